@@ -1,4 +1,5 @@
 #include "2DImage.h"
+#include "StateCache.h"
 
 
 C2DImage::C2DImage()
@@ -366,13 +367,13 @@ void C2DImage::RenderBuffers(ID3D11DeviceContext * deviceContext)
 	offset = 0;
 
 	// Set the vertex buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
+	CStateCache::Get(deviceContext)->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
 
 	// Set the index buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetIndexBuffer(mpIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	CStateCache::Get(deviceContext)->IASetIndexBuffer(mpIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
 	// Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	return;
 }
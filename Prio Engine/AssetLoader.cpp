@@ -0,0 +1,319 @@
+#include "AssetLoader.h"
+#include "Texture.h"
+#include "TextureCooker.h"
+#include <climits>
+
+CAssetLoader::CAssetLoader(ID3D11Device* device, CResourceCache* resourceCache, unsigned int numberOfThreads)
+{
+	mpDevice = device;
+	mpResourceCache = resourceCache;
+	mpPlaceholderTexture = nullptr;
+
+	mpWorkers = new CThreadPool(numberOfThreads);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpWorkers).name());
+
+	if (!CreatePlaceholderTexture())
+	{
+		logger->GetInstance().WriteLine("Failed to create the placeholder texture for the asset loader, textures will be blank until loaded.");
+	}
+}
+
+
+CAssetLoader::~CAssetLoader()
+{
+	// The pool finishes off anything it has already been given before its threads stop.
+	delete mpWorkers;
+	mpWorkers = nullptr;
+	logger->GetInstance().MemoryDeallocWriteLine(typeid(mpWorkers).name());
+
+	for (auto& request : mInFlight)
+	{
+		Cancel(request);
+	}
+	mInFlight.clear();
+	mQueued.clear();
+
+	if (mpPlaceholderTexture != nullptr)
+	{
+		mpPlaceholderTexture->Release();
+		mpPlaceholderTexture = nullptr;
+	}
+}
+
+/* Queue a texture to be read in the background. Until it's ready, the placeholder texture should be used in its place.
+* @Returns AssetHandle The request, which holds the texture once its state is AssetReady. */
+CAssetLoader::AssetHandle CAssetLoader::LoadTexture(const std::string& filename, CompletionCallback callback)
+{
+	ID3D11ShaderResourceView* cachedTexture = mpResourceCache != nullptr ? mpResourceCache->AcquireTexture(filename) : nullptr;
+	if (cachedTexture == nullptr)
+	{
+		return CreateRequest(TextureAsset, filename, callback);
+	}
+
+	// Already loaded, so there's nothing for the workers to do. It still waits for Update so the callback fires there.
+	AssetHandle request = std::make_shared<Request>();
+	request->type = TextureAsset;
+	request->filename = filename;
+	request->state = AssetReady;
+	request->cancelled = false;
+	request->callback = callback;
+	request->contentHash = 0;
+	request->texture = cachedTexture;
+	request->resourceCache = mpResourceCache;
+
+	mInFlight.push_back(request);
+
+	return request;
+}
+
+/* Queue a mesh to be loaded in the background. The mesh has nothing to draw until its state is AssetReady.
+* @Returns AssetHandle The request. */
+CAssetLoader::AssetHandle CAssetLoader::LoadMesh(const std::string& filename, MeshCreateFunction createMesh, CompletionCallback callback)
+{
+	AssetHandle request = CreateRequest(MeshAsset, filename, callback);
+	request->createMesh = createMesh;
+	return request;
+}
+
+void CAssetLoader::Cancel(AssetHandle& handle)
+{
+	if (handle == nullptr)
+	{
+		return;
+	}
+
+	handle->cancelled = true;
+	handle->createMesh = nullptr;
+
+	if (handle->texture != nullptr)
+	{
+		if (handle->resourceCache != nullptr)
+		{
+			handle->resourceCache->ReleaseTexture(handle->texture);
+		}
+		else
+		{
+			handle->texture->Release();
+		}
+		handle->texture = nullptr;
+	}
+
+	handle.reset();
+}
+
+/* Creates the device resources for loads which have finished, in the order they were requested, then tops the workers
+* back up from the queue. Callbacks are fired from here, so they always run on the main thread.
+* Creating a mesh queues its textures, so requests can be added while this runs. They're walked by index for that reason,
+* and anything added is picked up on the same pass. */
+void CAssetLoader::Update(unsigned int maxCreations)
+{
+	unsigned int numberOfCreated = 0;
+
+	size_t index = 0;
+	while (index < mInFlight.size())
+	{
+		// Held by value, the list may grow and move while the request is being created.
+		AssetHandle request = mInFlight[index];
+
+		const int state = request->state.load(std::memory_order_acquire);
+		if (state == AssetQueued || state == AssetLoading)
+		{
+			index++;
+			continue;
+		}
+
+		if (state == AssetLoaded)
+		{
+			if (numberOfCreated >= maxCreations)
+			{
+				index++;
+				continue;
+			}
+
+			if (!request->cancelled)
+			{
+				numberOfCreated++;
+			}
+
+			request->state = CreateResources(*request) ? AssetReady : AssetFailed;
+		}
+
+		if (!request->cancelled && request->callback)
+		{
+			request->callback(request->state == AssetReady);
+		}
+
+		mInFlight.erase(mInFlight.begin() + index);
+	}
+
+	SubmitQueued();
+}
+
+void CAssetLoader::Flush()
+{
+	while (GetNumberOfPendingRequests() > 0)
+	{
+		Update(UINT_MAX);
+		std::this_thread::yield();
+	}
+}
+
+CAssetLoader::AssetHandle CAssetLoader::CreateRequest(AssetType type, const std::string& filename, CompletionCallback callback)
+{
+	AssetHandle request = std::make_shared<Request>();
+	request->type = type;
+	request->filename = filename;
+	request->state = AssetQueued;
+	request->cancelled = false;
+	request->callback = callback;
+	request->contentHash = 0;
+	request->texture = nullptr;
+	request->resourceCache = mpResourceCache;
+
+	mQueued.push_back(request);
+	SubmitQueued();
+
+	return request;
+}
+
+void CAssetLoader::SubmitQueued()
+{
+	while (!mQueued.empty() && mInFlight.size() < kMaxRequestsInFlight)
+	{
+		AssetHandle request = mQueued.front();
+		mQueued.pop_front();
+
+		if (request->cancelled)
+		{
+			continue;
+		}
+
+		request->state = AssetLoading;
+		mInFlight.push_back(request);
+
+		// The worker holds its own reference, so the request stays alive even if it's cancelled part way through.
+		mpWorkers->Enqueue([request]() { ProcessRequest(*request); });
+	}
+}
+
+/* Runs on a worker, does everything which doesn't need the device. Nothing else touches the request until the state
+* has moved on from AssetLoading. */
+void CAssetLoader::ProcessRequest(Request& request)
+{
+	bool success = false;
+
+	if (request.type == TextureAsset)
+	{
+		// Picks up the block compressed copy written by the texture cooker in place of the source, if there is one.
+		success = CTextureCooker::OpenImage(request.image, request.filename);
+
+		if (success)
+		{
+			request.contentHash = PrioEngine::Hash::FNV1a(request.image.GetFileData(), request.image.GetFileSize());
+
+			// Decoding and building the mip chain happen here, off the main thread. Formats the engine can't read
+			// itself are left as they are and handed to D3DX when the texture is created.
+			request.image.Decode();
+		}
+
+		if (!success)
+		{
+			CLogger::GetInstance().WriteLine("Failed to read the texture '" + request.filename + "'.");
+		}
+	}
+	else if (request.type == MeshAsset)
+	{
+		success = request.cookedMesh.Load(request.filename, kMeshImportFlags);
+	}
+
+	request.state.store(success ? AssetLoaded : AssetFailed, std::memory_order_release);
+}
+
+/* Runs on the main thread, turns the data read by a worker into device resources.
+* @Returns bool Success */
+bool CAssetLoader::CreateResources(Request& request)
+{
+	bool success = false;
+
+	// Nobody wants the result any more, so there's nothing to create.
+	if (request.cancelled)
+	{
+		request.image.Release();
+		request.cookedMesh.Release();
+		return false;
+	}
+
+	if (request.type == TextureAsset)
+	{
+		// Another request may have brought in the same file while this one was being read.
+		if (request.resourceCache != nullptr)
+		{
+			request.texture = request.resourceCache->AcquireTexture(request.filename, request.contentHash);
+		}
+
+		if (request.texture == nullptr)
+		{
+			if (!CTexture::CreateFromImage(mpDevice, request.image, &request.texture))
+			{
+				logger->GetInstance().WriteLine("Failed to create the texture '" + request.filename + "' from the data read in.");
+			}
+			else if (request.resourceCache != nullptr)
+			{
+				request.texture = request.resourceCache->AddTexture(request.filename, request.contentHash, request.texture);
+			}
+		}
+
+		success = request.texture != nullptr;
+
+		request.image.Release();
+	}
+	else if (request.type == MeshAsset && request.createMesh)
+	{
+		success = request.createMesh(request.cookedMesh);
+		request.cookedMesh.Release();
+
+		if (!success)
+		{
+			logger->GetInstance().WriteLine("Failed to create the buffers for mesh '" + request.filename + "'.");
+		}
+	}
+
+	return success;
+}
+
+/* A single mid grey texel, neutral enough that nothing stands out while the real texture is loading.
+* @Returns bool Success */
+bool CAssetLoader::CreatePlaceholderTexture()
+{
+	const unsigned int texel = 0xFF808080;
+
+	D3D11_TEXTURE2D_DESC textureDesc;
+	textureDesc.Width = 1;
+	textureDesc.Height = 1;
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = 0;
+
+	D3D11_SUBRESOURCE_DATA initData;
+	initData.pSysMem = &texel;
+	initData.SysMemPitch = sizeof(texel);
+	initData.SysMemSlicePitch = 0;
+
+	ID3D11Texture2D* texture = nullptr;
+	HRESULT result = mpDevice->CreateTexture2D(&textureDesc, &initData, &texture);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	result = mpDevice->CreateShaderResourceView(texture, NULL, &mpPlaceholderTexture);
+	texture->Release();
+
+	return SUCCEEDED(result);
+}
@@ -0,0 +1,113 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <d3d11.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include "PrioEngineVars.h"
+#include "ThreadPool.h"
+#include "CookedMesh.h"
+#include "ResourceCache.h"
+#include "Image.h"
+
+/* Loads textures and meshes in the background. File reads, image decoding and mesh cooking run on a small pool of
+* workers of its own, so they never hold up the culling work on the main pool. Anything which needs the device is created
+* on the main thread when Update is called at the start of a frame, a few at a time so a burst of finished loads doesn't
+* cause a hitch.
+* Until then textures hand out a placeholder, and meshes simply have nothing to draw. */
+class CAssetLoader
+{
+private:
+	CLogger* logger;
+public:
+	enum AssetType
+	{
+		TextureAsset = 0,
+		MeshAsset
+	};
+
+	enum AssetState
+	{
+		// Waiting for a free slot before it's handed to the workers.
+		AssetQueued = 0,
+		AssetLoading,
+		// Read from disk, waiting for its device resources to be created.
+		AssetLoaded,
+		AssetReady,
+		AssetFailed
+	};
+
+	// Called on the main thread from Update once an asset is ready to use, or has failed.
+	typedef std::function<void(bool success)> CompletionCallback;
+	// Creates whatever a mesh needs from its cooked data, called on the main thread from Update.
+	typedef std::function<bool(CCookedMesh& cookedMesh)> MeshCreateFunction;
+
+	struct Request
+	{
+		AssetType type;
+		std::string filename;
+		std::atomic<int> state;
+		// Set when whoever asked for the asset no longer wants it, nothing is created for it and the callback isn't fired.
+		bool cancelled;
+		CompletionCallback callback;
+
+		// Filled in by a worker.
+		CImage image;
+		unsigned long long contentHash;
+		CCookedMesh cookedMesh;
+
+		// The texture once created, owned by the request until it's taken. Belongs to the resource cache if there is one.
+		ID3D11ShaderResourceView* texture;
+		CResourceCache* resourceCache;
+		// Creates the buffers of the mesh, whatever it refers to must outlive the request unless it's cancelled.
+		MeshCreateFunction createMesh;
+	};
+
+	// Shared between the loader and whoever made the request, check the state to see whether it's finished.
+	typedef std::shared_ptr<Request> AssetHandle;
+
+	static const unsigned int kDefaultNumberOfThreads = 2;
+	// Requests handed to the workers at once, the rest wait their turn so reads aren't all fighting over the disk.
+	static const unsigned int kMaxRequestsInFlight = 8;
+	// Assets which have their device resources created by each call to Update.
+	static const unsigned int kMaxCreationsPerUpdate = 4;
+public:
+	CAssetLoader(ID3D11Device* device, CResourceCache* resourceCache = nullptr, unsigned int numberOfThreads = kDefaultNumberOfThreads);
+	~CAssetLoader();
+public:
+	AssetHandle LoadTexture(const std::string& filename, CompletionCallback callback = nullptr);
+	// Cook or load the cooked copy of a mesh, then hand it to the create function to make its buffers and textures.
+	AssetHandle LoadMesh(const std::string& filename, MeshCreateFunction createMesh, CompletionCallback callback = nullptr);
+	// Let go of a request which may not have finished yet, releasing anything already created for it.
+	static void Cancel(AssetHandle& handle);
+
+	// Create the device resources of finished loads and hand out more work. Call once per frame from the main thread.
+	void Update(unsigned int maxCreations = kMaxCreationsPerUpdate);
+	// Block until every request made so far is either ready or has failed.
+	void Flush();
+
+	ID3D11ShaderResourceView* GetPlaceholderTexture() { return mpPlaceholderTexture; };
+	CResourceCache* GetResourceCache() { return mpResourceCache; };
+	unsigned int GetNumberOfPendingRequests() { return static_cast<unsigned int>(mQueued.size() + mInFlight.size()); };
+private:
+	AssetHandle CreateRequest(AssetType type, const std::string& filename, CompletionCallback callback);
+	void SubmitQueued();
+	static void ProcessRequest(Request& request);
+	bool CreateResources(Request& request);
+	bool CreatePlaceholderTexture();
+private:
+	ID3D11Device* mpDevice;
+	CResourceCache* mpResourceCache;
+	CThreadPool* mpWorkers;
+	ID3D11ShaderResourceView* mpPlaceholderTexture;
+
+	// Only touched on the main thread, the workers communicate through the state of each request.
+	std::deque<AssetHandle> mQueued;
+	std::vector<AssetHandle> mInFlight;
+};
+
+#endif
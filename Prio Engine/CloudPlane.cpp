@@ -1,4 +1,5 @@
 #include "CloudPlane.h"
+#include "StateCache.h"
 
 
 
@@ -314,9 +315,9 @@ void CCloudPlane::RenderBuffers(ID3D11DeviceContext * deviceContext)
 	offset = 0;
 
 	// Place vertex and index data on the pipeline to be rendered.
-	deviceContext->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
-	deviceContext->IASetIndexBuffer(mpIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CStateCache::Get(deviceContext)->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
+	CStateCache::Get(deviceContext)->IASetIndexBuffer(mpIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	return;
 }
@@ -1,4 +1,5 @@
 #include "CloudShader.h"
+#include "StateCache.h"
 
 
 
@@ -68,7 +69,7 @@ bool CCloudShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::strin
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "CloudVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "CloudVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -86,7 +87,7 @@ bool CCloudShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::strin
 
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "CloudPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "CloudPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		// If we recieved an error message.
@@ -317,24 +318,24 @@ bool CCloudShader::SetShaderParameters(ID3D11DeviceContext * deviceContext)
 
 	// Pass buffer to shader.
 	bufferNumber = 0;
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpCloudBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpCloudBuffer);
 
 	/////////////////////////////
 	// Shader resources
 	/////////////////////////////
 
-	deviceContext->PSSetShaderResources(0, 1, &mpCloudTexture1);
-	deviceContext->PSSetShaderResources(1, 1, &mpCloudTexture2);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpCloudTexture1);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(1, 1, &mpCloudTexture2);
 
 	return true;
 }
 
 void CCloudShader::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
-	deviceContext->IASetInputLayout(mpLayout);
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
 	deviceContext->DrawIndexed(indexCount, 0, 0);
 }
 
@@ -1,4 +1,5 @@
 #include "ColourShader.h"
+#include "StateCache.h"
 
 
 
@@ -64,7 +65,7 @@ bool CColourShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::stri
 	pixelShaderBuffer = nullptr;
 	
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "ColourVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "ColourVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -81,7 +82,7 @@ bool CColourShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::stri
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "ColourPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "ColourPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		// If we recieved an error message.
@@ -226,11 +227,11 @@ bool CColourShader::SetShaderParameters(ID3D11DeviceContext* deviceContext)
 void CColourShader::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout
-	deviceContext->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
 	
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpPixelShader, NULL, 0);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -0,0 +1,557 @@
+#include "CookedMesh.h"
+#include "MeshOptimiser.h"
+#include "MeshSimplifier.h"
+#include "DiskFile.h"
+#include <Importer.hpp>
+#include <scene.h>
+#include <postprocess.h>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+namespace
+{
+	const char kMagic[4] = { 'P', 'M', 'S', 'H' };
+	const char* kCookedExtension = ".pmesh";
+	const unsigned int kSectionAlignment = 16;
+
+	// Extensions of the model formats which will be picked up when cooking a directory.
+	const char* kModelExtensions[] = { ".x", ".fbx", ".obj", ".3ds" };
+
+	unsigned int AlignOffset(unsigned int offset)
+	{
+		return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+	}
+
+	// There's always the full detail level, and no more than the file has room for.
+	unsigned int ClampNumberOfLods(unsigned int numberOfLods)
+	{
+		if (numberOfLods == 0)
+		{
+			return 1;
+		}
+		return numberOfLods < CCookedMesh::kMaxLods ? numberOfLods : CCookedMesh::kMaxLods;
+	}
+
+	bool HasModelExtension(const std::string& filename)
+	{
+		const size_t dot = filename.find_last_of('.');
+		if (dot == std::string::npos)
+		{
+			return false;
+		}
+
+		std::string extension = filename.substr(dot);
+		for (auto& character : extension)
+		{
+			character = static_cast<char>(tolower(character));
+		}
+
+		for (auto modelExtension : kModelExtensions)
+		{
+			if (extension == modelExtension)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+// Full detail, then a half, a quarter and a tenth of the triangles.
+const CCookedMesh::LodSettings CCookedMesh::kDefaultLodSettings = { 4, { 1.0f, 0.5f, 0.25f, 0.1f } };
+
+CCookedMesh::CCookedMesh()
+{
+	mLoadedFromCache = false;
+	mNumberOfSubMeshes = 0;
+	mNumberOfMaterials = 0;
+	mNumberOfVertices = 0;
+	mNumberOfIndices = 0;
+	mNumberOfLods = 0;
+	mpSubMeshes = nullptr;
+	mpMaterials = nullptr;
+	mpVertices = nullptr;
+	mpIndices = nullptr;
+}
+
+
+CCookedMesh::~CCookedMesh()
+{
+	Release();
+}
+
+/* Loads the cooked copy of a model. If there isn't one, or the source model has changed since it was cooked, the source
+* is imported with assimp and cooked again first.
+* @Returns bool Success */
+bool CCookedMesh::Load(const std::string& sourceFile, unsigned int importFlags, const LodSettings& lodSettings)
+{
+	Release();
+
+	const std::string cookedFile = GetCookedFilename(sourceFile);
+	unsigned long long sourceHash = 0;
+
+	if (!HashSourceFile(sourceFile, lodSettings, sourceHash))
+	{
+		// The source isn't always shipped, in which case whatever was cooked is all there is to use.
+		if (MapCookedFile(cookedFile, false, 0, importFlags))
+		{
+			mLoadedFromCache = true;
+			return true;
+		}
+
+		logger->GetInstance().WriteLine("Failed to find the model '" + sourceFile + "' or a cooked copy of it.");
+		return false;
+	}
+
+	if (MapCookedFile(cookedFile, true, sourceHash, importFlags))
+	{
+		logger->GetInstance().WriteLine("Loaded cooked mesh '" + cookedFile + "'.");
+		mLoadedFromCache = true;
+		return true;
+	}
+
+	logger->GetInstance().WriteLine("Cooked mesh '" + cookedFile + "' is missing or out of date, importing '" + sourceFile + "' using Assimp.");
+
+	if (!Import(sourceFile, importFlags, lodSettings, mImported))
+	{
+		return false;
+	}
+
+	if (Write(cookedFile, sourceHash, importFlags, mImported) && MapCookedFile(cookedFile, true, sourceHash, importFlags))
+	{
+		mImported = ImportedMesh();
+		return true;
+	}
+
+	// Still able to carry on without the cooked file, it will just be imported again next time.
+	logger->GetInstance().WriteLine("Failed to write cooked mesh '" + cookedFile + "', using the imported data directly.");
+	UseImportedMesh();
+
+	return true;
+}
+
+/* Maps the cooked copy of a model again after it has been loaded once, skipping the hash of the source. Only for reading
+* back data which was already checked when the model was first loaded.
+* @Returns bool Success */
+bool CCookedMesh::Remap(const std::string& sourceFile, unsigned int importFlags)
+{
+	Release();
+
+	mLoadedFromCache = MapCookedFile(GetCookedFilename(sourceFile), false, 0, importFlags);
+	return mLoadedFromCache;
+}
+
+void CCookedMesh::Release()
+{
+	mFile.Close();
+	mImported = ImportedMesh();
+	mLoadedFromCache = false;
+
+	mNumberOfSubMeshes = 0;
+	mNumberOfMaterials = 0;
+	mNumberOfVertices = 0;
+	mNumberOfIndices = 0;
+	mNumberOfLods = 0;
+	mpSubMeshes = nullptr;
+	mpMaterials = nullptr;
+	mpVertices = nullptr;
+	mpIndices = nullptr;
+}
+
+/* Imports a model with assimp and writes out its cooked copy, regardless of whether the existing one is up to date.
+* @Returns bool Success */
+bool CCookedMesh::Cook(const std::string& sourceFile, unsigned int importFlags, const LodSettings& lodSettings)
+{
+	unsigned long long sourceHash = 0;
+	if (!HashSourceFile(sourceFile, lodSettings, sourceHash))
+	{
+		CLogger::GetInstance().WriteLine("Failed to open '" + sourceFile + "' to cook it.");
+		return false;
+	}
+
+	ImportedMesh mesh;
+	if (!Import(sourceFile, importFlags, lodSettings, mesh))
+	{
+		return false;
+	}
+
+	const std::string cookedFile = GetCookedFilename(sourceFile);
+	if (!Write(cookedFile, sourceHash, importFlags, mesh))
+	{
+		CLogger::GetInstance().WriteLine("Failed to write cooked mesh '" + cookedFile + "'.");
+		return false;
+	}
+
+	CLogger::GetInstance().WriteLine("Cooked '" + sourceFile + "' into '" + cookedFile + "'.");
+	return true;
+}
+
+/* Cooks every model found in a directory, including any sub directories.
+* @Returns unsigned int The number of models which were successfully cooked. */
+unsigned int CCookedMesh::CookDirectory(const std::string& directory, unsigned int importFlags, const LodSettings& lodSettings)
+{
+	unsigned int numberOfCooked = 0;
+
+	std::vector<std::string> files;
+	if (!PrioEngine::DiskFile::FindFiles(directory, files))
+	{
+		CLogger::GetInstance().WriteLine("Failed to find any files to cook in '" + directory + "'.");
+		return 0;
+	}
+
+	for (auto& file : files)
+	{
+		if (HasModelExtension(file) && Cook(file, importFlags, lodSettings))
+		{
+			numberOfCooked++;
+		}
+	}
+
+	return numberOfCooked;
+}
+
+std::string CCookedMesh::GetCookedFilename(const std::string& sourceFile)
+{
+	return sourceFile + kCookedExtension;
+}
+
+/* Opens a cooked file through the file system and points the accessors at its sections, after checking it was cooked by
+* this version of the engine with the same import flags and from the same source data.
+* @Returns bool Whether the cooked file can be used. */
+bool CCookedMesh::MapCookedFile(const std::string& cookedFile, bool checkHash, unsigned long long sourceHash, unsigned int importFlags)
+{
+	if (!mFile.Open(cookedFile))
+	{
+		return false;
+	}
+
+	const unsigned char* data = mFile.GetData();
+	const size_t size = mFile.GetSize();
+
+	if (size < sizeof(Header))
+	{
+		mFile.Close();
+		return false;
+	}
+
+	const Header* header = reinterpret_cast<const Header*>(data);
+
+	if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion || header->vertexStride != sizeof(Vertex) ||
+		header->importFlags != importFlags || header->numberOfLods == 0 || header->numberOfLods > kMaxLods ||
+		(checkHash && header->sourceHash != sourceHash))
+	{
+		mFile.Close();
+		return false;
+	}
+
+	// Make sure every section actually fits in the file before trusting any of the offsets.
+	const unsigned long long subMeshEnd = static_cast<unsigned long long>(header->subMeshOffset) + static_cast<unsigned long long>(header->numberOfSubMeshes) * sizeof(SubMeshRecord);
+	const unsigned long long materialEnd = static_cast<unsigned long long>(header->materialOffset) + static_cast<unsigned long long>(header->numberOfMaterials) * sizeof(MaterialRecord);
+	const unsigned long long vertexEnd = static_cast<unsigned long long>(header->vertexOffset) + static_cast<unsigned long long>(header->numberOfVertices) * sizeof(Vertex);
+	const unsigned long long indexEnd = static_cast<unsigned long long>(header->indexOffset) + static_cast<unsigned long long>(header->numberOfIndices) * sizeof(unsigned int);
+
+	if (subMeshEnd > size || materialEnd > size || vertexEnd > size || indexEnd > size)
+	{
+		logger->GetInstance().WriteLine("Cooked mesh '" + cookedFile + "' is truncated, it will be cooked again.");
+		mFile.Close();
+		return false;
+	}
+
+	mNumberOfSubMeshes = header->numberOfSubMeshes;
+	mNumberOfMaterials = header->numberOfMaterials;
+	mNumberOfVertices = header->numberOfVertices;
+	mNumberOfIndices = header->numberOfIndices;
+	mNumberOfLods = header->numberOfLods;
+	memcpy(mLodErrors, header->lodErrors, sizeof(mLodErrors));
+	mpSubMeshes = reinterpret_cast<const SubMeshRecord*>(data + header->subMeshOffset);
+	mpMaterials = reinterpret_cast<const MaterialRecord*>(data + header->materialOffset);
+	mpVertices = reinterpret_cast<const Vertex*>(data + header->vertexOffset);
+	mpIndices = reinterpret_cast<const unsigned int*>(data + header->indexOffset);
+
+	// Check the submeshes only reference data which exists, so the buffers can be created straight from the file.
+	for (unsigned int subMesh = 0; subMesh < mNumberOfSubMeshes; subMesh++)
+	{
+		const SubMeshRecord& record = mpSubMeshes[subMesh];
+		bool valid = static_cast<unsigned long long>(record.firstVertex) + record.numberOfVertices <= mNumberOfVertices &&
+			static_cast<unsigned long long>(record.firstIndex) + record.numberOfIndices <= mNumberOfIndices &&
+			record.materialIndex < mNumberOfMaterials &&
+			record.lodFirstIndex[0] == record.firstIndex && record.lodNumberOfIndices[0] == record.numberOfIndices;
+
+		// Each level of detail must follow on directly from the one before, so they can all go in one index buffer.
+		for (unsigned int lod = 1; lod < mNumberOfLods && valid; lod++)
+		{
+			valid = record.lodFirstIndex[lod] == record.lodFirstIndex[lod - 1] + record.lodNumberOfIndices[lod - 1] &&
+				static_cast<unsigned long long>(record.lodFirstIndex[lod]) + record.lodNumberOfIndices[lod] <= mNumberOfIndices;
+		}
+
+		if (!valid)
+		{
+			logger->GetInstance().WriteLine("Cooked mesh '" + cookedFile + "' has an invalid submesh, it will be cooked again.");
+			mFile.Close();
+			mNumberOfSubMeshes = 0;
+			mNumberOfMaterials = 0;
+			mNumberOfVertices = 0;
+			mNumberOfIndices = 0;
+			mNumberOfLods = 0;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Points the accessors at the data which was imported this time, for when it couldn't be written out. */
+void CCookedMesh::UseImportedMesh()
+{
+	mNumberOfSubMeshes = static_cast<unsigned int>(mImported.subMeshes.size());
+	mNumberOfMaterials = static_cast<unsigned int>(mImported.materials.size());
+	mNumberOfVertices = static_cast<unsigned int>(mImported.vertices.size());
+	mNumberOfIndices = static_cast<unsigned int>(mImported.indices.size());
+	mNumberOfLods = mImported.numberOfLods;
+	memcpy(mLodErrors, mImported.lodErrors, sizeof(mLodErrors));
+	mpSubMeshes = mImported.subMeshes.data();
+	mpMaterials = mImported.materials.data();
+	mpVertices = mImported.vertices.data();
+	mpIndices = mImported.indices.data();
+}
+
+/* Reads a model in with assimp and flattens it into the layout used by the cooked file.
+* @Returns bool Success */
+bool CCookedMesh::Import(const std::string& sourceFile, unsigned int importFlags, const LodSettings& lodSettings, ImportedMesh& mesh)
+{
+	Assimp::Importer importer;
+
+	// Read in the file, store this mesh in the scene.
+	const aiScene* scene = importer.ReadFile(sourceFile, importFlags);
+
+	// If scene hasn't been initialised then something has gone wrong!
+	if (!scene)
+	{
+		CLogger::GetInstance().WriteLine(importer.GetErrorString());
+		CLogger::GetInstance().WriteLine("Failed to create scene.");
+		return false;
+	}
+
+	mesh = ImportedMesh();
+	mesh.materials.resize(scene->mNumMaterials);
+	mesh.numberOfLods = ClampNumberOfLods(lodSettings.numberOfLods);
+	memset(mesh.lodErrors, 0, sizeof(mesh.lodErrors));
+
+	const aiTextureType kTextureTypes[kNumberOfTextureSlots] = { aiTextureType_DIFFUSE, aiTextureType_OPACITY, aiTextureType_SPECULAR };
+
+	for (unsigned int materialCount = 0; materialCount < scene->mNumMaterials; materialCount++)
+	{
+		MaterialRecord& record = mesh.materials[materialCount];
+		memset(&record, 0, sizeof(MaterialRecord));
+
+		for (unsigned int slot = 0; slot < kNumberOfTextureSlots; slot++)
+		{
+			aiString textureName;
+			if (scene->mMaterials[materialCount]->GetTexture(kTextureTypes[slot], 0, &textureName) != AI_SUCCESS)
+			{
+				continue;
+			}
+
+			if (textureName.length >= kMaxTextureNameLength)
+			{
+				CLogger::GetInstance().WriteLine("Texture name '" + std::string(textureName.C_Str()) + "' in '" + sourceFile + "' is too long to be cooked.");
+				return false;
+			}
+
+			memcpy(record.textures[slot], textureName.C_Str(), textureName.length);
+		}
+	}
+
+	for (unsigned int meshCount = 0; meshCount < scene->mNumMeshes; meshCount++)
+	{
+		const aiMesh& subMesh = *scene->mMeshes[meshCount];
+
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		vertices.reserve(subMesh.mNumVertices);
+		indices.reserve(subMesh.mNumFaces * 3);
+
+		for (unsigned int vertexCount = 0; vertexCount < subMesh.mNumVertices; vertexCount++)
+		{
+			Vertex vertex;
+			memset(&vertex, 0, sizeof(Vertex));
+
+			vertex.position[0] = subMesh.mVertices[vertexCount].x;
+			vertex.position[1] = subMesh.mVertices[vertexCount].y;
+			vertex.position[2] = subMesh.mVertices[vertexCount].z;
+
+			if (subMesh.HasTextureCoords(0))
+			{
+				vertex.uv[0] = subMesh.mTextureCoords[0][vertexCount].x;
+				vertex.uv[1] = subMesh.mTextureCoords[0][vertexCount].y;
+			}
+
+			if (subMesh.HasNormals())
+			{
+				vertex.normal[0] = subMesh.mNormals[vertexCount].x;
+				vertex.normal[1] = subMesh.mNormals[vertexCount].y;
+				vertex.normal[2] = subMesh.mNormals[vertexCount].z;
+			}
+
+			vertices.push_back(vertex);
+		}
+
+		// Only triangles are kept, anything else left over after triangulation is skipped.
+		for (unsigned int faceCount = 0; faceCount < subMesh.mNumFaces; faceCount++)
+		{
+			const aiFace& face = subMesh.mFaces[faceCount];
+			if (face.mNumIndices == 3)
+			{
+				indices.push_back(face.mIndices[0]);
+				indices.push_back(face.mIndices[1]);
+				indices.push_back(face.mIndices[2]);
+			}
+		}
+
+		// Weld and reorder the geometry, this only happens once per cook so the cost doesn't matter at load time.
+		const CMeshOptimiser::Statistics statistics = CMeshOptimiser::Optimise(vertices, indices);
+
+		std::stringstream optimiseMessage;
+		optimiseMessage << std::fixed << std::setprecision(3) << "Optimised submesh " << meshCount << " of '" << sourceFile << "': "
+			<< statistics.numberOfVerticesBefore << " to " << statistics.numberOfVerticesAfter << " vertices, ACMR "
+			<< statistics.acmrBefore << " to " << statistics.acmrAfter << ".";
+		CLogger::GetInstance().WriteLine(optimiseMessage.str());
+
+		SubMeshRecord record;
+		memset(&record, 0, sizeof(SubMeshRecord));
+		record.firstVertex = static_cast<unsigned int>(mesh.vertices.size());
+		record.numberOfVertices = static_cast<unsigned int>(vertices.size());
+		record.firstIndex = static_cast<unsigned int>(mesh.indices.size());
+		record.numberOfIndices = static_cast<unsigned int>(indices.size());
+		record.materialIndex = subMesh.mMaterialIndex;
+
+		float lodErrors[kMaxLods];
+		GenerateLods(vertices, indices, lodSettings, record, lodErrors);
+
+		// The whole model switches level at once, so it's the worst submesh which decides when.
+		for (unsigned int lod = 0; lod < mesh.numberOfLods; lod++)
+		{
+			record.lodFirstIndex[lod] += record.firstIndex;
+			mesh.lodErrors[lod] = std::max(mesh.lodErrors[lod], lodErrors[lod]);
+		}
+
+		mesh.vertices.insert(mesh.vertices.end(), vertices.begin(), vertices.end());
+		mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+		mesh.subMeshes.push_back(record);
+	}
+
+	// A coarser level should never claim to be more accurate than a finer one, or the selection would skip over it.
+	for (unsigned int lod = 1; lod < mesh.numberOfLods; lod++)
+	{
+		mesh.lodErrors[lod] = std::max(mesh.lodErrors[lod], mesh.lodErrors[lod - 1]);
+	}
+
+	return true;
+}
+
+/* Simplifies a submesh down to each ratio in the settings, appending the indices of every level after the full detail ones.
+* The ranges written into the record are relative to the start of the submesh's indices. */
+void CCookedMesh::GenerateLods(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const LodSettings& lodSettings,
+	SubMeshRecord& record, float lodErrors[kMaxLods])
+{
+	const unsigned int numberOfLods = ClampNumberOfLods(lodSettings.numberOfLods);
+	const std::vector<unsigned int> fullIndices = indices;
+	std::vector<unsigned int> lodIndices;
+
+	record.lodFirstIndex[0] = 0;
+	record.lodNumberOfIndices[0] = static_cast<unsigned int>(fullIndices.size());
+	lodErrors[0] = 0.0f;
+
+	for (unsigned int lod = 1; lod < kMaxLods; lod++)
+	{
+		record.lodFirstIndex[lod] = 0;
+		record.lodNumberOfIndices[lod] = 0;
+		lodErrors[lod] = 0.0f;
+	}
+
+	for (unsigned int lod = 1; lod < numberOfLods; lod++)
+	{
+		// Every level is simplified from the full mesh rather than the level before, so errors don't build on each other.
+		const unsigned int targetNumberOfIndices = static_cast<unsigned int>(fullIndices.size() * lodSettings.ratios[lod]) / 3 * 3;
+		lodErrors[lod] = CMeshSimplifier::Simplify(vertices, fullIndices, targetNumberOfIndices, CMeshSimplifier::kDefaultSettings, lodIndices);
+		CMeshOptimiser::OptimiseVertexCache(lodIndices, static_cast<unsigned int>(vertices.size()));
+
+		record.lodFirstIndex[lod] = static_cast<unsigned int>(indices.size());
+		record.lodNumberOfIndices[lod] = static_cast<unsigned int>(lodIndices.size());
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+
+		std::stringstream lodMessage;
+		lodMessage << std::fixed << std::setprecision(4) << "Generated level of detail " << lod << " with " << lodIndices.size() / 3
+			<< " of " << fullIndices.size() / 3 << " triangles, error " << lodErrors[lod] << ".";
+		CLogger::GetInstance().WriteLine(lodMessage.str());
+	}
+}
+
+/* Writes imported model data out to a cooked file. The file is written under a temporary name first and then moved
+* into place, so a crash part way through never leaves a half written file behind.
+* @Returns bool Success */
+bool CCookedMesh::Write(const std::string& cookedFile, unsigned long long sourceHash, unsigned int importFlags, const ImportedMesh& mesh)
+{
+	Header header;
+	memset(&header, 0, sizeof(Header));
+	memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.sourceHash = sourceHash;
+	header.importFlags = importFlags;
+	header.vertexStride = sizeof(Vertex);
+	header.numberOfSubMeshes = static_cast<unsigned int>(mesh.subMeshes.size());
+	header.numberOfMaterials = static_cast<unsigned int>(mesh.materials.size());
+	header.numberOfVertices = static_cast<unsigned int>(mesh.vertices.size());
+	header.numberOfIndices = static_cast<unsigned int>(mesh.indices.size());
+	header.numberOfLods = mesh.numberOfLods;
+	memcpy(header.lodErrors, mesh.lodErrors, sizeof(header.lodErrors));
+
+	header.subMeshOffset = AlignOffset(sizeof(Header));
+	header.materialOffset = AlignOffset(header.subMeshOffset + header.numberOfSubMeshes * sizeof(SubMeshRecord));
+	header.vertexOffset = AlignOffset(header.materialOffset + header.numberOfMaterials * sizeof(MaterialRecord));
+	header.indexOffset = AlignOffset(header.vertexOffset + header.numberOfVertices * sizeof(Vertex));
+	const unsigned int fileSize = header.indexOffset + header.numberOfIndices * sizeof(unsigned int);
+
+	std::vector<char> buffer(fileSize, 0);
+	memcpy(&buffer[0], &header, sizeof(Header));
+	if (!mesh.subMeshes.empty())
+	{
+		memcpy(&buffer[header.subMeshOffset], mesh.subMeshes.data(), mesh.subMeshes.size() * sizeof(SubMeshRecord));
+	}
+	if (!mesh.materials.empty())
+	{
+		memcpy(&buffer[header.materialOffset], mesh.materials.data(), mesh.materials.size() * sizeof(MaterialRecord));
+	}
+	if (!mesh.vertices.empty())
+	{
+		memcpy(&buffer[header.vertexOffset], mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+	}
+	if (!mesh.indices.empty())
+	{
+		memcpy(&buffer[header.indexOffset], mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+	}
+
+	return PrioEngine::DiskFile::Write(cookedFile, [&buffer](std::ofstream& file)
+	{
+		file.write(&buffer[0], buffer.size());
+	});
+}
+
+/* Hashes the contents of a source model and the level of detail settings, used to tell whether its cooked copy is out of date.
+* @Returns bool Whether the source file could be read. */
+bool CCookedMesh::HashSourceFile(const std::string& sourceFile, const LodSettings& lodSettings, unsigned long long& hash)
+{
+	CVirtualFile file;
+	if (!file.Open(sourceFile))
+	{
+		return false;
+	}
+
+	hash = PrioEngine::Hash::FNV1a(file.GetData(), file.GetSize());
+	hash = PrioEngine::Hash::FNV1a(&lodSettings, sizeof(LodSettings), hash);
+	return true;
+}
@@ -0,0 +1,155 @@
+#ifndef COOKEDMESH_H
+#define COOKEDMESH_H
+
+#include <string>
+#include <vector>
+#include "PrioEngineVars.h"
+#include "FileSystem.h"
+#include <postprocess.h>
+
+// Post processing applied when a model is imported, changing these causes every cooked mesh to be cooked again.
+const unsigned int kMeshImportFlags = aiProcess_ConvertToLeftHanded | aiProcess_Triangulate | aiProcess_SortByPType;
+
+/* Geometry and material names of a model, stored in a binary .pmesh file next to the source model so assimp only has
+* to parse the source once. The cooked file is read through the file system and its contents handed straight to buffer creation.
+* A hash of the source file is kept in the header, so editing the source causes it to be cooked again. */
+class CCookedMesh
+{
+private:
+	CLogger* logger;
+public:
+	// Bump this whenever the layout of the file, or how its contents are worked out, changes. Older files will then be cooked again.
+	static const unsigned int kVersion = 4;
+	static const unsigned int kNumberOfTextureSlots = 3;
+	static const unsigned int kMaxTextureNameLength = 128;
+	static const unsigned int kMaxLods = 4;
+
+	enum TextureSlot
+	{
+		DiffuseTexture = 0,
+		AlphaTexture,
+		SpecularTexture
+	};
+
+	// Interleaved the same way as the vertex types which consume it.
+	struct Vertex
+	{
+		float position[3];
+		float uv[2];
+		float normal[3];
+	};
+
+	struct SubMeshRecord
+	{
+		unsigned int firstVertex;
+		unsigned int numberOfVertices;
+		// Indices are relative to the first vertex of the submesh.
+		unsigned int firstIndex;
+		unsigned int numberOfIndices;
+		unsigned int materialIndex;
+		// Where the indices of each level of detail start, the first level always matches the full submesh above.
+		// Every level shares the same vertices, and follows on from the previous one in the index section.
+		unsigned int lodFirstIndex[kMaxLods];
+		unsigned int lodNumberOfIndices[kMaxLods];
+	};
+
+	struct MaterialRecord
+	{
+		// Empty names mean the material doesn't use that slot.
+		char textures[kNumberOfTextureSlots][kMaxTextureNameLength];
+	};
+
+	// Which levels of detail are generated when cooking, as a fraction of the triangles in the full mesh.
+	struct LodSettings
+	{
+		unsigned int numberOfLods;
+		float ratios[kMaxLods];
+	};
+
+	static const LodSettings kDefaultLodSettings;
+public:
+	CCookedMesh();
+	~CCookedMesh();
+public:
+	// Load the cooked copy of a model, cooking it first if there isn't one or it has gone out of date.
+	bool Load(const std::string& sourceFile, unsigned int importFlags, const LodSettings& lodSettings = kDefaultLodSettings);
+	// Map the cooked copy of a model which has already been through Load, without checking it against the source again.
+	bool Remap(const std::string& sourceFile, unsigned int importFlags);
+	void Release();
+
+	// Import a model with assimp and write out its cooked copy.
+	static bool Cook(const std::string& sourceFile, unsigned int importFlags, const LodSettings& lodSettings = kDefaultLodSettings);
+	// Cook every model found under a directory and its sub directories. Returns how many were cooked.
+	static unsigned int CookDirectory(const std::string& directory, unsigned int importFlags, const LodSettings& lodSettings = kDefaultLodSettings);
+	static std::string GetCookedFilename(const std::string& sourceFile);
+public:
+	unsigned int GetNumberOfSubMeshes() { return mNumberOfSubMeshes; };
+	unsigned int GetNumberOfMaterials() { return mNumberOfMaterials; };
+	unsigned int GetNumberOfVertices() { return mNumberOfVertices; };
+	unsigned int GetNumberOfIndices() { return mNumberOfIndices; };
+	unsigned int GetNumberOfLods() { return mNumberOfLods; };
+	// Furthest any level of detail strays from the full mesh, in model space units.
+	float GetLodError(unsigned int lod) { return mLodErrors[lod]; };
+	const SubMeshRecord& GetSubMesh(unsigned int index) { return mpSubMeshes[index]; };
+	const MaterialRecord& GetMaterial(unsigned int index) { return mpMaterials[index]; };
+	const Vertex* GetVertices() { return mpVertices; };
+	const unsigned int* GetIndices() { return mpIndices; };
+	// Whether the data came from an up to date cooked file rather than being imported this time.
+	bool WasLoadedFromCache() { return mLoadedFromCache; };
+private:
+	struct Header
+	{
+		char magic[4];
+		unsigned int version;
+		unsigned long long sourceHash;
+		unsigned int importFlags;
+		unsigned int vertexStride;
+		unsigned int numberOfSubMeshes;
+		unsigned int numberOfMaterials;
+		unsigned int numberOfVertices;
+		unsigned int numberOfIndices;
+		unsigned int numberOfLods;
+		float lodErrors[kMaxLods];
+		unsigned int subMeshOffset;
+		unsigned int materialOffset;
+		unsigned int vertexOffset;
+		unsigned int indexOffset;
+	};
+
+	// Model data as it comes out of assimp, before being written to disk.
+	struct ImportedMesh
+	{
+		std::vector<SubMeshRecord> subMeshes;
+		std::vector<MaterialRecord> materials;
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		unsigned int numberOfLods;
+		float lodErrors[kMaxLods];
+	};
+
+	bool MapCookedFile(const std::string& cookedFile, bool checkHash, unsigned long long sourceHash, unsigned int importFlags);
+	void UseImportedMesh();
+	static bool Import(const std::string& sourceFile, unsigned int importFlags, const LodSettings& lodSettings, ImportedMesh& mesh);
+	static void GenerateLods(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const LodSettings& lodSettings,
+		SubMeshRecord& record, float lodErrors[kMaxLods]);
+	static bool Write(const std::string& cookedFile, unsigned long long sourceHash, unsigned int importFlags, const ImportedMesh& mesh);
+	static bool HashSourceFile(const std::string& sourceFile, const LodSettings& lodSettings, unsigned long long& hash);
+private:
+	CVirtualFile mFile;
+	// Only filled in when the cooked file couldn't be written, so the imported data is used directly.
+	ImportedMesh mImported;
+	bool mLoadedFromCache;
+
+	unsigned int mNumberOfSubMeshes;
+	unsigned int mNumberOfMaterials;
+	unsigned int mNumberOfVertices;
+	unsigned int mNumberOfIndices;
+	unsigned int mNumberOfLods;
+	float mLodErrors[kMaxLods];
+	const SubMeshRecord* mpSubMeshes;
+	const MaterialRecord* mpMaterials;
+	const Vertex* mpVertices;
+	const unsigned int* mpIndices;
+};
+
+#endif
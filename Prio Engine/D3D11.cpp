@@ -1,5 +1,11 @@
 #include "D3D11.h"
 
+namespace
+{
+	// Room for a few frames of text and other vertices which only live for a frame.
+	const unsigned int kVertexRingSize = 1024 * 1024;
+}
+
 CD3D11::CD3D11()
 {
 	mGraphicsCardName = "";
@@ -8,6 +14,9 @@ CD3D11::CD3D11()
 	mpRasterStateNoCulling = nullptr;
 	mpAdditiveAlphaBlendingStateEnabled = nullptr;
 	mpDepthState = nullptr;
+	mpRenderDevice = nullptr;
+	mpVertexRing = nullptr;
+	mpStateCache = nullptr;
 }
 
 
@@ -236,7 +245,7 @@ bool CD3D11::Initialise(int screenWidth, int screenHeight, bool vsync, HWND hwnd
 	}
 
 	// Put the depth stencil buffer into effect!
-	mpDeviceContext->OMSetDepthStencilState(mpDepthEnabledStencilState, 1);
+	mpStateCache->OMSetDepthStencilState(mpDepthEnabledStencilState, 1);
 
 	/* Create the depth stencil view. */
 
@@ -345,6 +354,23 @@ bool CD3D11::Initialise(int screenWidth, int screenHeight, bool vsync, HWND hwnd
 		 return false;
 	 }
 
+	mpRenderDevice = new CD3D11RenderDevice(mpDevice, mpDeviceContext);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpRenderDevice).name());
+	if (!mpRenderDevice->Initialise())
+	{
+		logger->GetInstance().WriteLine("Failed to initialise the render device.");
+		return false;
+	}
+	UpdateRenderDeviceStates();
+
+	mpVertexRing = new CFrameRingBuffer(mpRenderDevice, CRenderDevice::VertexBuffer, kVertexRingSize);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpVertexRing).name());
+	if (!mpVertexRing->Initialise())
+	{
+		logger->GetInstance().WriteLine("Failed to initialise the vertex ring buffer.");
+		return false;
+	}
+
 	// Success! We have successfully setup DirectX.
 	return true;
 }
@@ -443,9 +469,28 @@ void CD3D11::Shutdown()
 
 	TwTerminate();
 
+	if (mpVertexRing != nullptr)
+	{
+		mpVertexRing->Shutdown();
+		delete mpVertexRing;
+		mpVertexRing = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpVertexRing).name());
+	}
+
+	if (mpRenderDevice != nullptr)
+	{
+		mpRenderDevice->Shutdown();
+		delete mpRenderDevice;
+		mpRenderDevice = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpRenderDevice).name());
+	}
+
 	// If device context has been initialised.
 	if (mpDeviceContext)
 	{
+		CStateCache::Release(mpDeviceContext);
+		mpStateCache = nullptr;
+
 		// Release the device context.
 		mpDeviceContext->Release();
 		mpDeviceContext = nullptr;
@@ -484,6 +529,10 @@ void CD3D11::BeginScene(float red, float green, float blue, float alpha)
 	colour[2] = blue;
 	colour[3] = alpha;
 
+	// Statistics are counted per frame, starting from here.
+	mpRenderDevice->BeginFrame();
+	mpStateCache->BeginFrame();
+
 	// Clear the back buffer.
 	mpDeviceContext->ClearRenderTargetView(mpRenderTargetView, colour);
 
@@ -495,6 +544,9 @@ void CD3D11::BeginScene(float red, float green, float blue, float alpha)
 
 void CD3D11::EndScene()
 {
+	// Everything written into the ring this frame has been drawn from by now.
+	mpVertexRing->EndFrame();
+
 	// Present the back buffer to the screen after rendering as the rendering has completed now.
 	if (mVsyncEnabled)
 	{
@@ -569,7 +621,8 @@ void CD3D11::EnableWireframeFill()
 	}
 
 	// Set the rasterizer state.
-	mpDeviceContext->RSSetState(mpRasterizerState);
+	mpStateCache->RSSetState(mpRasterizerState);
+	UpdateRenderDeviceStates();
 	logger->GetInstance().WriteLine("Rasterizer state changed to use wireframe fill.");
 }
 
@@ -603,7 +656,8 @@ void CD3D11::EnableSolidFill()
 	}
 
 	// Set the rasterizer state.
-	mpDeviceContext->RSSetState(mpRasterizerState);
+	mpStateCache->RSSetState(mpRasterizerState);
+	UpdateRenderDeviceStates();
 
 	logger->GetInstance().WriteLine("Rasterizer state changed to use solid fill.");
 }
@@ -612,33 +666,33 @@ void CD3D11::EnableAlphaBlending()
 {
 	float blendFactor[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 
-	mpDeviceContext->OMSetBlendState(mpAlphaBlendingStateEnabled, blendFactor, 0xffffffff);
+	mpStateCache->OMSetBlendState(mpAlphaBlendingStateEnabled, blendFactor, 0xffffffff);
 }
 
 void CD3D11::DisableAlphaBlending()
 {
 	float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
-	mpDeviceContext->OMSetBlendState(mpAlphaBlendingStateDisabled, blendFactor, 0xffffffff);
+	mpStateCache->OMSetBlendState(mpAlphaBlendingStateDisabled, blendFactor, 0xffffffff);
 }
 
 void CD3D11::EnableAdditiveAlphaBlending()
 {
 	float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
-	mpDeviceContext->OMSetBlendState(mpAdditiveAlphaBlendingStateEnabled, blendFactor, 0xffffffff);
+	mpStateCache->OMSetBlendState(mpAdditiveAlphaBlendingStateEnabled, blendFactor, 0xffffffff);
 }
 
 void CD3D11::DisableZBuffer()
 {
 	// Create the stencil buffer from the descriptor.
-	mpDeviceContext->OMSetDepthStencilState(mpDepthDisabledStencilState, 1);
+	mpStateCache->OMSetDepthStencilState(mpDepthDisabledStencilState, 1);
 }
 
 void CD3D11::EnableZBuffer()
 {
 	// Create the stencil buffer from the descriptor.
-	mpDeviceContext->OMSetDepthStencilState(mpDepthEnabledStencilState, 1);
+	mpStateCache->OMSetDepthStencilState(mpDepthEnabledStencilState, 1);
 }
 
 /* Gets information about the graphics card that DirectX is using. */
@@ -732,6 +786,8 @@ bool CD3D11::CreateSwapChain(D3D_FEATURE_LEVEL & featureLevel, DXGI_SWAP_CHAIN_D
 		return false;
 	}
 
+	mpStateCache = CStateCache::Get(mpDeviceContext);
+
 	return true;
 }
 
@@ -794,10 +850,10 @@ bool CD3D11::CreateDepthStencilView(D3D11_DEPTH_STENCIL_VIEW_DESC& depthStencilV
 	}
 
 	ID3D11RenderTargetView* nullRenderTarget = nullptr;
-	GetDeviceContext()->OMSetRenderTargets(1, &nullRenderTarget, nullptr);
+	mpStateCache->OMSetRenderTargets(1, &nullRenderTarget, nullptr);
 
 	// Bind the render target view and depth stencil buffer to the output render pipeline.
-	mpDeviceContext->OMSetRenderTargets(1, &mpRenderTargetView, mpDepthStencilView);
+	mpStateCache->OMSetRenderTargets(1, &mpRenderTargetView, mpDepthStencilView);
 
 	return true;
 }
@@ -909,7 +965,7 @@ bool CD3D11::InitRasterizer(D3D11_RASTERIZER_DESC& rasterDesc)
 	}
 
 	// Set the rasterizer state.
-	mpDeviceContext->RSSetState(mpRasterizerState);
+	mpStateCache->RSSetState(mpRasterizerState);
 
 	return true;
 }
@@ -959,7 +1015,7 @@ void CD3D11::SetDepthState(bool depth, bool stencil, bool depthWrite)
 	depthStateDesc.DepthWriteMask = depthWrite ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
 	depthStateDesc.StencilEnable = stencil;
 	mpDevice->CreateDepthStencilState(&depthStateDesc, &mpDepthState);
-	mpDeviceContext->OMSetDepthStencilState(mpDepthState, 1);
+	mpStateCache->OMSetDepthStencilState(mpDepthState, 1);
 
 }
 
@@ -977,14 +1033,28 @@ bool CD3D11::ToggleFullscreen(bool fullscreenEnabled)
 	return true;
 }
 
+void CD3D11::UpdateRenderDeviceStates()
+{
+	CD3D11RenderDevice::FixedStates fixedStates;
+	fixedStates.cullBack = mpRasterizerState;
+	fixedStates.cullNone = mpRasterStateNoCulling;
+	fixedStates.noBlend = mpAlphaBlendingStateDisabled;
+	fixedStates.alphaBlend = mpAlphaBlendingStateEnabled;
+	fixedStates.additiveBlend = mpAdditiveAlphaBlendingStateEnabled;
+	fixedStates.depthTestAndWrite = mpDepthEnabledStencilState;
+	fixedStates.noDepth = mpDepthDisabledStencilState;
+
+	mpRenderDevice->SetFixedStates(fixedStates);
+}
+
 void CD3D11::TurnOnBackFaceCulling()
 {
-	mpDeviceContext->RSSetState(mpRasterizerState);
+	mpStateCache->RSSetState(mpRasterizerState);
 }
 
 void CD3D11::TurnOffBackFaceCulling()
 {
-	mpDeviceContext->RSSetState(mpRasterStateNoCulling);
+	mpStateCache->RSSetState(mpRasterStateNoCulling);
 }
 
 ID3D11DepthStencilView * CD3D11::GetDepthStencilView()
@@ -994,5 +1064,9 @@ ID3D11DepthStencilView * CD3D11::GetDepthStencilView()
 
 void CD3D11::SetBackBufferRenderTarget()
 {
-	mpDeviceContext->OMSetRenderTargets(1, &mpRenderTargetView, mpDepthStencilView);
+	mpStateCache->OMSetRenderTargets(1, &mpRenderTargetView, mpDepthStencilView);
+
+	// Render textures set a viewport of their own size, which may not cover the screen.
+	D3D11_VIEWPORT viewport;
+	InitViewport(viewport);
 }
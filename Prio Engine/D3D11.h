@@ -13,6 +13,9 @@
 #include <d3dx10math.h>
 #include <string>
 #include "PrioEngineVars.h"
+#include "D3D11RenderDevice.h"
+#include "FrameRingBuffer.h"
+#include "StateCache.h"
 #include <AntTweakBar.h>
 
 class CD3D11
@@ -44,6 +47,9 @@ private:
 	ID3D11BlendState* mpAdditiveAlphaBlendingStateEnabled;
 	ID3D11RasterizerState* mpRasterStateNoCulling;
 	ID3D11DepthStencilState* mpDepthState;
+	CD3D11RenderDevice* mpRenderDevice;
+	CFrameRingBuffer* mpVertexRing;
+	CStateCache* mpStateCache;
 public:
 	CD3D11();
 	~CD3D11();
@@ -56,6 +62,12 @@ public:
 
 	ID3D11Device* GetDevice();
 	ID3D11DeviceContext* GetDeviceContext();
+	// Classes moved over to the render device draw through this rather than the device context.
+	CRenderDevice* GetRenderDevice() { return mpRenderDevice; };
+	// Vertices which are only drawn this frame are written here rather than into buffers of their own.
+	CFrameRingBuffer* GetVertexRing() { return mpVertexRing; };
+	// Shadows the state set on the device context, so setting what's already bound costs nothing.
+	CStateCache* GetStateCache() { return mpStateCache; };
 
 	void GetProjectionMatrix(D3DMATRIX& projMatrix);
 	void GetWorldMatrix(D3DMATRIX& worldMatrix);
@@ -88,6 +100,8 @@ private:
 	bool InitRasterizer(D3D11_RASTERIZER_DESC& rasterDesc);
 	void InitViewport(D3D11_VIEWPORT& viewport);
 	void CreateProjMatrix(float screenDepth, float screenNear);
+	// Hands the render device the states its fixed state modes are set from.
+	void UpdateRenderDeviceStates();
 
 
 };
@@ -0,0 +1,732 @@
+#include "D3D11RenderDevice.h"
+#include <vector>
+#include <cstring>
+
+struct CD3D11RenderDevice::D3D11PipelineState
+{
+	ID3D11VertexShader* vertexShader;
+	ID3D11GeometryShader* geometryShader;
+	ID3D11PixelShader* pixelShader;
+	ID3D11InputLayout* layout;
+	ID3D11SamplerState* sampler;
+	Topology topology;
+};
+
+struct CD3D11RenderDevice::D3D11CommandList
+{
+	ID3D11CommandList* commandList;
+	// Counted as the list was recorded, added to the immediate device's once it's executed.
+	Statistics statistics;
+};
+
+namespace
+{
+	// Direct3D takes the same number of slots whatever the stage, textures beyond these are never bound by the engine.
+	const unsigned int kMaxTextureSlots = 16;
+
+	DXGI_FORMAT GetVertexElementFormat(CRenderDevice::VertexElementFormat format)
+	{
+		switch (format)
+		{
+		case CRenderDevice::Float2:
+			return DXGI_FORMAT_R32G32_FLOAT;
+		case CRenderDevice::Float3:
+			return DXGI_FORMAT_R32G32B32_FLOAT;
+		case CRenderDevice::Float4:
+			return DXGI_FORMAT_R32G32B32A32_FLOAT;
+		case CRenderDevice::Half2:
+			return DXGI_FORMAT_R16G16_FLOAT;
+		case CRenderDevice::Short2Norm:
+			return DXGI_FORMAT_R16G16_SNORM;
+		case CRenderDevice::Short4Norm:
+			return DXGI_FORMAT_R16G16B16A16_SNORM;
+		}
+
+		return DXGI_FORMAT_UNKNOWN;
+	}
+
+	DXGI_FORMAT GetTextureFormat(CRenderDevice::TextureFormat format)
+	{
+		switch (format)
+		{
+		case CRenderDevice::RGBA8Format:
+			return DXGI_FORMAT_R8G8B8A8_UNORM;
+		case CRenderDevice::BC1Format:
+			return DXGI_FORMAT_BC1_UNORM;
+		case CRenderDevice::BC3Format:
+			return DXGI_FORMAT_BC3_UNORM;
+		case CRenderDevice::BC5Format:
+			return DXGI_FORMAT_BC5_UNORM;
+		}
+
+		return DXGI_FORMAT_UNKNOWN;
+	}
+
+	unsigned long long CountPrimitives(CRenderDevice::Topology topology, unsigned int count)
+	{
+		return topology == CRenderDevice::PointList ? count : count / 3;
+	}
+
+	template<typename Interface>
+	void SafeRelease(Interface*& object)
+	{
+		if (object != nullptr)
+		{
+			object->Release();
+			object = nullptr;
+		}
+	}
+
+	template<typename Interface>
+	void SafeRelease(Interface** objects, unsigned int count)
+	{
+		for (unsigned int object = 0; object < count; object++)
+		{
+			SafeRelease(objects[object]);
+		}
+	}
+}
+
+CD3D11RenderDevice::CD3D11RenderDevice(ID3D11Device* device, ID3D11DeviceContext* deviceContext)
+{
+	mpDevice = device;
+	mpDeviceContext = deviceContext;
+	mpStateCache = CStateCache::Get(deviceContext);
+	mpImmediateDevice = nullptr;
+	mpLinearWrapSampler = nullptr;
+	mpLinearClampSampler = nullptr;
+	std::memset(&mFixedStates, 0, sizeof(mFixedStates));
+	mTopology = TriangleList;
+	mLastFence = 0;
+	mCompletedFence = 0;
+}
+
+
+CD3D11RenderDevice::CD3D11RenderDevice(ID3D11Device* device, ID3D11DeviceContext* deferredContext, CD3D11RenderDevice* immediateDevice) : CD3D11RenderDevice(device, deferredContext)
+{
+	mpImmediateDevice = immediateDevice;
+}
+
+CD3D11RenderDevice::~CD3D11RenderDevice()
+{
+	Shutdown();
+}
+
+/* Create the samplers pipeline states can ask for, they're shared rather than made per pipeline.
+* @Returns bool Success */
+bool CD3D11RenderDevice::Initialise()
+{
+	D3D11_SAMPLER_DESC samplerDesc;
+	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.MipLODBias = 0.0f;
+	samplerDesc.MaxAnisotropy = 1;
+	samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+	samplerDesc.BorderColor[0] = 0;
+	samplerDesc.BorderColor[1] = 0;
+	samplerDesc.BorderColor[2] = 0;
+	samplerDesc.BorderColor[3] = 0;
+	samplerDesc.MinLOD = 0;
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+	if (FAILED(mpDevice->CreateSamplerState(&samplerDesc, &mpLinearWrapSampler)))
+	{
+		logger->GetInstance().WriteLine("Failed to create the wrapping sampler state for the render device.");
+		return false;
+	}
+
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+
+	if (FAILED(mpDevice->CreateSamplerState(&samplerDesc, &mpLinearClampSampler)))
+	{
+		logger->GetInstance().WriteLine("Failed to create the clamping sampler state for the render device.");
+		return false;
+	}
+
+	return true;
+}
+
+void CD3D11RenderDevice::Shutdown()
+{
+	SafeRelease(mpLinearClampSampler);
+	SafeRelease(mpLinearWrapSampler);
+
+	for (auto& pendingFence : mPendingFences)
+	{
+		SafeRelease(pendingFence.query);
+	}
+	mPendingFences.clear();
+
+	for (auto& query : mFreeQueries)
+	{
+		SafeRelease(query);
+	}
+	mFreeQueries.clear();
+
+	if (mpImmediateDevice != nullptr && mpDeviceContext != nullptr)
+	{
+		CStateCache::Release(mpDeviceContext);
+		mpStateCache = nullptr;
+		SafeRelease(mpDeviceContext);
+	}
+}
+
+CRenderDevice::Buffer* CD3D11RenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+	D3D11_BUFFER_DESC bufferDesc;
+	bufferDesc.ByteWidth = desc.size;
+	bufferDesc.Usage = desc.usage == DynamicUsage ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_IMMUTABLE;
+	bufferDesc.CPUAccessFlags = desc.usage == DynamicUsage ? D3D11_CPU_ACCESS_WRITE : 0;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	switch (desc.type)
+	{
+	case VertexBuffer:
+		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		break;
+	case IndexBuffer:
+		bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		break;
+	case ConstantBuffer:
+		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		break;
+	}
+
+	D3D11_SUBRESOURCE_DATA initData;
+	initData.pSysMem = initialData;
+	initData.SysMemPitch = 0;
+	initData.SysMemSlicePitch = 0;
+
+	ID3D11Buffer* buffer = nullptr;
+	if (FAILED(mpDevice->CreateBuffer(&bufferDesc, initialData != nullptr ? &initData : NULL, &buffer)))
+	{
+		logger->GetInstance().WriteLine("Failed to create a buffer of " + std::to_string(desc.size) + " bytes.");
+		return nullptr;
+	}
+
+	mResourceMemory += desc.size;
+
+	return WrapBuffer(buffer);
+}
+
+void CD3D11RenderDevice::DestroyBuffer(Buffer* buffer)
+{
+	ID3D11Buffer* nativeBuffer = GetNativeBuffer(buffer);
+	if (nativeBuffer == nullptr)
+	{
+		return;
+	}
+
+	D3D11_BUFFER_DESC bufferDesc;
+	nativeBuffer->GetDesc(&bufferDesc);
+	mResourceMemory -= bufferDesc.ByteWidth;
+
+	nativeBuffer->Release();
+}
+
+CRenderDevice::Texture* CD3D11RenderDevice::CreateTexture(const TextureDesc& desc, const void* data)
+{
+	D3D11_TEXTURE2D_DESC textureDesc;
+	textureDesc.Width = desc.width;
+	textureDesc.Height = desc.height;
+	textureDesc.MipLevels = desc.mipLevels;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = GetTextureFormat(desc.format);
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = 0;
+
+	// Point each subresource at its level in the tightly packed chain.
+	std::vector<D3D11_SUBRESOURCE_DATA> initData(desc.mipLevels);
+	const unsigned char* level = static_cast<const unsigned char*>(data);
+	unsigned int width = desc.width;
+	unsigned int height = desc.height;
+
+	for (unsigned int mip = 0; mip < desc.mipLevels; mip++)
+	{
+		unsigned int rowPitch;
+		unsigned int numberOfRows;
+		GetMipLayout(desc.format, width, height, rowPitch, numberOfRows);
+
+		initData[mip].pSysMem = level;
+		initData[mip].SysMemPitch = rowPitch;
+		initData[mip].SysMemSlicePitch = 0;
+		level += static_cast<size_t>(rowPitch) * numberOfRows;
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	ID3D11Texture2D* texture = nullptr;
+	if (FAILED(mpDevice->CreateTexture2D(&textureDesc, initData.data(), &texture)))
+	{
+		logger->GetInstance().WriteLine("Failed to create a " + std::to_string(desc.width) + "x" + std::to_string(desc.height) + " texture.");
+		return nullptr;
+	}
+
+	ID3D11ShaderResourceView* view = nullptr;
+	HRESULT result = mpDevice->CreateShaderResourceView(texture, NULL, &view);
+	texture->Release();
+
+	if (FAILED(result))
+	{
+		logger->GetInstance().WriteLine("Failed to create the shader resource view of a texture.");
+		return nullptr;
+	}
+
+	mResourceMemory += CalculateTextureSize(desc);
+
+	return WrapTexture(view);
+}
+
+void CD3D11RenderDevice::DestroyTexture(Texture* texture)
+{
+	ID3D11ShaderResourceView* view = GetNativeTexture(texture);
+	if (view == nullptr)
+	{
+		return;
+	}
+
+	ID3D11Resource* resource = nullptr;
+	view->GetResource(&resource);
+	D3D11_TEXTURE2D_DESC textureDesc;
+	static_cast<ID3D11Texture2D*>(resource)->GetDesc(&textureDesc);
+	resource->Release();
+
+	TextureDesc desc;
+	desc.width = textureDesc.Width;
+	desc.height = textureDesc.Height;
+	desc.mipLevels = textureDesc.MipLevels;
+	desc.format = textureDesc.Format == DXGI_FORMAT_BC1_UNORM ? BC1Format : textureDesc.Format == DXGI_FORMAT_BC3_UNORM ? BC3Format :
+		textureDesc.Format == DXGI_FORMAT_BC5_UNORM ? BC5Format : RGBA8Format;
+	mResourceMemory -= CalculateTextureSize(desc);
+
+	view->Release();
+}
+
+CRenderDevice::PipelineState* CD3D11RenderDevice::CreatePipelineState(const PipelineStateDesc& desc)
+{
+	D3D11PipelineState* pipelineState = new D3D11PipelineState();
+	pipelineState->vertexShader = nullptr;
+	pipelineState->geometryShader = nullptr;
+	pipelineState->pixelShader = nullptr;
+	pipelineState->layout = nullptr;
+	pipelineState->sampler = desc.sampler == LinearWrapSampler ? mpLinearWrapSampler : desc.sampler == LinearClampSampler ? mpLinearClampSampler : nullptr;
+	pipelineState->topology = desc.topology;
+
+	bool successful = SUCCEEDED(mpDevice->CreateVertexShader(desc.vertexShader, desc.vertexShaderSize, NULL, &pipelineState->vertexShader));
+
+	if (successful && desc.geometryShader != nullptr)
+	{
+		successful = SUCCEEDED(mpDevice->CreateGeometryShader(desc.geometryShader, desc.geometryShaderSize, NULL, &pipelineState->geometryShader));
+	}
+
+	if (successful && desc.pixelShader != nullptr)
+	{
+		successful = SUCCEEDED(mpDevice->CreatePixelShader(desc.pixelShader, desc.pixelShaderSize, NULL, &pipelineState->pixelShader));
+	}
+
+	if (successful)
+	{
+		std::vector<D3D11_INPUT_ELEMENT_DESC> elements(desc.numberOfVertexElements);
+		for (unsigned int element = 0; element < desc.numberOfVertexElements; element++)
+		{
+			elements[element].SemanticName = desc.vertexElements[element].semanticName;
+			elements[element].SemanticIndex = desc.vertexElements[element].semanticIndex;
+			elements[element].Format = GetVertexElementFormat(desc.vertexElements[element].format);
+			elements[element].InputSlot = 0;
+			elements[element].AlignedByteOffset = desc.vertexElements[element].offset;
+			elements[element].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+			elements[element].InstanceDataStepRate = 0;
+		}
+
+		successful = SUCCEEDED(mpDevice->CreateInputLayout(elements.data(), desc.numberOfVertexElements, desc.vertexShader, desc.vertexShaderSize, &pipelineState->layout));
+	}
+
+	if (!successful)
+	{
+		logger->GetInstance().WriteLine("Failed to create the shaders or input layout of a pipeline state.");
+		DestroyPipelineState(reinterpret_cast<PipelineState*>(pipelineState));
+		return nullptr;
+	}
+
+	return reinterpret_cast<PipelineState*>(pipelineState);
+}
+
+void CD3D11RenderDevice::DestroyPipelineState(PipelineState* pipelineState)
+{
+	D3D11PipelineState* d3d11PipelineState = reinterpret_cast<D3D11PipelineState*>(pipelineState);
+	if (d3d11PipelineState == nullptr)
+	{
+		return;
+	}
+
+	SafeRelease(d3d11PipelineState->layout);
+	SafeRelease(d3d11PipelineState->pixelShader);
+	SafeRelease(d3d11PipelineState->geometryShader);
+	SafeRelease(d3d11PipelineState->vertexShader);
+	delete d3d11PipelineState;
+}
+
+void* CD3D11RenderDevice::Map(Buffer* buffer)
+{
+	ID3D11Buffer* nativeBuffer = GetNativeBuffer(buffer);
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+	if (FAILED(mpDeviceContext->Map(nativeBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource)))
+	{
+		logger->GetInstance().WriteLine("Failed to map a buffer for writing.");
+		return nullptr;
+	}
+
+	D3D11_BUFFER_DESC bufferDesc;
+	nativeBuffer->GetDesc(&bufferDesc);
+	mStatistics.maps++;
+	mStatistics.uploadBytes += bufferDesc.ByteWidth;
+
+	return mappedResource.pData;
+}
+
+void CD3D11RenderDevice::Unmap(Buffer* buffer)
+{
+	mpDeviceContext->Unmap(GetNativeBuffer(buffer), 0);
+}
+
+void* CD3D11RenderDevice::MapNoOverwrite(Buffer* buffer, unsigned int offset, unsigned int size)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+	// Before Direct3D 11.1 a deferred context can only map by discarding.
+	if (mpImmediateDevice != nullptr)
+	{
+		logger->GetInstance().WriteLine("Can't map a buffer without overwriting on a deferred render device.");
+		return nullptr;
+	}
+
+	if (FAILED(mpDeviceContext->Map(GetNativeBuffer(buffer), 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mappedResource)))
+	{
+		logger->GetInstance().WriteLine("Failed to map a buffer for writing without overwriting.");
+		return nullptr;
+	}
+
+	mStatistics.maps++;
+	mStatistics.uploadBytes += size;
+
+	return static_cast<unsigned char*>(mappedResource.pData) + offset;
+}
+
+unsigned long long CD3D11RenderDevice::InsertFence()
+{
+	// Queries can't be read back from a deferred context, and where the fence really lands depends on when it's executed.
+	if (mpImmediateDevice != nullptr)
+	{
+		logger->GetInstance().WriteLine("Can't insert a fence on a deferred render device.");
+		return 0;
+	}
+
+	PendingFence pendingFence;
+	pendingFence.fence = ++mLastFence;
+	pendingFence.query = nullptr;
+
+	if (!mFreeQueries.empty())
+	{
+		pendingFence.query = mFreeQueries.back();
+		mFreeQueries.pop_back();
+	}
+	else
+	{
+		D3D11_QUERY_DESC queryDesc;
+		queryDesc.Query = D3D11_QUERY_EVENT;
+		queryDesc.MiscFlags = 0;
+
+		// Without a query the fence counts as passed once the fences before it have, which is the best that can be done.
+		if (FAILED(mpDevice->CreateQuery(&queryDesc, &pendingFence.query)))
+		{
+			logger->GetInstance().WriteLine("Failed to create an event query for a fence.");
+			pendingFence.query = nullptr;
+		}
+	}
+
+	if (pendingFence.query != nullptr)
+	{
+		mpDeviceContext->End(pendingFence.query);
+	}
+
+	mPendingFences.push_back(pendingFence);
+
+	return pendingFence.fence;
+}
+
+bool CD3D11RenderDevice::IsFenceComplete(unsigned long long fence)
+{
+	// Queries finish in order, so stop at the first which hasn't.
+	while (!mPendingFences.empty() && fence > mCompletedFence)
+	{
+		PendingFence& pendingFence = mPendingFences.front();
+		if (pendingFence.query != nullptr && mpDeviceContext->GetData(pendingFence.query, NULL, 0, 0) != S_OK)
+		{
+			break;
+		}
+
+		mCompletedFence = pendingFence.fence;
+		if (pendingFence.query != nullptr)
+		{
+			mFreeQueries.push_back(pendingFence.query);
+		}
+		mPendingFences.pop_front();
+	}
+
+	return fence <= mCompletedFence;
+}
+
+void CD3D11RenderDevice::SetPipelineState(PipelineState* pipelineState)
+{
+	D3D11PipelineState* d3d11PipelineState = reinterpret_cast<D3D11PipelineState*>(pipelineState);
+
+	// Classes which haven't moved to the render device set shaders themselves, so nothing can be assumed still bound.
+	mpStateCache->IASetInputLayout(d3d11PipelineState->layout);
+	mpStateCache->IASetPrimitiveTopology(d3d11PipelineState->topology == PointList ? D3D11_PRIMITIVE_TOPOLOGY_POINTLIST : D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	mpStateCache->VSSetShader(d3d11PipelineState->vertexShader, NULL, 0);
+	mpStateCache->GSSetShader(d3d11PipelineState->geometryShader, NULL, 0);
+	mpStateCache->PSSetShader(d3d11PipelineState->pixelShader, NULL, 0);
+
+	if (d3d11PipelineState->sampler != nullptr)
+	{
+		mpStateCache->PSSetSamplers(0, 1, &d3d11PipelineState->sampler);
+	}
+
+	mTopology = d3d11PipelineState->topology;
+	mStatistics.pipelineChanges++;
+}
+
+void CD3D11RenderDevice::SetVertexBuffer(Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	ID3D11Buffer* nativeBuffer = GetNativeBuffer(buffer);
+	mpStateCache->IASetVertexBuffers(0, 1, &nativeBuffer, &stride, &offset);
+	mStatistics.bufferBindings++;
+}
+
+void CD3D11RenderDevice::SetIndexBuffer(Buffer* buffer, IndexFormat format, unsigned int offset)
+{
+	mpStateCache->IASetIndexBuffer(GetNativeBuffer(buffer), format == Index16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, offset);
+	mStatistics.bufferBindings++;
+}
+
+void CD3D11RenderDevice::SetConstantBuffer(ShaderStage stage, unsigned int slot, Buffer* buffer)
+{
+	ID3D11Buffer* nativeBuffer = GetNativeBuffer(buffer);
+
+	switch (stage)
+	{
+	case VertexStage:
+		mpStateCache->VSSetConstantBuffers(slot, 1, &nativeBuffer);
+		break;
+	case GeometryStage:
+		mpStateCache->GSSetConstantBuffers(slot, 1, &nativeBuffer);
+		break;
+	case PixelStage:
+		mpStateCache->PSSetConstantBuffers(slot, 1, &nativeBuffer);
+		break;
+	}
+
+	mStatistics.bufferBindings++;
+}
+
+void CD3D11RenderDevice::SetTextures(ShaderStage stage, unsigned int firstSlot, unsigned int count, Texture* const* textures)
+{
+	// The handles are the views themselves.
+	ID3D11ShaderResourceView* views[kMaxTextureSlots];
+	count = count < kMaxTextureSlots ? count : kMaxTextureSlots;
+	for (unsigned int texture = 0; texture < count; texture++)
+	{
+		views[texture] = GetNativeTexture(textures[texture]);
+	}
+
+	switch (stage)
+	{
+	case VertexStage:
+		mpStateCache->VSSetShaderResources(firstSlot, count, views);
+		break;
+	case GeometryStage:
+		mpStateCache->GSSetShaderResources(firstSlot, count, views);
+		break;
+	case PixelStage:
+		mpStateCache->PSSetShaderResources(firstSlot, count, views);
+		break;
+	}
+
+	mStatistics.textureBindings += count;
+}
+
+void CD3D11RenderDevice::SetCullMode(CullMode mode)
+{
+	mpStateCache->RSSetState(mode == CullNone ? mFixedStates.cullNone : mFixedStates.cullBack);
+	mStatistics.fixedStateChanges++;
+}
+
+void CD3D11RenderDevice::SetBlendMode(BlendMode mode)
+{
+	const float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	switch (mode)
+	{
+	case NoBlend:
+		mpStateCache->OMSetBlendState(mFixedStates.noBlend, blendFactor, 0xffffffff);
+		break;
+	case AlphaBlend:
+		mpStateCache->OMSetBlendState(mFixedStates.alphaBlend, blendFactor, 0xffffffff);
+		break;
+	case AdditiveBlend:
+		mpStateCache->OMSetBlendState(mFixedStates.additiveBlend, blendFactor, 0xffffffff);
+		break;
+	}
+
+	mStatistics.fixedStateChanges++;
+}
+
+void CD3D11RenderDevice::SetDepthMode(DepthMode mode)
+{
+	mpStateCache->OMSetDepthStencilState(mode == NoDepth ? mFixedStates.noDepth : mFixedStates.depthTestAndWrite, 1);
+	mStatistics.fixedStateChanges++;
+}
+
+void CD3D11RenderDevice::Draw(unsigned int vertexCount, unsigned int firstVertex)
+{
+	mpDeviceContext->Draw(vertexCount, firstVertex);
+	mStatistics.draws++;
+	mStatistics.primitives += CountPrimitives(mTopology, vertexCount);
+}
+
+void CD3D11RenderDevice::DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex)
+{
+	mpDeviceContext->DrawIndexed(indexCount, firstIndex, baseVertex);
+	mStatistics.draws++;
+	mStatistics.primitives += CountPrimitives(mTopology, indexCount);
+}
+
+CRenderDevice* CD3D11RenderDevice::CreateDeferredDevice()
+{
+	ID3D11DeviceContext* deferredContext = nullptr;
+	if (FAILED(mpDevice->CreateDeferredContext(0, &deferredContext)))
+	{
+		logger->GetInstance().WriteLine("Failed to create a deferred context for a deferred render device.");
+		return nullptr;
+	}
+
+	return new CD3D11RenderDevice(mpDevice, deferredContext, this);
+}
+
+/* A deferred context starts each command list with nothing bound, unlike the state a pass expects to inherit from the
+* immediate context. Copy over the outputs, fixed state and constant buffers, which covers the shared constants, along
+* with the states the fixed state modes are set from. */
+void CD3D11RenderDevice::BeginCommandList()
+{
+	if (mpImmediateDevice == nullptr)
+	{
+		logger->GetInstance().WriteLine("Only a deferred render device can record a command list.");
+		return;
+	}
+
+	ID3D11DeviceContext* immediateContext = mpImmediateDevice->mpDeviceContext;
+	mFixedStates = mpImmediateDevice->mFixedStates;
+
+	ID3D11RenderTargetView* renderTargets[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+	ID3D11DepthStencilView* depthStencilView = nullptr;
+	immediateContext->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, &depthStencilView);
+	mpStateCache->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, renderTargets, depthStencilView);
+	SafeRelease(renderTargets, D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT);
+	SafeRelease(depthStencilView);
+
+	D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+	UINT numberOfViewports = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+	immediateContext->RSGetViewports(&numberOfViewports, viewports);
+	mpDeviceContext->RSSetViewports(numberOfViewports, viewports);
+
+	ID3D11RasterizerState* rasterizerState = nullptr;
+	immediateContext->RSGetState(&rasterizerState);
+	mpStateCache->RSSetState(rasterizerState);
+	SafeRelease(rasterizerState);
+
+	ID3D11BlendState* blendState = nullptr;
+	FLOAT blendFactor[4];
+	UINT sampleMask;
+	immediateContext->OMGetBlendState(&blendState, blendFactor, &sampleMask);
+	mpStateCache->OMSetBlendState(blendState, blendFactor, sampleMask);
+	SafeRelease(blendState);
+
+	ID3D11DepthStencilState* depthStencilState = nullptr;
+	UINT stencilRef;
+	immediateContext->OMGetDepthStencilState(&depthStencilState, &stencilRef);
+	mpStateCache->OMSetDepthStencilState(depthStencilState, stencilRef);
+	SafeRelease(depthStencilState);
+
+	ID3D11Buffer* constantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+	immediateContext->VSGetConstantBuffers(0, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, constantBuffers);
+	mpStateCache->VSSetConstantBuffers(0, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, constantBuffers);
+	SafeRelease(constantBuffers, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+
+	immediateContext->GSGetConstantBuffers(0, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, constantBuffers);
+	mpStateCache->GSSetConstantBuffers(0, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, constantBuffers);
+	SafeRelease(constantBuffers, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+
+	immediateContext->PSGetConstantBuffers(0, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, constantBuffers);
+	mpStateCache->PSSetConstantBuffers(0, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, constantBuffers);
+	SafeRelease(constantBuffers, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+}
+
+CRenderDevice::CommandList* CD3D11RenderDevice::FinishCommandList()
+{
+	ID3D11CommandList* nativeCommandList = nullptr;
+	const HRESULT result = mpDeviceContext->FinishCommandList(FALSE, &nativeCommandList);
+
+	// Finishing clears everything bound to the deferred context, whether it worked or not.
+	mpStateCache->Invalidate();
+
+	if (FAILED(result))
+	{
+		logger->GetInstance().WriteLine("Failed to finish recording a command list.");
+		return nullptr;
+	}
+
+	D3D11CommandList* commandList = new D3D11CommandList();
+	commandList->commandList = nativeCommandList;
+	commandList->statistics = mStatistics;
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+
+	return reinterpret_cast<CommandList*>(commandList);
+}
+
+void CD3D11RenderDevice::ExecuteCommandList(CommandList* commandList)
+{
+	D3D11CommandList* d3d11CommandList = reinterpret_cast<D3D11CommandList*>(commandList);
+	if (d3d11CommandList == nullptr)
+	{
+		return;
+	}
+
+	// Restoring the state afterwards costs the driver a little, but keeps the state cache's copy of it true.
+	mpDeviceContext->ExecuteCommandList(d3d11CommandList->commandList, TRUE);
+	AddStatistics(d3d11CommandList->statistics);
+
+	DiscardCommandList(commandList);
+}
+
+void CD3D11RenderDevice::DiscardCommandList(CommandList* commandList)
+{
+	D3D11CommandList* d3d11CommandList = reinterpret_cast<D3D11CommandList*>(commandList);
+	if (d3d11CommandList == nullptr)
+	{
+		return;
+	}
+
+	SafeRelease(d3d11CommandList->commandList);
+	delete d3d11CommandList;
+}
@@ -0,0 +1,104 @@
+#ifndef D3D11RENDERDEVICE_H
+#define D3D11RENDERDEVICE_H
+
+#include <d3d11.h>
+#include <deque>
+#include <vector>
+#include "RenderDevice.h"
+#include "StateCache.h"
+
+/* The render device backed by Direct3D 11. Buffer and texture handles are the Direct3D objects themselves, so resources
+* made by classes which haven't moved over yet can be passed in with WrapBuffer and WrapTexture at no cost.
+* Deferred devices record into a deferred context of their own, and can't insert fences or map without overwriting. */
+class CD3D11RenderDevice : public CRenderDevice
+{
+public:
+	// Owned by CD3D11, which hands them over again whenever it rebuilds one, such as when wireframe is toggled.
+	struct FixedStates
+	{
+		ID3D11RasterizerState* cullBack;
+		ID3D11RasterizerState* cullNone;
+		ID3D11BlendState* noBlend;
+		ID3D11BlendState* alphaBlend;
+		ID3D11BlendState* additiveBlend;
+		ID3D11DepthStencilState* depthTestAndWrite;
+		ID3D11DepthStencilState* noDepth;
+	};
+public:
+	CD3D11RenderDevice(ID3D11Device* device, ID3D11DeviceContext* deviceContext);
+	~CD3D11RenderDevice();
+public:
+	bool Initialise();
+	void Shutdown();
+
+	Buffer* CreateBuffer(const BufferDesc& desc, const void* initialData);
+	void DestroyBuffer(Buffer* buffer);
+	Texture* CreateTexture(const TextureDesc& desc, const void* data);
+	void DestroyTexture(Texture* texture);
+	PipelineState* CreatePipelineState(const PipelineStateDesc& desc);
+	void DestroyPipelineState(PipelineState* pipelineState);
+
+	void* Map(Buffer* buffer);
+	void Unmap(Buffer* buffer);
+	void* MapNoOverwrite(Buffer* buffer, unsigned int offset, unsigned int size);
+
+	unsigned long long InsertFence();
+	bool IsFenceComplete(unsigned long long fence);
+
+	void SetPipelineState(PipelineState* pipelineState);
+	void SetVertexBuffer(Buffer* buffer, unsigned int stride, unsigned int offset);
+	void SetIndexBuffer(Buffer* buffer, IndexFormat format, unsigned int offset);
+	void SetConstantBuffer(ShaderStage stage, unsigned int slot, Buffer* buffer);
+	void SetTextures(ShaderStage stage, unsigned int firstSlot, unsigned int count, Texture* const* textures);
+	void SetCullMode(CullMode mode);
+	void SetBlendMode(BlendMode mode);
+	void SetDepthMode(DepthMode mode);
+
+	void Draw(unsigned int vertexCount, unsigned int firstVertex);
+	void DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex);
+
+	CRenderDevice* CreateDeferredDevice();
+	void BeginCommandList();
+	CommandList* FinishCommandList();
+	void ExecuteCommandList(CommandList* commandList);
+	void DiscardCommandList(CommandList* commandList);
+
+	// Only on the immediate device, deferred devices take them from it each time they begin a list.
+	void SetFixedStates(const FixedStates& fixedStates) { mFixedStates = fixedStates; };
+
+	static Buffer* WrapBuffer(ID3D11Buffer* buffer) { return reinterpret_cast<Buffer*>(buffer); };
+	static ID3D11Buffer* GetNativeBuffer(Buffer* buffer) { return reinterpret_cast<ID3D11Buffer*>(buffer); };
+	static Texture* WrapTexture(ID3D11ShaderResourceView* texture) { return reinterpret_cast<Texture*>(texture); };
+	static ID3D11ShaderResourceView* GetNativeTexture(Texture* texture) { return reinterpret_cast<ID3D11ShaderResourceView*>(texture); };
+	// The context the device records or issues its commands on, for classes which still draw through Direct3D themselves.
+	static ID3D11DeviceContext* GetNativeContext(CRenderDevice* renderDevice) { return static_cast<CD3D11RenderDevice*>(renderDevice)->mpDeviceContext; };
+private:
+	CD3D11RenderDevice(ID3D11Device* device, ID3D11DeviceContext* deferredContext, CD3D11RenderDevice* immediateDevice);
+private:
+	struct D3D11PipelineState;
+	struct D3D11CommandList;
+
+	struct PendingFence
+	{
+		unsigned long long fence;
+		ID3D11Query* query;
+	};
+private:
+	ID3D11Device* mpDevice;
+	ID3D11DeviceContext* mpDeviceContext;
+	CStateCache* mpStateCache;
+	// Set for deferred devices only, which own their context.
+	CD3D11RenderDevice* mpImmediateDevice;
+	ID3D11SamplerState* mpLinearWrapSampler;
+	ID3D11SamplerState* mpLinearClampSampler;
+	FixedStates mFixedStates;
+	// Topology of the bound pipeline state, for counting primitives.
+	Topology mTopology;
+	// Event queries standing in for fences, oldest first. Finished queries are kept to be reused.
+	std::deque<PendingFence> mPendingFences;
+	std::vector<ID3D11Query*> mFreeQueries;
+	unsigned long long mLastFence;
+	unsigned long long mCompletedFence;
+};
+
+#endif
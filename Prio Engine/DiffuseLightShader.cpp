@@ -1,13 +1,63 @@
 #include "DiffuseLightShader.h"
 
+namespace
+{
+	// The vertex layout of meshes which aren't quantised, described for the render device.
+	const CRenderDevice::VertexElement kFloatVertexElements[] =
+	{
+		{ "POSITION", 0, CRenderDevice::Float3, 0 },
+		{ "TEXCOORD", 0, CRenderDevice::Float2, 12 },
+		{ "NORMAL", 0, CRenderDevice::Float3, 20 }
+	};
+
+	// Matches kQuantisedVertexLayout.
+	const CRenderDevice::VertexElement kQuantisedVertexElements[] =
+	{
+		{ "POSITION", 0, CRenderDevice::Short4Norm, 0 },
+		{ "TEXCOORD", 0, CRenderDevice::Half2, 8 },
+		{ "NORMAL", 0, CRenderDevice::Short2Norm, 12 }
+	};
+
+	CRenderDevice::PipelineStateDesc DescribePipelineState(ID3D10Blob* vertexShaderBuffer, ID3D10Blob* pixelShaderBuffer,
+		const CRenderDevice::VertexElement* vertexElements, unsigned int numberOfVertexElements)
+	{
+		CRenderDevice::PipelineStateDesc desc;
+		desc.vertexShader = vertexShaderBuffer->GetBufferPointer();
+		desc.vertexShaderSize = vertexShaderBuffer->GetBufferSize();
+		desc.geometryShader = nullptr;
+		desc.geometryShaderSize = 0;
+		desc.pixelShader = pixelShaderBuffer->GetBufferPointer();
+		desc.pixelShaderSize = pixelShaderBuffer->GetBufferSize();
+		desc.vertexElements = vertexElements;
+		desc.numberOfVertexElements = numberOfVertexElements;
+		desc.topology = CRenderDevice::TriangleList;
+		desc.sampler = CRenderDevice::LinearWrapSampler;
+		return desc;
+	}
+
+	void ReleaseShaderBuffer(ID3D10Blob*& shaderBuffer)
+	{
+		if (shaderBuffer)
+		{
+			shaderBuffer->Release();
+			shaderBuffer = nullptr;
+		}
+	}
+}
 
-CDiffuseLightShader::CDiffuseLightShader()
+CDiffuseLightShader::CDiffuseLightShader(CRenderDevice* renderDevice)
 {
-	mpVertexShader = nullptr;
-	mpPixelShader = nullptr;
-	mpLayout = nullptr;
-	mpSampleState = nullptr;
-	mpLightBuffer = nullptr;
+	mpRenderDevice = renderDevice;
+	mpPipelineState = nullptr;
+	mpQuantisedPipelineState = nullptr;
+	mpTransparentPipelineState = nullptr;
+	mPipelineStateId = CDrawList::AllocateStateId();
+	mQuantisedPipelineStateId = CDrawList::AllocateStateId();
+
+	for (unsigned int buffer = 0; buffer < kNumberOfMapBuffers; buffer++)
+	{
+		mpMapBuffers[buffer] = nullptr;
+	}
 }
 
 CDiffuseLightShader::~CDiffuseLightShader()
@@ -16,17 +66,8 @@ CDiffuseLightShader::~CDiffuseLightShader()
 
 bool CDiffuseLightShader::Initialise(ID3D11Device * device, HWND hwnd)
 {
-	bool result;
-
-	// Initialise the vertex pixel shaders.
-	result = InitialiseShader(device, hwnd, "Shaders/DiffuseLight.vs.hlsl", "Shaders/DiffuseLight.ps.hlsl", "Shaders/Transparent.ps.hlsl");
-
-	if (!result)
-	{
-		return false;
-	}
-
-	return true;
+	// Initialise the vertex pixel shaders, the device itself is reached through the render device.
+	return InitialiseShader(hwnd, "Shaders/DiffuseLight.vs.hlsl", "Shaders/DiffuseLight.ps.hlsl", "Shaders/Transparent.ps.hlsl");
 }
 
 void CDiffuseLightShader::Shutdown()
@@ -35,226 +76,91 @@ void CDiffuseLightShader::Shutdown()
 	ShutdownShader();
 }
 
-bool CDiffuseLightShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, ID3D11ShaderResourceView** textures, int numberOfTextures,
-	D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour)
+bool CDiffuseLightShader::InitialiseShader(HWND hwnd, std::string vsFilename, std::string psFilename, std::string transparentPSFilename)
 {
+	ID3D10Blob* vertexShaderBuffer = nullptr;
+	ID3D10Blob* quantisedVertexShaderBuffer = nullptr;
+	ID3D10Blob* pixelShaderBuffer = nullptr;
+	ID3D10Blob* transparentPixelShaderBuffer = nullptr;
+	CRenderDevice::BufferDesc bufferDesc;
 	bool result;
 
-	// Set the shader parameters that it will use for rendering.
-	result = SetShaderParameters(deviceContext, textures, numberOfTextures, lightDirection, diffuseColour, ambientColour);
-	if (!result)
-	{
-		return false;
-	}
+	// Compile everything first, the pipeline states share the pixel shader between both vertex formats.
+	result = CompileShader(hwnd, vsFilename, "LightVertexShader", "vs_5_0", &vertexShaderBuffer) &&
+		CompileShader(hwnd, vsFilename, "LightVertexShaderQuantised", "vs_5_0", &quantisedVertexShaderBuffer) &&
+		CompileShader(hwnd, psFilename, "LightPixelShader", "ps_5_0", &pixelShaderBuffer) &&
+		CompileShader(hwnd, transparentPSFilename, "TransparentPS", "ps_5_0", &transparentPixelShaderBuffer);
 
-	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	if (result)
+	{
+		mpPipelineState = mpRenderDevice->CreatePipelineState(DescribePipelineState(vertexShaderBuffer, pixelShaderBuffer,
+			kFloatVertexElements, sizeof(kFloatVertexElements) / sizeof(kFloatVertexElements[0])));
+		mpQuantisedPipelineState = mpRenderDevice->CreatePipelineState(DescribePipelineState(quantisedVertexShaderBuffer, pixelShaderBuffer,
+			kQuantisedVertexElements, sizeof(kQuantisedVertexElements) / sizeof(kQuantisedVertexElements[0])));
+		mpTransparentPipelineState = mpRenderDevice->CreatePipelineState(DescribePipelineState(vertexShaderBuffer, transparentPixelShaderBuffer,
+			kFloatVertexElements, sizeof(kFloatVertexElements) / sizeof(kFloatVertexElements[0])));
 
-	return true;
-}
+		result = mpPipelineState != nullptr && mpQuantisedPipelineState != nullptr && mpTransparentPipelineState != nullptr;
+		if (!result)
+		{
+			logger->GetInstance().WriteLine("Failed to create the pipeline states in diffuse light shader.");
+		}
+	}
 
-bool CDiffuseLightShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string vsFilename, std::string psFilename, std::string transparentPSFilename)
-{
-	HRESULT result;
-	ID3D10Blob* errorMessage;
-	ID3D10Blob* vertexShaderBuffer;
-	ID3D10Blob* pixelShaderBuffer;
-	D3D11_INPUT_ELEMENT_DESC polygonLayout[3];
-	unsigned int numElements;
-	D3D11_SAMPLER_DESC samplerDesc;
-	D3D11_BUFFER_DESC lightBufferDesc;
-	D3D11_BUFFER_DESC mapBufferDesc;
-
-	// Initialise pointers in this function to null.
-	errorMessage = nullptr;
-	vertexShaderBuffer = nullptr;
-	pixelShaderBuffer = nullptr;
+	// The bytecode has been copied into the pipeline states, so the buffers are no longer needed either way.
+	ReleaseShaderBuffer(vertexShaderBuffer);
+	ReleaseShaderBuffer(quantisedVertexShaderBuffer);
+	ReleaseShaderBuffer(pixelShaderBuffer);
+	ReleaseShaderBuffer(transparentPixelShaderBuffer);
 
-	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "LightVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
-	if (FAILED(result))
+	if (!result)
 	{
-		if (errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
-		}
-		else
-		{
-			std::string errMsg = "Missing shader file. ";
-			logger->GetInstance().WriteLine("Could not find a shader file with name '" + vsFilename + "'");
-			MessageBox(hwnd, vsFilename.c_str(), errMsg.c_str(), MB_OK);
-		}
-		logger->GetInstance().WriteLine("Failed to compile the vertex shader named '" + vsFilename + "'");
 		return false;
 	}
 
-	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "LightPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
-	if (FAILED(result))
+	// The matrices and the light come from the shared constants, only the material constants belong to this shader.
+	bufferDesc.type = CRenderDevice::ConstantBuffer;
+	bufferDesc.usage = CRenderDevice::ImmutableUsage;
+	bufferDesc.size = sizeof(MapBufferType);
+
+	for (unsigned int buffer = 0; buffer < kNumberOfMapBuffers; buffer++)
 	{
-		if (errorMessage)
-		{
-			OutputShaderErrorMessage(errorMessage, hwnd, psFilename);
-		}
-		else
+		MapBufferType mapBuffer;
+		mapBuffer.useAlphaMap = (buffer & 1) != 0;
+		mapBuffer.useSpecularMap = (buffer & 2) != 0;
+		mapBuffer.padding2 = D3DXVECTOR3{ 0.0f, 0.0f, 0.0f };
+		mapBuffer.padding3 = D3DXVECTOR4{ 0.0f, 0.0f, 0.0f, 0.0f };
+
+		mpMapBuffers[buffer] = mpRenderDevice->CreateBuffer(bufferDesc, &mapBuffer);
+		if (mpMapBuffers[buffer] == nullptr)
 		{
-			std::string errMsg = "Missing shader file.";
-			logger->GetInstance().WriteLine("Could not find a shader file with name '" + psFilename + "'");
-			MessageBox(hwnd, psFilename.c_str(), errMsg.c_str(), MB_OK);
+			logger->GetInstance().WriteLine("Failed to create the buffer from the map buffer descriptor from within the texture diffuse light shader class.");
+			return false;
 		}
-		logger->GetInstance().WriteLine("Failed to compile the pixel shader named '" + psFilename + "'");
-		return false;
 	}
 
-	// Create the vertex shader from the buffer.
-	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &mpVertexShader);
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create the vertex shader from the buffer.");
-		return false;
-	}
+	return true;
+}
 
-	// Create the pixel shader from the buffer.
-	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &mpPixelShader);
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create the pixel shader from the buffer.");
-		return false;
-	}
+/* @Returns bool Whether the shader compiled, failures are logged and shown to the user. */
+bool CDiffuseLightShader::CompileShader(HWND hwnd, std::string filename, LPCSTR entryPoint, LPCSTR profile, ID3D10Blob** shaderBuffer)
+{
+	ID3D10Blob* errorMessage = nullptr;
 
-	/////////////////////////////////////////
-	// Transparent
-	/////////////////////////////////////////
-	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(transparentPSFilename.c_str(), NULL, NULL, "TransparentPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	HRESULT result = CompileShaderFromFile(filename, entryPoint, profile, D3D10_SHADER_ENABLE_STRICTNESS, shaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
 		{
-			OutputShaderErrorMessage(errorMessage, hwnd, transparentPSFilename);
+			OutputShaderErrorMessage(errorMessage, hwnd, filename);
 		}
 		else
 		{
-			std::string errMsg = "Missing shader file.";
-			logger->GetInstance().WriteLine("Could not find a shader file with name '" + transparentPSFilename + "'");
-			MessageBox(hwnd, transparentPSFilename.c_str(), errMsg.c_str(), MB_OK);
+			std::string errMsg = "Missing shader file. ";
+			logger->GetInstance().WriteLine("Could not find a shader file with name '" + filename + "'");
+			MessageBox(hwnd, filename.c_str(), errMsg.c_str(), MB_OK);
 		}
-		logger->GetInstance().WriteLine("Failed to compile the pixel shader named '" + transparentPSFilename + "'");
-		return false;
-	}
-
-	// Create the pixel shader from the buffer.
-	result = device->CreatePixelShader(pixelShaderBuffer->GetBufferPointer(), pixelShaderBuffer->GetBufferSize(), NULL, &mpTransparentPixelShader);
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create the pixel shader from the buffer.");
-		return false;
-	}
-
-	/*
-	* The polygonLayout.Format describes what size item should be placed in here, check if it's a float3 or float2 basically, and pass in DXGI_FORMAT_R32/G32/B32_FLOAT accordingly.
-	*/
-
-	// Setup the layout of the data that goes into the shader.
-	polygonLayout[0].SemanticName = "POSITION";
-	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	polygonLayout[0].InputSlot = 0;
-	polygonLayout[0].AlignedByteOffset = 0;
-	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[0].InstanceDataStepRate = 0;
-
-	// Position only has 2 co-ords. Only need format of R32G32.
-	polygonLayout[1].SemanticName = "TEXCOORD";
-	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
-	polygonLayout[1].InputSlot = 0;
-	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[1].InstanceDataStepRate = 0;
-
-	polygonLayout[2].SemanticName = "NORMAL";
-	polygonLayout[2].SemanticIndex = 0;
-	polygonLayout[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-	polygonLayout[2].InputSlot = 0;
-	polygonLayout[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-	polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-	polygonLayout[2].InstanceDataStepRate = 0;
-
-	// Get a count of the elements in the layout.
-	numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
-
-	// Create the vertex input layout.
-	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &mpLayout);
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create polygon layout.");
-		return false;
-	}
-
-	// Release the vertex shader buffer and pixel shader buffer since they are no longer needed.
-	vertexShaderBuffer->Release();
-	vertexShaderBuffer = nullptr;
-
-	pixelShaderBuffer->Release();
-	pixelShaderBuffer = nullptr;
-
-	// Set up the sampler state descriptor.
-    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-    samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-    samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-    samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-    samplerDesc.MipLODBias = 0.0f;
-    samplerDesc.MaxAnisotropy = 1;
-    samplerDesc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
-    samplerDesc.BorderColor[0] = 0;
-	samplerDesc.BorderColor[1] = 0;
-	samplerDesc.BorderColor[2] = 0;
-	samplerDesc.BorderColor[3] = 0;
-    samplerDesc.MinLOD = 0;
-    samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
-
-	// Create the texture sampler state.
-	result = device->CreateSamplerState(&samplerDesc, &mpSampleState);
-
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create the sampler state in TextureShader.cpp");
-		return false;
-	}
-
-
-	if (!SetupMatrixBuffer(device))
-	{
-		logger->GetInstance().WriteLine("Failed to create the matrix buffer from desc in diffuse light shader.");
-		return false;
-	}
-
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-
-	result = device->CreateBuffer(&lightBufferDesc, NULL, &mpLightBuffer);
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create the buffer from the light buffer descriptor from within the texture diffuse light shader class.");
-		return false;
-	}
-
-	mapBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	mapBufferDesc.ByteWidth = sizeof(MapBufferType);
-	mapBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	mapBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	mapBufferDesc.MiscFlags = 0;
-	mapBufferDesc.StructureByteStride = 0;
-
-	result = device->CreateBuffer(&mapBufferDesc, NULL, &mpMapBuffer);
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create the buffer from the map buffer descriptor from within the texture diffuse light shader class.");
+		logger->GetInstance().WriteLine("Failed to compile the shader named '" + filename + "' with entry point '" + entryPoint + "'");
 		return false;
 	}
 
@@ -263,40 +169,28 @@ bool CDiffuseLightShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std
 
 void CDiffuseLightShader::ShutdownShader()
 {
-	if (mpMapBuffer)
+	for (unsigned int buffer = 0; buffer < kNumberOfMapBuffers; buffer++)
 	{
-		mpMapBuffer->Release();
-		mpMapBuffer = nullptr;
+		mpRenderDevice->DestroyBuffer(mpMapBuffers[buffer]);
+		mpMapBuffers[buffer] = nullptr;
 	}
 
-	if (mpLightBuffer)
+	if (mpTransparentPipelineState)
 	{
-		mpLightBuffer->Release();
-		mpLightBuffer = nullptr;
+		mpRenderDevice->DestroyPipelineState(mpTransparentPipelineState);
+		mpTransparentPipelineState = nullptr;
 	}
 
-	if (mpSampleState)
+	if (mpQuantisedPipelineState)
 	{
-		mpSampleState->Release();
-		mpSampleState = nullptr;
+		mpRenderDevice->DestroyPipelineState(mpQuantisedPipelineState);
+		mpQuantisedPipelineState = nullptr;
 	}
 
-	if (mpLayout)
+	if (mpPipelineState)
 	{
-		mpLayout->Release();
-		mpLayout = nullptr;
-	}
-
-	if (mpPixelShader)
-	{
-		mpPixelShader->Release();
-		mpPixelShader = nullptr;
-	}
-
-	if (mpVertexShader)
-	{
-		mpVertexShader->Release();
-		mpVertexShader = nullptr;
+		mpRenderDevice->DestroyPipelineState(mpPipelineState);
+		mpPipelineState = nullptr;
 	}
 }
 
@@ -332,97 +226,17 @@ void CDiffuseLightShader::OutputShaderErrorMessage(ID3D10Blob *errorMessage, HWN
 	MessageBox(hwnd, "Error compiling the shader. Check the logs for a more detailed error message.", shaderFilename.c_str(), MB_OK);
 }
 
-bool CDiffuseLightShader::SetShaderParameters(ID3D11DeviceContext * deviceContext, ID3D11ShaderResourceView** textures, int numberOfTextures, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour)
+CRenderDevice::PipelineState* CDiffuseLightShader::GetPipelineState(VertexFormat format)
 {
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	unsigned int bufferNumber;
-	LightBufferType* dataPtr2;
-
-
-	if (!SetMatrixBuffer(deviceContext, 0, ShaderType::Vertex))
-	{
-		logger->GetInstance().WriteLine("Failed to set matrix buffer in diffuse light shader class.");
-		return false;
-	}
-
-	deviceContext->PSSetShaderResources(0, numberOfTextures, textures);
-
-	// Lock the light constant buffer so it can be written to.
-	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
-	{
-		return false;
-	}
-
-	// Get a pointer to the data in the constant buffer.
-	dataPtr2 = (LightBufferType*)mappedResource.pData;
-
-	// Copy the lighting variables into the constant buffer.
-	dataPtr2->diffuseColour = diffuseColour;
-	dataPtr2->ambientColour = ambientColour;
-	dataPtr2->lightDirection = lightDirection;
-	dataPtr2->padding = 0.0f;
-
-	// Unlock the constant buffer.
-	deviceContext->Unmap(mpLightBuffer, 0);
-
-	// Set the position of the light constant buffer in the pixel shader.
-	bufferNumber = 0;
-
-	// Finally set the light constant buffer in the pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
-
-	return true;
+	return format == QuantisedVertexFormat ? mpQuantisedPipelineState : mpPipelineState;
 }
 
-bool CDiffuseLightShader::UpdateMapBuffer(ID3D11DeviceContext* deviceContext, bool useAlphaMap, bool useSpecularMap)
+unsigned int CDiffuseLightShader::GetPipelineStateId(VertexFormat format)
 {
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	unsigned int bufferNumber = 1;
-	MapBufferType* mapBufferPtr;
-
-	// Lock the constant buffer so it can be written to.
-	result = deviceContext->Map(mpMapBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to lock the map buffer when attempting to update it.");
-		return false;
-	}
-
-	// Get a pointer to the data in the constant buffer.
-	mapBufferPtr = (MapBufferType*)mappedResource.pData;
-
-	// Copy the bools into the constant buffer.
-	mapBufferPtr->useAlphaMap = useAlphaMap;
-	mapBufferPtr->useSpecularMap = useSpecularMap;
-	mapBufferPtr->padding2 = D3DXVECTOR3{ 0.0F, 0.0F, 0.0f };
-
-	// Unlock the constant buffer.
-	deviceContext->Unmap(mpMapBuffer, 0);
-
-	// Now set the constant buffer in the vertex shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpMapBuffer);
-
-	return true;
+	return format == QuantisedVertexFormat ? mQuantisedPipelineStateId : mPipelineStateId;
 }
 
-void CDiffuseLightShader::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
+CRenderDevice::Buffer* CDiffuseLightShader::GetMapBuffer(bool useAlphaMap, bool useSpecularMap)
 {
-	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
-
-	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
-
-	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpSampleState);
-
-	// Render the triangle.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
-
-	return;
+	return mpMapBuffers[(useAlphaMap ? 1 : 0) | (useSpecularMap ? 2 : 0)];
 }
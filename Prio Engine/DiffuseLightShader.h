@@ -2,19 +2,13 @@
 #define DIFFUSELIGHTSHADER_H
 
 #include "Shader.h"
+#include "VertexFormat.h"
+#include "DrawList.h"
 
 class CDiffuseLightShader : public CShader
 {
 private:
 
-	struct LightBufferType
-	{
-		D3DXVECTOR4 ambientColour;
-		D3DXVECTOR4 diffuseColour;
-		D3DXVECTOR3 lightDirection;
-		float padding;
-	};
-
 	struct MapBufferType
 	{
 		bool useAlphaMap;
@@ -24,30 +18,34 @@ private:
 	};
 
 public:
-	CDiffuseLightShader();
+	CDiffuseLightShader(CRenderDevice* renderDevice);
 	~CDiffuseLightShader();
 
 	bool Initialise(ID3D11Device* device, HWND hwnd);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext* deviceContext, int indexCount, ID3D11ShaderResourceView** textures, int numberOfTextures, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour);
-	bool UpdateMapBuffer(ID3D11DeviceContext* deviceContext, bool useAlphaMap, bool useSpecularMap);
+
+	// The pipeline state matching the layout of a vertex buffer, and its id to sort draws by.
+	CRenderDevice::PipelineState* GetPipelineState(VertexFormat format);
+	unsigned int GetPipelineStateId(VertexFormat format);
+	// Material constants are never written once created, there's one buffer for each combination of maps.
+	CRenderDevice::Buffer* GetMapBuffer(bool useAlphaMap, bool useSpecularMap);
 
 private:
-	bool InitialiseShader(ID3D11Device * device, HWND hwnd, std::string vsFilename, std::string psFilename, std::string transparentPSFilename);
+	bool InitialiseShader(HWND hwnd, std::string vsFilename, std::string psFilename, std::string transparentPSFilename);
+	bool CompileShader(HWND hwnd, std::string filename, LPCSTR entryPoint, LPCSTR profile, ID3D10Blob** shaderBuffer);
 	void ShutdownShader();
 	void OutputShaderErrorMessage(ID3D10Blob *errorMessage, HWND hwnd, std::string shaderFilename);
 
-	bool SetShaderParameters(ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView** textures, int numberOfTextures, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour);
-	void RenderShader(ID3D11DeviceContext* deviceContext, int indexCount);
-
 private:
-	ID3D11VertexShader* mpVertexShader;
-	ID3D11PixelShader* mpPixelShader;
-	ID3D11PixelShader* mpTransparentPixelShader;
-	ID3D11InputLayout* mpLayout;
-	ID3D11SamplerState* mpSampleState;
-	ID3D11Buffer* mpLightBuffer;
-	ID3D11Buffer* mpMapBuffer;
+	static const unsigned int kNumberOfMapBuffers = 4;
+
+	CRenderDevice* mpRenderDevice;
+	CRenderDevice::PipelineState* mpPipelineState;
+	CRenderDevice::PipelineState* mpQuantisedPipelineState;
+	CRenderDevice::PipelineState* mpTransparentPipelineState;
+	unsigned int mPipelineStateId;
+	unsigned int mQuantisedPipelineStateId;
+	CRenderDevice::Buffer* mpMapBuffers[kNumberOfMapBuffers];
 };
 
 #endif
\ No newline at end of file
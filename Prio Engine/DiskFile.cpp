@@ -0,0 +1,135 @@
+#include "DiskFile.h"
+#include <cstdio>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace PrioEngine
+{
+	namespace DiskFile
+	{
+		const char* const kTemporaryExtension = ".tmp";
+
+		namespace
+		{
+			void RemoveFile(const std::string& filename)
+			{
+#ifdef _WIN32
+				DeleteFileA(filename.c_str());
+#else
+				std::remove(filename.c_str());
+#endif
+			}
+
+			// Replaces the file if it's already there.
+			bool RenameFile(const std::string& from, const std::string& to)
+			{
+#ifdef _WIN32
+				return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+#else
+				return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+			}
+		}
+
+		bool FindFiles(const std::string& directory, std::vector<std::string>& files)
+		{
+#ifdef _WIN32
+			WIN32_FIND_DATAA findData;
+			HANDLE findHandle = FindFirstFileA((directory + "/*").c_str(), &findData);
+			if (findHandle == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+
+			do
+			{
+				const std::string name = findData.cFileName;
+				if (name == "." || name == "..")
+				{
+					continue;
+				}
+
+				const std::string path = directory + "/" + name;
+				if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				{
+					FindFiles(path, files);
+				}
+				else
+				{
+					files.push_back(path);
+				}
+			} while (FindNextFileA(findHandle, &findData));
+
+			FindClose(findHandle);
+#else
+			DIR* directoryHandle = opendir(directory.c_str());
+			if (directoryHandle == nullptr)
+			{
+				return false;
+			}
+
+			while (dirent* entry = readdir(directoryHandle))
+			{
+				const std::string name = entry->d_name;
+				if (name == "." || name == "..")
+				{
+					continue;
+				}
+
+				const std::string path = directory + "/" + name;
+				struct stat fileStatus;
+				if (stat(path.c_str(), &fileStatus) != 0)
+				{
+					continue;
+				}
+
+				if (S_ISDIR(fileStatus.st_mode))
+				{
+					FindFiles(path, files);
+				}
+				else
+				{
+					files.push_back(path);
+				}
+			}
+
+			closedir(directoryHandle);
+#endif
+			return true;
+		}
+
+		bool Write(const std::string& filename, const std::function<void(std::ofstream& file)>& write)
+		{
+			const std::string temporaryFile = filename + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + kTemporaryExtension;
+
+			{
+				std::ofstream file(temporaryFile.c_str(), std::ios::binary | std::ios::trunc);
+				if (!file.is_open())
+				{
+					return false;
+				}
+
+				write(file);
+				if (!file.good())
+				{
+					file.close();
+					RemoveFile(temporaryFile);
+					return false;
+				}
+			}
+
+			if (!RenameFile(temporaryFile, filename))
+			{
+				RemoveFile(temporaryFile);
+				return false;
+			}
+
+			return true;
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef DISKFILE_H
+#define DISKFILE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+
+namespace PrioEngine
+{
+	/* Plain files on disk, for the tools which cook and pack resources rather than anything loaded at run time, which goes
+	* through the file system. */
+	namespace DiskFile
+	{
+		/* Add the path of every file in a directory, and its sub directories, to the list. Paths are the directory given
+		* followed by the name of each file, separated by forward slashes.
+		* @Returns bool Whether the directory could be opened.
+		*/
+		bool FindFiles(const std::string& directory, std::vector<std::string>& files);
+
+		/* Write a file through a temporary one which is renamed over it once it's complete, so nothing ever opens one which
+		* is half written, whether another thread or the next run. The temporary file is named after the thread, so two
+		* threads writing the same file don't write over each other, and whichever renames last wins.
+		* @Returns bool Whether the file was written, the temporary file is removed if not.
+		*/
+		bool Write(const std::string& filename, const std::function<void(std::ofstream& file)>& write);
+
+		// The extension of the temporary files written by Write, so anything searching a directory can skip them.
+		extern const char* const kTemporaryExtension;
+	}
+}
+
+#endif
@@ -0,0 +1,294 @@
+#include "DrawList.h"
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+
+namespace
+{
+	const unsigned int kRadixBits = 8;
+	const unsigned int kRadixBuckets = 1 << kRadixBits;
+	const unsigned int kRadixPasses = 64 / kRadixBits;
+
+	std::atomic<unsigned int> gNextStateId(1);
+
+	/* Positive floats compare the same way as their bit patterns do, which is all the sort needs.
+	* @Returns unsigned int The bits of the depth, negative depths are treated as zero. */
+	unsigned int GetDepthBits(float depth)
+	{
+		unsigned int bits = 0;
+		if (depth > 0.0f)
+		{
+			std::memcpy(&bits, &depth, sizeof(bits));
+		}
+		return bits;
+	}
+}
+
+CDrawList::CDrawList()
+{
+	mSorted = false;
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+}
+
+
+CDrawList::~CDrawList()
+{
+}
+
+void CDrawList::Clear()
+{
+	mPackets.clear();
+	mObjectData.clear();
+	mSortEntries.clear();
+	mSorted = false;
+}
+
+void CDrawList::Add(const DrawPacket& packet, const void* objectData, unsigned int objectDataSize)
+{
+	PacketData data;
+	data.packet = packet;
+	data.objectDataOffset = mObjectData.size();
+	data.objectDataSize = objectDataSize;
+
+	mObjectData.insert(mObjectData.end(), static_cast<const unsigned char*>(objectData), static_cast<const unsigned char*>(objectData) + objectDataSize);
+	mPackets.push_back(data);
+	mSorted = false;
+}
+
+/* Least significant digit radix sort, a byte at a time. The counts for every byte are gathered in a single pass over
+* the keys, and any byte which is the same across every key (usually the pass, and often the pipeline) is skipped. */
+void CDrawList::Sort()
+{
+	const unsigned int numberOfPackets = static_cast<unsigned int>(mPackets.size());
+	unsigned int counts[kRadixPasses][kRadixBuckets];
+	std::memset(counts, 0, sizeof(counts));
+
+	mSortEntries.resize(numberOfPackets);
+	mSortScratch.resize(numberOfPackets);
+
+	for (unsigned int packet = 0; packet < numberOfPackets; packet++)
+	{
+		const unsigned long long key = mPackets[packet].packet.sortKey;
+		mSortEntries[packet].key = key;
+		mSortEntries[packet].packet = packet;
+
+		for (unsigned int radixPass = 0; radixPass < kRadixPasses; radixPass++)
+		{
+			counts[radixPass][(key >> (radixPass * kRadixBits)) & (kRadixBuckets - 1)]++;
+		}
+	}
+
+	for (unsigned int radixPass = 0; radixPass < kRadixPasses; radixPass++)
+	{
+		const unsigned int shift = radixPass * kRadixBits;
+		unsigned int* passCounts = counts[radixPass];
+
+		// Every key has the same value for this byte, so this pass wouldn't move anything.
+		if (numberOfPackets == 0 || passCounts[(mSortEntries[0].key >> shift) & (kRadixBuckets - 1)] == numberOfPackets)
+		{
+			continue;
+		}
+
+		unsigned int offset = 0;
+		for (unsigned int bucket = 0; bucket < kRadixBuckets; bucket++)
+		{
+			const unsigned int count = passCounts[bucket];
+			passCounts[bucket] = offset;
+			offset += count;
+		}
+
+		for (auto& entry : mSortEntries)
+		{
+			mSortScratch[passCounts[(entry.key >> shift) & (kRadixBuckets - 1)]++] = entry;
+		}
+
+		mSortEntries.swap(mSortScratch);
+	}
+
+	mSorted = true;
+}
+
+/* Issue every packet in sorted order, or in the order they were added if Sort wasn't called. Nothing is assumed to be
+* bound beforehand, since classes which haven't moved over to the render device bind their own state in between. */
+void CDrawList::Submit(CRenderDevice* renderDevice)
+{
+	if (!mSorted)
+	{
+		mSortEntries.resize(mPackets.size());
+		for (unsigned int packet = 0; packet < mPackets.size(); packet++)
+		{
+			mSortEntries[packet].key = mPackets[packet].packet.sortKey;
+			mSortEntries[packet].packet = packet;
+		}
+	}
+
+	SubmitRange(renderDevice, 0, static_cast<unsigned int>(mSortEntries.size()), mStatistics);
+}
+
+/* Submit a run of packets from the sorted list. Runs don't depend on each other, so different runs can be recorded on
+* different deferred devices at once. Must only be called once Sort has been. */
+void CDrawList::Submit(CRenderDevice* renderDevice, unsigned int firstPacket, unsigned int numberOfPackets, Statistics& statistics) const
+{
+	if (!mSorted || firstPacket + numberOfPackets > mSortEntries.size())
+	{
+		logger->GetInstance().WriteLine("Tried to submit part of a draw list which hasn't been sorted, or past its end.");
+		return;
+	}
+
+	SubmitRange(renderDevice, firstPacket, firstPacket + numberOfPackets, statistics);
+}
+
+/* Lists too short to give every run enough packets, or which haven't been sorted, are submitted straight to the render
+* device, as recording a run costs a deferred device and a command list whatever is in it. Each run binds everything
+* it draws with afresh, so the binds counted are the ones that were really made.
+* @Returns bool False if any run failed to record, in which case none of them were drawn. */
+bool CDrawList::Submit(CRenderDevice* renderDevice, CPassRecorder* passRecorder, unsigned int maxRuns)
+{
+	const unsigned int numberOfPackets = static_cast<unsigned int>(mPackets.size());
+	const unsigned int numberOfRuns = std::min(numberOfPackets / kMinPacketsPerRecordedRun, maxRuns);
+
+	if (!mSorted || numberOfRuns < 2)
+	{
+		Submit(renderDevice);
+		return true;
+	}
+
+	mRunStatistics.resize(numberOfRuns);
+
+	for (unsigned int run = 0; run < numberOfRuns; run++)
+	{
+		// Spread evenly, so no run is more than a packet longer than another.
+		const unsigned int firstPacket = static_cast<unsigned int>(static_cast<unsigned long long>(numberOfPackets) * run / numberOfRuns);
+		const unsigned int endPacket = static_cast<unsigned int>(static_cast<unsigned long long>(numberOfPackets) * (run + 1) / numberOfRuns);
+		const unsigned int runPackets = endPacket - firstPacket;
+		Statistics* statistics = &mRunStatistics[run];
+
+		passRecorder->AddPass([this, firstPacket, runPackets, statistics](CRenderDevice* deferredDevice)
+		{
+			Submit(deferredDevice, firstPacket, runPackets, *statistics);
+			return true;
+		});
+	}
+
+	const bool result = passRecorder->Execute();
+
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+	for (auto& statistics : mRunStatistics)
+	{
+		mStatistics.packets += statistics.packets;
+		mStatistics.pipelineChanges += statistics.pipelineChanges;
+		mStatistics.materialChanges += statistics.materialChanges;
+		mStatistics.bufferChanges += statistics.bufferChanges;
+		mStatistics.skippedBinds += statistics.skippedBinds;
+	}
+
+	return result;
+}
+
+void CDrawList::SubmitRange(CRenderDevice* renderDevice, unsigned int begin, unsigned int end, Statistics& statistics) const
+{
+	std::memset(&statistics, 0, sizeof(statistics));
+	statistics.packets = end - begin;
+
+	CRenderDevice::PipelineState* boundPipelineState = nullptr;
+	const Material* boundMaterial = nullptr;
+	CRenderDevice::Buffer* boundVertexBuffer = nullptr;
+	unsigned int boundVertexStride = 0;
+	CRenderDevice::Buffer* boundIndexBuffer = nullptr;
+	CRenderDevice::Buffer* boundObjectBuffer = nullptr;
+
+	for (unsigned int sortEntry = begin; sortEntry < end; sortEntry++)
+	{
+		const PacketData& data = mPackets[mSortEntries[sortEntry].packet];
+		const DrawPacket& packet = data.packet;
+
+		if (packet.pipelineState != boundPipelineState)
+		{
+			renderDevice->SetPipelineState(packet.pipelineState);
+			boundPipelineState = packet.pipelineState;
+			statistics.pipelineChanges++;
+		}
+		else
+		{
+			statistics.skippedBinds++;
+		}
+
+		if (packet.material != boundMaterial)
+		{
+			renderDevice->SetTextures(CRenderDevice::PixelStage, 0, packet.material->numberOfTextures, packet.material->textures);
+			renderDevice->SetConstantBuffer(CRenderDevice::PixelStage, kMaterialConstantsSlot, packet.material->constantBuffer);
+			boundMaterial = packet.material;
+			statistics.materialChanges++;
+		}
+		else
+		{
+			statistics.skippedBinds++;
+		}
+
+		if (packet.vertexBuffer != boundVertexBuffer || packet.vertexStride != boundVertexStride)
+		{
+			renderDevice->SetVertexBuffer(packet.vertexBuffer, packet.vertexStride, 0);
+			boundVertexBuffer = packet.vertexBuffer;
+			boundVertexStride = packet.vertexStride;
+			statistics.bufferChanges++;
+		}
+		else
+		{
+			statistics.skippedBinds++;
+		}
+
+		// Levels of detail share an index buffer, they're drawn from a different first index rather than rebinding it.
+		if (packet.indexBuffer != boundIndexBuffer)
+		{
+			renderDevice->SetIndexBuffer(packet.indexBuffer, packet.indexFormat, 0);
+			boundIndexBuffer = packet.indexBuffer;
+			statistics.bufferChanges++;
+		}
+		else
+		{
+			statistics.skippedBinds++;
+		}
+
+		// The object data changes every draw, but the buffer holding it only needs binding once.
+		void* objectData = renderDevice->Map(packet.objectBuffer);
+		if (objectData == nullptr)
+		{
+			logger->GetInstance().WriteLine("Failed to map the object constants of a draw packet, skipping it.");
+			continue;
+		}
+		std::memcpy(objectData, &mObjectData[data.objectDataOffset], data.objectDataSize);
+		renderDevice->Unmap(packet.objectBuffer);
+
+		if (packet.objectBuffer != boundObjectBuffer)
+		{
+			renderDevice->SetConstantBuffer(CRenderDevice::VertexStage, kObjectConstantsSlot, packet.objectBuffer);
+			boundObjectBuffer = packet.objectBuffer;
+		}
+		else
+		{
+			statistics.skippedBinds++;
+		}
+
+		renderDevice->DrawIndexed(packet.indexCount, packet.firstIndex, 0);
+	}
+}
+
+/* Opaque keys are laid out pass | pipeline | material | depth, transparent keys pass | inverted depth | material.
+* @Returns unsigned long long The key to store in a draw packet. */
+unsigned long long CDrawList::MakeSortKey(Pass pass, unsigned int pipelineId, unsigned int materialId, float depth)
+{
+	const unsigned long long passBits = static_cast<unsigned long long>(pass & 0xF) << 60;
+	const unsigned long long depthBits = GetDepthBits(depth);
+
+	if (pass == TransparentPass)
+	{
+		return passBits | ((~depthBits & 0xFFFFFFFFull) << 16) | (materialId & 0xFFFF);
+	}
+
+	return passBits | (static_cast<unsigned long long>(pipelineId & 0xFFF) << 48) | (static_cast<unsigned long long>(materialId & 0xFFFF) << 32) | depthBits;
+}
+
+unsigned int CDrawList::AllocateStateId()
+{
+	return gNextStateId++;
+}
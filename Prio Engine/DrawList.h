@@ -0,0 +1,115 @@
+#ifndef DRAWLIST_H
+#define DRAWLIST_H
+
+#include <vector>
+#include "RenderDevice.h"
+#include "SharedConstants.h"
+#include "PassRecorder.h"
+
+/* Draws gathered from a pass rather than issued as they're found. Each carries a 64 bit key, the list is radix sorted on
+* those keys and then submitted in one go, skipping any bind which wouldn't change what's already bound.
+* Shaders drawn from a list read their per draw constants from the shared draw constants in the vertex stage and their
+* material constants from the pixel stage at the slots below, and take their textures from pixel stage slot 0 onwards. */
+class CDrawList
+{
+private:
+	CLogger* logger;
+public:
+	static const unsigned int kObjectConstantsSlot = CSharedConstants::kDrawConstantsSlot;
+	static const unsigned int kMaterialConstantsSlot = 1;
+	static const unsigned int kMaxMaterialTextures = 8;
+	// Lists are only split into runs recorded on the workers when each run would get at least this many packets. A run
+	// costs a few microseconds to set up and record whatever is in it (see PassRecorderBenchmark), which is only a draw
+	// or two of driver time, so a run this long pays for itself.
+	static const unsigned int kMinPacketsPerRecordedRun = 64;
+
+	// The top bits of every key, so all of one pass is drawn before the next.
+	enum Pass
+	{
+		// Sorted by state first, then front to back so the depth test rejects as much as possible.
+		OpaquePass = 0,
+		// Sorted back to front before anything else so blending comes out right.
+		TransparentPass = 1
+	};
+
+	// Textures and constants which are bound together. Packets compare materials by address.
+	struct Material
+	{
+		unsigned int id;
+		CRenderDevice::Texture* textures[kMaxMaterialTextures];
+		unsigned int numberOfTextures;
+		CRenderDevice::Buffer* constantBuffer;
+	};
+
+	struct DrawPacket
+	{
+		unsigned long long sortKey;
+		CRenderDevice::PipelineState* pipelineState;
+		const Material* material;
+		CRenderDevice::Buffer* vertexBuffer;
+		unsigned int vertexStride;
+		CRenderDevice::Buffer* indexBuffer;
+		CRenderDevice::IndexFormat indexFormat;
+		unsigned int firstIndex;
+		unsigned int indexCount;
+		// Dynamic constant buffer the object data given to Add is written into before drawing, usually the shared draw buffer.
+		CRenderDevice::Buffer* objectBuffer;
+	};
+
+	// Counted by the last Submit.
+	struct Statistics
+	{
+		unsigned int packets;
+		unsigned int pipelineChanges;
+		unsigned int materialChanges;
+		unsigned int bufferChanges;
+		unsigned int skippedBinds;
+	};
+public:
+	CDrawList();
+	~CDrawList();
+public:
+	void Clear();
+	// The object data is copied, it must fill the whole of the packet's object buffer.
+	void Add(const DrawPacket& packet, const void* objectData, unsigned int objectDataSize);
+	void Sort();
+	void Submit(CRenderDevice* renderDevice);
+	void Submit(CRenderDevice* renderDevice, unsigned int firstPacket, unsigned int numberOfPackets, Statistics& statistics) const;
+	// Split the sorted list into at most maxRuns runs and record them at the same time. The statistics cover every run.
+	bool Submit(CRenderDevice* renderDevice, CPassRecorder* passRecorder, unsigned int maxRuns);
+
+	// Pipeline and material ids are truncated to 12 and 16 bits, depth is the distance from the camera.
+	static unsigned long long MakeSortKey(Pass pass, unsigned int pipelineId, unsigned int materialId, float depth);
+	// Hands out small ids for pipeline states and materials to sort by, unique for the life of the program.
+	static unsigned int AllocateStateId();
+
+	unsigned int GetNumberOfPackets() { return static_cast<unsigned int>(mPackets.size()); };
+	const Statistics& GetStatistics() { return mStatistics; };
+private:
+	struct SortEntry
+	{
+		unsigned long long key;
+		unsigned int packet;
+	};
+
+	struct PacketData
+	{
+		DrawPacket packet;
+		size_t objectDataOffset;
+		unsigned int objectDataSize;
+	};
+private:
+	void SubmitRange(CRenderDevice* renderDevice, unsigned int begin, unsigned int end, Statistics& statistics) const;
+private:
+	std::vector<PacketData> mPackets;
+	std::vector<unsigned char> mObjectData;
+	// Submission order once sorted, the scratch space is kept between frames so sorting doesn't allocate.
+	std::vector<SortEntry> mSortEntries;
+	std::vector<SortEntry> mSortScratch;
+	// What each run counted as it was recorded, totalled once they're all done.
+	std::vector<Statistics> mRunStatistics;
+	bool mSorted;
+	Statistics mStatistics;
+};
+
+#endif
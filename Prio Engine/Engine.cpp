@@ -1,4 +1,6 @@
 #include "Engine.h"
+#include "FileSystem.h"
+#include <chrono>
 
 /* Default constructor. */
 CEngine::CEngine()
@@ -27,6 +29,12 @@ bool CEngine::Initialise(std::string windowName)
 	// Boolean to store the result of attempting to initialise DirectX in our application.
 	bool result;
 
+	// Logged at the end, so startup with a cold and a warm disk cache, or with and without the pack, can be compared.
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	// Every resource after this point is read out of the pack if there is one, otherwise straight from disk.
+	CFileSystem::GetInstance().Mount(kResourcePackFile);
+
 	// Our graphics object will need to be created so we can check for fullscreen, if not it will cause errors.
 	mpGraphics = new CGraphics();
 
@@ -81,6 +89,9 @@ bool CEngine::Initialise(std::string windowName)
 	// Reset the timer so we are starting from 0.
 	mTimer->Reset();
 
+	const std::chrono::duration<float, std::milli> startupTime = std::chrono::high_resolution_clock::now() - startTime;
+	logger->GetInstance().WriteLine("Engine initialised in " + std::to_string(startupTime.count()) + "ms.");
+
 	// Success! Initialised all essentials for our system.
 	return true;
 }
@@ -121,6 +132,9 @@ void CEngine::Shutdown()
 		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpGraphics).name());
 	}
 
+	// Nothing can still be loading now the graphics, and with them the asset loader, are gone.
+	CFileSystem::GetInstance().UnmountAll();
+
 	return;
 }
 
@@ -515,6 +529,21 @@ void CEngine::SetLevelOfDetail(float value)
 	mpGraphics->SetLevelOfDetail(value);
 }
 
+void CEngine::SetWaterResolutionScale(float refractionScale, float reflectionScale)
+{
+	mpGraphics->SetWaterResolutionScale(refractionScale, reflectionScale);
+}
+
+void CEngine::SetWaterUpdateInterval(unsigned int frames)
+{
+	mpGraphics->SetWaterUpdateInterval(frames);
+}
+
+unsigned int CEngine::GetWaterUpdateInterval()
+{
+	return mpGraphics->GetWaterUpdateInterval();
+}
+
 /* Prevent the engine from running for any longer. */
 void CEngine::Stop()
 {
@@ -587,8 +616,11 @@ bool CEngine::AddSceneryToTerrain(CTerrain* terrainPtr)
 
 	if (terrainPtr != nullptr)
 	{
-		CMesh* treeMesh = LoadMesh("Resources/Models/firtree3.3ds", 2.0f);
-		
+		CMesh* treeMesh = LoadMeshAsync("Resources/Models/firtree3.3ds", 2.0f);
+		if (treeMesh == nullptr)
+		{
+			return false;
+		}
 
 		for (auto treeInfo : terrainPtr->GetTreeInformation())
 		{
@@ -607,7 +639,11 @@ bool CEngine::AddSceneryToTerrain(CTerrain* terrainPtr)
 		}
 
 
-		CMesh* plantMeshes = LoadMesh("Resources/Models/Bushes/LS13_01.3ds");
+		CMesh* plantMeshes = LoadMeshAsync("Resources/Models/Bushes/LS13_01.3ds");
+		if (plantMeshes == nullptr)
+		{
+			return false;
+		}
 
 		for (auto plantInfo : terrainPtr->GetPlantInformation())
 		{
@@ -625,6 +661,10 @@ bool CEngine::AddSceneryToTerrain(CTerrain* terrainPtr)
 			plant->SetScale(plantInfo.scale);
 		}
 
+		// Scenery never moves once placed, so distant chunks of it can be drawn as merged batches.
+		treeMesh->EnableStaticBatching(kSceneryChunkSize);
+		plantMeshes->EnableStaticBatching(kSceneryChunkSize);
+
 		mpListOfTreeMeshes.push_back(treeMesh);
 		mpListOfTreeMeshes.push_back(plantMeshes);
 	}
@@ -682,6 +722,11 @@ CMesh* CEngine::LoadMesh(std::string filename, float radius)
 	return mpGraphics->LoadMesh(filename, radius);
 }
 
+CMesh* CEngine::LoadMeshAsync(std::string filename, float radius)
+{
+	return mpGraphics->LoadMeshAsync(filename, radius);
+}
+
 /* Create a primitive shape and place it in our world, may pass in diffuse lighting boolean to indicate wether it should be used. */
 CPrimitive* CEngine::CreatePrimitive(std::string textureFilename, bool useLighting, PrioEngine::Primitives shape)
 {
@@ -110,6 +110,8 @@ public:
 	
 	// Load a mesh into the engine from filename X, textures will need to be located in 'Resources/Textures/'
 	CMesh* LoadMesh(std::string filename, float radius = 1.0f);
+	// Load a mesh in the background, models can be created from it straight away but won't appear until it has loaded.
+	CMesh* LoadMeshAsync(std::string filename, float radius = 1.0f);
 	// Remove a mesh from the engine.
 	bool RemoveMesh(CMesh* mesh);
 
@@ -200,6 +202,12 @@ public:
 	float GetLevelOfDetail();
 	void SetLevelOfDetail(float value);
 
+	// Draw the water refraction and reflection at a fraction of the screen size, 1.0 is full size.
+	void SetWaterResolutionScale(float refractionScale, float reflectionScale);
+	// Redraw each of the water refraction and reflection only once every this many frames, 1 redraws them every frame.
+	void SetWaterUpdateInterval(unsigned int frames);
+	unsigned int GetWaterUpdateInterval();
+
 	/////////////////////////
 	// Boolean flags to prevent threading issues.
 	/////////////////////////
@@ -211,6 +219,8 @@ public:
 	int GetScreenHeight() { return mpGraphics->GetScreenHeight(); };
 private:
 	std::vector<CMesh*> mpListOfTreeMeshes;
+	// Size of the square areas the scenery is merged into for drawing at a distance.
+	const float kSceneryChunkSize = 64.0f;
 };
 
 // Define WndProc and the application handle pointer here so that we can re-direct the windows system messaging into our message handler 
@@ -0,0 +1,127 @@
+#include "FileSystem.h"
+#include "Lz4.h"
+#include <chrono>
+
+CVirtualFile::CVirtualFile()
+{
+	mpData = nullptr;
+	mSize = 0;
+	mPacked = false;
+}
+
+
+CVirtualFile::~CVirtualFile()
+{
+	Close();
+}
+
+bool CVirtualFile::Open(const std::string& filename)
+{
+	return CFileSystem::GetInstance().Open(filename, *this);
+}
+
+void CVirtualFile::Close()
+{
+	mLooseFile.Close();
+	std::vector<unsigned char>().swap(mDecompressed);
+	mpData = nullptr;
+	mSize = 0;
+	mPacked = false;
+}
+
+CFileSystem::CFileSystem()
+{
+}
+
+
+CFileSystem::~CFileSystem()
+{
+	UnmountAll();
+}
+
+/* Map a pack so its files are found ahead of any loose copies on disk.
+* @Returns bool Success, a missing pack isn't an error for anything other than the log as files are read from disk instead. */
+bool CFileSystem::Mount(const std::string& packFile)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	CPackFile* pack = new CPackFile();
+	if (!pack->Open(packFile))
+	{
+		logger->GetInstance().WriteLine("Couldn't mount the pack '" + packFile + "', files will be read from disk.");
+		delete pack;
+		return false;
+	}
+
+	mPacks.push_back(pack);
+
+	const std::chrono::duration<float, std::milli> mountTime = std::chrono::high_resolution_clock::now() - startTime;
+	logger->GetInstance().WriteLine("Mounted the pack '" + packFile + "' holding " + std::to_string(pack->GetNumberOfEntries()) +
+		" files in " + std::to_string(mountTime.count()) + "ms.");
+
+	return true;
+}
+
+void CFileSystem::UnmountAll()
+{
+	for (auto pack : mPacks)
+	{
+		delete pack;
+	}
+	mPacks.clear();
+}
+
+/* @Returns bool Whether the file was found and could be read. */
+bool CFileSystem::Open(const std::string& filename, CVirtualFile& file)
+{
+	file.Close();
+
+	for (auto pack : mPacks)
+	{
+		const CPackFile::Entry* entry = pack->Find(filename);
+		if (entry == nullptr)
+		{
+			continue;
+		}
+
+		const unsigned char* data = pack->GetEntryData(*entry);
+
+		if ((entry->flags & CPackFile::CompressedEntry) != 0)
+		{
+			file.mDecompressed.resize(static_cast<size_t>(entry->size));
+			if (!PrioEngine::Lz4::Decompress(data, static_cast<size_t>(entry->storedSize), file.mDecompressed.data(), file.mDecompressed.size()))
+			{
+				logger->GetInstance().WriteLine("The entry for '" + filename + "' in the pack '" + pack->GetFilename() + "' is corrupt.");
+				file.Close();
+				return false;
+			}
+			data = file.mDecompressed.data();
+		}
+
+		file.mpData = data;
+		file.mSize = static_cast<size_t>(entry->size);
+		file.mPacked = true;
+		return true;
+	}
+
+	if (!file.mLooseFile.Open(filename))
+	{
+		return false;
+	}
+
+	file.mpData = file.mLooseFile.GetData();
+	file.mSize = file.mLooseFile.GetSize();
+	return true;
+}
+
+bool CFileSystem::ReadText(const std::string& filename, std::string& text)
+{
+	CVirtualFile file;
+	if (!Open(filename, file))
+	{
+		return false;
+	}
+
+	text.assign(reinterpret_cast<const char*>(file.GetData()), file.GetSize());
+	return true;
+}
@@ -0,0 +1,76 @@
+#ifndef FILESYSTEM_H
+#define FILESYSTEM_H
+
+#include <string>
+#include <vector>
+#include "Logger.h"
+#include "MappedFile.h"
+#include "PackFile.h"
+
+// Built by running with -pack, and mounted as the engine starts if it's there.
+const char* const kResourcePackFile = "Resources.pak";
+
+/* The contents of a file opened through the file system. Entries stored uncompressed in a pack point straight into the
+* pack's mapping, compressed entries are decompressed into memory owned by this, and loose files are mapped on their own. */
+class CVirtualFile
+{
+private:
+	CLogger* logger;
+public:
+	CVirtualFile();
+	~CVirtualFile();
+public:
+	// Open a file from the first mounted pack which holds it, or from disk if none of them do.
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen() { return mpData != nullptr; };
+	const unsigned char* GetData() { return mpData; };
+	size_t GetSize() { return mSize; };
+	// Whether the file came out of a pack rather than from disk.
+	bool IsPacked() { return mPacked; };
+private:
+	// Can't be copied, as the data may point into memory owned by this.
+	CVirtualFile(const CVirtualFile&);
+	CVirtualFile& operator=(const CVirtualFile&);
+private:
+	friend class CFileSystem;
+
+	CMappedFile mLooseFile;
+	std::vector<unsigned char> mDecompressed;
+	const unsigned char* mpData;
+	size_t mSize;
+	bool mPacked;
+};
+
+/* Every resource the engine loads is read through here, so it doesn't matter to a loader whether a file is packed or
+* loose on disk. Packs are searched in the order they were mounted before falling back to disk.
+* Packs must only be mounted and unmounted while nothing is loading, opening files is safe from any thread. */
+class CFileSystem
+{
+private:
+	CLogger* logger;
+public:
+	static CFileSystem& GetInstance()
+	{
+		static CFileSystem instance;
+
+		return instance;
+	}
+private:
+	CFileSystem();
+	~CFileSystem();
+	CFileSystem(CFileSystem const&) = delete;
+	void operator=(CFileSystem const&) = delete;
+public:
+	bool Mount(const std::string& packFile);
+	void UnmountAll();
+
+	bool Open(const std::string& filename, CVirtualFile& file);
+	// Read a whole file into a string, for text formats which are parsed with streams.
+	bool ReadText(const std::string& filename, std::string& text);
+private:
+	std::vector<CPackFile*> mPacks;
+};
+
+#endif
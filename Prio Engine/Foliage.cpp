@@ -1,4 +1,5 @@
 #include "Foliage.h"
+#include "StateCache.h"
 
 
 
@@ -379,9 +380,9 @@ void CFoliage::RenderBuffers(ID3D11DeviceContext * deviceContext, int quadIndex,
 	}
 	bufferPtrs[1] = mpInstanceBuffer;
 
-	deviceContext->IASetVertexBuffers(0, 2, bufferPtrs, strides, offsets);
+	CStateCache::Get(deviceContext)->IASetVertexBuffers(0, 2, bufferPtrs, strides, offsets);
 
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
 bool CFoliage::UpdateBuffers(ID3D11Device* device, double** heightMap, int mapWidth, int mapHeight, CTerrainTile** terrainTiles, int terrainWidth, int terrainHeight)
@@ -1,4 +1,5 @@
 #include "FoliageShader.h"
+#include "StateCache.h"
 
 CFoliageShader::CFoliageShader()
 {
@@ -69,7 +70,7 @@ bool CFoliageShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "FoliageVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "FoliageVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -86,7 +87,7 @@ bool CFoliageShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "FoliagePS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "FoliagePS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -290,29 +291,6 @@ bool CFoliageShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 		return false;
 	}
 
-	////////////////////////////////
-	// Light buffer
-	///////////////////////////////
-
-	D3D11_BUFFER_DESC lightBufferDesc;
-
-	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&lightBufferDesc, NULL, &mpLightBuffer);
-
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create the buffer pointer to access the light buffer from foilage shader class.");
-		return false;
-	}
-
 	////////////////////////////////
 	// Compliment buffer
 	///////////////////////////////
@@ -413,36 +391,7 @@ bool CFoliageShader::SetShaderParameters(ID3D11DeviceContext * deviceContext)
 		return false;
 	}
 
-	/////////////////////////////
-	// Light buffer
-	/////////////////////////////
-
-	// Lock the matrix buffer for writing to.
-	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-
-	// If we did not successfully lock the constant buffer.
-	if (FAILED(result))
-	{
-		// Output error message to the logs.
-		logger->GetInstance().WriteLine("Failed to lock the light buffer before writing to it in shader class.");
-		return false;
-	}
-
-	// Grab pointer to the matrix const buff.
-	LightBufferType* lightBufferPtr = static_cast<LightBufferType*>(mappedResource.pData);
-
-	// Set data in the structure.
-	lightBufferPtr->AmbientColour = mAmbientColour;
-	lightBufferPtr->DiffuseColour = mDiffuseColour;
-	lightBufferPtr->LightDirection = mLightDirection;
-	lightBufferPtr->padding = 0.0f;
-
-	// Unlock the const buffer and write modifications to it.
-	deviceContext->Unmap(mpLightBuffer, 0);
-
-	// Pass buffer to shader
-	bufferNumber = 0;
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
+	// Lighting comes from the shared frame constants, only the wind and placement are set here.
 
 	/////////////////////////////
 	// Foliage buffer
@@ -473,17 +422,17 @@ bool CFoliageShader::SetShaderParameters(ID3D11DeviceContext * deviceContext)
 
 	// Pass buffer to shader
 	bufferNumber = 1;
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &mpFoliageBuffer);
+	CStateCache::Get(deviceContext)->VSSetConstantBuffers(bufferNumber, 1, &mpFoliageBuffer);
 
 	/////////////////////////////
 	// Resources buffer
 	/////////////////////////////
 
 	// Set the shader texture resource in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &mpGrassTexture);
-	deviceContext->PSSetShaderResources(1, 1, &mpAlphaTexture);
-	deviceContext->PSSetShaderResources(2, 1, &mpReedTexture);
-	deviceContext->PSSetShaderResources(3, 1, &mpReedAlphaTexture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpGrassTexture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(1, 1, &mpAlphaTexture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(2, 1, &mpReedTexture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(3, 1, &mpReedAlphaTexture);
 
 	return true;
 }
@@ -491,14 +440,14 @@ bool CFoliageShader::SetShaderParameters(ID3D11DeviceContext * deviceContext)
 void CFoliageShader::RenderShader(ID3D11DeviceContext * deviceContext, int vertexCount, int instanceCount)
 {
 	// Set the vertex input layout
-	deviceContext->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpPixelShader, NULL, 0);
 
 	// Set sample state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpSampleState);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpSampleState);
 	
 	deviceContext->DrawInstanced(vertexCount, instanceCount, 0, 0);
 }
@@ -523,21 +472,6 @@ void CFoliageShader::SetReedAlphaTexture(ID3D11ShaderResourceView * alphaTexture
 	mpReedAlphaTexture = alphaTexture;
 }
 
-void CFoliageShader::SetAmbientColour(D3DXVECTOR4 ambientColour)
-{
-	mAmbientColour = ambientColour;
-}
-
-void CFoliageShader::SetDiffuseColour(D3DXVECTOR4 diffuseColour)
-{
-	mDiffuseColour = diffuseColour;
-}
-
-void CFoliageShader::SetLightDirection(D3DXVECTOR3 lightDirection)
-{
-	mLightDirection = lightDirection;
-}
-
 void CFoliageShader::SetWindDirection(D3DXVECTOR3 direction)
 {
 	mWindDirection = direction;
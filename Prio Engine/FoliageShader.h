@@ -5,14 +5,6 @@
 class CFoliageShader : public CShader
 {
 private:
-	struct LightBufferType
-	{
-		D3DXVECTOR4 AmbientColour;
-		D3DXVECTOR4 DiffuseColour;
-		D3DXVECTOR3 LightDirection;
-		float padding;
-	};
-
 	struct FoliageBufferType
 	{
 		D3DXVECTOR3 WindDirection;
@@ -41,16 +33,12 @@ private:
 	ID3D11PixelShader* mpPixelShader;
 	ID3D11InputLayout* mpLayout;
 	ID3D11SamplerState* mpSampleState;
-	ID3D11Buffer* mpLightBuffer;
 	ID3D11Buffer* mpFoliageBuffer;
 public:
 	void SetGrassTexture(ID3D11ShaderResourceView * grassTexture);
 	void SetGrassAlphaTexture(ID3D11ShaderResourceView * alphaTexture);
 	void SetReedTexture(ID3D11ShaderResourceView * reedTexture);
 	void SetReedAlphaTexture(ID3D11ShaderResourceView * alphaTexture);
-	void SetAmbientColour(D3DXVECTOR4 ambientColour);
-	void SetDiffuseColour(D3DXVECTOR4 diffuseColour);
-	void SetLightDirection(D3DXVECTOR3 lightDirection);
 	void SetWindDirection(D3DXVECTOR3 direction);
 	void SetFrameTime(float frameTime);
 	void SetWindStrength(float strength);
@@ -60,9 +48,6 @@ public:
 	ID3D11ShaderResourceView * mpAlphaTexture;
 	ID3D11ShaderResourceView * mpReedTexture;
 	ID3D11ShaderResourceView * mpReedAlphaTexture;
-	D3DXVECTOR4 mAmbientColour;
-	D3DXVECTOR4 mDiffuseColour;
-	D3DXVECTOR3 mLightDirection;
 	D3DXVECTOR3 mWindDirection;
 	float mFrameTime;
 	float mStrength;
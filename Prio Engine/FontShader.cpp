@@ -1,4 +1,5 @@
 #include "FontShader.h"
+#include "StateCache.h"
 
 CFontShader::CFontShader()
 {
@@ -68,7 +69,7 @@ bool CFontShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "FontVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "FontVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -85,7 +86,7 @@ bool CFontShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "FontPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "FontPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		// If we recieved an error message.
@@ -284,7 +285,7 @@ bool CFontShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, ID3D11
 	}
 
 	// Set the shader texture resource in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &texture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &texture);
 
 	// Lock pixel buffer so we can write to it.
 	result = deviceContext->Map(mpPixelBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
@@ -308,7 +309,7 @@ bool CFontShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, ID3D11
 	bufferNumber = 0;
 
 	// Now set the pixel constant buffer in the pixel shader with new val.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpPixelBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpPixelBuffer);
 
 	return true;
 }
@@ -316,14 +317,14 @@ bool CFontShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, ID3D11
 void CFontShader::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
 
 	// Set the vertex and pixel shaders that will be used to render the triangles.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpSampleState);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpSampleState);
 
 	// Render the triangles.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
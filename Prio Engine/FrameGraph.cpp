@@ -0,0 +1,586 @@
+#include "FrameGraph.h"
+#include <cstring>
+#include <chrono>
+#include <sstream>
+
+namespace
+{
+	bool SameDesc(const CFrameGraph::TargetDesc& a, const CFrameGraph::TargetDesc& b)
+	{
+		return a.width == b.width && a.height == b.height && a.format == b.format && a.depth == b.depth;
+	}
+}
+
+CFrameGraph::CFrameGraph(ID3D11Device* device)
+{
+	mpDevice = device;
+	mCompiled = false;
+	mHoldingReleases = false;
+	mFrame = 0;
+	mFramesExecuted = 0;
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+}
+
+
+CFrameGraph::~CFrameGraph()
+{
+	Shutdown();
+}
+
+void CFrameGraph::Shutdown()
+{
+	ReleaseAllTargets();
+
+	for (auto& pooledTarget : mPool)
+	{
+		DestroyTexture(pooledTarget.texture);
+	}
+
+	for (auto& historyTarget : mHistory)
+	{
+		DestroyTexture(historyTarget.texture);
+	}
+
+	mPool.clear();
+	mHistory.clear();
+	mResources.clear();
+	mPasses.clear();
+	mCompiled = false;
+}
+
+void CFrameGraph::Reset()
+{
+	ReleaseAllTargets();
+
+	mResources.clear();
+	mPasses.clear();
+	mCompiled = false;
+	mFrame++;
+
+	// Anything left over from a pass which has stopped running is given back, so the memory doesn't stay held for good.
+	for (unsigned int i = 0; i < mPool.size();)
+	{
+		if (!mPool[i].inUse && mFrame - mPool[i].lastUsedFrame > kFramesBeforeRelease)
+		{
+			DestroyTexture(mPool[i].texture);
+
+			mPool[i] = mPool.back();
+			mPool.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	for (unsigned int i = 0; i < mHistory.size();)
+	{
+		if (mFrame - mHistory[i].lastUsedFrame > kFramesBeforeRelease)
+		{
+			DestroyTexture(mHistory[i].texture);
+
+			mHistory[i] = mHistory.back();
+			mHistory.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+	mStatistics.pooledTargets = static_cast<unsigned int>(mPool.size());
+}
+
+CFrameGraph::ResourceId CFrameGraph::CreateTarget(const std::string& name, const TargetDesc& desc)
+{
+	return AddResource(name, true, desc);
+}
+
+CFrameGraph::ResourceId CFrameGraph::CreateVirtual(const std::string& name)
+{
+	TargetDesc desc = { 0, 0, DXGI_FORMAT_UNKNOWN, false };
+	return AddResource(name, false, desc);
+}
+
+CFrameGraph::ResourceId CFrameGraph::CreateHistoryTarget(const std::string& name, const TargetDesc& desc)
+{
+	unsigned int history = 0;
+	while (history < mHistory.size() && mHistory[history].name != name)
+	{
+		history++;
+	}
+
+	if (history == mHistory.size())
+	{
+		HistoryTarget historyTarget;
+		historyTarget.name = name;
+		historyTarget.desc = desc;
+		historyTarget.texture = nullptr;
+		historyTarget.valid = false;
+		mHistory.push_back(historyTarget);
+	}
+	else if (!SameDesc(mHistory[history].desc, desc))
+	{
+		// Whatever was drawn at the old size is thrown away rather than stretched.
+		DestroyTexture(mHistory[history].texture);
+		mHistory[history].desc = desc;
+		mHistory[history].valid = false;
+	}
+	mHistory[history].lastUsedFrame = mFrame;
+
+	ResourceId resource = AddResource(name, true, desc);
+	mResources[resource].history = history;
+
+	return resource;
+}
+
+bool CFrameGraph::IsHistoryValid(ResourceId resource)
+{
+	if (resource >= mResources.size() || mResources[resource].history == kNone)
+	{
+		return false;
+	}
+
+	return mHistory[mResources[resource].history].valid;
+}
+
+CFrameGraph::PassId CFrameGraph::AddPass(const std::string& name, ExecuteFunction function)
+{
+	Pass pass;
+	pass.name = name;
+	pass.function = function;
+	pass.sideEffect = false;
+	pass.deferred = false;
+	pass.references = 0;
+	pass.active = false;
+
+	mPasses.push_back(pass);
+	mCompiled = false;
+
+	return static_cast<PassId>(mPasses.size() - 1);
+}
+
+void CFrameGraph::Read(PassId pass, ResourceId resource)
+{
+	if (pass >= mPasses.size() || resource >= mResources.size())
+	{
+		logger->GetInstance().WriteLine("Attempted to read a resource which doesn't exist in the frame graph.");
+		return;
+	}
+
+	mPasses[pass].reads.push_back(resource);
+}
+
+void CFrameGraph::Write(PassId pass, ResourceId resource)
+{
+	if (pass >= mPasses.size() || resource >= mResources.size())
+	{
+		logger->GetInstance().WriteLine("Attempted to write a resource which doesn't exist in the frame graph.");
+		return;
+	}
+
+	mPasses[pass].writes.push_back(resource);
+	mResources[resource].writers.push_back(pass);
+}
+
+void CFrameGraph::SetSideEffect(PassId pass)
+{
+	if (pass < mPasses.size())
+	{
+		mPasses[pass].sideEffect = true;
+	}
+}
+
+void CFrameGraph::SetDeferred(PassId pass)
+{
+	if (pass < mPasses.size())
+	{
+		mPasses[pass].deferred = true;
+	}
+}
+
+void CFrameGraph::FlushDeferredReleases()
+{
+	for (auto texture : mHeldTargets)
+	{
+		ReleaseTarget(texture);
+	}
+
+	mHeldTargets.clear();
+	mHoldingReleases = false;
+}
+
+void CFrameGraph::SkipPass(const std::string& name)
+{
+	mTimings[name].framesSkipped++;
+}
+
+/* Every pass starts out referenced once for each resource it writes, plus once more if it has side effects, and loses a
+* reference for each of those resources which nothing reads. Passes left with no references are pruned, which may leave
+* what they read with no readers, in turn taking references away from the passes which wrote it. */
+void CFrameGraph::Compile()
+{
+	mStatistics.passes = 0;
+	mStatistics.prunedPasses = 0;
+	mStatistics.targets = 0;
+
+	for (auto& resource : mResources)
+	{
+		resource.readers = 0;
+		resource.firstPass = kNone;
+		resource.lastPass = kNone;
+	}
+
+	for (auto& pass : mPasses)
+	{
+		for (auto resource : pass.reads)
+		{
+			mResources[resource].readers++;
+		}
+		pass.references = static_cast<unsigned int>(pass.writes.size()) + (pass.sideEffect ? 1 : 0);
+		pass.active = true;
+		pass.acquires.clear();
+		pass.releases.clear();
+	}
+
+	// Anything nothing reads takes away a reference from each pass which wrote it.
+	std::vector<PassId> unreferenced;
+	for (auto& resource : mResources)
+	{
+		if (resource.readers > 0)
+		{
+			continue;
+		}
+
+		for (auto writer : resource.writers)
+		{
+			if (--mPasses[writer].references == 0)
+			{
+				unreferenced.push_back(writer);
+			}
+		}
+	}
+
+	while (!unreferenced.empty())
+	{
+		Pass& pass = mPasses[unreferenced.back()];
+		unreferenced.pop_back();
+		pass.active = false;
+
+		for (auto resource : pass.reads)
+		{
+			if (--mResources[resource].readers > 0)
+			{
+				continue;
+			}
+
+			for (auto writer : mResources[resource].writers)
+			{
+				if (mPasses[writer].active && --mPasses[writer].references == 0)
+				{
+					unreferenced.push_back(writer);
+				}
+			}
+		}
+	}
+
+	for (PassId id = 0; id < mPasses.size(); id++)
+	{
+		Pass& pass = mPasses[id];
+		if (!pass.active)
+		{
+			mStatistics.prunedPasses++;
+			continue;
+		}
+
+		mStatistics.passes++;
+
+		for (auto resource : pass.reads)
+		{
+			if (mResources[resource].firstPass == kNone && mResources[resource].isTarget && mResources[resource].history == kNone)
+			{
+				logger->GetInstance().WriteLine("The pass '" + pass.name + "' reads the target '" + mResources[resource].name + "' before anything has written to it.");
+			}
+		}
+
+		auto touch = [this, id](ResourceId resource)
+		{
+			if (mResources[resource].firstPass == kNone)
+			{
+				mResources[resource].firstPass = id;
+			}
+			mResources[resource].lastPass = id;
+		};
+		for (auto resource : pass.reads)
+		{
+			touch(resource);
+		}
+		for (auto resource : pass.writes)
+		{
+			touch(resource);
+		}
+	}
+
+	for (ResourceId id = 0; id < mResources.size(); id++)
+	{
+		Resource& resource = mResources[id];
+		if (resource.isTarget && resource.history == kNone && resource.firstPass != kNone)
+		{
+			mPasses[resource.firstPass].acquires.push_back(id);
+			mPasses[resource.lastPass].releases.push_back(id);
+			mStatistics.targets++;
+		}
+	}
+
+	mCompiled = true;
+}
+
+/* Targets are handed back as soon as the last pass using them has finished, so a later pass in the same frame can take
+* them, unless a deferred pass has run, in which case they're held until FlushDeferredReleases.
+* @Returns bool False if a target couldn't be created or a pass failed, in which case no later passes are run. */
+bool CFrameGraph::Execute()
+{
+	if (!mCompiled)
+	{
+		logger->GetInstance().WriteLine("Attempted to execute a frame graph which hasn't been compiled.");
+		return false;
+	}
+
+	mFramesExecuted++;
+
+	// History targets are created the first frame anything uses them, and kept after that.
+	for (auto& resource : mResources)
+	{
+		if (resource.history == kNone || resource.firstPass == kNone)
+		{
+			continue;
+		}
+
+		HistoryTarget& historyTarget = mHistory[resource.history];
+		if (historyTarget.texture == nullptr)
+		{
+			historyTarget.texture = CreateTexture(historyTarget.desc);
+			if (historyTarget.texture == nullptr)
+			{
+				logger->GetInstance().WriteLine("Failed to create the history target '" + resource.name + "'.");
+				return false;
+			}
+		}
+		resource.target = historyTarget.texture;
+	}
+
+	const auto executeStart = std::chrono::high_resolution_clock::now();
+
+	for (auto& pass : mPasses)
+	{
+		if (!pass.active)
+		{
+			mTimings[pass.name].framesSkipped++;
+			continue;
+		}
+
+		for (auto resource : pass.acquires)
+		{
+			mResources[resource].target = AcquireTarget(mResources[resource].desc);
+			if (mResources[resource].target == nullptr)
+			{
+				logger->GetInstance().WriteLine("Failed to create the target '" + mResources[resource].name + "' for the pass '" + pass.name + "'.");
+				ReleaseAllTargets();
+				return false;
+			}
+		}
+
+		const auto passStart = std::chrono::high_resolution_clock::now();
+		if (!pass.function())
+		{
+			logger->GetInstance().WriteLine("The pass '" + pass.name + "' failed, skipping the rest of the frame graph.");
+			ReleaseAllTargets();
+			return false;
+		}
+		const std::chrono::duration<float, std::milli> passTime = std::chrono::high_resolution_clock::now() - passStart;
+
+		PassTiming& timing = mTimings[pass.name];
+		timing.framesRun++;
+		timing.totalTime += passTime.count();
+
+		for (auto resource : pass.writes)
+		{
+			if (mResources[resource].history != kNone)
+			{
+				mHistory[mResources[resource].history].valid = true;
+			}
+		}
+
+		// Whatever the pass queued may still draw into any target it used, or one an earlier deferred pass used.
+		if (pass.deferred)
+		{
+			mHoldingReleases = true;
+		}
+
+		for (auto resource : pass.releases)
+		{
+			if (mHoldingReleases)
+			{
+				mHeldTargets.push_back(mResources[resource].target);
+			}
+			else
+			{
+				ReleaseTarget(mResources[resource].target);
+			}
+			mResources[resource].target = nullptr;
+		}
+	}
+
+	const std::chrono::duration<float, std::milli> executeTime = std::chrono::high_resolution_clock::now() - executeStart;
+	mStatistics.executeTime = executeTime.count();
+
+	return true;
+}
+
+/* The saving is estimated from the average cost of the frames a pass did run, measured on the CPU around recording it. */
+void CFrameGraph::LogTimings()
+{
+	if (mFramesExecuted == 0)
+	{
+		return;
+	}
+
+	std::stringstream report;
+	report << "Frame graph timings over " << mFramesExecuted << " frames:";
+	logger->GetInstance().WriteLine(report.str());
+
+	for (auto& entry : mTimings)
+	{
+		const PassTiming& timing = entry.second;
+		const float averageTime = timing.framesRun > 0 ? timing.totalTime / timing.framesRun : 0.0f;
+
+		std::stringstream line;
+		line << "  " << entry.first << ": ran on " << timing.framesRun << " of " << timing.framesRun + timing.framesSkipped
+			<< " frames, " << averageTime << "ms on average, around " << averageTime * timing.framesSkipped << "ms saved on the others.";
+		logger->GetInstance().WriteLine(line.str());
+	}
+}
+
+bool CFrameGraph::IsPassActive(PassId pass)
+{
+	return mCompiled && pass < mPasses.size() && mPasses[pass].active;
+}
+
+bool CFrameGraph::IsResourceUsed(ResourceId resource)
+{
+	return mCompiled && resource < mResources.size() && mResources[resource].firstPass != kNone;
+}
+
+CRenderTexture* CFrameGraph::GetTarget(ResourceId resource)
+{
+	if (resource >= mResources.size())
+	{
+		return nullptr;
+	}
+
+	return mResources[resource].target;
+}
+
+CFrameGraph::ResourceId CFrameGraph::AddResource(const std::string& name, bool isTarget, const TargetDesc& desc)
+{
+	Resource resource;
+	resource.name = name;
+	resource.isTarget = isTarget;
+	resource.desc = desc;
+	resource.readers = 0;
+	resource.firstPass = kNone;
+	resource.lastPass = kNone;
+	resource.target = nullptr;
+	resource.history = kNone;
+
+	mResources.push_back(resource);
+	mCompiled = false;
+
+	return static_cast<ResourceId>(mResources.size() - 1);
+}
+
+/* @Returns CRenderTexture* Null if the texture couldn't be created. */
+CRenderTexture* CFrameGraph::CreateTexture(const TargetDesc& desc)
+{
+	CRenderTexture* texture = new CRenderTexture();
+	logger->GetInstance().MemoryAllocWriteLine(typeid(texture).name());
+	if (!texture->Initialise(mpDevice, desc.width, desc.height, desc.format, desc.depth))
+	{
+		DestroyTexture(texture);
+		return nullptr;
+	}
+
+	mStatistics.createdTargets++;
+
+	return texture;
+}
+
+void CFrameGraph::DestroyTexture(CRenderTexture*& texture)
+{
+	if (texture != nullptr)
+	{
+		texture->Shutdown();
+		delete texture;
+		texture = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(texture).name());
+	}
+}
+
+/* Take a free texture of the same size and format from the pool, creating one if there isn't one.
+* @Returns CRenderTexture* Null if a new texture was needed and couldn't be created. */
+CRenderTexture* CFrameGraph::AcquireTarget(const TargetDesc& desc)
+{
+	for (auto& pooledTarget : mPool)
+	{
+		if (!pooledTarget.inUse && SameDesc(pooledTarget.desc, desc))
+		{
+			pooledTarget.inUse = true;
+			return pooledTarget.texture;
+		}
+	}
+
+	CRenderTexture* texture = CreateTexture(desc);
+	if (texture == nullptr)
+	{
+		return nullptr;
+	}
+
+	PooledTarget pooledTarget;
+	pooledTarget.desc = desc;
+	pooledTarget.texture = texture;
+	pooledTarget.inUse = true;
+	pooledTarget.lastUsedFrame = mFrame;
+	mPool.push_back(pooledTarget);
+
+	mStatistics.pooledTargets = static_cast<unsigned int>(mPool.size());
+
+	return texture;
+}
+
+void CFrameGraph::ReleaseTarget(CRenderTexture* texture)
+{
+	for (auto& pooledTarget : mPool)
+	{
+		if (pooledTarget.texture == texture)
+		{
+			pooledTarget.inUse = false;
+			pooledTarget.lastUsedFrame = mFrame;
+			return;
+		}
+	}
+}
+
+void CFrameGraph::ReleaseAllTargets()
+{
+	FlushDeferredReleases();
+
+	for (auto& resource : mResources)
+	{
+		if (resource.target != nullptr)
+		{
+			ReleaseTarget(resource.target);
+			resource.target = nullptr;
+		}
+	}
+}
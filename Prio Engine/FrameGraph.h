@@ -0,0 +1,186 @@
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+#include <d3d11.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <map>
+#include "RenderTexture.h"
+#include "PrioEngineVars.h"
+
+/* Describes a frame as passes which declare the resources they read and write, rebuilt every frame. Compiling the graph
+* prunes any pass whose writes nothing goes on to read, unless it has effects outside the graph such as drawing to the
+* back buffer, and works out the first and last pass to touch each resource. Render targets are only created when a
+* pass which survives uses them, taken from a pool when it starts and handed back once the last pass using it has run,
+* so targets whose lifetimes don't overlap share the same texture, and the pool is kept from frame to frame.
+* Virtual resources have nothing behind them, they carry results produced elsewhere, such as culling for a view, so
+* whoever produces them can ask whether anything still needs them. History targets are kept from one frame to the next
+* instead, so a pass which only runs every few frames can leave its results for the frames in between.
+* A deferred pass only queues its drawing to be recorded later, so once one has run, targets are held rather than handed
+* back to the pool until FlushDeferredReleases says the queued work has been recorded.
+* Passes are run in the order they were added, the graph never reorders them. Must only be used from the render thread. */
+class CFrameGraph
+{
+private:
+	CLogger* logger;
+public:
+	typedef unsigned int ResourceId;
+	typedef unsigned int PassId;
+	static const unsigned int kNone = 0xFFFFFFFF;
+	// How many frames a pooled target can go unused before it's released.
+	static const unsigned int kFramesBeforeRelease = 120;
+
+	struct TargetDesc
+	{
+		int width;
+		int height;
+		DXGI_FORMAT format;
+		// Give the target a depth buffer of its own, needed when it's a different size to the screen.
+		bool depth;
+	};
+
+	// Returning false stops the graph, no later passes are run.
+	typedef std::function<bool()> ExecuteFunction;
+
+	// Counted since the last call to Reset.
+	struct Statistics
+	{
+		unsigned int passes;
+		unsigned int prunedPasses;
+		// Transient targets used by the passes which ran.
+		unsigned int targets;
+		// Textures the pool needed to create this frame.
+		unsigned int createdTargets;
+		// Textures held by the pool, in use or not.
+		unsigned int pooledTargets;
+		// Time spent running the passes, in milliseconds.
+		float executeTime;
+	};
+public:
+	CFrameGraph(ID3D11Device* device);
+	~CFrameGraph();
+public:
+	void Shutdown();
+
+	// Forget every pass and resource, ready to describe the next frame. Pooled targets which haven't been used for a while are released here.
+	void Reset();
+
+	ResourceId CreateTarget(const std::string& name, const TargetDesc& desc);
+	ResourceId CreateVirtual(const std::string& name);
+	// Found by name, so the same texture is handed back each frame for as long as the description doesn't change. Passes
+	// may read it without anything writing it this frame, whatever was last written is still there.
+	ResourceId CreateHistoryTarget(const std::string& name, const TargetDesc& desc);
+	// Whether a history target has been written since it was created, or last had its description changed.
+	bool IsHistoryValid(ResourceId resource);
+
+	PassId AddPass(const std::string& name, ExecuteFunction function);
+	void Read(PassId pass, ResourceId resource);
+	void Write(PassId pass, ResourceId resource);
+	// The pass is never pruned, whether or not anything reads what it writes.
+	void SetSideEffect(PassId pass);
+	// The pass queues its work rather than drawing it, so no target it could be drawing into is reused until the flush.
+	void SetDeferred(PassId pass);
+	// Hand back the targets held since a deferred pass ran. Must be called once whatever they queued has been recorded.
+	void FlushDeferredReleases();
+	// Count a pass which was left out of this frame on purpose, so the timings can show what skipping it saved.
+	void SkipPass(const std::string& name);
+
+	// Prune unused passes and work out resource lifetimes. Must be called after the last pass is added and before Execute.
+	void Compile();
+	// Run each pass which survived compilation. Targets are only valid while a pass using them is running.
+	bool Execute();
+
+	bool IsPassActive(PassId pass);
+	// Whether any pass which survived compilation reads or writes the resource.
+	bool IsResourceUsed(ResourceId resource);
+	// The texture behind a target, only valid from inside a pass which reads or writes it.
+	CRenderTexture* GetTarget(ResourceId resource);
+
+	const Statistics& GetStatistics() { return mStatistics; };
+	// Write how often each pass ran, what it cost on average and roughly how much was saved on the frames it didn't.
+	void LogTimings();
+private:
+	struct Resource
+	{
+		std::string name;
+		bool isTarget;
+		TargetDesc desc;
+		std::vector<PassId> writers;
+		// Number of surviving passes which read the resource, worked out by Compile.
+		unsigned int readers;
+		PassId firstPass;
+		PassId lastPass;
+		CRenderTexture* target;
+		// Index into the history targets, or kNone if the resource only lasts the frame.
+		unsigned int history;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		ExecuteFunction function;
+		std::vector<ResourceId> reads;
+		std::vector<ResourceId> writes;
+		bool sideEffect;
+		bool deferred;
+		// Number of things still needing the pass, it's pruned when this reaches zero.
+		unsigned int references;
+		bool active;
+		// Targets which start or end their lifetime in this pass.
+		std::vector<ResourceId> acquires;
+		std::vector<ResourceId> releases;
+	};
+
+	struct PooledTarget
+	{
+		TargetDesc desc;
+		CRenderTexture* texture;
+		bool inUse;
+		unsigned int lastUsedFrame;
+	};
+
+	struct HistoryTarget
+	{
+		std::string name;
+		TargetDesc desc;
+		CRenderTexture* texture;
+		bool valid;
+		unsigned int lastUsedFrame;
+	};
+
+	// Added up across every frame since the graph was created, by the name of the pass.
+	struct PassTiming
+	{
+		unsigned int framesRun;
+		unsigned int framesSkipped;
+		// In milliseconds.
+		float totalTime;
+	};
+private:
+	ResourceId AddResource(const std::string& name, bool isTarget, const TargetDesc& desc);
+	CRenderTexture* CreateTexture(const TargetDesc& desc);
+	void DestroyTexture(CRenderTexture*& texture);
+	CRenderTexture* AcquireTarget(const TargetDesc& desc);
+	void ReleaseTarget(CRenderTexture* texture);
+	void ReleaseAllTargets();
+private:
+	ID3D11Device* mpDevice;
+	std::vector<Resource> mResources;
+	std::vector<Pass> mPasses;
+	bool mCompiled;
+
+	std::vector<PooledTarget> mPool;
+	// Targets finished with since a deferred pass ran, which stay in use until its work has been recorded.
+	bool mHoldingReleases;
+	std::vector<CRenderTexture*> mHeldTargets;
+	std::vector<HistoryTarget> mHistory;
+	unsigned int mFrame;
+
+	std::map<std::string, PassTiming> mTimings;
+	unsigned int mFramesExecuted;
+
+	Statistics mStatistics;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "FrameRingBuffer.h"
+#include <cstring>
+#include <thread>
+
+CFrameRingBuffer::CFrameRingBuffer(CRenderDevice* renderDevice, CRenderDevice::BufferType type, unsigned int size)
+{
+	mpRenderDevice = renderDevice;
+	mType = type;
+	mSize = size;
+	mpBuffer = nullptr;
+	mHead = 0;
+	mBytesInUse = 0;
+	mFrameBytes = 0;
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+	std::memset(&mLastFrameStatistics, 0, sizeof(mLastFrameStatistics));
+}
+
+
+CFrameRingBuffer::~CFrameRingBuffer()
+{
+	Shutdown();
+}
+
+bool CFrameRingBuffer::Initialise()
+{
+	CRenderDevice::BufferDesc bufferDesc;
+	bufferDesc.type = mType;
+	bufferDesc.usage = CRenderDevice::DynamicUsage;
+	bufferDesc.size = mSize;
+
+	mpBuffer = mpRenderDevice->CreateBuffer(bufferDesc, nullptr);
+	if (mpBuffer == nullptr)
+	{
+		logger->GetInstance().WriteLine("Failed to create a frame ring buffer of " + std::to_string(mSize) + " bytes.");
+		return false;
+	}
+
+	return true;
+}
+
+void CFrameRingBuffer::Shutdown()
+{
+	if (mpBuffer != nullptr)
+	{
+		mpRenderDevice->DestroyBuffer(mpBuffer);
+		mpBuffer = nullptr;
+	}
+
+	mFrames.clear();
+	mHead = 0;
+	mBytesInUse = 0;
+	mFrameBytes = 0;
+}
+
+/* @Returns bool False if the data is bigger than the whole ring, nothing is written in that case. */
+bool CFrameRingBuffer::Write(const void* data, unsigned int size, unsigned int alignment, unsigned int& offset)
+{
+	if (mpBuffer == nullptr || !Reserve(size, alignment, offset))
+	{
+		mStatistics.failedAllocations++;
+		return false;
+	}
+
+	void* destination = mpRenderDevice->MapNoOverwrite(mpBuffer, offset, size);
+	if (destination == nullptr)
+	{
+		mStatistics.failedAllocations++;
+		return false;
+	}
+
+	std::memcpy(destination, data, size);
+	mpRenderDevice->Unmap(mpBuffer);
+
+	mStatistics.allocations++;
+	mStatistics.bytesAllocated += size;
+
+	return true;
+}
+
+void CFrameRingBuffer::EndFrame()
+{
+	FrameRecord frame;
+	frame.fence = mpRenderDevice->InsertFence();
+	frame.bytes = mFrameBytes;
+	mFrames.push_back(frame);
+	mFrameBytes = 0;
+
+	mLastFrameStatistics = mStatistics;
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+}
+
+/* Find room for the next write. The bytes in use always run contiguously, wrapping around the end, from the oldest
+* frame the GPU hasn't finished with up to the head. Padding for alignment and the space skipped at the end when
+* wrapping count as in use too, so they're given back along with the frame that skipped them.
+* @Returns bool Whether there was room, once the GPU had caught up if need be. */
+bool CFrameRingBuffer::Reserve(unsigned int size, unsigned int alignment, unsigned int& offset)
+{
+	if (size == 0 || size > mSize)
+	{
+		return false;
+	}
+
+	alignment = alignment == 0 ? 1 : alignment;
+	unsigned int start = (mHead + alignment - 1) / alignment * alignment;
+	bool wraps = false;
+
+	if (start + size > mSize)
+	{
+		start = 0;
+		wraps = true;
+	}
+
+	const unsigned int needed = (wraps ? mSize - mHead : start - mHead) + size;
+	if (needed > mSize)
+	{
+		return false;
+	}
+
+	RetireFrames(false);
+	while (mBytesInUse + needed > mSize)
+	{
+		// This frame alone has filled the ring, there's nothing the GPU can give back.
+		if (mFrames.empty())
+		{
+			logger->GetInstance().WriteLine("Frame ring buffer of " + std::to_string(mSize) + " bytes is too small for one frame.");
+			return false;
+		}
+
+		mStatistics.stalls++;
+		RetireFrames(true);
+	}
+
+	if (wraps)
+	{
+		mStatistics.wraps++;
+	}
+
+	offset = start;
+	mHead = start + size;
+	mBytesInUse += needed;
+	mFrameBytes += needed;
+	mStatistics.peakBytesInUse = mBytesInUse > mStatistics.peakBytesInUse ? mBytesInUse : mStatistics.peakBytesInUse;
+
+	return true;
+}
+
+/* Give back the space of every frame the GPU has finished with. When waiting, blocks until at least the oldest has. */
+void CFrameRingBuffer::RetireFrames(bool wait)
+{
+	if (wait && !mFrames.empty())
+	{
+		while (!mpRenderDevice->IsFenceComplete(mFrames.front().fence))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	while (!mFrames.empty() && mpRenderDevice->IsFenceComplete(mFrames.front().fence))
+	{
+		mBytesInUse -= mFrames.front().bytes;
+		mFrames.pop_front();
+	}
+}
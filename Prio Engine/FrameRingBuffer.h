@@ -0,0 +1,67 @@
+#ifndef FRAMERINGBUFFER_H
+#define FRAMERINGBUFFER_H
+
+#include <deque>
+#include "RenderDevice.h"
+
+/* One large dynamic vertex or index buffer which data that only lives for a frame is written into one after another.
+* Writes never discard the buffer, so the driver never has to rename it. Instead each frame ends with a fence, and the
+* space a frame used is only written over again once the GPU has passed that frame's fence.
+* Must only be used from the thread which owns the render device. */
+class CFrameRingBuffer
+{
+private:
+	CLogger* logger;
+public:
+	// Counted since the last call to EndFrame.
+	struct Statistics
+	{
+		unsigned int allocations;
+		unsigned int failedAllocations;
+		unsigned long long bytesAllocated;
+		unsigned int wraps;
+		// Times a write had to wait on the GPU to finish with an earlier frame.
+		unsigned int stalls;
+		unsigned int peakBytesInUse;
+	};
+public:
+	CFrameRingBuffer(CRenderDevice* renderDevice, CRenderDevice::BufferType type, unsigned int size);
+	~CFrameRingBuffer();
+public:
+	bool Initialise();
+	void Shutdown();
+
+	// Copy data into the ring, the offset it was written at is given back to bind or draw from.
+	bool Write(const void* data, unsigned int size, unsigned int alignment, unsigned int& offset);
+	// Called once the last draw of a frame using the ring has been issued.
+	void EndFrame();
+
+	CRenderDevice::Buffer* GetBuffer() { return mpBuffer; };
+	unsigned int GetSize() { return mSize; };
+	const Statistics& GetLastFrameStatistics() { return mLastFrameStatistics; };
+private:
+	bool Reserve(unsigned int size, unsigned int alignment, unsigned int& offset);
+	void RetireFrames(bool wait);
+private:
+	struct FrameRecord
+	{
+		unsigned long long fence;
+		unsigned int bytes;
+	};
+private:
+	CRenderDevice* mpRenderDevice;
+	CRenderDevice::BufferType mType;
+	unsigned int mSize;
+	CRenderDevice::Buffer* mpBuffer;
+
+	// Where the next write goes, and how many bytes behind it are still waiting on the GPU, padding included.
+	unsigned int mHead;
+	unsigned int mBytesInUse;
+	unsigned int mFrameBytes;
+	std::deque<FrameRecord> mFrames;
+
+	Statistics mStatistics;
+	Statistics mLastFrameStatistics;
+};
+
+#endif
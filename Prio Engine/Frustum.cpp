@@ -1,7 +1,21 @@
 #include "Frustum.h"
+#include <xmmintrin.h>
+#include <cmath>
+#include <cfloat>
+
+namespace
+{
+	// Spreads a four bit lane mask out so each lane's bit lands in the bottom of its own byte.
+	const unsigned int kLaneToByte[16] =
+	{
+		0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+		0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101
+	};
+}
 
 CFrustum::CFrustum()
 {
+	ClearClipPlane();
 }
 
 
@@ -13,7 +27,7 @@ void CFrustum::ConstructFrustum(float farClip, D3DXMATRIX projMatrix, D3DXMATRIX
 {
 	// Calculate the minimum Z in the frustum.
 	float minZ = -projMatrix._43 / projMatrix._33;
-	float r = farClip / (farClip / minZ);
+	float r = farClip / (farClip - minZ);
 	projMatrix._33 = r;
 	projMatrix._43 = -r * minZ;
 
@@ -62,6 +76,40 @@ void CFrustum::ConstructFrustum(float farClip, D3DXMATRIX projMatrix, D3DXMATRIX
 	mPlanes[5].c = matrix._34 - matrix._32;
 	mPlanes[5].d = matrix._44 - matrix._42;
 	D3DXPlaneNormalize(&mPlanes[5], &mPlanes[5]);
+
+	// Copy the planes out into the layout used by the batched tests, the clip plane is left as it was.
+	for (int i = 0; i < kNumberOfFrustumPlanes; i++)
+	{
+		SetPlane(i, mPlanes[i].a, mPlanes[i].b, mPlanes[i].c, mPlanes[i].d);
+	}
+}
+
+/* The plane is normalised, so distances to it are in world units like those to the planes of the frustum. */
+void CFrustum::SetClipPlane(const D3DXPLANE& plane)
+{
+	D3DXPlaneNormalize(&mPlanes[kClipPlane], &plane);
+	SetPlane(kClipPlane, mPlanes[kClipPlane].a, mPlanes[kClipPlane].b, mPlanes[kClipPlane].c, mPlanes[kClipPlane].d);
+}
+
+/* Everything is the same distance in front of a plane with no normal, so it never culls anything. */
+void CFrustum::ClearClipPlane()
+{
+	mPlanes[kClipPlane] = D3DXPLANE(0.0f, 0.0f, 0.0f, FLT_MAX);
+	SetPlane(kClipPlane, mPlanes[kClipPlane].a, mPlanes[kClipPlane].b, mPlanes[kClipPlane].c, mPlanes[kClipPlane].d);
+}
+
+void CFrustum::SetPlane(int index, float a, float b, float c, float d)
+{
+	for (int lane = 0; lane < 4; lane++)
+	{
+		mPlaneA[index][lane] = a;
+		mPlaneB[index][lane] = b;
+		mPlaneC[index][lane] = c;
+		mPlaneD[index][lane] = d;
+		mAbsPlaneA[index][lane] = std::abs(a);
+		mAbsPlaneB[index][lane] = std::abs(b);
+		mAbsPlaneC[index][lane] = std::abs(c);
+	}
 }
 
 bool CFrustum::CheckPoint(float x, float y, float z)
@@ -69,7 +117,7 @@ bool CFrustum::CheckPoint(float x, float y, float z)
 	for (int i = 0; i < kNumberOfPlanes; i++)
 	{
 		// If coordinates are outside our frustum planes.
-		if (D3DXPlaneDotCoord(&mPlanes[i], &D3DXVECTOR3(x, y, z)) < 0.0f)
+		if (mPlaneA[i][0] * x + mPlaneB[i][0] * y + mPlaneC[i][0] * z + mPlaneD[i][0] < 0.0f)
 		{
 			// Don't need to render this one.
 			return false;
@@ -82,13 +130,260 @@ bool CFrustum::CheckPoint(float x, float y, float z)
 
 bool CFrustum::CheckSphere(D3DXVECTOR3 position, float radius)
 {
+	unsigned int planeMask = kAllPlanes;
+	return CheckSphere(position, radius, planeMask);
+}
+
+bool CFrustum::CheckSphere(D3DXVECTOR3 position, float radius, unsigned int& planeMask)
+{
+	unsigned int intersectedPlanes = 0;
+
 	for (int i = 0; i < kNumberOfPlanes; i++)
 	{
-		if (mPlanes[i].a * position.x + mPlanes[i].b * position.y + mPlanes[i].c * position.z + mPlanes[i].d <= -radius)
+		// The parent was already entirely inside this plane.
+		if (!(planeMask & (1 << i)))
+		{
+			continue;
+		}
+
+		float distance = mPlaneA[i][0] * position.x + mPlaneB[i][0] * position.y + mPlaneC[i][0] * position.z + mPlaneD[i][0];
+
+		if (distance <= -radius)
 		{
 			return false;
 		}
+
+		if (distance < radius)
+		{
+			intersectedPlanes |= 1 << i;
+		}
 	}
+
+	planeMask = intersectedPlanes;
+
 	// Success!
 	return true;
 }
+
+bool CFrustum::CheckRectangle(D3DXVECTOR3 centre, D3DXVECTOR3 extents)
+{
+	unsigned int planeMask = kAllPlanes;
+	return CheckRectangle(centre, extents, planeMask);
+}
+
+/* The scalar version of CullAABBs, with the arithmetic in the same order so both give exactly the same results. */
+bool CFrustum::CheckRectangle(D3DXVECTOR3 centre, D3DXVECTOR3 extents, unsigned int& planeMask)
+{
+	unsigned int intersectedPlanes = 0;
+
+	for (int i = 0; i < kNumberOfPlanes; i++)
+	{
+		if (!(planeMask & (1 << i)))
+		{
+			continue;
+		}
+
+		float distance = mPlaneA[i][0] * centre.x + mPlaneB[i][0] * centre.y + mPlaneC[i][0] * centre.z + mPlaneD[i][0];
+		float projectedRadius = mAbsPlaneA[i][0] * extents.x + mAbsPlaneB[i][0] * extents.y + mAbsPlaneC[i][0] * extents.z;
+
+		if (distance < -projectedRadius)
+		{
+			return false;
+		}
+
+		if (distance < projectedRadius)
+		{
+			intersectedPlanes |= 1 << i;
+		}
+	}
+
+	planeMask = intersectedPlanes;
+
+	return true;
+}
+
+/* Spheres are processed in groups of four, with the last group padded out if the count isn't a multiple of four.
+* The arithmetic is done in the same order as CheckSphere so both give exactly the same results. */
+void CFrustum::CullSpheres(const float* x, const float* y, const float* z, const float* radius, unsigned int count,
+	unsigned int* visibleMasks, unsigned int planeMask, unsigned char* outPlaneMasks)
+{
+	for (unsigned int word = 0; word < (count + 31) / 32; word++)
+	{
+		visibleMasks[word] = 0;
+	}
+
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+
+	for (unsigned int first = 0; first < count; first += 4)
+	{
+		const unsigned int remaining = count - first < 4 ? count - first : 4;
+
+		__m128 posX;
+		__m128 posY;
+		__m128 posZ;
+		__m128 rad;
+
+		if (remaining == 4)
+		{
+			posX = _mm_loadu_ps(x + first);
+			posY = _mm_loadu_ps(y + first);
+			posZ = _mm_loadu_ps(z + first);
+			rad = _mm_loadu_ps(radius + first);
+		}
+		else
+		{
+			float padding[4][4] = {};
+			for (unsigned int lane = 0; lane < remaining; lane++)
+			{
+				padding[0][lane] = x[first + lane];
+				padding[1][lane] = y[first + lane];
+				padding[2][lane] = z[first + lane];
+				padding[3][lane] = radius[first + lane];
+			}
+			posX = _mm_loadu_ps(padding[0]);
+			posY = _mm_loadu_ps(padding[1]);
+			posZ = _mm_loadu_ps(padding[2]);
+			rad = _mm_loadu_ps(padding[3]);
+		}
+
+		const __m128 negativeRad = _mm_xor_ps(rad, signBit);
+		const int laneMask = (1 << remaining) - 1;
+		int outside = 0;
+		// The planes crossed by each lane, one byte per lane.
+		unsigned int intersected = 0;
+
+		for (int i = 0; i < kNumberOfPlanes; i++)
+		{
+			if (!(planeMask & (1 << i)))
+			{
+				continue;
+			}
+
+			__m128 distance = _mm_mul_ps(_mm_loadu_ps(mPlaneA[i]), posX);
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(mPlaneB[i]), posY));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(mPlaneC[i]), posZ));
+			distance = _mm_add_ps(distance, _mm_loadu_ps(mPlaneD[i]));
+
+			outside |= _mm_movemask_ps(_mm_cmple_ps(distance, negativeRad));
+
+			if (outPlaneMasks != nullptr)
+			{
+				intersected |= kLaneToByte[_mm_movemask_ps(_mm_cmplt_ps(distance, rad))] << i;
+			}
+			// Every sphere in the group has already been rejected.
+			else if ((outside & laneMask) == laneMask)
+			{
+				break;
+			}
+		}
+
+		const unsigned int visible = static_cast<unsigned int>(~outside & laneMask);
+		visibleMasks[first / 32] |= visible << (first % 32);
+
+		if (outPlaneMasks != nullptr)
+		{
+			for (unsigned int lane = 0; lane < remaining; lane++)
+			{
+				outPlaneMasks[first + lane] = static_cast<unsigned char>(intersected >> (lane * 8));
+			}
+		}
+	}
+}
+
+/* The box is projected onto each plane normal to find how far it extends towards the plane, then treated like a sphere of that radius. */
+void CFrustum::CullAABBs(const float* centreX, const float* centreY, const float* centreZ,
+	const float* extentX, const float* extentY, const float* extentZ, unsigned int count,
+	unsigned int* visibleMasks, unsigned int planeMask, unsigned char* outPlaneMasks)
+{
+	for (unsigned int word = 0; word < (count + 31) / 32; word++)
+	{
+		visibleMasks[word] = 0;
+	}
+
+	const __m128 signBit = _mm_set1_ps(-0.0f);
+
+	for (unsigned int first = 0; first < count; first += 4)
+	{
+		const unsigned int remaining = count - first < 4 ? count - first : 4;
+
+		__m128 cx;
+		__m128 cy;
+		__m128 cz;
+		__m128 ex;
+		__m128 ey;
+		__m128 ez;
+
+		if (remaining == 4)
+		{
+			cx = _mm_loadu_ps(centreX + first);
+			cy = _mm_loadu_ps(centreY + first);
+			cz = _mm_loadu_ps(centreZ + first);
+			ex = _mm_loadu_ps(extentX + first);
+			ey = _mm_loadu_ps(extentY + first);
+			ez = _mm_loadu_ps(extentZ + first);
+		}
+		else
+		{
+			float padding[6][4] = {};
+			for (unsigned int lane = 0; lane < remaining; lane++)
+			{
+				padding[0][lane] = centreX[first + lane];
+				padding[1][lane] = centreY[first + lane];
+				padding[2][lane] = centreZ[first + lane];
+				padding[3][lane] = extentX[first + lane];
+				padding[4][lane] = extentY[first + lane];
+				padding[5][lane] = extentZ[first + lane];
+			}
+			cx = _mm_loadu_ps(padding[0]);
+			cy = _mm_loadu_ps(padding[1]);
+			cz = _mm_loadu_ps(padding[2]);
+			ex = _mm_loadu_ps(padding[3]);
+			ey = _mm_loadu_ps(padding[4]);
+			ez = _mm_loadu_ps(padding[5]);
+		}
+
+		const int laneMask = (1 << remaining) - 1;
+		int outside = 0;
+		// The planes crossed by each lane, one byte per lane.
+		unsigned int intersected = 0;
+
+		for (int i = 0; i < kNumberOfPlanes; i++)
+		{
+			if (!(planeMask & (1 << i)))
+			{
+				continue;
+			}
+
+			__m128 distance = _mm_mul_ps(_mm_loadu_ps(mPlaneA[i]), cx);
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(mPlaneB[i]), cy));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(mPlaneC[i]), cz));
+			distance = _mm_add_ps(distance, _mm_loadu_ps(mPlaneD[i]));
+
+			__m128 projectedRadius = _mm_mul_ps(_mm_loadu_ps(mAbsPlaneA[i]), ex);
+			projectedRadius = _mm_add_ps(projectedRadius, _mm_mul_ps(_mm_loadu_ps(mAbsPlaneB[i]), ey));
+			projectedRadius = _mm_add_ps(projectedRadius, _mm_mul_ps(_mm_loadu_ps(mAbsPlaneC[i]), ez));
+
+			outside |= _mm_movemask_ps(_mm_cmplt_ps(distance, _mm_xor_ps(projectedRadius, signBit)));
+
+			if (outPlaneMasks != nullptr)
+			{
+				intersected |= kLaneToByte[_mm_movemask_ps(_mm_cmplt_ps(distance, projectedRadius))] << i;
+			}
+			else if ((outside & laneMask) == laneMask)
+			{
+				break;
+			}
+		}
+
+		const unsigned int visible = static_cast<unsigned int>(~outside & laneMask);
+		visibleMasks[first / 32] |= visible << (first % 32);
+
+		if (outPlaneMasks != nullptr)
+		{
+			for (unsigned int lane = 0; lane < remaining; lane++)
+			{
+				outPlaneMasks[first + lane] = static_cast<unsigned char>(intersected >> (lane * 8));
+			}
+		}
+	}
+}
@@ -4,20 +4,58 @@
 #include <D3DX10math.h>
 #include "PrioEngineVars.h"
 
+/* The planes are stored as a structure of arrays, with each coefficient repeated four times so batches of objects
+* can be tested four at a time. A plane mask has a bit set for each plane which still needs testing, children of a
+* node which was entirely inside some planes can be passed the mask from their parent so those planes are skipped.
+* A seventh, clip plane can be added after the six of the frustum, for views which only see one side of a plane such as
+* a reflection in water. Until one is set it's a plane nothing is ever behind. */
 class CFrustum
 {
 private:
 	CLogger* logger;
-	const int kNumberOfPlanes = 6;
+	static const int kNumberOfFrustumPlanes = 6;
+	static const int kClipPlane = kNumberOfFrustumPlanes;
+	static const int kNumberOfPlanes = kNumberOfFrustumPlanes + 1;
+public:
+	static const unsigned int kAllPlanes = (1 << kNumberOfPlanes) - 1;
 public:
 	CFrustum();
 	~CFrustum();
 public:
 	void ConstructFrustum(float farClip, D3DXMATRIX projMatrix, D3DXMATRIX viewMatrix);
+	// Anything entirely on the negative side of the plane is culled, kept until it's cleared rather than reset with the frustum.
+	void SetClipPlane(const D3DXPLANE& plane);
+	void ClearClipPlane();
 	bool CheckPoint(float x, float y, float z);
 	bool CheckSphere(D3DXVECTOR3 position, float radius);
+	// Only tests planes in the mask, on return the mask holds the planes the sphere intersects.
+	bool CheckSphere(D3DXVECTOR3 position, float radius, unsigned int& planeMask);
+	// An axis aligned box given as a centre and half extents, the plane mask works the same as for a sphere.
+	bool CheckRectangle(D3DXVECTOR3 centre, D3DXVECTOR3 extents);
+	bool CheckRectangle(D3DXVECTOR3 centre, D3DXVECTOR3 extents, unsigned int& planeMask);
+
+	// Test a batch of spheres stored as separate arrays. A bit is set in visibleMasks for each visible sphere, one
+	// unsigned int per 32 spheres. If outPlaneMasks is given it receives the planes each sphere intersects.
+	void CullSpheres(const float* x, const float* y, const float* z, const float* radius, unsigned int count,
+		unsigned int* visibleMasks, unsigned int planeMask = kAllPlanes, unsigned char* outPlaneMasks = nullptr);
+	// Same as CullSpheres, but for axis aligned boxes given as a centre and half extents.
+	void CullAABBs(const float* centreX, const float* centreY, const float* centreZ,
+		const float* extentX, const float* extentY, const float* extentZ, unsigned int count,
+		unsigned int* visibleMasks, unsigned int planeMask = kAllPlanes, unsigned char* outPlaneMasks = nullptr);
 private:
-	D3DXPLANE mPlanes[6];
+	void SetPlane(int index, float a, float b, float c, float d);
+private:
+	D3DXPLANE mPlanes[kNumberOfPlanes];
+
+	// Plane coefficients splatted across four lanes.
+	float mPlaneA[kNumberOfPlanes][4];
+	float mPlaneB[kNumberOfPlanes][4];
+	float mPlaneC[kNumberOfPlanes][4];
+	float mPlaneD[kNumberOfPlanes][4];
+	// Absolute values of the normals, used to find the projected radius of a box.
+	float mAbsPlaneA[kNumberOfPlanes][4];
+	float mAbsPlaneB[kNumberOfPlanes][4];
+	float mAbsPlaneC[kNumberOfPlanes][4];
 };
 
 #endif
\ No newline at end of file
@@ -122,12 +122,11 @@ void CGameFont::BuildVertexArray(void * vertices, std::string text, float xPos,
 
 bool CGameFont::LoadFontData(char * dataFile)
 {
-	std::ifstream inFile;
+	std::string fontData;
 	char temp;
 
-	inFile.open(dataFile);
-
-	if (!inFile.is_open())
+	// Read in through the file system, so the font data can come out of a pack.
+	if (!CFileSystem::GetInstance().ReadText(dataFile, fontData))
 	{
 		logger->GetInstance().WriteLine("Could not open the input file in GameFont.cpp.");
 		return false;
@@ -147,6 +146,8 @@ bool CGameFont::LoadFontData(char * dataFile)
 		return false;
 	}
 
+	std::istringstream inFile(fontData);
+
 	// Read in the 95 used ascii characters for text.
 	for (int i = 0; i<95; i++)
 	{
@@ -166,9 +167,6 @@ bool CGameFont::LoadFontData(char * dataFile)
 		inFile >> mpFont[i].size;
 	}
 
-	// Close the file, done with it now.
-	inFile.close();
-
 	// Success!
 	return true;
 }
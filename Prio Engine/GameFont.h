@@ -4,9 +4,11 @@
 #include <d3d11.h>
 #include <d3dx10math.h>
 #include <fstream>
+#include <sstream>
 
 #include "Texture.h"
 #include "PrioEngineVars.h"
+#include "FileSystem.h"
 
 class CGameFont
 {
@@ -1,4 +1,5 @@
 #include "GameText.h"
+#include "StateCache.h"
 
 
 
@@ -6,6 +7,7 @@ CGameText::CGameText()
 {
 	mpFont = nullptr;
 	mpFontShader = nullptr;
+	mpVertexRing = nullptr;
 }
 
 
@@ -13,10 +15,12 @@ CGameText::~CGameText()
 {
 }
 
-bool CGameText::Initialise(ID3D11Device * device, ID3D11DeviceContext * deviceContext, HWND hWnd, int screenWidth, int screenHeight, D3DXMATRIX baseViewMatrix)
+bool CGameText::Initialise(ID3D11Device * device, ID3D11DeviceContext * deviceContext, CFrameRingBuffer* vertexRing, HWND hWnd, int screenWidth, int screenHeight, D3DXMATRIX baseViewMatrix)
 {
 	bool result;
 
+	mpVertexRing = vertexRing;
+
 	// Store the screen width and height.
 	mScreenWidth = screenWidth;
 	mScreenHeight = screenHeight;
@@ -124,9 +128,7 @@ bool CGameText::InitialiseSentence(SentenceType** sentence, int maxLength, ID3D1
 {
 	VertexType* vertices;
 	unsigned long* indices;
-	D3D11_BUFFER_DESC vertexBufferDesc;
 	D3D11_BUFFER_DESC indexBufferDesc;
-	D3D11_SUBRESOURCE_DATA vertexData;
 	D3D11_SUBRESOURCE_DATA indexData;
 	HRESULT result;
 
@@ -143,7 +145,8 @@ bool CGameText::InitialiseSentence(SentenceType** sentence, int maxLength, ID3D1
 	//mpSentences.push_back(sentence);
 
 	// Initialise buffer properties to be null.
-	(*sentence)->vertexBuffer = nullptr;
+	(*sentence)->vertices = nullptr;
+	(*sentence)->numberOfVertices = 0;
 	(*sentence)->indexBuffer = nullptr;
 
 	// Set max length of the sentence.
@@ -155,8 +158,9 @@ bool CGameText::InitialiseSentence(SentenceType** sentence, int maxLength, ID3D1
 	// Set the number of indexes in the index array to be equal to the number of vertices.
 	(*sentence)->indexCount = (*sentence)->vertexCount;
 
-	// Create vertex array.
+	// Create vertex array, it's kept for the life of the sentence so updating it doesn't allocate.
 	vertices = new VertexType[(*sentence)->vertexCount];
+	(*sentence)->vertices = vertices;
 	if (!vertices)
 	{
 		logger->GetInstance().WriteLine("Failed to allocate memory to the vertices buffer in GameText.cpp.");
@@ -179,28 +183,6 @@ bool CGameText::InitialiseSentence(SentenceType** sentence, int maxLength, ID3D1
 		indices[i] = i;
 	}
 
-	// Set up descriptor for vertex buffer
-	vertexBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	vertexBufferDesc.ByteWidth = sizeof(VertexType) * (*sentence)->vertexCount;
-	vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vertexBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	vertexBufferDesc.MiscFlags = 0;
-	vertexBufferDesc.StructureByteStride = 0;
-
-	// Pass subresource ptr to vertex data.
-	vertexData.pSysMem = vertices;
-	vertexData.SysMemPitch = 0;
-	vertexData.SysMemSlicePitch = 0;
-
-	// Create the buffer and store it in sentence objects properties.
-	result = device->CreateBuffer(&vertexBufferDesc, &vertexData, &(*sentence)->vertexBuffer);
-
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create the vertex buffer in DirectX after passing it vertex data in GameText.cpp.");
-		return false;
-	}
-
 	// Set up descriptor for index buffer.
 	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
 	indexBufferDesc.ByteWidth = sizeof(unsigned long) * (*sentence)->indexCount;
@@ -223,9 +205,6 @@ bool CGameText::InitialiseSentence(SentenceType** sentence, int maxLength, ID3D1
 		return false;
 	}
 
-	delete[] vertices;
-	vertices = nullptr;
-
 	delete[] indices;
 	indices = nullptr;
 
@@ -235,12 +214,8 @@ bool CGameText::InitialiseSentence(SentenceType** sentence, int maxLength, ID3D1
 bool CGameText::UpdateSentence(SentenceType* &sentence, std::string text, int posX, int posY, float red, float green, float blue, ID3D11DeviceContext* deviceContext)
 {
 	int numberOfLetters;
-	VertexType* vertices;
 	float x;
 	float y;
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	VertexType* verticesPtr;
 
 	// Store the colour which the sentence will be drawn in.
 	sentence->red = red;
@@ -257,47 +232,16 @@ bool CGameText::UpdateSentence(SentenceType* &sentence, std::string text, int po
 		return false;
 	}
 
-	// Create vertex array.
-	vertices = new VertexType[sentence->vertexCount];
-	
-	// Check vertices array was allocated memory.
-	if (!vertices)
-	{
-		logger->GetInstance().WriteLine("Failed to allocate memory to vertices array in GameText.cpp.");
-		return false;
-	}
-
-	// Initialise the array to be 0.
-	memset(vertices, 0, (sizeof(VertexType) * sentence->vertexCount));
+	// Only as many vertices as there are letters are drawn, spaces are left as zeroed out triangles.
+	sentence->numberOfVertices = 6 * numberOfLetters;
+	memset(sentence->vertices, 0, (sizeof(VertexType) * sentence->numberOfVertices));
 
 	// Calculate positions which we will draw the text.
 	x = (float)(((mScreenWidth / 2) * -1) + posX);
 	y = (float)((mScreenHeight / 2) - posY);
 
-	// Build the vertex array.
-	mpFont->BuildVertexArray((void*)vertices, text, x, y);
-
-	// Lock vertex array.
-	result = deviceContext->Map(sentence->vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to map the resource when updating sentence in GameText.cpp.");
-		return false;
-	}
-
-	// Grab pointer to data in vertex buffer.
-	verticesPtr = (VertexType*)mappedResource.pData;
-
-	// Copy the data into vertex buffer.
-	memcpy(verticesPtr, (void*)vertices, (sizeof(VertexType) * sentence->vertexCount));
-
-	// Unlock vertex buff.
-	deviceContext->Unmap(sentence->vertexBuffer, 0);
-
-	// Release vertex array.
-	delete[] vertices;
-	vertices = nullptr;
+	// Build the vertex array, it's copied to the GPU when the sentence is next drawn.
+	mpFont->BuildVertexArray(sentence->vertices, text, x, y);
 
 	return true;
 }
@@ -353,12 +297,10 @@ void CGameText::ReleaseSentence(SentenceType* sentence)
 {
 	if (sentence)
 	{
-		// Vertex buffer isn't null.
-		if ((sentence)->vertexBuffer)
+		if ((sentence)->vertices)
 		{
-			//delete[](sentence)->vertexBuffer;
-			sentence->vertexBuffer->Release();
-			(sentence)->vertexBuffer = nullptr;
+			delete[] static_cast<VertexType*>(sentence->vertices);
+			(sentence)->vertices = nullptr;
 		}
 
 		// Index buffer isn't null.
@@ -382,18 +324,29 @@ bool CGameText::RenderSentence(ID3D11DeviceContext * deviceContext, SentenceType
 	bool result;
 
 
-	// Set vertex buffer stride and offset.
+	// Nothing to draw for an empty sentence.
+	if (sentence->numberOfVertices == 0)
+	{
+		return true;
+	}
+
+	// Copy the vertices into this frame's part of the ring.
 	stride = sizeof(VertexType);
-	offset = 0;
+	if (!mpVertexRing->Write(sentence->vertices, stride * sentence->numberOfVertices, stride, offset))
+	{
+		logger->GetInstance().WriteLine("Failed to write a sentence into the vertex ring in GameText.cpp.");
+		return false;
+	}
 
 	// Set the vertex buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetVertexBuffers(0, 1, &sentence->vertexBuffer, &stride, &offset);
+	ID3D11Buffer* vertexBuffer = CD3D11RenderDevice::GetNativeBuffer(mpVertexRing->GetBuffer());
+	CStateCache::Get(deviceContext)->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
 
 	// Set the index buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetIndexBuffer(sentence->indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	CStateCache::Get(deviceContext)->IASetIndexBuffer(sentence->indexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
 	// Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	// Create a pixel color vector with the input sentence color.
 	pixelColor = D3DXVECTOR4(sentence->red, sentence->green, sentence->blue, 1.0f);
@@ -404,7 +357,7 @@ bool CGameText::RenderSentence(ID3D11DeviceContext * deviceContext, SentenceType
 	mpFontShader->SetViewProjMatrix(mBaseViewMatrix * orthoMatrix);
 
 	// Render the text using the font shader.
-	result = mpFontShader->Render(deviceContext, sentence->indexCount, mpFont->GetTexture(),
+	result = mpFontShader->Render(deviceContext, sentence->numberOfVertices, mpFont->GetTexture(),
 		pixelColor);
 	if (!result)
 	{
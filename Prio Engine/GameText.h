@@ -4,10 +4,13 @@
 #include "GameFont.h"
 #include "FontShader.h"
 #include "PrioEngineVars.h"
+#include "FrameRingBuffer.h"
 
 struct SentenceType
 {
-	ID3D11Buffer* vertexBuffer;
+	// Kept on the CPU and written into the vertex ring each time the sentence is drawn.
+	void* vertices;
+	int numberOfVertices;
 	ID3D11Buffer* indexBuffer;
 	int vertexCount;
 	int indexCount;
@@ -33,7 +36,7 @@ public:
 	~CGameText();
 
 public:
-	bool Initialise(ID3D11Device* device, ID3D11DeviceContext* deviceContext, HWND hWnd, int screenWidth, int screenHeight, D3DXMATRIX baseViewMatrix);
+	bool Initialise(ID3D11Device* device, ID3D11DeviceContext* deviceContext, CFrameRingBuffer* vertexRing, HWND hWnd, int screenWidth, int screenHeight, D3DXMATRIX baseViewMatrix);
 	void Shutdown();
 	bool Render(ID3D11DeviceContext* deviceContext, D3DXMATRIX worldMatrix, D3DXMATRIX orthoMatrix);
 	SentenceType* CreateSentence(ID3D11Device* device, ID3D11DeviceContext* deviceContext, std::string text, int posX, int posY, int maxLength);
@@ -46,6 +49,7 @@ private:
 private:
 	CGameFont* mpFont;
 	CFontShader* mpFontShader;
+	CFrameRingBuffer* mpVertexRing;
 	int mScreenWidth;
 	int mScreenHeight;
 	D3DXMATRIX mBaseViewMatrix;
@@ -1,4 +1,33 @@
 #include "Graphics.h"
+#include <algorithm>
+
+namespace
+{
+	const std::string kWaterRefractionPass = "Water refraction";
+	const std::string kWaterReflectionPass = "Water reflection";
+
+	/* Targets drawn smaller than the screen have a depth buffer of their own, the back buffer's won't fit them.
+	* @Returns ID3D11DepthStencilView* The depth buffer to draw into the target with. */
+	ID3D11DepthStencilView* GetTargetDepthStencil(CRenderTexture* target, ID3D11DepthStencilView* screenDepthStencil)
+	{
+		return target->GetDepthStencilView() != nullptr ? target->GetDepthStencilView() : screenDepthStencil;
+	}
+
+	int ScaleTargetSize(int screenSize, float scale)
+	{
+		return std::max(1, static_cast<int>(screenSize * scale));
+	}
+}
+
+namespace
+{
+	/* SFML copies the samples out of the file, so it only needs to stay open while the buffer is loaded. */
+	bool LoadSoundBuffer(sf::SoundBuffer* soundBuffer, const std::string& filename)
+	{
+		CVirtualFile file;
+		return file.Open(filename) && soundBuffer->loadFromMemory(file.GetData(), file.GetSize());
+	}
+}
 
 CGraphics::CGraphics()
 {
@@ -14,6 +43,24 @@ CGraphics::CGraphics()
 	mpText = nullptr;
 	mFullScreen = false;
 	mpFrustum = nullptr;
+	mpReflectionFrustum = nullptr;
+	mpRefractionFrustum = nullptr;
+	mpTransformSystem = nullptr;
+	mpThreadPool = nullptr;
+	mpVisibilitySystem = nullptr;
+	mpDrawList = nullptr;
+	mpSharedConstants = nullptr;
+	mpPassRecorder = nullptr;
+	mpFrameGraph = nullptr;
+	mpRefractionShader = nullptr;
+	mpReflectionShader = nullptr;
+	mReflectionVisibility = CFrameGraph::kNone;
+	mRefractionVisibility = CFrameGraph::kNone;
+	D3DXMatrixIdentity(&mWaterRefractionViewProj);
+	D3DXMatrixIdentity(&mWaterReflectionViewProj);
+	mpOcclusionCuller = nullptr;
+	mpResourceCache = nullptr;
+	mpAssetLoader = nullptr;
 	mpSkyboxShader = nullptr;
 	mpTerrain = nullptr;
 	mpSkybox = nullptr;
@@ -72,205 +119,339 @@ bool CGraphics::Initialise(int screenWidth, int screenHeight, HWND hwnd)
 		return false;
 	}
 
-	// Create a colour shader now, it's necessary for terrain.
-	CreateColourShader(hwnd);
-	CreateTextureShaderForModel(hwnd);
-	CreateTextureAndDiffuseLightShaderFromModel(hwnd);
-	CreateTerrainShader(hwnd);
+	mpThreadPool = new CThreadPool();
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpThreadPool).name());
 
 	mpFrustum = new CFrustum();
+	mpReflectionFrustum = new CFrustum();
+	mpRefractionFrustum = new CFrustum();
 
-	mpCamera = CreateCamera();
-	mpCamera->Render();
+	mpTransformSystem = new CTransformSystem();
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpTransformSystem).name());
 
-	//mpReflectionCamera = new CCamera(mScreenWidth, mScreenWidth, mFieldOfView, SCREEN_NEAR, SCREEN_DEPTH);
+	mpVisibilitySystem = new CVisibilitySystem(mpThreadPool);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpVisibilitySystem).name());
 
-	/// SET UP TEXT FROM CAMERA POS.
-	mpText = new CGameText();
+	mpOcclusionCuller = new COcclusionCuller(mpThreadPool);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpOcclusionCuller).name());
+
+	mpDrawList = new CDrawList();
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpDrawList).name());
 
-	if (!mpText)
+	mpSharedConstants = new CSharedConstants(mpD3D->GetRenderDevice());
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpSharedConstants).name());
+	if (!mpSharedConstants->Initialise())
 	{
-		logger->GetInstance().WriteLine("Failed to allocate memory to the GameText var in Graphics.cpp.");
+		logger->GetInstance().WriteLine("Failed to initialise the shared constants.");
 		return false;
 	}
 
-	D3DXMATRIX baseView;
-	mpCamera->GetViewMatrix(baseView);
-	if (!mpText->Initialise(mpD3D->GetDevice(), mpD3D->GetDeviceContext(), mHwnd, mScreenWidth, mScreenHeight, baseView))
+	mpPassRecorder = new CPassRecorder(mpD3D->GetRenderDevice(), mpThreadPool);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpPassRecorder).name());
+
+	mpFrameGraph = new CFrameGraph(mpD3D->GetDevice());
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpFrameGraph).name());
+
+	mpResourceCache = new CResourceCache();
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpResourceCache).name());
+
+	mpAssetLoader = new CAssetLoader(mpD3D->GetDevice(), mpResourceCache);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpAssetLoader).name());
+
+	mpCamera = CreateCamera();
+	mpCamera->Render();
+
+	//mpReflectionCamera = new CCamera(mScreenWidth, mScreenWidth, mFieldOfView, SCREEN_NEAR, SCREEN_DEPTH);
+
+	// The rest is almost all reading files and compiling shaders, none of which depends on the rest, so it's run as a
+	// graph of tasks across the thread pool. The device is free threaded so resources can be created on any thread, only
+	// steps which use the immediate context, or AntTweakBar and SFML's playing sounds, are kept to this thread.
+	CTaskGraph graph("Graphics initialisation");
+	ID3D11Device* device = mpD3D->GetDevice();
+
+	// Create a colour shader now, it's necessary for terrain.
+	graph.AddTask("Colour shader", [this, hwnd]() { return CreateColourShader(hwnd); });
+	graph.AddTask("Texture shader", [this, hwnd]() { return CreateTextureShaderForModel(hwnd); });
+	graph.AddTask("Diffuse light shader", [this, hwnd]() { return CreateTextureAndDiffuseLightShaderFromModel(hwnd); });
+	graph.AddTask("Terrain shader", [this, hwnd]() { return CreateTerrainShader(hwnd); });
+
+	/// SET UP TEXT FROM CAMERA POS.
+	graph.AddTask("Text", [this]()
 	{
-		logger->GetInstance().WriteLine("Failed to initailise the text object in graphics.cpp.");
-		return false;
-	}
-	mBaseView = baseView;
+		mpText = new CGameText();
 
-	logger->GetInstance().WriteLine("Setting up AntTweakBar.");
-	TwInit(TW_DIRECT3D11, mpD3D->GetDevice());
-	TwWindowSize(mScreenWidth, mScreenHeight);
-	logger->GetInstance().WriteLine("AntTweakBar successfully initialised. ");
+		if (!mpText)
+		{
+			logger->GetInstance().WriteLine("Failed to allocate memory to the GameText var in Graphics.cpp.");
+			return false;
+		}
 
-	//////////////////////////////////////////////
-	// Skybox shader
+		D3DXMATRIX baseView;
+		mpCamera->GetViewMatrix(baseView);
+		if (!mpText->Initialise(mpD3D->GetDevice(), mpD3D->GetDeviceContext(), mpD3D->GetVertexRing(), mHwnd, mScreenWidth, mScreenHeight, baseView))
+		{
+			logger->GetInstance().WriteLine("Failed to initailise the text object in graphics.cpp.");
+			return false;
+		}
+		mBaseView = baseView;
+		return true;
+	}, CTaskGraph::MainThread);
 
-	mpSkyboxShader = new CSkyboxShader();
-	if (!mpSkyboxShader)
+	graph.AddTask("AntTweakBar", [this]()
 	{
-		logger->GetInstance().WriteLine("Failed to allocate memory to the skybox shader.");
-		return false;
-	}
+		logger->GetInstance().WriteLine("Setting up AntTweakBar.");
+		TwInit(TW_DIRECT3D11, mpD3D->GetDevice());
+		TwWindowSize(mScreenWidth, mScreenHeight);
+		logger->GetInstance().WriteLine("AntTweakBar successfully initialised. ");
+		return true;
+	}, CTaskGraph::MainThread);
 
-	bool result = mpSkyboxShader->Initialise(mpD3D->GetDevice(), hwnd);
-	if (!result)
+	//////////////////////////////////////////////
+	// Skybox shader
+
+	graph.AddTask("Skybox shader", [this, device, hwnd]()
 	{
-		logger->GetInstance().WriteLine("Failed to initialise the skybox shader.");
-		return false;
-	}
+		mpSkyboxShader = new CSkyboxShader();
+		if (!mpSkyboxShader)
+		{
+			logger->GetInstance().WriteLine("Failed to allocate memory to the skybox shader.");
+			return false;
+		}
 
-	CreateSkybox();
+		if (!mpSkyboxShader->Initialise(device, hwnd))
+		{
+			logger->GetInstance().WriteLine("Failed to initialise the skybox shader.");
+			return false;
+		}
+		return true;
+	});
 
-	D3DXVECTOR4 horizonColour = mpSkybox->GetCenterColour();
+	const CTaskGraph::TaskId skybox = graph.AddTask("Skybox", [this]() { return CreateSkybox() != nullptr; });
 
-	// Set up the diffuse colour for the light.
-	D3DXVECTOR4 diffuseColour = horizonColour;
+	// The light takes its colour from the horizon of the skybox.
+	const CTaskGraph::TaskId light = graph.AddTask("Light", [this]()
+	{
+		D3DXVECTOR4 horizonColour = mpSkybox->GetCenterColour();
 
-	// Copy the colour of the horizon for the ambient colour.
-	D3DXVECTOR4 ambientColour = horizonColour;
+		// Set up the diffuse colour for the light.
+		D3DXVECTOR4 diffuseColour = horizonColour;
 
-	ambientColour.x *= mAmbientMultiplier;
-	ambientColour.y *= mAmbientMultiplier;
-	ambientColour.z *= mAmbientMultiplier;
-	ambientColour.w = 1.0f;
+		// Copy the colour of the horizon for the ambient colour.
+		D3DXVECTOR4 ambientColour = horizonColour;
 
-	// Set the direction of our light.
-	D3DXVECTOR3 direction(0.0f, 0.0f, 1.0f);
+		ambientColour.x *= mAmbientMultiplier;
+		ambientColour.y *= mAmbientMultiplier;
+		ambientColour.z *= mAmbientMultiplier;
+		ambientColour.w = 1.0f;
 
-	// Set up specular vairables for our light.
-	float specularPower = 0.1f;
-	D3DXVECTOR4 specularColour = ambientColour;
+		// Set the direction of our light.
+		D3DXVECTOR3 direction(0.0f, 0.0f, 1.0f);
 
-	mpSceneLight = CreateLight(diffuseColour, specularColour, specularPower, ambientColour, direction);
+		// Set up specular vairables for our light.
+		float specularPower = 0.1f;
+		D3DXVECTOR4 specularColour = ambientColour;
 
+		mpSceneLight = CreateLight(diffuseColour, specularColour, specularPower, ambientColour, direction);
+		return mpSceneLight != nullptr;
+	});
+	graph.AddDependency(light, skybox);
 
-	mpWaterShader = new CWaterShader();
-	if (!mpWaterShader->Initialise(mpD3D->GetDevice(), hwnd))
+	graph.AddTask("Water shader", [this, device, hwnd]()
 	{
-		logger->GetInstance().WriteSubtitle("Critical Error!");
-		logger->GetInstance().WriteLine("Failed to initialise the water shader, shutting down.");
-		logger->GetInstance().CloseSubtitle();
-
-		return false;
-	}
+		mpWaterShader = new CWaterShader();
+		if (!mpWaterShader->Initialise(device, hwnd))
+		{
+			logger->GetInstance().WriteSubtitle("Critical Error!");
+			logger->GetInstance().WriteLine("Failed to initialise the water shader, shutting down.");
+			logger->GetInstance().CloseSubtitle();
 
-	mpRefractionShader = new CReflectRefractShader();
+			return false;
+		}
+		return true;
+	});
 
-	if (!mpRefractionShader->Initialise(mpD3D->GetDevice(), hwnd))
+	graph.AddTask("Refraction shader", [this, device, hwnd]()
 	{
-		logger->GetInstance().WriteSubtitle("Critical Error!");
-		logger->GetInstance().WriteLine("Failed to initialise the refraction shader, shutting down.");
-		logger->GetInstance().CloseSubtitle();
-		return false;
-	}
+		mpRefractionShader = new CReflectRefractShader();
 
-	mpCloudPlane = new CCloudPlane();
-	if (!mpCloudPlane->Initialise(mpD3D->GetDevice(), "Resources/Textures/cloud1.dds", "Resources/Textures/cloud2.dds"))
-	{
-		logger->GetInstance().WriteLine("Failed to initialise the cloud plane in graphics class.");
-		return false;
-	}
+		if (!mpRefractionShader->Initialise(device, hwnd))
+		{
+			logger->GetInstance().WriteSubtitle("Critical Error!");
+			logger->GetInstance().WriteLine("Failed to initialise the refraction shader, shutting down.");
+			logger->GetInstance().CloseSubtitle();
+			return false;
+		}
+		return true;
+	});
 
-	mpCloudShader = new CCloudShader();
-	if (!mpCloudShader->Initialise(mpD3D->GetDevice(), hwnd))
+	graph.AddTask("Reflection shader", [this, device, hwnd]()
 	{
-		logger->GetInstance().WriteLine("Failed tto initialise the cloud shader in graphics class.");
-		return false;
-	}
+		mpReflectionShader = new CReflectRefractShader();
 
-	mpRain = new CRain();
-	if (!mpRain->Initialise(mpD3D->GetDevice(), "Resources/Textures/raindrop.dds", 150000))
+		if (!mpReflectionShader->Initialise(device, hwnd))
+		{
+			logger->GetInstance().WriteSubtitle("Critical Error!");
+			logger->GetInstance().WriteLine("Failed to initialise the reflection shader, shutting down.");
+			logger->GetInstance().CloseSubtitle();
+			return false;
+		}
+		return true;
+	});
+
+	graph.AddTask("Cloud plane", [this, device]()
 	{
-		logger->GetInstance().WriteLine("Failed to initialise the rain particle emitter.");
-		return false;
-	}
+		mpCloudPlane = new CCloudPlane();
+		if (!mpCloudPlane->Initialise(device, "Resources/Textures/cloud1.dds", "Resources/Textures/cloud2.dds"))
+		{
+			logger->GetInstance().WriteLine("Failed to initialise the cloud plane in graphics class.");
+			return false;
+		}
+		return true;
+	});
 
-		
-	mpRainShader = new CRainShader();
-	if (!mpRainShader->Initialise(mpD3D->GetDevice(), hwnd))
+	graph.AddTask("Cloud shader", [this, device, hwnd]()
 	{
-		logger->GetInstance().WriteLine("Failed to initialise the rain shader.");
-		return false;
-	}
+		mpCloudShader = new CCloudShader();
+		if (!mpCloudShader->Initialise(device, hwnd))
+		{
+			logger->GetInstance().WriteLine("Failed tto initialise the cloud shader in graphics class.");
+			return false;
+		}
+		return true;
+	});
 
-	mpSnow = new CSnow();
-	if (!mpSnow->Initialise(mpD3D->GetDevice(), "Resources/Textures/raindrop.dds", 1500000))
+	graph.AddTask("Rain", [this, device]()
 	{
-		logger->GetInstance().WriteLine("Failed to initialise the snow particle emitter.");
-		return false;
-	}
+		mpRain = new CRain();
+		if (!mpRain->Initialise(device, "Resources/Textures/raindrop.dds", 150000))
+		{
+			logger->GetInstance().WriteLine("Failed to initialise the rain particle emitter.");
+			return false;
+		}
+		return true;
+	});
 
-	mpSnowShader = new CSnowShader();
-	if (!mpSnowShader->Initialise(mpD3D->GetDevice(), hwnd))
+	graph.AddTask("Rain shader", [this, device, hwnd]()
 	{
-		logger->GetInstance().WriteLine("Failed to initialise the snow shader.");
-		return false;
-	}
+		mpRainShader = new CRainShader();
+		if (!mpRainShader->Initialise(device, hwnd))
+		{
+			logger->GetInstance().WriteLine("Failed to initialise the rain shader.");
+			return false;
+		}
+		return true;
+	});
 
-	mpFoliageShader = new CFoliageShader();
-	if (!mpFoliageShader->Initialise(mpD3D->GetDevice(), hwnd))
+	graph.AddTask("Snow", [this, device]()
 	{
-		logger->GetInstance().WriteLine("Failed to initialise the foliage shader.");
-		return false;
-	}
+		mpSnow = new CSnow();
+		if (!mpSnow->Initialise(device, "Resources/Textures/raindrop.dds", 1500000))
+		{
+			logger->GetInstance().WriteLine("Failed to initialise the snow particle emitter.");
+			return false;
+		}
+		return true;
+	});
 
-	mpCamera->SetPosition(0.0f, 50.0f, 20.0f);
+	graph.AddTask("Snow shader", [this, device, hwnd]()
+	{
+		mpSnowShader = new CSnowShader();
+		if (!mpSnowShader->Initialise(device, hwnd))
+		{
+			logger->GetInstance().WriteLine("Failed to initialise the snow shader.");
+			return false;
+		}
+		return true;
+	});
 
-	mpReflectionCamera = new CCamera(mScreenWidth, mScreenHeight, mFieldOfView, SCREEN_NEAR, SCREEN_DEPTH);
+	graph.AddTask("Foliage shader", [this, device, hwnd]()
+	{
+		mpFoliageShader = new CFoliageShader();
+		if (!mpFoliageShader->Initialise(device, hwnd))
+		{
+			logger->GetInstance().WriteLine("Failed to initialise the foliage shader.");
+			return false;
+		}
+		return true;
+	});
 
 	///////////////////////////////
-	// Rain storm sound setup
+	// Sound setup
 	//////////////////////////////
 
-	mpRainSoundBuffer = new sf::SoundBuffer();
-	if (!mpRainSoundBuffer->loadFromFile("Resources/Sounds/RainStorm.wav"))
+	// Decoding the files can happen anywhere, the sounds which play them are set up together once they're all loaded.
+	const CTaskGraph::TaskId rainSoundBuffer = graph.AddTask("Rain storm sound", [this]()
 	{
-		logger->GetInstance().WriteLine("Failed to load RainStorm.wav from file into a sound buffer.");
-		return false;
-	}
-	mpRainSound = new sf::Sound();
-	mpRainSound->setBuffer(*mpRainSoundBuffer);
-	mpRainSound->setLoop(true);
-	mpRainSound->setVolume(30.0f);
-	//mpRainSound->play();
+		mpRainSoundBuffer = new sf::SoundBuffer();
+		if (!LoadSoundBuffer(mpRainSoundBuffer, "Resources/Sounds/RainStorm.wav"))
+		{
+			logger->GetInstance().WriteLine("Failed to load RainStorm.wav from file into a sound buffer.");
+			return false;
+		}
+		return true;
+	});
 
-	//////////////////////////////
-	// Bird squawk sound setup
-	//////////////////////////////
+	const CTaskGraph::TaskId birdSquawkSoundBuffer = graph.AddTask("Bird squawk sound", [this]()
+	{
+		mpBirdSquawkSoundBuffer = new sf::SoundBuffer();
+		if (!LoadSoundBuffer(mpBirdSquawkSoundBuffer, "Resources/Sounds/Merlin-Squawk.wav"))
+		{
+			logger->GetInstance().WriteLine("Failed to load Merlin-Squawk.wav from file into a sound buffer.");
+			return false;
+		}
+		return true;
+	});
 
-	mpBirdSquawkSoundBuffer = new sf::SoundBuffer();
-	if (!mpBirdSquawkSoundBuffer->loadFromFile("Resources/Sounds/Merlin-Squawk.wav"))
+	const CTaskGraph::TaskId runningWaterSoundBuffer = graph.AddTask("Running water sound", [this]()
 	{
-		logger->GetInstance().WriteLine("Failed to load Merlin-Squawk.wav from file into a sound buffer.");
-		return false;
-	}
-	mpBirdSquawkSound = new sf::Sound();
-	mpBirdSquawkSound->setBuffer(*mpBirdSquawkSoundBuffer);
-	mpBirdSquawkSound->setLoop(false);
-	mpBirdSquawkSound->setVolume(25.0f);
+		mpRunningWaterSoundBuffer = new sf::SoundBuffer();
+		if (!LoadSoundBuffer(mpRunningWaterSoundBuffer, "Resources/Sounds/Liquid.wav"))
+		{
+			logger->GetInstance().WriteLine("Failed to load Liquid.wav from file into a sound buffer.");
+			return false;
+		}
+		return true;
+	});
+
+	const CTaskGraph::TaskId sounds = graph.AddTask("Sounds", [this]()
+	{
+		mpRainSound = new sf::Sound();
+		mpRainSound->setBuffer(*mpRainSoundBuffer);
+		mpRainSound->setLoop(true);
+		mpRainSound->setVolume(30.0f);
+		//mpRainSound->play();
+
+		mpBirdSquawkSound = new sf::Sound();
+		mpBirdSquawkSound->setBuffer(*mpBirdSquawkSoundBuffer);
+		mpBirdSquawkSound->setLoop(false);
+		mpBirdSquawkSound->setVolume(25.0f);
+
+		mpRunningWaterSound = new sf::Sound();
+		mpRunningWaterSound->setBuffer(*mpRunningWaterSoundBuffer);
+		mpRunningWaterSound->setLoop(true);
+		mpRunningWaterSound->setVolume(50.0f);
+		mpRunningWaterSound->play();
+		return true;
+	}, CTaskGraph::MainThread);
+	graph.AddDependency(sounds, rainSoundBuffer);
+	graph.AddDependency(sounds, birdSquawkSoundBuffer);
+	graph.AddDependency(sounds, runningWaterSoundBuffer);
 
-	//////////////////////////////
-	// Running water sound setup
-	//////////////////////////////
+	successful = graph.Run(mpThreadPool);
+	graph.LogTimings();
 
-	mpRunningWaterSoundBuffer = new sf::SoundBuffer();
-	if (!mpRunningWaterSoundBuffer->loadFromFile("Resources/Sounds/Liquid.wav"))
+	// Every shader has been asked for by now, so the manifest lists all of them for -shaders.
+	CShaderCache::GetInstance().LogStatistics();
+	CShaderCache::GetInstance().SaveManifest();
+	if (!successful)
 	{
-		logger->GetInstance().WriteLine("Failed to load Liquid.wav from file into a sound buffer.");
+		logger->GetInstance().WriteLine("Failed to initialise the graphics, see above for the step which failed.");
 		return false;
 	}
-	mpRunningWaterSound = new sf::Sound();
-	mpRunningWaterSound->setBuffer(*mpRunningWaterSoundBuffer);
-	mpRunningWaterSound->setLoop(true);
-	mpRunningWaterSound->setVolume(50.0f);
-	mpRunningWaterSound->play();
 
+	mpCamera->SetPosition(0.0f, 50.0f, 20.0f);
+
+	mpReflectionCamera = new CCamera(mScreenWidth, mScreenHeight, mFieldOfView, SCREEN_NEAR, SCREEN_DEPTH);
 
 	// Success!
 	logger->GetInstance().WriteLine("Direct3D was successfully initialised.");
@@ -410,6 +591,18 @@ void CGraphics::Shutdown()
 		delete mpFrustum;
 	}
 
+	if (mpReflectionFrustum != nullptr)
+	{
+		delete mpReflectionFrustum;
+		mpReflectionFrustum = nullptr;
+	}
+
+	if (mpRefractionFrustum != nullptr)
+	{
+		delete mpRefractionFrustum;
+		mpRefractionFrustum = nullptr;
+	}
+
 	mpUIImages.clear();
 
 	if (mpDiffuseLightShader)
@@ -470,6 +663,66 @@ void CGraphics::Shutdown()
 	}
 	mpMeshes.clear();
 
+	if (mpOcclusionCuller)
+	{
+		delete mpOcclusionCuller;
+		mpOcclusionCuller = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpOcclusionCuller).name());
+	}
+
+	if (mpDrawList)
+	{
+		delete mpDrawList;
+		mpDrawList = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpDrawList).name());
+	}
+
+	if (mpFrameGraph)
+	{
+		mpFrameGraph->LogTimings();
+		mpFrameGraph->Shutdown();
+		delete mpFrameGraph;
+		mpFrameGraph = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpFrameGraph).name());
+	}
+
+	if (mpPassRecorder)
+	{
+		mpPassRecorder->Shutdown();
+		delete mpPassRecorder;
+		mpPassRecorder = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpPassRecorder).name());
+	}
+
+	if (mpSharedConstants)
+	{
+		mpSharedConstants->Shutdown();
+		delete mpSharedConstants;
+		mpSharedConstants = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpSharedConstants).name());
+	}
+
+	if (mpVisibilitySystem)
+	{
+		delete mpVisibilitySystem;
+		mpVisibilitySystem = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpVisibilitySystem).name());
+	}
+
+	if (mpThreadPool)
+	{
+		delete mpThreadPool;
+		mpThreadPool = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpThreadPool).name());
+	}
+
+	if (mpTransformSystem)
+	{
+		delete mpTransformSystem;
+		mpTransformSystem = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpTransformSystem).name());
+	}
+
 	if (mpSceneLight)
 	{
 		delete mpSceneLight;
@@ -506,6 +759,29 @@ void CGraphics::Shutdown()
 		mpRefractionShader = nullptr;
 	}
 
+	if (mpReflectionShader)
+	{
+		mpReflectionShader->Shutdown();
+		delete mpReflectionShader;
+		mpReflectionShader = nullptr;
+	}
+
+	// Anything still loading has been cancelled by its owner by now, whatever the workers finish is thrown away.
+	if (mpAssetLoader)
+	{
+		delete mpAssetLoader;
+		mpAssetLoader = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpAssetLoader).name());
+	}
+
+	// Everything sharing textures through the cache has handed them back by now.
+	if (mpResourceCache)
+	{
+		delete mpResourceCache;
+		mpResourceCache = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpResourceCache).name());
+	}
+
 	// If the Direct 3D object exists.
 	if (mpD3D)
 	{
@@ -525,6 +801,9 @@ bool CGraphics::Frame(float updateTime)
 {
 	bool success;
 
+	// Textures and meshes which finished loading since last frame get their device resources before anything is drawn.
+	mpAssetLoader->Update();
+
 	UpdateScene(updateTime);
 
 	// Render the graphics scene.
@@ -558,6 +837,20 @@ void CGraphics::UpdateScene(float updateTime)
 		primitive->UpdateMatrices();
 	}
 
+	// Rebuild world matrices for any models which moved, static scenery costs nothing here.
+	mpTransformSystem->Update();
+
+	// Bake any static batches which have had instances added, now their world matrices are up to date.
+	mRenderingMeshes = true;
+	for (auto mesh : mpMeshes)
+	{
+		if (!mesh->UpdateStaticBatches())
+		{
+			logger->GetInstance().WriteLine("Failed to bake the static batches of a mesh.");
+		}
+	}
+	mRenderingMeshes = false;
+
 	mpCloudPlane->Update(updateTime);
 
 	if (mpTerrain)
@@ -694,10 +987,75 @@ bool CGraphics::Render()
 
 	mpFrustum->ConstructFrustum(SCREEN_DEPTH, projMatrix, viewMatrix);
 
+	// The light, time and camera are written once for the whole frame, and the main camera is the pass until a pass
+	// drawn from somewhere else replaces it.
+	if (!SetFrameConstants())
+		return false;
+
+	if (!mpSharedConstants->SetPassConstants(viewMatrix, projMatrix, D3DXVECTOR4(0.0f, 0.0f, 0.0f, 0.0f), static_cast<float>(mScreenWidth), static_cast<float>(mScreenHeight)))
+		return false;
+
+	// Rasterise the terrain into the occlusion buffer so scenery hidden behind hills can be skipped.
+	COcclusionCuller* occlusionCuller = nullptr;
+	if (mpTerrain != nullptr && !mpTerrain->GetUpdateFlag())
+	{
+		D3DXMATRIX terrainWorld;
+		mpTerrain->GetWorldMatrix(terrainWorld);
+		mpOcclusionCuller->UpdateOccluder(mpTerrain);
+		mpOcclusionCuller->Rasterise(terrainWorld, viewProj);
+		occlusionCuller = mpOcclusionCuller;
+	}
+
+	// The water passes are worked out before culling, so the reflection and refraction are only culled if their passes survived pruning.
+	AddWaterPasses(viewMatrix, projMatrix, viewProj, reflectionView);
+
+	// Cull every mesh instance once up front, testing each view in the same pass over the scene. The reflection and
+	// refraction only keep their own side of the water, padded by the height of the waves. Refraction is seen from the
+	// main camera so can use its occluders, but the reflected camera can see things hidden from the main one.
+	mRenderingMeshes = true;
+	const float projectionScale = 1.0f / tanf(mFieldOfView * 0.5f);
+	mpVisibilitySystem->SetView(CVisibilitySystem::MainView, mpFrustum, mpCamera->GetPosition(), projectionScale, occlusionCuller);
+
+	const bool cullReflection = mpFrameGraph->IsResourceUsed(mReflectionVisibility);
+	const bool cullRefraction = mpFrameGraph->IsResourceUsed(mRefractionVisibility);
+	float waterSurfaceY = 0.0f;
+	float waveHeight = 0.0f;
+	if (cullReflection || cullRefraction)
+	{
+		waterSurfaceY = mpTerrain->GetWater()->GetPosY();
+		waveHeight = mpTerrain->GetWater()->GetWaveHeight() * mpTerrain->GetWater()->GetWaveScale();
+	}
+
+	if (cullReflection)
+	{
+		D3DXMATRIX reflectionCameraView;
+		mpReflectionCamera->GetReflectionView(reflectionCameraView);
+		mpReflectionFrustum->ConstructFrustum(SCREEN_DEPTH, projMatrix, reflectionCameraView);
+		mpReflectionFrustum->SetClipPlane(D3DXPLANE(0.0f, 1.0f, 0.0f, -(waterSurfaceY - waveHeight)));
+		mpVisibilitySystem->SetView(CVisibilitySystem::ReflectionView, mpReflectionFrustum, mpReflectionCamera->GetPosition(), projectionScale);
+	}
+	else
+	{
+		mpVisibilitySystem->DisableView(CVisibilitySystem::ReflectionView);
+	}
+
+	if (cullRefraction)
+	{
+		mpRefractionFrustum->ConstructFrustum(SCREEN_DEPTH, projMatrix, viewMatrix);
+		mpRefractionFrustum->SetClipPlane(D3DXPLANE(0.0f, -1.0f, 0.0f, waterSurfaceY + waveHeight));
+		mpVisibilitySystem->SetView(CVisibilitySystem::RefractionView, mpRefractionFrustum, mpCamera->GetPosition(), projectionScale, occlusionCuller);
+	}
+	else
+	{
+		mpVisibilitySystem->DisableView(CVisibilitySystem::RefractionView);
+	}
+	mpVisibilitySystem->Cull(mpMeshes);
+	mRenderingMeshes = false;
+
 	if (!RenderSkybox(worldMatrix, viewMatrix, projMatrix, viewProj))
 		return false;
 
-	if (!RenderModels(worldMatrix, viewMatrix, projMatrix, viewProj, reflectionView))
+	if (!RenderModels(worldMatrix, viewMatrix, projMatrix, viewProj))
 		return false;
 
 	if (!RenderBitmaps(mBaseView, mBaseView, orthoMatrix, viewProj))
@@ -762,6 +1120,39 @@ bool CGraphics::RenderPrimitives(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX p
 	return true;
 }
 
+/* Write the constants which stay the same for every draw this frame, shared by every shader.
+* @Returns bool False if the shared constants couldn't be written. */
+bool CGraphics::SetFrameConstants()
+{
+	CSharedConstants::FrameConstants frameConstants = {};
+
+	// The vectors' constructors leave them unset, so without a light they're cleared by hand.
+	if (mpSceneLight)
+	{
+		frameConstants.ambientColour = mpSceneLight->GetAmbientColour();
+		frameConstants.diffuseColour = mpSceneLight->GetDiffuseColour();
+		frameConstants.specularColour = mpSceneLight->GetSpecularColour();
+		frameConstants.lightDirection = mpSceneLight->GetDirection();
+		frameConstants.specularPower = mpSceneLight->GetSpecularPower();
+		frameConstants.lightPosition = mpSceneLight->GetPos();
+	}
+	else
+	{
+		frameConstants.ambientColour = D3DXVECTOR4(0.0f, 0.0f, 0.0f, 0.0f);
+		frameConstants.diffuseColour = D3DXVECTOR4(0.0f, 0.0f, 0.0f, 0.0f);
+		frameConstants.specularColour = D3DXVECTOR4(0.0f, 0.0f, 0.0f, 0.0f);
+		frameConstants.lightDirection = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+		frameConstants.lightPosition = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	}
+
+	frameConstants.frameTime = mFrameTime;
+	frameConstants.eyePosition = mpCamera->GetPosition();
+	frameConstants.windStrength = 1.0f;
+	frameConstants.windDirection = mWindDirection;
+
+	return mpSharedConstants->SetFrameConstants(frameConstants);
+}
+
 /* Render any meshes / instances of meshes which we have created on the scene. */
 bool CGraphics::RenderMeshes(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
 {
@@ -774,19 +1165,25 @@ bool CGraphics::RenderMeshes(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj,
 
 	mRenderingMeshes = true;
 
-	mpDiffuseLightShader->SetViewMatrix(view);
-	mpDiffuseLightShader->SetProjMatrix(proj);
-	mpDiffuseLightShader->SetViewProjMatrix(viewProj);
-
-	// Render any models which belong to each mesh. Do this in batches to make it faster.
+	// Queue the visible instances of every mesh, then sort them so each pipeline and material is only bound once. The
+	// camera and the light are already in the shared constants, only each world matrix is written as they're drawn.
+	mpDrawList->Clear();
 	for (auto mesh : mpMeshes)
 	{
-		mesh->Render(mpD3D->GetDeviceContext(), mpFrustum, mpDiffuseLightShader, mpSceneLight, mpCamera->GetPosition());
+		mesh->AddToDrawList(mpDrawList, CVisibilitySystem::MainView, mpDiffuseLightShader, mpSharedConstants, mpCamera->GetPosition());
+	}
+	mpDrawList->Sort();
+
+	// Big lists are split into runs which are recorded on the workers at the same time, small ones aren't worth it.
+	const bool result = mpDrawList->Submit(mpD3D->GetRenderDevice(), mpPassRecorder, mpThreadPool->GetNumberOfThreads() + 1);
+	if (!result)
+	{
+		logger->GetInstance().WriteLine("Failed to record the mesh draws across the workers.");
 	}
 
 	mRenderingMeshes = false;
 
-	return true;
+	return result;
 }
 
 /* Render the terrain and all areas inside of it. */
@@ -823,9 +1220,6 @@ bool CGraphics::RenderTerrains(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX pro
 			mpTerrain->GetNumberOfGrassTextures(),
 			mpTerrain->GetRockTextureArray(),
 			mpTerrain->GetNumberOfRockTextures(),
-			mpSceneLight->GetDirection(),
-			mpSceneLight->GetDiffuseColour(),
-			mpSceneLight->GetAmbientColour(),
 			mpTerrain->GetHighestPoint(),
 			mpTerrain->GetLowestPoint(),
 			mpTerrain->GetPos(),
@@ -921,9 +1315,9 @@ bool CGraphics::RenderSkybox(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj,
 }
 
 /* Renders physical entities within the scene. */
-bool CGraphics::RenderModels(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj, D3DXMATRIX reflectionViewProj)
+bool CGraphics::RenderModels(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
 {
-	if (!RenderWater(world, view, proj, viewProj, reflectionViewProj))
+	if (!RenderWater())
 		return false;
 
 	if (!RenderPrimitives(world, view, proj, viewProj))
@@ -1122,49 +1516,221 @@ CSkyBox * CGraphics::CreateSkybox()
 }
 
 
-bool CGraphics::RenderWater(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj, D3DXMATRIX reflectionView)
+/* Describe the water as a frame graph: the height of the surface, what can be seen through it, what it reflects, then the
+* surface itself. The surface only reads the maps which contribute to its colour, so refraction and reflection are pruned
+* when there's no light to draw them with or their strength is zero, and the height with them once nothing reads it.
+* Nothing is added when the water is off screen, so none of the scene is drawn again for it.
+* Refraction and reflection are drawn at a fraction of the screen size into history targets, and each is only redrawn
+* once every few frames, on different frames to the other so the cost is spread out. The surface reprojects whatever
+* was last drawn using the camera it was drawn from. Both are redrawn straight away if the water wasn't drawn last frame.
+* The graph only queues the height, refraction and reflection on the pass recorder, which records them across the
+* workers at the start of the surface pass, so the graph times all of them as part of the surface. Those passes are
+* marked deferred, so the graph holds on to their targets until they've been recorded. */
+void CGraphics::AddWaterPasses(D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj, D3DXMATRIX reflectionViewProj)
 {
+	mpFrameGraph->Reset();
+	mReflectionVisibility = CFrameGraph::kNone;
+	mRefractionVisibility = CFrameGraph::kNone;
+	const bool drawnLastFrame = mWaterDrawnLastFrame;
+	mWaterDrawnLastFrame = false;
+
+	// Compiled straight away, so an empty graph is run if the water is skipped below.
+	mpFrameGraph->Compile();
+
 	if (mpTerrain == nullptr)
 	{
 		logger->GetInstance().WriteLine("Skipping water as there's nothing to render.");
-		return true;
+		return;
 	}
 
 	if (mpTerrain->GetWater() == nullptr)
 	{
 		logger->GetInstance().WriteLine("No body of water exists for this terrain yet, skipping render pass.");
-		return true;
+		return;
 	}
 
 	if (mpTerrain->GetUpdateFlag())
 	{
 		logger->GetInstance().WriteLine("Skipping render pass for water as the terrain is currently being updated.");
-		return true;
+		return;
 	}
 
 	if (mpFoliage == nullptr)
 	{
 		logger->GetInstance().WriteLine("Foliage is not available, skipping render pass for water.");
-		return true;
+		return;
 	}
 
 	if (mpFoliage->IsUpdating())
 	{
 		logger->GetInstance().WriteLine("Foliage is not available, skipping render pass for water.");
+		return;
+	}
+
+	CWater* water = mpTerrain->GetWater();
+	if (!mpFrustum->CheckSphere(water->GetBoundsCentre(), water->GetBoundsRadius()))
+	{
+		return;
+	}
+
+	const int refractionWidth = ScaleTargetSize(mScreenWidth, mWaterRefractionScale);
+	const int refractionHeight = ScaleTargetSize(mScreenHeight, mWaterRefractionScale);
+	const int reflectionWidth = ScaleTargetSize(mScreenWidth, mWaterReflectionScale);
+	const int reflectionHeight = ScaleTargetSize(mScreenHeight, mWaterReflectionScale);
+	// Only ever sampled by the refraction and reflection passes, so it needn't be any bigger than the larger of the two.
+	const int heightWidth = std::max(refractionWidth, reflectionWidth);
+	const int heightHeight = std::max(refractionHeight, reflectionHeight);
+
+	const CFrameGraph::TargetDesc heightDesc = { heightWidth, heightHeight, DXGI_FORMAT_R32_FLOAT, heightWidth != mScreenWidth || heightHeight != mScreenHeight };
+	const CFrameGraph::TargetDesc refractionDesc = { refractionWidth, refractionHeight, DXGI_FORMAT_R8G8B8A8_UNORM, refractionWidth != mScreenWidth || refractionHeight != mScreenHeight };
+	const CFrameGraph::TargetDesc reflectionDesc = { reflectionWidth, reflectionHeight, DXGI_FORMAT_R8G8B8A8_UNORM, reflectionWidth != mScreenWidth || reflectionHeight != mScreenHeight };
+
+	const CFrameGraph::ResourceId height = mpFrameGraph->CreateTarget("Water height", heightDesc);
+	const CFrameGraph::ResourceId refraction = mpFrameGraph->CreateHistoryTarget(kWaterRefractionPass, refractionDesc);
+	const CFrameGraph::ResourceId reflection = mpFrameGraph->CreateHistoryTarget(kWaterReflectionPass, reflectionDesc);
+	mRefractionVisibility = mpFrameGraph->CreateVirtual("Refraction view visibility");
+	mReflectionVisibility = mpFrameGraph->CreateVirtual("Reflection view visibility");
+
+	CFrameGraph::PassId heightPass = mpFrameGraph->AddPass("Water height", [=]()
+	{
+		CRenderTexture* heightTarget = mpFrameGraph->GetTarget(height);
+		mpPassRecorder->AddPass([=](CRenderDevice* renderDevice)
+		{
+			return RenderWaterHeight(renderDevice, heightTarget, view, proj, viewProj);
+		});
 		return true;
+	});
+	mpFrameGraph->Write(heightPass, height);
+	mpFrameGraph->SetDeferred(heightPass);
+
+	// Two requirements for refraction and reflection are a light and terrain.
+	const bool refracts = mpSceneLight != nullptr && water->GetRefractionStrength() > 0.0f;
+	const bool reflects = mpSceneLight != nullptr && water->GetReflectionStrength() > 0.0f;
+
+	// Half an interval apart, so with the default of two the maps take it in turns.
+	mWaterFrame++;
+	const bool refractionDue = mWaterFrame % mWaterUpdateInterval == 0 || !mpFrameGraph->IsHistoryValid(refraction) || !drawnLastFrame;
+	const bool reflectionDue = (mWaterFrame + mWaterUpdateInterval / 2) % mWaterUpdateInterval == 0 || !mpFrameGraph->IsHistoryValid(reflection) || !drawnLastFrame;
+	mWaterDrawnLastFrame = true;
+
+	if (refracts && refractionDue)
+	{
+		CFrameGraph::PassId refractionPass = mpFrameGraph->AddPass(kWaterRefractionPass, [=]()
+		{
+			CRenderTexture* heightMap = mpFrameGraph->GetTarget(height);
+			CRenderTexture* refractionTarget = mpFrameGraph->GetTarget(refraction);
+			for (auto mesh : mpMeshes)
+			{
+				mesh->UpdateMatrices(CVisibilitySystem::RefractionView);
+			}
+			mpPassRecorder->AddPass([=](CRenderDevice* renderDevice)
+			{
+				return RenderWaterRefraction(renderDevice, heightMap, refractionTarget, view, proj, viewProj);
+			});
+			return true;
+		});
+		mpFrameGraph->Read(refractionPass, height);
+		mpFrameGraph->Read(refractionPass, mRefractionVisibility);
+		mpFrameGraph->Write(refractionPass, refraction);
+		mpFrameGraph->SetDeferred(refractionPass);
+		mWaterRefractionViewProj = viewProj;
+	}
+	else if (refracts)
+	{
+		mpFrameGraph->SkipPass(kWaterRefractionPass);
+	}
+
+	if (reflects && reflectionDue)
+	{
+		CFrameGraph::PassId reflectionPass = mpFrameGraph->AddPass(kWaterReflectionPass, [=]()
+		{
+			CRenderTexture* heightMap = mpFrameGraph->GetTarget(height);
+			CRenderTexture* reflectionTarget = mpFrameGraph->GetTarget(reflection);
+			for (auto mesh : mpMeshes)
+			{
+				mesh->UpdateMatrices(CVisibilitySystem::ReflectionView);
+			}
+			mpPassRecorder->AddPass([=](CRenderDevice* renderDevice)
+			{
+				return RenderWaterReflection(renderDevice, heightMap, reflectionTarget, view, proj, reflectionViewProj);
+			});
+			return true;
+		});
+		mpFrameGraph->Read(reflectionPass, height);
+		mpFrameGraph->Read(reflectionPass, mReflectionVisibility);
+		mpFrameGraph->Write(reflectionPass, reflection);
+		mpFrameGraph->SetDeferred(reflectionPass);
+		// The reflection is looked up from where the water was on the main camera's screen, not the reflected one's.
+		mWaterReflectionViewProj = viewProj;
+	}
+	else if (reflects)
+	{
+		mpFrameGraph->SkipPass(kWaterReflectionPass);
+	}
+
+	const D3DXMATRIX refractionViewProj = mWaterRefractionViewProj;
+	const D3DXMATRIX reflectionMapViewProj = mWaterReflectionViewProj;
+	CFrameGraph::PassId surfacePass = mpFrameGraph->AddPass("Water surface", [=]()
+	{
+		if (!RecordWaterPasses())
+		{
+			return false;
+		}
+
+		CRenderTexture* refractionMap = refracts ? mpFrameGraph->GetTarget(refraction) : nullptr;
+		CRenderTexture* reflectionMap = reflects ? mpFrameGraph->GetTarget(reflection) : nullptr;
+		mpWaterShader->SetReprojection(refractionViewProj, reflectionMapViewProj);
+		return RenderWaterSurface(refractionMap, reflectionMap, view, proj, viewProj);
+	});
+	mpFrameGraph->SetSideEffect(surfacePass);
+	if (refracts)
+	{
+		mpFrameGraph->Read(surfacePass, refraction);
+	}
+	if (reflects)
+	{
+		mpFrameGraph->Read(surfacePass, reflection);
 	}
 
+	mpFrameGraph->Compile();
+}
 
-	bool result = true;
+bool CGraphics::RenderWater()
+{
+	const bool result = mpFrameGraph->Execute();
 
-	// Reset the world matrix.
-	mpD3D->GetWorldMatrix(world);
+	// A pass which failed stops the graph before the surface, leaving whatever was queued before it unrecorded.
+	mpPassRecorder->Discard();
 
-	/////////////////////////////////
-	// Height
-	////////////////////////////////
+	return result;
+}
 
+/* Record the passes the graph queued so far, one on each worker, and execute them in the order they were queued.
+* The graph held on to every target they use, as they were deferred, and can only hand them back to its pool now.
+* @Returns bool False if any of the passes failed to record, in which case none of them were drawn. */
+bool CGraphics::RecordWaterPasses()
+{
+	mRenderingMeshes = true;
+	const bool result = mpPassRecorder->Execute();
+	mRenderingMeshes = false;
+	mpFrameGraph->FlushDeferredReleases();
+
+	if (!result)
+	{
+		logger->GetInstance().WriteLine("Failed to record the water passes.");
+	}
+
+	return result;
+}
+
+void CGraphics::SetWaterShaderProperties(D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
+{
+	D3DXMATRIX world;
 	D3DXMATRIX camWorld;
+
+	// Reset the world matrix.
+	mpD3D->GetWorldMatrix(world);
+
 	mpWaterShader->SetWorldMatrix(world);
 	mpWaterShader->SetViewMatrix(view);
 	mpWaterShader->SetProjMatrix(proj);
@@ -1181,254 +1747,263 @@ bool CGraphics::RenderWater(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj,
 	mpWaterShader->SetCameraMatrix(camWorld);
 	mpWaterShader->SetCameraPosition(mpCamera->GetPosition());
 	mpWaterShader->SetViewportSize(mScreenWidth, mScreenHeight);
-	mpWaterShader->SetLightProperties(mpSceneLight);
 	mpWaterShader->SetNormalMap(mpTerrain->GetWater()->GetNormalMap());
+}
+
+void CGraphics::SetReflectRefractTerrainProperties(CReflectRefractShader* shader, CRenderTexture* heightMap, CRenderTexture* target)
+{
+	shader->SetViewportProperties(target->GetWidth(), target->GetHeight());
+	shader->SetTerrainAreaProperties(mpTerrain->GetSnowHeight(), mpTerrain->GetGrassHeight(), mpTerrain->GetDirtHeight(), mpTerrain->GetSandHeight());
+	shader->SetPositioningProperties(mpTerrain->GetPosY(), mpTerrain->GetWater()->GetPosY() + mpTerrain->GetWater()->GetDepth());
+	shader->SetWaterHeightmap(heightMap->GetShaderResourceView());
+	shader->SetDirtTextureArray(mpTerrain->GetTexturesArray());
+	shader->SetGrassTextureArray(mpTerrain->GetGrassTextureArray());
+	shader->SetPatchMap(mpTerrain->GetPatchMap());
+	shader->SetRockTexture(mpTerrain->GetRockTextureArray());
+}
+
+bool CGraphics::RenderWaterHeight(CRenderDevice* renderDevice, CRenderTexture* heightTarget, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
+{
+	D3DXMATRIX world;
+	ID3D11DeviceContext* context = CD3D11RenderDevice::GetNativeContext(renderDevice);
+
+	SetWaterShaderProperties(view, proj, viewProj);
+
+	ID3D11DepthStencilView* depthStencil = GetTargetDepthStencil(heightTarget, mpD3D->GetDepthStencilView());
 
 	// Set render target to the height texture map.
-	mpTerrain->GetWater()->SetHeightMapRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView());
-	
-	//mpTerrain->GetWater()->GetHeightTexture()->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), 0.0f, 0.0f, 0.0f, 0.0f);
-	mpTerrain->GetWater()->GetHeightTexture()->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), mpSceneLight->GetAmbientColour().x, mpSceneLight->GetAmbientColour().y, mpSceneLight->GetAmbientColour().z, 1.0f);
-	mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+	heightTarget->SetRenderTarget(context, depthStencil);
+
+	//heightTarget->ClearRenderTarget(context, depthStencil, 0.0f, 0.0f, 0.0f, 0.0f);
+	heightTarget->ClearRenderTarget(context, depthStencil, mpSceneLight->GetAmbientColour().x, mpSceneLight->GetAmbientColour().y, mpSceneLight->GetAmbientColour().z, 1.0f);
+	context->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH, 1.0f, 0);
 
 	// Render the water height map.
-	mpTerrain->GetWater()->Render(mpD3D->GetDeviceContext());
+	mpTerrain->GetWater()->Render(context);
 	mpTerrain->GetWater()->GetWorldMatrix(world);
 	mpWaterShader->SetWorldMatrix(world);
-	result = mpWaterShader->RenderHeight(mpD3D->GetDeviceContext(), mpTerrain->GetWater()->GetNumberOfIndices());
 
-	if (!result)
-	{
-		return false;
-	}
+	return mpWaterShader->RenderHeight(context, mpTerrain->GetWater()->GetNumberOfIndices());
+}
 
-	// Two requirements for refraction and refleciton are a light and terrain.
-	if (mpTerrain && mpSceneLight)
-	{
-		//////////////////////////////
-		// Refraction
-		//////////////////////////////
+bool CGraphics::RenderWaterRefraction(CRenderDevice* renderDevice, CRenderTexture* heightMap, CRenderTexture* refractionTarget, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
+{
+	D3DXMATRIX world;
+	ID3D11DeviceContext* context = CD3D11RenderDevice::GetNativeContext(renderDevice);
 
-		mpD3D->GetWorldMatrix(world);
-		// Reset the terrain world matrix
-		mpTerrain->GetWorldMatrix(world);
+	mpD3D->GetWorldMatrix(world);
+	// Reset the terrain world matrix
+	mpTerrain->GetWorldMatrix(world);
 
-		
-		mpTerrain->GetWater()->SetRefractionRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView());
-		mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+	ID3D11DepthStencilView* depthStencil = GetTargetDepthStencil(refractionTarget, mpD3D->GetDepthStencilView());
+	refractionTarget->SetRenderTarget(context, depthStencil);
+	context->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH, 1.0f, 0);
 
-		// Place our refract / reflect properties into the refract reflect shader.
-		mpRefractionShader->SetWorldMatrix(world);
-		mpRefractionShader->SetViewMatrix(view);
-		mpRefractionShader->SetProjMatrix(proj);
-		mpRefractionShader->SetViewProjMatrix(viewProj);
-		mpRefractionShader->SetLightProperties(mpSceneLight);
-		mpRefractionShader->SetViewportProperties(mScreenWidth, mScreenHeight);
-		mpRefractionShader->SetTerrainAreaProperties(mpTerrain->GetSnowHeight(), mpTerrain->GetGrassHeight(), mpTerrain->GetDirtHeight(), mpTerrain->GetSandHeight());
-		mpRefractionShader->SetPositioningProperties(mpTerrain->GetPosY(), mpTerrain->GetWater()->GetPosY() + mpTerrain->GetWater()->GetDepth());
-		mpRefractionShader->SetWaterHeightmap(mpTerrain->GetWater()->GetHeightTexture()->GetShaderResourceView());
-		mpRefractionShader->SetDirtTextureArray(mpTerrain->GetTexturesArray());
-		mpRefractionShader->SetGrassTextureArray(mpTerrain->GetGrassTextureArray());
-		mpRefractionShader->SetPatchMap(mpTerrain->GetPatchMap());
-		mpRefractionShader->SetRockTexture(mpTerrain->GetRockTextureArray());
+	// Place our refract / reflect properties into the refract reflect shader.
+	mpRefractionShader->SetWorldMatrix(world);
+	mpRefractionShader->SetViewMatrix(view);
+	mpRefractionShader->SetProjMatrix(proj);
+	mpRefractionShader->SetViewProjMatrix(viewProj);
+	SetReflectRefractTerrainProperties(mpRefractionShader, heightMap, refractionTarget);
 
-		mpTerrain->Render(mpD3D->GetDeviceContext()); 
-		mpTerrain->GetWater()->GetRefractionTexture()->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), mpSceneLight->GetAmbientColour().x, mpSceneLight->GetAmbientColour().y, mpSceneLight->GetAmbientColour().z, 1.0f);
-		//mpTerrain->GetWater()->GetRefractionTexture()->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), 0.0f, 0.0f, 0.0f, 0.0f);
+	mpTerrain->Render(context);
+	refractionTarget->ClearRenderTarget(context, depthStencil, mpSceneLight->GetAmbientColour().x, mpSceneLight->GetAmbientColour().y, mpSceneLight->GetAmbientColour().z, 1.0f);
+	//refractionTarget->ClearRenderTarget(context, depthStencil, 0.0f, 0.0f, 0.0f, 0.0f);
 
-		result = mpRefractionShader->RefractionRender(mpD3D->GetDeviceContext(), mpTerrain->GetIndexCount());
+	if (!mpRefractionShader->RefractionRender(context, mpTerrain->GetIndexCount()))
+	{
+		logger->GetInstance().WriteLine("Failed to render the refraction shader for water. ");
+		return false;
+	}
 
-		if (!result)
-		{
-			logger->GetInstance().WriteLine("Failed to render the refraction shader for water. ");
-			return false;
-		}
+	///////////////////////////////
+	// Foliage refraction.
+	//////////////////////////////
+	mpRefractionShader->SetFrameTime(mFrameTime);
+	//mpRefractionShader->SetWindDirection(mWindDirection);
+	mpRefractionShader->SetTranslation(mpFoliage->GetTranslation());
+	mpRefractionShader->SetWindStrength(1.0f);
+	mpRefractionShader->SetGrassTexture(mpFoliage->GetFoliageTexture());
+	mpRefractionShader->SetGrassAlphaTexture(mpFoliage->GetFoliageAlphaTexture());
 
-		///////////////////////////////
-		// Foliage refraction.
-		//////////////////////////////
-		mpRefractionShader->SetFrameTime(mFrameTime);
-		//mpRefractionShader->SetWindDirection(mWindDirection);
-		mpRefractionShader->SetTranslation(mpFoliage->GetTranslation());
-		mpRefractionShader->SetWindStrength(1.0f);
-		mpRefractionShader->SetGrassTexture(mpFoliage->GetFoliageTexture());
-		mpRefractionShader->SetGrassAlphaTexture(mpFoliage->GetFoliageAlphaTexture());
-		
-		if (!mWireframeEnabled)
-		{
-			mpD3D->TurnOffBackFaceCulling();
-		}
-		mpD3D->EnableAlphaBlending();
+	if (!mWireframeEnabled)
+	{
+		renderDevice->SetCullMode(CRenderDevice::CullNone);
+	}
+	renderDevice->SetBlendMode(CRenderDevice::AlphaBlend);
 
-		for (int quadCount = 0; quadCount < 3; quadCount++)
+	for (int quadCount = 0; quadCount < 3; quadCount++)
+	{
+		for (int triangleCount = 0; triangleCount < 2; triangleCount++)
 		{
-			for (int triangleCount = 0; triangleCount < 2; triangleCount++)
-			{
-				mpFoliage->RenderBuffers(mpD3D->GetDeviceContext(), quadCount, triangleCount);
+			mpFoliage->RenderBuffers(context, quadCount, triangleCount);
 
-				if (!mpRefractionShader->RenderFoliageRefraction(mpD3D->GetDeviceContext(), mpFoliage->GetQuadVertexCount(), mpFoliage->GetInstanceCount()))
-				{
-					logger->GetInstance().WriteLine("Failed to render foliage refraction. ");
-					return false;
-				}
+			if (!mpRefractionShader->RenderFoliageRefraction(context, mpFoliage->GetQuadVertexCount(), mpFoliage->GetInstanceCount()))
+			{
+				logger->GetInstance().WriteLine("Failed to render foliage refraction. ");
+				return false;
 			}
 		}
+	}
 
-		mpD3D->DisableAlphaBlending();
-		mpD3D->TurnOnBackFaceCulling();
-
-		//////////////////////////////////////
-		// Model refraction
-		/////////////////////////////////////
+	renderDevice->SetBlendMode(CRenderDevice::NoBlend);
+	renderDevice->SetCullMode(CRenderDevice::CullBack);
 
-		mRenderingMeshes = true;
+	//////////////////////////////////////
+	// Model refraction
+	/////////////////////////////////////
 
-		mpDiffuseLightShader->SetViewMatrix(view);
-		mpDiffuseLightShader->SetProjMatrix(proj);
-		mpDiffuseLightShader->SetViewProjMatrix(viewProj);
+	// Render any models which belong to each mesh. Do this in batches to make it faster.
+	for (auto mesh : mpMeshes)
+	{
+		mesh->Render(context, CVisibilitySystem::RefractionView, mpRefractionShader);
+	}
 
-		// Render any models which belong to each mesh. Do this in batches to make it faster.
-		for (auto mesh : mpMeshes)
-		{
-			mesh->Render(mpD3D->GetDeviceContext(), mpFrustum, mpRefractionShader, mpCamera->GetPosition());
-		}
+	return true;
+}
 
-		mRenderingMeshes = false;
+/* Drawn with its own shader, so it can be recorded while the refraction is. It only ever changes the pass constants
+* and fixed state through the device it's recorded on. */
+bool CGraphics::RenderWaterReflection(CRenderDevice* renderDevice, CRenderTexture* heightMap, CRenderTexture* reflectionTarget, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX reflectionViewProj)
+{
+	D3DXMATRIX world;
+	ID3D11DeviceContext* context = CD3D11RenderDevice::GetNativeContext(renderDevice);
 
+	ID3D11DepthStencilView* depthStencil = GetTargetDepthStencil(reflectionTarget, mpD3D->GetDepthStencilView());
 
-		/////////////////////////////////
-		// Reflection
-		/////////////////////////////////
-		//mpTerrain->GetWater()->GetReflectionTexture()->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), 0.0f, 0.0f, 0.0f, 0.0f);
-		mpTerrain->GetWater()->GetReflectionTexture()->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), mpSceneLight->GetAmbientColour().x, mpSceneLight->GetAmbientColour().y, mpSceneLight->GetAmbientColour().z, 1.0f);
-		mpTerrain->GetWater()->SetReflectionRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView());
-		mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-		mpD3D->TurnOffBackFaceCulling();
-		mpRefractionShader->SetViewMatrix(reflectionView);
-		mpRefractionShader->SetProjMatrix(proj);
+	//reflectionTarget->ClearRenderTarget(context, depthStencil, 0.0f, 0.0f, 0.0f, 0.0f);
+	reflectionTarget->ClearRenderTarget(context, depthStencil, mpSceneLight->GetAmbientColour().x, mpSceneLight->GetAmbientColour().y, mpSceneLight->GetAmbientColour().z, 1.0f);
+	reflectionTarget->SetRenderTarget(context, depthStencil);
+	context->ClearDepthStencilView(depthStencil, D3D11_CLEAR_DEPTH, 1.0f, 0);
+	renderDevice->SetCullMode(CRenderDevice::CullNone);
+	mpReflectionShader->SetViewMatrix(reflectionViewProj);
+	mpReflectionShader->SetProjMatrix(proj);
+	SetReflectRefractTerrainProperties(mpReflectionShader, heightMap, reflectionTarget);
 
-		/***********
-		* Skybox 
-		************/
+	// Drawn from the reflected camera, keeping only what's above the water.
+	D3DXMATRIX reflectionCameraView;
+	mpReflectionCamera->GetReflectionView(reflectionCameraView);
+	const D3DXVECTOR4 waterPlane(0.0f, 1.0f, 0.0f, -mpTerrain->GetWater()->GetPosY());
+	if (!mpSharedConstants->SetPassConstants(renderDevice, reflectionCameraView, proj, waterPlane, static_cast<float>(reflectionTarget->GetWidth()), static_cast<float>(reflectionTarget->GetHeight())))
+	{
+		return false;
+	}
 
-		D3DXVECTOR3 cameraPosition;
+	/***********
+	* Skybox 
+	************/
 
-		// Get the position of the camera.
-		cameraPosition = mpCamera->GetPosition();
+	D3DXVECTOR3 cameraPosition;
 
-		mpD3D->GetWorldMatrix(world);
+	// Get the position of the camera.
+	cameraPosition = mpCamera->GetPosition();
 
-		// Translate the sky dome to be centered around the camera position.
-		D3DXMatrixTranslation(&world, cameraPosition.x, cameraPosition.y, cameraPosition.z);
+	mpD3D->GetWorldMatrix(world);
 
-		// Turn off the Z buffer.
-		mpD3D->DisableZBuffer();
+	// Translate the sky dome to be centered around the camera position.
+	D3DXMatrixTranslation(&world, cameraPosition.x, cameraPosition.y, cameraPosition.z);
 
-		// Render the sky dome using the sky dome shader.
-		mpSkybox->Render(mpD3D->GetDeviceContext());
+	// Turn off the Z buffer.
+	renderDevice->SetDepthMode(CRenderDevice::NoDepth);
 
-		D3DXMATRIX scale;
-		float scaleValue = (mpTerrain->GetWidth() * mpTerrain->GetHeight()) * 0.025f;
+	// Render the sky dome using the sky dome shader.
+	mpSkybox->Render(context);
 
-		D3DXMatrixScaling(&scale, scaleValue, scaleValue, scaleValue);
-		D3DXMatrixTranslation(&world, cameraPosition.x, cameraPosition.y, cameraPosition.z);
-		world = scale * world;
+	D3DXMATRIX scale;
+	float scaleValue = (mpTerrain->GetWidth() * mpTerrain->GetHeight()) * 0.025f;
 
-		mpRefractionShader->SetWorldMatrix(world);
-		mpRefractionShader->SetSkyboxColours(mpSkybox->GetApexColor(), mpSkybox->GetCenterColour());
+	D3DXMatrixScaling(&scale, scaleValue, scaleValue, scaleValue);
+	D3DXMatrixTranslation(&world, cameraPosition.x, cameraPosition.y, cameraPosition.z);
+	world = scale * world;
 
-		mpRefractionShader->RenderSkyboxReflection(mpD3D->GetDeviceContext(), mpSkybox->GetIndexCount());
+	mpReflectionShader->SetWorldMatrix(world);
+	mpReflectionShader->SetSkyboxColours(mpSkybox->GetApexColor(), mpSkybox->GetCenterColour());
 
-		/*****************
-		** Clouds
-		*******************/
-		mpD3D->GetWorldMatrix(world);
+	mpReflectionShader->RenderSkyboxReflection(context, mpSkybox->GetIndexCount());
 
-		// Translate the sky dome to be centered around the camera position.
+	/*****************
+	** Clouds
+	*******************/
+	mpD3D->GetWorldMatrix(world);
 
-		//D3DXMATRIX scale;
-		D3DXMatrixScaling(&scale, scaleValue, scaleValue, scaleValue);
-		D3DXMatrixTranslation(&world, cameraPosition.x, cameraPosition.y, cameraPosition.z);
-		world = scale * world;
-		// Turn off the Z buffer.
-		mpD3D->DisableZBuffer();
+	// Translate the sky dome to be centered around the camera position.
 
-		// Allow the clouds to additively blend with the skybox.
-		mpD3D->EnableAdditiveAlphaBlending();
+	//D3DXMATRIX scale;
+	D3DXMatrixScaling(&scale, scaleValue, scaleValue, scaleValue);
+	D3DXMatrixTranslation(&world, cameraPosition.x, cameraPosition.y, cameraPosition.z);
+	world = scale * world;
 
-		// Place the cloud plane vertex / index data onto the rendering pipeline.
-		mpCloudPlane->Render(mpD3D->GetDeviceContext());
+	// Allow the clouds to additively blend with the skybox.
+	renderDevice->SetBlendMode(CRenderDevice::AdditiveBlend);
 
-		// Set shader variables before rendering clouds with the shader.
-		mpRefractionShader->SetCloudBrightness(mpCloudPlane->GetBrightness());
-		mpRefractionShader->SetCloudMovement(mpCloudPlane->GetMovement(0), mpCloudPlane->GetMovement(1));
+	// Place the cloud plane vertex / index data onto the rendering pipeline.
+	mpCloudPlane->Render(context);
 
-		mpRefractionShader->SetCloudTextures(mpCloudPlane->GetCloudTexture1(), mpCloudPlane->GetCloudTexture2());
+	// Set shader variables before rendering clouds with the shader.
+	mpReflectionShader->SetCloudBrightness(mpCloudPlane->GetBrightness());
+	mpReflectionShader->SetCloudMovement(mpCloudPlane->GetMovement(0), mpCloudPlane->GetMovement(1));
 
-		// Render the clouds using vertex and pixel shaders.
-		mpRefractionShader->SetWorldMatrix(world);
+	mpReflectionShader->SetCloudTextures(mpCloudPlane->GetCloudTexture1(), mpCloudPlane->GetCloudTexture2());
 
-		mpRefractionShader->SetViewportProperties(mScreenWidth, mScreenHeight);
-		mpRefractionShader->RenderCloudReflection(mpD3D->GetDeviceContext(), mpCloudPlane->GetIndexCount());
+	// Render the clouds using vertex and pixel shaders.
+	mpReflectionShader->SetWorldMatrix(world);
 
-		// Turn off alpha blending.
-		mpD3D->DisableAlphaBlending();
+	mpReflectionShader->RenderCloudReflection(context, mpCloudPlane->GetIndexCount());
 
-		// Turn the Z buffer back on.
-		mpD3D->EnableZBuffer();
+	// Turn off alpha blending.
+	renderDevice->SetBlendMode(CRenderDevice::NoBlend);
 
-		// Reset the world matrix.
-		mpD3D->GetWorldMatrix(world);
+	// Turn the Z buffer back on.
+	renderDevice->SetDepthMode(CRenderDevice::DepthTestAndWrite);
 
+	/***********
+	* Terrain 
+	************/
 
-		/***********
-		* Terrain 
-		************/
+	mpTerrain->GetWorldMatrix(world);
+	mpReflectionShader->SetWorldMatrix(world);
 
-		mpTerrain->GetWorldMatrix(world);
-		mpRefractionShader->SetWorldMatrix(world);
-		//mpReflectionCamera->GetReflectionView(reflectionView);
-		//mpRefractionShader->SetViewMatrix(reflectionView);
-		mpRefractionShader->SetProjMatrix(proj);
+	mpTerrain->Render(context);
+	if (!mpReflectionShader->ReflectionRender(context, mpTerrain->GetIndexCount()))
+	{
+		logger->GetInstance().WriteLine("Failed to render the reflection of terrain on the reflection render target.");
+		return false;
+	}
 
-		mpRefractionShader->SetWaterHeightmap(mpTerrain->GetWater()->GetHeightTexture()->GetShaderResourceView());
-		mpRefractionShader->SetPatchMap(mpTerrain->GetPatchMap());
+	for (auto mesh : mpMeshes)
+	{
+		mesh->RenderReflection(context, CVisibilitySystem::ReflectionView, mpReflectionShader);
+	}
 
-		mpTerrain->Render(mpD3D->GetDeviceContext());
-		if (!mpRefractionShader->ReflectionRender(mpD3D->GetDeviceContext(), mpTerrain->GetIndexCount()))
-		{
-			logger->GetInstance().WriteLine("Failed to render the reflection of terrain on the reflection render target.");
-			return false;
-		}
+	renderDevice->SetCullMode(CRenderDevice::CullBack);
 
-		for (auto mesh : mpMeshes)
-		{
-			mesh->RenderReflection(mpD3D->GetDeviceContext(), mpFrustum, mpRefractionShader, mpCamera->GetPosition());
-		}
-		
+	// Back to the main camera for everything drawn after the water.
+	if (!mpSharedConstants->SetPassConstants(renderDevice, view, proj, D3DXVECTOR4(0.0f, 0.0f, 0.0f, 0.0f), static_cast<float>(mScreenWidth), static_cast<float>(mScreenHeight)))
+	{
+		return false;
 	}
 
-	/////////////////////////////////
-	// Water Model
-	/////////////////////////////////
+	return true;
+}
+
+/* Either map may be null when the graph pruned the pass drawing it, the shader then samples black, which its zero strength hides. */
+bool CGraphics::RenderWaterSurface(CRenderTexture* refractionMap, CRenderTexture* reflectionMap, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
+{
+	D3DXMATRIX world;
+
+	SetWaterShaderProperties(view, proj, viewProj);
+	mpTerrain->GetWater()->GetWorldMatrix(world);
+	mpWaterShader->SetWorldMatrix(world);
 
 	mpD3D->SetBackBufferRenderTarget();
 	mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
 	mpTerrain->GetWater()->Render(mpD3D->GetDeviceContext());
 
-	mpWaterShader->SetRefractionMap(mpTerrain->GetWater()->GetRefractionTexture()->GetShaderResourceView());
-	mpWaterShader->SetReflectionMap(mpTerrain->GetWater()->GetReflectionTexture()->GetShaderResourceView());
-
-	result = mpWaterShader->RenderSurface(mpD3D->GetDeviceContext(), mpTerrain->GetWater()->GetNumberOfIndices());
+	mpWaterShader->SetRefractionMap(refractionMap != nullptr ? refractionMap->GetShaderResourceView() : nullptr);
+	mpWaterShader->SetReflectionMap(reflectionMap != nullptr ? reflectionMap->GetShaderResourceView() : nullptr);
 
-
-	if (!result)
-	{
-		return false;
-	}
-
-	return true;
+	return mpWaterShader->RenderSurface(mpD3D->GetDeviceContext(), mpTerrain->GetWater()->GetNumberOfIndices());
 }
 
 bool CGraphics::RenderRain(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
@@ -1575,9 +2150,6 @@ bool CGraphics::RenderFoliage(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj
 	mpFoliageShader->SetViewMatrix(view);
 	mpFoliageShader->SetProjMatrix(proj);
 	mpFoliageShader->SetViewProjMatrix(viewProj);
-	mpFoliageShader->SetAmbientColour(mpSceneLight->GetAmbientColour());
-	mpFoliageShader->SetDiffuseColour(mpSceneLight->GetDiffuseColour());
-	mpFoliageShader->SetLightDirection(mpSceneLight->GetDirection());
 	mpFoliageShader->SetFrameTime(mFrameTime);
 	mpFoliageShader->SetGrassTexture(mpFoliage->GetFoliageTexture());
 	mpFoliageShader->SetGrassAlphaTexture(mpFoliage->GetFoliageAlphaTexture());
@@ -1867,7 +2439,7 @@ bool CGraphics::CreateTextureAndDiffuseLightShaderFromModel(HWND hwnd)
 		bool successful;
 
 		// Create texture shader.
-		mpDiffuseLightShader = new CDiffuseLightShader();
+		mpDiffuseLightShader = new CDiffuseLightShader(mpD3D->GetRenderDevice());
 		logger->GetInstance().MemoryAllocWriteLine(typeid(mpDiffuseLightShader).name());
 		if (!mpDiffuseLightShader)
 		{
@@ -2001,7 +2573,7 @@ bool CGraphics::RemovePrimitive(CPrimitive* &model)
 CMesh* CGraphics::LoadMesh(std::string filename, float radius)
 {
 	// Allocate the mesh memory.
-	CMesh* mesh = new CMesh(mpD3D->GetDevice());
+	CMesh* mesh = new CMesh(mpD3D->GetDevice(), mpD3D->GetRenderDevice(), mpTransformSystem, mpResourceCache);
 
 	logger->GetInstance().MemoryAllocWriteLine(typeid(mesh).name());
 
@@ -2021,6 +2593,26 @@ CMesh* CGraphics::LoadMesh(std::string filename, float radius)
 	return mesh;
 }
 
+/* Queue a mesh to load in the background. It's added to the list straight away, but has nothing to draw until it has loaded.
+* @Returns CMesh* Pointer to the mesh, or nullptr if it couldn't be queued. */
+CMesh* CGraphics::LoadMeshAsync(std::string filename, float radius, CAssetLoader::CompletionCallback callback)
+{
+	CMesh* mesh = new CMesh(mpD3D->GetDevice(), mpD3D->GetRenderDevice(), mpTransformSystem, mpResourceCache);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mesh).name());
+
+	if (!mesh->LoadMeshAsync(mpAssetLoader, filename, radius, callback))
+	{
+		delete mesh;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mesh).name());
+		logger->GetInstance().WriteLine("Failed to queue the mesh with name " + filename);
+		return nullptr;
+	}
+
+	mpMeshes.push_back(mesh);
+
+	return mesh;
+}
+
 /* Deletes any allocated memory to a mesh and removes it from the list. */
 bool CGraphics::RemoveMesh(CMesh *& mesh)
 {
@@ -2070,7 +2662,7 @@ CTerrain * CGraphics::CreateTerrain(std::string mapFile)
 		mpTerrain = nullptr;
 	}
 
-	CTerrain* terrain = new CTerrain(mpD3D->GetDevice(), mScreenWidth, mScreenHeight);
+	CTerrain* terrain = new CTerrain(mpD3D->GetDevice(), mScreenWidth, mScreenHeight, mpAssetLoader);
 	logger->GetInstance().WriteLine("Created terrain from the graphics object.");
 	mpTerrain = terrain;
 
@@ -2103,7 +2695,7 @@ CTerrain * CGraphics::CreateTerrain(double ** heightMap, int mapWidth, int mapHe
 		mpTerrain = nullptr;
 	}
 
-	CTerrain* terrain = new CTerrain(mpD3D->GetDevice(), mScreenWidth, mScreenHeight);
+	CTerrain* terrain = new CTerrain(mpD3D->GetDevice(), mScreenWidth, mScreenHeight, mpAssetLoader);
 	logger->GetInstance().WriteLine("Created terrain from the graphics object.");
 	mpTerrain = terrain;
 
@@ -2336,6 +2928,18 @@ void CGraphics::SetLevelOfDetail(float value)
 	}
 }
 
+void CGraphics::SetWaterResolutionScale(float refractionScale, float reflectionScale)
+{
+	mWaterRefractionScale = refractionScale;
+	mWaterReflectionScale = reflectionScale;
+}
+
+void CGraphics::SetWaterUpdateInterval(unsigned int frames)
+{
+	// Every frame is as often as the maps can be drawn.
+	mWaterUpdateInterval = std::max(1u, frames);
+}
+
 void CGraphics::SetWindDirection(D3DXVECTOR3 windDir)
 {
 	mWindDirection = windDir;
@@ -33,6 +33,10 @@
 #include "Snow.h"
 #include "FoliageShader.h"
 #include "Foliage.h"
+#include "TaskGraph.h"
+#include "PassRecorder.h"
+#include "FrameGraph.h"
+#include "ShaderCache.h"
 #include <SFML/Audio.hpp>
 
 // Global variables.
@@ -54,6 +58,26 @@ private:
 	float mFieldOfView;
 	bool mWireframeEnabled;
 	CFrustum* mpFrustum;
+	// Each view of the water has a frustum of its own, with the water surface as a clip plane.
+	CFrustum* mpReflectionFrustum;
+	CFrustum* mpRefractionFrustum;
+	CTransformSystem* mpTransformSystem;
+	CThreadPool* mpThreadPool;
+	CVisibilitySystem* mpVisibilitySystem;
+	// Opaque mesh draws, gathered and sorted each frame before being submitted.
+	CDrawList* mpDrawList;
+	// Constants every shader reads, written once a frame, once a camera and once a draw.
+	CSharedConstants* mpSharedConstants;
+	// Records large passes across the thread pool, then executes them in order.
+	CPassRecorder* mpPassRecorder;
+	// The water passes, rebuilt each frame so any whose results nothing uses are pruned along with their targets.
+	CFrameGraph* mpFrameGraph;
+	// Stand for the culling results of the reflection and refraction views, which are only worked out when a pass still reads them.
+	CFrameGraph::ResourceId mReflectionVisibility;
+	CFrameGraph::ResourceId mRefractionVisibility;
+	COcclusionCuller* mpOcclusionCuller;
+	CResourceCache* mpResourceCache;
+	CAssetLoader* mpAssetLoader;
 	bool mFullScreen = false;
 public:
 	CGraphics();
@@ -64,13 +88,22 @@ public:
 	bool Frame(float updateTime);
 private:
 	bool Render();
+	bool SetFrameConstants();
 private:
-	bool RenderModels(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj, D3DXMATRIX reflectionViewProj);
+	bool RenderModels(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
 	bool RenderPrimitives(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
 	bool RenderMeshes(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
 	bool RenderTerrains(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
 	bool RenderSkybox(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
-	bool RenderWater(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj, D3DXMATRIX reflectionViewProj);
+	void AddWaterPasses(D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj, D3DXMATRIX reflectionViewProj);
+	bool RenderWater();
+	bool RecordWaterPasses();
+	void SetWaterShaderProperties(D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
+	void SetReflectRefractTerrainProperties(CReflectRefractShader* shader, CRenderTexture* heightMap, CRenderTexture* target);
+	bool RenderWaterHeight(CRenderDevice* renderDevice, CRenderTexture* heightTarget, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
+	bool RenderWaterRefraction(CRenderDevice* renderDevice, CRenderTexture* heightMap, CRenderTexture* refractionTarget, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
+	bool RenderWaterReflection(CRenderDevice* renderDevice, CRenderTexture* heightMap, CRenderTexture* reflectionTarget, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX reflectionViewProj);
+	bool RenderWaterSurface(CRenderTexture* refractionMap, CRenderTexture* reflectionMap, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
 	bool RenderRain(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
 	bool RenderSnow(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
 	bool RenderFoliage(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
@@ -89,6 +122,8 @@ private:
 	CSkyboxShader* mpSkyboxShader;
 	CWaterShader* mpWaterShader;
 	CReflectRefractShader* mpRefractionShader;
+	// The reflection has its own, as it's recorded at the same time as the refraction.
+	CReflectRefractShader* mpReflectionShader;
 	CRainShader* mpRainShader;
 	CSnowShader* mpSnowShader;
 	CFoliageShader* mpFoliageShader;
@@ -123,6 +158,9 @@ public:
 
 	// Model creation / deletion.
 	CMesh* LoadMesh(std::string filename, float radius = 1.0f);
+	// Returns straight away with an empty mesh, which is filled in once the asset loader has finished with it.
+	CMesh* LoadMeshAsync(std::string filename, float radius = 1.0f, CAssetLoader::CompletionCallback callback = nullptr);
+	CAssetLoader* GetAssetLoader() { return mpAssetLoader; };
 	bool RemoveMesh(CMesh* &mesh);
 
 	CTerrain* CreateTerrain(std::string mapFile);
@@ -188,6 +226,17 @@ private:
 	const float mBirdSquawkPlayInterval = 20.0f;
 	float mLevelOfDetail = 1000.0f;
 	D3DXVECTOR3 mWindDirection = { 0.0f, 0.0f, 0.0f };
+
+	// Fraction of the screen size the water refraction and reflection are drawn at.
+	float mWaterRefractionScale = 0.5f;
+	float mWaterReflectionScale = 0.5f;
+	// How many frames go by between redrawing each of the water maps.
+	unsigned int mWaterUpdateInterval = 2;
+	unsigned int mWaterFrame = 0;
+	bool mWaterDrawnLastFrame = false;
+	// The main camera as it was when each water map was last drawn, to reproject them with.
+	D3DXMATRIX mWaterRefractionViewProj;
+	D3DXMATRIX mWaterReflectionViewProj;
 public:
 	bool CreateFoliage(std::string filename);
 	bool CreateFoliage(double** heightMap, int width, int height);
@@ -203,6 +252,9 @@ public:
 	void SetLevelOfDetail(float value);
 	D3DXVECTOR3 GetWindDirection() { return mWindDirection; };
 	void SetWindDirection(D3DXVECTOR3 windDir);
+	void SetWaterResolutionScale(float refractionScale, float reflectionScale);
+	unsigned int GetWaterUpdateInterval() { return mWaterUpdateInterval; };
+	void SetWaterUpdateInterval(unsigned int frames);
 
 	bool IsRenderingWater() { return mRenderingWater; };
 
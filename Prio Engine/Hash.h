@@ -0,0 +1,31 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+
+namespace PrioEngine
+{
+	// Hashing used to check whether cached data is still up to date with its source.
+	namespace Hash
+	{
+		const unsigned long long kFNVOffsetBasis = 14695981039346656037ULL;
+		const unsigned long long kFNVPrime = 1099511628211ULL;
+
+		/* Hashes a block of memory using 64 bit FNV-1a, pass in a previous result as the seed to continue hashing over more data.
+		* @Returns unsigned long long, the hash of the data.
+		*/
+		inline unsigned long long FNV1a(const void* data, size_t size, unsigned long long seed = kFNVOffsetBasis)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			unsigned long long hash = seed;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= kFNVPrime;
+			}
+			return hash;
+		}
+	}
+}
+
+#endif
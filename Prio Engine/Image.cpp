@@ -0,0 +1,924 @@
+#include "Image.h"
+#include "Inflate.h"
+#include <cstring>
+#include <cctype>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define IMAGE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const unsigned int kMaxDimension = 16384;
+
+	const unsigned int kDDSMagic = 0x20534444;
+	const unsigned int kDDSHeaderSize = 124;
+	const unsigned int kDDSMipMapCountFlag = 0x20000;
+	const unsigned int kDDSFourCCFlag = 0x4;
+	const unsigned int kDDSRGBFlag = 0x40;
+	const unsigned int kDDSCubeMapFlag = 0x200;
+	const unsigned int kDDSVolumeFlag = 0x200000;
+	const unsigned int kDX10TextureCubeFlag = 0x4;
+	const unsigned int kDX10Texture2D = 3;
+
+	struct DDSPixelFormat
+	{
+		unsigned int size;
+		unsigned int flags;
+		unsigned int fourCC;
+		unsigned int rgbBitCount;
+		unsigned int redMask;
+		unsigned int greenMask;
+		unsigned int blueMask;
+		unsigned int alphaMask;
+	};
+
+	struct DDSHeader
+	{
+		unsigned int size;
+		unsigned int flags;
+		unsigned int height;
+		unsigned int width;
+		unsigned int pitchOrLinearSize;
+		unsigned int depth;
+		unsigned int mipMapCount;
+		unsigned int reserved1[11];
+		DDSPixelFormat pixelFormat;
+		unsigned int caps;
+		unsigned int caps2;
+		unsigned int caps3;
+		unsigned int caps4;
+		unsigned int reserved2;
+	};
+
+	struct DDSHeaderDX10
+	{
+		unsigned int dxgiFormat;
+		unsigned int resourceDimension;
+		unsigned int miscFlag;
+		unsigned int arraySize;
+		unsigned int miscFlags2;
+	};
+
+	const unsigned char kPNGSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	unsigned int FourCC(char a, char b, char c, char d)
+	{
+		return static_cast<unsigned int>(static_cast<unsigned char>(a)) | (static_cast<unsigned int>(static_cast<unsigned char>(b)) << 8) |
+			(static_cast<unsigned int>(static_cast<unsigned char>(c)) << 16) | (static_cast<unsigned int>(static_cast<unsigned char>(d)) << 24);
+	}
+
+	unsigned int ReadBigEndian32(const unsigned char* data)
+	{
+		return (static_cast<unsigned int>(data[0]) << 24) | (static_cast<unsigned int>(data[1]) << 16) | (static_cast<unsigned int>(data[2]) << 8) | data[3];
+	}
+
+	CImage::PixelFormat FormatFromFourCC(unsigned int fourCC)
+	{
+		if (fourCC == FourCC('D', 'X', 'T', '1')) return CImage::BC1Format;
+		if (fourCC == FourCC('D', 'X', 'T', '2') || fourCC == FourCC('D', 'X', 'T', '3')) return CImage::BC2Format;
+		if (fourCC == FourCC('D', 'X', 'T', '4') || fourCC == FourCC('D', 'X', 'T', '5')) return CImage::BC3Format;
+		if (fourCC == FourCC('A', 'T', 'I', '1') || fourCC == FourCC('B', 'C', '4', 'U')) return CImage::BC4Format;
+		if (fourCC == FourCC('B', 'C', '4', 'S')) return CImage::BC4SnormFormat;
+		if (fourCC == FourCC('A', 'T', 'I', '2') || fourCC == FourCC('B', 'C', '5', 'U')) return CImage::BC5Format;
+		if (fourCC == FourCC('B', 'C', '5', 'S')) return CImage::BC5SnormFormat;
+		return CImage::UnknownFormat;
+	}
+
+	// Typeless formats are read as their UNORM equivalent, the same as D3DX did.
+	CImage::PixelFormat FormatFromDXGI(unsigned int dxgiFormat)
+	{
+		switch (dxgiFormat)
+		{
+		case 27: case 28: return CImage::RGBA8Format;
+		case 29: return CImage::RGBA8SrgbFormat;
+		case 87: case 90: return CImage::BGRA8Format;
+		case 88: return CImage::BGRX8Format;
+		case 91: return CImage::BGRA8SrgbFormat;
+		case 70: case 71: return CImage::BC1Format;
+		case 72: return CImage::BC1SrgbFormat;
+		case 73: case 74: return CImage::BC2Format;
+		case 75: return CImage::BC2SrgbFormat;
+		case 76: case 77: return CImage::BC3Format;
+		case 78: return CImage::BC3SrgbFormat;
+		case 79: case 80: return CImage::BC4Format;
+		case 81: return CImage::BC4SnormFormat;
+		case 82: case 83: return CImage::BC5Format;
+		case 84: return CImage::BC5SnormFormat;
+		case 94: case 95: return CImage::BC6HUnsignedFormat;
+		case 96: return CImage::BC6HSignedFormat;
+		case 97: case 98: return CImage::BC7Format;
+		case 99: return CImage::BC7SrgbFormat;
+		default: return CImage::UnknownFormat;
+		}
+	}
+
+	unsigned char PaethPredictor(int left, int above, int aboveLeft)
+	{
+		const int estimate = left + above - aboveLeft;
+		const int distanceLeft = estimate > left ? estimate - left : left - estimate;
+		const int distanceAbove = estimate > above ? estimate - above : above - estimate;
+		const int distanceAboveLeft = estimate > aboveLeft ? estimate - aboveLeft : aboveLeft - estimate;
+
+		if (distanceLeft <= distanceAbove && distanceLeft <= distanceAboveLeft)
+		{
+			return static_cast<unsigned char>(left);
+		}
+		return static_cast<unsigned char>(distanceAbove <= distanceAboveLeft ? above : aboveLeft);
+	}
+
+	/* Undo the filter on one row of a PNG in place.
+	* @Returns bool False if the filter type isn't one the spec defines. */
+	bool UnfilterRow(unsigned char filter, unsigned char* row, const unsigned char* previousRow, size_t rowBytes, unsigned int bytesPerPixel)
+	{
+		switch (filter)
+		{
+		case 0:
+			return true;
+		case 1:
+			for (size_t byte = bytesPerPixel; byte < rowBytes; byte++)
+			{
+				row[byte] = static_cast<unsigned char>(row[byte] + row[byte - bytesPerPixel]);
+			}
+			return true;
+		case 2:
+			if (previousRow != nullptr)
+			{
+				for (size_t byte = 0; byte < rowBytes; byte++)
+				{
+					row[byte] = static_cast<unsigned char>(row[byte] + previousRow[byte]);
+				}
+			}
+			return true;
+		case 3:
+			for (size_t byte = 0; byte < rowBytes; byte++)
+			{
+				const int left = byte >= bytesPerPixel ? row[byte - bytesPerPixel] : 0;
+				const int above = previousRow != nullptr ? previousRow[byte] : 0;
+				row[byte] = static_cast<unsigned char>(row[byte] + ((left + above) >> 1));
+			}
+			return true;
+		case 4:
+			for (size_t byte = 0; byte < rowBytes; byte++)
+			{
+				const int left = byte >= bytesPerPixel ? row[byte - bytesPerPixel] : 0;
+				const int above = previousRow != nullptr ? previousRow[byte] : 0;
+				const int aboveLeft = previousRow != nullptr && byte >= bytesPerPixel ? previousRow[byte - bytesPerPixel] : 0;
+				row[byte] = static_cast<unsigned char>(row[byte] + PaethPredictor(left, above, aboveLeft));
+			}
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
+CImage::CImage()
+{
+	mFormat = UnknownFormat;
+	mNumberOfMipLevels = 0;
+	memset(mMipLevels, 0, sizeof(mMipLevels));
+}
+
+
+CImage::~CImage()
+{
+	Release();
+}
+
+bool CImage::Open(const std::string& filename)
+{
+	Release();
+	mFilename = filename;
+
+	return mFile.Open(filename);
+}
+
+bool CImage::Decode(bool generateMips)
+{
+	if (!mFile.IsOpen())
+	{
+		return false;
+	}
+
+	const unsigned char* data = mFile.GetData();
+	const size_t size = mFile.GetSize();
+
+	bool success = false;
+	if (size >= 4 && (data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<unsigned int>(data[3]) << 24)) == kDDSMagic)
+	{
+		success = ParseDDS(generateMips);
+	}
+	else if (size >= sizeof(kPNGSignature) && memcmp(data, kPNGSignature, sizeof(kPNGSignature)) == 0)
+	{
+		success = DecodePNG(generateMips);
+	}
+	else
+	{
+		// TGA files don't have anything to identify them at the start, so go by the extension.
+		std::string extension = mFilename.size() >= 4 ? mFilename.substr(mFilename.size() - 4) : "";
+		for (auto& character : extension)
+		{
+			character = static_cast<char>(tolower(static_cast<unsigned char>(character)));
+		}
+
+		if (extension == ".tga")
+		{
+			success = DecodeTGA(generateMips);
+		}
+	}
+
+	if (!success)
+	{
+		mFormat = UnknownFormat;
+		mNumberOfMipLevels = 0;
+		std::vector<unsigned char>().swap(mPixels);
+		std::vector<unsigned char>().swap(mMipPixels);
+	}
+
+	return success;
+}
+
+void CImage::Release()
+{
+	mFile.Close();
+	std::vector<unsigned char>().swap(mPixels);
+	std::vector<unsigned char>().swap(mMipPixels);
+
+	mFormat = UnknownFormat;
+	mNumberOfMipLevels = 0;
+	memset(mMipLevels, 0, sizeof(mMipLevels));
+}
+
+bool CImage::IsBlockCompressed(PixelFormat format)
+{
+	return format >= BC1Format;
+}
+
+unsigned int CImage::GetBytesPerElement(PixelFormat format)
+{
+	switch (format)
+	{
+	case BC1Format:
+	case BC1SrgbFormat:
+	case BC4Format:
+	case BC4SnormFormat:
+		return 8;
+	case UnknownFormat:
+		return 0;
+	default:
+		return IsBlockCompressed(format) ? 16 : 4;
+	}
+}
+
+unsigned int CImage::CalculateNumberOfMipLevels(unsigned int width, unsigned int height)
+{
+	unsigned int numberOfLevels = 1;
+	while (width > 1 || height > 1)
+	{
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+		numberOfLevels++;
+	}
+	return numberOfLevels;
+}
+
+/* Point the levels straight into the file data. Only 32 bit layouts which match a DXGI format are read this way,
+* anything else is left for D3DX.
+* @Returns bool Success */
+bool CImage::ParseDDS(bool generateMips)
+{
+	const unsigned char* data = mFile.GetData();
+	const size_t size = mFile.GetSize();
+
+	if (size < sizeof(unsigned int) + sizeof(DDSHeader))
+	{
+		logger->GetInstance().WriteLine("The DDS file '" + mFilename + "' is too small to hold a header.");
+		return false;
+	}
+
+	DDSHeader header;
+	memcpy(&header, data + sizeof(unsigned int), sizeof(header));
+	size_t offset = sizeof(unsigned int) + sizeof(header);
+
+	if (header.size != kDDSHeaderSize || header.width == 0 || header.height == 0 || header.width > kMaxDimension || header.height > kMaxDimension)
+	{
+		logger->GetInstance().WriteLine("The DDS file '" + mFilename + "' has an invalid header.");
+		return false;
+	}
+
+	// Cube maps and volumes aren't 2D textures.
+	if ((header.caps2 & (kDDSCubeMapFlag | kDDSVolumeFlag)) != 0)
+	{
+		return false;
+	}
+
+	PixelFormat format = UnknownFormat;
+	bool forceOpaque = false;
+
+	if ((header.pixelFormat.flags & kDDSFourCCFlag) != 0)
+	{
+		if (header.pixelFormat.fourCC == FourCC('D', 'X', '1', '0'))
+		{
+			DDSHeaderDX10 extendedHeader;
+			if (size < offset + sizeof(extendedHeader))
+			{
+				logger->GetInstance().WriteLine("The DDS file '" + mFilename + "' is too small to hold its extended header.");
+				return false;
+			}
+
+			memcpy(&extendedHeader, data + offset, sizeof(extendedHeader));
+			offset += sizeof(extendedHeader);
+
+			if (extendedHeader.resourceDimension != kDX10Texture2D || extendedHeader.arraySize > 1 || (extendedHeader.miscFlag & kDX10TextureCubeFlag) != 0)
+			{
+				return false;
+			}
+
+			format = FormatFromDXGI(extendedHeader.dxgiFormat);
+		}
+		else
+		{
+			format = FormatFromFourCC(header.pixelFormat.fourCC);
+		}
+	}
+	else if ((header.pixelFormat.flags & kDDSRGBFlag) != 0 && header.pixelFormat.rgbBitCount == 32)
+	{
+		const DDSPixelFormat& pixelFormat = header.pixelFormat;
+		if (pixelFormat.redMask == 0x00FF0000 && pixelFormat.greenMask == 0x0000FF00 && pixelFormat.blueMask == 0x000000FF)
+		{
+			format = pixelFormat.alphaMask == 0xFF000000 ? BGRA8Format : BGRX8Format;
+		}
+		else if (pixelFormat.redMask == 0x000000FF && pixelFormat.greenMask == 0x0000FF00 && pixelFormat.blueMask == 0x00FF0000)
+		{
+			// There's no RGBX format, so when the alpha is unused it's filled in as opaque.
+			format = RGBA8Format;
+			forceOpaque = pixelFormat.alphaMask != 0xFF000000;
+		}
+	}
+
+	if (format == UnknownFormat)
+	{
+		return false;
+	}
+
+	unsigned int numberOfLevels = (header.flags & kDDSMipMapCountFlag) != 0 && header.mipMapCount > 0 ? header.mipMapCount : 1;
+	if (numberOfLevels > kMaxMipLevels || numberOfLevels > CalculateNumberOfMipLevels(header.width, header.height))
+	{
+		logger->GetInstance().WriteLine("The DDS file '" + mFilename + "' has more mip levels than its size allows.");
+		return false;
+	}
+
+	const bool compressed = IsBlockCompressed(format);
+	const unsigned int bytesPerElement = GetBytesPerElement(format);
+	unsigned int width = header.width;
+	unsigned int height = header.height;
+
+	for (unsigned int level = 0; level < numberOfLevels; level++)
+	{
+		MipLevel& mipLevel = mMipLevels[level];
+		mipLevel.width = width;
+		mipLevel.height = height;
+
+		if (compressed)
+		{
+			const unsigned int blocksWide = width > 4 ? (width + 3) / 4 : 1;
+			const unsigned int blocksHigh = height > 4 ? (height + 3) / 4 : 1;
+			mipLevel.rowPitch = blocksWide * bytesPerElement;
+			mipLevel.size = mipLevel.rowPitch * blocksHigh;
+		}
+		else
+		{
+			mipLevel.rowPitch = width * bytesPerElement;
+			mipLevel.size = mipLevel.rowPitch * height;
+		}
+
+		if (offset + mipLevel.size > size)
+		{
+			logger->GetInstance().WriteLine("The DDS file '" + mFilename + "' ends part way through its mip chain.");
+			return false;
+		}
+
+		mipLevel.data = data + offset;
+		offset += mipLevel.size;
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	mFormat = format;
+	mNumberOfMipLevels = numberOfLevels;
+
+	if (forceOpaque)
+	{
+		// The only case which can't be used straight from the file.
+		mPixels.assign(mMipLevels[0].data, mMipLevels[numberOfLevels - 1].data + mMipLevels[numberOfLevels - 1].size);
+		for (size_t texel = 3; texel < mPixels.size(); texel += 4)
+		{
+			mPixels[texel] = 0xFF;
+		}
+
+		size_t levelOffset = 0;
+		for (unsigned int level = 0; level < numberOfLevels; level++)
+		{
+			mMipLevels[level].data = mPixels.data() + levelOffset;
+			levelOffset += mMipLevels[level].size;
+		}
+	}
+
+	if (generateMips && numberOfLevels == 1 && !compressed)
+	{
+		return GenerateMips();
+	}
+
+	return true;
+}
+
+/* Decode a PNG to 8 bit RGBA. Every colour type and bit depth is handled, but not interlaced images.
+* @Returns bool Success */
+bool CImage::DecodePNG(bool generateMips)
+{
+	const unsigned char* data = mFile.GetData();
+	const size_t size = mFile.GetSize();
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+	unsigned int bitDepth = 0;
+	unsigned int colourType = 0;
+	unsigned int interlaceMethod = 0;
+
+	unsigned char palette[256][4];
+	unsigned int paletteSize = 0;
+	memset(palette, 0xFF, sizeof(palette));
+
+	bool hasTransparentColour = false;
+	unsigned int transparentColour[3] = { 0, 0, 0 };
+
+	// Usually the image data is in a single chunk and can be decompressed straight from the file.
+	const unsigned char* imageData = nullptr;
+	size_t imageDataSize = 0;
+	std::vector<unsigned char> joinedImageData;
+
+	size_t offset = sizeof(kPNGSignature);
+	bool foundEnd = false;
+	while (!foundEnd)
+	{
+		if (offset + 12 > size)
+		{
+			logger->GetInstance().WriteLine("The PNG file '" + mFilename + "' ends before its last chunk.");
+			return false;
+		}
+
+		const unsigned int length = ReadBigEndian32(data + offset);
+		const unsigned int type = ReadBigEndian32(data + offset + 4);
+		const unsigned char* chunk = data + offset + 8;
+
+		if (length > size - offset - 12)
+		{
+			logger->GetInstance().WriteLine("The PNG file '" + mFilename + "' has a chunk which runs past the end of the file.");
+			return false;
+		}
+
+		switch (type)
+		{
+		case 0x49484452: // IHDR
+			if (length < 13 || chunk[10] != 0 || chunk[11] != 0)
+			{
+				logger->GetInstance().WriteLine("The PNG file '" + mFilename + "' has an invalid header.");
+				return false;
+			}
+			width = ReadBigEndian32(chunk);
+			height = ReadBigEndian32(chunk + 4);
+			bitDepth = chunk[8];
+			colourType = chunk[9];
+			interlaceMethod = chunk[12];
+			break;
+		case 0x504C5445: // PLTE
+			paletteSize = length / 3 > 256 ? 256 : length / 3;
+			for (unsigned int entry = 0; entry < paletteSize; entry++)
+			{
+				palette[entry][0] = chunk[entry * 3];
+				palette[entry][1] = chunk[entry * 3 + 1];
+				palette[entry][2] = chunk[entry * 3 + 2];
+			}
+			break;
+		case 0x74524E53: // tRNS
+			if (colourType == 3)
+			{
+				for (unsigned int entry = 0; entry < length && entry < 256; entry++)
+				{
+					palette[entry][3] = chunk[entry];
+				}
+			}
+			else if (colourType == 0 && length >= 2)
+			{
+				hasTransparentColour = true;
+				transparentColour[0] = (chunk[0] << 8) | chunk[1];
+			}
+			else if (colourType == 2 && length >= 6)
+			{
+				hasTransparentColour = true;
+				for (unsigned int channel = 0; channel < 3; channel++)
+				{
+					transparentColour[channel] = (chunk[channel * 2] << 8) | chunk[channel * 2 + 1];
+				}
+			}
+			break;
+		case 0x49444154: // IDAT
+			if (imageData == nullptr)
+			{
+				imageData = chunk;
+				imageDataSize = length;
+			}
+			else
+			{
+				if (joinedImageData.empty())
+				{
+					joinedImageData.assign(imageData, imageData + imageDataSize);
+				}
+				joinedImageData.insert(joinedImageData.end(), chunk, chunk + length);
+			}
+			break;
+		case 0x49454E44: // IEND
+			foundEnd = true;
+			break;
+		default:
+			break;
+		}
+
+		offset += 12 + length;
+	}
+
+	if (!joinedImageData.empty())
+	{
+		imageData = joinedImageData.data();
+		imageDataSize = joinedImageData.size();
+	}
+
+	unsigned int channels = 0;
+	switch (colourType)
+	{
+	case 0: channels = 1; break;
+	case 2: channels = 3; break;
+	case 3: channels = 1; break;
+	case 4: channels = 2; break;
+	case 6: channels = 4; break;
+	default: break;
+	}
+
+	const bool validDepth = bitDepth == 8 || (bitDepth == 16 && colourType != 3) ||
+		((bitDepth == 1 || bitDepth == 2 || bitDepth == 4) && (colourType == 0 || colourType == 3));
+
+	if (width == 0 || height == 0 || width > kMaxDimension || height > kMaxDimension || channels == 0 || !validDepth || imageData == nullptr ||
+		(colourType == 3 && paletteSize == 0))
+	{
+		logger->GetInstance().WriteLine("The PNG file '" + mFilename + "' has an invalid or unsupported header.");
+		return false;
+	}
+
+	if (interlaceMethod != 0)
+	{
+		// Rare enough in game assets to leave to D3DX.
+		return false;
+	}
+
+	const unsigned int bitsPerPixel = channels * bitDepth;
+	const size_t rowBytes = (static_cast<size_t>(width) * bitsPerPixel + 7) / 8;
+	const unsigned int bytesPerPixel = bitsPerPixel >= 8 ? bitsPerPixel / 8 : 1;
+
+	std::vector<unsigned char> filtered;
+	filtered.reserve(height * (rowBytes + 1));
+	if (!PrioEngine::Inflate::DecompressZlib(imageData, imageDataSize, filtered) || filtered.size() < height * (rowBytes + 1))
+	{
+		logger->GetInstance().WriteLine("Failed to decompress the image data of the PNG file '" + mFilename + "'.");
+		return false;
+	}
+
+	mPixels.resize(static_cast<size_t>(width) * height * 4);
+
+	const unsigned char* previousRow = nullptr;
+	for (unsigned int y = 0; y < height; y++)
+	{
+		unsigned char* row = filtered.data() + y * (rowBytes + 1);
+		const unsigned char filter = row[0];
+		row++;
+
+		if (!UnfilterRow(filter, row, previousRow, rowBytes, bytesPerPixel))
+		{
+			logger->GetInstance().WriteLine("The PNG file '" + mFilename + "' uses an unknown filter.");
+			return false;
+		}
+		previousRow = row;
+
+		unsigned char* output = mPixels.data() + static_cast<size_t>(y) * width * 4;
+
+		// The common layouts first, then everything else a texel at a time.
+		if (colourType == 6 && bitDepth == 8)
+		{
+			memcpy(output, row, rowBytes);
+			continue;
+		}
+
+		if (colourType == 2 && bitDepth == 8 && !hasTransparentColour)
+		{
+			for (unsigned int x = 0; x < width; x++)
+			{
+				output[x * 4] = row[x * 3];
+				output[x * 4 + 1] = row[x * 3 + 1];
+				output[x * 4 + 2] = row[x * 3 + 2];
+				output[x * 4 + 3] = 0xFF;
+			}
+			continue;
+		}
+
+		const unsigned int sampleMask = (1u << bitDepth) - 1;
+		for (unsigned int x = 0; x < width; x++)
+		{
+			unsigned int samples[4] = { 0, 0, 0, 0 };
+			for (unsigned int channel = 0; channel < channels; channel++)
+			{
+				const size_t sampleIndex = static_cast<size_t>(x) * channels + channel;
+				if (bitDepth == 16)
+				{
+					samples[channel] = (row[sampleIndex * 2] << 8) | row[sampleIndex * 2 + 1];
+				}
+				else if (bitDepth == 8)
+				{
+					samples[channel] = row[sampleIndex];
+				}
+				else
+				{
+					const size_t bit = sampleIndex * bitDepth;
+					samples[channel] = (row[bit / 8] >> (8 - bitDepth - (bit % 8))) & sampleMask;
+				}
+			}
+
+			unsigned char* texel = output + x * 4;
+
+			if (colourType == 3)
+			{
+				const unsigned int entry = samples[0] < paletteSize ? samples[0] : 0;
+				memcpy(texel, palette[entry], 4);
+				continue;
+			}
+
+			// Down to 8 bits, low bit depth greys are scaled up to cover the full range.
+			unsigned char values[4];
+			for (unsigned int channel = 0; channel < channels; channel++)
+			{
+				values[channel] = static_cast<unsigned char>(bitDepth == 16 ? samples[channel] >> 8 : samples[channel] * 255 / sampleMask);
+			}
+
+			if (channels <= 2)
+			{
+				texel[0] = values[0];
+				texel[1] = values[0];
+				texel[2] = values[0];
+				texel[3] = channels == 2 ? values[1] : 0xFF;
+
+				if (hasTransparentColour && samples[0] == transparentColour[0])
+				{
+					texel[3] = 0;
+				}
+			}
+			else
+			{
+				texel[0] = values[0];
+				texel[1] = values[1];
+				texel[2] = values[2];
+				texel[3] = channels == 4 ? values[3] : 0xFF;
+
+				if (hasTransparentColour && samples[0] == transparentColour[0] && samples[1] == transparentColour[1] && samples[2] == transparentColour[2])
+				{
+					texel[3] = 0;
+				}
+			}
+		}
+	}
+
+	SetTopLevel(RGBA8Format, mPixels.data(), width, height);
+
+	return generateMips ? GenerateMips() : true;
+}
+
+/* Decode an uncompressed or run length encoded TGA, in true colour or greyscale, to 8 bit RGBA.
+* @Returns bool Success */
+bool CImage::DecodeTGA(bool generateMips)
+{
+	const unsigned char* data = mFile.GetData();
+	const size_t size = mFile.GetSize();
+
+	if (size < 18)
+	{
+		logger->GetInstance().WriteLine("The TGA file '" + mFilename + "' is too small to hold a header.");
+		return false;
+	}
+
+	const unsigned int idLength = data[0];
+	const unsigned int colourMapType = data[1];
+	const unsigned int imageType = data[2];
+	const unsigned int width = data[12] | (data[13] << 8);
+	const unsigned int height = data[14] | (data[15] << 8);
+	const unsigned int bitsPerPixel = data[16];
+	const bool topDown = (data[17] & 0x20) != 0;
+
+	const bool greyscale = imageType == 3 || imageType == 11;
+	const bool runLengthEncoded = imageType == 10 || imageType == 11;
+	const bool supported = colourMapType == 0 &&
+		(((imageType == 2 || imageType == 10) && (bitsPerPixel == 24 || bitsPerPixel == 32)) || (greyscale && bitsPerPixel == 8));
+
+	if (!supported || width == 0 || height == 0)
+	{
+		return false;
+	}
+
+	const unsigned int bytesPerPixel = bitsPerPixel / 8;
+	const size_t numberOfTexels = static_cast<size_t>(width) * height;
+	size_t offset = 18 + idLength;
+
+	mPixels.resize(numberOfTexels * 4);
+
+	size_t texel = 0;
+	while (texel < numberOfTexels)
+	{
+		// Raw images are treated as a single packet of every texel.
+		size_t packetLength = numberOfTexels - texel;
+		bool repeated = false;
+
+		if (runLengthEncoded)
+		{
+			if (offset >= size)
+			{
+				break;
+			}
+			const unsigned char packetHeader = data[offset++];
+			packetLength = (packetHeader & 0x7F) + 1;
+			repeated = (packetHeader & 0x80) != 0;
+
+			if (texel + packetLength > numberOfTexels)
+			{
+				break;
+			}
+		}
+
+		const size_t bytesNeeded = repeated ? bytesPerPixel : packetLength * bytesPerPixel;
+		if (offset + bytesNeeded > size)
+		{
+			break;
+		}
+
+		for (size_t index = 0; index < packetLength; index++, texel++)
+		{
+			const unsigned char* source = data + offset + (repeated ? 0 : index * bytesPerPixel);
+
+			const size_t x = texel % width;
+			const size_t y = topDown ? texel / width : height - 1 - texel / width;
+			unsigned char* output = mPixels.data() + (y * width + x) * 4;
+
+			if (greyscale)
+			{
+				output[0] = source[0];
+				output[1] = source[0];
+				output[2] = source[0];
+				output[3] = 0xFF;
+			}
+			else
+			{
+				output[0] = source[2];
+				output[1] = source[1];
+				output[2] = source[0];
+				output[3] = bytesPerPixel == 4 ? source[3] : 0xFF;
+			}
+		}
+
+		offset += bytesNeeded;
+	}
+
+	if (texel < numberOfTexels)
+	{
+		logger->GetInstance().WriteLine("The TGA file '" + mFilename + "' ends before all of its texels.");
+		return false;
+	}
+
+	SetTopLevel(RGBA8Format, mPixels.data(), width, height);
+
+	return generateMips ? GenerateMips() : true;
+}
+
+void CImage::SetTopLevel(PixelFormat format, const unsigned char* data, unsigned int width, unsigned int height)
+{
+	mFormat = format;
+	mNumberOfMipLevels = 1;
+
+	mMipLevels[0].data = data;
+	mMipLevels[0].width = width;
+	mMipLevels[0].height = height;
+	mMipLevels[0].rowPitch = width * GetBytesPerElement(format);
+	mMipLevels[0].size = mMipLevels[0].rowPitch * height;
+}
+
+/* Fill in the rest of the mip chain from the top level, each level a 2x2 box filter of the one above.
+* @Returns bool Success */
+bool CImage::GenerateMips()
+{
+	if (IsBlockCompressed(mFormat) || mNumberOfMipLevels != 1)
+	{
+		return false;
+	}
+
+	unsigned int numberOfLevels = CalculateNumberOfMipLevels(mMipLevels[0].width, mMipLevels[0].height);
+	numberOfLevels = numberOfLevels < kMaxMipLevels ? numberOfLevels : kMaxMipLevels;
+
+	size_t totalSize = 0;
+	unsigned int width = mMipLevels[0].width;
+	unsigned int height = mMipLevels[0].height;
+	for (unsigned int level = 1; level < numberOfLevels; level++)
+	{
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+		totalSize += static_cast<size_t>(width) * height * 4;
+	}
+
+	mMipPixels.resize(totalSize);
+
+	size_t offset = 0;
+	for (unsigned int level = 1; level < numberOfLevels; level++)
+	{
+		const MipLevel& source = mMipLevels[level - 1];
+		MipLevel& mipLevel = mMipLevels[level];
+
+		mipLevel.width = source.width > 1 ? source.width / 2 : 1;
+		mipLevel.height = source.height > 1 ? source.height / 2 : 1;
+		mipLevel.rowPitch = mipLevel.width * 4;
+		mipLevel.size = mipLevel.rowPitch * mipLevel.height;
+		mipLevel.data = mMipPixels.data() + offset;
+
+		DownsampleLevel(source, mMipPixels.data() + offset, mipLevel.width, mipLevel.height);
+		offset += mipLevel.size;
+	}
+
+	mNumberOfMipLevels = numberOfLevels;
+
+	return true;
+}
+
+/* Averages each 2x2 block of 32 bit texels, rounding to nearest. Channels are treated alike, so the order doesn't matter.
+* Odd rows or columns at the far edge are dropped, the same as the sizes D3D expects for each level. */
+void CImage::DownsampleLevel(const MipLevel& source, unsigned char* destination, unsigned int width, unsigned int height)
+{
+	for (unsigned int y = 0; y < height; y++)
+	{
+		const unsigned int sourceY0 = y * 2 < source.height ? y * 2 : source.height - 1;
+		const unsigned int sourceY1 = y * 2 + 1 < source.height ? y * 2 + 1 : source.height - 1;
+		const unsigned char* row0 = source.data + static_cast<size_t>(sourceY0) * source.rowPitch;
+		const unsigned char* row1 = source.data + static_cast<size_t>(sourceY1) * source.rowPitch;
+		unsigned char* output = destination + static_cast<size_t>(y) * width * 4;
+
+		unsigned int x = 0;
+
+#ifdef IMAGE_USE_SSE2
+		// Four output texels from eight source texels on each row at a time, a source one texel wide has nothing to pair up.
+		if (source.width >= 2)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i rounding = _mm_set1_epi16(2);
+
+			for (; x + 4 <= width; x += 4)
+			{
+				const __m128i top0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+				const __m128i top1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8 + 16));
+				const __m128i bottom0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+				const __m128i bottom1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8 + 16));
+
+				// Widen to 16 bits and add the rows, two texels in each register.
+				const __m128i sum0 = _mm_add_epi16(_mm_unpacklo_epi8(top0, zero), _mm_unpacklo_epi8(bottom0, zero));
+				const __m128i sum1 = _mm_add_epi16(_mm_unpackhi_epi8(top0, zero), _mm_unpackhi_epi8(bottom0, zero));
+				const __m128i sum2 = _mm_add_epi16(_mm_unpacklo_epi8(top1, zero), _mm_unpacklo_epi8(bottom1, zero));
+				const __m128i sum3 = _mm_add_epi16(_mm_unpackhi_epi8(top1, zero), _mm_unpackhi_epi8(bottom1, zero));
+
+				// Then add each texel to its neighbour, by pairing the low and high halves.
+				__m128i average01 = _mm_add_epi16(_mm_unpacklo_epi64(sum0, sum1), _mm_unpackhi_epi64(sum0, sum1));
+				__m128i average23 = _mm_add_epi16(_mm_unpacklo_epi64(sum2, sum3), _mm_unpackhi_epi64(sum2, sum3));
+				average01 = _mm_srli_epi16(_mm_add_epi16(average01, rounding), 2);
+				average23 = _mm_srli_epi16(_mm_add_epi16(average23, rounding), 2);
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + x * 4), _mm_packus_epi16(average01, average23));
+			}
+		}
+#endif
+
+		for (; x < width; x++)
+		{
+			const unsigned int sourceX0 = x * 2 < source.width ? x * 2 : source.width - 1;
+			const unsigned int sourceX1 = x * 2 + 1 < source.width ? x * 2 + 1 : source.width - 1;
+
+			for (unsigned int channel = 0; channel < 4; channel++)
+			{
+				const unsigned int sum = row0[sourceX0 * 4 + channel] + row0[sourceX1 * 4 + channel] +
+					row1[sourceX0 * 4 + channel] + row1[sourceX1 * 4 + channel];
+				output[x * 4 + channel] = static_cast<unsigned char>((sum + 2) >> 2);
+			}
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <string>
+#include <vector>
+#include "Logger.h"
+#include "FileSystem.h"
+
+/* Reads DDS, PNG and TGA images without any help from D3DX, so it can run on any thread or platform. The file is read
+* through the file system, and the levels of a DDS file point straight into its data rather than being copied. PNG and TGA images
+* are decoded to 8 bit RGBA, and anything without a mip chain has one generated with a box filter.
+* Must not be released until whatever was created from the levels has finished with them. */
+class CImage
+{
+private:
+	CLogger* logger;
+public:
+	enum PixelFormat
+	{
+		UnknownFormat = 0,
+		RGBA8Format,
+		RGBA8SrgbFormat,
+		BGRA8Format,
+		BGRA8SrgbFormat,
+		BGRX8Format,
+		BC1Format,
+		BC1SrgbFormat,
+		BC2Format,
+		BC2SrgbFormat,
+		BC3Format,
+		BC3SrgbFormat,
+		BC4Format,
+		BC4SnormFormat,
+		BC5Format,
+		BC5SnormFormat,
+		BC6HUnsignedFormat,
+		BC6HSignedFormat,
+		BC7Format,
+		BC7SrgbFormat
+	};
+
+	struct MipLevel
+	{
+		const unsigned char* data;
+		unsigned int width;
+		unsigned int height;
+		// Bytes from one row of texels, or blocks for compressed formats, to the next.
+		unsigned int rowPitch;
+		unsigned int size;
+	};
+
+	static const unsigned int kMaxMipLevels = 16;
+public:
+	CImage();
+	~CImage();
+public:
+	// Open the file through the file system, nothing is decoded until Decode is called.
+	bool Open(const std::string& filename);
+	// Work out the format and levels of the image, decoding it if it isn't a DDS file.
+	// Returns false if the format isn't one which can be read, the file can still be handed to something else.
+	bool Decode(bool generateMips = true);
+	void Release();
+
+	const unsigned char* GetFileData() { return mFile.GetData(); };
+	size_t GetFileSize() { return mFile.GetSize(); };
+	const std::string& GetFilename() { return mFilename; };
+
+	bool IsDecoded() { return mFormat != UnknownFormat; };
+	PixelFormat GetFormat() { return mFormat; };
+	unsigned int GetWidth() { return mMipLevels[0].width; };
+	unsigned int GetHeight() { return mMipLevels[0].height; };
+	unsigned int GetNumberOfMipLevels() { return mNumberOfMipLevels; };
+	const MipLevel& GetMipLevel(unsigned int level) { return mMipLevels[level]; };
+
+	static bool IsBlockCompressed(PixelFormat format);
+	// Bytes per 4x4 block for compressed formats, per texel otherwise.
+	static unsigned int GetBytesPerElement(PixelFormat format);
+	static unsigned int CalculateNumberOfMipLevels(unsigned int width, unsigned int height);
+private:
+	bool ParseDDS(bool generateMips);
+	bool DecodePNG(bool generateMips);
+	bool DecodeTGA(bool generateMips);
+	void SetTopLevel(PixelFormat format, const unsigned char* data, unsigned int width, unsigned int height);
+	bool GenerateMips();
+	static void DownsampleLevel(const MipLevel& source, unsigned char* destination, unsigned int width, unsigned int height);
+private:
+	std::string mFilename;
+	CVirtualFile mFile;
+	// Decoded texels for images which couldn't be used straight from the file, and any generated mip levels.
+	std::vector<unsigned char> mPixels;
+	std::vector<unsigned char> mMipPixels;
+
+	PixelFormat mFormat;
+	unsigned int mNumberOfMipLevels;
+	MipLevel mMipLevels[kMaxMipLevels];
+};
+
+#endif
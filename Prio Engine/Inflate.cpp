@@ -0,0 +1,491 @@
+#include "Inflate.h"
+#include <cstring>
+
+namespace PrioEngine
+{
+	namespace Inflate
+	{
+		namespace
+		{
+			const unsigned int kMaxCodeLength = 15;
+			const unsigned int kNumberOfLengthCodes = 288;
+			const unsigned int kNumberOfDistanceCodes = 30;
+			// Codes up to this long are decoded with a single table lookup, longer ones are walked a bit at a time.
+			const unsigned int kFastBits = 10;
+
+			const unsigned short kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			const unsigned char kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			const unsigned short kDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			const unsigned char kDistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+			// The order the lengths of the code length alphabet are stored in.
+			const unsigned char kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+			struct Huffman
+			{
+				// The symbol shifted up by 4 with the code length in the low bits, 0 if the code is longer than kFastBits.
+				unsigned short fast[1 << kFastBits];
+				// Number of codes of each length, and the symbols ordered by their code.
+				unsigned short counts[kMaxCodeLength + 1];
+				unsigned short symbols[kNumberOfLengthCodes];
+			};
+
+			/* Reads the stream least significant bit first, holding up to 64 bits at a time. */
+			struct BitReader
+			{
+				const unsigned char* position;
+				const unsigned char* end;
+				unsigned long long buffer;
+				unsigned int numberOfBits;
+				// Set once more bits have been taken than the stream holds.
+				bool overrun;
+
+				void Refill()
+				{
+					while (numberOfBits <= 56)
+					{
+						if (position == end)
+						{
+							return;
+						}
+						buffer |= static_cast<unsigned long long>(*position++) << numberOfBits;
+						numberOfBits += 8;
+					}
+				}
+
+				unsigned int Peek(unsigned int count)
+				{
+					if (numberOfBits < count)
+					{
+						Refill();
+					}
+					return static_cast<unsigned int>(buffer & ((1ULL << count) - 1));
+				}
+
+				void Consume(unsigned int count)
+				{
+					if (count > numberOfBits)
+					{
+						overrun = true;
+						count = numberOfBits;
+					}
+					buffer >>= count;
+					numberOfBits -= count;
+				}
+
+				unsigned int Read(unsigned int count)
+				{
+					const unsigned int value = Peek(count);
+					Consume(count);
+					return value;
+				}
+			};
+
+			/* Builds the canonical code for a set of code lengths. Codes which don't use the whole code space are allowed,
+			* as the deflate spec permits a distance code with only one symbol.
+			* @Returns bool False if the lengths describe more codes than can exist.
+			*/
+			bool BuildHuffman(Huffman& huffman, const unsigned char* lengths, unsigned int numberOfSymbols)
+			{
+				memset(huffman.counts, 0, sizeof(huffman.counts));
+				memset(huffman.fast, 0, sizeof(huffman.fast));
+
+				for (unsigned int symbol = 0; symbol < numberOfSymbols; symbol++)
+				{
+					huffman.counts[lengths[symbol]]++;
+				}
+				huffman.counts[0] = 0;
+
+				int left = 1;
+				for (unsigned int length = 1; length <= kMaxCodeLength; length++)
+				{
+					left <<= 1;
+					left -= huffman.counts[length];
+					if (left < 0)
+					{
+						return false;
+					}
+				}
+
+				unsigned short offsets[kMaxCodeLength + 2];
+				offsets[1] = 0;
+				for (unsigned int length = 1; length <= kMaxCodeLength; length++)
+				{
+					offsets[length + 1] = offsets[length] + huffman.counts[length];
+				}
+
+				unsigned int nextCode[kMaxCodeLength + 1];
+				unsigned int code = 0;
+				for (unsigned int length = 1; length <= kMaxCodeLength; length++)
+				{
+					code = (code + huffman.counts[length - 1]) << 1;
+					nextCode[length] = code;
+				}
+				// counts[0] was cleared above, so the first length starts at zero as it should.
+
+				for (unsigned int symbol = 0; symbol < numberOfSymbols; symbol++)
+				{
+					const unsigned int length = lengths[symbol];
+					if (length == 0)
+					{
+						continue;
+					}
+
+					huffman.symbols[offsets[length]++] = static_cast<unsigned short>(symbol);
+
+					const unsigned int symbolCode = nextCode[length]++;
+					if (length > kFastBits)
+					{
+						continue;
+					}
+
+					// Codes are packed most significant bit first, but the reader works from the least significant end.
+					unsigned int reversed = 0;
+					for (unsigned int bit = 0; bit < length; bit++)
+					{
+						reversed |= ((symbolCode >> bit) & 1) << (length - 1 - bit);
+					}
+
+					for (unsigned int entry = reversed; entry < (1u << kFastBits); entry += 1u << length)
+					{
+						huffman.fast[entry] = static_cast<unsigned short>((symbol << 4) | length);
+					}
+				}
+
+				return true;
+			}
+
+			/* @Returns int The next symbol, or -1 if the bits don't form a valid code. */
+			int DecodeSymbol(BitReader& reader, const Huffman& huffman)
+			{
+				const unsigned int bits = reader.Peek(kMaxCodeLength);
+				const unsigned short entry = huffman.fast[bits & ((1u << kFastBits) - 1)];
+				if (entry != 0)
+				{
+					reader.Consume(entry & 0xF);
+					return entry >> 4;
+				}
+
+				// Longer than the fast table covers, walk the canonical code one bit at a time.
+				int code = 0;
+				int first = 0;
+				int index = 0;
+				for (unsigned int length = 1; length <= kMaxCodeLength; length++)
+				{
+					code |= (bits >> (length - 1)) & 1;
+					const int count = huffman.counts[length];
+					if (code - count < first)
+					{
+						reader.Consume(length);
+						return huffman.symbols[index + (code - first)];
+					}
+					index += count;
+					first += count;
+					first <<= 1;
+					code <<= 1;
+				}
+
+				return -1;
+			}
+
+			bool BuildFixedHuffman(Huffman& lengthCodes, Huffman& distanceCodes)
+			{
+				unsigned char lengths[kNumberOfLengthCodes];
+				unsigned int symbol = 0;
+				for (; symbol < 144; symbol++) lengths[symbol] = 8;
+				for (; symbol < 256; symbol++) lengths[symbol] = 9;
+				for (; symbol < 280; symbol++) lengths[symbol] = 7;
+				for (; symbol < kNumberOfLengthCodes; symbol++) lengths[symbol] = 8;
+
+				if (!BuildHuffman(lengthCodes, lengths, kNumberOfLengthCodes))
+				{
+					return false;
+				}
+
+				for (symbol = 0; symbol < kNumberOfDistanceCodes; symbol++) lengths[symbol] = 5;
+				return BuildHuffman(distanceCodes, lengths, kNumberOfDistanceCodes);
+			}
+
+			bool ReadDynamicHuffman(BitReader& reader, Huffman& lengthCodes, Huffman& distanceCodes)
+			{
+				const unsigned int numberOfLengthCodes = reader.Read(5) + 257;
+				const unsigned int numberOfDistanceCodes = reader.Read(5) + 1;
+				const unsigned int numberOfCodeLengthCodes = reader.Read(4) + 4;
+
+				if (numberOfLengthCodes > 286 || numberOfDistanceCodes > kNumberOfDistanceCodes)
+				{
+					return false;
+				}
+
+				unsigned char lengths[kNumberOfLengthCodes + kNumberOfDistanceCodes];
+				memset(lengths, 0, sizeof(lengths));
+
+				for (unsigned int index = 0; index < numberOfCodeLengthCodes; index++)
+				{
+					lengths[kCodeLengthOrder[index]] = static_cast<unsigned char>(reader.Read(3));
+				}
+
+				Huffman codeLengthCodes;
+				if (!BuildHuffman(codeLengthCodes, lengths, 19))
+				{
+					return false;
+				}
+
+				// The lengths of both alphabets are stored as one run, repeats may cross from one into the other.
+				const unsigned int total = numberOfLengthCodes + numberOfDistanceCodes;
+				unsigned int index = 0;
+				while (index < total)
+				{
+					const int symbol = DecodeSymbol(reader, codeLengthCodes);
+					if (symbol < 0)
+					{
+						return false;
+					}
+
+					if (symbol < 16)
+					{
+						lengths[index++] = static_cast<unsigned char>(symbol);
+						continue;
+					}
+
+					unsigned char repeated = 0;
+					unsigned int repeat = 0;
+					if (symbol == 16)
+					{
+						if (index == 0)
+						{
+							return false;
+						}
+						repeated = lengths[index - 1];
+						repeat = 3 + reader.Read(2);
+					}
+					else if (symbol == 17)
+					{
+						repeat = 3 + reader.Read(3);
+					}
+					else
+					{
+						repeat = 11 + reader.Read(7);
+					}
+
+					if (index + repeat > total)
+					{
+						return false;
+					}
+
+					while (repeat-- > 0)
+					{
+						lengths[index++] = repeated;
+					}
+				}
+
+				// Without an end of block code there'd be no way out of the block.
+				if (lengths[256] == 0)
+				{
+					return false;
+				}
+
+				return BuildHuffman(lengthCodes, lengths, numberOfLengthCodes) &&
+					BuildHuffman(distanceCodes, lengths + numberOfLengthCodes, numberOfDistanceCodes);
+			}
+
+			bool InflateBlock(BitReader& reader, const Huffman& lengthCodes, const Huffman& distanceCodes, std::vector<unsigned char>& destination, size_t& written)
+			{
+				for (;;)
+				{
+					const int symbol = DecodeSymbol(reader, lengthCodes);
+					if (symbol < 0 || reader.overrun)
+					{
+						return false;
+					}
+
+					if (symbol < 256)
+					{
+						if (written == destination.size())
+						{
+							destination.resize(destination.size() * 2 + 256);
+						}
+						destination[written++] = static_cast<unsigned char>(symbol);
+						continue;
+					}
+
+					if (symbol == 256)
+					{
+						return true;
+					}
+
+					const unsigned int lengthSymbol = static_cast<unsigned int>(symbol) - 257;
+					if (lengthSymbol >= 29)
+					{
+						return false;
+					}
+					const unsigned int length = kLengthBase[lengthSymbol] + reader.Read(kLengthExtra[lengthSymbol]);
+
+					const int distanceSymbol = DecodeSymbol(reader, distanceCodes);
+					if (distanceSymbol < 0 || distanceSymbol >= static_cast<int>(kNumberOfDistanceCodes))
+					{
+						return false;
+					}
+					const unsigned int distance = kDistanceBase[distanceSymbol] + reader.Read(kDistanceExtra[distanceSymbol]);
+
+					if (distance > written)
+					{
+						return false;
+					}
+
+					if (written + length > destination.size())
+					{
+						destination.resize((written + length) * 2);
+					}
+
+					// Byte by byte, as the source may overlap what's being written when the distance is short.
+					unsigned char* output = destination.data() + written;
+					const unsigned char* copy = output - distance;
+					for (unsigned int byte = 0; byte < length; byte++)
+					{
+						output[byte] = copy[byte];
+					}
+					written += length;
+				}
+			}
+
+			bool CopyStoredBlock(BitReader& reader, std::vector<unsigned char>& destination, size_t& written)
+			{
+				// Stored blocks start on a byte boundary.
+				reader.Consume(reader.numberOfBits & 7);
+
+				const unsigned int length = reader.Read(16);
+				const unsigned int inverseLength = reader.Read(16);
+				if (reader.overrun || (length ^ 0xFFFF) != inverseLength)
+				{
+					return false;
+				}
+
+				if (written + length > destination.size())
+				{
+					destination.resize((written + length) * 2);
+				}
+
+				// Drain whatever whole bytes are already in the bit buffer, then copy the rest straight from the stream.
+				unsigned int remaining = length;
+				while (remaining > 0 && reader.numberOfBits >= 8)
+				{
+					destination[written++] = static_cast<unsigned char>(reader.Read(8));
+					remaining--;
+				}
+
+				if (static_cast<size_t>(reader.end - reader.position) < remaining)
+				{
+					return false;
+				}
+
+				memcpy(destination.data() + written, reader.position, remaining);
+				reader.position += remaining;
+				written += remaining;
+
+				return true;
+			}
+		}
+
+		bool Decompress(const unsigned char* source, size_t sourceSize, std::vector<unsigned char>& destination)
+		{
+			BitReader reader;
+			reader.position = source;
+			reader.end = source + sourceSize;
+			reader.buffer = 0;
+			reader.numberOfBits = 0;
+			reader.overrun = false;
+
+			// Work in whatever space the caller reserved, trimmed back down to what was written at the end.
+			size_t written = destination.size();
+			destination.resize(destination.capacity() > written ? destination.capacity() : written + 256);
+
+			Huffman fixedLengthCodes;
+			Huffman fixedDistanceCodes;
+			bool fixedBuilt = false;
+
+			Huffman lengthCodes;
+			Huffman distanceCodes;
+
+			bool lastBlock = false;
+			bool success = true;
+			while (!lastBlock && success)
+			{
+				lastBlock = reader.Read(1) != 0;
+				const unsigned int blockType = reader.Read(2);
+
+				if (reader.overrun)
+				{
+					success = false;
+				}
+				else if (blockType == 0)
+				{
+					success = CopyStoredBlock(reader, destination, written);
+				}
+				else if (blockType == 1)
+				{
+					if (!fixedBuilt)
+					{
+						fixedBuilt = BuildFixedHuffman(fixedLengthCodes, fixedDistanceCodes);
+					}
+					success = fixedBuilt && InflateBlock(reader, fixedLengthCodes, fixedDistanceCodes, destination, written);
+				}
+				else if (blockType == 2)
+				{
+					success = ReadDynamicHuffman(reader, lengthCodes, distanceCodes) && InflateBlock(reader, lengthCodes, distanceCodes, destination, written);
+				}
+				else
+				{
+					success = false;
+				}
+			}
+
+			destination.resize(written);
+			return success && !reader.overrun;
+		}
+
+		bool DecompressZlib(const unsigned char* source, size_t sourceSize, std::vector<unsigned char>& destination)
+		{
+			if (sourceSize < 6)
+			{
+				return false;
+			}
+
+			const unsigned int method = source[0] & 0x0F;
+			const bool presetDictionary = (source[1] & 0x20) != 0;
+			if (method != 8 || presetDictionary || ((source[0] << 8) | source[1]) % 31 != 0)
+			{
+				return false;
+			}
+
+			const size_t start = destination.size();
+			if (!Decompress(source + 2, sourceSize - 6, destination))
+			{
+				return false;
+			}
+
+			// Adler-32 of the output, the modulo can be put off for 5552 bytes without overflowing.
+			const unsigned char* end = source + sourceSize;
+			const unsigned int expected = (end[-4] << 24) | (end[-3] << 16) | (end[-2] << 8) | end[-1];
+
+			unsigned int a = 1;
+			unsigned int b = 0;
+			const unsigned char* data = destination.data() + start;
+			size_t remaining = destination.size() - start;
+			while (remaining > 0)
+			{
+				const size_t run = remaining < 5552 ? remaining : 5552;
+				for (size_t byte = 0; byte < run; byte++)
+				{
+					a += data[byte];
+					b += a;
+				}
+				a %= 65521;
+				b %= 65521;
+				data += run;
+				remaining -= run;
+			}
+
+			return ((b << 16) | a) == expected;
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <vector>
+#include <cstddef>
+
+namespace PrioEngine
+{
+	/* Decompresses deflate streams, as used inside PNG files. Only needs the standard library so it can run anywhere. */
+	namespace Inflate
+	{
+		/* Decompress a raw deflate stream onto the end of the destination, which may be reserved up front if the size is known.
+		* @Returns bool Success, false if the stream is corrupt or ends early.
+		*/
+		bool Decompress(const unsigned char* source, size_t sourceSize, std::vector<unsigned char>& destination);
+
+		/* Decompress a deflate stream wrapped in a zlib header, checking the Adler-32 checksum at the end.
+		* @Returns bool Success
+		*/
+		bool DecompressZlib(const unsigned char* source, size_t sourceSize, std::vector<unsigned char>& destination);
+	}
+}
+
+#endif
@@ -67,6 +67,8 @@ void CLogger::Shutdown()
 /**  Write a piece of text to the debug log and add a new line.. */
 void CLogger::WriteLine(std::string text)
 {
+	std::lock_guard<std::mutex> lock(mWriteMutex);
+
 	if (mLoggingEnabled)
 	{
 		// Increment our line number.
@@ -90,6 +92,8 @@ void CLogger::WriteLine(std::string text)
 /*  Write a piece of text to the debug log and add a new line. Use typid(var).name() and pass it in as a variable. */
 void CLogger::MemoryAllocWriteLine(std::string name)
 {
+	std::lock_guard<std::mutex> lock(mWriteMutex);
+
 	if (mLoggingEnabled)
 	{
 		// Increment our line number.
@@ -110,6 +114,8 @@ void CLogger::MemoryAllocWriteLine(std::string name)
 /**  Write a piece of text to the debug log and add a new line.. */
 void CLogger::MemoryDeallocWriteLine(std::string name)
 {
+	std::lock_guard<std::mutex> lock(mWriteMutex);
+
 	if (mLoggingEnabled)
 	{
 		// Increment our line number.
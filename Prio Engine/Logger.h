@@ -3,12 +3,25 @@
 
 #include <typeinfo>
 #include <string>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <iostream>
 #include <fstream>
 #include <string.h>
 #include <iomanip>
 #include <list>
+#include <mutex>
+
+#ifndef _WIN32
+// There are no message boxes away from Windows, so problems with the log files go to the error stream instead.
+#define MB_OK 0
+inline int MessageBox(void*, const char* text, const char* caption, unsigned int)
+{
+	std::cerr << caption << " " << text << std::endl;
+	return 0;
+}
+#endif
 
 #ifdef _DEBUG
 #define _LOGGING_ENABLED
@@ -47,6 +60,8 @@ private:
 	std::ofstream mMemoryLogFile;
 	// A boolean flag which is toggled on / off depending on if _LOGGING_ENABLED is defined by the preprocessor and successfully opening the log file.
 	bool mLoggingEnabled;
+	// Lines can be written from the asset loading threads, so writes are serialised.
+	std::mutex mWriteMutex;
 public:
 	void WriteSubtitle(std::string name);
 	void WriteLine(std::string text);
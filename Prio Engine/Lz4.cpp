@@ -0,0 +1,206 @@
+#include "Lz4.h"
+#include <cstring>
+
+namespace PrioEngine
+{
+	namespace Lz4
+	{
+		namespace
+		{
+			const unsigned int kMinMatch = 4;
+			// The format requires the last five bytes to be literals, and no match to start in the last twelve.
+			const size_t kLastLiterals = 5;
+			const size_t kMatchFindLimit = 12;
+			const size_t kMaxOffset = 65535;
+			const unsigned int kHashBits = 16;
+			// After this many misses in a row the search starts skipping ahead, so incompressible data goes by quickly.
+			const unsigned int kSkipTrigger = 6;
+
+			unsigned int Read32(const unsigned char* data)
+			{
+				unsigned int value;
+				memcpy(&value, data, sizeof(value));
+				return value;
+			}
+
+			unsigned int Hash(unsigned int sequence)
+			{
+				return (sequence * 2654435761U) >> (32 - kHashBits);
+			}
+
+			void WriteLength(std::vector<unsigned char>& destination, size_t length)
+			{
+				while (length >= 255)
+				{
+					destination.push_back(255);
+					length -= 255;
+				}
+				destination.push_back(static_cast<unsigned char>(length));
+			}
+
+			void WriteSequence(std::vector<unsigned char>& destination, const unsigned char* literals, size_t numberOfLiterals, size_t offset, size_t matchLength)
+			{
+				const size_t matchCode = matchLength - kMinMatch;
+				const unsigned char token = static_cast<unsigned char>(((numberOfLiterals < 15 ? numberOfLiterals : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+				destination.push_back(token);
+
+				if (numberOfLiterals >= 15)
+				{
+					WriteLength(destination, numberOfLiterals - 15);
+				}
+				destination.insert(destination.end(), literals, literals + numberOfLiterals);
+
+				destination.push_back(static_cast<unsigned char>(offset & 0xFF));
+				destination.push_back(static_cast<unsigned char>(offset >> 8));
+
+				if (matchCode >= 15)
+				{
+					WriteLength(destination, matchCode - 15);
+				}
+			}
+
+			/* Lengths over 15 carry on in following bytes, each 255 meaning there's another to come.
+			* @Returns bool False if the block ends part way through the length. */
+			bool ReadLength(const unsigned char*& position, const unsigned char* end, size_t& length)
+			{
+				unsigned char byte;
+				do
+				{
+					if (position == end)
+					{
+						return false;
+					}
+					byte = *position++;
+					length += byte;
+				} while (byte == 255);
+
+				return true;
+			}
+		}
+
+		/* Greedy matching against a single hash table of the last position each four byte sequence was seen at. */
+		void Compress(const unsigned char* source, size_t sourceSize, std::vector<unsigned char>& destination)
+		{
+			destination.clear();
+			destination.reserve(sourceSize + sourceSize / 255 + 16);
+
+			size_t anchor = 0;
+
+			if (sourceSize > kMatchFindLimit)
+			{
+				std::vector<unsigned int> table(1 << kHashBits, 0xFFFFFFFF);
+				const size_t matchStartLimit = sourceSize - kMatchFindLimit;
+				const size_t matchEndLimit = sourceSize - kLastLiterals;
+
+				size_t position = 0;
+				unsigned int misses = 0;
+				while (position < matchStartLimit)
+				{
+					const unsigned int sequence = Read32(source + position);
+					const unsigned int hash = Hash(sequence);
+					const size_t candidate = table[hash];
+					table[hash] = static_cast<unsigned int>(position);
+
+					if (candidate == 0xFFFFFFFF || position - candidate > kMaxOffset || Read32(source + candidate) != sequence)
+					{
+						misses++;
+						position += 1 + (misses >> kSkipTrigger);
+						continue;
+					}
+
+					misses = 0;
+
+					size_t matchLength = kMinMatch;
+					while (position + matchLength < matchEndLimit && source[candidate + matchLength] == source[position + matchLength])
+					{
+						matchLength++;
+					}
+
+					WriteSequence(destination, source + anchor, position - anchor, position - candidate, matchLength);
+					position += matchLength;
+					anchor = position;
+				}
+			}
+
+			// Whatever is left over goes out as literals on their own.
+			const size_t numberOfLiterals = sourceSize - anchor;
+			destination.push_back(static_cast<unsigned char>((numberOfLiterals < 15 ? numberOfLiterals : 15) << 4));
+			if (numberOfLiterals >= 15)
+			{
+				WriteLength(destination, numberOfLiterals - 15);
+			}
+			destination.insert(destination.end(), source + anchor, source + sourceSize);
+		}
+
+		bool Decompress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize)
+		{
+			const unsigned char* position = source;
+			const unsigned char* end = source + sourceSize;
+			size_t written = 0;
+
+			while (position < end)
+			{
+				const unsigned char token = *position++;
+
+				size_t numberOfLiterals = token >> 4;
+				if (numberOfLiterals == 15 && !ReadLength(position, end, numberOfLiterals))
+				{
+					return false;
+				}
+
+				if (numberOfLiterals > static_cast<size_t>(end - position) || numberOfLiterals > destinationSize - written)
+				{
+					return false;
+				}
+
+				memcpy(destination + written, position, numberOfLiterals);
+				position += numberOfLiterals;
+				written += numberOfLiterals;
+
+				// The last sequence is only literals.
+				if (position == end)
+				{
+					break;
+				}
+
+				if (end - position < 2)
+				{
+					return false;
+				}
+
+				const size_t offset = position[0] | (static_cast<size_t>(position[1]) << 8);
+				position += 2;
+
+				size_t matchLength = token & 0x0F;
+				if (matchLength == 15 && !ReadLength(position, end, matchLength))
+				{
+					return false;
+				}
+				matchLength += kMinMatch;
+
+				if (offset == 0 || offset > written || matchLength > destinationSize - written)
+				{
+					return false;
+				}
+
+				unsigned char* output = destination + written;
+				const unsigned char* match = output - offset;
+				if (offset >= matchLength)
+				{
+					memcpy(output, match, matchLength);
+				}
+				else
+				{
+					// Overlapping, so the bytes being copied are still being written and have to go one at a time.
+					for (size_t byte = 0; byte < matchLength; byte++)
+					{
+						output[byte] = match[byte];
+					}
+				}
+				written += matchLength;
+			}
+
+			return written == destinationSize;
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <vector>
+#include <cstddef>
+
+namespace PrioEngine
+{
+	/* Compresses and decompresses the LZ4 block format, used for entries in pack files. Decompression is cheap enough to
+	* run as files are opened, compression is only done when packing. */
+	namespace Lz4
+	{
+		/* Compress a block of memory, replacing whatever was in the destination.
+		*/
+		void Compress(const unsigned char* source, size_t sourceSize, std::vector<unsigned char>& destination);
+
+		/* Decompress a block which must come out at exactly the destination size.
+		* @Returns bool Success, false if the block is corrupt or doesn't match the size given.
+		*/
+		bool Decompress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize);
+	}
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "Engine.h"
 #include "PrioEngineVars.h"
+#include "TextureCooker.h"
+#include "FileSystem.h"
 
 // Declaration of functions used to run game itself.
 void GameLoop(CEngine* &engine);
@@ -14,6 +16,52 @@ int WINAPI WinMain(HINSTANCE hInstance,	HINSTANCE hPrevInstance, LPSTR lpCmdLine
 #if defined(DEBUG) | defined(_DEBUG)
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
+	const bool cook = strstr(lpCmdLine, "-cook") != nullptr;
+	const bool pack = strstr(lpCmdLine, "-pack") != nullptr;
+	const bool shaders = strstr(lpCmdLine, "-shaders") != nullptr;
+
+	// Cook every model and texture up front rather than as each one is first loaded, compile the shaders, and pack the
+	// results, then exit without starting the engine.
+	if (cook || pack || shaders)
+	{
+		if (cook)
+		{
+			unsigned int numberOfCooked = CCookedMesh::CookDirectory("Resources/Models", kMeshImportFlags);
+			// The sky box is imported with its own flags and no levels of detail, so needs cooking separately.
+			CCookedMesh::Cook("Resources/Models/Sphere.fbx", kSkyBoxImportFlags, kSkyBoxLodSettings);
+			logger->GetInstance().WriteLine("Cooked " + std::to_string(numberOfCooked) + " models.");
+
+			// Fonts are left alone, block compression smudges the edges of the glyphs.
+			CTextureCooker textureCooker("Resources/TextureManifest.txt");
+			textureCooker.CookDirectory("Resources/Textures");
+			textureCooker.CookDirectory("Resources/Patch Maps");
+			textureCooker.CookDirectory("Resources/Normal Maps");
+			textureCooker.SaveManifest();
+			logger->GetInstance().WriteLine("Cooked " + std::to_string(textureCooker.GetNumberOfCooked()) + " textures, " +
+				std::to_string(textureCooker.GetNumberUpToDate()) + " were already up to date.");
+		}
+
+		if (shaders)
+		{
+			unsigned int numberOfCompiled = CShader::PrecompileShaders();
+			CShaderCache::GetInstance().LogStatistics();
+			logger->GetInstance().WriteLine("Compiled " + std::to_string(numberOfCompiled) + " shaders.");
+		}
+
+		if (pack)
+		{
+			// Everything the engine reads at startup, so it's all mapped in one go rather than opened file by file.
+			std::vector<std::string> directories;
+			directories.push_back("Resources");
+			directories.push_back("Shaders");
+			directories.push_back(kShaderCacheDirectory);
+			CPackFile::Build(kResourcePackFile, directories);
+		}
+
+		logger->GetInstance().Shutdown();
+		return 0;
+	}
+
 	// Start the game engine.
 	CEngine* PrioEngine;
 	bool result;
@@ -0,0 +1,135 @@
+#include "MappedFile.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+CMappedFile::CMappedFile()
+{
+#ifdef _WIN32
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = NULL;
+#else
+	mFile = -1;
+#endif
+	mpData = nullptr;
+	mSize = 0;
+}
+
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool CMappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	mFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart == 0)
+	{
+		// Empty files can't be mapped.
+		Close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mMapping == NULL)
+	{
+		logger->GetInstance().WriteLine("Failed to create a file mapping for '" + filename + "'.");
+		Close();
+		return false;
+	}
+
+	mpData = static_cast<const unsigned char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mpData == nullptr)
+	{
+		logger->GetInstance().WriteLine("Failed to map a view of '" + filename + "'.");
+		Close();
+		return false;
+	}
+
+	mSize = static_cast<size_t>(fileSize.QuadPart);
+
+	return true;
+}
+#else
+bool CMappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	mFile = open(filename.c_str(), O_RDONLY);
+	if (mFile == -1)
+	{
+		return false;
+	}
+
+	struct stat fileStatus;
+	if (fstat(mFile, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		// Empty files can't be mapped.
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (data == MAP_FAILED)
+	{
+		logger->GetInstance().WriteLine("Failed to map a view of '" + filename + "'.");
+		Close();
+		return false;
+	}
+
+	mpData = static_cast<const unsigned char*>(data);
+	mSize = static_cast<size_t>(fileStatus.st_size);
+
+	return true;
+}
+#endif
+
+void CMappedFile::Close()
+{
+#ifdef _WIN32
+	if (mpData != nullptr)
+	{
+		UnmapViewOfFile(mpData);
+		mpData = nullptr;
+	}
+
+	if (mMapping != NULL)
+	{
+		CloseHandle(mMapping);
+		mMapping = NULL;
+	}
+
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (mpData != nullptr)
+	{
+		munmap(const_cast<unsigned char*>(mpData), mSize);
+		mpData = nullptr;
+	}
+
+	if (mFile != -1)
+	{
+		close(mFile);
+		mFile = -1;
+	}
+#endif
+
+	mSize = 0;
+}
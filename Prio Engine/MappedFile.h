@@ -0,0 +1,37 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include "Logger.h"
+
+/* A read only view of a file on disk which has been mapped into memory, the contents are paged in by the OS as they are touched. */
+class CMappedFile
+{
+private:
+	CLogger* logger;
+public:
+	CMappedFile();
+	~CMappedFile();
+public:
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen() { return mpData != nullptr; };
+	const unsigned char* GetData() { return mpData; };
+	size_t GetSize() { return mSize; };
+private:
+	// Can't be copied, as the handles would be closed twice.
+	CMappedFile(const CMappedFile&);
+	CMappedFile& operator=(const CMappedFile&);
+private:
+#ifdef _WIN32
+	HANDLE mFile;
+	HANDLE mMapping;
+#else
+	int mFile;
+#endif
+	const unsigned char* mpData;
+	size_t mSize;
+};
+
+#endif
@@ -1,12 +1,47 @@
 #include "Mesh.h"
+#include "StateCache.h"
+#include <map>
+#include <algorithm>
+#include <cfloat>
 
-CMesh::CMesh(ID3D11Device* device)
+const unsigned int CMesh::kNoChunk;
+
+namespace
+{
+	CRenderDevice::IndexFormat GetIndexFormat(const VertexLayout& layout)
+	{
+		return layout.indexFormat == DXGI_FORMAT_R16_UINT ? CRenderDevice::Index16 : CRenderDevice::Index32;
+	}
+
+	CRenderDevice::Buffer* CreateImmutableBuffer(CRenderDevice* renderDevice, CRenderDevice::BufferType type, unsigned int size, const void* data)
+	{
+		CRenderDevice::BufferDesc bufferDesc;
+		bufferDesc.type = type;
+		bufferDesc.usage = CRenderDevice::ImmutableUsage;
+		bufferDesc.size = size;
+		return renderDevice->CreateBuffer(bufferDesc, data);
+	}
+}
+
+CMesh::CMesh(ID3D11Device* device, CRenderDevice* renderDevice, CTransformSystem* transformSystem, CResourceCache* resourceCache)
 {
 	// Initialise our counter variables to the default values.
 	mVertexCount = 0;
 	mIndexCount = 0;
+	numberOfSubMaterials = 0;
+	mNumberOfSubMeshes = 0;
+	mpSubMeshes = nullptr;
+	mSubMeshMaterials = nullptr;
+
+	for (unsigned int lod = 0; lod < CCookedMesh::kMaxLods; lod++)
+	{
+		mLodScreenSizes[lod] = FLT_MAX;
+	}
 
 	mpDevice = device;
+	mpRenderDevice = renderDevice;
+	mpTransformSystem = transformSystem;
+	mpResourceCache = resourceCache;
 }
 
 CMesh::~CMesh()
@@ -15,19 +50,45 @@ CMesh::~CMesh()
 
 void CMesh::Shutdown()
 {
-	for (unsigned int i = 0; i < mNumberOfSubMeshes; i++)
+	// Stop the loader creating anything for this mesh if it's still loading.
+	CAssetLoader::Cancel(mLoadRequest);
+
+	for (int i = 0; i < numberOfSubMaterials; i++)
 	{
 		for (unsigned int t = 0; t < mNumberOfTextures; t++)
 		{
+			// Still loading, so this is the loader's placeholder rather than a texture of our own.
+			if (mSubMeshMaterials[i].mLoadRequests[t] != nullptr)
+			{
+				CAssetLoader::Cancel(mSubMeshMaterials[i].mLoadRequests[t]);
+				mSubMeshMaterials[i].mTextures[t] = nullptr;
+			}
+
 			if (mSubMeshMaterials[i].mTextures[t] != nullptr)
 			{
-				mSubMeshMaterials[i].mTextures[t]->Release();
+				if (mSubMeshMaterials[i].mResourceCaches[t] != nullptr)
+				{
+					mSubMeshMaterials[i].mResourceCaches[t]->ReleaseTexture(mSubMeshMaterials[i].mTextures[t]);
+				}
+				else
+				{
+					mSubMeshMaterials[i].mTextures[t]->Release();
+				}
 				mSubMeshMaterials[i].mTextures[t] = nullptr;
 			}
 		}
 	}
+	ReleaseStaticBatches();
+
+	for (unsigned int subMesh = 0; subMesh < mNumberOfSubMeshes; subMesh++)
+	{
+		mpRenderDevice->DestroyBuffer(mpSubMeshes[subMesh].vertexBuffer);
+		mpRenderDevice->DestroyBuffer(mpSubMeshes[subMesh].indexBuffer);
+	}
+
 	delete[] mpSubMeshes;
 	delete[] mSubMeshMaterials;
+	mDrawMaterials.clear();
 
 	for (auto model : mpModels)
 	{
@@ -57,77 +118,172 @@ bool CMesh::LoadMesh(std::string filename, float modelRadius)
 	return result;
 }
 
-void CMesh::Render(ID3D11DeviceContext* context, CFrustum* frustum, CDiffuseLightShader* shader, CLight* light, D3DXVECTOR3 cameraPos)
+/* Hand the mesh to the asset loader, which reads or cooks it on a worker then calls CreateFromCookedMesh at the start of a frame. */
+bool CMesh::LoadMeshAsync(CAssetLoader* assetLoader, std::string filename, float modelRadius, CAssetLoader::CompletionCallback callback)
 {
-	for (unsigned int subMeshCount = 0; subMeshCount < mNumberOfSubMeshes; subMeshCount++)
+	mRadius = modelRadius;
+	if (filename.empty())
 	{
-		unsigned int offset;
-		unsigned int stride;
-		stride = sizeof(VertexType);
-		offset = 0;
+		logger->GetInstance().WriteLine("You need to pass in a file name to load a model.");
+		return false;
+	}
 
-		// Set the vertex buffer to active in the input assembler so it can be rendered.
-		context->IASetVertexBuffers(0, 1, &mpSubMeshes[subMeshCount].vertexBuffer, &stride, &offset);
+	mFilename = filename;
 
-		// Set the index buffer to active in the input assembler so it can be rendered.
-		context->IASetIndexBuffer(mpSubMeshes[subMeshCount].indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	logger->GetInstance().WriteLine("Queued " + mFilename + " to be loaded in the background.");
+	mLoadRequest = assetLoader->LoadMesh(filename, [this, assetLoader](CCookedMesh& cookedMesh) { return CreateFromCookedMesh(cookedMesh, assetLoader); }, callback);
+	return true;
+}
 
-		// Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-		context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+/* Queue a draw for each instance the visibility system found to be visible from the given view, and one for each batch
+* of the static chunks drawn as a whole. Only the world matrix is written per draw, into the shared draw constants. */
+void CMesh::AddToDrawList(CDrawList* drawList, unsigned int view, CDiffuseLightShader* shader, CSharedConstants* sharedConstants, const D3DXVECTOR3& cameraPosition)
+{
+	// Nothing from this mesh is visible, don't bother setting up any packets.
+	if (!HasVisibleModels(view) && mVisibleChunks[view].empty())
+	{
+		return;
+	}
 
-		bool useAlpha = mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures[1] != NULL ? true : false;
-		bool useSpecular = mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures[2] != NULL ? true : false;
-		shader->UpdateMapBuffer(context, useAlpha, useSpecular);
+	if (mDrawMaterials.size() != static_cast<size_t>(numberOfSubMaterials))
+	{
+		CreateDrawMaterials(shader);
+	}
 
-		for (auto model : mpModels)
-		{
-			model->UpdateMatrices();
+	CSharedConstants::DrawConstants objectData;
+	CDrawList::DrawPacket packet;
+	packet.objectBuffer = sharedConstants->GetDrawBuffer();
 
-			float distance = std::abs(cameraPos.x - model->GetPosX()) +
-				std::abs(cameraPos.y - model->GetPosY()) +
-				std::abs(cameraPos.z - model->GetPosZ());
+	for (unsigned int subMeshCount = 0; subMeshCount < mNumberOfSubMeshes; subMeshCount++)
+	{
+		const SubMesh& subMesh = mpSubMeshes[subMeshCount];
+		const CDrawList::Material& material = mDrawMaterials[subMesh.materialIndex];
 
-			if (distance < mLevelOfDetail)
-			{
+		packet.pipelineState = shader->GetPipelineState(subMesh.layout.vertexFormat);
+		packet.material = &material;
+		packet.vertexBuffer = subMesh.vertexBuffer;
+		packet.vertexStride = subMesh.layout.vertexStride;
+		packet.indexBuffer = subMesh.indexBuffer;
+		packet.indexFormat = GetIndexFormat(subMesh.layout);
 
-				bool inFrustum = true;
-				inFrustum = frustum->CheckSphere(model->GetPos(), model->GetScaleRadius(mRadius));
+		const unsigned int pipelineId = shader->GetPipelineStateId(subMesh.layout.vertexFormat);
 
-				if (inFrustum)
-				{
-					shader->SetWorldMatrix(model->GetWorldMatrix());
+		for (unsigned int lod = 0; lod < mNumberOfLods; lod++)
+		{
+			// Each level of detail is a range of the one index buffer.
+			packet.firstIndex = subMesh.lodFirstIndex[lod];
+			packet.indexCount = subMesh.lodNumberOfIndices[lod];
 
-					// Pass over the textures for rendering.
-					if (!shader->Render(context, mpSubMeshes[subMeshCount].numberOfIndices,
-						mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures, mNumberOfTextures,
-						light->GetDirection(), light->GetDiffuseColour(), light->GetAmbientColour()))
-					{
-						logger->GetInstance().WriteLine("Failed to render the mesh model.");
-					}
+			// Only walk the instances which passed culling for this view.
+			for (auto modelIndex : mVisibleModels[view][lod])
+			{
+				CModel* model = mpModels[modelIndex];
 
+				// Models tracked by the transform system already had their matrices rebuilt this frame.
+				if (!model->HasTransformSystem())
+				{
+					model->UpdateMatrices();
 				}
+
+				// Quantised positions are scaled back into model space before the world transform.
+				CSharedConstants::WriteDrawConstants(objectData, subMesh.layout.dequantiseMatrix * model->GetWorldMatrix());
+
+				D3DXVECTOR3 toModel = model->GetWorldPosition() - cameraPosition;
+				packet.sortKey = CDrawList::MakeSortKey(CDrawList::OpaquePass, pipelineId, material.id, D3DXVec3Length(&toModel));
+				drawList->Add(packet, &objectData, sizeof(objectData));
+			}
+		}
+	}
+
+	// Chunks far enough away are drawn as a whole, their vertices are already in world space.
+	D3DXMATRIX identity;
+	D3DXMatrixIdentity(&identity);
+	CSharedConstants::WriteDrawConstants(objectData, identity);
+
+	packet.pipelineState = shader->GetPipelineState(FloatVertexFormat);
+	packet.vertexStride = sizeof(VertexType);
+	packet.indexFormat = CRenderDevice::Index32;
+	packet.firstIndex = 0;
+	const unsigned int pipelineId = shader->GetPipelineStateId(FloatVertexFormat);
+
+	for (auto chunkIndex : mVisibleChunks[view])
+	{
+		StaticChunk& chunk = mStaticChunks[chunkIndex];
+		D3DXVECTOR3 toChunk = (chunk.minBounds + chunk.maxBounds) * 0.5f - cameraPosition;
+		const float depth = D3DXVec3Length(&toChunk);
+
+		packet.vertexBuffer = chunk.vertexBuffer;
+
+		for (auto& batch : chunk.batches)
+		{
+			const CDrawList::Material& material = mDrawMaterials[batch.materialIndex];
+			packet.material = &material;
+			packet.indexBuffer = batch.indexBuffer;
+			packet.indexCount = batch.numberOfIndices;
+			packet.sortKey = CDrawList::MakeSortKey(CDrawList::OpaquePass, pipelineId, material.id, depth);
+			drawList->Add(packet, &objectData, sizeof(objectData));
+		}
+	}
+}
+
+/* Wrap the textures of each material for the render device, along with which maps the shader should sample. */
+void CMesh::CreateDrawMaterials(CDiffuseLightShader* shader)
+{
+	mDrawMaterials.resize(numberOfSubMaterials);
+
+	for (int materialIndex = 0; materialIndex < numberOfSubMaterials; materialIndex++)
+	{
+		CDrawList::Material& material = mDrawMaterials[materialIndex];
+		material.id = CDrawList::AllocateStateId();
+		material.numberOfTextures = mNumberOfTextures;
+		for (unsigned int texture = 0; texture < mNumberOfTextures; texture++)
+		{
+			material.textures[texture] = CD3D11RenderDevice::WrapTexture(mSubMeshMaterials[materialIndex].mTextures[texture]);
+		}
+
+		bool useAlpha = mSubMeshMaterials[materialIndex].mTextures[1] != NULL;
+		bool useSpecular = mSubMeshMaterials[materialIndex].mTextures[2] != NULL;
+		material.constantBuffer = shader->GetMapBuffer(useAlpha, useSpecular);
+	}
+}
+
+void CMesh::UpdateMatrices(unsigned int view)
+{
+	for (unsigned int lod = 0; lod < mNumberOfLods; lod++)
+	{
+		for (auto modelIndex : mVisibleModels[view][lod])
+		{
+			// Models tracked by the transform system already had their matrices rebuilt this frame.
+			if (!mpModels[modelIndex]->HasTransformSystem())
+			{
+				mpModels[modelIndex]->UpdateMatrices();
 			}
 		}
 	}
 }
 
-void CMesh::Render(ID3D11DeviceContext * context, CFrustum * frustum, CReflectRefractShader * shader, D3DXVECTOR3 cameraPos)
+void CMesh::Render(ID3D11DeviceContext * context, unsigned int view, CReflectRefractShader * shader)
 {
+	if (!HasVisibleModels(view) && mVisibleChunks[view].empty())
+	{
+		return;
+	}
+
 	for (unsigned int subMeshCount = 0; subMeshCount < mNumberOfSubMeshes; subMeshCount++)
 	{
 		unsigned int offset;
 		unsigned int stride;
-		stride = sizeof(VertexType);
+		stride = mpSubMeshes[subMeshCount].layout.vertexStride;
 		offset = 0;
 
 		// Set the vertex buffer to active in the input assembler so it can be rendered.
-		context->IASetVertexBuffers(0, 1, &mpSubMeshes[subMeshCount].vertexBuffer, &stride, &offset);
-
-		// Set the index buffer to active in the input assembler so it can be rendered.
-		context->IASetIndexBuffer(mpSubMeshes[subMeshCount].indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		ID3D11Buffer* vertexBuffer = CD3D11RenderDevice::GetNativeBuffer(mpSubMeshes[subMeshCount].vertexBuffer);
+		CStateCache::Get(context)->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
 
 		// Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-		context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		CStateCache::Get(context)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		shader->SetVertexFormat(mpSubMeshes[subMeshCount].layout.vertexFormat);
 
 		bool useAlpha = mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures[1] != NULL ? true : false;
 		bool useSpecular = mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures[2] != NULL ? true : false;
@@ -137,53 +293,92 @@ void CMesh::Render(ID3D11DeviceContext * context, CFrustum * frustum, CReflectRe
 		shader->SetModelTex(mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures);
 		shader->SetModelTexCount(mNumberOfTextures);
 
-		for (auto model : mpModels)
+		for (unsigned int lod = 0; lod < mNumberOfLods; lod++)
 		{
-			model->UpdateMatrices();
+			if (mVisibleModels[view][lod].empty())
+			{
+				continue;
+			}
 
-			float distance = std::abs(cameraPos.x - model->GetPosX()) +
-							 std::abs(cameraPos.y - model->GetPosY()) +
-							 std::abs(cameraPos.z - model->GetPosZ());
+			// Each level of detail is a range of the one index buffer, so switching between them is just a change of offset.
+			CStateCache::Get(context)->IASetIndexBuffer(CD3D11RenderDevice::GetNativeBuffer(mpSubMeshes[subMeshCount].indexBuffer), mpSubMeshes[subMeshCount].layout.indexFormat,
+				mpSubMeshes[subMeshCount].lodFirstIndex[lod] * mpSubMeshes[subMeshCount].layout.indexStride);
 
-			if (distance < mLevelOfDetail)
+			// Only walk the instances which passed culling for this view.
+			for (auto modelIndex : mVisibleModels[view][lod])
 			{
+				CModel* model = mpModels[modelIndex];
 
-				bool inFrustum = true;
-				inFrustum = frustum->CheckSphere(model->GetPos(), model->GetScaleRadius(mRadius));
+				// Quantised positions are scaled back into model space before the world transform.
+				shader->SetWorldMatrix(mpSubMeshes[subMeshCount].layout.dequantiseMatrix * model->GetWorldMatrix());
 
-				if (inFrustum)
+				// Pass over the textures for rendering.
+				if (!shader->RenderModelRefraction(context, mpSubMeshes[subMeshCount].lodNumberOfIndices[lod]))
 				{
-					shader->SetWorldMatrix(model->GetWorldMatrix());
+					logger->GetInstance().WriteLine("Failed to render the mesh model.");
+				}
+			}
+		}
+	}
 
-					// Pass over the textures for rendering.
-					if (!shader->RenderModelRefraction(context, mpSubMeshes[subMeshCount].numberOfIndices))
-					{
-						logger->GetInstance().WriteLine("Failed to render the mesh model.");
-					}
+	// Chunks far enough away are drawn as a whole, their vertices are already in world space.
+	D3DXMATRIX identity;
+	D3DXMatrixIdentity(&identity);
+	shader->SetVertexFormat(FloatVertexFormat);
 
-				}
+	for (auto chunkIndex : mVisibleChunks[view])
+	{
+		StaticChunk& chunk = mStaticChunks[chunkIndex];
+		unsigned int offset = 0;
+		unsigned int stride = sizeof(VertexType);
+
+		ID3D11Buffer* vertexBuffer = CD3D11RenderDevice::GetNativeBuffer(chunk.vertexBuffer);
+		CStateCache::Get(context)->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+		CStateCache::Get(context)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		for (auto& batch : chunk.batches)
+		{
+			CStateCache::Get(context)->IASetIndexBuffer(CD3D11RenderDevice::GetNativeBuffer(batch.indexBuffer), DXGI_FORMAT_R32_UINT, 0);
+
+			bool useAlpha = mSubMeshMaterials[batch.materialIndex].mTextures[1] != NULL ? true : false;
+			bool useSpecular = mSubMeshMaterials[batch.materialIndex].mTextures[2] != NULL ? true : false;
+
+			shader->SetUseSpecular(useSpecular);
+			shader->SetUseAlpha(useAlpha);
+			shader->SetModelTex(mSubMeshMaterials[batch.materialIndex].mTextures);
+			shader->SetModelTexCount(mNumberOfTextures);
+			shader->SetWorldMatrix(identity);
+
+			if (!shader->RenderModelRefraction(context, batch.numberOfIndices))
+			{
+				logger->GetInstance().WriteLine("Failed to render a static batch of the mesh.");
 			}
 		}
 	}
 }
 
-void CMesh::RenderReflection(ID3D11DeviceContext * context, CFrustum * frustum, CReflectRefractShader * shader, D3DXVECTOR3 cameraPos)
+void CMesh::RenderReflection(ID3D11DeviceContext * context, unsigned int view, CReflectRefractShader * shader)
 {
+	if (!HasVisibleModels(view) && mVisibleChunks[view].empty())
+	{
+		return;
+	}
+
 	for (unsigned int subMeshCount = 0; subMeshCount < mNumberOfSubMeshes; subMeshCount++)
 	{
 		unsigned int offset;
 		unsigned int stride;
-		stride = sizeof(VertexType);
+		stride = mpSubMeshes[subMeshCount].layout.vertexStride;
 		offset = 0;
 
 		// Set the vertex buffer to active in the input assembler so it can be rendered.
-		context->IASetVertexBuffers(0, 1, &mpSubMeshes[subMeshCount].vertexBuffer, &stride, &offset);
-
-		// Set the index buffer to active in the input assembler so it can be rendered.
-		context->IASetIndexBuffer(mpSubMeshes[subMeshCount].indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+		ID3D11Buffer* vertexBuffer = CD3D11RenderDevice::GetNativeBuffer(mpSubMeshes[subMeshCount].vertexBuffer);
+		CStateCache::Get(context)->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
 
 		// Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-		context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		CStateCache::Get(context)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		shader->SetVertexFormat(mpSubMeshes[subMeshCount].layout.vertexFormat);
 
 		bool useAlpha = mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures[1] != NULL ? true : false;
 		bool useSpecular = mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures[2] != NULL ? true : false;
@@ -193,36 +388,108 @@ void CMesh::RenderReflection(ID3D11DeviceContext * context, CFrustum * frustum,
 		shader->SetModelTex(mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures);
 		shader->SetModelTexCount(mNumberOfTextures);
 
-		for (auto model : mpModels)
+		for (unsigned int lod = 0; lod < mNumberOfLods; lod++)
 		{
-			model->UpdateMatrices();
+			if (mVisibleModels[view][lod].empty())
+			{
+				continue;
+			}
 
-			float distance = std::abs(cameraPos.x - model->GetPosX()) +
-				std::abs(cameraPos.y - model->GetPosY()) +
-				std::abs(cameraPos.z - model->GetPosZ());
+			// Each level of detail is a range of the one index buffer, so switching between them is just a change of offset.
+			CStateCache::Get(context)->IASetIndexBuffer(CD3D11RenderDevice::GetNativeBuffer(mpSubMeshes[subMeshCount].indexBuffer), mpSubMeshes[subMeshCount].layout.indexFormat,
+				mpSubMeshes[subMeshCount].lodFirstIndex[lod] * mpSubMeshes[subMeshCount].layout.indexStride);
 
-			if (distance < mLevelOfDetail)
+			// Only walk the instances which passed culling for this view.
+			for (auto modelIndex : mVisibleModels[view][lod])
 			{
+				CModel* model = mpModels[modelIndex];
 
-				bool inFrustum = true;
-				inFrustum = frustum->CheckSphere(model->GetPos(), model->GetScaleRadius(mRadius));
+				// Quantised positions are scaled back into model space before the world transform.
+				shader->SetWorldMatrix(mpSubMeshes[subMeshCount].layout.dequantiseMatrix * model->GetWorldMatrix());
 
-				if (inFrustum)
+				// Pass over the textures for rendering.
+				if (!shader->RenderModelReflection(context, mpSubMeshes[subMeshCount].lodNumberOfIndices[lod]))
 				{
-					shader->SetWorldMatrix(model->GetWorldMatrix());
+					logger->GetInstance().WriteLine("Failed to render the mesh model.");
+				}
+			}
+		}
+	}
 
-					// Pass over the textures for rendering.
-					if (!shader->RenderModelReflection(context, mpSubMeshes[subMeshCount].numberOfIndices))
-					{
-						logger->GetInstance().WriteLine("Failed to render the mesh model.");
-					}
+	// Chunks far enough away are drawn as a whole, their vertices are already in world space.
+	D3DXMATRIX identity;
+	D3DXMatrixIdentity(&identity);
+	shader->SetVertexFormat(FloatVertexFormat);
 
-				}
+	for (auto chunkIndex : mVisibleChunks[view])
+	{
+		StaticChunk& chunk = mStaticChunks[chunkIndex];
+		unsigned int offset = 0;
+		unsigned int stride = sizeof(VertexType);
+
+		ID3D11Buffer* vertexBuffer = CD3D11RenderDevice::GetNativeBuffer(chunk.vertexBuffer);
+		CStateCache::Get(context)->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+		CStateCache::Get(context)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+		for (auto& batch : chunk.batches)
+		{
+			CStateCache::Get(context)->IASetIndexBuffer(CD3D11RenderDevice::GetNativeBuffer(batch.indexBuffer), DXGI_FORMAT_R32_UINT, 0);
+
+			bool useAlpha = mSubMeshMaterials[batch.materialIndex].mTextures[1] != NULL ? true : false;
+			bool useSpecular = mSubMeshMaterials[batch.materialIndex].mTextures[2] != NULL ? true : false;
+
+			shader->SetUseSpecular(useSpecular);
+			shader->SetUseAlpha(useAlpha);
+			shader->SetModelTex(mSubMeshMaterials[batch.materialIndex].mTextures);
+			shader->SetModelTexCount(mNumberOfTextures);
+			shader->SetWorldMatrix(identity);
+
+			if (!shader->RenderModelReflection(context, batch.numberOfIndices))
+			{
+				logger->GetInstance().WriteLine("Failed to render a static batch of the mesh.");
 			}
 		}
 	}
 }
 
+bool CMesh::HasVisibleModels(unsigned int view)
+{
+	for (unsigned int lod = 0; lod < mNumberOfLods; lod++)
+	{
+		if (!mVisibleModels[view][lod].empty())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Start from the level the instance was last drawn at, and only move once the screen size is comfortably past the
+* switching point, so an instance sat right on the boundary doesn't keep flicking between levels.
+@Returns unsigned int The level of detail to draw at. */
+unsigned int CMesh::SelectLod(float screenSize, unsigned int previousLod)
+{
+	if (mNumberOfLods <= 1)
+	{
+		return 0;
+	}
+
+	unsigned int lod = previousLod < mNumberOfLods ? previousLod : mNumberOfLods - 1;
+
+	while (lod + 1 < mNumberOfLods && screenSize < mLodScreenSizes[lod + 1] * (1.0f - kLodHysteresis))
+	{
+		lod++;
+	}
+
+	while (lod > 0 && screenSize > mLodScreenSizes[lod] * (1.0f + kLodHysteresis))
+	{
+		lod--;
+	}
+
+	return lod;
+}
+
 /* Create an instance of this mesh.
 @Returns CModel* ptr
  */
@@ -238,111 +505,326 @@ CModel* CMesh::CreateModel()
 		return nullptr;
 	}
 
+	// Let the transform system take care of the world matrix from now on.
+	if (mpTransformSystem != nullptr)
+	{
+		mpTransformSystem->Register(model);
+	}
+
 	// Stick our models on a list to prevent losing the pointers.
 	mpModels.push_back(model);
 
+	// The new model needs adding to a batch.
+	if (mStaticBatchingEnabled)
+	{
+		mStaticBatchesDirty = true;
+	}
+
 	//return model;
 	return model;
 }
 
-/* Load a model using our assimp vertex manager.
+void CMesh::EnableStaticBatching(float chunkSize, float batchDistanceScale)
+{
+	if (chunkSize <= 0.0f)
+	{
+		logger->GetInstance().WriteLine("Static batching needs a chunk size greater than zero.");
+		return;
+	}
+
+	mStaticBatchingEnabled = true;
+	mStaticBatchesDirty = true;
+	mStaticChunkSize = chunkSize;
+	mStaticBatchDistanceScale = batchDistanceScale;
+}
+
+bool CMesh::UpdateStaticBatches()
+{
+	if (!mStaticBatchingEnabled || !mStaticBatchesDirty)
+	{
+		return true;
+	}
+
+	mStaticBatchesDirty = false;
+	return BakeStaticBatches();
+}
+
+/* Sort every instance into a square chunk based on its position, then copy the geometry of each instance in a chunk into
+* one vertex buffer with its world matrix already applied. Submeshes sharing a material end up in the same index buffer,
+* so a chunk costs one draw per material no matter how many instances it holds. Batches are only drawn from a distance,
+* so are baked from the second level of detail where there is one. The geometry is read back from the cooked file rather
+* than kept on the CPU, as a bake only happens when the instances change. */
+bool CMesh::BakeStaticBatches()
+{
+	ReleaseStaticBatches();
+
+	const unsigned int batchLod = mNumberOfLods > 1 ? 1 : 0;
+
+	// Nothing to read back until the mesh has finished loading, every chunk just comes out empty.
+	CCookedMesh cookedMesh;
+	if (mNumberOfSubMeshes > 0)
+	{
+		// Falls back on a full load for when the cooked file couldn't be written and the imported data was used directly.
+		if (!cookedMesh.Remap(mFilename, kMeshImportFlags) && !cookedMesh.Load(mFilename, kMeshImportFlags))
+		{
+			logger->GetInstance().WriteLine("Failed to read back the geometry of mesh '" + mFilename + "' to bake static batches.");
+			return false;
+		}
+
+		if (cookedMesh.GetNumberOfSubMeshes() != mNumberOfSubMeshes)
+		{
+			logger->GetInstance().WriteLine("The cooked copy of mesh '" + mFilename + "' has changed since it was loaded, not baking static batches.");
+			return false;
+		}
+	}
+
+	// Which models fall into each chunk, keyed on the chunk's grid coordinates.
+	std::map<std::pair<int, int>, std::vector<unsigned int>> chunkModels;
+	for (unsigned int modelIndex = 0; modelIndex < mpModels.size(); modelIndex++)
+	{
+		D3DXVECTOR3 position = mpModels[modelIndex]->GetWorldPosition();
+		int chunkX = static_cast<int>(std::floor(position.x / mStaticChunkSize));
+		int chunkZ = static_cast<int>(std::floor(position.z / mStaticChunkSize));
+		chunkModels[std::make_pair(chunkX, chunkZ)].push_back(modelIndex);
+	}
+
+	mModelChunks.assign(mpModels.size(), kNoChunk);
+
+	std::vector<VertexType> vertices;
+	std::map<int, std::vector<unsigned int>> materialIndices;
+
+	for (auto& cell : chunkModels)
+	{
+		StaticChunk chunk;
+		chunk.vertexBuffer = nullptr;
+		chunk.minBounds = D3DXVECTOR3(FLT_MAX, FLT_MAX, FLT_MAX);
+		chunk.maxBounds = D3DXVECTOR3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+		vertices.clear();
+		materialIndices.clear();
+
+		for (auto modelIndex : cell.second)
+		{
+			CModel* model = mpModels[modelIndex];
+
+			if (!model->HasTransformSystem())
+			{
+				model->UpdateMatrices();
+			}
+			D3DXMATRIX world = model->GetWorldMatrix();
+
+			for (unsigned int subMeshCount = 0; subMeshCount < mNumberOfSubMeshes; subMeshCount++)
+			{
+				const SubMesh& subMesh = mpSubMeshes[subMeshCount];
+				const CCookedMesh::SubMeshRecord& record = cookedMesh.GetSubMesh(subMeshCount);
+				const VertexType* sourceVertices = reinterpret_cast<const VertexType*>(cookedMesh.GetVertices() + record.firstVertex);
+				const unsigned int* sourceIndices = cookedMesh.GetIndices() + record.firstIndex;
+				const unsigned int baseVertex = static_cast<unsigned int>(vertices.size());
+
+				for (unsigned int vertexIndex = 0; vertexIndex < record.numberOfVertices; vertexIndex++)
+				{
+					const VertexType& source = sourceVertices[vertexIndex];
+					VertexType vertex = source;
+					D3DXVec3TransformCoord(&vertex.position, &source.position, &world);
+					D3DXVec3TransformNormal(&vertex.normal, &source.normal, &world);
+					D3DXVec3Normalize(&vertex.normal, &vertex.normal);
+
+					chunk.minBounds.x = std::min(chunk.minBounds.x, vertex.position.x);
+					chunk.minBounds.y = std::min(chunk.minBounds.y, vertex.position.y);
+					chunk.minBounds.z = std::min(chunk.minBounds.z, vertex.position.z);
+					chunk.maxBounds.x = std::max(chunk.maxBounds.x, vertex.position.x);
+					chunk.maxBounds.y = std::max(chunk.maxBounds.y, vertex.position.y);
+					chunk.maxBounds.z = std::max(chunk.maxBounds.z, vertex.position.z);
+
+					vertices.push_back(vertex);
+				}
+
+				std::vector<unsigned int>& indices = materialIndices[subMesh.materialIndex];
+				const unsigned int firstIndex = subMesh.lodFirstIndex[batchLod];
+				for (unsigned int index = firstIndex; index < firstIndex + subMesh.lodNumberOfIndices[batchLod]; index++)
+				{
+					indices.push_back(baseVertex + sourceIndices[index]);
+				}
+			}
+		}
+
+		if (vertices.empty())
+		{
+			continue;
+		}
+
+		chunk.vertexBuffer = CreateImmutableBuffer(mpRenderDevice, CRenderDevice::VertexBuffer,
+			static_cast<unsigned int>(sizeof(VertexType) * vertices.size()), vertices.data());
+		if (chunk.vertexBuffer == nullptr)
+		{
+			logger->GetInstance().WriteLine("Failed to create the vertex buffer for a static chunk of mesh '" + mFilename + "'.");
+			ReleaseStaticBatches();
+			return false;
+		}
+
+		for (auto& material : materialIndices)
+		{
+			StaticBatch batch;
+			batch.materialIndex = material.first;
+			batch.numberOfIndices = static_cast<int>(material.second.size());
+			batch.indexBuffer = CreateImmutableBuffer(mpRenderDevice, CRenderDevice::IndexBuffer,
+				static_cast<unsigned int>(sizeof(unsigned int) * material.second.size()), material.second.data());
+
+			if (batch.indexBuffer == nullptr)
+			{
+				logger->GetInstance().WriteLine("Failed to create the index buffer for a static chunk of mesh '" + mFilename + "'.");
+				chunk.batches.push_back(batch);
+				mStaticChunks.push_back(chunk);
+				ReleaseStaticBatches();
+				return false;
+			}
+
+			chunk.batches.push_back(batch);
+		}
+
+		for (auto modelIndex : cell.second)
+		{
+			mModelChunks[modelIndex] = static_cast<unsigned int>(mStaticChunks.size());
+		}
+		mStaticChunks.push_back(chunk);
+	}
+
+	for (auto view = 0u; view < CVisibilitySystem::kMaxViews; view++)
+	{
+		mVisibleChunks[view].clear();
+		mChunkStates[view].assign(mStaticChunks.size(), ChunkCulled);
+	}
+
+	logger->GetInstance().WriteLine("Baked " + std::to_string(mpModels.size()) + " instances of '" + mFilename + "' into " +
+		std::to_string(mStaticChunks.size()) + " static chunks.");
+
+	return true;
+}
+
+void CMesh::ReleaseStaticBatches()
+{
+	for (auto& chunk : mStaticChunks)
+	{
+		if (chunk.vertexBuffer != nullptr)
+		{
+			mpRenderDevice->DestroyBuffer(chunk.vertexBuffer);
+			chunk.vertexBuffer = nullptr;
+		}
+
+		for (auto& batch : chunk.batches)
+		{
+			if (batch.indexBuffer != nullptr)
+			{
+				mpRenderDevice->DestroyBuffer(batch.indexBuffer);
+				batch.indexBuffer = nullptr;
+			}
+		}
+	}
+
+	mStaticChunks.clear();
+	mModelChunks.clear();
+
+	for (auto view = 0u; view < CVisibilitySystem::kMaxViews; view++)
+	{
+		mVisibleChunks[view].clear();
+		mChunkStates[view].clear();
+	}
+}
+
+/* Load a model from its cooked copy, which is only imported through assimp if it's missing or out of date.
 @Returns bool Success*/
 bool CMesh::LoadAssimpModel(std::string filename)
 {
-	Assimp::Importer importer;
 	const std::string name = filename;
-	logger->GetInstance().WriteLine("Attempting to open " + name + " using Assimp.");
-
-	// Read in the file, store this mesh in the scene.
-	const aiScene* scene = importer.ReadFile(filename, aiProcess_ConvertToLeftHanded | aiProcess_Triangulate | aiProcess_SortByPType);
+	logger->GetInstance().WriteLine("Attempting to open " + name + ".");
 
-	// If scene hasn't been initialised then something has gone wrong!
-	if (!scene)
+	CCookedMesh cookedMesh;
+	if (!cookedMesh.Load(filename, kMeshImportFlags))
 	{
-		logger->GetInstance().WriteLine(importer.GetErrorString());
-		logger->GetInstance().WriteLine("Failed to create scene.");
+		logger->GetInstance().WriteLine("Failed to load cooked mesh.");
 		return false;
 	}
 
-	mNumberOfSubMeshes = scene->mNumMeshes;
+	return CreateFromCookedMesh(cookedMesh);
+}
 
-	int rootNode = 1;
+/* Create the textures and buffers for every submesh of a cooked mesh. With an asset loader, only the buffers are created
+here and each texture is queued on the loader, so nothing is read from disk or decoded on the main thread.
+@Returns bool Success*/
+bool CMesh::CreateFromCookedMesh(CCookedMesh& cookedMesh, CAssetLoader* assetLoader)
+{
+	// Only set once every submesh exists, so nothing tries to draw a half created mesh.
+	const unsigned int numberOfSubMeshes = cookedMesh.GetNumberOfSubMeshes();
+	numberOfSubMaterials = cookedMesh.GetNumberOfMaterials();
+	mNumberOfLods = cookedMesh.GetNumberOfLods();
+
+	// A level is good enough once its error, scaled the same way as the radius, would cover less than the allowed screen error.
+	for (unsigned int lod = 0; lod < CCookedMesh::kMaxLods; lod++)
+	{
+		const float error = lod < mNumberOfLods ? cookedMesh.GetLodError(lod) : 0.0f;
+		mLodScreenSizes[lod] = lod == 0 || error <= 0.0f ? FLT_MAX : kMaxLodScreenError * mRadius / error;
+	}
 
 	// Allocate memory to the sub mesh.
-	mSubMeshMaterials = new MaterialType[mNumberOfSubMeshes];
+	mSubMeshMaterials = new MaterialType[numberOfSubMaterials];
 
 	///////////////////////////////////////////////
 	// Define sub mesh materials.
 	///////////////////////////////////////////////
 
-	for (unsigned int materialCount = 0; materialCount < mNumberOfSubMeshes; materialCount++)
+	// Default the textures to be a nullptr, so nothing is released twice if a texture fails to load part way through.
+	for (int materialCount = 0; materialCount < numberOfSubMaterials; materialCount++)
 	{
-		// Default the textures to be a nullptr.
 		for (int textureCount = 0; textureCount < mNumberOfTextures; textureCount++)
 		{
 			mSubMeshMaterials[materialCount].mTextures[textureCount] = nullptr;
+			mSubMeshMaterials[materialCount].mResourceCaches[textureCount] = nullptr;
 		}
+	}
 
-		aiMaterial* material = scene->mMaterials[materialCount];
-		aiString diffuseMapName;
-		aiString alphaMapName;
-		aiString specularMapName;
+	const std::string kTextureTypeNames[mNumberOfTextures] = { "diffuse map", "alpha map", "specular map" };
+
+	for (int materialCount = 0; materialCount < numberOfSubMaterials; materialCount++)
+	{
+		const CCookedMesh::MaterialRecord& material = cookedMesh.GetMaterial(materialCount);
 		HRESULT result;
 		std::string sDir = "Resources/Textures/";
 
-		///////////////////////////////
-		// Diffuse map
-		if (material->GetTexture(aiTextureType_DIFFUSE, 0, &diffuseMapName) == AI_SUCCESS)
+		for (int textureCount = 0; textureCount < mNumberOfTextures; textureCount++)
 		{
-			std::string sTextureName = diffuseMapName.C_Str();
-			std::string sFullPath = sDir + sTextureName;
-
-			// Load in the texture.
-			result = D3DX11CreateShaderResourceViewFromFile(mpDevice, sFullPath.c_str(), NULL, NULL, &mSubMeshMaterials[materialCount].mTextures[0], NULL);
-
-			if (FAILED(result))
+			// No texture of this type on the material.
+			if (material.textures[textureCount][0] == '\0')
 			{
-				logger->GetInstance().WriteLine("Failed to load the diffuse map for texture " + sFullPath);
-				return false;
+				continue;
 			}
-			logger->GetInstance().WriteLine("Successfully loaded diffuse map named '" + sFullPath + "'.");
-		}
-
 
-		////////////////////////////////////
-		// Alpha map.
-		if (scene->mMaterials[materialCount]->GetTexture(aiTextureType_OPACITY, 0, &alphaMapName) == AI_SUCCESS)
-		{
-			std::string sTextureName = alphaMapName.C_Str();
+			std::string sTextureName = material.textures[textureCount];
 			std::string sFullPath = sDir + sTextureName;
 
-			// Load in the texture.
-			result = D3DX11CreateShaderResourceViewFromFile(mpDevice, sFullPath.c_str(), NULL, NULL, &mSubMeshMaterials[materialCount].mTextures[1], NULL);
-
-			if (FAILED(result))
+			if (assetLoader != nullptr)
 			{
-				logger->GetInstance().WriteLine("Failed to load the alpha map " + sFullPath);
-				return false;
+				LoadMaterialTextureAsync(assetLoader, materialCount, textureCount, sFullPath);
+				continue;
 			}
-			logger->GetInstance().WriteLine("Successfully loaded alpha map named '" + sFullPath + "'.");
-		}
 
-		////////////////////////
-		// Specular map.
-		if (scene->mMaterials[materialCount]->GetTexture(aiTextureType_SPECULAR, 0, &specularMapName) == AI_SUCCESS)
-		{
-			std::string sTextureName = specularMapName.C_Str();
-			std::string sFullPath = sDir + sTextureName;
-
-			// Load in the texture.
-			result = D3DX11CreateShaderResourceViewFromFile(mpDevice, sFullPath.c_str(), NULL, NULL, &mSubMeshMaterials[materialCount].mTextures[2], NULL);
+			// Load in the texture, meshes sharing a material share the one copy of it through the cache.
+			if (mpResourceCache != nullptr)
+			{
+				mSubMeshMaterials[materialCount].mTextures[textureCount] = mpResourceCache->LoadTexture(mpDevice, sFullPath);
+				mSubMeshMaterials[materialCount].mResourceCaches[textureCount] = mpResourceCache;
+				result = mSubMeshMaterials[materialCount].mTextures[textureCount] != nullptr ? S_OK : E_FAIL;
+			}
+			else
+			{
+				result = CTexture::CreateFromFile(mpDevice, sFullPath, &mSubMeshMaterials[materialCount].mTextures[textureCount]) ? S_OK : E_FAIL;
+			}
 
 			if (FAILED(result))
 			{
-				logger->GetInstance().WriteLine("Failed to load the specular map " + sFullPath);
+				logger->GetInstance().WriteLine("Failed to load the " + kTextureTypeNames[textureCount] + " " + sFullPath);
 				return false;
 			}
-			logger->GetInstance().WriteLine("Successfully loaded specular map named '" + sFullPath + "'.");
+			logger->GetInstance().WriteLine("Successfully loaded " + kTextureTypeNames[textureCount] + " named '" + sFullPath + "'.");
 		}
 	}
 
@@ -350,12 +832,28 @@ bool CMesh::LoadAssimpModel(std::string filename)
 	// Define sub meshes.
 	/////////////////////////////////////////////////////////////////////////
 
-	mpSubMeshes = new SubMesh[mNumberOfSubMeshes];
+	mpSubMeshes = new SubMesh[numberOfSubMeshes];
 
-	for (unsigned int meshCount = 0; meshCount < mNumberOfSubMeshes; meshCount++)
+	for (unsigned int meshCount = 0; meshCount < numberOfSubMeshes; meshCount++)
 	{
-		if (!CreateSubmesh(*scene->mMeshes[meshCount], &mpSubMeshes[meshCount]))
+		if (!CreateSubmesh(cookedMesh, cookedMesh.GetSubMesh(meshCount), &mpSubMeshes[meshCount]))
+		{
+			// The count isn't set yet, so Shutdown won't see the submeshes which were created before this one.
+			for (unsigned int createdCount = 0; createdCount < meshCount; createdCount++)
+			{
+				mpRenderDevice->DestroyBuffer(mpSubMeshes[createdCount].vertexBuffer);
+				mpRenderDevice->DestroyBuffer(mpSubMeshes[createdCount].indexBuffer);
+			}
 			return false;
+		}
+	}
+
+	mNumberOfSubMeshes = numberOfSubMeshes;
+
+	// Any instances created while the mesh was loading were baked without any geometry.
+	if (mStaticBatchingEnabled)
+	{
+		mStaticBatchesDirty = true;
 	}
 
 	logger->GetInstance().WriteLine("Successfully initialised our arrays for mesh '" + mFilename + "'. ");
@@ -368,100 +866,118 @@ bool CMesh::LoadAssimpModel(std::string filename)
 	return true;
 }
 
-bool CMesh::CreateSubmesh(const aiMesh& mesh, SubMesh* subMesh)
+/* Queue a material texture on the asset loader, with the placeholder in its slot until it's ready. The map is in use from
+the start, so the shader is set up for it straight away and only the texture is swapped over once it has been created. */
+void CMesh::LoadMaterialTextureAsync(CAssetLoader* assetLoader, int materialIndex, int textureIndex, const std::string& filename)
 {
-	VertexType* vertices = new VertexType[mesh.mNumVertices];
-	const int kNumberOfIndicesInFace = 3;
-	int numberOfIndices = mesh.mNumFaces * kNumberOfIndicesInFace;
-	unsigned int* indices = new unsigned int[numberOfIndices];
+	MaterialType& material = mSubMeshMaterials[materialIndex];
+	material.mTextures[textureIndex] = assetLoader->GetPlaceholderTexture();
 
-	for (unsigned int vertex = 0; vertex < mesh.mNumVertices; vertex++)
+	// Cancelled by Shutdown if the mesh goes first, so the callback never outlives the mesh.
+	material.mLoadRequests[textureIndex] = assetLoader->LoadTexture(filename, [this, materialIndex, textureIndex, filename](bool success)
 	{
-		vertices[vertex].position = { mesh.mVertices[vertex].x, mesh.mVertices[vertex].y, mesh.mVertices[vertex].z };
-		vertices[vertex].uv = { mesh.mTextureCoords[0][vertex].x , mesh.mTextureCoords[0][vertex].y };
-		vertices[vertex].normal = { mesh.mNormals[vertex].x, mesh.mNormals[vertex].y, mesh.mNormals[vertex].z };
-	}
+		MaterialType& material = mSubMeshMaterials[materialIndex];
+		CAssetLoader::AssetHandle& request = material.mLoadRequests[textureIndex];
 
-	int index = 0;
-	for (unsigned int i = 0; i < mesh.mNumFaces; i++)
-	{
-		if (mesh.mFaces[i].mNumIndices == 3)
+		if (success)
 		{
-			indices[index] = mesh.mFaces[i].mIndices[0];
-			index++;
-			indices[index] = mesh.mFaces[i].mIndices[1];
-			index++;
-			indices[index] = mesh.mFaces[i].mIndices[2];
-			index++;
+			// Take ownership of the texture from the request.
+			material.mTextures[textureIndex] = request->texture;
+			material.mResourceCaches[textureIndex] = request->resourceCache;
+			request->texture = nullptr;
 		}
-	}
+		else
+		{
+			// Drawn without this map rather than with the placeholder forever.
+			material.mTextures[textureIndex] = nullptr;
+			logger->GetInstance().WriteLine("Failed to load the texture '" + filename + "' for mesh '" + mFilename + "'.");
+		}
+		request.reset();
 
-	subMesh->faces = mesh.mFaces;
-	subMesh->numberOfVertices = mesh.mNumVertices;
-	subMesh->numberOfIndices = mesh.mNumFaces * kNumberOfIndicesInFace;
-	subMesh->materialIndex = mesh.mMaterialIndex;
+		// The draw materials hold the textures they were made with, so they're made again with this one.
+		mDrawMaterials.clear();
+	});
+}
 
-	int offset = 0;
+/* Create the buffers for a submesh straight from the cooked data.
+@Returns bool Success */
+bool CMesh::CreateSubmesh(CCookedMesh& cookedMesh, const CCookedMesh::SubMeshRecord& record, SubMesh* subMesh)
+{
+	static_assert(sizeof(VertexType) == sizeof(CCookedMesh::Vertex), "Cooked vertices must match the layout of the mesh vertex type.");
 
-	if (mesh.HasPositions())
-	{
-		offset += 12;
-	}
-	if (mesh.HasNormals())
-	{
-		offset += 12;
-	}
-	if (mesh.HasTangentsAndBitangents())
+	const VertexType* vertices = reinterpret_cast<const VertexType*>(cookedMesh.GetVertices() + record.firstVertex);
+	const unsigned int* indices = cookedMesh.GetIndices() + record.firstIndex;
+
+	// The levels of detail follow on from the full mesh, so they all come across in one go.
+	const unsigned int lastLod = cookedMesh.GetNumberOfLods() - 1;
+	const unsigned int numberOfIndices = record.lodFirstIndex[lastLod] + record.lodNumberOfIndices[lastLod] - record.firstIndex;
+
+	for (unsigned int lod = 0; lod < CCookedMesh::kMaxLods; lod++)
 	{
-		offset += 24;
+		subMesh->lodFirstIndex[lod] = lod <= lastLod ? record.lodFirstIndex[lod] - record.firstIndex : 0;
+		subMesh->lodNumberOfIndices[lod] = lod <= lastLod ? record.lodNumberOfIndices[lod] : 0;
 	}
-	if (mesh.HasTextureCoords(0))
+
+	subMesh->numberOfVertices = record.numberOfVertices;
+	subMesh->numberOfIndices = record.numberOfIndices;
+	subMesh->materialIndex = record.materialIndex;
+
+	// Work out how the buffers for this submesh will be laid out.
+	VertexLayout& layout = subMesh->layout;
+	layout.vertexFormat = kQuantiseMeshVertices ? QuantisedVertexFormat : FloatVertexFormat;
+	layout.vertexStride = kQuantiseMeshVertices ? sizeof(QuantisedVertexType) : sizeof(VertexType);
+	layout.indexFormat = record.numberOfVertices <= kMaxVerticesFor16BitIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	layout.indexStride = layout.indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(unsigned short) : sizeof(unsigned int);
+	D3DXMatrixIdentity(&layout.dequantiseMatrix);
+
+	const void* vertexData = vertices;
+	const void* indexData = indices;
+	std::vector<QuantisedVertexType> quantisedVertices;
+	std::vector<unsigned short> shortIndices;
+
+	if (layout.vertexFormat == QuantisedVertexFormat)
 	{
-		offset += 8;
+		D3DXVECTOR3 centre;
+		float scale;
+		PrioEngine::Quantisation::CalculatePositionQuantisation(&vertices[0].position.x, sizeof(VertexType), record.numberOfVertices, centre, scale, layout.dequantiseMatrix);
+
+		quantisedVertices.resize(record.numberOfVertices);
+		for (unsigned int vertex = 0; vertex < record.numberOfVertices; vertex++)
+		{
+			PrioEngine::Quantisation::QuantisePosition(&vertices[vertex].position.x, centre, scale, quantisedVertices[vertex].position);
+			quantisedVertices[vertex].uv[0] = PrioEngine::Quantisation::FloatToHalf(vertices[vertex].uv.x);
+			quantisedVertices[vertex].uv[1] = PrioEngine::Quantisation::FloatToHalf(vertices[vertex].uv.y);
+			PrioEngine::Quantisation::EncodeOctahedralNormal(&vertices[vertex].normal.x, quantisedVertices[vertex].normal);
+		}
+		vertexData = quantisedVertices.data();
 	}
-	if (mesh.HasVertexColors(0))
+
+	if (layout.indexFormat == DXGI_FORMAT_R16_UINT)
 	{
-		offset += 4;
+		shortIndices.assign(indices, indices + numberOfIndices);
+		indexData = shortIndices.data();
 	}
 
-	HRESULT result;
-
-	D3D11_BUFFER_DESC bufferDesc;
-	D3D11_SUBRESOURCE_DATA initData;
-	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	bufferDesc.ByteWidth = offset * subMesh->numberOfVertices;
-	bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bufferDesc.CPUAccessFlags = 0;
-	bufferDesc.MiscFlags = 0;
-
-	initData.pSysMem = &vertices[0];
-	result = mpDevice->CreateBuffer(&bufferDesc, &initData, &subMesh->vertexBuffer);
-
-	if (FAILED(result))
+	// The buffers are never written to again, so let the driver put them wherever suits it best.
+	subMesh->vertexBuffer = CreateImmutableBuffer(mpRenderDevice, CRenderDevice::VertexBuffer, layout.vertexStride * subMesh->numberOfVertices, vertexData);
+	if (subMesh->vertexBuffer == nullptr)
 	{
 		logger->GetInstance().WriteLine("Failed to create the vertex buffer for mesh.");
 		return false;
 	}
 
-	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	bufferDesc.ByteWidth = sizeof(unsigned int) * subMesh->numberOfIndices;
-	bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	bufferDesc.CPUAccessFlags = 0;
-	bufferDesc.MiscFlags = 0;
-
-	initData.pSysMem = &indices[0];
-
-	result = mpDevice->CreateBuffer(&bufferDesc, &initData, &subMesh->indexBuffer);
-	if (FAILED(result))
+	subMesh->indexBuffer = CreateImmutableBuffer(mpRenderDevice, CRenderDevice::IndexBuffer, layout.indexStride * numberOfIndices, indexData);
+	if (subMesh->indexBuffer == nullptr)
 	{
-		logger->GetInstance().WriteLine("Failed to create the vertex buffer for mesh.");
+		logger->GetInstance().WriteLine("Failed to create the index buffer for mesh.");
+		mpRenderDevice->DestroyBuffer(subMesh->vertexBuffer);
+		subMesh->vertexBuffer = nullptr;
 		return false;
 	}
 
-	delete[] vertices;
-	vertices = nullptr;
-	delete[] indices;
-	indices = nullptr;
+	const unsigned int fullSize = (sizeof(VertexType) * subMesh->numberOfVertices) + (sizeof(unsigned int) * numberOfIndices);
+	const unsigned int packedSize = (layout.vertexStride * subMesh->numberOfVertices) + (layout.indexStride * numberOfIndices);
+	logger->GetInstance().WriteLine("Created submesh buffers using " + std::to_string(packedSize) + " bytes, full precision would use " + std::to_string(fullSize) + " bytes.");
 
 	return true;
 }
\ No newline at end of file
@@ -19,8 +19,22 @@
 #include "PrioEngineVars.h"
 #include "Frustum.h"
 #include "RefractReflectShader.h"
+#include "TransformSystem.h"
+#include "VisibilitySystem.h"
+#include "CookedMesh.h"
+#include "VertexFormat.h"
+#include "AssetLoader.h"
 
 const int mNumberOfTextures = 3;
+// Whether mesh vertices are packed into the quantised format on the GPU, halving their size.
+const bool kQuantiseMeshVertices = true;
+// Furthest a level of detail may stray from the full mesh on screen before a finer one is used, as a fraction of half
+// the screen height. Roughly a pixel at 1080p.
+const float kMaxLodScreenError = 0.002f;
+// How far past a switching point an instance must go before it changes level, stops it flickering when sat on the boundary.
+const float kLodHysteresis = 0.1f;
+// Meshes with levels of detail are drawn until they cover less than this fraction of half the screen height.
+const float kMinimumScreenSize = 0.005f;
 
 class CMesh
 {
@@ -32,7 +46,11 @@ private:
 	float mRadius;
 
 	// A list of the instance of models belonging to this mesh.
-	std::list<CModel*> mpModels;
+	std::vector<CModel*> mpModels;
+	// Indices into the model list of the instances which passed culling for each view this frame, by level of detail.
+	std::vector<unsigned int> mVisibleModels[CVisibilitySystem::kMaxViews][CCookedMesh::kMaxLods];
+	// The level of detail each instance was drawn at last time it was visible in each view.
+	std::vector<unsigned char> mModelLods[CVisibilitySystem::kMaxViews];
 
 	struct VertexType
 	{
@@ -44,6 +62,10 @@ private:
 	struct MaterialType
 	{
 		ID3D11ShaderResourceView* mTextures[mNumberOfTextures];
+		// Where each texture came from if it's shared, so it's handed back rather than released.
+		CResourceCache* mResourceCaches[mNumberOfTextures];
+		// Textures still being read by the asset loader, the placeholder is in their place until they're ready.
+		CAssetLoader::AssetHandle mLoadRequests[mNumberOfTextures];
 	};
 
 	// Arrays to store data about vertices in.
@@ -52,37 +74,127 @@ private:
 		int numberOfVertices;
 		int numberOfIndices;
 		int materialIndex;
-		aiVector3D* vertices;
-		ID3D11Buffer* vertexBuffer;
-		ID3D11Buffer* indexBuffer;
-		aiFace* faces;
+		CRenderDevice::Buffer* vertexBuffer;
+		// Holds every level of detail one after the other, all sharing the same vertex buffer.
+		CRenderDevice::Buffer* indexBuffer;
+		unsigned int lodFirstIndex[CCookedMesh::kMaxLods];
+		unsigned int lodNumberOfIndices[CCookedMesh::kMaxLods];
+		VertexLayout layout;
+	};
+
+	// Every instance in one chunk which shares a material, merged into a single index buffer.
+	struct StaticBatch
+	{
+		int materialIndex;
+		int numberOfIndices;
+		CRenderDevice::Buffer* indexBuffer;
+	};
+
+	// A square area of the world whose instances have been transformed into world space and merged together.
+	struct StaticChunk
+	{
+		D3DXVECTOR3 minBounds;
+		D3DXVECTOR3 maxBounds;
+		CRenderDevice::Buffer* vertexBuffer;
+		std::vector<StaticBatch> batches;
 	};
 
 	ID3D11Device* mpDevice;
+	// Buffers are created through this, textures still come from the device.
+	CRenderDevice* mpRenderDevice;
+	CTransformSystem* mpTransformSystem;
+	// Material textures are shared through here when set.
+	CResourceCache* mpResourceCache;
 	SubMesh* mpSubMeshes;
 	unsigned int mNumberOfSubMeshes;
-	bool CreateSubmesh(const aiMesh& mesh, SubMesh* subMesh);
+	bool CreateSubmesh(CCookedMesh& cookedMesh, const CCookedMesh::SubMeshRecord& record, SubMesh* subMesh);
 public:
-	CMesh(ID3D11Device* device);
+	CMesh(ID3D11Device* device, CRenderDevice* renderDevice, CTransformSystem* transformSystem = nullptr, CResourceCache* resourceCache = nullptr);
 	~CMesh();
 
 	// Loads data from file into our mesh object.
 	CModel* CreateModel();
+
+	// Merge the instances of this mesh into one batch per chunk of the world, the instances must not move afterwards.
+	// Chunks further than batchDistanceScale * level of detail are drawn as a batch rather than instance by instance.
+	void EnableStaticBatching(float chunkSize, float batchDistanceScale = 0.5f);
+	// Rebuild the batches if any instances have been added since they were last baked. Called once per frame.
+	bool UpdateStaticBatches();
 	bool LoadMesh(std::string filename, float modelRadius = 1.0f);
+	// Load the mesh in the background, instances can be created straight away but won't be drawn until it's ready.
+	bool LoadMeshAsync(CAssetLoader* assetLoader, std::string filename, float modelRadius = 1.0f, CAssetLoader::CompletionCallback callback = nullptr);
+	// Create the buffers and textures from a loaded cooked mesh, must be called on the main thread.
+	// Given an asset loader, the textures are queued on it rather than read here, and the placeholder is used until they're ready.
+	bool CreateFromCookedMesh(CCookedMesh& cookedMesh, CAssetLoader* assetLoader = nullptr);
+	bool IsLoading() { return mLoadRequest != nullptr && mLoadRequest->state != CAssetLoader::AssetReady && mLoadRequest->state != CAssetLoader::AssetFailed; };
 
-	void Render(ID3D11DeviceContext* context, CFrustum* frustum, CDiffuseLightShader* shader, CLight* light, D3DXVECTOR3 cameraPos);
-	void Render(ID3D11DeviceContext* context, CFrustum* frustum, CReflectRefractShader* shader, D3DXVECTOR3 cameraPos);
-	void RenderReflection(ID3D11DeviceContext* context, CFrustum* frustum, CReflectRefractShader* shader, D3DXVECTOR3 cameraPos);
+	// Queue the instances the visibility system found to be visible from the given view, nearest first within a material.
+	void AddToDrawList(CDrawList* drawList, unsigned int view, CDiffuseLightShader* shader, CSharedConstants* sharedConstants, const D3DXVECTOR3& cameraPosition);
+	// Rebuild the matrices of the instances visible from the given view. Render leaves them alone, so passes drawing
+	// the same instances can be recorded at the same time once this has been called for each of their views.
+	void UpdateMatrices(unsigned int view);
+	// Render the instances the visibility system found to be visible from the given view.
+	void Render(ID3D11DeviceContext* context, unsigned int view, CReflectRefractShader* shader);
+	void RenderReflection(ID3D11DeviceContext* context, unsigned int view, CReflectRefractShader* shader);
 	void Shutdown();
 private:
 	bool LoadAssimpModel(std::string filename);
+	bool BakeStaticBatches();
+	void ReleaseStaticBatches();
+	bool HasVisibleModels(unsigned int view);
+	void CreateDrawMaterials(CDiffuseLightShader* shader);
+	void LoadMaterialTextureAsync(CAssetLoader* assetLoader, int materialIndex, int textureIndex, const std::string& filename);
 	unsigned int mVertexCount;
 	unsigned int mIndexCount;
 	MaterialType* mSubMeshMaterials;
+	// The same materials as they're bound from a draw list, made the first time the mesh is queued.
+	std::vector<CDrawList::Material> mDrawMaterials;
 	int numberOfSubMaterials;
+	// Distance instances stop being drawn at, meshes with levels of detail go by their size on screen instead.
 	float mLevelOfDetail = 100.0f;
+	unsigned int mNumberOfLods = 1;
+	// Screen size below which each level of detail is used, the first is always used when the mesh is close enough.
+	float mLodScreenSizes[CCookedMesh::kMaxLods];
+
+	CAssetLoader::AssetHandle mLoadRequest;
+
+	std::vector<StaticChunk> mStaticChunks;
+	// The chunk each model was baked into, any models created since the last bake won't have one yet.
+	std::vector<unsigned int> mModelChunks;
+	// Chunks which are far enough away to be drawn as a batch and passed culling this frame.
+	std::vector<unsigned int> mVisibleChunks[CVisibilitySystem::kMaxViews];
+	// How each chunk is to be handled this frame, filled in by the visibility system.
+	std::vector<unsigned char> mChunkStates[CVisibilitySystem::kMaxViews];
+	bool mStaticBatchingEnabled = false;
+	bool mStaticBatchesDirty = false;
+	float mStaticChunkSize = 0.0f;
+	float mStaticBatchDistanceScale = 0.5f;
 public:
+	static const unsigned int kNoChunk = 0xFFFFFFFF;
+	enum ChunkState
+	{
+		ChunkCulled = 0,
+		ChunkDrawInstances,
+		ChunkDrawBatch
+	};
+
 	void SetLevelOfDetail(float value) { mLevelOfDetail = value; };
 	float GetLevelOfDetail() { return mLevelOfDetail; };
+	float GetRadius() { return mRadius; };
+	unsigned int GetNumberOfModels() { return static_cast<unsigned int>(mpModels.size()); };
+	CModel* GetModel(unsigned int index) { return mpModels[index]; };
+	std::vector<unsigned int>& GetVisibleModels(unsigned int view, unsigned int lod) { return mVisibleModels[view][lod]; };
+	std::vector<unsigned char>& GetModelLods(unsigned int view) { return mModelLods[view]; };
+	unsigned int GetNumberOfLods() { return mNumberOfLods; };
+	// Pick the level of detail for an instance covering the given fraction of half the screen height. Safe to call from any thread.
+	unsigned int SelectLod(float screenSize, unsigned int previousLod);
+
+	unsigned int GetNumberOfStaticChunks() { return static_cast<unsigned int>(mStaticChunks.size()); };
+	const D3DXVECTOR3& GetStaticChunkMinBounds(unsigned int chunk) { return mStaticChunks[chunk].minBounds; };
+	const D3DXVECTOR3& GetStaticChunkMaxBounds(unsigned int chunk) { return mStaticChunks[chunk].maxBounds; };
+	unsigned int GetModelChunk(unsigned int index) { return index < mModelChunks.size() ? mModelChunks[index] : kNoChunk; };
+	float GetStaticBatchDistance() { return mLevelOfDetail * mStaticBatchDistanceScale; };
+	std::vector<unsigned int>& GetVisibleChunks(unsigned int view) { return mVisibleChunks[view]; };
+	std::vector<unsigned char>& GetChunkStates(unsigned int view) { return mChunkStates[view]; };
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,296 @@
+#include "MeshOptimiser.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Weights used to score vertices when ordering triangles, these are the values suggested by Tom Forsyth.
+	const float kCacheDecayPower = 1.5f;
+	const float kLastTriangleScore = 0.75f;
+	const float kValenceBoostScale = 2.0f;
+	const float kValenceBoostPower = 0.5f;
+
+	const unsigned int kNoVertex = 0xFFFFFFFF;
+
+	struct VertexHasher
+	{
+		size_t operator()(const CCookedMesh::Vertex& vertex) const
+		{
+			return static_cast<size_t>(PrioEngine::Hash::FNV1a(&vertex, sizeof(CCookedMesh::Vertex)));
+		}
+	};
+
+	struct VertexEqual
+	{
+		bool operator()(const CCookedMesh::Vertex& a, const CCookedMesh::Vertex& b) const
+		{
+			return memcmp(&a, &b, sizeof(CCookedMesh::Vertex)) == 0;
+		}
+	};
+}
+
+/* Welds, reorders for the post transform cache, then reorders for vertex fetch, measuring the cache miss ratio either side.
+* @Returns Statistics The vertex counts and cache miss ratios before and after optimising. */
+CMeshOptimiser::Statistics CMeshOptimiser::Optimise(std::vector<CCookedMesh::Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	Statistics statistics;
+	statistics.numberOfVerticesBefore = static_cast<unsigned int>(vertices.size());
+	statistics.acmrBefore = CalculateACMR(indices, static_cast<unsigned int>(vertices.size()));
+
+	WeldVertices(vertices, indices);
+	OptimiseVertexCache(indices, static_cast<unsigned int>(vertices.size()));
+	// Must come last, as it relies on the final triangle order.
+	OptimiseVertexFetch(vertices, indices);
+
+	statistics.numberOfVerticesAfter = static_cast<unsigned int>(vertices.size());
+	statistics.acmrAfter = CalculateACMR(indices, static_cast<unsigned int>(vertices.size()));
+
+	return statistics;
+}
+
+void CMeshOptimiser::WeldVertices(std::vector<CCookedMesh::Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::unordered_map<CCookedMesh::Vertex, unsigned int, VertexHasher, VertexEqual> uniqueVertices;
+	uniqueVertices.reserve(vertices.size());
+
+	std::vector<unsigned int> remap(vertices.size());
+	std::vector<CCookedMesh::Vertex> welded;
+	welded.reserve(vertices.size());
+
+	for (unsigned int vertex = 0; vertex < vertices.size(); vertex++)
+	{
+		auto result = uniqueVertices.insert(std::make_pair(vertices[vertex], static_cast<unsigned int>(welded.size())));
+		if (result.second)
+		{
+			welded.push_back(vertices[vertex]);
+		}
+		remap[vertex] = result.first->second;
+	}
+
+	for (auto& index : indices)
+	{
+		index = remap[index];
+	}
+
+	vertices.swap(welded);
+}
+
+void CMeshOptimiser::OptimiseVertexCache(std::vector<unsigned int>& indices, unsigned int numberOfVertices)
+{
+	const unsigned int numberOfTriangles = static_cast<unsigned int>(indices.size() / 3);
+	if (numberOfTriangles == 0)
+	{
+		return;
+	}
+
+	// Build the list of triangles using each vertex, stored contiguously with an offset per vertex.
+	std::vector<unsigned int> remainingTriangles(numberOfVertices, 0);
+	for (unsigned int i = 0; i < numberOfTriangles * 3; i++)
+	{
+		remainingTriangles[indices[i]]++;
+	}
+
+	std::vector<unsigned int> adjacencyOffsets(numberOfVertices + 1, 0);
+	for (unsigned int vertex = 0; vertex < numberOfVertices; vertex++)
+	{
+		adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + remainingTriangles[vertex];
+	}
+
+	std::vector<unsigned int> adjacency(adjacencyOffsets[numberOfVertices]);
+	std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (unsigned int triangle = 0; triangle < numberOfTriangles; triangle++)
+	{
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			const unsigned int vertex = indices[triangle * 3 + corner];
+			adjacency[fill[vertex]++] = triangle;
+		}
+	}
+
+	std::vector<int> cachePositions(numberOfVertices, -1);
+	std::vector<float> vertexScores(numberOfVertices);
+	for (unsigned int vertex = 0; vertex < numberOfVertices; vertex++)
+	{
+		vertexScores[vertex] = ScoreVertex(-1, remainingTriangles[vertex]);
+	}
+
+	std::vector<bool> triangleAdded(numberOfTriangles, false);
+
+	std::vector<unsigned int> output;
+	output.reserve(numberOfTriangles * 3);
+
+	// Holds a few more than the cache size, so the vertices pushed out by the last triangle can be rescored.
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	cache.reserve(kOptimiseCacheSize + 3);
+	newCache.reserve(kOptimiseCacheSize + 3);
+
+	int bestTriangle = -1;
+	// Where to resume looking for an unused triangle once the cache has nothing left to offer.
+	unsigned int nextUnusedTriangle = 0;
+
+	for (unsigned int emitted = 0; emitted < numberOfTriangles; emitted++)
+	{
+		if (bestTriangle < 0)
+		{
+			// Walking on in input order, rather than searching for the highest score, keeps this linear on meshes made of lots of separate pieces.
+			while (triangleAdded[nextUnusedTriangle])
+			{
+				nextUnusedTriangle++;
+			}
+			bestTriangle = static_cast<int>(nextUnusedTriangle);
+		}
+
+		const unsigned int* corners = &indices[bestTriangle * 3];
+		triangleAdded[bestTriangle] = true;
+
+		// Output the triangle and detach it from its vertices.
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			const unsigned int vertex = corners[corner];
+			output.push_back(vertex);
+
+			unsigned int* begin = adjacency.data() + adjacencyOffsets[vertex];
+			unsigned int* end = begin + remainingTriangles[vertex];
+			for (unsigned int* triangle = begin; triangle != end; triangle++)
+			{
+				if (*triangle == static_cast<unsigned int>(bestTriangle))
+				{
+					*triangle = *(end - 1);
+					remainingTriangles[vertex]--;
+					break;
+				}
+			}
+		}
+
+		// The vertices of this triangle move to the front of the cache, everything else shuffles down.
+		newCache.clear();
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			if (std::find(newCache.begin(), newCache.end(), corners[corner]) == newCache.end())
+			{
+				newCache.push_back(corners[corner]);
+			}
+		}
+		for (auto vertex : cache)
+		{
+			if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+			{
+				newCache.push_back(vertex);
+			}
+		}
+
+		// Rescore everything which was or still is in the cache.
+		for (unsigned int position = 0; position < newCache.size(); position++)
+		{
+			const unsigned int vertex = newCache[position];
+			cachePositions[vertex] = position < kOptimiseCacheSize ? static_cast<int>(position) : -1;
+			vertexScores[vertex] = ScoreVertex(cachePositions[vertex], remainingTriangles[vertex]);
+		}
+
+		// Only the triangles touching those vertices can have changed score, and the next triangle is picked from them.
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (auto vertex : newCache)
+		{
+			const unsigned int* begin = adjacency.data() + adjacencyOffsets[vertex];
+			const unsigned int* end = begin + remainingTriangles[vertex];
+			for (const unsigned int* triangle = begin; triangle != end; triangle++)
+			{
+				const unsigned int* triangleCorners = &indices[*triangle * 3];
+				const float score = vertexScores[triangleCorners[0]] + vertexScores[triangleCorners[1]] + vertexScores[triangleCorners[2]];
+
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = static_cast<int>(*triangle);
+				}
+			}
+		}
+
+		if (newCache.size() > kOptimiseCacheSize)
+		{
+			newCache.resize(kOptimiseCacheSize);
+		}
+		cache.swap(newCache);
+	}
+
+	indices.swap(output);
+}
+
+void CMeshOptimiser::OptimiseVertexFetch(std::vector<CCookedMesh::Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<unsigned int> remap(vertices.size(), kNoVertex);
+	std::vector<CCookedMesh::Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (auto& index : indices)
+	{
+		if (remap[index] == kNoVertex)
+		{
+			remap[index] = static_cast<unsigned int>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices.swap(reordered);
+}
+
+float CMeshOptimiser::CalculateACMR(const std::vector<unsigned int>& indices, unsigned int numberOfVertices, unsigned int cacheSize)
+{
+	const unsigned int numberOfTriangles = static_cast<unsigned int>(indices.size() / 3);
+	if (numberOfTriangles == 0)
+	{
+		return 0.0f;
+	}
+
+	// Simulates a FIFO cache by remembering when each vertex last went in. 0 means it never has.
+	std::vector<unsigned int> timeAdded(numberOfVertices, 0);
+	unsigned int time = cacheSize + 1;
+	unsigned int numberOfMisses = 0;
+
+	for (unsigned int i = 0; i < numberOfTriangles * 3; i++)
+	{
+		const unsigned int vertex = indices[i];
+		if (time - timeAdded[vertex] > cacheSize)
+		{
+			timeAdded[vertex] = time;
+			time++;
+			numberOfMisses++;
+		}
+	}
+
+	return static_cast<float>(numberOfMisses) / static_cast<float>(numberOfTriangles);
+}
+
+float CMeshOptimiser::ScoreVertex(int cachePosition, unsigned int numberOfRemainingTriangles)
+{
+	// Nothing left to draw which uses this vertex.
+	if (numberOfRemainingTriangles == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		if (cachePosition < 3)
+		{
+			// Used by the last triangle, given a fixed score so there's no preference for any particular winding.
+			score = kLastTriangleScore;
+		}
+		else
+		{
+			const float scale = 1.0f / static_cast<float>(kOptimiseCacheSize - 3);
+			score = powf(1.0f - static_cast<float>(cachePosition - 3) * scale, kCacheDecayPower);
+		}
+	}
+
+	// Vertices with only a few triangles left are boosted, so they're finished off rather than left stranded.
+	score += kValenceBoostScale * powf(static_cast<float>(numberOfRemainingTriangles), -kValenceBoostPower);
+
+	return score;
+}
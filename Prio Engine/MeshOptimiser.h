@@ -0,0 +1,45 @@
+#ifndef MESHOPTIMISER_H
+#define MESHOPTIMISER_H
+
+#include <vector>
+#include "PrioEngineVars.h"
+#include "CookedMesh.h"
+
+/* Reorganises imported geometry so it's cheaper for the GPU to draw, run once when a mesh is cooked.
+* Identical vertices are merged, triangles are reordered so recently transformed vertices are reused from the
+* post transform cache, and vertices are then laid out in the order the triangles first use them. */
+class CMeshOptimiser
+{
+private:
+	CLogger* logger;
+public:
+	// Size of the FIFO cache used when measuring how well a mesh uses the post transform cache.
+	static const unsigned int kSimulatedCacheSize = 16;
+	// Size of the LRU cache the triangle ordering is scored against.
+	static const unsigned int kOptimiseCacheSize = 32;
+
+	struct Statistics
+	{
+		unsigned int numberOfVerticesBefore;
+		unsigned int numberOfVerticesAfter;
+		float acmrBefore;
+		float acmrAfter;
+	};
+public:
+	// Run every optimisation on one submesh, the indices are relative to the start of the vertex list.
+	static Statistics Optimise(std::vector<CCookedMesh::Vertex>& vertices, std::vector<unsigned int>& indices);
+
+	// Merge vertices which are bit for bit identical, and point the indices at the merged copies.
+	static void WeldVertices(std::vector<CCookedMesh::Vertex>& vertices, std::vector<unsigned int>& indices);
+	// Reorder triangles to make best use of the post transform cache, using Tom Forsyth's linear speed optimiser.
+	static void OptimiseVertexCache(std::vector<unsigned int>& indices, unsigned int numberOfVertices);
+	// Reorder vertices into the order they're first referenced, dropping any which aren't referenced at all.
+	static void OptimiseVertexFetch(std::vector<CCookedMesh::Vertex>& vertices, std::vector<unsigned int>& indices);
+
+	// Average cache miss ratio, the number of vertices transformed per triangle. 0.5 is ideal, 3 is the worst case.
+	static float CalculateACMR(const std::vector<unsigned int>& indices, unsigned int numberOfVertices, unsigned int cacheSize = kSimulatedCacheSize);
+private:
+	static float ScoreVertex(int cachePosition, unsigned int numberOfRemainingTriangles);
+};
+
+#endif
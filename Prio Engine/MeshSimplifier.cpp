@@ -0,0 +1,474 @@
+#include "MeshSimplifier.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Stop after this many passes even if the target hasn't been reached, each pass only collapses independent edges.
+	const unsigned int kMaxPasses = 64;
+	// Cosine of the largest a triangle may turn during a single collapse.
+	const double kMinFlipCosine = 0.25;
+
+	struct Position
+	{
+		float xyz[3];
+	};
+
+	struct Plane
+	{
+		double a;
+		double b;
+		double c;
+		double d;
+	};
+
+	struct PositionHasher
+	{
+		size_t operator()(const Position& position) const
+		{
+			return static_cast<size_t>(PrioEngine::Hash::FNV1a(&position, sizeof(Position)));
+		}
+	};
+
+	struct PositionEqual
+	{
+		bool operator()(const Position& a, const Position& b) const
+		{
+			return memcmp(&a, &b, sizeof(Position)) == 0;
+		}
+	};
+
+	void Cross(const float a[3], const float b[3], const float c[3], double normal[3])
+	{
+		const double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+		normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+		normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+	}
+
+	unsigned long long EdgeKey(unsigned int a, unsigned int b)
+	{
+		return a < b ? (static_cast<unsigned long long>(a) << 32) | b : (static_cast<unsigned long long>(b) << 32) | a;
+	}
+}
+
+const CMeshSimplifier::Settings CMeshSimplifier::kDefaultSettings = { true, 0.05f, 0.02f };
+
+float CMeshSimplifier::Simplify(const std::vector<CCookedMesh::Vertex>& vertices, const std::vector<unsigned int>& indices,
+	unsigned int targetNumberOfIndices, const Settings& settings, std::vector<unsigned int>& result)
+{
+	result = indices;
+
+	const unsigned int numberOfVertices = static_cast<unsigned int>(vertices.size());
+	if (result.size() <= targetNumberOfIndices || numberOfVertices == 0)
+	{
+		return 0.0f;
+	}
+
+	// Vertices split along a uv seam or hard edge share a position, they're grouped so they always move together.
+	// Each group is identified by the first vertex found at that position.
+	std::vector<unsigned int> positionGroup(numberOfVertices);
+	{
+		std::unordered_map<Position, unsigned int, PositionHasher, PositionEqual> firstAtPosition;
+		firstAtPosition.reserve(numberOfVertices);
+		for (unsigned int vertex = 0; vertex < numberOfVertices; vertex++)
+		{
+			Position position;
+			memcpy(position.xyz, vertices[vertex].position, sizeof(position.xyz));
+			positionGroup[vertex] = firstAtPosition.insert(std::make_pair(position, vertex)).first->second;
+		}
+	}
+
+	// Build up the error quadrics from the planes of the original triangles, weighted by area.
+	std::vector<Quadric> quadrics(numberOfVertices);
+	for (auto& quadric : quadrics)
+	{
+		ClearQuadric(quadric);
+	}
+
+	// The planes of the original triangles each position has been collapsed over, used to measure how far the surface has moved.
+	std::vector<Plane> planes;
+	std::vector<std::vector<unsigned int>> groupPlanes(numberOfVertices);
+
+	std::unordered_map<unsigned long long, unsigned int> edgeUseCounts;
+	for (unsigned int i = 0; i + 2 < result.size(); i += 3)
+	{
+		const unsigned int corners[3] = { result[i], result[i + 1], result[i + 2] };
+
+		double normal[3];
+		Cross(vertices[corners[0]].position, vertices[corners[1]].position, vertices[corners[2]].position, normal);
+		const double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+		if (length > 0.0)
+		{
+			normal[0] /= length;
+			normal[1] /= length;
+			normal[2] /= length;
+			const float* origin = vertices[corners[0]].position;
+			const double distance = -(normal[0] * origin[0] + normal[1] * origin[1] + normal[2] * origin[2]);
+
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				AddPlane(quadrics[positionGroup[corners[corner]]], normal[0], normal[1], normal[2], distance, length * 0.5);
+				groupPlanes[positionGroup[corners[corner]]].push_back(static_cast<unsigned int>(planes.size()));
+			}
+
+			const Plane plane = { normal[0], normal[1], normal[2], distance };
+			planes.push_back(plane);
+		}
+
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			const unsigned int a = positionGroup[corners[corner]];
+			const unsigned int b = positionGroup[corners[(corner + 1) % 3]];
+			if (a != b)
+			{
+				edgeUseCounts[EdgeKey(a, b)]++;
+			}
+		}
+	}
+
+	// An edge used by only one triangle is on the border, one used by more than two isn't manifold, neither can move safely.
+	std::vector<bool> locked(numberOfVertices, false);
+	if (settings.lockBorders)
+	{
+		for (auto& edge : edgeUseCounts)
+		{
+			if (edge.second != 2)
+			{
+				locked[static_cast<unsigned int>(edge.first >> 32)] = true;
+				locked[static_cast<unsigned int>(edge.first & 0xFFFFFFFF)] = true;
+			}
+		}
+	}
+
+	// Attribute differences are scaled by the size of the mesh, so they're comparable with the positional error.
+	float minBounds[3] = { vertices[0].position[0], vertices[0].position[1], vertices[0].position[2] };
+	float maxBounds[3] = { minBounds[0], minBounds[1], minBounds[2] };
+	for (auto& vertex : vertices)
+	{
+		for (unsigned int axis = 0; axis < 3; axis++)
+		{
+			minBounds[axis] = std::min(minBounds[axis], vertex.position[axis]);
+			maxBounds[axis] = std::max(maxBounds[axis], vertex.position[axis]);
+		}
+	}
+	const double extentSquared = (maxBounds[0] - minBounds[0]) * (maxBounds[0] - minBounds[0]) +
+		(maxBounds[1] - minBounds[1]) * (maxBounds[1] - minBounds[1]) +
+		(maxBounds[2] - minBounds[2]) * (maxBounds[2] - minBounds[2]);
+
+	std::vector<unsigned int> triangleOffsets(numberOfVertices + 1);
+	std::vector<unsigned int> vertexTriangles;
+	std::vector<unsigned int> groupOffsets(numberOfVertices + 1);
+	std::vector<unsigned int> groupVertices;
+	std::vector<unsigned int> fill;
+	std::vector<unsigned int> remap(numberOfVertices);
+	std::vector<bool> touched(numberOfVertices);
+	std::vector<Collapse> collapses;
+	double maxDistance = 0.0;
+
+	for (unsigned int pass = 0; pass < kMaxPasses && result.size() > targetNumberOfIndices; pass++)
+	{
+		const unsigned int numberOfTriangles = static_cast<unsigned int>(result.size() / 3);
+
+		// Triangles using each vertex.
+		std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+		for (auto index : result)
+		{
+			triangleOffsets[index + 1]++;
+		}
+		for (unsigned int vertex = 0; vertex < numberOfVertices; vertex++)
+		{
+			triangleOffsets[vertex + 1] += triangleOffsets[vertex];
+		}
+		vertexTriangles.resize(result.size());
+		fill.assign(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (unsigned int triangle = 0; triangle < numberOfTriangles; triangle++)
+		{
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				vertexTriangles[fill[result[triangle * 3 + corner]]++] = triangle;
+			}
+		}
+
+		// Vertices still in use at each position.
+		std::fill(groupOffsets.begin(), groupOffsets.end(), 0);
+		for (unsigned int vertex = 0; vertex < numberOfVertices; vertex++)
+		{
+			if (triangleOffsets[vertex + 1] > triangleOffsets[vertex])
+			{
+				groupOffsets[positionGroup[vertex] + 1]++;
+			}
+		}
+		for (unsigned int vertex = 0; vertex < numberOfVertices; vertex++)
+		{
+			groupOffsets[vertex + 1] += groupOffsets[vertex];
+		}
+		groupVertices.resize(groupOffsets[numberOfVertices]);
+		fill.assign(groupOffsets.begin(), groupOffsets.end() - 1);
+		for (unsigned int vertex = 0; vertex < numberOfVertices; vertex++)
+		{
+			if (triangleOffsets[vertex + 1] > triangleOffsets[vertex])
+			{
+				groupVertices[fill[positionGroup[vertex]]++] = vertex;
+			}
+		}
+
+		// Finds the vertex at the target position which shares a triangle with a vertex being collapsed.
+		// Failing to find one means the collapse would tear a seam apart.
+		auto findMatch = [&](unsigned int vertex, unsigned int to) -> unsigned int
+		{
+			for (unsigned int t = triangleOffsets[vertex]; t < triangleOffsets[vertex + 1]; t++)
+			{
+				const unsigned int* corners = &result[vertexTriangles[t] * 3];
+				for (unsigned int corner = 0; corner < 3; corner++)
+				{
+					if (positionGroup[corners[corner]] == to)
+					{
+						return corners[corner];
+					}
+				}
+			}
+			return numberOfVertices;
+		};
+
+		auto evaluate = [&](unsigned int from, unsigned int to, Collapse& collapse) -> bool
+		{
+			if (locked[from])
+			{
+				return false;
+			}
+
+			const float* target = vertices[to].position;
+			const double area = quadrics[from].area + quadrics[to].area;
+			double error = area > 0.0 ? (EvaluateQuadric(quadrics[from], target) + EvaluateQuadric(quadrics[to], target)) / area : 0.0;
+			unsigned int numberOfRemoved = 0;
+
+			for (unsigned int g = groupOffsets[from]; g < groupOffsets[from + 1]; g++)
+			{
+				const unsigned int vertex = groupVertices[g];
+				const unsigned int match = findMatch(vertex, to);
+				if (match == numberOfVertices)
+				{
+					return false;
+				}
+
+				const CCookedMesh::Vertex& a = vertices[vertex];
+				const CCookedMesh::Vertex& b = vertices[match];
+				const double normalDifference = (a.normal[0] - b.normal[0]) * (a.normal[0] - b.normal[0]) +
+					(a.normal[1] - b.normal[1]) * (a.normal[1] - b.normal[1]) +
+					(a.normal[2] - b.normal[2]) * (a.normal[2] - b.normal[2]);
+				const double uvDifference = (a.uv[0] - b.uv[0]) * (a.uv[0] - b.uv[0]) + (a.uv[1] - b.uv[1]) * (a.uv[1] - b.uv[1]);
+				error += (normalDifference * settings.normalWeight + uvDifference * settings.uvWeight) * extentSquared;
+
+				// Reject collapses which would flip, or nearly flip, any of the triangles which survive.
+				for (unsigned int t = triangleOffsets[vertex]; t < triangleOffsets[vertex + 1]; t++)
+				{
+					const unsigned int* corners = &result[vertexTriangles[t] * 3];
+					if (positionGroup[corners[0]] == to || positionGroup[corners[1]] == to || positionGroup[corners[2]] == to)
+					{
+						numberOfRemoved++;
+						continue;
+					}
+
+					const float* positions[3];
+					const float* moved[3];
+					for (unsigned int corner = 0; corner < 3; corner++)
+					{
+						positions[corner] = vertices[corners[corner]].position;
+						moved[corner] = corners[corner] == vertex ? target : positions[corner];
+					}
+
+					double before[3];
+					double after[3];
+					Cross(positions[0], positions[1], positions[2], before);
+					Cross(moved[0], moved[1], moved[2], after);
+					// Anything turning by more than about 75 degrees counts, slivers can flip over in a later pass otherwise.
+					const double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+					const double lengths = (before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+						(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+					if (dot <= kMinFlipCosine * sqrt(lengths))
+					{
+						return false;
+					}
+				}
+			}
+
+			collapse.from = from;
+			collapse.to = to;
+			collapse.error = error;
+			collapse.numberOfRemovedTriangles = numberOfRemoved;
+			return true;
+		};
+
+		// Find the cheaper direction to collapse each edge in.
+		collapses.clear();
+		for (unsigned int triangle = 0; triangle < numberOfTriangles; triangle++)
+		{
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				const unsigned int a = positionGroup[result[triangle * 3 + corner]];
+				const unsigned int b = positionGroup[result[triangle * 3 + (corner + 1) % 3]];
+
+				// Each edge is seen from both triangles either side, only look at it from one.
+				if (a >= b)
+				{
+					continue;
+				}
+
+				Collapse forward;
+				Collapse backward;
+				const bool forwardValid = evaluate(a, b, forward);
+				const bool backwardValid = evaluate(b, a, backward);
+
+				if (forwardValid && (!backwardValid || forward.error <= backward.error))
+				{
+					collapses.push_back(forward);
+				}
+				else if (backwardValid)
+				{
+					collapses.push_back(backward);
+				}
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+		// Take the cheapest collapses which don't touch each other's neighbourhoods, so each stays valid.
+		for (unsigned int vertex = 0; vertex < numberOfVertices; vertex++)
+		{
+			remap[vertex] = vertex;
+			touched[vertex] = false;
+		}
+
+		const unsigned int numberOfTrianglesToRemove = (static_cast<unsigned int>(result.size()) - targetNumberOfIndices + 2) / 3;
+		unsigned int numberOfRemoved = 0;
+		unsigned int numberOfApplied = 0;
+
+		for (auto& collapse : collapses)
+		{
+			if (numberOfRemoved >= numberOfTrianglesToRemove)
+			{
+				break;
+			}
+
+			if (touched[collapse.from] || touched[collapse.to])
+			{
+				continue;
+			}
+
+			for (unsigned int g = groupOffsets[collapse.from]; g < groupOffsets[collapse.from + 1]; g++)
+			{
+				const unsigned int vertex = groupVertices[g];
+				remap[vertex] = findMatch(vertex, collapse.to);
+
+				for (unsigned int t = triangleOffsets[vertex]; t < triangleOffsets[vertex + 1]; t++)
+				{
+					const unsigned int* corners = &result[vertexTriangles[t] * 3];
+					touched[positionGroup[corners[0]]] = true;
+					touched[positionGroup[corners[1]]] = true;
+					touched[positionGroup[corners[2]]] = true;
+				}
+			}
+
+			AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+
+			// The quadric error is an average over the planes, the distance reported is the worst of any of them. Planes
+			// already merged into the target were measured from this same position when they were merged.
+			const float* target = vertices[collapse.to].position;
+			for (auto plane : groupPlanes[collapse.from])
+			{
+				const Plane& p = planes[plane];
+				maxDistance = std::max(maxDistance, std::abs(p.a * target[0] + p.b * target[1] + p.c * target[2] + p.d));
+			}
+
+			std::vector<unsigned int>& mergedPlanes = groupPlanes[collapse.to];
+			mergedPlanes.insert(mergedPlanes.end(), groupPlanes[collapse.from].begin(), groupPlanes[collapse.from].end());
+			std::sort(mergedPlanes.begin(), mergedPlanes.end());
+			mergedPlanes.erase(std::unique(mergedPlanes.begin(), mergedPlanes.end()), mergedPlanes.end());
+			std::vector<unsigned int>().swap(groupPlanes[collapse.from]);
+
+			numberOfRemoved += collapse.numberOfRemovedTriangles;
+			numberOfApplied++;
+		}
+
+		if (numberOfApplied == 0)
+		{
+			break;
+		}
+
+		// Rewrite the indices, dropping any triangles which have collapsed down to nothing.
+		unsigned int write = 0;
+		for (unsigned int triangle = 0; triangle < numberOfTriangles; triangle++)
+		{
+			const unsigned int a = remap[result[triangle * 3]];
+			const unsigned int b = remap[result[triangle * 3 + 1]];
+			const unsigned int c = remap[result[triangle * 3 + 2]];
+
+			if (positionGroup[a] == positionGroup[b] || positionGroup[b] == positionGroup[c] || positionGroup[a] == positionGroup[c])
+			{
+				continue;
+			}
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+	}
+
+	return static_cast<float>(maxDistance);
+}
+
+void CMeshSimplifier::ClearQuadric(Quadric& quadric)
+{
+	memset(&quadric, 0, sizeof(Quadric));
+}
+
+void CMeshSimplifier::AddPlane(Quadric& quadric, double a, double b, double c, double d, double weight)
+{
+	quadric.a00 += a * a * weight;
+	quadric.a01 += a * b * weight;
+	quadric.a02 += a * c * weight;
+	quadric.a03 += a * d * weight;
+	quadric.a11 += b * b * weight;
+	quadric.a12 += b * c * weight;
+	quadric.a13 += b * d * weight;
+	quadric.a22 += c * c * weight;
+	quadric.a23 += c * d * weight;
+	quadric.a33 += d * d * weight;
+	quadric.area += weight;
+}
+
+void CMeshSimplifier::AddQuadric(Quadric& quadric, const Quadric& other)
+{
+	quadric.a00 += other.a00;
+	quadric.a01 += other.a01;
+	quadric.a02 += other.a02;
+	quadric.a03 += other.a03;
+	quadric.a11 += other.a11;
+	quadric.a12 += other.a12;
+	quadric.a13 += other.a13;
+	quadric.a22 += other.a22;
+	quadric.a23 += other.a23;
+	quadric.a33 += other.a33;
+	quadric.area += other.area;
+}
+
+double CMeshSimplifier::EvaluateQuadric(const Quadric& quadric, const float position[3])
+{
+	const double x = position[0];
+	const double y = position[1];
+	const double z = position[2];
+
+	// v^T Q v for the point (x, y, z, 1), clamped as rounding can take it slightly below zero.
+	const double error = quadric.a00 * x * x + 2.0 * quadric.a01 * x * y + 2.0 * quadric.a02 * x * z + 2.0 * quadric.a03 * x +
+		quadric.a11 * y * y + 2.0 * quadric.a12 * y * z + 2.0 * quadric.a13 * y +
+		quadric.a22 * z * z + 2.0 * quadric.a23 * z +
+		quadric.a33;
+
+	return error > 0.0 ? error : 0.0;
+}
@@ -0,0 +1,59 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <vector>
+#include "PrioEngineVars.h"
+#include "CookedMesh.h"
+
+/* Reduces the number of triangles in a mesh by collapsing edges, choosing the collapses which move the surface the least
+* as measured by quadric error metrics. Vertices are only ever moved onto existing vertices, so every level of detail
+* generated from a mesh can share the same vertex buffer and only needs its own index buffer. */
+class CMeshSimplifier
+{
+private:
+	CLogger* logger;
+public:
+	struct Settings
+	{
+		// Vertices on an open edge of the mesh are never removed, stops holes opening up around the outline.
+		bool lockBorders;
+		// How much a difference in normals or texture coordinates either side of a collapse adds to its error.
+		float normalWeight;
+		float uvWeight;
+	};
+
+	static const Settings kDefaultSettings;
+public:
+	/* Simplify until the index count is at or below the target, or no more collapses are possible.
+	* @Returns float The furthest any remaining vertex lies from the plane of an original triangle it was collapsed over,
+	* in the same units as the vertex positions. */
+	static float Simplify(const std::vector<CCookedMesh::Vertex>& vertices, const std::vector<unsigned int>& indices,
+		unsigned int targetNumberOfIndices, const Settings& settings, std::vector<unsigned int>& result);
+private:
+	// Symmetric 4x4 matrix measuring the squared distance of a point from a set of planes.
+	struct Quadric
+	{
+		double a00, a01, a02, a03;
+		double a11, a12, a13;
+		double a22, a23;
+		double a33;
+		// Total area of the planes, used to turn the error back into a squared distance.
+		double area;
+	};
+
+	// Moving every vertex at one position onto the vertices at a neighbouring position.
+	struct Collapse
+	{
+		unsigned int from;
+		unsigned int to;
+		double error;
+		unsigned int numberOfRemovedTriangles;
+	};
+
+	static void ClearQuadric(Quadric& quadric);
+	static void AddPlane(Quadric& quadric, double a, double b, double c, double d, double weight);
+	static void AddQuadric(Quadric& quadric, const Quadric& other);
+	static double EvaluateQuadric(const Quadric& quadric, const float position[3]);
+};
+
+#endif
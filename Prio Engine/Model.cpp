@@ -1,4 +1,5 @@
 #include "Model.h"
+#include "TransformSystem.h"
 
 
 CModel::CModel()
@@ -17,6 +18,16 @@ void CModel::Shutdown()
 {
 }
 
+D3DXMATRIX CModel::GetWorldMatrix()
+{
+	if (mpTransformSystem != nullptr)
+	{
+		return mpTransformSystem->GetWorldMatrix(mTransformIndex);
+	}
+
+	return mWorldMatrix;
+}
+
 void CModel::UpdateMatrices()
 {
 	// Rotation
@@ -11,15 +11,14 @@ class CModel : public CModelControl
 private:
 	CLogger* logger;
 
-private:
-	D3DXMATRIX mWorldMatrix;
 public:
 	CModel();
 	~CModel();
 	void Shutdown();
 
+	// Only needed when the model isn't tracked by a transform system, otherwise the system keeps the matrix up to date.
 	void UpdateMatrices();
-	D3DXMATRIX GetWorldMatrix() { return mWorldMatrix; };
+	D3DXMATRIX GetWorldMatrix();
 };
 
 #endif
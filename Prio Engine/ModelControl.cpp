@@ -1,10 +1,14 @@
 #include "ModelControl.h"
+#include "TransformSystem.h"
 
 
 
 CModelControl::CModelControl()
 {
 	mpParent = nullptr;
+	mpTransformSystem = nullptr;
+	mTransformIndex = CTransformSystem::kInvalidIndex;
+	mTransformDirty = false;
 
 	mPosition.x = 0.0f;
 	mPosition.y = 0.0f;
@@ -22,6 +26,28 @@ CModelControl::CModelControl()
 
 CModelControl::~CModelControl()
 {
+	if (mpTransformSystem != nullptr)
+	{
+		mpTransformSystem->Unregister(this);
+	}
+}
+
+void CModelControl::MarkTransformDirty()
+{
+	if (mpTransformSystem != nullptr)
+	{
+		mpTransformSystem->MarkDirty(this);
+	}
+}
+
+D3DXVECTOR3 CModelControl::GetWorldPosition()
+{
+	if (mpTransformSystem != nullptr)
+	{
+		return mpTransformSystem->GetWorldPosition(mTransformIndex);
+	}
+
+	return GetPos();
 }
 
 float CModelControl::ToRadians(float degrees)
@@ -33,16 +59,19 @@ float CModelControl::ToRadians(float degrees)
 void CModelControl::RotateX(float x)
 {
 	mRotation.x += x;
+	MarkTransformDirty();
 }
 
 void CModelControl::RotateY(float y)
 {
 	mRotation.y += y;
+	MarkTransformDirty();
 }
 
 void CModelControl::RotateZ(float z)
 {
 	mRotation.z += z;
+	MarkTransformDirty();
 }
 
 float CModelControl::GetRotationX()
@@ -68,16 +97,19 @@ D3DXVECTOR3 CModelControl::GetRotation()
 void CModelControl::SetRotationX(float x)
 {
 	mRotation.x = x;
+	MarkTransformDirty();
 }
 
 void CModelControl::SetRotationY(float y)
 {
 	mRotation.y = y;
+	MarkTransformDirty();
 }
 
 void CModelControl::SetRotationZ(float z)
 {
 	mRotation.z = z;
+	MarkTransformDirty();
 }
 
 void CModelControl::SetRotation(float x, float y, float z)
@@ -85,21 +117,25 @@ void CModelControl::SetRotation(float x, float y, float z)
 	mRotation.x = x;
 	mRotation.y = y;
 	mRotation.z = z;
+	MarkTransformDirty();
 }
 
 void CModelControl::MoveX(float x)
 {
 	mPosition.x += x;
+	MarkTransformDirty();
 }
 
 void CModelControl::MoveY(float y)
 {
 	mPosition.y += y;
+	MarkTransformDirty();
 }
 
 void CModelControl::MoveZ(float z)
 {
 	mPosition.z += z;
+	MarkTransformDirty();
 }
 
 float CModelControl::GetPosX()
@@ -141,16 +177,19 @@ D3DXVECTOR3 CModelControl::GetPos()
 void CModelControl::SetXPos(float x)
 {
 	mPosition.x = x;
+	MarkTransformDirty();
 }
 
 void CModelControl::SetYPos(float y)
 {
 	mPosition.y = y;
+	MarkTransformDirty();
 }
 
 void CModelControl::SetZPos(float z)
 {
 	mPosition.z = z;
+	MarkTransformDirty();
 }
 
 void CModelControl::SetPos(float x, float y, float z)
@@ -158,21 +197,25 @@ void CModelControl::SetPos(float x, float y, float z)
 	mPosition.x = x;
 	mPosition.y = y;
 	mPosition.z = z;
+	MarkTransformDirty();
 }
 
 void CModelControl::ScaleX(float x)
 {
 	mScale.x += x;
+	MarkTransformDirty();
 }
 
 void CModelControl::ScaleY(float y)
 {
 	mScale.y += y;
+	MarkTransformDirty();
 }
 
 void CModelControl::ScaleZ(float z)
 {
 	mScale.z += z;
+	MarkTransformDirty();
 }
 
 void CModelControl::Scale(float value)
@@ -180,6 +223,7 @@ void CModelControl::Scale(float value)
 	mScale.x += value;
 	mScale.y += value;
 	mScale.z += value;
+	MarkTransformDirty();
 }
 
 float CModelControl::GetScaleX()
@@ -216,16 +260,19 @@ float CModelControl::GetScaleRadius(float initialRadius)
 void CModelControl::SetScaleX(float x)
 {
 	mScale.x = x;
+	MarkTransformDirty();
 }
 
 void CModelControl::SetScaleY(float y)
 {
 	mScale.y = y;
+	MarkTransformDirty();
 }
 
 void CModelControl::SetScaleZ(float z)
 {
 	mScale.z = z;
+	MarkTransformDirty();
 }
 
 void CModelControl::SetScale(float x, float y, float z)
@@ -233,6 +280,7 @@ void CModelControl::SetScale(float x, float y, float z)
 	mScale.x = x;
 	mScale.y = y;
 	mScale.z = z;
+	MarkTransformDirty();
 }
 
 void CModelControl::SetScale(float value)
@@ -240,16 +288,27 @@ void CModelControl::SetScale(float value)
 	mScale.x = value;
 	mScale.y = value;
 	mScale.z = value;
+	MarkTransformDirty();
 }
 
 void CModelControl::AttatchToParent(CModelControl * parent)
 {
 	mpParent = parent;
+
+	if (mpTransformSystem != nullptr)
+	{
+		mpTransformSystem->MarkHierarchyDirty();
+	}
 }
 
 void CModelControl::SeperateFromParent()
 {
 	mpParent = nullptr;
+
+	if (mpTransformSystem != nullptr)
+	{
+		mpTransformSystem->MarkHierarchyDirty();
+	}
 }
 
 void CModelControl::UpdateMatrices()
@@ -2,10 +2,14 @@
 #define MODELCONTROL_H
 
 #include <D3DX10math.h>
+#include <atomic>
 #include "PrioEngineVars.h"
 
+class CTransformSystem;
+
 class CModelControl
 {
+	friend class CTransformSystem;
 private:
 	CLogger* logger;
 	float ToRadians(float degrees);
@@ -15,6 +19,13 @@ protected:
 	D3DXVECTOR3 mScale;
 	CModelControl* mpParent;
 	D3DXMATRIX mWorldMatrix;
+	// The transform system which calculates our world matrix, null if we calculate it ourselves.
+	CTransformSystem* mpTransformSystem;
+	unsigned int mTransformIndex;
+	// Set when the transform changes and cleared by the transform system once it has read the new values, from any thread.
+	std::atomic<bool> mTransformDirty;
+	// Let the transform system know that our position, rotation or scale has changed.
+	void MarkTransformDirty();
 public:
 	/* Rotation. */
 	void RotateX(float x);
@@ -70,6 +81,10 @@ public:
 	void UpdateMatrices();
 
 	void GetWorldMatrix(D3DXMATRIX& world) { world = mWorldMatrix; };
+
+	// Get the position including any parents, uses the cached result from the transform system when possible.
+	D3DXVECTOR3 GetWorldPosition();
+	bool HasTransformSystem() { return mpTransformSystem != nullptr; };
 public:
 	CModelControl();
 	~CModelControl();
@@ -0,0 +1,631 @@
+#include "NullRenderDevice.h"
+#include <cstring>
+
+// Only the null device defines what its handles point to, so these can't be mistaken for another backend's.
+struct CNullRenderDevice::NullBuffer
+{
+	BufferDesc desc;
+	std::vector<unsigned char> data;
+};
+
+struct CNullRenderDevice::NullPipelineState
+{
+	Topology topology;
+	unsigned int vertexStride;
+};
+
+struct CNullRenderDevice::NullCommandList
+{
+	std::vector<NullCommand> commands;
+	std::vector<unsigned char> uploadData;
+	std::vector<Texture*> textures;
+};
+
+namespace
+{
+	// After this many errors they're only counted, so a bad frame repeated every frame doesn't flood the log.
+	const unsigned int kMaxLoggedErrors = 16;
+
+	unsigned long long CountPrimitives(CRenderDevice::Topology topology, unsigned int count)
+	{
+		return topology == CRenderDevice::PointList ? count : count / 3;
+	}
+}
+
+CNullRenderDevice::CNullRenderDevice()
+{
+	mpPipelineState = nullptr;
+	mpIndexBuffer = nullptr;
+	mpMappedBuffer = nullptr;
+	mpVertexBuffer = nullptr;
+	mVertexStride = 0;
+	mCullMode = CullBack;
+	mBlendMode = NoBlend;
+	mDepthMode = DepthTestAndWrite;
+	mNumberOfErrors = 0;
+	mLastFence = 0;
+	mpImmediateDevice = nullptr;
+	mpCommandList = nullptr;
+	mMappedUploadOffset = 0;
+}
+
+CNullRenderDevice::CNullRenderDevice(CNullRenderDevice* immediateDevice) : CNullRenderDevice()
+{
+	mpImmediateDevice = immediateDevice;
+}
+
+CNullRenderDevice::~CNullRenderDevice()
+{
+	delete mpCommandList;
+}
+
+CRenderDevice::Buffer* CNullRenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+	// Resources belong to the immediate device, deferred devices only share them.
+	if (mpImmediateDevice != nullptr)
+	{
+		return mpImmediateDevice->CreateBuffer(desc, initialData);
+	}
+
+	if (desc.size == 0 || (desc.usage == ImmutableUsage && initialData == nullptr))
+	{
+		ReportError("Immutable buffers need initial data, and no buffer can be empty.");
+		return nullptr;
+	}
+
+	NullBuffer* buffer = new NullBuffer();
+	buffer->desc = desc;
+
+	// Only dynamic buffers are ever handed back to be written to, the rest needn't take up any memory.
+	if (desc.usage == DynamicUsage)
+	{
+		buffer->data.resize(desc.size);
+	}
+
+	mResourceMemory += desc.size;
+
+	return reinterpret_cast<Buffer*>(buffer);
+}
+
+void CNullRenderDevice::DestroyBuffer(Buffer* buffer)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		mpImmediateDevice->DestroyBuffer(buffer);
+		return;
+	}
+
+	NullBuffer* nullBuffer = reinterpret_cast<NullBuffer*>(buffer);
+	if (nullBuffer == nullptr)
+	{
+		return;
+	}
+
+	// Nothing left bound should point at a buffer which no longer exists.
+	mpVertexBuffer = mpVertexBuffer == nullBuffer ? nullptr : mpVertexBuffer;
+	mpIndexBuffer = mpIndexBuffer == nullBuffer ? nullptr : mpIndexBuffer;
+	mpMappedBuffer = mpMappedBuffer == nullBuffer ? nullptr : mpMappedBuffer;
+
+	mResourceMemory -= nullBuffer->desc.size;
+	delete nullBuffer;
+}
+
+CRenderDevice::Texture* CNullRenderDevice::CreateTexture(const TextureDesc& desc, const void* data)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		return mpImmediateDevice->CreateTexture(desc, data);
+	}
+
+	if (desc.width == 0 || desc.height == 0 || desc.mipLevels == 0 || data == nullptr)
+	{
+		ReportError("Textures need a size, at least one mip level and their data.");
+		return nullptr;
+	}
+
+	TextureDesc* texture = new TextureDesc(desc);
+	mResourceMemory += CalculateTextureSize(desc);
+
+	return reinterpret_cast<Texture*>(texture);
+}
+
+void CNullRenderDevice::DestroyTexture(Texture* texture)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		mpImmediateDevice->DestroyTexture(texture);
+		return;
+	}
+
+	TextureDesc* desc = reinterpret_cast<TextureDesc*>(texture);
+	if (desc == nullptr)
+	{
+		return;
+	}
+
+	mResourceMemory -= CalculateTextureSize(*desc);
+	delete desc;
+}
+
+CRenderDevice::PipelineState* CNullRenderDevice::CreatePipelineState(const PipelineStateDesc& desc)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		return mpImmediateDevice->CreatePipelineState(desc);
+	}
+
+	if (desc.vertexShader == nullptr || desc.vertexShaderSize == 0)
+	{
+		ReportError("A pipeline state needs a vertex shader.");
+		return nullptr;
+	}
+
+	NullPipelineState* pipelineState = new NullPipelineState();
+	pipelineState->topology = desc.topology;
+	pipelineState->vertexStride = 0;
+
+	for (unsigned int element = 0; element < desc.numberOfVertexElements; element++)
+	{
+		const unsigned int end = desc.vertexElements[element].offset + GetVertexElementSize(desc.vertexElements[element].format);
+		pipelineState->vertexStride = end > pipelineState->vertexStride ? end : pipelineState->vertexStride;
+	}
+
+	return reinterpret_cast<PipelineState*>(pipelineState);
+}
+
+void CNullRenderDevice::DestroyPipelineState(PipelineState* pipelineState)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		mpImmediateDevice->DestroyPipelineState(pipelineState);
+		return;
+	}
+
+	NullPipelineState* nullPipelineState = reinterpret_cast<NullPipelineState*>(pipelineState);
+	if (mpPipelineState == nullPipelineState)
+	{
+		mpPipelineState = nullptr;
+	}
+	delete nullPipelineState;
+}
+
+void* CNullRenderDevice::Map(Buffer* buffer)
+{
+	NullBuffer* nullBuffer = reinterpret_cast<NullBuffer*>(buffer);
+	if (nullBuffer == nullptr || nullBuffer->desc.usage != DynamicUsage)
+	{
+		ReportError("Only dynamic buffers can be mapped.");
+		return nullptr;
+	}
+
+	if (mpMappedBuffer != nullptr)
+	{
+		ReportError("A buffer was mapped while another was still mapped.");
+	}
+
+	mpMappedBuffer = nullBuffer;
+
+	if (mpImmediateDevice != nullptr)
+	{
+		return RecordUpload(nullBuffer);
+	}
+
+	mStatistics.maps++;
+	mStatistics.uploadBytes += nullBuffer->desc.size;
+
+	return nullBuffer->data.data();
+}
+
+void CNullRenderDevice::Unmap(Buffer* buffer)
+{
+	if (reinterpret_cast<NullBuffer*>(buffer) != mpMappedBuffer)
+	{
+		ReportError("Unmapped a buffer which wasn't mapped.");
+	}
+	else if (mpImmediateDevice != nullptr && mpCommandList != nullptr)
+	{
+		Record(UploadCommand, buffer, 0, 0, 0, 0, mMappedUploadOffset);
+	}
+	mpMappedBuffer = nullptr;
+}
+
+void* CNullRenderDevice::MapNoOverwrite(Buffer* buffer, unsigned int offset, unsigned int size)
+{
+	NullBuffer* nullBuffer = reinterpret_cast<NullBuffer*>(buffer);
+	if (mpImmediateDevice != nullptr)
+	{
+		ReportError("Deferred devices can only map by discarding.");
+		return nullptr;
+	}
+
+	if (nullBuffer == nullptr || nullBuffer->desc.usage != DynamicUsage || nullBuffer->desc.type == ConstantBuffer)
+	{
+		ReportError("Only dynamic vertex and index buffers can be mapped without overwriting.");
+		return nullptr;
+	}
+
+	if (offset + size > nullBuffer->desc.size)
+	{
+		ReportError("Mapped a range past the end of a buffer.");
+		return nullptr;
+	}
+
+	if (mpMappedBuffer != nullptr)
+	{
+		ReportError("A buffer was mapped while another was still mapped.");
+	}
+
+	mpMappedBuffer = nullBuffer;
+	mStatistics.maps++;
+	mStatistics.uploadBytes += size;
+
+	return nullBuffer->data.data() + offset;
+}
+
+unsigned long long CNullRenderDevice::InsertFence()
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		ReportError("Fences can only be inserted on the immediate device.");
+		return 0;
+	}
+
+	return ++mLastFence;
+}
+
+bool CNullRenderDevice::IsFenceComplete(unsigned long long fence)
+{
+	return fence <= mLastFence;
+}
+
+void CNullRenderDevice::SetPipelineState(PipelineState* pipelineState)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		Record(SetPipelineStateCommand, pipelineState, 0, 0, 0);
+		return;
+	}
+
+	mpPipelineState = reinterpret_cast<NullPipelineState*>(pipelineState);
+	mStatistics.pipelineChanges++;
+}
+
+void CNullRenderDevice::SetVertexBuffer(Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		Record(SetVertexBufferCommand, buffer, stride, offset, 0);
+		return;
+	}
+
+	NullBuffer* nullBuffer = reinterpret_cast<NullBuffer*>(buffer);
+	if (nullBuffer != nullptr && nullBuffer->desc.type != VertexBuffer)
+	{
+		ReportError("Bound a buffer which isn't a vertex buffer as one.");
+	}
+
+	mpVertexBuffer = nullBuffer;
+	mVertexStride = stride;
+	mStatistics.bufferBindings++;
+}
+
+void CNullRenderDevice::SetIndexBuffer(Buffer* buffer, IndexFormat format, unsigned int offset)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		Record(SetIndexBufferCommand, buffer, format, offset, 0);
+		return;
+	}
+
+	NullBuffer* nullBuffer = reinterpret_cast<NullBuffer*>(buffer);
+	if (nullBuffer != nullptr && (nullBuffer->desc.type != IndexBuffer || offset >= nullBuffer->desc.size))
+	{
+		ReportError("Bound an index buffer which isn't one, or with an offset past its end.");
+	}
+
+	mpIndexBuffer = nullBuffer;
+	mStatistics.bufferBindings++;
+}
+
+void CNullRenderDevice::SetConstantBuffer(ShaderStage stage, unsigned int slot, Buffer* buffer)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		Record(SetConstantBufferCommand, buffer, stage, slot, 0);
+		return;
+	}
+
+	NullBuffer* nullBuffer = reinterpret_cast<NullBuffer*>(buffer);
+	if (nullBuffer != nullptr && nullBuffer->desc.type != ConstantBuffer)
+	{
+		ReportError("Bound a buffer which isn't a constant buffer as one.");
+	}
+
+	mStatistics.bufferBindings++;
+}
+
+void CNullRenderDevice::SetTextures(ShaderStage stage, unsigned int firstSlot, unsigned int count, Texture* const* textures)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		if (mpCommandList != nullptr)
+		{
+			const size_t dataOffset = mpCommandList->textures.size();
+			mpCommandList->textures.insert(mpCommandList->textures.end(), textures, textures + count);
+			Record(SetTexturesCommand, nullptr, stage, firstSlot, count, 0, dataOffset);
+		}
+		else
+		{
+			Record(SetTexturesCommand, nullptr, stage, firstSlot, count);
+		}
+		return;
+	}
+
+	mStatistics.textureBindings += count;
+}
+
+void CNullRenderDevice::SetCullMode(CullMode mode)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		Record(SetCullModeCommand, nullptr, mode, 0, 0);
+		return;
+	}
+
+	mCullMode = mode;
+	mStatistics.fixedStateChanges++;
+}
+
+void CNullRenderDevice::SetBlendMode(BlendMode mode)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		Record(SetBlendModeCommand, nullptr, mode, 0, 0);
+		return;
+	}
+
+	mBlendMode = mode;
+	mStatistics.fixedStateChanges++;
+}
+
+void CNullRenderDevice::SetDepthMode(DepthMode mode)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		Record(SetDepthModeCommand, nullptr, mode, 0, 0);
+		return;
+	}
+
+	mDepthMode = mode;
+	mStatistics.fixedStateChanges++;
+}
+
+void CNullRenderDevice::Draw(unsigned int vertexCount, unsigned int firstVertex)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		Record(DrawCommand, nullptr, vertexCount, firstVertex, 0);
+		return;
+	}
+
+	if (!CheckDrawState(false))
+	{
+		return;
+	}
+
+	mStatistics.draws++;
+	mStatistics.primitives += CountPrimitives(mpPipelineState->topology, vertexCount);
+}
+
+void CNullRenderDevice::DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex)
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		Record(DrawIndexedCommand, nullptr, indexCount, firstIndex, 0, baseVertex);
+		return;
+	}
+
+	if (!CheckDrawState(true))
+	{
+		return;
+	}
+
+	mStatistics.draws++;
+	mStatistics.primitives += CountPrimitives(mpPipelineState->topology, indexCount);
+}
+
+CRenderDevice* CNullRenderDevice::CreateDeferredDevice()
+{
+	if (mpImmediateDevice != nullptr)
+	{
+		ReportError("Deferred devices can only be created from the immediate device.");
+		return nullptr;
+	}
+
+	return new CNullRenderDevice(this);
+}
+
+/* Nothing is carried over into the list, the null device doesn't track outputs or constants to check draws against. */
+void CNullRenderDevice::BeginCommandList()
+{
+	if (mpImmediateDevice == nullptr)
+	{
+		ReportError("Only a deferred device can record a command list.");
+		return;
+	}
+
+	if (mpCommandList != nullptr)
+	{
+		ReportError("Began a command list without finishing the last one.");
+		delete mpCommandList;
+	}
+
+	mpCommandList = new NullCommandList();
+	mpMappedBuffer = nullptr;
+}
+
+CRenderDevice::CommandList* CNullRenderDevice::FinishCommandList()
+{
+	if (mpCommandList == nullptr)
+	{
+		ReportError("Finished a command list which was never begun.");
+		return nullptr;
+	}
+
+	NullCommandList* commandList = mpCommandList;
+	mpCommandList = nullptr;
+
+	return reinterpret_cast<CommandList*>(commandList);
+}
+
+/* Replay each recorded call through this device, so it's checked and counted as if it had been made here. */
+void CNullRenderDevice::ExecuteCommandList(CommandList* commandList)
+{
+	NullCommandList* nullCommandList = reinterpret_cast<NullCommandList*>(commandList);
+	if (nullCommandList == nullptr)
+	{
+		return;
+	}
+
+	if (mpImmediateDevice != nullptr)
+	{
+		ReportError("Command lists can only be executed on the immediate device.");
+		DiscardCommandList(commandList);
+		return;
+	}
+
+	NullPipelineState* pipelineState = mpPipelineState;
+	NullBuffer* vertexBuffer = mpVertexBuffer;
+	NullBuffer* indexBuffer = mpIndexBuffer;
+	unsigned int vertexStride = mVertexStride;
+	CullMode cullMode = mCullMode;
+	BlendMode blendMode = mBlendMode;
+	DepthMode depthMode = mDepthMode;
+
+	for (auto& command : nullCommandList->commands)
+	{
+		switch (command.type)
+		{
+		case SetPipelineStateCommand:
+			SetPipelineState(static_cast<PipelineState*>(command.handle));
+			break;
+		case SetVertexBufferCommand:
+			SetVertexBuffer(static_cast<Buffer*>(command.handle), command.arguments[0], command.arguments[1]);
+			break;
+		case SetIndexBufferCommand:
+			SetIndexBuffer(static_cast<Buffer*>(command.handle), static_cast<IndexFormat>(command.arguments[0]), command.arguments[1]);
+			break;
+		case SetConstantBufferCommand:
+			SetConstantBuffer(static_cast<ShaderStage>(command.arguments[0]), command.arguments[1], static_cast<Buffer*>(command.handle));
+			break;
+		case SetTexturesCommand:
+			SetTextures(static_cast<ShaderStage>(command.arguments[0]), command.arguments[1], command.arguments[2], nullCommandList->textures.data() + command.dataOffset);
+			break;
+		case SetCullModeCommand:
+			SetCullMode(static_cast<CullMode>(command.arguments[0]));
+			break;
+		case SetBlendModeCommand:
+			SetBlendMode(static_cast<BlendMode>(command.arguments[0]));
+			break;
+		case SetDepthModeCommand:
+			SetDepthMode(static_cast<DepthMode>(command.arguments[0]));
+			break;
+		case UploadCommand:
+		{
+			Buffer* buffer = static_cast<Buffer*>(command.handle);
+			void* destination = Map(buffer);
+			if (destination != nullptr)
+			{
+				std::memcpy(destination, nullCommandList->uploadData.data() + command.dataOffset, static_cast<NullBuffer*>(command.handle)->desc.size);
+				Unmap(buffer);
+			}
+			break;
+		}
+		case DrawCommand:
+			Draw(command.arguments[0], command.arguments[1]);
+			break;
+		case DrawIndexedCommand:
+			DrawIndexed(command.arguments[0], command.arguments[1], command.baseVertex);
+			break;
+		}
+	}
+
+	mpPipelineState = pipelineState;
+	mpVertexBuffer = vertexBuffer;
+	mpIndexBuffer = indexBuffer;
+	mVertexStride = vertexStride;
+	mCullMode = cullMode;
+	mBlendMode = blendMode;
+	mDepthMode = depthMode;
+
+	DiscardCommandList(commandList);
+}
+
+void CNullRenderDevice::DiscardCommandList(CommandList* commandList)
+{
+	delete reinterpret_cast<NullCommandList*>(commandList);
+}
+
+/* @Returns bool Whether everything a draw needs is bound, and the vertex buffer is laid out as the pipeline expects. */
+bool CNullRenderDevice::CheckDrawState(bool indexed)
+{
+	if (mpPipelineState == nullptr || mpVertexBuffer == nullptr || (indexed && mpIndexBuffer == nullptr))
+	{
+		ReportError("Drew without a pipeline state, vertex buffer or index buffer bound.");
+		return false;
+	}
+
+	if (mVertexStride < mpPipelineState->vertexStride)
+	{
+		ReportError("Drew with a vertex stride smaller than the pipeline state's vertex layout.");
+		return false;
+	}
+
+	return true;
+}
+
+void CNullRenderDevice::ReportError(const std::string& message)
+{
+	mNumberOfErrors++;
+	if (mNumberOfErrors <= kMaxLoggedErrors)
+	{
+		logger->GetInstance().WriteLine("Null render device: " + message);
+	}
+}
+
+void CNullRenderDevice::Record(CommandType type, void* handle, unsigned int first, unsigned int second, unsigned int third, int baseVertex, size_t dataOffset)
+{
+	if (mpCommandList == nullptr)
+	{
+		ReportError("Recorded a command without beginning a command list.");
+		return;
+	}
+
+	NullCommand command;
+	command.type = type;
+	command.handle = handle;
+	command.arguments[0] = first;
+	command.arguments[1] = second;
+	command.arguments[2] = third;
+	command.baseVertex = baseVertex;
+	command.dataOffset = dataOffset;
+	mpCommandList->commands.push_back(command);
+}
+
+/* Mapping on a deferred device hands out space in the list, as a real device would, rather than the buffer itself.
+* Other lists recorded at the same time may be mapping the same buffer. The space is recorded as an upload on unmapping.
+* @Returns void* Where to write the whole of the buffer, or nullptr if no list is being recorded. */
+void* CNullRenderDevice::RecordUpload(NullBuffer* buffer)
+{
+	if (mpCommandList == nullptr)
+	{
+		ReportError("Mapped a buffer without beginning a command list.");
+		mpMappedBuffer = nullptr;
+		return nullptr;
+	}
+
+	mMappedUploadOffset = mpCommandList->uploadData.size();
+	mpCommandList->uploadData.resize(mMappedUploadOffset + buffer->desc.size);
+
+	return mpCommandList->uploadData.data() + mMappedUploadOffset;
+}
@@ -0,0 +1,110 @@
+#ifndef NULLRENDERDEVICE_H
+#define NULLRENDERDEVICE_H
+
+#include <vector>
+#include "RenderDevice.h"
+
+/* A render device which executes nothing. Every call is checked and counted, and dynamic buffers are given memory to be
+* written into, so a frame can be built on a machine without a GPU and its draw counts and upload bytes measured.
+* Only buffers and pipeline states created by this device are ever looked inside, textures are just counted.
+* Deferred devices keep each call in a list instead, which is replayed through the immediate device when executed. */
+class CNullRenderDevice : public CRenderDevice
+{
+public:
+	CNullRenderDevice();
+	~CNullRenderDevice();
+public:
+	Buffer* CreateBuffer(const BufferDesc& desc, const void* initialData);
+	void DestroyBuffer(Buffer* buffer);
+	Texture* CreateTexture(const TextureDesc& desc, const void* data);
+	void DestroyTexture(Texture* texture);
+	PipelineState* CreatePipelineState(const PipelineStateDesc& desc);
+	void DestroyPipelineState(PipelineState* pipelineState);
+
+	void* Map(Buffer* buffer);
+	void Unmap(Buffer* buffer);
+	void* MapNoOverwrite(Buffer* buffer, unsigned int offset, unsigned int size);
+
+	unsigned long long InsertFence();
+	bool IsFenceComplete(unsigned long long fence);
+
+	void SetPipelineState(PipelineState* pipelineState);
+	void SetVertexBuffer(Buffer* buffer, unsigned int stride, unsigned int offset);
+	void SetIndexBuffer(Buffer* buffer, IndexFormat format, unsigned int offset);
+	void SetConstantBuffer(ShaderStage stage, unsigned int slot, Buffer* buffer);
+	void SetTextures(ShaderStage stage, unsigned int firstSlot, unsigned int count, Texture* const* textures);
+	void SetCullMode(CullMode mode);
+	void SetBlendMode(BlendMode mode);
+	void SetDepthMode(DepthMode mode);
+
+	void Draw(unsigned int vertexCount, unsigned int firstVertex);
+	void DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex);
+
+	CRenderDevice* CreateDeferredDevice();
+	void BeginCommandList();
+	CommandList* FinishCommandList();
+	void ExecuteCommandList(CommandList* commandList);
+	void DiscardCommandList(CommandList* commandList);
+
+	// Calls which would have been errors on a real device, such as drawing with nothing bound.
+	unsigned int GetNumberOfErrors() { return mNumberOfErrors; };
+	CullMode GetCullMode() { return mCullMode; };
+	BlendMode GetBlendMode() { return mBlendMode; };
+	DepthMode GetDepthMode() { return mDepthMode; };
+private:
+	CNullRenderDevice(CNullRenderDevice* immediateDevice);
+private:
+	struct NullBuffer;
+	struct NullPipelineState;
+	struct NullCommandList;
+
+	enum CommandType
+	{
+		SetPipelineStateCommand,
+		SetVertexBufferCommand,
+		SetIndexBufferCommand,
+		SetConstantBufferCommand,
+		SetTexturesCommand,
+		SetCullModeCommand,
+		SetBlendModeCommand,
+		SetDepthModeCommand,
+		UploadCommand,
+		DrawCommand,
+		DrawIndexedCommand
+	};
+
+	// The handle and arguments of one recorded call, in the order the call takes them.
+	struct NullCommand
+	{
+		CommandType type;
+		void* handle;
+		unsigned int arguments[3];
+		int baseVertex;
+		// Where the command's uploaded data or textures start in the list.
+		size_t dataOffset;
+	};
+
+	bool CheckDrawState(bool indexed);
+	void ReportError(const std::string& message);
+	void Record(CommandType type, void* handle, unsigned int first, unsigned int second, unsigned int third, int baseVertex = 0, size_t dataOffset = 0);
+	void* RecordUpload(NullBuffer* buffer);
+private:
+	NullPipelineState* mpPipelineState;
+	NullBuffer* mpVertexBuffer;
+	NullBuffer* mpIndexBuffer;
+	NullBuffer* mpMappedBuffer;
+	unsigned int mVertexStride;
+	CullMode mCullMode;
+	BlendMode mBlendMode;
+	DepthMode mDepthMode;
+	unsigned int mNumberOfErrors;
+	// There's no GPU to wait on, so every fence is complete as soon as it's inserted.
+	unsigned long long mLastFence;
+
+	// Set for deferred devices only, along with the list being recorded.
+	CNullRenderDevice* mpImmediateDevice;
+	NullCommandList* mpCommandList;
+	size_t mMappedUploadOffset;
+};
+
+#endif
@@ -0,0 +1,340 @@
+#include "OcclusionCuller.h"
+#include "Terrain.h"
+#include <xmmintrin.h>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	// Anything with a w smaller than this is treated as being on or behind the camera.
+	const float kMinW = 0.0001f;
+}
+
+COcclusionCuller::COcclusionCuller(CThreadPool* threadPool)
+{
+	mpThreadPool = threadPool;
+	mpTerrain = nullptr;
+	mTerrainVersion = 0;
+	D3DXMatrixIdentity(&mViewProj);
+	mDepthBuffer.resize(kDepthBufferWidth * kDepthBufferHeight, 1.0f);
+}
+
+
+COcclusionCuller::~COcclusionCuller()
+{
+}
+
+/* Reduce the height map to a grid of at most kMaxOccluderCells cells along each side.
+* Each point takes the lowest height from every cell it touches, so the flat triangles between points never rise above the real surface. */
+void COcclusionCuller::BuildOccluder(double** heightMap, int width, int height)
+{
+	mVertices.clear();
+	mIndices.clear();
+
+	if (heightMap == nullptr || width < 2 || height < 2)
+	{
+		return;
+	}
+
+	const int largestSide = std::max(width, height) - 1;
+	const int step = std::max(1, (largestSide + static_cast<int>(kMaxOccluderCells) - 1) / static_cast<int>(kMaxOccluderCells));
+	const int cellsX = (width - 1 + step - 1) / step;
+	const int cellsZ = (height - 1 + step - 1) / step;
+
+	for (int gridZ = 0; gridZ <= cellsZ; gridZ++)
+	{
+		const int z = std::min(gridZ * step, height - 1);
+
+		for (int gridX = 0; gridX <= cellsX; gridX++)
+		{
+			const int x = std::min(gridX * step, width - 1);
+
+			double lowest = heightMap[z][x];
+			for (int sampleZ = std::max(0, z - step); sampleZ <= std::min(height - 1, z + step); sampleZ++)
+			{
+				for (int sampleX = std::max(0, x - step); sampleX <= std::min(width - 1, x + step); sampleX++)
+				{
+					lowest = std::min(lowest, heightMap[sampleZ][sampleX]);
+				}
+			}
+
+			// Same layout as the terrain vertices, x and z come straight from the grid coordinates.
+			mVertices.push_back(D3DXVECTOR3(static_cast<float>(x), static_cast<float>(lowest), static_cast<float>(z)));
+		}
+	}
+
+	const unsigned int rowLength = cellsX + 1;
+	for (int gridZ = 0; gridZ < cellsZ; gridZ++)
+	{
+		for (int gridX = 0; gridX < cellsX; gridX++)
+		{
+			const unsigned int vertex = gridZ * rowLength + gridX;
+
+			mIndices.push_back(vertex);
+			mIndices.push_back(vertex + rowLength);
+			mIndices.push_back(vertex + 1);
+
+			mIndices.push_back(vertex + 1);
+			mIndices.push_back(vertex + rowLength);
+			mIndices.push_back(vertex + rowLength + 1);
+		}
+	}
+
+	mScreenVertices.resize(mVertices.size());
+
+	logger->GetInstance().WriteLine("Built terrain occluder with " + std::to_string(mIndices.size() / 3) + " triangles.");
+}
+
+void COcclusionCuller::UpdateOccluder(CTerrain* terrain)
+{
+	if (terrain == nullptr || terrain->GetUpdateFlag())
+	{
+		return;
+	}
+
+	if (terrain == mpTerrain && terrain->GetHeightMapVersion() == mTerrainVersion)
+	{
+		return;
+	}
+
+	mpTerrain = terrain;
+	mTerrainVersion = terrain->GetHeightMapVersion();
+	BuildOccluder(terrain->GetHeightMap(), terrain->GetWidth(), terrain->GetHeight());
+}
+
+/* Project the occluder then split the depth buffer into bands of rows, each of which is filled in by a different worker. */
+void COcclusionCuller::Rasterise(const D3DXMATRIX& occluderWorld, const D3DXMATRIX& viewProj)
+{
+	mViewProj = viewProj;
+	std::fill(mDepthBuffer.begin(), mDepthBuffer.end(), 1.0f);
+
+	if (mIndices.empty())
+	{
+		return;
+	}
+
+	D3DXMATRIX worldViewProj;
+	D3DXMatrixMultiply(&worldViewProj, &occluderWorld, &viewProj);
+	const D3DXMATRIX& m = worldViewProj;
+
+	for (unsigned int i = 0; i < mVertices.size(); i++)
+	{
+		const D3DXVECTOR3& v = mVertices[i];
+		const float clipX = v.x * m._11 + v.y * m._21 + v.z * m._31 + m._41;
+		const float clipY = v.x * m._12 + v.y * m._22 + v.z * m._32 + m._42;
+		const float clipZ = v.x * m._13 + v.y * m._23 + v.z * m._33 + m._43;
+		const float clipW = v.x * m._14 + v.y * m._24 + v.z * m._34 + m._44;
+
+		ScreenVertex& screen = mScreenVertices[i];
+		screen.valid = clipW > kMinW;
+		if (screen.valid)
+		{
+			const float invW = 1.0f / clipW;
+			screen.x = (clipX * invW * 0.5f + 0.5f) * kDepthBufferWidth;
+			screen.y = (0.5f - clipY * invW * 0.5f) * kDepthBufferHeight;
+			screen.z = clipZ * invW;
+		}
+	}
+
+	const unsigned int numberOfBands = (kDepthBufferHeight + kRowsPerJob - 1) / kRowsPerJob;
+	mpThreadPool->ParallelFor(numberOfBands, 1, [this](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int band = begin; band < end; band++)
+		{
+			const unsigned int firstRow = band * kRowsPerJob;
+			const unsigned int lastRow = firstRow + kRowsPerJob < kDepthBufferHeight ? firstRow + kRowsPerJob : kDepthBufferHeight;
+			RasteriseRows(firstRow, lastRow);
+		}
+	});
+}
+
+void COcclusionCuller::RasteriseRows(unsigned int firstRow, unsigned int lastRow)
+{
+	for (unsigned int i = 0; i + 2 < mIndices.size(); i += 3)
+	{
+		const ScreenVertex& v0 = mScreenVertices[mIndices[i]];
+		const ScreenVertex& v1 = mScreenVertices[mIndices[i + 1]];
+		const ScreenVertex& v2 = mScreenVertices[mIndices[i + 2]];
+
+		// Triangles crossing the near plane are dropped rather than clipped, which can only make the occluder smaller.
+		if (!v0.valid || !v1.valid || !v2.valid)
+		{
+			continue;
+		}
+
+		RasteriseTriangle(v0, v1, v2, firstRow, lastRow);
+	}
+}
+
+/* Fill the pixels whose centres lie inside the triangle, four at a time, keeping the nearest depth. Both windings are filled
+* since the terrain can be seen from underneath. */
+void COcclusionCuller::RasteriseTriangle(const ScreenVertex& v0, const ScreenVertex& in1, const ScreenVertex& in2, unsigned int firstRow, unsigned int lastRow)
+{
+	float area = (in1.x - v0.x) * (in2.y - v0.y) - (in2.x - v0.x) * (in1.y - v0.y);
+	if (std::abs(area) < 0.0001f)
+	{
+		return;
+	}
+
+	const ScreenVertex& v1 = area > 0.0f ? in1 : in2;
+	const ScreenVertex& v2 = area > 0.0f ? in2 : in1;
+	area = std::abs(area);
+
+	const float minX = std::min(v0.x, std::min(v1.x, v2.x));
+	const float maxX = std::max(v0.x, std::max(v1.x, v2.x));
+	const float minY = std::min(v0.y, std::min(v1.y, v2.y));
+	const float maxY = std::max(v0.y, std::max(v1.y, v2.y));
+
+	if (maxX < 0.0f || minX >= kDepthBufferWidth || maxY < static_cast<float>(firstRow) || minY >= static_cast<float>(lastRow))
+	{
+		return;
+	}
+
+	const int startX = std::max(0, static_cast<int>(std::floor(minX))) & ~3;
+	const int endX = std::min(static_cast<int>(kDepthBufferWidth) - 1, static_cast<int>(std::floor(maxX)));
+	const int startY = std::max(static_cast<int>(firstRow), static_cast<int>(std::floor(minY)));
+	const int endY = std::min(static_cast<int>(lastRow) - 1, static_cast<int>(std::floor(maxY)));
+
+	// Edge functions in the form A * x + B * y + C, positive on the inside of each edge.
+	const ScreenVertex* points[3] = { &v0, &v1, &v2 };
+	float edgeA[3];
+	float edgeB[3];
+	float edgeC[3];
+	for (int edge = 0; edge < 3; edge++)
+	{
+		const ScreenVertex& a = *points[edge];
+		const ScreenVertex& b = *points[(edge + 1) % 3];
+		edgeA[edge] = -(b.y - a.y);
+		edgeB[edge] = b.x - a.x;
+		edgeC[edge] = -(edgeA[edge] * a.x + edgeB[edge] * a.y);
+	}
+
+	// Depth varies linearly across the screen.
+	const float depthDX = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	const float depthDY = ((v1.x - v0.x) * (v2.z - v0.z) - (v2.x - v0.x) * (v1.z - v0.z)) / area;
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 laneOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+
+	for (int y = startY; y <= endY; y++)
+	{
+		const float pixelY = static_cast<float>(y) + 0.5f;
+		float* row = &mDepthBuffer[y * kDepthBufferWidth];
+
+		const __m128 rowEdge0 = _mm_set1_ps(edgeB[0] * pixelY + edgeC[0]);
+		const __m128 rowEdge1 = _mm_set1_ps(edgeB[1] * pixelY + edgeC[1]);
+		const __m128 rowEdge2 = _mm_set1_ps(edgeB[2] * pixelY + edgeC[2]);
+		const __m128 rowDepth = _mm_set1_ps(v0.z + depthDY * (pixelY - v0.y));
+
+		for (int x = startX; x <= endX; x += 4)
+		{
+			const __m128 pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+
+			const __m128 edge0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[0]), pixelX), rowEdge0);
+			const __m128 edge1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[1]), pixelX), rowEdge1);
+			const __m128 edge2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[2]), pixelX), rowEdge2);
+
+			__m128 inside = _mm_cmpge_ps(edge0, zero);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(edge1, zero));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(edge2, zero));
+
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			const __m128 depth = _mm_add_ps(rowDepth, _mm_mul_ps(_mm_set1_ps(depthDX), _mm_sub_ps(pixelX, _mm_set1_ps(v0.x))));
+			const __m128 current = _mm_loadu_ps(row + x);
+			const __m128 nearest = _mm_min_ps(current, depth);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+		}
+	}
+}
+
+/* Project the corners of the box and find the closest depth of any of them, then check whether the occluder is
+* nearer than that over every pixel the box covers. */
+bool COcclusionCuller::TestAABB(const D3DXVECTOR3& minBounds, const D3DXVECTOR3& maxBounds)
+{
+	if (mIndices.empty())
+	{
+		return true;
+	}
+
+	const D3DXMATRIX& m = mViewProj;
+	float screenMinX = std::numeric_limits<float>::max();
+	float screenMaxX = -std::numeric_limits<float>::max();
+	float screenMinY = std::numeric_limits<float>::max();
+	float screenMaxY = -std::numeric_limits<float>::max();
+	float nearestDepth = 1.0f;
+
+	for (int corner = 0; corner < 8; corner++)
+	{
+		const float x = corner & 1 ? maxBounds.x : minBounds.x;
+		const float y = corner & 2 ? maxBounds.y : minBounds.y;
+		const float z = corner & 4 ? maxBounds.z : minBounds.z;
+
+		const float clipW = x * m._14 + y * m._24 + z * m._34 + m._44;
+
+		// Reaches behind the camera, don't try to cull it.
+		if (clipW <= kMinW)
+		{
+			return true;
+		}
+
+		const float invW = 1.0f / clipW;
+		const float screenX = ((x * m._11 + y * m._21 + z * m._31 + m._41) * invW * 0.5f + 0.5f) * kDepthBufferWidth;
+		const float screenY = (0.5f - (x * m._12 + y * m._22 + z * m._32 + m._42) * invW * 0.5f) * kDepthBufferHeight;
+		const float depth = (x * m._13 + y * m._23 + z * m._33 + m._43) * invW;
+
+		screenMinX = std::min(screenMinX, screenX);
+		screenMaxX = std::max(screenMaxX, screenX);
+		screenMinY = std::min(screenMinY, screenY);
+		screenMaxY = std::max(screenMaxY, screenY);
+		nearestDepth = std::min(nearestDepth, depth);
+	}
+
+	// Entirely off screen, leave that to the frustum.
+	if (screenMaxX < 0.0f || screenMinX >= kDepthBufferWidth || screenMaxY < 0.0f || screenMinY >= kDepthBufferHeight)
+	{
+		return true;
+	}
+
+	// Widened out to whole pixels. Occluders only cover a pixel by its centre, so a box reaching partway into one can still
+	// be seen beside the edge of an occluder covering it, and the pixel past the edge is checked as well.
+	const int startX = std::max(0, static_cast<int>(std::floor(screenMinX)));
+	const int endX = std::min(static_cast<int>(kDepthBufferWidth) - 1, static_cast<int>(std::ceil(screenMaxX)));
+	const int startY = std::max(0, static_cast<int>(std::floor(screenMinY)));
+	const int endY = std::min(static_cast<int>(kDepthBufferHeight) - 1, static_cast<int>(std::ceil(screenMaxY)));
+
+	const __m128 boxDepth = _mm_set1_ps(nearestDepth);
+	const __m128 laneIndices = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	const __m128 firstColumn = _mm_set1_ps(static_cast<float>(startX));
+	const __m128 lastColumn = _mm_set1_ps(static_cast<float>(endX));
+
+	for (int y = startY; y <= endY; y++)
+	{
+		const float* row = &mDepthBuffer[y * kDepthBufferWidth];
+
+		for (int x = startX & ~3; x <= endX; x += 4)
+		{
+			const __m128 column = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneIndices);
+			const __m128 inRect = _mm_and_ps(_mm_cmpge_ps(column, firstColumn), _mm_cmple_ps(column, lastColumn));
+
+			// Any pixel where the occluder is further away than the box means some of it could be seen.
+			const __m128 uncovered = _mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth);
+			if (_mm_movemask_ps(_mm_and_ps(inRect, uncovered)) != 0)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool COcclusionCuller::TestSphere(const D3DXVECTOR3& centre, float radius)
+{
+	const D3DXVECTOR3 extent(radius, radius, radius);
+	return TestAABB(centre - extent, centre + extent);
+}
@@ -0,0 +1,67 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include <D3DX10math.h>
+#include <vector>
+#include "PrioEngineVars.h"
+#include "ThreadPool.h"
+
+class CTerrain;
+
+/* Rasterises a coarse copy of the terrain into a small depth buffer on the CPU, which bounding boxes can then be tested against.
+* The occluder is built from the lowest heights around each point so it always sits on or below the real terrain,
+* meaning anything reported as hidden really is hidden behind a hill. Nothing here touches the GPU. */
+class COcclusionCuller
+{
+private:
+	CLogger* logger;
+public:
+	static const unsigned int kDepthBufferWidth = 256;
+	static const unsigned int kDepthBufferHeight = 144;
+	// The most cells the occluder will have along either side of the terrain.
+	static const unsigned int kMaxOccluderCells = 64;
+	// How many rows of the depth buffer a single rasterisation job covers.
+	static const unsigned int kRowsPerJob = 16;
+public:
+	COcclusionCuller(CThreadPool* threadPool);
+	~COcclusionCuller();
+public:
+	// Build the coarse occluder mesh from a height map. Only needs calling when the height map changes.
+	void BuildOccluder(double** heightMap, int width, int height);
+	// Build the occluder from a terrain, does nothing if the terrain hasn't changed since the last call.
+	void UpdateOccluder(CTerrain* terrain);
+	// Clear the depth buffer and rasterise the occluder into it, should be called once per frame before testing.
+	void Rasterise(const D3DXMATRIX& occluderWorld, const D3DXMATRIX& viewProj);
+	// Returns false if the box is entirely behind the occluder. Safe to call from multiple threads once rasterisation is done.
+	bool TestAABB(const D3DXVECTOR3& minBounds, const D3DXVECTOR3& maxBounds);
+	bool TestSphere(const D3DXVECTOR3& centre, float radius);
+public:
+	bool HasOccluder() { return !mIndices.empty(); };
+	const float* GetDepthBuffer() { return mDepthBuffer.data(); };
+private:
+	struct ScreenVertex
+	{
+		float x;
+		float y;
+		float z;
+		bool valid;
+	};
+
+	void RasteriseRows(unsigned int firstRow, unsigned int lastRow);
+	void RasteriseTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2, unsigned int firstRow, unsigned int lastRow);
+private:
+	CThreadPool* mpThreadPool;
+	CTerrain* mpTerrain;
+	unsigned int mTerrainVersion;
+
+	// Occluder mesh in the local space of the terrain.
+	std::vector<D3DXVECTOR3> mVertices;
+	std::vector<unsigned int> mIndices;
+	// Occluder vertices after being projected this frame.
+	std::vector<ScreenVertex> mScreenVertices;
+
+	D3DXMATRIX mViewProj;
+	std::vector<float> mDepthBuffer;
+};
+
+#endif
@@ -0,0 +1,290 @@
+#include "PackFile.h"
+#include "Lz4.h"
+#include "CookedMesh.h"
+#include "TextureCooker.h"
+#include "DiskFile.h"
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <fstream>
+#include <unordered_set>
+
+namespace
+{
+	const char kMagic[4] = { 'P', 'P', 'A', 'K' };
+
+	// Only worth paying to decompress an entry if it saves at least an eighth of its size.
+	const unsigned int kMinimumSavingShift = 3;
+
+	unsigned long long AlignOffset(unsigned long long offset)
+	{
+		return (offset + CPackFile::kEntryAlignment - 1) & ~static_cast<unsigned long long>(CPackFile::kEntryAlignment - 1);
+	}
+
+	bool EndsWith(const std::string& text, const std::string& ending)
+	{
+		return text.size() >= ending.size() && text.compare(text.size() - ending.size(), ending.size(), ending) == 0;
+	}
+}
+
+CPackFile::CPackFile()
+{
+	mpEntries = nullptr;
+	mpPaths = nullptr;
+	mPathsSize = 0;
+	mNumberOfEntries = 0;
+}
+
+
+CPackFile::~CPackFile()
+{
+	Close();
+}
+
+/* Maps the pack into memory and checks its header, the entries themselves aren't touched until they're asked for.
+* @Returns bool Success */
+bool CPackFile::Open(const std::string& filename)
+{
+	Close();
+
+	if (!mFile.Open(filename))
+	{
+		return false;
+	}
+
+	const unsigned char* data = mFile.GetData();
+	const size_t size = mFile.GetSize();
+
+	if (size < sizeof(Header))
+	{
+		logger->GetInstance().WriteLine("The pack '" + filename + "' is too small to hold a header.");
+		Close();
+		return false;
+	}
+
+	const Header* header = reinterpret_cast<const Header*>(data);
+	if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion)
+	{
+		logger->GetInstance().WriteLine("The pack '" + filename + "' isn't a pack, or was built by another version of the engine.");
+		Close();
+		return false;
+	}
+
+	const unsigned long long indexEnd = header->indexOffset + static_cast<unsigned long long>(header->numberOfEntries) * sizeof(Entry);
+	if (header->indexOffset > size || indexEnd > size || header->pathsOffset > size || header->pathsSize > size - header->pathsOffset ||
+		header->indexOffset % kEntryAlignment != 0)
+	{
+		logger->GetInstance().WriteLine("The pack '" + filename + "' is truncated.");
+		Close();
+		return false;
+	}
+
+	mFilename = filename;
+	mpEntries = reinterpret_cast<const Entry*>(data + header->indexOffset);
+	mpPaths = reinterpret_cast<const char*>(data + header->pathsOffset);
+	mPathsSize = header->pathsSize;
+	mNumberOfEntries = header->numberOfEntries;
+
+	return true;
+}
+
+void CPackFile::Close()
+{
+	mFile.Close();
+	mFilename.clear();
+	mpEntries = nullptr;
+	mpPaths = nullptr;
+	mPathsSize = 0;
+	mNumberOfEntries = 0;
+}
+
+/* Binary search of the index by the hash of the path, then the path itself is compared in case two share a hash.
+* Only reads from the mapping, so can be called from any thread.
+* @Returns const Entry* The entry, nullptr if the pack doesn't hold the file. */
+const CPackFile::Entry* CPackFile::Find(const std::string& filename)
+{
+	if (mpEntries == nullptr)
+	{
+		return nullptr;
+	}
+
+	const std::string path = NormaliseFilename(filename);
+	const unsigned long long pathHash = PrioEngine::Hash::FNV1a(path.data(), path.size());
+
+	const Entry* entriesEnd = mpEntries + mNumberOfEntries;
+	const Entry* entry = std::lower_bound(mpEntries, entriesEnd, pathHash, [](const Entry& entry, unsigned long long hash)
+	{
+		return entry.pathHash < hash;
+	});
+
+	for (; entry != entriesEnd && entry->pathHash == pathHash; ++entry)
+	{
+		if (entry->pathLength != path.size())
+		{
+			continue;
+		}
+
+		// Checked before the path is compared, a corrupt entry could otherwise point it anywhere in memory.
+		if (entry->pathOffset > mPathsSize || entry->pathLength > mPathsSize - entry->pathOffset)
+		{
+			logger->GetInstance().WriteLine("The path of an entry runs past the end of the paths in the pack '" + mFilename + "'.");
+			return nullptr;
+		}
+
+		if (memcmp(mpPaths + entry->pathOffset, path.data(), path.size()) != 0)
+		{
+			continue;
+		}
+
+		if (entry->offset > mFile.GetSize() || entry->storedSize > mFile.GetSize() - entry->offset)
+		{
+			logger->GetInstance().WriteLine("The entry for '" + path + "' runs past the end of the pack '" + mFilename + "'.");
+			return nullptr;
+		}
+
+		return entry;
+	}
+
+	return nullptr;
+}
+
+/* Writes the header, then the data of every file, then the paths and finally the index sorted by path hash.
+* @Returns bool Success */
+bool CPackFile::Build(const std::string& packFile, const std::vector<std::string>& directories)
+{
+	std::vector<std::string> files;
+	for (auto& directory : directories)
+	{
+		if (!PrioEngine::DiskFile::FindFiles(directory, files))
+		{
+			CLogger::GetInstance().WriteLine("Failed to find any files to pack in '" + directory + "'.");
+		}
+	}
+
+	std::unordered_set<std::string> normalisedFiles;
+	for (auto& file : files)
+	{
+		normalisedFiles.insert(NormaliseFilename(file));
+	}
+
+	Header header;
+	memset(&header, 0, sizeof(Header));
+	std::vector<Entry> entries;
+	unsigned long long totalSize = 0;
+
+	const bool written = PrioEngine::DiskFile::Write(packFile, [&](std::ofstream& output)
+	{
+		output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+		std::string paths;
+		unsigned long long offset = sizeof(Header);
+		std::vector<unsigned char> compressed;
+		const char padding[kEntryAlignment] = {};
+
+		for (auto& file : files)
+		{
+			const std::string path = NormaliseFilename(file);
+
+			// Left behind by a write which never finished, or one still going.
+			if (EndsWith(path, PrioEngine::DiskFile::kTemporaryExtension))
+			{
+				continue;
+			}
+
+			if (normalisedFiles.count(NormaliseFilename(CCookedMesh::GetCookedFilename(file))) != 0 ||
+				normalisedFiles.count(NormaliseFilename(CTextureCooker::GetCookedFilename(file))) != 0)
+			{
+				continue;
+			}
+
+			CMappedFile source;
+			if (!source.Open(file))
+			{
+				// Empty files can't be mapped, and nothing would want to load one anyway.
+				CLogger::GetInstance().WriteLine("Skipped '" + file + "' when packing, it's empty or couldn't be opened.");
+				continue;
+			}
+
+			Entry entry;
+			memset(&entry, 0, sizeof(Entry));
+			entry.pathHash = PrioEngine::Hash::FNV1a(path.data(), path.size());
+			entry.size = source.GetSize();
+			entry.pathOffset = static_cast<unsigned int>(paths.size());
+			entry.pathLength = static_cast<unsigned int>(path.size());
+			paths += path;
+
+			const unsigned char* data = source.GetData();
+			entry.storedSize = entry.size;
+
+			PrioEngine::Lz4::Compress(source.GetData(), source.GetSize(), compressed);
+			if (compressed.size() <= source.GetSize() - (source.GetSize() >> kMinimumSavingShift))
+			{
+				entry.flags |= CompressedEntry;
+				entry.storedSize = compressed.size();
+				data = compressed.data();
+			}
+
+			const unsigned long long alignedOffset = AlignOffset(offset);
+			output.write(padding, alignedOffset - offset);
+			output.write(reinterpret_cast<const char*>(data), entry.storedSize);
+			entry.offset = alignedOffset;
+			offset = alignedOffset + entry.storedSize;
+			totalSize += entry.size;
+
+			entries.push_back(entry);
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b)
+		{
+			return a.pathHash < b.pathHash;
+		});
+
+		header.pathsOffset = offset;
+		header.pathsSize = paths.size();
+		output.write(paths.data(), paths.size());
+		offset += paths.size();
+
+		header.indexOffset = AlignOffset(offset);
+		output.write(padding, header.indexOffset - offset);
+		if (!entries.empty())
+		{
+			output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+		}
+
+		memcpy(header.magic, kMagic, sizeof(kMagic));
+		header.version = kVersion;
+		header.numberOfEntries = static_cast<unsigned int>(entries.size());
+		output.seekp(0);
+		output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	});
+
+	if (!written)
+	{
+		CLogger::GetInstance().WriteLine("Failed to write the pack '" + packFile + "'.");
+		return false;
+	}
+
+	CLogger::GetInstance().WriteLine("Packed " + std::to_string(entries.size()) + " files, " + std::to_string(totalSize / 1024) + "KB into " +
+		std::to_string((header.indexOffset + entries.size() * sizeof(Entry)) / 1024) + "KB in '" + packFile + "'.");
+
+	return true;
+}
+
+std::string CPackFile::NormaliseFilename(const std::string& filename)
+{
+	std::string normalised;
+	normalised.reserve(filename.size());
+
+	for (auto character : filename)
+	{
+		normalised += character == '\\' ? '/' : static_cast<char>(tolower(static_cast<unsigned char>(character)));
+	}
+
+	// "./Resources" is the same file as "Resources".
+	while (normalised.compare(0, 2, "./") == 0)
+	{
+		normalised.erase(0, 2);
+	}
+
+	return normalised;
+}
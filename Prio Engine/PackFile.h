@@ -0,0 +1,77 @@
+#ifndef PACKFILE_H
+#define PACKFILE_H
+
+#include <string>
+#include <vector>
+#include "Logger.h"
+#include "MappedFile.h"
+
+/* Many resource files stored in one archive, which is memory mapped once rather than each file being opened separately.
+* The index is sorted by a hash of each path, so finding a file is a binary search straight over the mapped index with
+* nothing read in up front. The data of every entry starts on a 16 byte boundary, and entries which shrink enough are
+* stored LZ4 compressed. */
+class CPackFile
+{
+private:
+	CLogger* logger;
+public:
+	// Bump this whenever the layout of the file changes, older packs will then be refused.
+	static const unsigned int kVersion = 1;
+	static const unsigned int kEntryAlignment = 16;
+
+	enum EntryFlags
+	{
+		CompressedEntry = 0x1
+	};
+
+	struct Entry
+	{
+		unsigned long long pathHash;
+		unsigned long long offset;
+		// Bytes taken up in the pack, which is less than the size of the file when compressed.
+		unsigned long long storedSize;
+		unsigned long long size;
+		unsigned int pathOffset;
+		unsigned int pathLength;
+		unsigned int flags;
+		unsigned int padding;
+	};
+public:
+	CPackFile();
+	~CPackFile();
+public:
+	bool Open(const std::string& filename);
+	void Close();
+
+	// Find a file by its path, nullptr if the pack doesn't hold it.
+	const Entry* Find(const std::string& filename);
+	const unsigned char* GetEntryData(const Entry& entry) { return mFile.GetData() + entry.offset; };
+	unsigned int GetNumberOfEntries() { return mNumberOfEntries; };
+	const std::string& GetFilename() { return mFilename; };
+
+	// Pack every file found under the directories given, and their sub directories, into a single archive. Source
+	// models and textures which have a cooked copy beside them are left out, the cooked copy is all that's loaded.
+	static bool Build(const std::string& packFile, const std::vector<std::string>& directories);
+	// Paths are stored lower case with forward slashes, so they're found however they're written when asked for.
+	static std::string NormaliseFilename(const std::string& filename);
+private:
+	struct Header
+	{
+		char magic[4];
+		unsigned int version;
+		unsigned int numberOfEntries;
+		unsigned int padding;
+		unsigned long long indexOffset;
+		unsigned long long pathsOffset;
+		unsigned long long pathsSize;
+	};
+private:
+	std::string mFilename;
+	CMappedFile mFile;
+	const Entry* mpEntries;
+	const char* mpPaths;
+	unsigned long long mPathsSize;
+	unsigned int mNumberOfEntries;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "PassRecorder.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+CPassRecorder::CPassRecorder(CRenderDevice* renderDevice, CThreadPool* threadPool)
+{
+	mpRenderDevice = renderDevice;
+	mpThreadPool = threadPool;
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+}
+
+
+CPassRecorder::~CPassRecorder()
+{
+	Shutdown();
+}
+
+void CPassRecorder::Shutdown()
+{
+	for (auto& deferredDevice : mDeferredDevices)
+	{
+		delete deferredDevice;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(deferredDevice).name());
+	}
+
+	mDeferredDevices.clear();
+	mCommandLists.clear();
+	mPasses.clear();
+}
+
+void CPassRecorder::AddPass(RecordFunction function)
+{
+	mPasses.push_back(function);
+}
+
+bool CPassRecorder::Execute()
+{
+	const unsigned int numberOfPasses = static_cast<unsigned int>(mPasses.size());
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+	mStatistics.passes = numberOfPasses;
+
+	while (mDeferredDevices.size() < numberOfPasses)
+	{
+		CRenderDevice* deferredDevice = mpRenderDevice->CreateDeferredDevice();
+		if (deferredDevice == nullptr)
+		{
+			logger->GetInstance().WriteLine("Failed to create a deferred render device to record a pass on.");
+			mPasses.clear();
+			return false;
+		}
+
+		mDeferredDevices.push_back(deferredDevice);
+		logger->GetInstance().MemoryAllocWriteLine(typeid(deferredDevice).name());
+	}
+
+	// What each pass inherits is read from the immediate device here, before any worker starts recording.
+	for (unsigned int pass = 0; pass < numberOfPasses; pass++)
+	{
+		mDeferredDevices[pass]->BeginCommandList();
+	}
+	mCommandLists.assign(numberOfPasses, nullptr);
+
+	const auto recordStart = std::chrono::high_resolution_clock::now();
+
+	std::atomic<bool> succeeded(true);
+	mpThreadPool->ParallelFor(numberOfPasses, 1, [this, &succeeded](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int pass = begin; pass < end; pass++)
+		{
+			if (!RecordPass(pass))
+			{
+				succeeded = false;
+			}
+		}
+	});
+
+	const auto executeStart = std::chrono::high_resolution_clock::now();
+
+	for (auto commandList : mCommandLists)
+	{
+		if (succeeded)
+		{
+			mpRenderDevice->ExecuteCommandList(commandList);
+		}
+		else
+		{
+			mpRenderDevice->DiscardCommandList(commandList);
+		}
+	}
+
+	const auto executeEnd = std::chrono::high_resolution_clock::now();
+	const std::chrono::duration<float, std::milli> recordTime = executeStart - recordStart;
+	const std::chrono::duration<float, std::milli> executeTime = executeEnd - executeStart;
+	mStatistics.recordTime = recordTime.count();
+	mStatistics.executeTime = executeTime.count();
+
+	mCommandLists.clear();
+	mPasses.clear();
+
+	return succeeded;
+}
+
+/* The list is always finished, even when the pass fails, so the deferred device is ready for the next frame.
+* @Returns bool Whether the pass recorded and its list was finished. */
+bool CPassRecorder::RecordPass(unsigned int pass)
+{
+	const bool recorded = mPasses[pass](mDeferredDevices[pass]);
+	mCommandLists[pass] = mDeferredDevices[pass]->FinishCommandList();
+
+	return recorded && mCommandLists[pass] != nullptr;
+}
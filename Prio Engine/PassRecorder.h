@@ -0,0 +1,55 @@
+#ifndef PASSRECORDER_H
+#define PASSRECORDER_H
+
+#include <vector>
+#include <functional>
+#include "RenderDevice.h"
+#include "ThreadPool.h"
+
+/* Records passes across the thread pool, each onto a deferred render device of its own, then executes the command lists
+* on the immediate device in the order the passes were added. Passes are recorded at the same time as each other, so
+* a pass mustn't touch anything on the CPU which another pass is also using. Runs the same over the null device, so the
+* cost of recording can be measured without a GPU. Must only be used from the thread which owns the render device. */
+class CPassRecorder
+{
+private:
+	CLogger* logger;
+public:
+	// Given the deferred device to record the pass onto. Returning false fails the whole of Execute.
+	typedef std::function<bool(CRenderDevice* renderDevice)> RecordFunction;
+
+	// Counted by the last call to Execute.
+	struct Statistics
+	{
+		unsigned int passes;
+		// Wall clock time from starting to record the first pass until the last had finished.
+		float recordTime;
+		// Time spent executing the command lists on the immediate device.
+		float executeTime;
+	};
+public:
+	CPassRecorder(CRenderDevice* renderDevice, CThreadPool* threadPool);
+	~CPassRecorder();
+public:
+	void Shutdown();
+
+	void AddPass(RecordFunction function);
+	// Record every pass added since the last call, then execute them in order. Nothing is executed if any pass failed.
+	bool Execute();
+	// Drop every pass added since the last call to Execute without recording them.
+	void Discard() { mPasses.clear(); };
+
+	const Statistics& GetStatistics() { return mStatistics; };
+private:
+	bool RecordPass(unsigned int pass);
+private:
+	CRenderDevice* mpRenderDevice;
+	CThreadPool* mpThreadPool;
+	std::vector<RecordFunction> mPasses;
+	// One for each pass, kept from frame to frame so contexts aren't created every frame.
+	std::vector<CRenderDevice*> mDeferredDevices;
+	std::vector<CRenderDevice::CommandList*> mCommandLists;
+	Statistics mStatistics;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define PRIO_ENGINE_VARS_H
 
 #include "Logger.h"
+#include "Hash.h"
 #include <windows.h>
 
 namespace PrioEngine
@@ -1,4 +1,5 @@
 #include "Rain.h"
+#include "StateCache.h"
 
 
 
@@ -130,21 +131,21 @@ void CRain::UpdateRender(ID3D11DeviceContext * deviceContext)
 	offset = 0;
 	
 	// Tell directx we've passed it a point list.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
 
 	if (mFirstRun)
 	{
 		// Set the vertex buffer to active in the input assembler.
-		deviceContext->IASetVertexBuffers(0, 1, &mpInitialBuffer, &stride, &offset);
+		CStateCache::Get(deviceContext)->IASetVertexBuffers(0, 1, &mpInitialBuffer, &stride, &offset);
 	}
 	else
 	{
 		// Set the vertex buffer to active in the input assembler.
-		deviceContext->IASetVertexBuffers(0, 1, &mpDrawBuffer, &stride, &offset);
+		CStateCache::Get(deviceContext)->IASetVertexBuffers(0, 1, &mpDrawBuffer, &stride, &offset);
 	}
 
 	// Set the stream buffer render target.
-	deviceContext->SOSetTargets(1, &mpStreamBuffer, &offset);
+	CStateCache::Get(deviceContext)->SOSetTargets(1, &mpStreamBuffer, &offset);
 }
 
 void CRain::Render(ID3D11DeviceContext * deviceContext)
@@ -158,13 +159,13 @@ void CRain::Render(ID3D11DeviceContext * deviceContext)
 
 	//Unbind the vertex buffer
 	ID3D11Buffer* buffer = 0;
-	deviceContext->SOSetTargets(1, &buffer, &offset);
+	CStateCache::Get(deviceContext)->SOSetTargets(1, &buffer, &offset);
 
 	std::swap(mpDrawBuffer, mpStreamBuffer);
 
 	// Tell directx we've passed it a point list.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
-	deviceContext->IASetVertexBuffers(0, 1, &mpDrawBuffer, &stride, &offset);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	CStateCache::Get(deviceContext)->IASetVertexBuffers(0, 1, &mpDrawBuffer, &stride, &offset);
 }
 
 void CRain::ShutdownBuffers()
@@ -1,4 +1,5 @@
 #include "RainShader.h"
+#include "StateCache.h"
 
 CRainShader::CRainShader()
 {
@@ -56,7 +57,7 @@ bool CRainShader::Render(ID3D11DeviceContext* deviceContext)
 	// Shader resources / textures
 	/////////////////////////////
 
-	deviceContext->PSSetShaderResources(0, 1, &mpRainTexture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpRainTexture);
 
 	// Now render the prepared buffers with the shader.
 	RenderShader(deviceContext);
@@ -75,7 +76,7 @@ bool CRainShader::UpdateRender(ID3D11DeviceContext * deviceContext)
 		return false;
 	}
 
-	deviceContext->GSSetShaderResources(0, 1, &mpRandomTexture);
+	CStateCache::Get(deviceContext)->GSSetShaderResources(0, 1, &mpRandomTexture);
 
 	// Now render the prepared buffers with the shader.
 	UpdateParticles(deviceContext);
@@ -106,7 +107,7 @@ bool CRainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "RainVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "RainVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -123,7 +124,7 @@ bool CRainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the geometry shader code.
-	result = D3DX11CompileFromFile(gsFilename.c_str(), NULL, NULL, "RainGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &geometryShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(gsFilename, "RainGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &geometryShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -140,7 +141,7 @@ bool CRainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "RainPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "RainPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -185,7 +186,7 @@ bool CRainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	/////////////////////////////////////////
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsUpdateFilename.c_str(), NULL, NULL, "RainUpdateVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &vertexShaderUpdateBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsUpdateFilename, "RainUpdateVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &vertexShaderUpdateBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -202,7 +203,7 @@ bool CRainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the geometry shader code.
-	result = D3DX11CompileFromFile(gsUpdateFilename.c_str(), NULL, NULL, "RainUpdateGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &geometryShaderUpdateBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(gsUpdateFilename, "RainUpdateGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &geometryShaderUpdateBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -531,8 +532,8 @@ bool CRainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext)
 	bufferNumber = 1;
 
 	// Now set the constant buffer in the vertex shader with the updated values.
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &mpFrameBuffer);
-	deviceContext->GSSetConstantBuffers(bufferNumber, 1, &mpFrameBuffer);
+	CStateCache::Get(deviceContext)->VSSetConstantBuffers(bufferNumber, 1, &mpFrameBuffer);
+	CStateCache::Get(deviceContext)->GSSetConstantBuffers(bufferNumber, 1, &mpFrameBuffer);
 
 	return true;
 }
@@ -540,19 +541,19 @@ bool CRainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext)
 void CRainShader::RenderShader(ID3D11DeviceContext * deviceContext)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
 
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->GSSetShader(mpGeometryShader, NULL, 0);
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->GSSetShader(mpGeometryShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
 
 	deviceContext->DrawAuto();
 
-	deviceContext->GSSetShader(NULL, NULL, 0);
+	CStateCache::Get(deviceContext)->GSSetShader(NULL, NULL, 0);
 
 	return;
 }
@@ -560,13 +561,13 @@ void CRainShader::RenderShader(ID3D11DeviceContext * deviceContext)
 bool CRainShader::UpdateParticles(ID3D11DeviceContext * deviceContext)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
 
-	deviceContext->VSSetShader(mpUpdateVertexShader, NULL, 0);
-	deviceContext->GSSetShader(mpUpdateGeometryShader, NULL, 0);
-	deviceContext->GSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetShader(NULL, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpUpdateVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->GSSetShader(mpUpdateGeometryShader, NULL, 0);
+	CStateCache::Get(deviceContext)->GSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetShader(NULL, NULL, 0);
 	
 	if (mFirstRun)
 	{
@@ -577,7 +578,7 @@ bool CRainShader::UpdateParticles(ID3D11DeviceContext * deviceContext)
 		deviceContext->DrawAuto();
 	}
 
-	deviceContext->GSSetShader(NULL, NULL, NULL);
+	CStateCache::Get(deviceContext)->GSSetShader(NULL, NULL, NULL);
 
 	return true;
 }
@@ -1,4 +1,5 @@
 #include "RefractReflectShader.h"
+#include "StateCache.h"
 
 
 
@@ -7,8 +8,10 @@ CReflectRefractShader::CReflectRefractShader()
 	mpVertexShader					= nullptr;
 	mpRefractionPixelShader			= nullptr;
 	mpModelLayout					= nullptr;
+	mpQuantisedModelVertexShader	= nullptr;
+	mpQuantisedModelLayout			= nullptr;
+	mVertexFormat					= FloatVertexFormat;
 	mpTrilinearWrap					= nullptr;
-	mpLightBuffer					= nullptr;
 	mpViewportBuffer				= nullptr;
 	mpReflectionPixelShader			= nullptr;
 	mpTerrainAreaBuffer				= nullptr;
@@ -51,6 +54,14 @@ bool CReflectRefractShader::Initialise(ID3D11Device * device, HWND hwnd)
 		return false;
 	}
 
+	result = InitialiseQuantisedModelShader(device, hwnd, TerrainVSName);
+
+	if (!result)
+	{
+		logger->GetInstance().WriteLine("Failed to initialise the quantised model refraction shader.");
+		return false;
+	}
+
 	std::string FoliageVSName = "Shaders/FoliageRefraction.vs.hlsl";
 	std::string FoliagePSName = "Shaders/FoliageRefraction.ps.hlsl";
 
@@ -231,7 +242,6 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	unsigned int numElements;
 	D3D11_SAMPLER_DESC samplerDesc;
 	D3D11_BUFFER_DESC viewportBufferDesc;
-	D3D11_BUFFER_DESC lightBufferDesc;
 	D3D11_BUFFER_DESC terrainAreaBufferDesc;
 	D3D11_BUFFER_DESC terrainPosBufferDesc;
 
@@ -242,7 +252,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "RefractionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "RefractionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -260,7 +270,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "TerrainRefractionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "TerrainRefractionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -298,7 +308,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	//////////////////////////////////
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(reflectionPSFilename.c_str(), NULL, NULL, "TerrainReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(reflectionPSFilename, "TerrainReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -327,7 +337,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	//////////////////////////////////
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(modelRefractionPSName.c_str(), NULL, NULL, "ModelRefractionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(modelRefractionPSName, "ModelRefractionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -356,7 +366,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	//////////////////////////////////
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(modelReflectionPSName.c_str(), NULL, NULL, "ModelReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(modelReflectionPSName, "ModelReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -506,25 +516,6 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 		return false;
 	}
 
-	//////////////////////////////////
-	// Set up light buffer
-	/////////////////////////////////
-	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&lightBufferDesc, NULL, &mpLightBuffer);
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create the light buffer from within the refraction shader class.");
-		return false;
-	}
-
 	//////////////////////////////////
 	// Set up terrain area buffer
 	/////////////////////////////////
@@ -589,6 +580,53 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	return true;
 }
 
+bool CReflectRefractShader::InitialiseQuantisedModelShader(ID3D11Device * device, HWND hwnd, std::string vsFilename)
+{
+	HRESULT result;
+	ID3D10Blob* errorMessage = nullptr;
+	ID3D10Blob* vertexShaderBuffer = nullptr;
+
+	// Compile the vertex shader code.
+	result = CompileShaderFromFile(vsFilename, "QuantisedRefractionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
+	if (FAILED(result))
+	{
+		if (errorMessage)
+		{
+			OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
+		}
+		else
+		{
+			std::string errMsg = "Missing shader file. ";
+			logger->GetInstance().WriteLine("Could not find a shader file with name '" + vsFilename + "'");
+			MessageBox(hwnd, vsFilename.c_str(), errMsg.c_str(), MB_OK);
+		}
+		logger->GetInstance().WriteLine("Failed to compile the quantised vertex shader named '" + vsFilename + "'");
+		return false;
+	}
+
+	// Create the vertex shader from the buffer.
+	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &mpQuantisedModelVertexShader);
+	if (FAILED(result))
+	{
+		logger->GetInstance().WriteLine("Failed to create the quantised vertex shader from the buffer.");
+		vertexShaderBuffer->Release();
+		return false;
+	}
+
+	// Create the vertex input layout.
+	result = device->CreateInputLayout(kQuantisedVertexLayout, kNumberOfQuantisedVertexElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &mpQuantisedModelLayout);
+	vertexShaderBuffer->Release();
+	vertexShaderBuffer = nullptr;
+
+	if (FAILED(result))
+	{
+		logger->GetInstance().WriteLine("Failed to create quantised polygon layout.");
+		return false;
+	}
+
+	return true;
+}
+
 bool CReflectRefractShader::InitialiseFoliageShader(ID3D11Device * device, HWND hwnd, std::string vsName, std::string psName)
 {
 	HRESULT result;
@@ -603,7 +641,7 @@ bool CReflectRefractShader::InitialiseFoliageShader(ID3D11Device * device, HWND
 	///////////////////////////////////
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsName.c_str(), NULL, NULL, "FoliageRefractionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsName, "FoliageRefractionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -621,7 +659,7 @@ bool CReflectRefractShader::InitialiseFoliageShader(ID3D11Device * device, HWND
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psName.c_str(), NULL, NULL, "FoliageRefractionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psName, "FoliageRefractionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -844,7 +882,7 @@ bool CReflectRefractShader::InitialiseCloudShader(ID3D11Device * device, HWND hw
 	//////////////////////////////////
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "CloudReflectionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "CloudReflectionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -862,7 +900,7 @@ bool CReflectRefractShader::InitialiseCloudShader(ID3D11Device * device, HWND hw
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "CloudReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "CloudReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -978,7 +1016,7 @@ bool CReflectRefractShader::InitialiseSkyboxShader(ID3D11Device * device, HWND h
 	//////////////////////////////////
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "SkyboxReflectionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "SkyboxReflectionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -996,7 +1034,7 @@ bool CReflectRefractShader::InitialiseSkyboxShader(ID3D11Device * device, HWND h
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "SkyboxReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "SkyboxReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -1162,12 +1200,6 @@ void CReflectRefractShader::ShutdownShader()
 		mpPositioningBuffer = nullptr;
 	}
 
-	if (mpLightBuffer)
-	{
-		mpLightBuffer->Release();
-		mpLightBuffer = nullptr;
-	}
-
 	if (mpViewportBuffer)
 	{
 		mpViewportBuffer->Release();
@@ -1180,6 +1212,18 @@ void CReflectRefractShader::ShutdownShader()
 		mpModelLayout = nullptr;
 	}
 
+	if (mpQuantisedModelLayout)
+	{
+		mpQuantisedModelLayout->Release();
+		mpQuantisedModelLayout = nullptr;
+	}
+
+	if (mpQuantisedModelVertexShader)
+	{
+		mpQuantisedModelVertexShader->Release();
+		mpQuantisedModelVertexShader = nullptr;
+	}
+
 	if (mpRefractionPixelShader)
 	{
 		mpRefractionPixelShader->Release();
@@ -1242,7 +1286,6 @@ bool CReflectRefractShader::SetShaderParameters(ID3D11DeviceContext* deviceConte
 	HRESULT result;
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
 	unsigned int bufferNumber;
-	LightBufferType* lightBufferPtr;
 	ViewportBufferType* viewportBufferPtr;
 
 	////////////////////////////
@@ -1283,39 +1326,7 @@ bool CReflectRefractShader::SetShaderParameters(ID3D11DeviceContext* deviceConte
 	bufferNumber = 0;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpViewportBuffer);
-
-	/////////////////////////////////
-	// Update the light constant buffer.
-	/////////////////////////////////
-	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to set the light constant buffer in refraction shader class.");
-		return false;
-	}
-
-	// Get pointer to the data inside the constant buffer.
-	lightBufferPtr = (LightBufferType*)mappedResource.pData;
-
-	// Copy the current light values into the constant buffer.
-	lightBufferPtr->AmbientColour = mAmbientColour;
-	lightBufferPtr->DiffuseColour = mDiffuseColour;
-	lightBufferPtr->LightDirection = mLightDirection;
-	lightBufferPtr->mLightPosition = mLightPosition;
-	lightBufferPtr->mSpecularColour = mSpecularColour;
-	lightBufferPtr->mSpecularPower = mSpecularPower;
-	lightBufferPtr->lightBufferPadding = 0.0f;
-
-	// Unlock the constnat buffer so we can write to it elsewhere.
-	deviceContext->Unmap(mpLightBuffer, 0);
-
-	// Update the position of our constant buffer in the shader.
-	bufferNumber = 1;
-
-	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpViewportBuffer);
 
 	/////////////////////////////////
 	// Update the terrain area constant buffer.
@@ -1344,7 +1355,7 @@ bool CReflectRefractShader::SetShaderParameters(ID3D11DeviceContext* deviceConte
 	bufferNumber = 2;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpTerrainAreaBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpTerrainAreaBuffer);
 
 
 	/////////////////////////////////
@@ -1372,16 +1383,16 @@ bool CReflectRefractShader::SetShaderParameters(ID3D11DeviceContext* deviceConte
 	bufferNumber = 3;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpPositioningBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpPositioningBuffer);
 
 	/////////////////////////////////
 	// Update shader resources
 	/////////////////////////////////
-	deviceContext->PSSetShaderResources(0, 1, &mpWaterHeightMap);
-	deviceContext->PSSetShaderResources(1, 2, mpDirtTexArray);
-	deviceContext->PSSetShaderResources(3, 2, mpGrassTextures);
-	deviceContext->PSSetShaderResources(5, 1, &mpPatchMap);
-	deviceContext->PSSetShaderResources(6, 2, mpRockTextures);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpWaterHeightMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(1, 2, mpDirtTexArray);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(3, 2, mpGrassTextures);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(5, 1, &mpPatchMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(6, 2, mpRockTextures);
 
 	return true;
 }
@@ -1422,39 +1433,7 @@ bool CReflectRefractShader::SetFoliageShaderParameters(ID3D11DeviceContext * dev
 	bufferNumber = 0;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpViewportBuffer);
-
-	/////////////////////////////////
-	// Update the light constant buffer.
-	/////////////////////////////////
-	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to set the light constant buffer in refraction shader class.");
-		return false;
-	}
-
-	// Get pointer to the data inside the constant buffer.
-	LightBufferType* lightBufferPtr = (LightBufferType*)mappedResource.pData;
-
-	// Copy the current light values into the constant buffer.
-	lightBufferPtr->AmbientColour = mAmbientColour;
-	lightBufferPtr->DiffuseColour = mDiffuseColour;
-	lightBufferPtr->LightDirection = mLightDirection;
-	lightBufferPtr->mLightPosition = mLightPosition;
-	lightBufferPtr->mSpecularColour = mSpecularColour;
-	lightBufferPtr->mSpecularPower = mSpecularPower;
-	lightBufferPtr->lightBufferPadding = 0.0f;
-
-	// Unlock the constnat buffer so we can write to it elsewhere.
-	deviceContext->Unmap(mpLightBuffer, 0);
-
-	// Update the position of our constant buffer in the shader.
-	bufferNumber = 1;
-
-	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpViewportBuffer);
 
 	/////////////////////////////////
 	// Update the foliage buffer
@@ -1483,15 +1462,15 @@ bool CReflectRefractShader::SetFoliageShaderParameters(ID3D11DeviceContext * dev
 	bufferNumber = 1;
 
 	// Set the constant buffer in the shader.
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &mpFoliageBuffer);
+	CStateCache::Get(deviceContext)->VSSetConstantBuffers(bufferNumber, 1, &mpFoliageBuffer);
 
 	/////////////////////////////////////
 	// Resources
 	////////////////////////////////////
 
-	deviceContext->PSSetShaderResources(0, 1, &mpWaterHeightMap);
-	deviceContext->PSSetShaderResources(1, 1, &mpGrassTexture);
-	deviceContext->PSSetShaderResources(2, 1, &mpGrassAlphaTexture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpWaterHeightMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(1, 1, &mpGrassTexture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(2, 1, &mpGrassAlphaTexture);
 
 	return true;
 }
@@ -1541,16 +1520,16 @@ bool CReflectRefractShader::SetCloudShaderParameters(ID3D11DeviceContext * devic
 	bufferNumber = 0;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpCloudBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpCloudBuffer);
 
 
 	////////////////////////////
 	// Shader resources
 	///////////////////////////
 
-	deviceContext->PSSetShaderResources(0, 1, &mpWaterHeightMap);
-	deviceContext->PSSetShaderResources(1, 1, &mpCloudTex1);
-	deviceContext->PSSetShaderResources(2, 1, &mpCloudTex2);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpWaterHeightMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(1, 1, &mpCloudTex1);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(2, 1, &mpCloudTex2);
 
 	return true;
 }
@@ -1600,14 +1579,14 @@ bool CReflectRefractShader::SetSkyboxShaderParameters(ID3D11DeviceContext * devi
 	bufferNumber = 0;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpSkyboxBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpSkyboxBuffer);
 
 
 	////////////////////////////
 	// Shader resources
 	///////////////////////////
 
-	deviceContext->PSSetShaderResources(0, 1, &mpWaterHeightMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpWaterHeightMap);
 
 	return true;
 }
@@ -1649,40 +1628,7 @@ bool CReflectRefractShader::SetModelRefractionShaderParameters(ID3D11DeviceConte
 	bufferNumber = 0;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpViewportBuffer);
-
-	/////////////////////////////////
-	// Update the light constant buffer.
-	/////////////////////////////////
-	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to set the light constant buffer in refraction shader class.");
-		return false;
-	}
-
-	// Get pointer to the data inside the constant buffer.
-	LightBufferType* lightBufferPtr = (LightBufferType*)mappedResource.pData;
-
-	// Copy the current light values into the constant buffer.
-	lightBufferPtr->AmbientColour = mAmbientColour;
-	lightBufferPtr->DiffuseColour = mDiffuseColour;
-	lightBufferPtr->LightDirection = mLightDirection;
-	lightBufferPtr->mLightPosition = mLightPosition;
-	lightBufferPtr->mSpecularColour = mSpecularColour;
-	lightBufferPtr->mSpecularPower = mSpecularPower;
-	lightBufferPtr->lightBufferPadding = 0.0f;
-
-	// Unlock the constnat buffer so we can write to it elsewhere.
-	deviceContext->Unmap(mpLightBuffer, 0);
-
-	// Update the position of our constant buffer in the shader.
-	bufferNumber = 1;
-
-	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
-
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpViewportBuffer);
 
 	//////////////////////////////
 	// Update the map constant buffer.
@@ -1711,13 +1657,13 @@ bool CReflectRefractShader::SetModelRefractionShaderParameters(ID3D11DeviceConte
 	bufferNumber = 2;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpMapBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpMapBuffer);
 
 	//////////////////////////////
 	// Resources
 	//////////////////////////////
-	deviceContext->PSSetShaderResources(0, 1, &mpWaterHeightMap);
-	deviceContext->PSSetShaderResources(1, mModelTextureCount, mpModelTextures);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpWaterHeightMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(1, mModelTextureCount, mpModelTextures);
 
 	return true;
 }
@@ -1759,39 +1705,7 @@ bool CReflectRefractShader::SetModelReflectionShaderParameters(ID3D11DeviceConte
 	bufferNumber = 0;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpViewportBuffer);
-
-	/////////////////////////////////
-	// Update the light constant buffer.
-	/////////////////////////////////
-	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to set the light constant buffer in refraction shader class.");
-		return false;
-	}
-
-	// Get pointer to the data inside the constant buffer.
-	LightBufferType* lightBufferPtr = (LightBufferType*)mappedResource.pData;
-
-	// Copy the current light values into the constant buffer.
-	lightBufferPtr->AmbientColour = mAmbientColour;
-	lightBufferPtr->DiffuseColour = mDiffuseColour;
-	lightBufferPtr->LightDirection = mLightDirection;
-	lightBufferPtr->mLightPosition = mLightPosition;
-	lightBufferPtr->mSpecularColour = mSpecularColour;
-	lightBufferPtr->mSpecularPower = mSpecularPower;
-	lightBufferPtr->lightBufferPadding = 0.0f;
-
-	// Unlock the constnat buffer so we can write to it elsewhere.
-	deviceContext->Unmap(mpLightBuffer, 0);
-
-	// Update the position of our constant buffer in the shader.
-	bufferNumber = 1;
-
-	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpViewportBuffer);
 
 	//////////////////////////////
 	// Update the positioning buffer
@@ -1819,7 +1733,7 @@ bool CReflectRefractShader::SetModelReflectionShaderParameters(ID3D11DeviceConte
 	bufferNumber = 2;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpPositioningBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpPositioningBuffer);
 
 	//////////////////////////////
 	// Update the map constant buffer.
@@ -1848,17 +1762,17 @@ bool CReflectRefractShader::SetModelReflectionShaderParameters(ID3D11DeviceConte
 	bufferNumber = 3;
 
 	// Set the constant buffer in the shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpMapBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpMapBuffer);
 
 	//////////////////////////////
 	// Resources
 	//////////////////////////////
 
-	deviceContext->PSSetShaderResources(0, 1, &mpWaterHeightMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpWaterHeightMap);
 	// Diffuse
-	deviceContext->PSSetShaderResources(1, 1, &mpModelTextures[0]);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(1, 1, &mpModelTextures[0]);
 	// Alpha
-	deviceContext->PSSetShaderResources(2, 1, &mpModelTextures[1]);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(2, 1, &mpModelTextures[1]);
 
 	return true;
 }
@@ -1866,15 +1780,15 @@ bool CReflectRefractShader::SetModelReflectionShaderParameters(ID3D11DeviceConte
 void CReflectRefractShader::RenderReflectionShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpModelLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpModelLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpReflectionPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpReflectionPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetSamplers(1, 1, &mpBilinearMirror);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(1, 1, &mpBilinearMirror);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -1885,16 +1799,16 @@ void CReflectRefractShader::RenderReflectionShader(ID3D11DeviceContext * deviceC
 void CReflectRefractShader::RenderFoliageRefractionShader(ID3D11DeviceContext * deviceContext, int vertexCount, int instanceCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpFoliageLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpFoliageLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpFoliageRefractionVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpFoliageRefractionPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpFoliageRefractionVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpFoliageRefractionPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetSamplers(1, 1, &mpBilinearMirror);
-	deviceContext->PSSetSamplers(2, 1, &mpPointClamp);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(1, 1, &mpBilinearMirror);
+	CStateCache::Get(deviceContext)->PSSetSamplers(2, 1, &mpPointClamp);
 
 	// Render the quad.
 	deviceContext->DrawInstanced(vertexCount, instanceCount, 0, 0);
@@ -1903,15 +1817,15 @@ void CReflectRefractShader::RenderFoliageRefractionShader(ID3D11DeviceContext *
 void CReflectRefractShader::RenderCloudReflectionShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpCloudLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpCloudLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpCloudVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpCloudPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpCloudVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpCloudPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetSamplers(1, 1, &mpBilinearMirror);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(1, 1, &mpBilinearMirror);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -1920,32 +1834,43 @@ void CReflectRefractShader::RenderCloudReflectionShader(ID3D11DeviceContext * de
 void CReflectRefractShader::RenderSkyboxReflectionShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpSkyboxLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpSkyboxLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpSkyboxVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpSkyboxPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpSkyboxVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpSkyboxPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetSamplers(1, 1, &mpBilinearMirror);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(1, 1, &mpBilinearMirror);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
 }
 
-void CReflectRefractShader::RenderModelRefractionShader(ID3D11DeviceContext * deviceContext, int indexCount)
+void CReflectRefractShader::SetVertexFormat(VertexFormat format)
 {
-	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpModelLayout);
+	mVertexFormat = format;
+}
 
-	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpModelRefractionPixelShader, NULL, 0);
+void CReflectRefractShader::RenderModelRefractionShader(ID3D11DeviceContext * deviceContext, int indexCount)
+{
+	// Set the vertex input layout and vertex shader to match the vertex buffer being drawn.
+	if (mVertexFormat == QuantisedVertexFormat)
+	{
+		CStateCache::Get(deviceContext)->IASetInputLayout(mpQuantisedModelLayout);
+		CStateCache::Get(deviceContext)->VSSetShader(mpQuantisedModelVertexShader, NULL, 0);
+	}
+	else
+	{
+		CStateCache::Get(deviceContext)->IASetInputLayout(mpModelLayout);
+		CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	}
+	CStateCache::Get(deviceContext)->PSSetShader(mpModelRefractionPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetSamplers(1, 1, &mpBilinearMirror);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(1, 1, &mpBilinearMirror);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -1953,16 +1878,22 @@ void CReflectRefractShader::RenderModelRefractionShader(ID3D11DeviceContext * de
 
 void CReflectRefractShader::RenderModelReflectionShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
-	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpModelLayout);
-
-	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpModelReflectionPixelShader, NULL, 0);
+	// Set the vertex input layout and vertex shader to match the vertex buffer being drawn.
+	if (mVertexFormat == QuantisedVertexFormat)
+	{
+		CStateCache::Get(deviceContext)->IASetInputLayout(mpQuantisedModelLayout);
+		CStateCache::Get(deviceContext)->VSSetShader(mpQuantisedModelVertexShader, NULL, 0);
+	}
+	else
+	{
+		CStateCache::Get(deviceContext)->IASetInputLayout(mpModelLayout);
+		CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	}
+	CStateCache::Get(deviceContext)->PSSetShader(mpModelReflectionPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetSamplers(1, 1, &mpBilinearMirror);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(1, 1, &mpBilinearMirror);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -1971,15 +1902,15 @@ void CReflectRefractShader::RenderModelReflectionShader(ID3D11DeviceContext * de
 void CReflectRefractShader::RenderRefractionShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpModelLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpModelLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpRefractionPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpRefractionPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetSamplers(1, 1, &mpBilinearMirror);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(1, 1, &mpBilinearMirror);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -1988,22 +1919,12 @@ void CReflectRefractShader::RenderRefractionShader(ID3D11DeviceContext * deviceC
 	ID3D11ShaderResourceView* nullResource = nullptr;
 	for (int i = 0; i < 7; i++)
 	{
-		deviceContext->PSSetShaderResources(i, 1, &nullResource);
+		CStateCache::Get(deviceContext)->PSSetShaderResources(i, 1, &nullResource);
 	}
 
 	return;
 }
 
-void CReflectRefractShader::SetLightProperties(CLight * light)
-{
-	mAmbientColour = light->GetAmbientColour();
-	mDiffuseColour = light->GetDiffuseColour();
-	mLightDirection = light->GetDirection();
-	mSpecularPower = light->GetSpecularPower();
-	mSpecularColour = light->GetSpecularColour();
-	mLightPosition = light->GetPos();
-}
-
 void CReflectRefractShader::SetViewportProperties(int screenWidth, int screenHeight)
 {
 	mViewportSize = D3DXVECTOR2(static_cast<float>(screenWidth), static_cast<float>(screenHeight));
@@ -2,7 +2,7 @@
 #define REFRACTIONSHADER_H
 
 #include "Shader.h"
-#include "Light.h"
+#include "VertexFormat.h"
 class CReflectRefractShader :
 	public CShader
 {
@@ -14,17 +14,6 @@ private:
 		D3DXVECTOR2 viewportPadding2;
 	};
 
-	struct LightBufferType
-	{
-		D3DXVECTOR4	AmbientColour;
-		D3DXVECTOR4	DiffuseColour;
-		D3DXVECTOR3	LightDirection;
-		D3DXVECTOR4 mSpecularColour;
-		D3DXVECTOR3 mLightPosition;
-		float mSpecularPower;
-		float lightBufferPadding;
-	};
-
 	struct TerrainAreaBufferType
 	{
 		float snowHeight;
@@ -86,16 +75,12 @@ public:
 	bool RenderModelRefraction(ID3D11DeviceContext * deviceContext, int indexCount);
 	bool RenderModelReflection(ID3D11DeviceContext * deviceContext, int indexCount);
 	bool RenderSkyboxReflection(ID3D11DeviceContext * deviceContext, int indexCount);
+	// Choose which input layout and vertex shader the model refraction and reflection renders use.
+	void SetVertexFormat(VertexFormat format);
 private:
 	D3DXMATRIX mWorldMatrix; 
 	D3DXMATRIX mViewMatrix;
 	D3DXMATRIX mProjMatrix; 
-	D3DXVECTOR4 mAmbientColour;
-	D3DXVECTOR4 mDiffuseColour;
-	D3DXVECTOR3 mLightDirection;
-	float mSpecularPower;
-	D3DXVECTOR4 mSpecularColour;
-	D3DXVECTOR3 mLightPosition;
 	D3DXVECTOR2 mViewportSize; 
 	float mSnowHeight; 
 	float mGrassHeight; 
@@ -134,7 +119,6 @@ private:
 	D3DXVECTOR4 mCentreColour;
 
 public:
-	void SetLightProperties(CLight* light);
 	void SetViewportProperties(int screenWidth, int screenHeight);
 	void SetTerrainAreaProperties(float snowHeight, float grassHeight, float dirtHeight, float sandHeight);
 	void SetPositioningProperties(float terrainPositionY, float waterPlanePositionY);
@@ -154,6 +138,7 @@ public:
 	void SetSkyboxColours(D3DXVECTOR4 apexColour, D3DXVECTOR4 centreColour);
 private:
 	bool InitialiseShader(ID3D11Device * device, HWND hwnd, std::string vsFilename, std::string psFilename, std::string reflectionPSFilename, std::string modelRefractionPSName, std::string modelReflectionPSName);
+	bool InitialiseQuantisedModelShader(ID3D11Device * device, HWND hwnd, std::string vsFilename);
 	bool InitialiseFoliageShader(ID3D11Device * device, HWND hwnd, std::string foliageRefractionVSName, std::string foliageRefractionPSName);
 	bool InitialiseCloudShader(ID3D11Device * device, HWND hwnd, std::string vsFilename, std::string psFilename);
 	bool InitialiseSkyboxShader(ID3D11Device * device, HWND hwnd, std::string vsFilename, std::string psFilename);
@@ -192,13 +177,15 @@ private:
 	ID3D11PixelShader* mpSkyboxPixelShader;
 
 	ID3D11InputLayout* mpModelLayout;
+	ID3D11VertexShader* mpQuantisedModelVertexShader;
+	ID3D11InputLayout* mpQuantisedModelLayout;
+	VertexFormat mVertexFormat;
 	ID3D11InputLayout* mpSkyboxLayout;
 	ID3D11InputLayout* mpCloudLayout;
 	ID3D11InputLayout* mpFoliageLayout;
 	ID3D11SamplerState* mpTrilinearWrap;
 	ID3D11SamplerState* mpPointClamp;
 	ID3D11SamplerState* mpBilinearMirror;
-	ID3D11Buffer* mpLightBuffer;
 	ID3D11Buffer* mpViewportBuffer;
 	ID3D11Buffer* mpTerrainAreaBuffer;
 	ID3D11Buffer* mpPositioningBuffer;
@@ -0,0 +1,84 @@
+#include "RenderDevice.h"
+#include <cstring>
+
+CRenderDevice::CRenderDevice()
+{
+	memset(&mStatistics, 0, sizeof(Statistics));
+	mResourceMemory = 0;
+}
+
+
+CRenderDevice::~CRenderDevice()
+{
+}
+
+void CRenderDevice::BeginFrame()
+{
+	memset(&mStatistics, 0, sizeof(Statistics));
+}
+
+void CRenderDevice::AddStatistics(const Statistics& statistics)
+{
+	mStatistics.draws += statistics.draws;
+	mStatistics.primitives += statistics.primitives;
+	mStatistics.pipelineChanges += statistics.pipelineChanges;
+	mStatistics.bufferBindings += statistics.bufferBindings;
+	mStatistics.textureBindings += statistics.textureBindings;
+	mStatistics.fixedStateChanges += statistics.fixedStateChanges;
+	mStatistics.maps += statistics.maps;
+	mStatistics.uploadBytes += statistics.uploadBytes;
+}
+
+unsigned int CRenderDevice::GetVertexElementSize(VertexElementFormat format)
+{
+	switch (format)
+	{
+	case Float2:
+		return 8;
+	case Float3:
+		return 12;
+	case Float4:
+		return 16;
+	case Half2:
+	case Short2Norm:
+		return 4;
+	case Short4Norm:
+		return 8;
+	}
+
+	return 0;
+}
+
+void CRenderDevice::GetMipLayout(TextureFormat format, unsigned int width, unsigned int height, unsigned int& rowPitch, unsigned int& numberOfRows)
+{
+	if (format == RGBA8Format)
+	{
+		rowPitch = width * 4;
+		numberOfRows = height;
+		return;
+	}
+
+	const unsigned int bytesPerBlock = format == BC1Format ? 8 : 16;
+	rowPitch = ((width + 3) / 4) * bytesPerBlock;
+	numberOfRows = (height + 3) / 4;
+}
+
+size_t CRenderDevice::CalculateTextureSize(const TextureDesc& desc)
+{
+	size_t size = 0;
+	unsigned int width = desc.width;
+	unsigned int height = desc.height;
+
+	for (unsigned int level = 0; level < desc.mipLevels; level++)
+	{
+		unsigned int rowPitch;
+		unsigned int numberOfRows;
+		GetMipLayout(desc.format, width, height, rowPitch, numberOfRows);
+		size += static_cast<size_t>(rowPitch) * numberOfRows;
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return size;
+}
@@ -0,0 +1,223 @@
+#ifndef RENDERDEVICE_H
+#define RENDERDEVICE_H
+
+#include <cstddef>
+#include <atomic>
+#include "Logger.h"
+
+/* A thin layer between the renderer and the graphics API, covering buffers, textures, pipeline state, mapping and draws.
+* Nothing here depends on Direct3D, so code written against it can be driven by the null device on a machine without a
+* GPU to measure what a frame costs on the CPU. Resources may be created from any thread, commands must all come from
+* the thread which owns the device, or be recorded on a deferred device and executed from there later.
+* Classes not yet moved over still talk to Direct3D themselves. */
+class CRenderDevice
+{
+protected:
+	CLogger* logger;
+public:
+	// Opaque handles, each backend decides what they point at.
+	struct Buffer;
+	struct Texture;
+	struct PipelineState;
+	struct CommandList;
+
+	enum BufferType
+	{
+		VertexBuffer,
+		IndexBuffer,
+		ConstantBuffer
+	};
+
+	enum BufferUsage
+	{
+		// Filled once on creation and never changed.
+		ImmutableUsage,
+		// Rewritten from the CPU by mapping, every map discards the previous contents.
+		DynamicUsage
+	};
+
+	enum ShaderStage
+	{
+		VertexStage,
+		GeometryStage,
+		PixelStage
+	};
+
+	enum IndexFormat
+	{
+		Index16,
+		Index32
+	};
+
+	enum Topology
+	{
+		TriangleList,
+		PointList
+	};
+
+	enum VertexElementFormat
+	{
+		Float2,
+		Float3,
+		Float4,
+		Half2,
+		Short2Norm,
+		Short4Norm
+	};
+
+	enum SamplerMode
+	{
+		NoSampler,
+		LinearWrapSampler,
+		LinearClampSampler
+	};
+
+	// Fixed state for drawing which isn't done through pipeline states yet, limited to the states CD3D11 already has.
+	enum CullMode
+	{
+		CullBack,
+		CullNone
+	};
+
+	enum BlendMode
+	{
+		NoBlend,
+		AlphaBlend,
+		AdditiveBlend
+	};
+
+	enum DepthMode
+	{
+		DepthTestAndWrite,
+		NoDepth
+	};
+
+	enum TextureFormat
+	{
+		RGBA8Format,
+		BC1Format,
+		BC3Format,
+		BC5Format
+	};
+
+	struct BufferDesc
+	{
+		BufferType type;
+		BufferUsage usage;
+		unsigned int size;
+	};
+
+	struct TextureDesc
+	{
+		unsigned int width;
+		unsigned int height;
+		unsigned int mipLevels;
+		TextureFormat format;
+	};
+
+	struct VertexElement
+	{
+		const char* semanticName;
+		unsigned int semanticIndex;
+		VertexElementFormat format;
+		unsigned int offset;
+	};
+
+	/* Compiled shader bytecode along with the fixed state which goes with it. Blend, depth and rasteriser state are set
+	* apart from it by mode, using the states CD3D11 owns so toggles like wireframe keep working. The sampler is bound to
+	* slot 0 of the pixel shader. */
+	struct PipelineStateDesc
+	{
+		const void* vertexShader;
+		size_t vertexShaderSize;
+		const void* geometryShader;
+		size_t geometryShaderSize;
+		const void* pixelShader;
+		size_t pixelShaderSize;
+		const VertexElement* vertexElements;
+		unsigned int numberOfVertexElements;
+		Topology topology;
+		SamplerMode sampler;
+	};
+
+	// Counted since the last call to BeginFrame.
+	struct Statistics
+	{
+		unsigned int draws;
+		unsigned long long primitives;
+		unsigned int pipelineChanges;
+		unsigned int bufferBindings;
+		unsigned int textureBindings;
+		unsigned int fixedStateChanges;
+		unsigned int maps;
+		unsigned long long uploadBytes;
+	};
+public:
+	CRenderDevice();
+	virtual ~CRenderDevice();
+public:
+	// Returns nullptr on failure. Immutable buffers need their initial data, dynamic ones are filled by mapping.
+	virtual Buffer* CreateBuffer(const BufferDesc& desc, const void* initialData) = 0;
+	virtual void DestroyBuffer(Buffer* buffer) = 0;
+	// The data holds every mip level one after another, each tightly packed.
+	virtual Texture* CreateTexture(const TextureDesc& desc, const void* data) = 0;
+	virtual void DestroyTexture(Texture* texture) = 0;
+	virtual PipelineState* CreatePipelineState(const PipelineStateDesc& desc) = 0;
+	virtual void DestroyPipelineState(PipelineState* pipelineState) = 0;
+
+	// Returns memory for the whole of a dynamic buffer, which must be written in full before calling Unmap.
+	virtual void* Map(Buffer* buffer) = 0;
+	virtual void Unmap(Buffer* buffer) = 0;
+	// Returns memory for part of a dynamic vertex or index buffer, leaving the rest as it was. The caller has to be sure
+	// the GPU is done with that part. Constant buffers can't be written like this before Direct3D 11.1.
+	virtual void* MapNoOverwrite(Buffer* buffer, unsigned int offset, unsigned int size) = 0;
+
+	// Marks the point reached in the commands issued so far. Fences complete in the order they were inserted.
+	virtual unsigned long long InsertFence() = 0;
+	virtual bool IsFenceComplete(unsigned long long fence) = 0;
+
+	virtual void SetPipelineState(PipelineState* pipelineState) = 0;
+	virtual void SetVertexBuffer(Buffer* buffer, unsigned int stride, unsigned int offset) = 0;
+	virtual void SetIndexBuffer(Buffer* buffer, IndexFormat format, unsigned int offset) = 0;
+	virtual void SetConstantBuffer(ShaderStage stage, unsigned int slot, Buffer* buffer) = 0;
+	virtual void SetTextures(ShaderStage stage, unsigned int firstSlot, unsigned int count, Texture* const* textures) = 0;
+	virtual void SetCullMode(CullMode mode) = 0;
+	virtual void SetBlendMode(BlendMode mode) = 0;
+	virtual void SetDepthMode(DepthMode mode) = 0;
+
+	virtual void Draw(unsigned int vertexCount, unsigned int firstVertex) = 0;
+	virtual void DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex) = 0;
+
+	// A device sharing this one's resources which records the commands given to it rather than issuing them, so a pass
+	// can be built on another thread. Returns nullptr on failure, the caller deletes it once done with it.
+	virtual CRenderDevice* CreateDeferredDevice() = 0;
+	// Called on a deferred device, from the thread which owns the device it came from, before recording each list.
+	// The render targets, fixed state and constant buffers bound there are carried into the list.
+	virtual void BeginCommandList() = 0;
+	// Called on a deferred device, from the thread recording, once the last command has been given. Returns nullptr
+	// on failure. The deferred device is left with nothing bound, ready for BeginCommandList again.
+	virtual CommandList* FinishCommandList() = 0;
+	// Run a recorded list on this device and free it. What was bound before is bound again afterwards.
+	virtual void ExecuteCommandList(CommandList* commandList) = 0;
+	// Free a recorded list without running it.
+	virtual void DiscardCommandList(CommandList* commandList) = 0;
+
+	// Resets the per frame statistics.
+	void BeginFrame();
+	const Statistics& GetStatistics() { return mStatistics; };
+	// Bytes held by buffers and textures created through this device which haven't been destroyed.
+	unsigned long long GetResourceMemory() { return mResourceMemory; };
+
+	static unsigned int GetVertexElementSize(VertexElementFormat format);
+	// Bytes per row, and the number of rows, of one mip level. Compressed formats are stored as rows of 4x4 blocks.
+	static void GetMipLayout(TextureFormat format, unsigned int width, unsigned int height, unsigned int& rowPitch, unsigned int& numberOfRows);
+	static size_t CalculateTextureSize(const TextureDesc& desc);
+protected:
+	// For backends which count a command list as it's recorded rather than as it's executed.
+	void AddStatistics(const Statistics& statistics);
+protected:
+	Statistics mStatistics;
+	std::atomic<unsigned long long> mResourceMemory;
+};
+
+#endif
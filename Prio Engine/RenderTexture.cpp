@@ -1,9 +1,17 @@
 #include "RenderTexture.h"
+#include "StateCache.h"
 
 
 
 CRenderTexture::CRenderTexture()
 {
+	mpRenderTargetTexture = nullptr;
+	mpRenderTargetView = nullptr;
+	mpShaderResourceView = nullptr;
+	mpDepthStencilTexture = nullptr;
+	mpDepthStencilView = nullptr;
+	mWidth = 0;
+	mHeight = 0;
 }
 
 
@@ -11,10 +19,20 @@ CRenderTexture::~CRenderTexture()
 {
 }
 
-bool CRenderTexture::Initialise(ID3D11Device * device, int width, int height, DXGI_FORMAT format)
+bool CRenderTexture::Initialise(ID3D11Device * device, int width, int height, DXGI_FORMAT format, bool depthBuffer)
 {
 	HRESULT result;
 
+	mWidth = width;
+	mHeight = height;
+
+	mViewport.Width = static_cast<float>(width);
+	mViewport.Height = static_cast<float>(height);
+	mViewport.MinDepth = 0.0f;
+	mViewport.MaxDepth = 1.0f;
+	mViewport.TopLeftX = 0.0f;
+	mViewport.TopLeftY = 0.0f;
+
 	D3D11_TEXTURE2D_DESC textureDesc = { 0 };
 	textureDesc.Width = width;
 	textureDesc.Height = height;
@@ -48,6 +66,36 @@ bool CRenderTexture::Initialise(ID3D11Device * device, int width, int height, DX
 		logger->GetInstance().WriteLine("Failed to create the shader resource view from the desc provided in render texture class.");
 		return false;
 	}
+
+	if (depthBuffer)
+	{
+		D3D11_TEXTURE2D_DESC depthBufferDesc = { 0 };
+		depthBufferDesc.Width = width;
+		depthBufferDesc.Height = height;
+		depthBufferDesc.MipLevels = 1;
+		depthBufferDesc.ArraySize = 1;
+		depthBufferDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		depthBufferDesc.SampleDesc.Count = 1;
+		depthBufferDesc.SampleDesc.Quality = 0;
+		depthBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+		depthBufferDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+		depthBufferDesc.CPUAccessFlags = 0;
+		depthBufferDesc.MiscFlags = 0;
+
+		result = device->CreateTexture2D(&depthBufferDesc, NULL, &mpDepthStencilTexture);
+		if (FAILED(result))
+		{
+			logger->GetInstance().WriteLine("Failed to create the depth buffer for a render texture.");
+			return false;
+		}
+
+		result = device->CreateDepthStencilView(mpDepthStencilTexture, NULL, &mpDepthStencilView);
+		if (FAILED(result))
+		{
+			logger->GetInstance().WriteLine("Failed to create the depth stencil view for a render texture.");
+			return false;
+		}
+	}
 	
 	logger->GetInstance().WriteLine("Successfully initialised render texture.");
 
@@ -56,6 +104,18 @@ bool CRenderTexture::Initialise(ID3D11Device * device, int width, int height, DX
 
 void CRenderTexture::Shutdown()
 {
+	if (mpDepthStencilView)
+	{
+		mpDepthStencilView->Release();
+		mpDepthStencilView = nullptr;
+	}
+
+	if (mpDepthStencilTexture)
+	{
+		mpDepthStencilTexture->Release();
+		mpDepthStencilTexture = nullptr;
+	}
+
 	if (mpShaderResourceView)
 	{
 		mpShaderResourceView->Release();
@@ -71,13 +131,14 @@ void CRenderTexture::Shutdown()
 	if (mpRenderTargetTexture)
 	{
 		mpRenderTargetTexture->Release();
-		mpRenderTargetView = nullptr;
+		mpRenderTargetTexture = nullptr;
 	}
 }
 
 void CRenderTexture::SetRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView)
 {
-	deviceContext->OMSetRenderTargets(1, &mpRenderTargetView, depthStencilView);
+	CStateCache::Get(deviceContext)->OMSetRenderTargets(1, &mpRenderTargetView, depthStencilView);
+	deviceContext->RSSetViewports(1, &mViewport);
 }
 
 void CRenderTexture::ClearRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView, float red, float green, float blue, float alpha)
@@ -12,15 +12,26 @@ public:
 	CRenderTexture();
 	~CRenderTexture();
 public:
-	bool Initialise(ID3D11Device * device, int width, int height, DXGI_FORMAT format);
+	// A target smaller than the screen can't share its depth buffer, so can be given one of its own.
+	bool Initialise(ID3D11Device * device, int width, int height, DXGI_FORMAT format, bool depthBuffer = false);
 	void Shutdown();
+	// Also sets the viewport to cover the whole texture.
 	void SetRenderTarget(ID3D11DeviceContext* deviceContext, ID3D11DepthStencilView* depthStencilView);
 	void ClearRenderTarget(ID3D11DeviceContext* deviceContext, ID3D11DepthStencilView* depthStencilView, float red, float green, float blue, float alpha);
 	ID3D11ShaderResourceView* &GetShaderResourceView();
+	// Null unless the texture was given a depth buffer of its own.
+	ID3D11DepthStencilView* GetDepthStencilView() { return mpDepthStencilView; };
+	int GetWidth() { return mWidth; };
+	int GetHeight() { return mHeight; };
 private:
 	ID3D11Texture2D* mpRenderTargetTexture;
 	ID3D11RenderTargetView* mpRenderTargetView;
 	ID3D11ShaderResourceView* mpShaderResourceView;
+	ID3D11Texture2D* mpDepthStencilTexture;
+	ID3D11DepthStencilView* mpDepthStencilView;
+	D3D11_VIEWPORT mViewport;
+	int mWidth;
+	int mHeight;
 };
 
 #endif
\ No newline at end of file
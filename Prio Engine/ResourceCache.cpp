@@ -0,0 +1,330 @@
+#include "ResourceCache.h"
+#include "Texture.h"
+#include "TextureCooker.h"
+#include <cctype>
+
+CResourceCache::CResourceCache(size_t memoryBudget)
+{
+	mMemoryBudget = memoryBudget;
+
+	mStatistics.hits = 0;
+	mStatistics.contentHits = 0;
+	mStatistics.misses = 0;
+	mStatistics.evictions = 0;
+	mStatistics.numberOfTextures = 0;
+	mStatistics.residentBytes = 0;
+}
+
+
+CResourceCache::~CResourceCache()
+{
+	LogStatistics();
+
+	for (auto& entry : mEntries)
+	{
+		if (entry.referenceCount > 0)
+		{
+			logger->GetInstance().WriteLine("The texture '" + entry.filenames.front() + "' was still in use when the resource cache was destroyed.");
+		}
+
+		entry.texture->Release();
+	}
+
+	mEntries.clear();
+	mFilenames.clear();
+	mContentHashes.clear();
+	mTextures.clear();
+}
+
+/* Find a texture in the cache, reading it from disk if it isn't there.
+* @Returns ID3D11ShaderResourceView* The texture, nullptr if it couldn't be loaded. */
+ID3D11ShaderResourceView* CResourceCache::LoadTexture(ID3D11Device* device, const std::string& filename)
+{
+	ID3D11ShaderResourceView* texture = AcquireTexture(filename);
+	if (texture != nullptr)
+	{
+		return texture;
+	}
+
+	CImage image;
+	if (!CTextureCooker::OpenImage(image, filename))
+	{
+		logger->GetInstance().WriteLine("Failed to open the texture '" + filename + "'.");
+		return nullptr;
+	}
+
+	const unsigned long long contentHash = PrioEngine::Hash::FNV1a(image.GetFileData(), image.GetFileSize());
+	texture = AcquireTexture(filename, contentHash);
+	if (texture != nullptr)
+	{
+		return texture;
+	}
+
+	image.Decode();
+
+	if (!CTexture::CreateFromImage(device, image, &texture))
+	{
+		logger->GetInstance().WriteLine("Failed to create the texture '" + filename + "' from the data read in.");
+		return nullptr;
+	}
+
+	return AddTexture(filename, contentHash, texture);
+}
+
+ID3D11ShaderResourceView* CResourceCache::AcquireTexture(const std::string& filename)
+{
+	auto found = mFilenames.find(NormaliseFilename(filename));
+	if (found == mFilenames.end())
+	{
+		return nullptr;
+	}
+
+	mStatistics.hits++;
+	found->second->referenceCount++;
+	Touch(found->second);
+
+	return found->second->texture;
+}
+
+/* Look for a texture with the same contents as one read in under another name. If one is found, the filename is
+* remembered so it's found by name next time.
+* @Returns ID3D11ShaderResourceView* The texture, nullptr if there isn't one. */
+ID3D11ShaderResourceView* CResourceCache::AcquireTexture(const std::string& filename, unsigned long long contentHash)
+{
+	auto found = mContentHashes.find(contentHash);
+	if (found == mContentHashes.end())
+	{
+		return nullptr;
+	}
+
+	EntryIterator entry = found->second;
+	const std::string normalisedFilename = NormaliseFilename(filename);
+	if (mFilenames.find(normalisedFilename) == mFilenames.end())
+	{
+		entry->filenames.push_back(normalisedFilename);
+		mFilenames[normalisedFilename] = entry;
+	}
+
+	mStatistics.contentHits++;
+	entry->referenceCount++;
+	Touch(entry);
+
+	return entry->texture;
+}
+
+/* Takes over the reference to a texture the caller has just created. If the same contents were added in the meantime,
+* the new texture is released and the existing one shared instead.
+* @Returns ID3D11ShaderResourceView* The texture to use, with a reference held for the caller. */
+ID3D11ShaderResourceView* CResourceCache::AddTexture(const std::string& filename, unsigned long long contentHash, ID3D11ShaderResourceView* texture)
+{
+	ID3D11ShaderResourceView* existing = AcquireTexture(filename, contentHash);
+	if (existing != nullptr)
+	{
+		texture->Release();
+		return existing;
+	}
+
+	Entry entry;
+	entry.texture = texture;
+	entry.contentHash = contentHash;
+	entry.filenames.push_back(NormaliseFilename(filename));
+	entry.sizeInBytes = CalculateTextureSize(texture);
+	entry.referenceCount = 1;
+
+	mEntries.push_front(entry);
+	EntryIterator added = mEntries.begin();
+
+	// A different file under the same name replaces the old one for anyone asking by name from now on.
+	mFilenames[added->filenames.front()] = added;
+	mContentHashes[contentHash] = added;
+	mTextures[texture] = added;
+
+	mStatistics.misses++;
+	mStatistics.numberOfTextures++;
+	mStatistics.residentBytes += added->sizeInBytes;
+
+	Trim();
+
+	return texture;
+}
+
+void CResourceCache::ReleaseTexture(ID3D11ShaderResourceView* texture)
+{
+	if (texture == nullptr)
+	{
+		return;
+	}
+
+	auto found = mTextures.find(texture);
+	if (found == mTextures.end())
+	{
+		// Not one of ours, so whoever has it owns it outright.
+		texture->Release();
+		return;
+	}
+
+	EntryIterator entry = found->second;
+	if (entry->referenceCount == 0)
+	{
+		logger->GetInstance().WriteLine("The texture '" + entry->filenames.front() + "' was released more times than it was acquired.");
+		return;
+	}
+
+	entry->referenceCount--;
+
+	if (entry->referenceCount == 0)
+	{
+		Trim();
+	}
+}
+
+void CResourceCache::SetMemoryBudget(size_t memoryBudget)
+{
+	mMemoryBudget = memoryBudget;
+	Trim();
+}
+
+void CResourceCache::LogStatistics()
+{
+	logger->GetInstance().WriteLine("Resource cache: " + std::to_string(mStatistics.numberOfTextures) + " textures using " +
+		std::to_string(mStatistics.residentBytes / 1024) + "KB, " + std::to_string(mStatistics.hits) + " hits, " +
+		std::to_string(mStatistics.contentHits) + " content hits, " + std::to_string(mStatistics.misses) + " misses, " +
+		std::to_string(mStatistics.evictions) + " evictions.");
+}
+
+void CResourceCache::Touch(EntryIterator entry)
+{
+	mEntries.splice(mEntries.begin(), mEntries, entry);
+}
+
+void CResourceCache::Evict(EntryIterator entry)
+{
+	for (auto& filename : entry->filenames)
+	{
+		// The name may have been taken over by a newer texture since.
+		auto found = mFilenames.find(filename);
+		if (found != mFilenames.end() && found->second == entry)
+		{
+			mFilenames.erase(found);
+		}
+	}
+
+	auto found = mContentHashes.find(entry->contentHash);
+	if (found != mContentHashes.end() && found->second == entry)
+	{
+		mContentHashes.erase(found);
+	}
+
+	mTextures.erase(entry->texture);
+	entry->texture->Release();
+
+	mStatistics.evictions++;
+	mStatistics.numberOfTextures--;
+	mStatistics.residentBytes -= entry->sizeInBytes;
+
+	mEntries.erase(entry);
+}
+
+/* Release the least recently used textures which nothing is holding until the cache is back under budget. Textures
+* still in use are never released, so the budget can be exceeded if enough of them are. */
+void CResourceCache::Trim()
+{
+	auto entry = mEntries.end();
+	while (mStatistics.residentBytes > mMemoryBudget && entry != mEntries.begin())
+	{
+		--entry;
+
+		if (entry->referenceCount == 0)
+		{
+			EntryIterator evicted = entry;
+			++entry;
+			Evict(evicted);
+		}
+	}
+}
+
+/* Works out how much video memory a texture takes up, including its mip chain.
+* @Returns size_t The size in bytes, 0 if it isn't a 2D texture. */
+size_t CResourceCache::CalculateTextureSize(ID3D11ShaderResourceView* texture)
+{
+	ID3D11Resource* resource = nullptr;
+	texture->GetResource(&resource);
+
+	ID3D11Texture2D* texture2D = nullptr;
+	HRESULT result = resource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&texture2D));
+	resource->Release();
+
+	if (FAILED(result))
+	{
+		return 0;
+	}
+
+	D3D11_TEXTURE2D_DESC desc;
+	texture2D->GetDesc(&desc);
+	texture2D->Release();
+
+	bool blockCompressed = true;
+	size_t bytesPerBlock = 16;
+	switch (desc.Format)
+	{
+	case DXGI_FORMAT_BC1_TYPELESS:
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+	case DXGI_FORMAT_BC4_TYPELESS:
+	case DXGI_FORMAT_BC4_UNORM:
+	case DXGI_FORMAT_BC4_SNORM:
+		bytesPerBlock = 8;
+		break;
+	case DXGI_FORMAT_BC2_TYPELESS:
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_TYPELESS:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC5_TYPELESS:
+	case DXGI_FORMAT_BC5_UNORM:
+	case DXGI_FORMAT_BC5_SNORM:
+	case DXGI_FORMAT_BC6H_TYPELESS:
+	case DXGI_FORMAT_BC6H_UF16:
+	case DXGI_FORMAT_BC6H_SF16:
+	case DXGI_FORMAT_BC7_TYPELESS:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		break;
+	default:
+		blockCompressed = false;
+		break;
+	}
+
+	// Anything which isn't block compressed is treated as 32 bits a texel, true of everything the engine loads.
+	size_t size = 0;
+	unsigned int width = desc.Width;
+	unsigned int height = desc.Height;
+	for (unsigned int mip = 0; mip < desc.MipLevels; mip++)
+	{
+		if (blockCompressed)
+		{
+			size += ((width + 3) / 4) * ((height + 3) / 4) * bytesPerBlock;
+		}
+		else
+		{
+			size += width * height * 4;
+		}
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return size * desc.ArraySize;
+}
+
+/* Paths on Windows aren't case sensitive and may use either slash, so put them in one form before comparing them. */
+std::string CResourceCache::NormaliseFilename(const std::string& filename)
+{
+	std::string normalised = filename;
+	for (auto& character : normalised)
+	{
+		character = character == '\\' ? '/' : static_cast<char>(tolower(static_cast<unsigned char>(character)));
+	}
+	return normalised;
+}
@@ -0,0 +1,79 @@
+#ifndef RESOURCECACHE_H
+#define RESOURCECACHE_H
+
+#include <d3d11.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include "PrioEngineVars.h"
+
+/* Shares textures between everything which uses them. A texture is looked up by the path it was loaded from, then by a
+* hash of the file's contents, so the same image under two names is still only created once. Each texture is reference
+* counted, and once nothing holds it any more it stays in the cache so it can be picked straight back up, until the
+* memory budget is exceeded and the least recently used unreferenced textures are released.
+* Only to be used from the main thread. */
+class CResourceCache
+{
+private:
+	CLogger* logger;
+public:
+	struct Statistics
+	{
+		// Found by the path it was asked for with.
+		unsigned int hits;
+		// Read from disk, but the contents matched a texture which was already in the cache.
+		unsigned int contentHits;
+		unsigned int misses;
+		unsigned int evictions;
+		unsigned int numberOfTextures;
+		size_t residentBytes;
+	};
+
+	static const size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+public:
+	CResourceCache(size_t memoryBudget = kDefaultMemoryBudget);
+	~CResourceCache();
+public:
+	// Find a texture or load it from disk if it isn't cached, the result must be handed back with ReleaseTexture.
+	ID3D11ShaderResourceView* LoadTexture(ID3D11Device* device, const std::string& filename);
+	// Find a texture which is already cached, nullptr if it isn't.
+	ID3D11ShaderResourceView* AcquireTexture(const std::string& filename);
+	ID3D11ShaderResourceView* AcquireTexture(const std::string& filename, unsigned long long contentHash);
+	// Hand a newly created texture over to the cache, which takes the caller's reference to it.
+	ID3D11ShaderResourceView* AddTexture(const std::string& filename, unsigned long long contentHash, ID3D11ShaderResourceView* texture);
+	void ReleaseTexture(ID3D11ShaderResourceView* texture);
+
+	void SetMemoryBudget(size_t memoryBudget);
+	const Statistics& GetStatistics() { return mStatistics; };
+	void LogStatistics();
+private:
+	struct Entry
+	{
+		ID3D11ShaderResourceView* texture;
+		unsigned long long contentHash;
+		// Every path which has resolved to this texture.
+		std::vector<std::string> filenames;
+		size_t sizeInBytes;
+		unsigned int referenceCount;
+	};
+
+	typedef std::list<Entry>::iterator EntryIterator;
+
+	void Touch(EntryIterator entry);
+	void Evict(EntryIterator entry);
+	void Trim();
+	static size_t CalculateTextureSize(ID3D11ShaderResourceView* texture);
+	static std::string NormaliseFilename(const std::string& filename);
+private:
+	// Most recently used at the front.
+	std::list<Entry> mEntries;
+	std::unordered_map<std::string, EntryIterator> mFilenames;
+	std::unordered_map<unsigned long long, EntryIterator> mContentHashes;
+	std::unordered_map<ID3D11ShaderResourceView*, EntryIterator> mTextures;
+
+	size_t mMemoryBudget;
+	Statistics mStatistics;
+};
+
+#endif
@@ -1,9 +1,135 @@
 #include "Shader.h"
+#include "StateCache.h"
+#include "ShaderCache.h"
+#include <atomic>
+#include <vector>
 
+namespace
+{
+	/* Resolves #include in shader source through the file system, relative to the directory of the file being compiled,
+	* so shared headers are found inside the pack as well as on disk. */
+	class CShaderInclude : public ID3D10Include
+	{
+	public:
+		CShaderInclude(const std::string& directory) : mDirectory(directory) {};
+
+		HRESULT __stdcall Open(D3D10_INCLUDE_TYPE includeType, LPCSTR fileName, LPCVOID parentData, LPCVOID* data, UINT* bytes)
+		{
+			std::string text;
+			if (!CFileSystem::GetInstance().ReadText(mDirectory + fileName, text))
+			{
+				return E_FAIL;
+			}
+
+			char* copy = new char[text.size()];
+			text.copy(copy, text.size());
+			*data = copy;
+			*bytes = static_cast<UINT>(text.size());
+			return S_OK;
+		}
+
+		HRESULT __stdcall Close(LPCVOID data)
+		{
+			delete[] static_cast<const char*>(data);
+			return S_OK;
+		}
+	private:
+		std::string mDirectory;
+	};
+
+	/* Hands bytecode or compile errors back to the shaders in the blob they expect from D3DX, whether it was compiled or
+	* loaded from the cache. Deletes itself once the last reference is released. */
+	class CShaderBlob : public ID3D10Blob
+	{
+	public:
+		CShaderBlob(const void* data, size_t size) : mData(static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + size), mReferences(1) {};
+
+		HRESULT __stdcall QueryInterface(REFIID riid, void** object)
+		{
+			*object = nullptr;
+			return E_NOINTERFACE;
+		}
+
+		ULONG __stdcall AddRef()
+		{
+			return ++mReferences;
+		}
+
+		ULONG __stdcall Release()
+		{
+			const ULONG references = --mReferences;
+			if (references == 0)
+			{
+				delete this;
+			}
+			return references;
+		}
+
+		LPVOID __stdcall GetBufferPointer()
+		{
+			return mData.data();
+		}
+
+		SIZE_T __stdcall GetBufferSize()
+		{
+			return mData.size();
+		}
+	private:
+		std::vector<unsigned char> mData;
+		std::atomic<ULONG> mReferences;
+	};
+
+	/* What the shader cache compiles misses with, the source has already been read through the file system.
+	* @Returns bool Whether it compiled, with the compiler's messages in errors if it didn't. */
+	bool CompileWithD3DX(const CShaderCache::ShaderDesc& desc, const std::string& source, std::vector<unsigned char>& bytecode, std::string& errors)
+	{
+		// Terminated by an empty macro, the same as D3DX expects.
+		std::vector<D3D10_SHADER_MACRO> macros;
+		for (auto& define : desc.defines)
+		{
+			D3D10_SHADER_MACRO macro = { define.name.c_str(), define.value.c_str() };
+			macros.push_back(macro);
+		}
+		D3D10_SHADER_MACRO terminator = { NULL, NULL };
+		macros.push_back(terminator);
+
+		CShaderInclude include(desc.filename.substr(0, desc.filename.find_last_of("/\\") + 1));
+
+		ID3D10Blob* shaderBuffer = nullptr;
+		ID3D10Blob* errorMessage = nullptr;
+		const HRESULT result = D3DX11CompileFromMemory(source.data(), source.size(), desc.filename.c_str(), macros.data(), &include,
+			desc.entryPoint.c_str(), desc.profile.c_str(), desc.flags, 0, NULL, &shaderBuffer, &errorMessage, NULL);
 
+		if (errorMessage != nullptr)
+		{
+			errors.assign(static_cast<const char*>(errorMessage->GetBufferPointer()), errorMessage->GetBufferSize());
+			errorMessage->Release();
+		}
+
+		if (FAILED(result) || shaderBuffer == nullptr)
+		{
+			if (errors.empty())
+			{
+				// An empty error would look the same as a missing file to the shader, so say something.
+				errors = "Failed to compile '" + desc.filename + "' for an unknown reason.";
+			}
+			if (shaderBuffer != nullptr)
+			{
+				shaderBuffer->Release();
+			}
+			return false;
+		}
+
+		const unsigned char* data = static_cast<const unsigned char*>(shaderBuffer->GetBufferPointer());
+		bytecode.assign(data, data + shaderBuffer->GetBufferSize());
+		shaderBuffer->Release();
+		return true;
+	}
+}
 
 CShader::CShader()
 {
+	mpMatrixBuffer = nullptr;
 }
 
 
@@ -40,6 +166,41 @@ void CShader::SetViewProjMatrix(D3DXMATRIX viewProj)
 	D3DXMatrixTranspose(&mViewProjMatrix, &mViewProjMatrix);
 }
 
+/* Goes through the shader cache, so the shader is only compiled if it, or anything it includes, has changed since it was cached.
+* @Returns HRESULT The result of compiling, with no error message if the file couldn't be found the same as D3DX gives. */
+HRESULT CShader::CompileShaderFromFile(const std::string& filename, LPCSTR entryPoint, LPCSTR profile, UINT flags, ID3D10Blob** shaderBuffer, ID3D10Blob** errorMessage)
+{
+	CShaderCache::ShaderDesc desc;
+	desc.filename = filename;
+	desc.entryPoint = entryPoint;
+	desc.profile = profile;
+	desc.flags = flags;
+
+	*shaderBuffer = nullptr;
+	*errorMessage = nullptr;
+
+	std::vector<unsigned char> bytecode;
+	std::string errors;
+	if (!CShaderCache::GetInstance().Compile(desc, CompileWithD3DX, bytecode, errors))
+	{
+		if (!errors.empty())
+		{
+			*errorMessage = new CShaderBlob(errors.data(), errors.size());
+		}
+		return E_FAIL;
+	}
+
+	*shaderBuffer = new CShaderBlob(bytecode.data(), bytecode.size());
+	return S_OK;
+}
+
+/* Compile every shader the engine asked for the last time it ran which isn't already cached, without a device.
+* @Returns unsigned int How many shaders were compiled. */
+unsigned int CShader::PrecompileShaders()
+{
+	return CShaderCache::GetInstance().Precompile(CompileWithD3DX);
+}
+
 bool CShader::SetupMatrixBuffer(ID3D11Device * device)
 {
 	D3D11_BUFFER_DESC matrixBufferDesc;
@@ -100,15 +261,15 @@ bool CShader::SetMatrixBuffer(ID3D11DeviceContext * deviceContext, unsigned int
 	// Pass buffer to shader
 	if (shaderType == ShaderType::Vertex)
 	{
-		deviceContext->VSSetConstantBuffers(bufferSlot, 1, &mpMatrixBuffer);
+		CStateCache::Get(deviceContext)->VSSetConstantBuffers(bufferSlot, 1, &mpMatrixBuffer);
 	}
 	else if (shaderType == ShaderType::Pixel)
 	{
-		deviceContext->PSSetConstantBuffers(bufferSlot, 1, &mpMatrixBuffer);
+		CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferSlot, 1, &mpMatrixBuffer);
 	}
 	else if (shaderType == ShaderType::Geometry)
 	{
-		deviceContext->GSSetConstantBuffers(bufferSlot, 1, &mpMatrixBuffer);
+		CStateCache::Get(deviceContext)->GSSetConstantBuffers(bufferSlot, 1, &mpMatrixBuffer);
 	}
 	else
 	{
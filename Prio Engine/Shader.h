@@ -6,6 +6,8 @@
 #include <D3DX11async.h>
 #include "PrioEngineVars.h"
 #include "Texture.h"
+#include "FileSystem.h"
+#include "D3D11RenderDevice.h"
 
 class CShader
 {
@@ -27,6 +29,9 @@ private:
 public:
 	virtual bool Initialise(ID3D11Device* device, HWND hwnd) = 0;
 	virtual void Shutdown() = 0;
+
+	// Fill the shader cache ahead of running the engine, from the shaders it used last time.
+	static unsigned int PrecompileShaders();
 protected:
 	D3DXMATRIX mWorldMatrix;
 	D3DXMATRIX mViewMatrix;
@@ -44,6 +49,8 @@ protected:
 		Geometry,
 		Pixel
 	};
+	// Compile a shader whose source is read through the file system, so it can come out of a pack, or load it from the shader cache.
+	static HRESULT CompileShaderFromFile(const std::string& filename, LPCSTR entryPoint, LPCSTR profile, UINT flags, ID3D10Blob** shaderBuffer, ID3D10Blob** errorMessage);
 	bool SetupMatrixBuffer(ID3D11Device * device);
 	bool SetMatrixBuffer(ID3D11DeviceContext * deviceContext, unsigned int bufferSlot, ShaderType shaderType);
 };
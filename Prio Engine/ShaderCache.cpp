@@ -0,0 +1,423 @@
+#include "ShaderCache.h"
+#include "FileSystem.h"
+#include "ThreadPool.h"
+#include "DiskFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	const char* kCachedExtension = ".cso";
+	const char* kManifestFile = "Manifest.txt";
+	const char* kManifestHeader = "PrioShaderManifest";
+
+	const unsigned int kCachedShaderMagic = 0x43485350;
+
+	// Written in front of the bytecode, so a file from another version or cut short isn't handed to the device.
+	struct CachedShaderHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned long long key;
+		unsigned long long size;
+	};
+
+	unsigned long long HashString(const std::string& text, unsigned long long hash)
+	{
+		// The terminator goes in too, so the boundary between strings is part of the hash.
+		return PrioEngine::Hash::FNV1a(text.c_str(), text.size() + 1, hash);
+	}
+
+	/* Only looks for the line, it doesn't preprocess, so an include which is commented out or behind an #if still counts.
+	* @Returns bool Whether the line includes a file, with its name in includeName. */
+	bool ParseInclude(const std::string& line, std::string& includeName)
+	{
+		const size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+		{
+			return false;
+		}
+
+		const size_t open = line.find_first_of("\"<", start + 8);
+		if (open == std::string::npos)
+		{
+			return false;
+		}
+
+		const size_t close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+		if (close == std::string::npos)
+		{
+			return false;
+		}
+
+		includeName = line.substr(open + 1, close - open - 1);
+		return !includeName.empty();
+	}
+
+	bool CreateCacheDirectory(const std::string& directory)
+	{
+#ifdef _WIN32
+		return CreateDirectoryA(directory.c_str(), NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+		struct stat directoryStatus;
+		return mkdir(directory.c_str(), 0755) == 0 || (stat(directory.c_str(), &directoryStatus) == 0 && S_ISDIR(directoryStatus.st_mode));
+#endif
+	}
+}
+
+CShaderCache::CShaderCache(const std::string& directory)
+{
+	mDirectory = directory;
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+}
+
+
+CShaderCache::~CShaderCache()
+{
+}
+
+/* The source is read here rather than by the compile function, so the key is taken from exactly what gets compiled.
+* @Returns bool Whether there's bytecode for the shader, loaded or compiled. */
+bool CShaderCache::Compile(const ShaderDesc& desc, const CompileFunction& compileFunction, std::vector<unsigned char>& bytecode, std::string& errors)
+{
+	bytecode.clear();
+	errors.clear();
+
+	std::string source;
+	if (!CFileSystem::GetInstance().ReadText(desc.filename, source))
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStatistics.failures++;
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mManifest[GetManifestKey(desc)] = desc;
+	}
+
+	const unsigned long long key = CalculateKey(desc, source);
+	if (Load(key, bytecode))
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStatistics.hits++;
+		return true;
+	}
+
+	const auto compileStart = std::chrono::high_resolution_clock::now();
+	const bool compiled = compileFunction(desc, source, bytecode, errors);
+	const std::chrono::duration<float, std::milli> compileTime = std::chrono::high_resolution_clock::now() - compileStart;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStatistics.compileTime += compileTime.count();
+		if (compiled)
+		{
+			mStatistics.misses++;
+		}
+		else
+		{
+			mStatistics.failures++;
+		}
+	}
+
+	if (!compiled)
+	{
+		return false;
+	}
+
+	// The shader is still good to use if it can't be stored, it'll just be compiled again next time.
+	if (!Store(key, bytecode))
+	{
+		logger->GetInstance().WriteLine("Failed to store the compiled shader '" + desc.filename + "' (" + desc.entryPoint + ") in the shader cache.");
+	}
+
+	return true;
+}
+
+/* Everything the compiler is given goes into the key, along with the version of the cache. Includes are found the same
+* way the compiler finds them, relative to the directory of the shader being compiled.
+* @Returns unsigned long long The key to store the shader under. */
+unsigned long long CShaderCache::CalculateKey(const ShaderDesc& desc, const std::string& source)
+{
+	const unsigned int version = kVersion;
+	unsigned long long hash = PrioEngine::Hash::FNV1a(&version, sizeof(version));
+	hash = HashString(desc.entryPoint, hash);
+	hash = HashString(desc.profile, hash);
+	hash = PrioEngine::Hash::FNV1a(&desc.flags, sizeof(desc.flags), hash);
+
+	for (auto& define : desc.defines)
+	{
+		hash = HashString(define.name, hash);
+		hash = HashString(define.value, hash);
+	}
+
+	hash = HashString(source, hash);
+
+	const std::string directory = desc.filename.substr(0, desc.filename.find_last_of("/\\") + 1);
+	std::vector<std::string> visited;
+	return HashIncludes(directory, source, visited, hash);
+}
+
+/* Each file is only hashed the first time it's included. One which can't be read is hashed by its name alone, if it's
+* really needed the compile fails the same as it would have without the cache. */
+unsigned long long CShaderCache::HashIncludes(const std::string& directory, const std::string& source, std::vector<std::string>& visited, unsigned long long hash)
+{
+	std::istringstream lines(source);
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		std::string includeName;
+		if (!ParseInclude(line, includeName))
+		{
+			continue;
+		}
+
+		if (std::find(visited.begin(), visited.end(), includeName) != visited.end())
+		{
+			continue;
+		}
+		visited.push_back(includeName);
+
+		hash = HashString(includeName, hash);
+
+		std::string includeSource;
+		if (CFileSystem::GetInstance().ReadText(directory + includeName, includeSource))
+		{
+			hash = HashString(includeSource, hash);
+			hash = HashIncludes(directory, includeSource, visited, hash);
+		}
+	}
+
+	return hash;
+}
+
+std::string CShaderCache::GetCachedFilename(unsigned long long key)
+{
+	std::stringstream filename;
+	filename << mDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << kCachedExtension;
+	return filename.str();
+}
+
+/* Read through the file system, so a cache which has been packed is used the same as one on disk.
+* @Returns bool Whether the shader was cached. */
+bool CShaderCache::Load(unsigned long long key, std::vector<unsigned char>& bytecode)
+{
+	CVirtualFile file;
+	if (!CFileSystem::GetInstance().Open(GetCachedFilename(key), file))
+	{
+		return false;
+	}
+
+	CachedShaderHeader header;
+	if (file.GetSize() < sizeof(header))
+	{
+		return false;
+	}
+
+	std::memcpy(&header, file.GetData(), sizeof(header));
+	if (header.magic != kCachedShaderMagic || header.version != kVersion || header.key != key || header.size != file.GetSize() - sizeof(header))
+	{
+		return false;
+	}
+
+	bytecode.assign(file.GetData() + sizeof(header), file.GetData() + file.GetSize());
+	return true;
+}
+
+/* Written through a temporary file, so another thread or run never reads one which is half written. If two threads
+* compile the same shader at once, whichever renames second replaces the first with the same bytecode.
+* @Returns bool Whether the shader is now in the cache. */
+bool CShaderCache::Store(unsigned long long key, const std::vector<unsigned char>& bytecode)
+{
+	if (!CreateCacheDirectory(mDirectory))
+	{
+		return false;
+	}
+
+	const std::string cachedFile = GetCachedFilename(key);
+
+	CachedShaderHeader header;
+	header.magic = kCachedShaderMagic;
+	header.version = kVersion;
+	header.key = key;
+	header.size = bytecode.size();
+
+	const bool written = PrioEngine::DiskFile::Write(cachedFile, [&header, &bytecode](std::ofstream& file)
+	{
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(bytecode.data()), bytecode.size());
+	});
+
+	// Another thread may have the file open while renaming over it, in which case its copy is the one in the cache.
+	return written || std::ifstream(cachedFile.c_str()).good();
+}
+
+std::string CShaderCache::GetManifestKey(const ShaderDesc& desc)
+{
+	std::string key = desc.filename + "|" + desc.entryPoint + "|" + desc.profile + "|" + std::to_string(desc.flags);
+	for (auto& define : desc.defines)
+	{
+		key += "|" + define.name + "=" + define.value;
+	}
+	return key;
+}
+
+/* The manifest is plain text, a header with the version of the cache followed by one line for each shader holding its
+* compile flags, entry point, profile, defines and then its path. Shaders listed in the manifest from earlier runs are
+* kept, as long as they were read in by Precompile.
+* @Returns bool Success */
+bool CShaderCache::SaveManifest()
+{
+	if (!CreateCacheDirectory(mDirectory))
+	{
+		logger->GetInstance().WriteLine("Failed to create the shader cache directory '" + mDirectory + "'.");
+		return false;
+	}
+
+	const std::string manifestFile = mDirectory + "/" + kManifestFile;
+	std::ofstream file(manifestFile.c_str(), std::ios::trunc);
+	if (!file.is_open())
+	{
+		logger->GetInstance().WriteLine("Failed to write the shader manifest '" + manifestFile + "'.");
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	file << kManifestHeader << " " << kVersion << "\n";
+	for (auto& entry : mManifest)
+	{
+		const ShaderDesc& desc = entry.second;
+		file << std::hex << std::setw(8) << std::setfill('0') << desc.flags << std::dec << " " << desc.entryPoint << " " <<
+			desc.profile << " " << desc.defines.size();
+		for (auto& define : desc.defines)
+		{
+			file << " " << define.name << "=" << define.value;
+		}
+		file << " " << desc.filename << "\n";
+	}
+
+	return file.good();
+}
+
+/* A missing manifest, or one from another version of the cache, just means there's nothing to compile.
+* @Returns bool Whether a manifest was read. */
+bool CShaderCache::LoadManifest()
+{
+	const std::string manifestFile = mDirectory + "/" + kManifestFile;
+	std::ifstream file(manifestFile.c_str());
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::string header;
+	unsigned int version = 0;
+	file >> header >> version;
+	if (header != kManifestHeader || version != kVersion)
+	{
+		logger->GetInstance().WriteLine("The shader manifest '" + manifestFile + "' is from another version of the cache, run the engine to write a new one.");
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream entryStream(line);
+		ShaderDesc desc;
+		size_t numberOfDefines = 0;
+		if (!(entryStream >> std::hex >> desc.flags >> std::dec >> desc.entryPoint >> desc.profile >> numberOfDefines))
+		{
+			continue;
+		}
+
+		bool valid = true;
+		for (size_t defineIndex = 0; defineIndex < numberOfDefines && valid; defineIndex++)
+		{
+			std::string defineText;
+			const size_t separator = (entryStream >> defineText) ? defineText.find('=') : std::string::npos;
+			valid = separator != std::string::npos;
+			if (valid)
+			{
+				Define define;
+				define.name = defineText.substr(0, separator);
+				define.value = defineText.substr(separator + 1);
+				desc.defines.push_back(define);
+			}
+		}
+
+		// The path is the rest of the line, as it may well have spaces in.
+		std::getline(entryStream >> std::ws, desc.filename);
+		if (!valid || desc.filename.empty())
+		{
+			continue;
+		}
+
+		mManifest[GetManifestKey(desc)] = desc;
+	}
+
+	return true;
+}
+
+/* Each shader is compiled through Compile, so anything already cached is a hit and is left alone.
+* @Returns unsigned int How many shaders were compiled. */
+unsigned int CShaderCache::Precompile(const CompileFunction& compileFunction)
+{
+	if (!LoadManifest())
+	{
+		logger->GetInstance().WriteLine("There's no shader manifest in '" + mDirectory + "' to precompile from, run the engine once to write it.");
+		return 0;
+	}
+
+	std::vector<ShaderDesc> shaders;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto& entry : mManifest)
+		{
+			shaders.push_back(entry.second);
+		}
+	}
+
+	const unsigned int missesBefore = GetStatistics().misses;
+
+	CThreadPool threadPool;
+	threadPool.ParallelFor(static_cast<unsigned int>(shaders.size()), 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int index = begin; index < end; index++)
+		{
+			std::vector<unsigned char> bytecode;
+			std::string errors;
+			if (!Compile(shaders[index], compileFunction, bytecode, errors))
+			{
+				logger->GetInstance().WriteLine("Failed to precompile the shader '" + shaders[index].filename + "' (" + shaders[index].entryPoint + "). " + errors);
+			}
+		}
+	});
+
+	return GetStatistics().misses - missesBefore;
+}
+
+CShaderCache::Statistics CShaderCache::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStatistics;
+}
+
+void CShaderCache::LogStatistics()
+{
+	const Statistics statistics = GetStatistics();
+	logger->GetInstance().WriteLine("Shader cache: " + std::to_string(statistics.hits) + " hits, " + std::to_string(statistics.misses) +
+		" compiled taking " + std::to_string(statistics.compileTime) + "ms, " + std::to_string(statistics.failures) + " failed.");
+}
@@ -0,0 +1,99 @@
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+#include "Logger.h"
+#include "Hash.h"
+
+// Where compiled shaders are kept, the directory is created the first time one is stored.
+const char* const kShaderCacheDirectory = "ShaderCache";
+
+/* Keeps compiled shader bytecode on disk so a shader is only compiled again once something which goes into it changes.
+* Shaders are stored under a key hashed from their source, the source of every file they include, their defines, entry
+* point, profile and compile flags, so an edit to a shared header is picked up by each shader including it.
+* Compiling is left to the function handed in, nothing here depends on D3DX. Safe to use from any thread, misses are
+* compiled on the thread which asked, so shaders created across the workers are compiled across them too.
+* Every shader asked for is noted in a manifest, which -shaders reads to compile the lot up front. */
+class CShaderCache
+{
+private:
+	CLogger* logger;
+public:
+	// Bump this whenever the layout of the cached files changes, every shader will then be compiled again.
+	static const unsigned int kVersion = 1;
+
+	struct Define
+	{
+		std::string name;
+		std::string value;
+	};
+
+	struct ShaderDesc
+	{
+		std::string filename;
+		std::string entryPoint;
+		std::string profile;
+		unsigned int flags;
+		std::vector<Define> defines;
+	};
+
+	// Given the source, already read through the file system. Returns false with the compiler's messages in errors if it doesn't compile.
+	typedef std::function<bool(const ShaderDesc& desc, const std::string& source, std::vector<unsigned char>& bytecode, std::string& errors)> CompileFunction;
+
+	struct Statistics
+	{
+		unsigned int hits;
+		unsigned int misses;
+		unsigned int failures;
+		// Time spent in the compile function, added up across every thread, in milliseconds.
+		float compileTime;
+	};
+public:
+	// Stores shaders under the directory given, the manifest is kept there with them.
+	CShaderCache(const std::string& directory);
+	~CShaderCache();
+
+	// The cache every shader in the engine goes through.
+	static CShaderCache& GetInstance()
+	{
+		static CShaderCache instance(kShaderCacheDirectory);
+
+		return instance;
+	}
+public:
+	// Load the shader from the cache, or compile and store it on a miss. Errors is left empty if the source couldn't be read.
+	bool Compile(const ShaderDesc& desc, const CompileFunction& compileFunction, std::vector<unsigned char>& bytecode, std::string& errors);
+	// Hash everything which goes into compiling a shader, includes are read through the file system.
+	unsigned long long CalculateKey(const ShaderDesc& desc, const std::string& source);
+
+	// Write out every shader asked for, so they can all be compiled without starting the engine.
+	bool SaveManifest();
+	// Compile each shader in the manifest which isn't already cached, spread across a thread pool. Returns how many were compiled.
+	unsigned int Precompile(const CompileFunction& compileFunction);
+
+	std::string GetCachedFilename(unsigned long long key);
+	Statistics GetStatistics();
+	void LogStatistics();
+private:
+	bool Load(unsigned long long key, std::vector<unsigned char>& bytecode);
+	bool Store(unsigned long long key, const std::vector<unsigned char>& bytecode);
+	bool LoadManifest();
+	unsigned long long HashIncludes(const std::string& directory, const std::string& source, std::vector<std::string>& visited, unsigned long long hash);
+	static std::string GetManifestKey(const ShaderDesc& desc);
+private:
+	CShaderCache(const CShaderCache&);
+	CShaderCache& operator=(const CShaderCache&);
+private:
+	std::string mDirectory;
+	// Shaders asked for, keyed by everything in their description so each is only listed once.
+	std::map<std::string, ShaderDesc> mManifest;
+	Statistics mStatistics;
+	std::mutex mMutex;
+};
+
+#endif
@@ -2,14 +2,7 @@
 Texture2D textures[3];
 SamplerState SampleType;
 
-cbuffer LightBuffer : register(b0)
-{
-	float4 ambientColour;
-	float4 diffuseColour;
-	float3 lightDirection;
-	float specularPower;
-	float4 specularColor;
-};
+#include "SharedConstants.hlsli"
 
 cbuffer MapBuffer : register(b1)
 {
@@ -39,17 +32,17 @@ float4 LightPixelShader(PixelInputType input) : SV_TARGET
 	textureColour = textures[0].Sample(SampleType, input.tex);
 
 	// Set the colour to the ambient colour.
-	colour = ambientColour;
+	colour = AmbientColour;
 
 	// Invert the light direction for calculations.
-	lightDir = -lightDirection;
+	lightDir = -LightDirection;
 
 	// Calculate the amount of light on this pixel.
 	lightIntensity = saturate(dot(input.normal, lightDir));
 
 	if (lightIntensity > 0.0f)
 	{
-		colour += (diffuseColour * lightIntensity);
+		colour += (DiffuseColour * lightIntensity);
 	}
 
 	// Determine the final amount of diffuse color based on the diffuse color combined with the light intensity.
@@ -1,11 +1,5 @@
 // Globals
-cbuffer MatrixBuffer
-{
-	matrix worldMatrix;
-	matrix viewMatrix;
-	matrix projMatrix;
-	matrix ViewProjMatrix;
-};
+#include "SharedConstants.hlsli"
 
 // Type defs.
 struct VertexInputType
@@ -15,6 +9,14 @@ struct VertexInputType
 	float3 normal : NORMAL;
 };
 
+// Packed vertex, the position has already been scaled into the quantised range and is restored by the world matrix.
+struct QuantisedVertexInputType
+{
+	float4 position : POSITION;
+	float2 tex : TEXCOORD0;
+	float2 normal : NORMAL;
+};
+
 struct PixelInputType
 {
 	float4 position : SV_POSITION;
@@ -22,6 +24,16 @@ struct PixelInputType
 	float3 normal : NORMAL;
 };
 
+// Unfold a normal stored on an octahedron back onto the unit sphere.
+float3 DecodeOctahedralNormal(float2 encoded)
+{
+	float3 normal = float3(encoded.x, encoded.y, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float fold = saturate(-normal.z);
+	normal.x += normal.x >= 0.0f ? -fold : fold;
+	normal.y += normal.y >= 0.0f ? -fold : fold;
+	return normalize(normal);
+}
+
 // Vertex shader.
 PixelInputType LightVertexShader(VertexInputType input)
 {
@@ -31,19 +43,28 @@ PixelInputType LightVertexShader(VertexInputType input)
 	input.position.w = 1.0f;
 
 	// Calculate the position of the vertex against world, view and proj matrices.
-	output.position = mul(input.position, worldMatrix);
-	output.position = mul(output.position, ViewProjMatrix);
-	//output.position = mul(output.position, viewMatrix);
-	//output.position = mul(output.position, projMatrix);
+	output.position = mul(input.position, DrawWorldMatrix);
+	output.position = mul(output.position, PassViewProjMatrix);
 
 	// Store the texture coordinates for the pixel shader.
 	output.tex = input.tex;
 
 	// Calculate the normal vector against the world matrix only.
-	output.normal = mul(input.normal, (float3x3)worldMatrix);
+	output.normal = mul(input.normal, (float3x3)DrawWorldMatrix);
 
 	// Normalise the vector.
 	output.normal = normalize(output.normal);
 
 	return output;
+}
+
+// Vertex shader for meshes using the quantised vertex format.
+PixelInputType LightVertexShaderQuantised(QuantisedVertexInputType input)
+{
+	VertexInputType unpacked;
+	unpacked.position = input.position;
+	unpacked.tex = input.tex;
+	unpacked.normal = DecodeOctahedralNormal(input.normal);
+
+	return LightVertexShader(unpacked);
 }
\ No newline at end of file
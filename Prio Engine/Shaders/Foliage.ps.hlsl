@@ -30,13 +30,7 @@ struct PixelInputType
 // Constant buffers
 //////////////////////////
 
-cbuffer LightBuffer : register(b0)
-{
-	float4 AmbientColour;
-	float4 DiffuseColour;
-	float3 LightDirection;
-	float padding;
-};
+#include "SharedConstants.hlsli"
 
 //////////////////////////
 // Pixel Shader
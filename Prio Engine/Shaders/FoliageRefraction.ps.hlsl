@@ -27,16 +27,7 @@ cbuffer ViewportBuffer : register(b0)
 	float2 viewportPadding2;
 }
 
-cbuffer LightBuffer : register(b1)
-{
-	float4	AmbientColour;
-	float4	DiffuseColour;
-	float3	LightDirection;
-	float4	SpecularColour;
-	float3	LightPosition;
-	float	SpecularPower;
-	float	lightBufferPadding;
-}
+#include "SharedConstants.hlsli"
 
 //////////////////////////
 // Structures
@@ -21,6 +21,14 @@ struct VertexInputType
 	float3 Normal : NORMAL;
 };
 
+// Packed vertex, the position has already been scaled into the quantised range and is restored by the world matrix.
+struct QuantisedVertexInputType
+{
+	float4 WorldPosition : POSITION;
+	float2 UV : TEXCOORD0;
+	float2 Normal : NORMAL;
+};
+
 struct PixelInputType
 {
 	float4 ProjectedPosition : SV_POSITION;
@@ -33,6 +41,16 @@ struct PixelInputType
 // Vertex shader
 //////////////////////////
 
+// Unfold a normal stored on an octahedron back onto the unit sphere.
+float3 DecodeOctahedralNormal(float2 encoded)
+{
+	float3 normal = float3(encoded.x, encoded.y, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float fold = saturate(-normal.z);
+	normal.x += normal.x >= 0.0f ? -fold : fold;
+	normal.y += normal.y >= 0.0f ? -fold : fold;
+	return normalize(normal);
+}
+
 PixelInputType RefractionVS(VertexInputType input)
 {
 	PixelInputType output;
@@ -48,4 +66,15 @@ PixelInputType RefractionVS(VertexInputType input)
 	output.Normal = normalize(output.Normal);
 
 	return output;
+}
+
+// Vertex shader for meshes using the quantised vertex format.
+PixelInputType QuantisedRefractionVS(QuantisedVertexInputType input)
+{
+	VertexInputType unpacked;
+	unpacked.WorldPosition = input.WorldPosition;
+	unpacked.UV = input.UV;
+	unpacked.Normal = DecodeOctahedralNormal(input.Normal);
+
+	return RefractionVS(unpacked);
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+//////////////////////////
+// Shared constants
+//////////////////////////
+
+// Bound once at the top slots by CSharedConstants and left there, so every shader can read them without binding
+// anything itself. Slots 0 to 10 are left for constants belonging to a single shader.
+// Must match the structures in SharedConstants.h.
+
+// Written once a frame.
+cbuffer FrameConstants : register(b13)
+{
+	float4	AmbientColour;
+	float4	DiffuseColour;
+	float4	SpecularColour;
+	float3	LightDirection;
+	float	SpecularPower;
+	float3	LightPosition;
+	float	FrameTime;
+	float3	EyePosition;
+	float	WindStrength;
+	float3	WindDirection;
+	float	frameConstantsPadding;
+};
+
+// Written each time the camera being drawn from changes, such as for the reflection.
+cbuffer PassConstants : register(b12)
+{
+	matrix	PassViewMatrix;
+	matrix	PassProjMatrix;
+	matrix	PassViewProjMatrix;
+	// Pixels on the negative side of the plane are clipped, all zeros clips nothing.
+	float4	PassClipPlane;
+	float2	PassViewportSize;
+	float2	passConstantsPadding;
+};
+
+// Written for every draw, only the world matrix.
+cbuffer DrawConstants : register(b11)
+{
+	matrix	DrawWorldMatrix;
+};
@@ -22,13 +22,7 @@ Texture2D rockTextures[2];
 ///////////////////////////
 
 /* The buffer which contains details about our lighting information. */
-cbuffer LightBuffer : register(b0)
-{
-	float4 ambientColour;
-	float4 diffuseColour;
-	float3 lightDirection;
-	float padding;
-};
+#include "SharedConstants.hlsli"
 
 /* Information about the model of the terrain itself. */
 // Important note - separate from terrainInfoBuffer due to the way in which padding works.
@@ -365,17 +359,17 @@ float4 TerrainPixel(PixelInputType input) : SV_TARGET
 	}
 
 	// Set the colour to the ambient colour.
-	colour = ambientColour;
+	colour = AmbientColour;
 
 	// Invert the light direction for calculations.
-	lightDir = -lightDirection;
+	lightDir = -LightDirection;
 
 	// Calculate the amount of light on this pixel.
 	lightIntensity = saturate(dot(input.normal, lightDir));
 
 	if (lightIntensity > 0.0f)
 	{
-		colour += (diffuseColour * lightIntensity);
+		colour += (DiffuseColour * lightIntensity);
 	}
 
 	// Determine the final amount of diffuse color based on the diffuse color combined with the light intensity.
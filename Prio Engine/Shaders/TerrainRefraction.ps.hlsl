@@ -24,16 +24,7 @@ cbuffer ViewportBuffer : register(b0)
 	float2 ViewportSize;
 }
 
-cbuffer LightBuffer : register(b1)
-{
-	float4	AmbientColour;
-	float4	DiffuseColour;
-	float3	LightDirection;
-	float4	SpecularColour;
-	float3	LightPosition;
-	float	SpecularPower;
-	float	lightBufferPadding;
-}
+#include "SharedConstants.hlsli"
 
 cbuffer TerrainAreaBuffer : register(b2)
 {
@@ -2,14 +2,7 @@
 Texture2D textures[3];
 SamplerState SampleType;
 
-cbuffer LightBuffer : register(b0)
-{
-	float4 ambientColour;
-	float4 diffuseColour;
-	float3 lightDirection;
-	float specularPower;
-	float4 specularColor;
-};
+#include "SharedConstants.hlsli"
 
 cbuffer MapBuffer : register(b1)
 {
@@ -32,7 +25,7 @@ float4 TransparentPS(PixelInputType input) : SV_TARGET
 	// Sample the pixel color from the texture using the sampler at this texture coordinate location.
 	float4 textureColour = textures[0].Sample(SampleType, input.tex);
 
-	//textureColour.rgb += ambientColour;
+	//textureColour.rgb += AmbientColour;
 
 	if (textureColour.r < 0.9f)
 	{
@@ -50,17 +50,15 @@ cbuffer ViewportBuffer : register(b3)
 	float2 ViewportSize;
 }
 
-cbuffer LightBuffer : register(b4)
+// The camera each map was drawn from, they aren't always redrawn every frame.
+cbuffer ReprojectionBuffer : register(b4)
 {
-	float4	AmbientColour;
-	float4	DiffuseColour;
-	float3	LightDirection;
-	float4	SpecularColour;
-	float3	LightPosition;
-	float	SpecularPower;
-	float	lightBufferPadding;
+	matrix RefractionViewProj;
+	matrix ReflectionViewProj;
 }
 
+#include "SharedConstants.hlsli"
+
 //////////////////////////
 // Structures
 //////////////////////////
@@ -87,6 +85,13 @@ static const float WaterSpeed2 = 1.0f;
 static const float WaterSpeed3 = 1.7f;
 static const float WaterSpeed4 = 2.6f;
 
+// Where a point was on screen when a map was drawn, from 0 to 1 the same as a screen position divided by the viewport size.
+float2 ReprojectToMap(float4 worldPosition, matrix mapViewProj)
+{
+	float4 projected = mul(worldPosition, mapViewProj);
+	return float2(projected.x, -projected.y) / projected.w * 0.5f + 0.5f;
+}
+
 float4 WaterSurfacePS(PixelInputType input) : SV_TARGET
 {
 	float2 waterUV = input.UV;
@@ -116,12 +121,13 @@ float4 WaterSurfacePS(PixelInputType input) : SV_TARGET
 	float2 waterNormal2D = waterNormal.xz;
 	float2 offsetDir = waterNormal2D * 0.3f;
 
-	float2 screenUV = input.ProjectedPosition.xy / ViewportSize;
-	float4 refractionDepth = RefractionMap.Sample(BilinearMirror, screenUV).a;
-	float4 reflectionHeight = ReflectionMap.Sample(BilinearMirror, screenUV).a;
+	float2 refractionScreenUV = ReprojectToMap(input.WorldPosition, RefractionViewProj);
+	float2 reflectionScreenUV = ReprojectToMap(input.WorldPosition, ReflectionViewProj);
+	float4 refractionDepth = RefractionMap.Sample(BilinearMirror, refractionScreenUV).a;
+	float4 reflectionHeight = ReflectionMap.Sample(BilinearMirror, reflectionScreenUV).a;
 
-	float2 refractionUV = screenUV + RefractionDistortion * refractionDepth * offsetDir / input.ProjectedPosition.w;
-	float2 reflectionUV = screenUV + ReflectionDistortion * reflectionHeight * offsetDir / input.ProjectedPosition.w;
+	float2 refractionUV = refractionScreenUV + RefractionDistortion * refractionDepth * offsetDir / input.ProjectedPosition.w;
+	float2 reflectionUV = reflectionScreenUV + ReflectionDistortion * reflectionHeight * offsetDir / input.ProjectedPosition.w;
 	float4 refractColour = RefractionMap.Sample(BilinearMirror, refractionUV) * RefractionStrength;
 	float4 reflectColour = ReflectionMap.Sample(BilinearMirror, reflectionUV) * ReflectionStrength;
 
@@ -0,0 +1,121 @@
+#include "SharedConstants.h"
+#include <cstring>
+
+namespace
+{
+	CRenderDevice::Buffer* CreateConstantBuffer(CRenderDevice* renderDevice, unsigned int size)
+	{
+		CRenderDevice::BufferDesc bufferDesc;
+		bufferDesc.type = CRenderDevice::ConstantBuffer;
+		bufferDesc.usage = CRenderDevice::DynamicUsage;
+		bufferDesc.size = size;
+
+		return renderDevice->CreateBuffer(bufferDesc, nullptr);
+	}
+
+	void DestroyConstantBuffer(CRenderDevice* renderDevice, CRenderDevice::Buffer*& buffer)
+	{
+		if (buffer != nullptr)
+		{
+			renderDevice->DestroyBuffer(buffer);
+			buffer = nullptr;
+		}
+	}
+}
+
+CSharedConstants::CSharedConstants(CRenderDevice* renderDevice)
+{
+	mpRenderDevice = renderDevice;
+	mpFrameBuffer = nullptr;
+	mpPassBuffer = nullptr;
+	mpDrawBuffer = nullptr;
+}
+
+
+CSharedConstants::~CSharedConstants()
+{
+	Shutdown();
+}
+
+bool CSharedConstants::Initialise()
+{
+	mpFrameBuffer = CreateConstantBuffer(mpRenderDevice, sizeof(FrameConstants));
+	mpPassBuffer = CreateConstantBuffer(mpRenderDevice, sizeof(PassConstants));
+	mpDrawBuffer = CreateConstantBuffer(mpRenderDevice, sizeof(DrawConstants));
+
+	if (mpFrameBuffer == nullptr || mpPassBuffer == nullptr || mpDrawBuffer == nullptr)
+	{
+		logger->GetInstance().WriteLine("Failed to create the shared constant buffers.");
+		return false;
+	}
+
+	return true;
+}
+
+void CSharedConstants::Shutdown()
+{
+	DestroyConstantBuffer(mpRenderDevice, mpDrawBuffer);
+	DestroyConstantBuffer(mpRenderDevice, mpPassBuffer);
+	DestroyConstantBuffer(mpRenderDevice, mpFrameBuffer);
+}
+
+bool CSharedConstants::SetFrameConstants(const FrameConstants& constants)
+{
+	return WriteBuffer(mpRenderDevice, mpFrameBuffer, kFrameConstantsSlot, &constants, sizeof(constants));
+}
+
+bool CSharedConstants::SetPassConstants(const D3DXMATRIX& view, const D3DXMATRIX& projection, const D3DXVECTOR4& clipPlane, float viewportWidth, float viewportHeight)
+{
+	return SetPassConstants(mpRenderDevice, view, projection, clipPlane, viewportWidth, viewportHeight);
+}
+
+/* Written through the device given, so a pass recorded on a deferred device carries its own camera in its list. The
+* buffer is discarded as it's mapped, so each list sees only what it wrote, and passes executed after it the last of it. */
+bool CSharedConstants::SetPassConstants(CRenderDevice* renderDevice, const D3DXMATRIX& view, const D3DXMATRIX& projection, const D3DXVECTOR4& clipPlane, float viewportWidth, float viewportHeight)
+{
+	PassConstants constants;
+	D3DXMATRIX viewProj = view * projection;
+
+	D3DXMatrixTranspose(&constants.view, &view);
+	D3DXMatrixTranspose(&constants.projection, &projection);
+	D3DXMatrixTranspose(&constants.viewProj, &viewProj);
+	constants.clipPlane = clipPlane;
+	constants.viewportSize = D3DXVECTOR2(viewportWidth, viewportHeight);
+	constants.padding = D3DXVECTOR2(0.0f, 0.0f);
+
+	return WriteBuffer(renderDevice, mpPassBuffer, kPassConstantsSlot, &constants, sizeof(constants));
+}
+
+bool CSharedConstants::SetDrawConstants(const D3DXMATRIX& world)
+{
+	DrawConstants constants;
+	WriteDrawConstants(constants, world);
+
+	return WriteBuffer(mpRenderDevice, mpDrawBuffer, kDrawConstantsSlot, &constants, sizeof(constants));
+}
+
+void CSharedConstants::WriteDrawConstants(DrawConstants& constants, const D3DXMATRIX& world)
+{
+	D3DXMatrixTranspose(&constants.world, &world);
+}
+
+/* Discard the buffer's old contents, then bind it to every stage, so the binding is correct whatever was drawn before.
+* @Returns bool False if the buffer couldn't be mapped, in which case nothing is bound. */
+bool CSharedConstants::WriteBuffer(CRenderDevice* renderDevice, CRenderDevice::Buffer* buffer, unsigned int slot, const void* data, unsigned int size)
+{
+	void* destination = renderDevice->Map(buffer);
+	if (destination == nullptr)
+	{
+		logger->GetInstance().WriteLine("Failed to map a shared constant buffer to write to it.");
+		return false;
+	}
+
+	std::memcpy(destination, data, size);
+	renderDevice->Unmap(buffer);
+
+	renderDevice->SetConstantBuffer(CRenderDevice::VertexStage, slot, buffer);
+	renderDevice->SetConstantBuffer(CRenderDevice::GeometryStage, slot, buffer);
+	renderDevice->SetConstantBuffer(CRenderDevice::PixelStage, slot, buffer);
+
+	return true;
+}
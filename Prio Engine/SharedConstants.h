@@ -0,0 +1,77 @@
+#ifndef SHAREDCONSTANTS_H
+#define SHAREDCONSTANTS_H
+
+#include <D3DX10math.h>
+#include "RenderDevice.h"
+
+/* Constants read by every shader, split by how often they change. Each tier is a buffer of its own bound to the vertex,
+* geometry and pixel stages at a fixed slot, so per frame data is written once rather than alongside every draw, and a
+* draw only has to write its world matrix. Shaders declare them by including Shaders/SharedConstants.hlsli.
+* Must only be used from the thread which owns the render device, or through a deferred one while recording. */
+class CSharedConstants
+{
+private:
+	CLogger* logger;
+public:
+	// The top of the fourteen slots, out of the way of the constants each shader binds for itself from slot 0 up.
+	static const unsigned int kDrawConstantsSlot = 11;
+	static const unsigned int kPassConstantsSlot = 12;
+	static const unsigned int kFrameConstantsSlot = 13;
+
+	// Laid out to match the HLSL packing rules, no member may straddle a 16 byte boundary.
+	struct FrameConstants
+	{
+		D3DXVECTOR4 ambientColour;
+		D3DXVECTOR4 diffuseColour;
+		D3DXVECTOR4 specularColour;
+		D3DXVECTOR3 lightDirection;
+		float specularPower;
+		D3DXVECTOR3 lightPosition;
+		float frameTime;
+		D3DXVECTOR3 eyePosition;
+		float windStrength;
+		D3DXVECTOR3 windDirection;
+		float padding;
+	};
+
+	struct PassConstants
+	{
+		D3DXMATRIX view;
+		D3DXMATRIX projection;
+		D3DXMATRIX viewProj;
+		D3DXVECTOR4 clipPlane;
+		D3DXVECTOR2 viewportSize;
+		D3DXVECTOR2 padding;
+	};
+
+	struct DrawConstants
+	{
+		D3DXMATRIX world;
+	};
+public:
+	CSharedConstants(CRenderDevice* renderDevice);
+	~CSharedConstants();
+public:
+	bool Initialise();
+	void Shutdown();
+
+	bool SetFrameConstants(const FrameConstants& constants);
+	// Matrices are given as they come from the camera, they're transposed for the shaders here.
+	bool SetPassConstants(const D3DXMATRIX& view, const D3DXMATRIX& projection, const D3DXVECTOR4& clipPlane, float viewportWidth, float viewportHeight);
+	// For passes recorded on a deferred device, which may be done from the thread recording.
+	bool SetPassConstants(CRenderDevice* renderDevice, const D3DXMATRIX& view, const D3DXMATRIX& projection, const D3DXVECTOR4& clipPlane, float viewportWidth, float viewportHeight);
+	bool SetDrawConstants(const D3DXMATRIX& world);
+
+	// For draws queued in a draw list, which writes the draw buffer itself as each one is submitted.
+	static void WriteDrawConstants(DrawConstants& constants, const D3DXMATRIX& world);
+	CRenderDevice::Buffer* GetDrawBuffer() { return mpDrawBuffer; };
+private:
+	bool WriteBuffer(CRenderDevice* renderDevice, CRenderDevice::Buffer* buffer, unsigned int slot, const void* data, unsigned int size);
+private:
+	CRenderDevice* mpRenderDevice;
+	CRenderDevice::Buffer* mpFrameBuffer;
+	CRenderDevice::Buffer* mpPassBuffer;
+	CRenderDevice::Buffer* mpDrawBuffer;
+};
+
+#endif
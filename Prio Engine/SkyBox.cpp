@@ -1,4 +1,5 @@
 #include "SkyBox.h"
+#include "StateCache.h"
 
 CSkyBox::CSkyBox()
 {
@@ -74,11 +75,11 @@ void CSkyBox::RenderBuffers(ID3D11DeviceContext * deviceContext)
 	stride = sizeof(VertexType);
 	offset = 0;
 
-	deviceContext->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
+	CStateCache::Get(deviceContext)->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
 
-	deviceContext->IASetIndexBuffer(mpIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	CStateCache::Get(deviceContext)->IASetIndexBuffer(mpIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 }
 
@@ -829,67 +830,43 @@ bool CSkyBox::InitialiseBuffers(ID3D11Device * device)
 
 bool CSkyBox::LoadSkyBoxModel(char * modelName)
 {
-	// Grab the mesh object for the last mesh we loaded.
-
-	Assimp::Importer importer;
 	const std::string name = modelName;
-	logger->GetInstance().WriteLine("Attempting to open " + name + " using Assimp.");
-
-	// Read in the file, store this mesh in the scene.
-	const aiScene* scene = importer.ReadFile(modelName,
-		aiProcess_ConvertToLeftHanded |
-		aiProcess_JoinIdenticalVertices |
-		aiProcess_Triangulate |
-		aiProcess_SortByPType);
+	logger->GetInstance().WriteLine("Attempting to open " + name + ".");
 
-	// If scene hasn't been initialised then something has gone wrong!
-	if (!scene)
+	// Read in the cooked copy of the model, assimp is only used if it needs cooking again.
+	CCookedMesh cookedMesh;
+	if (!cookedMesh.Load(name, kSkyBoxImportFlags, kSkyBoxLodSettings))
 	{
-		logger->GetInstance().WriteLine(importer.GetErrorString());
-		logger->GetInstance().WriteLine("Failed to create scene.");
-		return nullptr;
+		logger->GetInstance().WriteLine("Failed to load cooked mesh.");
+		return false;
 	}
 
+	const CCookedMesh::Vertex* vertices = cookedMesh.GetVertices();
+	const unsigned int* indices = cookedMesh.GetIndices();
+
 	// Iterate through all our meshes to be loaded.
-	for (unsigned int meshCount = 0; meshCount < scene->mNumMeshes; meshCount++)
+	for (unsigned int meshCount = 0; meshCount < cookedMesh.GetNumberOfSubMeshes(); meshCount++)
 	{
 		// Load the current mesh.
-		const aiMesh& mesh = *scene->mMeshes[meshCount];
-	
-		// Store info about the mesh.
-		unsigned int numFaces = mesh.mNumFaces;
-		unsigned int numVertices = mesh.mNumVertices;
+		const CCookedMesh::SubMeshRecord& mesh = cookedMesh.GetSubMesh(meshCount);
 
-		for (unsigned int vertexCount = 0; vertexCount < numVertices; vertexCount++)
+		for (unsigned int vertexCount = 0; vertexCount < mesh.numberOfVertices; vertexCount++)
 		{
-			// Parse a singular vertex info.
-
-			const aiVector3D& vertexCoords = mesh.mVertices[vertexCount];
+			const CCookedMesh::Vertex& vertex = vertices[mesh.firstVertex + vertexCount];
 
 			// Load the vertex info into our array.
-			mpVerticesList.push_back(D3DXVECTOR3(vertexCoords.x, vertexCoords.y, vertexCoords.z));
-
-			// Parse information on the UV of a singular vertex.
-			const aiVector3D& textureCoords = mesh.mTextureCoords[0][vertexCount];
+			mpVerticesList.push_back(D3DXVECTOR3(vertex.position[0], vertex.position[1], vertex.position[2]));
 
 			// Only need to parse the U and V channels.
-			mpUVList.push_back(D3DXVECTOR2(textureCoords.x, textureCoords.y));
-
-			// Load the normals data of this singular vertex.
-			const aiVector3D& normals = mesh.mNormals[vertexCount];
+			mpUVList.push_back(D3DXVECTOR2(vertex.uv[0], vertex.uv[1]));
 
 			// Store this normals data in our array.
-			mpNormalsList.push_back(D3DXVECTOR3(normals.x, normals.y, normals.z));
+			mpNormalsList.push_back(D3DXVECTOR3(vertex.normal[0], vertex.normal[1], vertex.normal[2]));
 		}
 
-		for (unsigned int faceCount = 0; faceCount < numFaces; faceCount++)
+		for (unsigned int indexCount = 0; indexCount < mesh.numberOfIndices; indexCount++)
 		{
-			const aiFace& face = mesh.mFaces[faceCount];
-
-			for (unsigned int indexCount = 0; indexCount < face.mNumIndices; indexCount++)
-			{
-				mpIndicesList.push_back(face.mIndices[indexCount]);
-			}
+			mpIndicesList.push_back(indices[mesh.firstIndex + indexCount]);
 		}
 	}
 
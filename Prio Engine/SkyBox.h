@@ -10,6 +10,12 @@
 #include <postprocess.h>
 
 #include "PrioEngineVars.h"
+#include "CookedMesh.h"
+
+// Post processing applied when the sky box model is imported, changing these causes it to be cooked again.
+const unsigned int kSkyBoxImportFlags = aiProcess_ConvertToLeftHanded | aiProcess_JoinIdenticalVertices | aiProcess_Triangulate | aiProcess_SortByPType;
+// The sky box is always drawn in full, so there's no point generating any levels of detail for it.
+const CCookedMesh::LodSettings kSkyBoxLodSettings = { 1, { 1.0f } };
 
 class CSkyBox
 {
@@ -1,4 +1,5 @@
 #include "SkyboxShader.h"
+#include "StateCache.h"
 
 
 
@@ -67,7 +68,7 @@ bool CSkyboxShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::stri
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "SkyDomeVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "SkyDomeVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -85,7 +86,7 @@ bool CSkyboxShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::stri
 	
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "SkyDomePixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "SkyDomePixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		// If we recieved an error message.
@@ -265,7 +266,7 @@ bool CSkyboxShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, D3DX
 	bufferNumber = 0;
 
 	// Finally set the gradient constant buffer in the pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpGradientBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpGradientBuffer);
 
 	return true;
 }
@@ -273,11 +274,11 @@ bool CSkyboxShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, D3DX
 void CSkyboxShader::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
 
 	// Set the vertex and pixel shaders that will be used to render the triangles.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpPixelShader, NULL, 0);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -1,4 +1,5 @@
 #include "SnowShader.h"
+#include "StateCache.h"
 
 
 
@@ -59,7 +60,7 @@ bool CSnowShader::Render(ID3D11DeviceContext* deviceContext)
 	// Shader resources / textures
 	/////////////////////////////
 
-	deviceContext->PSSetShaderResources(0, 1, &mpDiffuseTexture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpDiffuseTexture);
 
 	// Now render the prepared buffers with the shader.
 	RenderShader(deviceContext);
@@ -78,7 +79,7 @@ bool CSnowShader::UpdateRender(ID3D11DeviceContext * deviceContext)
 		return false;
 	}
 
-	deviceContext->GSSetShaderResources(0, 1, &mpRandomTexture);
+	CStateCache::Get(deviceContext)->GSSetShaderResources(0, 1, &mpRandomTexture);
 
 	// Now render the prepared buffers with the shader.
 	UpdateParticles(deviceContext);
@@ -109,7 +110,7 @@ bool CSnowShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "SnowVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "SnowVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -126,7 +127,7 @@ bool CSnowShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the geometry shader code.
-	result = D3DX11CompileFromFile(gsFilename.c_str(), NULL, NULL, "SnowGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &geometryShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(gsFilename, "SnowGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &geometryShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -143,7 +144,7 @@ bool CSnowShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "SnowPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "SnowPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -188,7 +189,7 @@ bool CSnowShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	/////////////////////////////////////////
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsUpdateFilename.c_str(), NULL, NULL, "SnowUpdateVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &vertexShaderUpdateBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsUpdateFilename, "SnowUpdateVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &vertexShaderUpdateBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -205,7 +206,7 @@ bool CSnowShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the geometry shader code.
-	result = D3DX11CompileFromFile(gsUpdateFilename.c_str(), NULL, NULL, "SnowUpdateGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &geometryShaderUpdateBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(gsUpdateFilename, "SnowUpdateGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &geometryShaderUpdateBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -534,8 +535,8 @@ bool CSnowShader::SetShaderParameters(ID3D11DeviceContext* deviceContext)
 	bufferNumber = 1;
 
 	// Now set the constant buffer in the vertex shader with the updated values.
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &mpFrameBuffer);
-	deviceContext->GSSetConstantBuffers(bufferNumber, 1, &mpFrameBuffer);
+	CStateCache::Get(deviceContext)->VSSetConstantBuffers(bufferNumber, 1, &mpFrameBuffer);
+	CStateCache::Get(deviceContext)->GSSetConstantBuffers(bufferNumber, 1, &mpFrameBuffer);
 
 	return true;
 }
@@ -543,19 +544,19 @@ bool CSnowShader::SetShaderParameters(ID3D11DeviceContext* deviceContext)
 void CSnowShader::RenderShader(ID3D11DeviceContext * deviceContext)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
 
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->GSSetShader(mpGeometryShader, NULL, 0);
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->GSSetShader(mpGeometryShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
 
 	deviceContext->DrawAuto();
 
-	deviceContext->GSSetShader(NULL, NULL, 0);
+	CStateCache::Get(deviceContext)->GSSetShader(NULL, NULL, 0);
 
 	return;
 }
@@ -563,13 +564,13 @@ void CSnowShader::RenderShader(ID3D11DeviceContext * deviceContext)
 bool CSnowShader::UpdateParticles(ID3D11DeviceContext * deviceContext)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
 
-	deviceContext->VSSetShader(mpUpdateVertexShader, NULL, 0);
-	deviceContext->GSSetShader(mpUpdateGeometryShader, NULL, 0);
-	deviceContext->GSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetShader(NULL, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpUpdateVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->GSSetShader(mpUpdateGeometryShader, NULL, 0);
+	CStateCache::Get(deviceContext)->GSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetShader(NULL, NULL, 0);
 
 	if (mFirstRun)
 	{
@@ -580,7 +581,7 @@ bool CSnowShader::UpdateParticles(ID3D11DeviceContext * deviceContext)
 		deviceContext->DrawAuto();
 	}
 
-	deviceContext->GSSetShader(NULL, NULL, NULL);
+	CStateCache::Get(deviceContext)->GSSetShader(NULL, NULL, NULL);
 
 	return true;
 }
@@ -1,4 +1,5 @@
 #include "SpecularLightingShader.h"
+#include "StateCache.h"
 
 
 CSpecularLightingShader::CSpecularLightingShader()
@@ -72,7 +73,7 @@ bool CSpecularLightingShader::InitialiseShader(ID3D11Device * device, HWND hwnd,
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "LightVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "LightVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -89,7 +90,7 @@ bool CSpecularLightingShader::InitialiseShader(ID3D11Device * device, HWND hwnd,
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "LightPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "LightPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -343,12 +344,12 @@ bool CSpecularLightingShader::SetShaderParameters(	ID3D11DeviceContext * deviceC
 	bufferNumber = 1;
 
 	// Set the camera constant buffer with the updated values.
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &mpCameraBuffer);
+	CStateCache::Get(deviceContext)->VSSetConstantBuffers(bufferNumber, 1, &mpCameraBuffer);
 
 	// Set shader texture resource in the pixel shader.
 	ID3D11ShaderResourceView* nullShader = nullptr;
-	deviceContext->PSSetShaderResources(0, 1, &nullShader);
-	deviceContext->PSSetShaderResources(0, 1, &texture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &nullShader);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &texture);
 
 	// Lock the light constant buffer so it can be written to.
 	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
@@ -374,7 +375,7 @@ bool CSpecularLightingShader::SetShaderParameters(	ID3D11DeviceContext * deviceC
 	bufferNumber = 0;
 
 	// Finally set the light constant buffer in the pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
 
 	return true;
 }
@@ -382,14 +383,14 @@ bool CSpecularLightingShader::SetShaderParameters(	ID3D11DeviceContext * deviceC
 void CSpecularLightingShader::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpSampleState);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpSampleState);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -0,0 +1,449 @@
+#include "StateCache.h"
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+namespace
+{
+	// Stands in for state which could be anything, it never compares equal to a real object.
+	const char kUnknownState = 0;
+	const void* const kUnknown = &kUnknownState;
+
+	std::mutex gCachesMutex;
+	std::map<ID3D11DeviceContext*, CStateCache*> gCaches;
+	// Bumped whenever a cache is released, so a thread knows the cache it last looked up may be gone.
+	std::atomic<unsigned int> gCachesGeneration(0);
+
+	// The last lookup each thread made. Nearly every lookup is for the same context as the one before it.
+	thread_local ID3D11DeviceContext* tLastDeviceContext = nullptr;
+	thread_local CStateCache* tLastCache = nullptr;
+	thread_local unsigned int tLastGeneration = 0;
+
+	void Forget(const void** shadow, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; i++)
+		{
+			shadow[i] = kUnknown;
+		}
+	}
+
+	/* Compare a range of slots being set against the shadow copy, updating it, and narrow the range down to run from the
+	* first slot that changes to the last. Ranges reaching past the shadowed slots are left whole.
+	* @Returns bool False if every slot already held what's being set, so the call can be dropped. */
+	template <typename T>
+	bool NarrowRange(const void** shadow, unsigned int shadowedSlots, UINT& startSlot, UINT& count, T* const*& values)
+	{
+		if (values == nullptr || startSlot + count > shadowedSlots)
+		{
+			if (startSlot < shadowedSlots)
+			{
+				Forget(shadow + startSlot, shadowedSlots - startSlot);
+			}
+			return true;
+		}
+
+		UINT first = count;
+		UINT last = 0;
+		for (UINT i = 0; i < count; i++)
+		{
+			if (shadow[startSlot + i] != values[i])
+			{
+				first = first == count ? i : first;
+				last = i;
+				shadow[startSlot + i] = values[i];
+			}
+		}
+
+		if (first == count)
+		{
+			return false;
+		}
+
+		startSlot += first;
+		values += first;
+		count = last - first + 1;
+		return true;
+	}
+}
+
+CStateCache::CStateCache(ID3D11DeviceContext* deviceContext)
+{
+	mpDeviceContext = deviceContext;
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+	std::memset(&mLastFrameStatistics, 0, sizeof(mLastFrameStatistics));
+	Invalidate();
+}
+
+
+CStateCache::~CStateCache()
+{
+}
+
+CStateCache* CStateCache::Get(ID3D11DeviceContext* deviceContext)
+{
+	const unsigned int generation = gCachesGeneration.load(std::memory_order_acquire);
+	if (deviceContext == tLastDeviceContext && generation == tLastGeneration)
+	{
+		return tLastCache;
+	}
+
+	std::lock_guard<std::mutex> lock(gCachesMutex);
+
+	CStateCache*& cache = gCaches[deviceContext];
+	if (cache == nullptr)
+	{
+		cache = new CStateCache(deviceContext);
+		CLogger::GetInstance().MemoryAllocWriteLine(typeid(cache).name());
+	}
+
+	tLastDeviceContext = deviceContext;
+	tLastCache = cache;
+	tLastGeneration = gCachesGeneration.load(std::memory_order_relaxed);
+
+	return cache;
+}
+
+void CStateCache::Release(ID3D11DeviceContext* deviceContext)
+{
+	std::lock_guard<std::mutex> lock(gCachesMutex);
+
+	auto found = gCaches.find(deviceContext);
+	if (found == gCaches.end())
+	{
+		return;
+	}
+
+	delete found->second;
+	CLogger::GetInstance().MemoryDeallocWriteLine(typeid(found->second).name());
+	gCaches.erase(found);
+	gCachesGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void CStateCache::BeginFrame()
+{
+	mLastFrameStatistics = mStatistics;
+	std::memset(&mStatistics, 0, sizeof(mStatistics));
+
+	Invalidate();
+}
+
+void CStateCache::Invalidate()
+{
+	InvalidateStage(mVertexStage);
+	InvalidateStage(mGeometryStage);
+	InvalidateStage(mPixelStage);
+
+	mInputLayout = kUnknown;
+	Forget(mVertexBuffers, kShadowedVertexBufferSlots);
+	std::memset(mVertexStrides, 0, sizeof(mVertexStrides));
+	std::memset(mVertexOffsets, 0, sizeof(mVertexOffsets));
+	mIndexBuffer = kUnknown;
+	mIndexFormat = DXGI_FORMAT_UNKNOWN;
+	mIndexOffset = 0;
+	mTopology = -1;
+
+	mRasterizerState = kUnknown;
+	mBlendState = kUnknown;
+	std::memset(mBlendFactor, 0, sizeof(mBlendFactor));
+	mSampleMask = 0;
+	mDepthStencilState = kUnknown;
+	mStencilRef = 0;
+}
+
+void CStateCache::IASetInputLayout(ID3D11InputLayout* inputLayout)
+{
+	if (mInputLayout == inputLayout)
+	{
+		Count(false);
+		return;
+	}
+
+	mInputLayout = inputLayout;
+	mpDeviceContext->IASetInputLayout(inputLayout);
+	Count(true);
+}
+
+/* Vertex buffers are narrowed the same way as the other slot ranges, but a slot only matches if its stride and offset do too. */
+void CStateCache::IASetVertexBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* vertexBuffers, const UINT* strides, const UINT* offsets)
+{
+	if (vertexBuffers == nullptr || startSlot + numBuffers > kShadowedVertexBufferSlots)
+	{
+		if (startSlot < kShadowedVertexBufferSlots)
+		{
+			Forget(mVertexBuffers + startSlot, kShadowedVertexBufferSlots - startSlot);
+		}
+		mpDeviceContext->IASetVertexBuffers(startSlot, numBuffers, vertexBuffers, strides, offsets);
+		Count(true);
+		return;
+	}
+
+	UINT first = numBuffers;
+	UINT last = 0;
+	for (UINT i = 0; i < numBuffers; i++)
+	{
+		const UINT slot = startSlot + i;
+		if (mVertexBuffers[slot] != vertexBuffers[i] || mVertexStrides[slot] != strides[i] || mVertexOffsets[slot] != offsets[i])
+		{
+			first = first == numBuffers ? i : first;
+			last = i;
+			mVertexBuffers[slot] = vertexBuffers[i];
+			mVertexStrides[slot] = strides[i];
+			mVertexOffsets[slot] = offsets[i];
+		}
+	}
+
+	if (first == numBuffers)
+	{
+		Count(false);
+		return;
+	}
+
+	mpDeviceContext->IASetVertexBuffers(startSlot + first, last - first + 1, vertexBuffers + first, strides + first, offsets + first);
+	Count(true);
+}
+
+void CStateCache::IASetIndexBuffer(ID3D11Buffer* indexBuffer, DXGI_FORMAT format, UINT offset)
+{
+	if (mIndexBuffer == indexBuffer && mIndexFormat == format && mIndexOffset == offset)
+	{
+		Count(false);
+		return;
+	}
+
+	mIndexBuffer = indexBuffer;
+	mIndexFormat = format;
+	mIndexOffset = offset;
+	mpDeviceContext->IASetIndexBuffer(indexBuffer, format, offset);
+	Count(true);
+}
+
+void CStateCache::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (mTopology == static_cast<int>(topology))
+	{
+		Count(false);
+		return;
+	}
+
+	mTopology = static_cast<int>(topology);
+	mpDeviceContext->IASetPrimitiveTopology(topology);
+	Count(true);
+}
+
+void CStateCache::VSSetShader(ID3D11VertexShader* vertexShader, ID3D11ClassInstance* const* classInstances, UINT numClassInstances)
+{
+	if (SetShader(mVertexStage, vertexShader, numClassInstances))
+	{
+		mpDeviceContext->VSSetShader(vertexShader, classInstances, numClassInstances);
+	}
+}
+
+void CStateCache::GSSetShader(ID3D11GeometryShader* geometryShader, ID3D11ClassInstance* const* classInstances, UINT numClassInstances)
+{
+	if (SetShader(mGeometryStage, geometryShader, numClassInstances))
+	{
+		mpDeviceContext->GSSetShader(geometryShader, classInstances, numClassInstances);
+	}
+}
+
+void CStateCache::PSSetShader(ID3D11PixelShader* pixelShader, ID3D11ClassInstance* const* classInstances, UINT numClassInstances)
+{
+	if (SetShader(mPixelStage, pixelShader, numClassInstances))
+	{
+		mpDeviceContext->PSSetShader(pixelShader, classInstances, numClassInstances);
+	}
+}
+
+void CStateCache::VSSetShaderResources(UINT startSlot, UINT numViews, ID3D11ShaderResourceView* const* shaderResourceViews)
+{
+	const bool issue = NarrowRange(mVertexStage.shaderResources, kShadowedResourceSlots, startSlot, numViews, shaderResourceViews);
+	if (issue)
+	{
+		mpDeviceContext->VSSetShaderResources(startSlot, numViews, shaderResourceViews);
+	}
+	Count(issue);
+}
+
+void CStateCache::GSSetShaderResources(UINT startSlot, UINT numViews, ID3D11ShaderResourceView* const* shaderResourceViews)
+{
+	const bool issue = NarrowRange(mGeometryStage.shaderResources, kShadowedResourceSlots, startSlot, numViews, shaderResourceViews);
+	if (issue)
+	{
+		mpDeviceContext->GSSetShaderResources(startSlot, numViews, shaderResourceViews);
+	}
+	Count(issue);
+}
+
+void CStateCache::PSSetShaderResources(UINT startSlot, UINT numViews, ID3D11ShaderResourceView* const* shaderResourceViews)
+{
+	const bool issue = NarrowRange(mPixelStage.shaderResources, kShadowedResourceSlots, startSlot, numViews, shaderResourceViews);
+	if (issue)
+	{
+		mpDeviceContext->PSSetShaderResources(startSlot, numViews, shaderResourceViews);
+	}
+	Count(issue);
+}
+
+void CStateCache::VSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* samplers)
+{
+	const bool issue = NarrowRange(mVertexStage.samplers, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, startSlot, numSamplers, samplers);
+	if (issue)
+	{
+		mpDeviceContext->VSSetSamplers(startSlot, numSamplers, samplers);
+	}
+	Count(issue);
+}
+
+void CStateCache::GSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* samplers)
+{
+	const bool issue = NarrowRange(mGeometryStage.samplers, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, startSlot, numSamplers, samplers);
+	if (issue)
+	{
+		mpDeviceContext->GSSetSamplers(startSlot, numSamplers, samplers);
+	}
+	Count(issue);
+}
+
+void CStateCache::PSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* samplers)
+{
+	const bool issue = NarrowRange(mPixelStage.samplers, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, startSlot, numSamplers, samplers);
+	if (issue)
+	{
+		mpDeviceContext->PSSetSamplers(startSlot, numSamplers, samplers);
+	}
+	Count(issue);
+}
+
+void CStateCache::VSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* constantBuffers)
+{
+	const bool issue = NarrowRange(mVertexStage.constantBuffers, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, startSlot, numBuffers, constantBuffers);
+	if (issue)
+	{
+		mpDeviceContext->VSSetConstantBuffers(startSlot, numBuffers, constantBuffers);
+	}
+	Count(issue);
+}
+
+void CStateCache::GSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* constantBuffers)
+{
+	const bool issue = NarrowRange(mGeometryStage.constantBuffers, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, startSlot, numBuffers, constantBuffers);
+	if (issue)
+	{
+		mpDeviceContext->GSSetConstantBuffers(startSlot, numBuffers, constantBuffers);
+	}
+	Count(issue);
+}
+
+void CStateCache::PSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* constantBuffers)
+{
+	const bool issue = NarrowRange(mPixelStage.constantBuffers, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, startSlot, numBuffers, constantBuffers);
+	if (issue)
+	{
+		mpDeviceContext->PSSetConstantBuffers(startSlot, numBuffers, constantBuffers);
+	}
+	Count(issue);
+}
+
+void CStateCache::RSSetState(ID3D11RasterizerState* rasterizerState)
+{
+	if (mRasterizerState == rasterizerState)
+	{
+		Count(false);
+		return;
+	}
+
+	mRasterizerState = rasterizerState;
+	mpDeviceContext->RSSetState(rasterizerState);
+	Count(true);
+}
+
+void CStateCache::OMSetBlendState(ID3D11BlendState* blendState, const FLOAT blendFactor[4], UINT sampleMask)
+{
+	// No blend factor is the same as a factor of all ones.
+	const FLOAT defaultBlendFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	const FLOAT* factor = blendFactor != nullptr ? blendFactor : defaultBlendFactor;
+
+	if (mBlendState == blendState && mSampleMask == sampleMask && std::memcmp(mBlendFactor, factor, sizeof(mBlendFactor)) == 0)
+	{
+		Count(false);
+		return;
+	}
+
+	mBlendState = blendState;
+	mSampleMask = sampleMask;
+	std::memcpy(mBlendFactor, factor, sizeof(mBlendFactor));
+	mpDeviceContext->OMSetBlendState(blendState, blendFactor, sampleMask);
+	Count(true);
+}
+
+void CStateCache::OMSetDepthStencilState(ID3D11DepthStencilState* depthStencilState, UINT stencilRef)
+{
+	if (mDepthStencilState == depthStencilState && mStencilRef == stencilRef)
+	{
+		Count(false);
+		return;
+	}
+
+	mDepthStencilState = depthStencilState;
+	mStencilRef = stencilRef;
+	mpDeviceContext->OMSetDepthStencilState(depthStencilState, stencilRef);
+	Count(true);
+}
+
+void CStateCache::OMSetRenderTargets(UINT numViews, ID3D11RenderTargetView* const* renderTargetViews, ID3D11DepthStencilView* depthStencilView)
+{
+	mpDeviceContext->OMSetRenderTargets(numViews, renderTargetViews, depthStencilView);
+	InvalidateShaderResources();
+	Count(true);
+}
+
+void CStateCache::SOSetTargets(UINT numBuffers, ID3D11Buffer* const* targets, const UINT* offsets)
+{
+	mpDeviceContext->SOSetTargets(numBuffers, targets, offsets);
+	Forget(mVertexBuffers, kShadowedVertexBufferSlots);
+	Count(true);
+}
+
+/* Shaders with class instances are always passed on, the instances aren't shadowed.
+* @Returns bool Whether the call needs passing on to the context. */
+bool CStateCache::SetShader(StageState& stage, const void* shader, UINT numClassInstances)
+{
+	if (stage.shader == shader && numClassInstances == 0)
+	{
+		Count(false);
+		return false;
+	}
+
+	stage.shader = numClassInstances == 0 ? shader : kUnknown;
+	Count(true);
+	return true;
+}
+
+void CStateCache::InvalidateStage(StageState& stage)
+{
+	stage.shader = kUnknown;
+	Forget(stage.shaderResources, kShadowedResourceSlots);
+	Forget(stage.samplers, D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT);
+	Forget(stage.constantBuffers, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+}
+
+/* The runtime unbinds any shader resource view whose texture is bound as an output, without saying which. */
+void CStateCache::InvalidateShaderResources()
+{
+	Forget(mVertexStage.shaderResources, kShadowedResourceSlots);
+	Forget(mGeometryStage.shaderResources, kShadowedResourceSlots);
+	Forget(mPixelStage.shaderResources, kShadowedResourceSlots);
+}
+
+void CStateCache::Count(bool issued)
+{
+	if (issued)
+	{
+		mStatistics.issued++;
+	}
+	else
+	{
+		mStatistics.elided++;
+	}
+}
@@ -0,0 +1,118 @@
+#ifndef STATECACHE_H
+#define STATECACHE_H
+
+#include <d3d11.h>
+#include "PrioEngineVars.h"
+
+/* Sits in front of a device context and drops calls which would set state the context already has. A copy of what was
+* last set is kept for each piece of state, and only the slots which actually differ are passed on. Reached through
+* Get with the context it shadows, so a class can swap deviceContext->PSSetShader for
+* CStateCache::Get(deviceContext)->PSSetShader without being handed anything new.
+* Only the calls below are shadowed, anything else still goes straight to the context. Code which sets state on the
+* context directly, rather than through here, must call Invalidate afterwards.
+* Like the context itself, a cache must only be used from one thread at a time. */
+class CStateCache
+{
+private:
+	CLogger* logger;
+public:
+	// Counted since the last call to BeginFrame.
+	struct Statistics
+	{
+		// Calls passed on to the context, including those trimmed down to fewer slots.
+		unsigned int issued;
+		// Calls dropped because nothing they set had changed.
+		unsigned int elided;
+	};
+public:
+	// The cache for a context, made the first time it's asked for. Safe to call from any thread.
+	static CStateCache* Get(ID3D11DeviceContext* deviceContext);
+	// Must be called before the context itself is released.
+	static void Release(ID3D11DeviceContext* deviceContext);
+public:
+	// Starts counting a new frame. Everything is invalidated too, as the UI draws straight through the context.
+	void BeginFrame();
+	// Forget everything, so the next call for each piece of state is passed on whatever it sets.
+	void Invalidate();
+
+	void IASetInputLayout(ID3D11InputLayout* inputLayout);
+	void IASetVertexBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* vertexBuffers, const UINT* strides, const UINT* offsets);
+	void IASetIndexBuffer(ID3D11Buffer* indexBuffer, DXGI_FORMAT format, UINT offset);
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+
+	void VSSetShader(ID3D11VertexShader* vertexShader, ID3D11ClassInstance* const* classInstances, UINT numClassInstances);
+	void GSSetShader(ID3D11GeometryShader* geometryShader, ID3D11ClassInstance* const* classInstances, UINT numClassInstances);
+	void PSSetShader(ID3D11PixelShader* pixelShader, ID3D11ClassInstance* const* classInstances, UINT numClassInstances);
+
+	void VSSetShaderResources(UINT startSlot, UINT numViews, ID3D11ShaderResourceView* const* shaderResourceViews);
+	void GSSetShaderResources(UINT startSlot, UINT numViews, ID3D11ShaderResourceView* const* shaderResourceViews);
+	void PSSetShaderResources(UINT startSlot, UINT numViews, ID3D11ShaderResourceView* const* shaderResourceViews);
+
+	void VSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* samplers);
+	void GSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* samplers);
+	void PSSetSamplers(UINT startSlot, UINT numSamplers, ID3D11SamplerState* const* samplers);
+
+	void VSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* constantBuffers);
+	void GSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* constantBuffers);
+	void PSSetConstantBuffers(UINT startSlot, UINT numBuffers, ID3D11Buffer* const* constantBuffers);
+
+	void RSSetState(ID3D11RasterizerState* rasterizerState);
+	void OMSetBlendState(ID3D11BlendState* blendState, const FLOAT blendFactor[4], UINT sampleMask);
+	void OMSetDepthStencilState(ID3D11DepthStencilState* depthStencilState, UINT stencilRef);
+
+	// Always passed on. Binding a target unbinds any shader resource views of the same texture.
+	void OMSetRenderTargets(UINT numViews, ID3D11RenderTargetView* const* renderTargetViews, ID3D11DepthStencilView* depthStencilView);
+	// Always passed on. Binding a stream out target unbinds it as a vertex buffer.
+	void SOSetTargets(UINT numBuffers, ID3D11Buffer* const* targets, const UINT* offsets);
+
+	ID3D11DeviceContext* GetDeviceContext() { return mpDeviceContext; };
+	const Statistics& GetLastFrameStatistics() { return mLastFrameStatistics; };
+private:
+	CStateCache(ID3D11DeviceContext* deviceContext);
+	~CStateCache();
+private:
+	// Shader resources are only shadowed in the first few slots, calls reaching past them are always passed on.
+	static const unsigned int kShadowedResourceSlots = 16;
+	static const unsigned int kShadowedVertexBufferSlots = 4;
+
+	struct StageState
+	{
+		const void* shader;
+		const void* shaderResources[kShadowedResourceSlots];
+		const void* samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+		const void* constantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+	};
+private:
+	bool SetShader(StageState& stage, const void* shader, UINT numClassInstances);
+	void InvalidateStage(StageState& stage);
+	void InvalidateShaderResources();
+	void Count(bool issued);
+private:
+	ID3D11DeviceContext* mpDeviceContext;
+
+	StageState mVertexStage;
+	StageState mGeometryStage;
+	StageState mPixelStage;
+
+	const void* mInputLayout;
+	const void* mVertexBuffers[kShadowedVertexBufferSlots];
+	UINT mVertexStrides[kShadowedVertexBufferSlots];
+	UINT mVertexOffsets[kShadowedVertexBufferSlots];
+	const void* mIndexBuffer;
+	DXGI_FORMAT mIndexFormat;
+	UINT mIndexOffset;
+	// Negative while unknown.
+	int mTopology;
+
+	const void* mRasterizerState;
+	const void* mBlendState;
+	FLOAT mBlendFactor[4];
+	UINT mSampleMask;
+	const void* mDepthStencilState;
+	UINT mStencilRef;
+
+	Statistics mStatistics;
+	Statistics mLastFrameStatistics;
+};
+
+#endif
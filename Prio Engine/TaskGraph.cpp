@@ -0,0 +1,242 @@
+#include "TaskGraph.h"
+#include <sstream>
+#include <iomanip>
+
+namespace
+{
+	std::string FormatMilliseconds(float milliseconds)
+	{
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(1) << std::setw(8) << milliseconds << "ms";
+		return stream.str();
+	}
+}
+
+CTaskGraph::CTaskGraph(const std::string& name)
+{
+	mName = name;
+	mpThreadPool = nullptr;
+	mNumberInFlight = 0;
+	mNumberCompleted = 0;
+	mFailed = false;
+	mTotalTime = 0.0f;
+}
+
+
+CTaskGraph::~CTaskGraph()
+{
+}
+
+CTaskGraph::TaskId CTaskGraph::AddTask(const std::string& name, std::function<bool()> function, TaskAffinity affinity)
+{
+	Task task;
+	task.name = name;
+	task.function = function;
+	task.affinity = affinity;
+	task.remainingDependencies = 0;
+	task.completed = false;
+	task.startTime = 0.0f;
+	task.duration = 0.0f;
+
+	mTasks.push_back(task);
+
+	return static_cast<TaskId>(mTasks.size() - 1);
+}
+
+void CTaskGraph::AddDependency(TaskId task, TaskId dependsOn)
+{
+	mTasks[task].dependencies.push_back(dependsOn);
+	mTasks[dependsOn].dependents.push_back(task);
+}
+
+/* The thread calling this runs the main thread tasks as they become ready, and otherwise sleeps until the workers have
+* finished everything else.
+* @Returns bool Whether every task ran and succeeded. */
+bool CTaskGraph::Run(CThreadPool* threadPool)
+{
+	mpThreadPool = threadPool;
+	mNumberInFlight = 0;
+	mNumberCompleted = 0;
+	mFailed = false;
+	mStartTime = std::chrono::high_resolution_clock::now();
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	for (auto& task : mTasks)
+	{
+		task.remainingDependencies = static_cast<unsigned int>(task.dependencies.size());
+		task.completed = false;
+	}
+
+	for (TaskId id = 0; id < mTasks.size(); id++)
+	{
+		if (mTasks[id].remainingDependencies == 0)
+		{
+			Dispatch(id);
+		}
+	}
+
+	while (true)
+	{
+		mCondition.wait(lock, [this] { return !mMainThreadTasks.empty() || mNumberInFlight == 0; });
+
+		if (!mMainThreadTasks.empty())
+		{
+			const TaskId id = mMainThreadTasks.front();
+			mMainThreadTasks.pop_front();
+
+			lock.unlock();
+			Execute(id);
+			lock.lock();
+			continue;
+		}
+
+		// Nothing left running and nothing waiting to run on this thread.
+		break;
+	}
+
+	mTotalTime = GetElapsedTime();
+	mpThreadPool = nullptr;
+
+	if (!mFailed && mNumberCompleted != mTasks.size())
+	{
+		// Every task which could start has finished, so the rest must be waiting on each other.
+		logger->GetInstance().WriteLine("The task graph '" + mName + "' has a cycle in its dependencies, " +
+			std::to_string(mTasks.size() - mNumberCompleted) + " tasks were never run.");
+		return false;
+	}
+
+	return !mFailed;
+}
+
+/* Hand a task whose dependencies are all done to whichever thread it's allowed to run on. Must be called with the lock held. */
+void CTaskGraph::Dispatch(TaskId id)
+{
+	mNumberInFlight++;
+
+	if (mTasks[id].affinity == MainThread || mpThreadPool == nullptr)
+	{
+		mMainThreadTasks.push_back(id);
+		mCondition.notify_all();
+	}
+	else
+	{
+		mpThreadPool->Enqueue([this, id]() { Execute(id); });
+	}
+}
+
+void CTaskGraph::Execute(TaskId id)
+{
+	Task& task = mTasks[id];
+
+	bool skip;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		skip = mFailed;
+	}
+
+	bool successful = false;
+	if (!skip)
+	{
+		task.startTime = GetElapsedTime();
+		successful = task.function();
+		task.duration = GetElapsedTime() - task.startTime;
+
+		if (!successful)
+		{
+			logger->GetInstance().WriteLine("The task '" + task.name + "' failed, no more of '" + mName + "' will be started.");
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mNumberInFlight--;
+
+	if (successful)
+	{
+		task.completed = true;
+		mNumberCompleted++;
+
+		if (!mFailed)
+		{
+			for (auto dependent : task.dependents)
+			{
+				if (--mTasks[dependent].remainingDependencies == 0)
+				{
+					Dispatch(dependent);
+				}
+			}
+		}
+	}
+	else
+	{
+		mFailed = true;
+	}
+
+	mCondition.notify_all();
+}
+
+float CTaskGraph::GetElapsedTime()
+{
+	const std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - mStartTime;
+	return elapsed.count();
+}
+
+void CTaskGraph::LogTimings()
+{
+	logger->GetInstance().WriteSubtitle("Timings of '" + mName + "'");
+
+	float summedTime = 0.0f;
+	TaskId lastFinished = 0;
+	float lastFinishTime = -1.0f;
+
+	for (TaskId id = 0; id < mTasks.size(); id++)
+	{
+		const Task& task = mTasks[id];
+		if (!task.completed)
+		{
+			logger->GetInstance().WriteLine("                            " + task.name + " (didn't complete)");
+			continue;
+		}
+
+		logger->GetInstance().WriteLine("started at " + FormatMilliseconds(task.startTime) + " took " + FormatMilliseconds(task.duration) + "  " +
+			task.name + (task.affinity == MainThread ? " (main thread)" : ""));
+
+		summedTime += task.duration;
+		if (task.startTime + task.duration > lastFinishTime)
+		{
+			lastFinishTime = task.startTime + task.duration;
+			lastFinished = id;
+		}
+	}
+
+	logger->GetInstance().WriteLine("");
+	logger->GetInstance().WriteLine("Finished in " + FormatMilliseconds(mTotalTime) + ", the tasks took " + FormatMilliseconds(summedTime) +
+		" between them.");
+
+	// Walk back from the last task to finish, each time to whichever dependency held it up the longest.
+	if (lastFinishTime >= 0.0f)
+	{
+		std::string criticalPath = mTasks[lastFinished].name;
+		TaskId current = lastFinished;
+
+		while (!mTasks[current].dependencies.empty())
+		{
+			TaskId latest = mTasks[current].dependencies.front();
+			for (auto dependency : mTasks[current].dependencies)
+			{
+				if (mTasks[dependency].startTime + mTasks[dependency].duration > mTasks[latest].startTime + mTasks[latest].duration)
+				{
+					latest = dependency;
+				}
+			}
+
+			current = latest;
+			criticalPath = mTasks[current].name + " > " + criticalPath;
+		}
+
+		logger->GetInstance().WriteLine("Critical path: " + criticalPath);
+	}
+
+	logger->GetInstance().CloseSubtitle();
+}
@@ -0,0 +1,78 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "ThreadPool.h"
+
+/* A set of tasks with the order between them given only where one needs another to have finished. Each task is started
+* as soon as everything it depends on is done, so independent file loading and shader compilation overlap across the
+* thread pool. Tasks which need the immediate context, or anything else only safe on one thread, are pinned to the
+* thread calling Run and executed there one at a time. How long every task took is kept for a timing report. */
+class CTaskGraph
+{
+private:
+	CLogger* logger;
+public:
+	typedef unsigned int TaskId;
+
+	enum TaskAffinity
+	{
+		AnyThread,
+		MainThread
+	};
+public:
+	CTaskGraph(const std::string& name);
+	~CTaskGraph();
+public:
+	// The function returns false if the task failed.
+	TaskId AddTask(const std::string& name, std::function<bool()> function, TaskAffinity affinity = AnyThread);
+	// The task won't be started until the one it depends on has finished successfully.
+	void AddDependency(TaskId task, TaskId dependsOn);
+
+	// Runs every task, not returning until all have finished. Once a task fails no more are started, though any which
+	// are already running are waited on.
+	bool Run(CThreadPool* threadPool);
+	// Write when each task started and how long it took to the log, along with the chain of tasks which held up the end.
+	void LogTimings();
+private:
+	struct Task
+	{
+		std::string name;
+		std::function<bool()> function;
+		TaskAffinity affinity;
+		std::vector<TaskId> dependencies;
+		std::vector<TaskId> dependents;
+		unsigned int remainingDependencies;
+		bool completed;
+		// Both in milliseconds, the start being relative to when the graph started running.
+		float startTime;
+		float duration;
+	};
+
+	void Dispatch(TaskId id);
+	void Execute(TaskId id);
+	float GetElapsedTime();
+private:
+	std::string mName;
+	std::vector<Task> mTasks;
+	CThreadPool* mpThreadPool;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::deque<TaskId> mMainThreadTasks;
+	// Tasks which have been handed out but haven't finished yet.
+	unsigned int mNumberInFlight;
+	unsigned int mNumberCompleted;
+	bool mFailed;
+
+	std::chrono::high_resolution_clock::time_point mStartTime;
+	float mTotalTime;
+};
+
+#endif
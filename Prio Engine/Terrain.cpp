@@ -1,6 +1,15 @@
 #include "Terrain.h"
+#include "StateCache.h"
 
-CTerrain::CTerrain(ID3D11Device* device, int screenWidth, int screenHeight)
+namespace
+{
+	bool InitialiseTexture(CTexture* texture, ID3D11Device* device, CAssetLoader* assetLoader, const std::string& filename)
+	{
+		return assetLoader != nullptr ? texture->InitialiseAsync(assetLoader, filename) : texture->Initialise(device, filename);
+	}
+}
+
+CTerrain::CTerrain(ID3D11Device* device, int screenWidth, int screenHeight, CAssetLoader* assetLoader)
 {
 	// Output alloc message to memory log.
 	logger->GetInstance().MemoryAllocWriteLine(typeid(this).name());
@@ -18,6 +27,7 @@ CTerrain::CTerrain(ID3D11Device* device, int screenWidth, int screenHeight)
 
 	mHeightMapLoaded = false;
 	mpHeightMap = nullptr;
+	mHeightMapVersion = 0;
 
 	mLowestPoint = 0.0f;
 	mHighestPoint = 0.0f;
@@ -26,13 +36,13 @@ CTerrain::CTerrain(ID3D11Device* device, int screenWidth, int screenHeight)
 	mpTextures = new CTexture*[kmNumberOfTextures];
 	// Dirt
 	mpTextures[0] = new CTexture();
-	mpTextures[0]->Initialise(device, "Resources/Textures/Dirt.dds");
+	InitialiseTexture(mpTextures[0], device, assetLoader, "Resources/Textures/Dirt.dds");
 	// Sand.
 	mpTextures[1] = new CTexture();
-	mpTextures[1]->Initialise(device, "Resources/Textures/Sand.dds");
+	InitialiseTexture(mpTextures[1], device, assetLoader, "Resources/Textures/Sand.dds");
 
 	mpPatchMap = new CTexture();
-	mpPatchMap->Initialise(device, "Resources/Patch Maps/PatchMap.png");
+	InitialiseTexture(mpPatchMap, device, assetLoader, "Resources/Patch Maps/PatchMap.png");
 
 	///////////////////////
 	// Grass textures
@@ -41,13 +51,13 @@ CTerrain::CTerrain(ID3D11Device* device, int screenWidth, int screenHeight)
 	mpGrassTextures = new CTexture*[kNumberOfGrassTextures];
 
 	mpGrassTextures[0] = new CTexture();
-	if (!mpGrassTextures[0]->Initialise(device, "Resources/Textures/BrightGrass.dds"))
+	if (!InitialiseTexture(mpGrassTextures[0], device, assetLoader, "Resources/Textures/BrightGrass.dds"))
 	{
 		logger->GetInstance().WriteLine("Failed to load 'Resources/Textures/BrightGrass.dds'.");
 	}
 
 	mpGrassTextures[1] = new CTexture();
-	if (!mpGrassTextures[1]->Initialise(device, "Resources/Textures/DarkGrass.dds"))
+	if (!InitialiseTexture(mpGrassTextures[1], device, assetLoader, "Resources/Textures/DarkGrass.dds"))
 	{
 		logger->GetInstance().WriteLine("Failed to load 'Resources/Textures/DarkGrass.dds'.");
 	}
@@ -58,13 +68,13 @@ CTerrain::CTerrain(ID3D11Device* device, int screenWidth, int screenHeight)
 	mpRockTextures = new CTexture*[kNumberOfRockTextures];
 
 	mpRockTextures[0] = new CTexture();
-	if (!mpRockTextures[0]->Initialise(device, "Resources/Textures/Stone.dds"))
+	if (!InitialiseTexture(mpRockTextures[0], device, assetLoader, "Resources/Textures/Stone.dds"))
 	{
 		logger->GetInstance().WriteLine("Failed to load 'Resources/Textures/Stone.dds'.");
 	}
 
 	mpRockTextures[1] = new CTexture();
-	if (!mpRockTextures[1]->Initialise(device, "Resources/Textures/LightRock.dds"))
+	if (!InitialiseTexture(mpRockTextures[1], device, assetLoader, "Resources/Textures/LightRock.dds"))
 	{
 		logger->GetInstance().WriteLine("Failed to load 'Resources/Textures/LightRock.dds'.");
 	}
@@ -163,7 +173,7 @@ bool CTerrain::CreateTerrain(ID3D11Device* device)
 	}
 
 	mpWater = new CWater();
-	if (!mpWater->Initialise(device, D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(mWidth - 1.0f, 0.0f, mHeight - 1.0f), 200, 200, "Resources/Textures/WaterNormalHeight.png", mScreenWidth, mScreenHeight))
+	if (!mpWater->Initialise(device, D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(mWidth - 1.0f, 0.0f, mHeight - 1.0f), 200, 200, "Resources/Textures/WaterNormalHeight.png"))
 	{
 		logger->GetInstance().WriteLine("Failed to initialise the body of water.");
 		return false;
@@ -180,7 +190,7 @@ bool CTerrain::CreateTerrain(ID3D11Device* device)
 		return false;
 	}
 
-
+	mHeightMapVersion++;
 
 	return true;
 }
@@ -734,13 +744,13 @@ void CTerrain::RenderBuffers(ID3D11DeviceContext * context)
 	offset = 0;
 
 	// Set the vertex buffer to active in the input assembler.
-	context->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
+	CStateCache::Get(context)->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
 
 	// Set the index buffer to active in the input assembler.
-	context->IASetIndexBuffer(mpIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	CStateCache::Get(context)->IASetIndexBuffer(mpIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
 	
 	// Tell directx we've passed it a triangle list in the form of indices.
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CStateCache::Get(context)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
 PrioEngine::Math::VEC3 CTerrain::CalculateNormal(VertexType * vertices, int index)
@@ -1008,7 +1018,7 @@ bool CTerrain::UpdateBuffers(ID3D11Device * device, ID3D11DeviceContext* deviceC
 		delete mpWater;
 		mpWater = nullptr;
 		mpWater = new CWater();
-		if (!mpWater->Initialise(device, D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(mWidth - 1.0f, 0.0f, mHeight - 1.0f), 200, 200, "Resources/Textures/WaterNormalHeight.png", mScreenWidth, mScreenHeight))
+		if (!mpWater->Initialise(device, D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(mWidth - 1.0f, 0.0f, mHeight - 1.0f), 200, 200, "Resources/Textures/WaterNormalHeight.png"))
 		{
 			logger->GetInstance().WriteLine("Failed to initialise the body of water.");
 			return false;
@@ -1019,6 +1029,7 @@ bool CTerrain::UpdateBuffers(ID3D11Device * device, ID3D11DeviceContext* deviceC
 	mPlantsInfo.clear();
 
 	InitialiseBuffers(device);
+	mHeightMapVersion++;
 	mUpdating = false;
 
 	return true;
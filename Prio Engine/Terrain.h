@@ -34,7 +34,8 @@ private:
 	};
 
 public:
-	CTerrain(ID3D11Device* device, int screenWidth, int screenHeight);
+	// Textures are read in the background if an asset loader is given, otherwise they're loaded before returning.
+	CTerrain(ID3D11Device* device, int screenWidth, int screenHeight, CAssetLoader* assetLoader = nullptr);
 	~CTerrain();
 private:
 	void ReleaseHeightMap();
@@ -79,6 +80,8 @@ private:
 	int mVertexCount;
 	int mIndexCount;
 	double** mpHeightMap;
+	// Incremented each time the height map is rebuilt, so anything derived from it knows when to update.
+	unsigned int mHeightMapVersion;
 	// Buffer to store our vertices.
 	ID3D11Buffer* mpVertexBuffer;
 	// Buffer to store our indices.
@@ -94,6 +97,8 @@ public:
 	int GetHeight() { return mHeight; };
 	float GetHighestPoint() { return mHighestPoint; };
 	float GetLowestPoint() { return mLowestPoint; };
+	double** GetHeightMap() { return mpHeightMap; };
+	unsigned int GetHeightMapVersion() { return mHeightMapVersion; };
 // Setters
 public:
 	void SetWidth(int value) { mWidth = value; };
@@ -1,4 +1,5 @@
 #include "TerrainShader.h"
+#include "StateCache.h"
 
 CTerrainShader::CTerrainShader()
 {
@@ -6,7 +7,6 @@ CTerrainShader::CTerrainShader()
 	mpPixelShader = nullptr;
 	mpLayout = nullptr;
 	mpSampleState = nullptr;
-	mpLightBuffer = nullptr;
 	mpPatchMap = new CTexture();
 }
 
@@ -46,16 +46,15 @@ void CTerrainShader::Shutdown()
 }
 
 bool CTerrainShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, CTexture** texturesArray, unsigned int numberOfTextures, CTexture** grassTexturesArray, unsigned int numberOfGrassTextures,
-	CTexture** rockTexturesArray, unsigned int numberOfRockTextures,
-	D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour, float highestPos, float lowestPos, D3DXVECTOR3 worldPosition,
+	CTexture** rockTexturesArray, unsigned int numberOfRockTextures, float highestPos, float lowestPos, D3DXVECTOR3 worldPosition,
 	float snowHeight, float grassHeight, float dirtHeight, float sandHeight, float slopeGrassCutoff, float slopeRockCutoff)
 {
 	bool result;
 
 	// Set the shader parameters that it will use for rendering.
 	result = SetShaderParameters(deviceContext, texturesArray, 
-		numberOfTextures, grassTexturesArray, numberOfGrassTextures, rockTexturesArray, numberOfRockTextures, lightDirection, 
-		diffuseColour, ambientColour, highestPos, lowestPos, worldPosition, snowHeight, grassHeight, dirtHeight, sandHeight, slopeGrassCutoff, slopeRockCutoff);
+		numberOfTextures, grassTexturesArray, numberOfGrassTextures, rockTexturesArray, numberOfRockTextures,
+		highestPos, lowestPos, worldPosition, snowHeight, grassHeight, dirtHeight, sandHeight, slopeGrassCutoff, slopeRockCutoff);
 	if (!result)
 	{
 		return false;
@@ -77,7 +76,6 @@ bool CTerrainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 	D3D11_INPUT_ELEMENT_DESC polygonLayout[kNumberOfPolygonElements];
 	unsigned int numElements;
 	D3D11_SAMPLER_DESC samplerDesc;
-	D3D11_BUFFER_DESC lightBufferDesc;
 	D3D11_BUFFER_DESC positioningBufferDesc;
 	D3D11_BUFFER_DESC terrainAreaBufferDesc;
 	D3D11_BUFFER_DESC slopeBufferDesc;
@@ -88,7 +86,7 @@ bool CTerrainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "TerrainVertex", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "TerrainVertex", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -105,7 +103,7 @@ bool CTerrainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "TerrainPixel", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "TerrainPixel", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -221,20 +219,6 @@ bool CTerrainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 		return false;
 	}
 
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-
-	result = device->CreateBuffer(&lightBufferDesc, NULL, &mpLightBuffer);
-	if (FAILED(result))
-	{
-		logger->GetInstance().WriteLine("Failed to create the buffer from the light buffer descriptor from within the texture diffuse light shader class.");
-		return false;
-	}
-
 	///////////////////////////////
 	// Position buffer description
 	positioningBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
@@ -307,12 +291,6 @@ void CTerrainShader::ShutdownShader()
 		mpPatchMap = nullptr;
 	}
 
-	if (mpLightBuffer)
-	{
-		mpLightBuffer->Release();
-		mpLightBuffer = nullptr;
-	}
-	
 	if (mpTerrainAreaBuffer)
 	{
 		mpTerrainAreaBuffer->Release();
@@ -384,7 +362,6 @@ void CTerrainShader::OutputShaderErrorMessage(ID3D10Blob *errorMessage, HWND hwn
 
 bool CTerrainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, CTexture** textureArray, unsigned int numberOfTextures, CTexture** grassTexturesArray, unsigned int numberOfGrassTextures,
 	CTexture** rockTexturesArray, unsigned int numberOfRockTextures,
-	D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour,
 	float highestPos, float lowestPos, D3DXVECTOR3 worldPosition, float snowHeight, float grassHeight, float dirtHeight, float sandHeight, float slopeGrassCutoff, float slopeRockCutoff)
 {
 	ID3D11ShaderResourceView** textures = new ID3D11ShaderResourceView*[numberOfTextures];
@@ -410,7 +387,6 @@ bool CTerrainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, CTe
 	HRESULT result;
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
 	unsigned int bufferNumber;
-	LightBufferType* dataPtr2;
 	PositioningBufferType* positioningConstBuffPtr;
 	TerrainAreaBufferType* terrainAreaConstBuffPtr;
 
@@ -426,35 +402,12 @@ bool CTerrainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, CTe
 	// Resources
 	//////////////////////////
 
-	deviceContext->PSSetShaderResources(0, numberOfTextures, textures);
-	deviceContext->PSSetShaderResources(numberOfTextures, numberOfGrassTextures, grassTextures);
-	deviceContext->PSSetShaderResources(numberOfTextures + numberOfGrassTextures, 1, &patchMap);
-	deviceContext->PSSetShaderResources(numberOfTextures + numberOfGrassTextures + 1, numberOfRockTextures, rockTextures);
-
-	// Lock the light constant buffer so it can be written to.
-	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
-	{
-		return false;
-	}
-
-	// Get a pointer to the data in the constant buffer.
-	dataPtr2 = (LightBufferType*)mappedResource.pData;
-
-	// Copy the lighting variables into the constant buffer.
-	dataPtr2->diffuseColour = diffuseColour;
-	dataPtr2->ambientColour = ambientColour;
-	dataPtr2->lightDirection = lightDirection;
-	dataPtr2->padding = 0.0f;
-
-	// Unlock the constant buffer.
-	deviceContext->Unmap(mpLightBuffer, 0);
-
-	// Set the position of the light constant buffer in the pixel shader.
-	bufferNumber = 0;
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, numberOfTextures, textures);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(numberOfTextures, numberOfGrassTextures, grassTextures);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(numberOfTextures + numberOfGrassTextures, 1, &patchMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(numberOfTextures + numberOfGrassTextures + 1, numberOfRockTextures, rockTextures);
 
-	// Finally set the light constant buffer in the pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
+	// The light is read from the shared frame constants.
 
 	////////////////////////////////////////
 	// Positioning buffer.
@@ -480,7 +433,7 @@ bool CTerrainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, CTe
 	bufferNumber = 1;
 
 	// Update the terrain constant buffer in the pixel shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpPositioningBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpPositioningBuffer);
 
 	result = deviceContext->Map(mpTerrainAreaBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 
@@ -499,7 +452,7 @@ bool CTerrainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, CTe
 	bufferNumber = 2;
 
 	// Update the terrain constant buffer in the pixel shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpTerrainAreaBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpTerrainAreaBuffer);
 
 	///////////////////////////
 	// Slope Buffer
@@ -527,7 +480,7 @@ bool CTerrainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, CTe
 	bufferNumber = 3;
 
 	// Update the terrain constant buffer in the pixel shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpSlopeBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpSlopeBuffer);
 
 	delete[] textures;
 	delete[] grassTextures;
@@ -539,14 +492,14 @@ bool CTerrainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, CTe
 void CTerrainShader::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpPixelShader, NULL, 0);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpSampleState);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpSampleState);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -6,14 +6,6 @@
 class CTerrainShader : public CShader
 {
 private:
-	struct LightBufferType
-	{
-		D3DXVECTOR4 ambientColour;
-		D3DXVECTOR4 diffuseColour;
-		D3DXVECTOR3 lightDirection;
-		float padding;
-	};
-
 	struct TerrainInfoBufferType
 	{
 		float highestPosition;
@@ -50,8 +42,7 @@ public:
 	bool Initialise(ID3D11Device* device, HWND hwnd);
 	void Shutdown();
 	bool Render(ID3D11DeviceContext* deviceContext, int indexCount, CTexture** texturesArray, unsigned int numberOfTextures, CTexture** grassTexturesArray, unsigned int numberOfGrassTextures,
-		CTexture** rockTexturesArray, unsigned int numberOfRockTextures,
-		D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, 	D3DXVECTOR4 ambientColour, float highestPos, float lowestPos, D3DXVECTOR3 worldPosition,
+		CTexture** rockTexturesArray, unsigned int numberOfRockTextures, float highestPos, float lowestPos, D3DXVECTOR3 worldPosition,
 		float snowHeight, float grassHeight, float dirtHeight, float sandHeight, float slopeGrassCutoff, float slopeRockCutoff);
 
 private:
@@ -62,7 +53,6 @@ private:
 	bool SetShaderParameters(ID3D11DeviceContext* deviceContext, 
 		CTexture** textureArray, unsigned int numberOfTextures, CTexture** grassTexturesArray, unsigned int numberOfGrassTextures,
 		CTexture** rockTexturesArray, unsigned int numberOfRockTextures,
-		D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour, 
 		float highestPos, float lowestPos, D3DXVECTOR3 worldPosition, float snowHeight, float grassHeight, float dirtHeight, float sandHeight,
 		float slopeGrassCutoff, float slopeRockCutoff);
 	void RenderShader(ID3D11DeviceContext* deviceContext, int indexCount);
@@ -72,7 +62,6 @@ private:
 	ID3D11PixelShader* mpPixelShader;
 	ID3D11InputLayout* mpLayout;
 	ID3D11SamplerState* mpSampleState;
-	ID3D11Buffer* mpLightBuffer;
 	ID3D11Buffer* mpPositioningBuffer;
 	ID3D11Buffer* mpTerrainAreaBuffer;
 	ID3D11Buffer* mpSlopeBuffer;
@@ -1,9 +1,42 @@
 #include "Texture.h"
+#include "TextureCooker.h"
+
+namespace
+{
+	DXGI_FORMAT GetDXGIFormat(CImage::PixelFormat format)
+	{
+		switch (format)
+		{
+		case CImage::RGBA8Format: return DXGI_FORMAT_R8G8B8A8_UNORM;
+		case CImage::RGBA8SrgbFormat: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+		case CImage::BGRA8Format: return DXGI_FORMAT_B8G8R8A8_UNORM;
+		case CImage::BGRA8SrgbFormat: return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+		case CImage::BGRX8Format: return DXGI_FORMAT_B8G8R8X8_UNORM;
+		case CImage::BC1Format: return DXGI_FORMAT_BC1_UNORM;
+		case CImage::BC1SrgbFormat: return DXGI_FORMAT_BC1_UNORM_SRGB;
+		case CImage::BC2Format: return DXGI_FORMAT_BC2_UNORM;
+		case CImage::BC2SrgbFormat: return DXGI_FORMAT_BC2_UNORM_SRGB;
+		case CImage::BC3Format: return DXGI_FORMAT_BC3_UNORM;
+		case CImage::BC3SrgbFormat: return DXGI_FORMAT_BC3_UNORM_SRGB;
+		case CImage::BC4Format: return DXGI_FORMAT_BC4_UNORM;
+		case CImage::BC4SnormFormat: return DXGI_FORMAT_BC4_SNORM;
+		case CImage::BC5Format: return DXGI_FORMAT_BC5_UNORM;
+		case CImage::BC5SnormFormat: return DXGI_FORMAT_BC5_SNORM;
+		case CImage::BC6HUnsignedFormat: return DXGI_FORMAT_BC6H_UF16;
+		case CImage::BC6HSignedFormat: return DXGI_FORMAT_BC6H_SF16;
+		case CImage::BC7Format: return DXGI_FORMAT_BC7_UNORM;
+		case CImage::BC7SrgbFormat: return DXGI_FORMAT_BC7_UNORM_SRGB;
+		default: return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+}
 
 
 CTexture::CTexture()
 {
 	mpTexture = nullptr;
+	mpPlaceholderTexture = nullptr;
+	mpResourceCache = nullptr;
 }
 
 
@@ -15,32 +48,166 @@ CTexture::~CTexture()
 bool CTexture::Initialise(ID3D11Device * device, std::string filename)
 {
 	mFilename = filename;
-	HRESULT result;
 
 	// Load in the texture.
-	result = D3DX11CreateShaderResourceViewFromFile(device, filename.c_str(), NULL, NULL, &mpTexture, NULL);
+	if (!CreateFromFile(device, filename, &mpTexture))
+	{
+		logger->GetInstance().WriteLine("Failed to load the texture '" + filename + "'in Texture.cpp.");
+		return false;
+	}
 
-	if (FAILED(result))
+	return true;
+}
+
+/* Load in a texture, or find it in the cache if it has already been loaded. */
+bool CTexture::Initialise(ID3D11Device * device, std::string filename, CResourceCache* resourceCache)
+{
+	if (resourceCache == nullptr)
+	{
+		return Initialise(device, filename);
+	}
+
+	mFilename = filename;
+	mpTexture = resourceCache->LoadTexture(device, filename);
+
+	if (mpTexture == nullptr)
 	{
 		logger->GetInstance().WriteLine("Failed to load the texture '" + filename + "'in Texture.cpp.");
 		return false;
 	}
 
+	mpResourceCache = resourceCache;
+	return true;
+}
+
+/* Queue a texture to be loaded by the asset loader. */
+bool CTexture::InitialiseAsync(CAssetLoader* assetLoader, std::string filename)
+{
+	mFilename = filename;
+	mpPlaceholderTexture = assetLoader->GetPlaceholderTexture();
+	mLoadRequest = assetLoader->LoadTexture(filename);
+
 	return true;
 }
 
 /* Deallocates memory and cleans up after object. */
 void CTexture::Shutdown()
 {
+	// Still loading, make sure it's thrown away when it finishes.
+	CAssetLoader::Cancel(mLoadRequest);
+
 	// Let go of the sample texture.
-	mpTexture->Release();
-	mpTexture = nullptr;
+	if (mpTexture != nullptr)
+	{
+		if (mpResourceCache != nullptr)
+		{
+			mpResourceCache->ReleaseTexture(mpTexture);
+		}
+		else
+		{
+			mpTexture->Release();
+		}
+		mpTexture = nullptr;
+	}
 }
 
-/* Return the texture which is loaded. */
+/* Return the texture which is loaded, or the placeholder if it's still loading. */
 ID3D11ShaderResourceView * CTexture::GetTexture()
 {
-	return mpTexture;
+	if (mLoadRequest != nullptr)
+	{
+		const int state = mLoadRequest->state;
+
+		if (state == CAssetLoader::AssetReady)
+		{
+			// Take ownership of the texture from the request.
+			mpTexture = mLoadRequest->texture;
+			mpResourceCache = mLoadRequest->resourceCache;
+			mLoadRequest->texture = nullptr;
+			mLoadRequest.reset();
+		}
+		else if (state == CAssetLoader::AssetFailed)
+		{
+			logger->GetInstance().WriteLine("Failed to load the texture '" + mFilename + "' in Texture.cpp.");
+			mLoadRequest.reset();
+		}
+	}
+
+	return mpTexture != nullptr ? mpTexture : mpPlaceholderTexture;
+}
+
+/* Every level of the image is uploaded as it is, straight from the mapped file for DDS files.
+* @Returns bool Success */
+bool CTexture::CreateFromImage(ID3D11Device* device, CImage& image, ID3D11ShaderResourceView** texture)
+{
+	*texture = nullptr;
+
+	// Anything the engine can't read itself, such as JPEGs, is still left to D3DX.
+	if (!image.IsDecoded())
+	{
+		if (image.GetFileData() == nullptr)
+		{
+			return false;
+		}
+
+		HRESULT result = D3DX11CreateShaderResourceViewFromMemory(device, image.GetFileData(), image.GetFileSize(), NULL, NULL, texture, NULL);
+		return SUCCEEDED(result);
+	}
+
+	D3D11_TEXTURE2D_DESC textureDesc;
+	textureDesc.Width = image.GetWidth();
+	textureDesc.Height = image.GetHeight();
+	textureDesc.MipLevels = image.GetNumberOfMipLevels();
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = GetDXGIFormat(image.GetFormat());
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = 0;
+
+	D3D11_SUBRESOURCE_DATA initData[CImage::kMaxMipLevels];
+	for (unsigned int level = 0; level < image.GetNumberOfMipLevels(); level++)
+	{
+		const CImage::MipLevel& mipLevel = image.GetMipLevel(level);
+		initData[level].pSysMem = mipLevel.data;
+		initData[level].SysMemPitch = mipLevel.rowPitch;
+		initData[level].SysMemSlicePitch = mipLevel.size;
+	}
+
+	ID3D11Texture2D* texture2D = nullptr;
+	HRESULT result = device->CreateTexture2D(&textureDesc, initData, &texture2D);
+	if (FAILED(result))
+	{
+		return false;
+	}
+
+	result = device->CreateShaderResourceView(texture2D, NULL, texture);
+	texture2D->Release();
+
+	if (FAILED(result))
+	{
+		*texture = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+/* @Returns bool Success */
+bool CTexture::CreateFromFile(ID3D11Device* device, const std::string& filename, ID3D11ShaderResourceView** texture)
+{
+	CImage image;
+	if (!CTextureCooker::OpenImage(image, filename))
+	{
+		*texture = nullptr;
+		return false;
+	}
+
+	image.Decode();
+
+	return CreateFromImage(device, image, texture);
 }
 
 std::wstring CTexture::s2ws(const std::string str)
@@ -5,6 +5,8 @@
 #include <d3d11.h>
 #include <D3DX11tex.h>
 #include "PrioEngineVars.h"
+#include "AssetLoader.h"
+#include "Image.h"
 
 class CTexture
 {
@@ -15,11 +17,24 @@ public:
 	~CTexture();
 
 	bool Initialise(ID3D11Device * device, std::string filename);
+	// Share the texture with anything else which has loaded the same file through the cache.
+	bool Initialise(ID3D11Device * device, std::string filename, CResourceCache* resourceCache);
+	// Read the texture in the background, the loader's placeholder is handed out until it's ready.
+	bool InitialiseAsync(CAssetLoader* assetLoader, std::string filename);
 	void Shutdown();
 
 	ID3D11ShaderResourceView* GetTexture();
+	bool IsLoading() { return mLoadRequest != nullptr; };
+
+	// Create a texture from an image which has been read in, passing it to D3DX if it couldn't be decoded.
+	static bool CreateFromImage(ID3D11Device* device, CImage& image, ID3D11ShaderResourceView** texture);
+	static bool CreateFromFile(ID3D11Device* device, const std::string& filename, ID3D11ShaderResourceView** texture);
 private:
 	ID3D11ShaderResourceView* mpTexture;
+	ID3D11ShaderResourceView* mpPlaceholderTexture;
+	// Where the texture came from, if it's shared, so it's handed back rather than released.
+	CResourceCache* mpResourceCache;
+	CAssetLoader::AssetHandle mLoadRequest;
 	std::wstring s2ws(const std::string str);
 	std::string mFilename;
 };
@@ -0,0 +1,751 @@
+#include "TextureCooker.h"
+#include "DiskFile.h"
+#include <cstring>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TEXTURECOOKER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const char* kCookedExtension = ".cooked.dds";
+	const char* kManifestHeader = "PrioTextureManifest";
+
+	// Extensions of the image formats which will be picked up when cooking a directory.
+	const char* kSourceExtensions[] = { ".png", ".tga", ".dds" };
+
+	const unsigned int kDDSMagic = 0x20534444;
+	const unsigned int kDDSHeaderSize = 124;
+	const unsigned int kDDSPixelFormatSize = 32;
+	const unsigned int kDDSRequiredFlags = 0x1 | 0x2 | 0x4 | 0x1000;
+	const unsigned int kDDSMipMapCountFlag = 0x20000;
+	const unsigned int kDDSLinearSizeFlag = 0x80000;
+	const unsigned int kDDSFourCCFlag = 0x4;
+	const unsigned int kDDSTextureCaps = 0x1000;
+	const unsigned int kDDSComplexCaps = 0x8;
+	const unsigned int kDDSMipMapCaps = 0x400000;
+
+	// The legacy header, which D3DX and every other tool can read.
+	struct DDSHeader
+	{
+		unsigned int magic;
+		unsigned int size;
+		unsigned int flags;
+		unsigned int height;
+		unsigned int width;
+		unsigned int pitchOrLinearSize;
+		unsigned int depth;
+		unsigned int mipMapCount;
+		unsigned int reserved1[11];
+		unsigned int pixelFormatSize;
+		unsigned int pixelFormatFlags;
+		unsigned int fourCC;
+		unsigned int rgbBitCount;
+		unsigned int redMask;
+		unsigned int greenMask;
+		unsigned int blueMask;
+		unsigned int alphaMask;
+		unsigned int caps;
+		unsigned int caps2;
+		unsigned int caps3;
+		unsigned int caps4;
+		unsigned int reserved2;
+	};
+
+	unsigned int FourCC(char a, char b, char c, char d)
+	{
+		return static_cast<unsigned int>(static_cast<unsigned char>(a)) | (static_cast<unsigned int>(static_cast<unsigned char>(b)) << 8) |
+			(static_cast<unsigned int>(static_cast<unsigned char>(c)) << 16) | (static_cast<unsigned int>(static_cast<unsigned char>(d)) << 24);
+	}
+
+	std::string ToLower(const std::string& text)
+	{
+		std::string lower = text;
+		for (auto& character : lower)
+		{
+			character = static_cast<char>(tolower(static_cast<unsigned char>(character)));
+		}
+		return lower;
+	}
+
+	bool EndsWith(const std::string& text, const std::string& ending)
+	{
+		return text.size() >= ending.size() && text.compare(text.size() - ending.size(), ending.size(), ending) == 0;
+	}
+
+	bool HasSourceExtension(const std::string& filename)
+	{
+		const std::string lower = ToLower(filename);
+
+		// Never cook the output of a previous cook.
+		if (EndsWith(lower, kCookedExtension))
+		{
+			return false;
+		}
+
+		for (auto sourceExtension : kSourceExtensions)
+		{
+			if (EndsWith(lower, sourceExtension))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Goes by the name, as there's nothing in the texels themselves which gives a normal map away.
+	bool IsNormalMap(const std::string& filename)
+	{
+		const std::string lower = ToLower(filename);
+		return lower.find("normal") != std::string::npos || lower.find("_nrm") != std::string::npos;
+	}
+
+	unsigned int BlocksAcross(unsigned int size)
+	{
+		return size > 4 ? (size + 3) / 4 : 1;
+	}
+
+	unsigned int BytesPerBlock(CTextureCooker::CompressedFormat format)
+	{
+		return format == CTextureCooker::BC1Compression ? 8 : 16;
+	}
+
+	const char* FormatName(CTextureCooker::CompressedFormat format)
+	{
+		switch (format)
+		{
+		case CTextureCooker::BC1Compression: return "BC1";
+		case CTextureCooker::BC3Compression: return "BC3";
+		default: return "BC5";
+		}
+	}
+
+	unsigned short PackColour565(const unsigned char colour[4])
+	{
+		const unsigned int red = (colour[0] * 31 + 127) / 255;
+		const unsigned int green = (colour[1] * 63 + 127) / 255;
+		const unsigned int blue = (colour[2] * 31 + 127) / 255;
+		return static_cast<unsigned short>((red << 11) | (green << 5) | blue);
+	}
+
+	// Back to 8 bits a channel the same way the hardware does, by repeating the top bits into the bottom.
+	void UnpackColour565(unsigned short packed, unsigned int colour[3])
+	{
+		const unsigned int red = (packed >> 11) & 0x1F;
+		const unsigned int green = (packed >> 5) & 0x3F;
+		const unsigned int blue = packed & 0x1F;
+		colour[0] = (red << 3) | (red >> 2);
+		colour[1] = (green << 2) | (green >> 4);
+		colour[2] = (blue << 3) | (blue >> 2);
+	}
+
+	/* Finds the smallest and largest value of each channel over the 16 texels in a block. */
+	void FindColourBounds(const unsigned char* texels, unsigned char minimum[4], unsigned char maximum[4])
+	{
+#ifdef TEXTURECOOKER_USE_SSE2
+		const __m128i texels0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels));
+		const __m128i texels1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + 16));
+		const __m128i texels2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + 32));
+		const __m128i texels3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + 48));
+
+		__m128i smallest = _mm_min_epu8(_mm_min_epu8(texels0, texels1), _mm_min_epu8(texels2, texels3));
+		__m128i largest = _mm_max_epu8(_mm_max_epu8(texels0, texels1), _mm_max_epu8(texels2, texels3));
+
+		// Fold the four texels left in each register down into one.
+		smallest = _mm_min_epu8(smallest, _mm_srli_si128(smallest, 8));
+		smallest = _mm_min_epu8(smallest, _mm_srli_si128(smallest, 4));
+		largest = _mm_max_epu8(largest, _mm_srli_si128(largest, 8));
+		largest = _mm_max_epu8(largest, _mm_srli_si128(largest, 4));
+
+		const int smallestTexel = _mm_cvtsi128_si32(smallest);
+		const int largestTexel = _mm_cvtsi128_si32(largest);
+		memcpy(minimum, &smallestTexel, 4);
+		memcpy(maximum, &largestTexel, 4);
+#else
+		for (unsigned int channel = 0; channel < 4; channel++)
+		{
+			minimum[channel] = 255;
+			maximum[channel] = 0;
+		}
+
+		for (unsigned int texel = 0; texel < 16; texel++)
+		{
+			for (unsigned int channel = 0; channel < 4; channel++)
+			{
+				const unsigned char value = texels[texel * 4 + channel];
+				minimum[channel] = value < minimum[channel] ? value : minimum[channel];
+				maximum[channel] = value > maximum[channel] ? value : maximum[channel];
+			}
+		}
+#endif
+	}
+
+	/* Picks the closest of the four palette colours for every texel in a block, by squared distance over RGB.
+	* @Returns unsigned int The 2 bit indices of all 16 texels, the first texel in the lowest bits. */
+	unsigned int SelectColourIndices(const unsigned char* texels, const unsigned int palette[4])
+	{
+		unsigned int indices = 0;
+
+#ifdef TEXTURECOOKER_USE_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i colourMask = _mm_set1_epi32(0x00FFFFFF);
+
+		// Four texels at a time, each held as a 32 bit lane.
+		for (unsigned int group = 0; group < 4; group++)
+		{
+			const __m128i colours = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + group * 16)), colourMask);
+			__m128i bestDistance = _mm_set1_epi32(0x7FFFFFFF);
+			__m128i bestIndex = zero;
+
+			for (unsigned int entry = 0; entry < 4; entry++)
+			{
+				const __m128i paletteColour = _mm_set1_epi32(static_cast<int>(palette[entry]));
+				const __m128i difference = _mm_or_si128(_mm_subs_epu8(colours, paletteColour), _mm_subs_epu8(paletteColour, colours));
+
+				// Square and add pairs of channels, then add the pairs, leaving each texel's total in the even lanes.
+				const __m128i low = _mm_unpacklo_epi8(difference, zero);
+				const __m128i high = _mm_unpackhi_epi8(difference, zero);
+				__m128i squaredLow = _mm_madd_epi16(low, low);
+				__m128i squaredHigh = _mm_madd_epi16(high, high);
+				squaredLow = _mm_add_epi32(squaredLow, _mm_srli_epi64(squaredLow, 32));
+				squaredHigh = _mm_add_epi32(squaredHigh, _mm_srli_epi64(squaredHigh, 32));
+				const __m128i distance = _mm_unpacklo_epi64(_mm_shuffle_epi32(squaredLow, _MM_SHUFFLE(3, 1, 2, 0)),
+					_mm_shuffle_epi32(squaredHigh, _MM_SHUFFLE(3, 1, 2, 0)));
+
+				const __m128i closer = _mm_cmplt_epi32(distance, bestDistance);
+				bestDistance = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, bestDistance));
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(entry))), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			unsigned int lanes[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+			indices |= (lanes[0] | (lanes[1] << 2) | (lanes[2] << 4) | (lanes[3] << 6)) << (group * 8);
+		}
+#else
+		for (unsigned int texel = 0; texel < 16; texel++)
+		{
+			unsigned int bestDistance = 0xFFFFFFFF;
+			unsigned int bestIndex = 0;
+
+			for (unsigned int entry = 0; entry < 4; entry++)
+			{
+				unsigned int distance = 0;
+				for (unsigned int channel = 0; channel < 3; channel++)
+				{
+					const int difference = static_cast<int>(texels[texel * 4 + channel]) - static_cast<int>((palette[entry] >> (channel * 8)) & 0xFF);
+					distance += static_cast<unsigned int>(difference * difference);
+				}
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = entry;
+				}
+			}
+
+			indices |= bestIndex << (texel * 2);
+		}
+#endif
+
+		return indices;
+	}
+
+	/* The main diagonal of the box only suits colours whose channels rise together. Any channel which falls as the widest
+	* one rises has its ends swapped, so the endpoints lie along the colours in the block rather than across them. */
+	void SelectDiagonal(const unsigned char* texels, unsigned char minimum[4], unsigned char maximum[4])
+	{
+		unsigned int widest = 0;
+		for (unsigned int channel = 1; channel < 3; channel++)
+		{
+			if (maximum[channel] - minimum[channel] > maximum[widest] - minimum[widest])
+			{
+				widest = channel;
+			}
+		}
+
+		int centre[3];
+		for (unsigned int channel = 0; channel < 3; channel++)
+		{
+			centre[channel] = (minimum[channel] + maximum[channel]) / 2;
+		}
+
+		for (unsigned int channel = 0; channel < 3; channel++)
+		{
+			if (channel == widest)
+			{
+				continue;
+			}
+
+			int covariance = 0;
+			for (unsigned int texel = 0; texel < 16; texel++)
+			{
+				covariance += (texels[texel * 4 + widest] - centre[widest]) * (texels[texel * 4 + channel] - centre[channel]);
+			}
+			if (covariance < 0)
+			{
+				const unsigned char swap = minimum[channel];
+				minimum[channel] = maximum[channel];
+				maximum[channel] = swap;
+			}
+		}
+	}
+
+	/* Compresses the RGB of a block into 8 bytes of BC1. The endpoints are the corners of the box bounding the colours,
+	* pulled in slightly so the interpolated colours land nearer the texels rather than the extremes.
+	* Always uses the four colour mode, as alpha is stored separately or not at all. */
+	void CompressColourBlock(const unsigned char* texels, unsigned char* block)
+	{
+		unsigned char minimum[4];
+		unsigned char maximum[4];
+		FindColourBounds(texels, minimum, maximum);
+
+		for (unsigned int channel = 0; channel < 3; channel++)
+		{
+			const unsigned char inset = static_cast<unsigned char>((maximum[channel] - minimum[channel]) >> 4);
+			minimum[channel] = static_cast<unsigned char>(minimum[channel] + inset);
+			maximum[channel] = static_cast<unsigned char>(maximum[channel] - inset);
+		}
+		SelectDiagonal(texels, minimum, maximum);
+
+		unsigned short colour0 = PackColour565(maximum);
+		unsigned short colour1 = PackColour565(minimum);
+
+		// The first endpoint has to be the larger to select the four colour mode.
+		if (colour0 < colour1)
+		{
+			const unsigned short swap = colour0;
+			colour0 = colour1;
+			colour1 = swap;
+		}
+
+		unsigned int indices = 0;
+		if (colour0 != colour1)
+		{
+			unsigned int endpoint0[3];
+			unsigned int endpoint1[3];
+			UnpackColour565(colour0, endpoint0);
+			UnpackColour565(colour1, endpoint1);
+
+			unsigned int palette[4] = { 0, 0, 0, 0 };
+			for (unsigned int channel = 0; channel < 3; channel++)
+			{
+				const unsigned int shift = channel * 8;
+				palette[0] |= endpoint0[channel] << shift;
+				palette[1] |= endpoint1[channel] << shift;
+				palette[2] |= ((2 * endpoint0[channel] + endpoint1[channel]) / 3) << shift;
+				palette[3] |= ((endpoint0[channel] + 2 * endpoint1[channel]) / 3) << shift;
+			}
+
+			indices = SelectColourIndices(texels, palette);
+		}
+
+		block[0] = static_cast<unsigned char>(colour0 & 0xFF);
+		block[1] = static_cast<unsigned char>(colour0 >> 8);
+		block[2] = static_cast<unsigned char>(colour1 & 0xFF);
+		block[3] = static_cast<unsigned char>(colour1 >> 8);
+		block[4] = static_cast<unsigned char>(indices & 0xFF);
+		block[5] = static_cast<unsigned char>((indices >> 8) & 0xFF);
+		block[6] = static_cast<unsigned char>((indices >> 16) & 0xFF);
+		block[7] = static_cast<unsigned char>(indices >> 24);
+	}
+
+	/* Compresses one channel of a block into 8 bytes, the layout used for the alpha of BC3 and each channel of BC5.
+	* The endpoints are the smallest and largest values, with the six steps between them. */
+	void CompressChannelBlock(const unsigned char* texels, unsigned int channel, unsigned char* block)
+	{
+		unsigned int minimum = 255;
+		unsigned int maximum = 0;
+		for (unsigned int texel = 0; texel < 16; texel++)
+		{
+			const unsigned int value = texels[texel * 4 + channel];
+			minimum = value < minimum ? value : minimum;
+			maximum = value > maximum ? value : maximum;
+		}
+
+		unsigned long long indices = 0;
+		if (maximum > minimum)
+		{
+			const unsigned int range = maximum - minimum;
+			for (unsigned int texel = 0; texel < 16; texel++)
+			{
+				// Steps from the first endpoint, which the palette orders as 0, 2, 3, 4, 5, 6, 7 then 1 for the second.
+				const unsigned int step = ((maximum - texels[texel * 4 + channel]) * 7 + range / 2) / range;
+				const unsigned long long index = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+				indices |= index << (texel * 3);
+			}
+		}
+
+		block[0] = static_cast<unsigned char>(maximum);
+		block[1] = static_cast<unsigned char>(minimum);
+		for (unsigned int byte = 0; byte < 6; byte++)
+		{
+			block[2 + byte] = static_cast<unsigned char>((indices >> (byte * 8)) & 0xFF);
+		}
+	}
+}
+
+CTextureCooker::CTextureCooker(const std::string& manifestFile, unsigned int numberOfThreads)
+{
+	mManifestFile = manifestFile;
+	mNumberOfCooked = 0;
+	mNumberUpToDate = 0;
+
+	mpThreadPool = new CThreadPool(numberOfThreads);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpThreadPool).name());
+
+	LoadManifest();
+}
+
+
+CTextureCooker::~CTextureCooker()
+{
+	delete mpThreadPool;
+	logger->GetInstance().MemoryDeallocWriteLine(typeid(mpThreadPool).name());
+	mpThreadPool = nullptr;
+}
+
+/* Compress an image and write out its cooked copy, unless the manifest shows the same source was already cooked.
+* @Returns bool Whether there's an up to date cooked copy of the image. */
+bool CTextureCooker::Cook(const std::string& sourceFile)
+{
+	CImage image;
+	if (!image.Open(sourceFile))
+	{
+		logger->GetInstance().WriteLine("Failed to open the texture '" + sourceFile + "' to cook it.");
+		return false;
+	}
+
+	const std::string cookedFile = GetCookedFilename(sourceFile);
+	const unsigned long long sourceHash = PrioEngine::Hash::FNV1a(image.GetFileData(), image.GetFileSize());
+
+	auto found = mManifest.find(sourceFile);
+	if (found != mManifest.end() && found->second.sourceHash == sourceHash && std::ifstream(cookedFile.c_str()).good())
+	{
+		mNumberUpToDate++;
+		return true;
+	}
+
+	// Whatever was cooked before is out of date, so it mustn't be picked up in place of the source if this fails.
+	mManifest.erase(sourceFile);
+	std::remove(cookedFile.c_str());
+
+	CompressedFormat format;
+	if (!image.Decode() || !ChooseFormat(sourceFile, image, format))
+	{
+		logger->GetInstance().WriteLine("The texture '" + sourceFile + "' is already compressed or in a format which can't be cooked, it will be used as it is.");
+		return false;
+	}
+
+	std::vector<unsigned char> blocks;
+	if (!Compress(image, format, blocks) || !Write(cookedFile, image, format, blocks))
+	{
+		logger->GetInstance().WriteLine("Failed to write the cooked texture '" + cookedFile + "'.");
+		return false;
+	}
+
+	ManifestEntry entry;
+	entry.sourceHash = sourceHash;
+	entry.format = format;
+	mManifest[sourceFile] = entry;
+	mNumberOfCooked++;
+
+	size_t decodedSize = 0;
+	for (unsigned int level = 0; level < image.GetNumberOfMipLevels(); level++)
+	{
+		decodedSize += image.GetMipLevel(level).size;
+	}
+
+	logger->GetInstance().WriteLine("Cooked '" + sourceFile + "' as " + FormatName(format) + ", " + std::to_string(decodedSize / 1024) +
+		"KB down to " + std::to_string(blocks.size() / 1024) + "KB.");
+
+	return true;
+}
+
+unsigned int CTextureCooker::CookDirectory(const std::string& directory)
+{
+	const unsigned int numberCookedBefore = mNumberOfCooked;
+
+	std::vector<std::string> files;
+	if (!PrioEngine::DiskFile::FindFiles(directory, files))
+	{
+		logger->GetInstance().WriteLine("Failed to find any textures to cook in '" + directory + "'.");
+		return 0;
+	}
+
+	for (auto& file : files)
+	{
+		if (HasSourceExtension(file))
+		{
+			Cook(file);
+		}
+	}
+
+	return mNumberOfCooked - numberCookedBefore;
+}
+
+/* The manifest is plain text, a header with the version of the cooker followed by one line for each texture holding
+* the hash of its source, the format it was cooked to and its path.
+* @Returns bool Success */
+bool CTextureCooker::SaveManifest()
+{
+	std::ofstream file(mManifestFile.c_str(), std::ios::trunc);
+	if (!file.is_open())
+	{
+		logger->GetInstance().WriteLine("Failed to write the texture manifest '" + mManifestFile + "'.");
+		return false;
+	}
+
+	file << kManifestHeader << " " << kVersion << "\n";
+	for (auto& entry : mManifest)
+	{
+		file << std::hex << std::setw(16) << std::setfill('0') << entry.second.sourceHash << std::dec << " " <<
+			static_cast<unsigned int>(entry.second.format) << " " << entry.first << "\n";
+	}
+
+	return file.good();
+}
+
+std::string CTextureCooker::GetCookedFilename(const std::string& sourceFile)
+{
+	return sourceFile + kCookedExtension;
+}
+
+/* A cooked copy is only ever written by the cooker, which removes it as soon as the source has changed, so if there is one
+* it's used without checking it against the source.
+* @Returns bool Whether either file could be opened. */
+bool CTextureCooker::OpenImage(CImage& image, const std::string& sourceFile)
+{
+	return image.Open(GetCookedFilename(sourceFile)) || image.Open(sourceFile);
+}
+
+/* Read in what was cooked last time. A missing manifest, or one from another version of the cooker, just means
+* everything is cooked again.
+* @Returns bool Whether a manifest was read. */
+bool CTextureCooker::LoadManifest()
+{
+	std::ifstream file(mManifestFile.c_str());
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::string header;
+	unsigned int version = 0;
+	file >> header >> version;
+	if (header != kManifestHeader || version != kVersion)
+	{
+		logger->GetInstance().WriteLine("The texture manifest '" + mManifestFile + "' is from another version of the cooker, every texture will be cooked again.");
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream entryStream(line);
+		ManifestEntry entry;
+		unsigned int format = 0;
+		if (!(entryStream >> std::hex >> entry.sourceHash >> std::dec >> format) || format > BC5Compression)
+		{
+			continue;
+		}
+
+		// The path is the rest of the line, as it may well have spaces in.
+		std::string sourceFile;
+		std::getline(entryStream >> std::ws, sourceFile);
+		if (sourceFile.empty())
+		{
+			continue;
+		}
+
+		entry.format = static_cast<CompressedFormat>(format);
+		mManifest[sourceFile] = entry;
+	}
+
+	return true;
+}
+
+/* Compresses every level of the image, handing rows of blocks out across the thread pool.
+* @Returns bool Success */
+bool CTextureCooker::Compress(CImage& image, CompressedFormat format, std::vector<unsigned char>& output)
+{
+	struct BlockRow
+	{
+		unsigned int level;
+		unsigned int row;
+		size_t offset;
+	};
+
+	const CImage::PixelFormat pixelFormat = image.GetFormat();
+	const bool swapRedAndBlue = pixelFormat == CImage::BGRA8Format || pixelFormat == CImage::BGRX8Format;
+	const bool forceOpaque = pixelFormat == CImage::BGRX8Format;
+	const unsigned int bytesPerBlock = BytesPerBlock(format);
+
+	std::vector<BlockRow> blockRows;
+	size_t size = 0;
+	for (unsigned int level = 0; level < image.GetNumberOfMipLevels(); level++)
+	{
+		const CImage::MipLevel& mipLevel = image.GetMipLevel(level);
+		const size_t rowSize = static_cast<size_t>(BlocksAcross(mipLevel.width)) * bytesPerBlock;
+
+		for (unsigned int row = 0; row < BlocksAcross(mipLevel.height); row++)
+		{
+			BlockRow blockRow;
+			blockRow.level = level;
+			blockRow.row = row;
+			blockRow.offset = size;
+			blockRows.push_back(blockRow);
+			size += rowSize;
+		}
+	}
+
+	if (blockRows.empty())
+	{
+		return false;
+	}
+
+	output.resize(size);
+	unsigned char* destination = output.data();
+
+	mpThreadPool->ParallelFor(static_cast<unsigned int>(blockRows.size()), 4, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int index = begin; index < end; index++)
+		{
+			const BlockRow& blockRow = blockRows[index];
+			CompressBlockRow(image.GetMipLevel(blockRow.level), swapRedAndBlue, forceOpaque, format, blockRow.row, destination + blockRow.offset);
+		}
+	});
+
+	return true;
+}
+
+/* Works out which compressed format suits an image, going by its name and whether any of it is see through.
+* @Returns bool False if the image shouldn't be cooked, because it's already compressed or is sRGB. */
+bool CTextureCooker::ChooseFormat(const std::string& sourceFile, CImage& image, CompressedFormat& format)
+{
+	const CImage::PixelFormat pixelFormat = image.GetFormat();
+	if (pixelFormat != CImage::RGBA8Format && pixelFormat != CImage::BGRA8Format && pixelFormat != CImage::BGRX8Format)
+	{
+		return false;
+	}
+
+	bool opaque = true;
+	if (pixelFormat != CImage::BGRX8Format)
+	{
+		const CImage::MipLevel& topLevel = image.GetMipLevel(0);
+		for (unsigned int y = 0; y < topLevel.height && opaque; y++)
+		{
+			const unsigned char* row = topLevel.data + static_cast<size_t>(y) * topLevel.rowPitch;
+			for (unsigned int x = 0; x < topLevel.width; x++)
+			{
+				if (row[x * 4 + 3] != 0xFF)
+				{
+					opaque = false;
+					break;
+				}
+			}
+		}
+	}
+
+	if (!opaque)
+	{
+		// Includes normal maps with a height in their alpha, which need all four channels.
+		format = BC3Compression;
+	}
+	else
+	{
+		format = IsNormalMap(sourceFile) ? BC5Compression : BC1Compression;
+	}
+
+	return true;
+}
+
+/* Compresses a row of 4x4 blocks from a level. Blocks hanging over the edge of a level smaller than a block repeat the
+* last row and column of texels. */
+void CTextureCooker::CompressBlockRow(const CImage::MipLevel& level, bool swapRedAndBlue, bool forceOpaque, CompressedFormat format,
+	unsigned int blockRow, unsigned char* destination)
+{
+	const unsigned int blocksAcross = BlocksAcross(level.width);
+	const unsigned int bytesPerBlock = BytesPerBlock(format);
+
+	for (unsigned int blockColumn = 0; blockColumn < blocksAcross; blockColumn++)
+	{
+		unsigned char texels[64];
+		for (unsigned int y = 0; y < 4; y++)
+		{
+			unsigned int sourceY = blockRow * 4 + y;
+			sourceY = sourceY < level.height ? sourceY : level.height - 1;
+			const unsigned char* row = level.data + static_cast<size_t>(sourceY) * level.rowPitch;
+
+			for (unsigned int x = 0; x < 4; x++)
+			{
+				unsigned int sourceX = blockColumn * 4 + x;
+				sourceX = sourceX < level.width ? sourceX : level.width - 1;
+
+				const unsigned char* texel = row + sourceX * 4;
+				unsigned char* output = texels + (y * 4 + x) * 4;
+				output[0] = swapRedAndBlue ? texel[2] : texel[0];
+				output[1] = texel[1];
+				output[2] = swapRedAndBlue ? texel[0] : texel[2];
+				output[3] = forceOpaque ? 0xFF : texel[3];
+			}
+		}
+
+		unsigned char* block = destination + blockColumn * bytesPerBlock;
+		switch (format)
+		{
+		case BC1Compression:
+			CompressColourBlock(texels, block);
+			break;
+		case BC3Compression:
+			CompressChannelBlock(texels, 3, block);
+			CompressColourBlock(texels, block + 8);
+			break;
+		case BC5Compression:
+			CompressChannelBlock(texels, 0, block);
+			CompressChannelBlock(texels, 1, block + 8);
+			break;
+		}
+	}
+}
+
+bool CTextureCooker::Write(const std::string& cookedFile, CImage& image, CompressedFormat format, const std::vector<unsigned char>& blocks)
+{
+	DDSHeader header;
+	memset(&header, 0, sizeof(DDSHeader));
+	header.magic = kDDSMagic;
+	header.size = kDDSHeaderSize;
+	header.flags = kDDSRequiredFlags | kDDSMipMapCountFlag | kDDSLinearSizeFlag;
+	header.width = image.GetWidth();
+	header.height = image.GetHeight();
+	header.pitchOrLinearSize = BlocksAcross(header.width) * BlocksAcross(header.height) * BytesPerBlock(format);
+	header.mipMapCount = image.GetNumberOfMipLevels();
+	header.pixelFormatSize = kDDSPixelFormatSize;
+	header.pixelFormatFlags = kDDSFourCCFlag;
+	header.caps = kDDSTextureCaps | kDDSComplexCaps | kDDSMipMapCaps;
+
+	switch (format)
+	{
+	case BC1Compression:
+		header.fourCC = FourCC('D', 'X', 'T', '1');
+		break;
+	case BC3Compression:
+		header.fourCC = FourCC('D', 'X', 'T', '5');
+		break;
+	case BC5Compression:
+		header.fourCC = FourCC('A', 'T', 'I', '2');
+		break;
+	}
+
+	return PrioEngine::DiskFile::Write(cookedFile, [&header, &blocks](std::ofstream& file)
+	{
+		file.write(reinterpret_cast<const char*>(&header), sizeof(DDSHeader));
+		file.write(reinterpret_cast<const char*>(blocks.data()), blocks.size());
+	});
+}
@@ -0,0 +1,70 @@
+#ifndef TEXTURECOOKER_H
+#define TEXTURECOOKER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "PrioEngineVars.h"
+#include "Image.h"
+#include "ThreadPool.h"
+
+/* Converts source images into block compressed DDS files with a full mip chain, stored next to the source with a
+* .cooked.dds extension. Opaque images are stored as BC1 and anything with alpha as BC3. Normal maps with nothing in
+* their alpha are stored as BC5, which only keeps X and Y, so whatever samples them has to rebuild Z.
+* A manifest keeps a hash of every source cooked, so only images which have changed are cooked again. */
+class CTextureCooker
+{
+private:
+	CLogger* logger;
+public:
+	// Bump this whenever the compressor or the layout of the cooked files changes, everything will then be cooked again.
+	static const unsigned int kVersion = 1;
+
+	enum CompressedFormat
+	{
+		BC1Compression = 0,
+		BC3Compression,
+		BC5Compression
+	};
+public:
+	// Passing 0 threads uses one less than the number of hardware threads, the same as the thread pool.
+	CTextureCooker(const std::string& manifestFile, unsigned int numberOfThreads = 0);
+	~CTextureCooker();
+public:
+	// Cook an image if it has changed since it was last cooked. Returns false if it can't be cooked.
+	bool Cook(const std::string& sourceFile);
+	// Cook every image found under a directory and its sub directories. Returns how many were cooked, not counting
+	// those which were already up to date.
+	unsigned int CookDirectory(const std::string& directory);
+	// Write out the manifest, so the next run can skip everything which hasn't changed since.
+	bool SaveManifest();
+
+	unsigned int GetNumberOfCooked() { return mNumberOfCooked; };
+	unsigned int GetNumberUpToDate() { return mNumberUpToDate; };
+
+	static std::string GetCookedFilename(const std::string& sourceFile);
+	// Open the cooked copy of a texture if there is one, otherwise the source file itself.
+	static bool OpenImage(CImage& image, const std::string& sourceFile);
+private:
+	struct ManifestEntry
+	{
+		unsigned long long sourceHash;
+		CompressedFormat format;
+	};
+
+	bool LoadManifest();
+	bool Compress(CImage& image, CompressedFormat format, std::vector<unsigned char>& output);
+	static bool ChooseFormat(const std::string& sourceFile, CImage& image, CompressedFormat& format);
+	static void CompressBlockRow(const CImage::MipLevel& level, bool swapRedAndBlue, bool forceOpaque, CompressedFormat format,
+		unsigned int blockRow, unsigned char* destination);
+	static bool Write(const std::string& cookedFile, CImage& image, CompressedFormat format, const std::vector<unsigned char>& blocks);
+private:
+	std::string mManifestFile;
+	std::unordered_map<std::string, ManifestEntry> mManifest;
+	CThreadPool* mpThreadPool;
+
+	unsigned int mNumberOfCooked;
+	unsigned int mNumberUpToDate;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "TextureShader.h"
+#include "StateCache.h"
 
 CTextureShader::CTextureShader()
 {
@@ -68,7 +69,7 @@ bool CTextureShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "TextureVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "TextureVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -85,7 +86,7 @@ bool CTextureShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "TexturePixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "TexturePixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -257,7 +258,7 @@ bool CTextureShader::SetShaderParameters(ID3D11DeviceContext * deviceContext, ID
 	}
 
 	// Set the shader texture resource in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &texture);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &texture);
 
 	return true;
 }
@@ -265,14 +266,14 @@ bool CTextureShader::SetShaderParameters(ID3D11DeviceContext * deviceContext, ID
 void CTextureShader::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout
-	deviceContext->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpPixelShader, NULL, 0);
 	
 	// Set sample state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpSampleState);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpSampleState);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -0,0 +1,133 @@
+#include "ThreadPool.h"
+
+CThreadPool::CThreadPool(unsigned int numberOfThreads)
+{
+	mStopping = false;
+
+	if (numberOfThreads == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		numberOfThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < numberOfThreads; i++)
+	{
+		mThreads.push_back(std::thread(&CThreadPool::WorkerLoop, this));
+	}
+
+	logger->GetInstance().WriteLine("Created thread pool with " + std::to_string(numberOfThreads) + " worker threads.");
+}
+
+
+CThreadPool::~CThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mCondition.notify_all();
+
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+	mThreads.clear();
+}
+
+void CThreadPool::Push(std::function<void()> task)
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mTasks.push(task);
+	}
+	mCondition.notify_one();
+}
+
+void CThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+
+			// Finish off any outstanding work before stopping.
+			if (mStopping && mTasks.empty())
+			{
+				return;
+			}
+
+			task = mTasks.front();
+			mTasks.pop();
+		}
+
+		task();
+	}
+}
+
+void CThreadPool::ParallelFor(unsigned int count, unsigned int chunkSize, const std::function<void(unsigned int begin, unsigned int end)>& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (chunkSize == 0)
+	{
+		chunkSize = 1;
+	}
+
+	const unsigned int numberOfChunks = (count + chunkSize - 1) / chunkSize;
+
+	// Not worth waking up any workers for a single chunk.
+	if (numberOfChunks == 1 || mThreads.empty())
+	{
+		function(0, count);
+		return;
+	}
+
+	// Shared between the caller and the helpers, helpers may outlive this call if they never got to run.
+	struct SharedState
+	{
+		std::atomic<unsigned int> nextChunk;
+		std::atomic<unsigned int> chunksCompleted;
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+	std::shared_ptr<SharedState> state = std::make_shared<SharedState>();
+	state->nextChunk = 0;
+	state->chunksCompleted = 0;
+
+	// Each participant keeps grabbing the next chunk until there are none left.
+	auto processChunks = [state, count, chunkSize, numberOfChunks, &function]()
+	{
+		unsigned int chunk;
+		while ((chunk = state->nextChunk.fetch_add(1)) < numberOfChunks)
+		{
+			unsigned int begin = chunk * chunkSize;
+			unsigned int end = begin + chunkSize < count ? begin + chunkSize : count;
+			function(begin, end);
+
+			if (state->chunksCompleted.fetch_add(1) + 1 == numberOfChunks)
+			{
+				std::unique_lock<std::mutex> lock(state->mutex);
+				state->finished.notify_all();
+			}
+		}
+	};
+
+	unsigned int numberOfHelpers = numberOfChunks - 1 < GetNumberOfThreads() ? numberOfChunks - 1 : GetNumberOfThreads();
+	for (unsigned int i = 0; i < numberOfHelpers; i++)
+	{
+		// Helpers only touch the function while chunks remain, which is never after this call returns.
+		Push(processChunks);
+	}
+
+	// The calling thread does its share too, this also means we can't deadlock if all workers are busy.
+	processChunks();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state, numberOfChunks]() { return state->chunksCompleted.load() == numberOfChunks; });
+}
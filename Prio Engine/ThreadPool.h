@@ -0,0 +1,60 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <atomic>
+#include "PrioEngineVars.h"
+
+/* A fixed set of worker threads which sit idle until work is handed to them.
+* Threads are created once on construction rather than each time some work needs doing. */
+class CThreadPool
+{
+private:
+	CLogger* logger;
+public:
+	// Passing 0 will create one less worker than the number of hardware threads, leaving one for the caller.
+	CThreadPool(unsigned int numberOfThreads = 0);
+	~CThreadPool();
+public:
+	// Queue a single task to be run on a worker, the returned future can be waited on for the result.
+	template<typename Function>
+	std::future<typename std::result_of<Function()>::type> Enqueue(Function task);
+
+	// Split the range [0, count) into chunks and process them across the workers.
+	// The calling thread also processes chunks, and does not return until every chunk has been completed.
+	void ParallelFor(unsigned int count, unsigned int chunkSize, const std::function<void(unsigned int begin, unsigned int end)>& function);
+
+	unsigned int GetNumberOfThreads() { return static_cast<unsigned int>(mThreads.size()); };
+private:
+	void WorkerLoop();
+	void Push(std::function<void()> task);
+private:
+	std::vector<std::thread> mThreads;
+	std::queue<std::function<void()>> mTasks;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mStopping;
+};
+
+template<typename Function>
+std::future<typename std::result_of<Function()>::type> CThreadPool::Enqueue(Function task)
+{
+	typedef typename std::result_of<Function()>::type ReturnType;
+
+	// Packaged tasks can't be copied, so share it to allow it to be stored in a std::function.
+	std::shared_ptr<std::packaged_task<ReturnType()>> packagedTask = std::make_shared<std::packaged_task<ReturnType()>>(task);
+	std::future<ReturnType> result = packagedTask->get_future();
+
+	Push([packagedTask]() { (*packagedTask)(); });
+
+	return result;
+}
+
+#endif
@@ -0,0 +1,431 @@
+#include "TransformSystem.h"
+#include "ModelControl.h"
+#include <algorithm>
+#include <unordered_map>
+#include <xmmintrin.h>
+
+const unsigned int CTransformSystem::kInvalidIndex;
+const unsigned int CTransformSystem::kBatchSize;
+
+CTransformSystem::CTransformSystem()
+{
+	mHierarchyDirty = false;
+	mNumberOfUpdatedNodes = 0;
+	mNumberOfMarkedNodes = 0;
+}
+
+
+CTransformSystem::~CTransformSystem()
+{
+	// Release any models which are still pointing at us.
+	for (auto node : mpNodes)
+	{
+		if (node != nullptr)
+		{
+			node->mpTransformSystem = nullptr;
+			node->mTransformIndex = kInvalidIndex;
+		}
+	}
+}
+
+/* Start tracking the transform of a model. New nodes are appended, they will be resorted if they have a parent. */
+void CTransformSystem::Register(CModelControl * node)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (node == nullptr || node->mpTransformSystem != nullptr)
+	{
+		return;
+	}
+
+	unsigned int index = static_cast<unsigned int>(mpNodes.size());
+
+	mpNodes.push_back(node);
+	mParents.push_back(kInvalidIndex);
+	mPosX.push_back(0.0f);
+	mPosY.push_back(0.0f);
+	mPosZ.push_back(0.0f);
+	mRotX.push_back(0.0f);
+	mRotY.push_back(0.0f);
+	mRotZ.push_back(0.0f);
+	mScaleX.push_back(1.0f);
+	mScaleY.push_back(1.0f);
+	mScaleZ.push_back(1.0f);
+	mWorldPosX.push_back(0.0f);
+	mWorldPosY.push_back(0.0f);
+	mWorldPosZ.push_back(0.0f);
+
+	D3DXMATRIX identity;
+	D3DXMatrixIdentity(&identity);
+	mWorldMatrices.push_back(identity);
+
+	mDirtyFlags.push_back(1);
+	mHasChildren.push_back(0);
+	mDirtyList.push_back(index);
+
+	node->mpTransformSystem = this;
+	node->mTransformIndex = index;
+
+	// A node which already has a parent needs to be placed after it.
+	if (node->mpParent != nullptr)
+	{
+		mHierarchyDirty = true;
+	}
+}
+
+/* Stop tracking a model. The slot is left empty until the hierarchy is next rebuilt. */
+void CTransformSystem::Unregister(CModelControl * node)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (node == nullptr || node->mpTransformSystem != this)
+	{
+		return;
+	}
+
+	mpNodes[node->mTransformIndex] = nullptr;
+	node->mpTransformSystem = nullptr;
+	node->mTransformIndex = kInvalidIndex;
+
+	mHierarchyDirty = true;
+}
+
+/* Queue a node to have its world matrix rebuilt on the next update. The flag lives on the model rather than in our arrays,
+* which are only touched under the lock, and only the first change since the update last looked is counted. */
+void CTransformSystem::MarkDirty(CModelControl * node)
+{
+	if (!node->mTransformDirty.exchange(true, std::memory_order_acq_rel))
+	{
+		mNumberOfMarkedNodes.fetch_add(1, std::memory_order_release);
+	}
+}
+
+void CTransformSystem::MarkHierarchyDirty()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mHierarchyDirty = true;
+}
+
+/* Rebuild the world matrices for any nodes which have changed since the last update.
+* If nothing has moved this does no matrix work at all. */
+void CTransformSystem::Update()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mUpdateList.clear();
+
+	/* Pick up the models flagged since the last update. The count is cleared before looking, so a model flagged while we
+	* look is either found now or counted again for the next update, never missed. */
+	if (mNumberOfMarkedNodes.exchange(0, std::memory_order_acquire) != 0)
+	{
+		for (unsigned int i = 0; i < mpNodes.size(); i++)
+		{
+			if (mpNodes[i] != nullptr && mpNodes[i]->mTransformDirty.exchange(false, std::memory_order_acquire) && !mDirtyFlags[i])
+			{
+				mDirtyFlags[i] = 1;
+				mDirtyList.push_back(i);
+			}
+		}
+	}
+
+	if (mHierarchyDirty)
+	{
+		// Resorting touches every node, so everything is rebuilt.
+		RebuildHierarchy();
+
+		for (unsigned int i = 0; i < mpNodes.size(); i++)
+		{
+			GatherLocalTransform(i);
+			mUpdateList.push_back(i);
+		}
+	}
+	else
+	{
+		// Nodes which follow a parent we don't track have to be refreshed every frame.
+		for (auto index : mExternalParentNodes)
+		{
+			if (!mDirtyFlags[index])
+			{
+				mDirtyFlags[index] = 1;
+				mDirtyList.push_back(index);
+			}
+		}
+
+		if (mDirtyList.empty())
+		{
+			mNumberOfUpdatedNodes = 0;
+			return;
+		}
+
+		bool parentChanged = false;
+
+		// Copy the new local transforms out of the models which changed.
+		for (auto index : mDirtyList)
+		{
+			GatherLocalTransform(index);
+
+			if (mHasChildren[index])
+			{
+				parentChanged = true;
+			}
+		}
+
+		if (parentChanged)
+		{
+			// Parents are sorted before children, so a single forward pass pushes the dirty flag down the hierarchy.
+			for (unsigned int i = 0; i < mpNodes.size(); i++)
+			{
+				if (!mDirtyFlags[i] && mParents[i] != kInvalidIndex && mDirtyFlags[mParents[i]])
+				{
+					mDirtyFlags[i] = 1;
+				}
+
+				if (mDirtyFlags[i])
+				{
+					mUpdateList.push_back(i);
+				}
+			}
+		}
+		else
+		{
+			mUpdateList = mDirtyList;
+			std::sort(mUpdateList.begin(), mUpdateList.end());
+		}
+	}
+
+	// Rotation and scale don't depend on the parent, so these can be done in any order in batches.
+	for (unsigned int i = 0; i < mUpdateList.size(); i += kBatchSize)
+	{
+		unsigned int count = std::min(kBatchSize, static_cast<unsigned int>(mUpdateList.size()) - i);
+		ComputeLocalMatrices(&mUpdateList[i], count);
+	}
+
+	// Translation inherits the parent position, the update list is sorted so parents are always resolved first.
+	for (auto index : mUpdateList)
+	{
+		ComputeWorldPosition(index);
+		mDirtyFlags[index] = 0;
+	}
+
+	mNumberOfUpdatedNodes = static_cast<unsigned int>(mUpdateList.size());
+	mDirtyList.clear();
+}
+
+/* Remove empty slots and sort nodes so that parents always come before their children. */
+void CTransformSystem::RebuildHierarchy()
+{
+	std::vector<CModelControl*> liveNodes;
+	std::unordered_map<CModelControl*, unsigned int> depths;
+
+	for (auto node : mpNodes)
+	{
+		if (node != nullptr)
+		{
+			liveNodes.push_back(node);
+		}
+	}
+
+	// Find how many tracked ancestors each node has.
+	for (auto node : liveNodes)
+	{
+		unsigned int depth = 0;
+		CModelControl* parent = node->mpParent;
+
+		while (parent != nullptr && parent->mpTransformSystem == this)
+		{
+			depth++;
+			parent = parent->mpParent;
+		}
+
+		depths[node] = depth;
+	}
+
+	std::stable_sort(liveNodes.begin(), liveNodes.end(), [&depths](CModelControl* a, CModelControl* b)
+	{
+		return depths[a] < depths[b];
+	});
+
+	unsigned int numberOfNodes = static_cast<unsigned int>(liveNodes.size());
+
+	mpNodes = liveNodes;
+	mParents.assign(numberOfNodes, kInvalidIndex);
+	mPosX.resize(numberOfNodes);
+	mPosY.resize(numberOfNodes);
+	mPosZ.resize(numberOfNodes);
+	mRotX.resize(numberOfNodes);
+	mRotY.resize(numberOfNodes);
+	mRotZ.resize(numberOfNodes);
+	mScaleX.resize(numberOfNodes);
+	mScaleY.resize(numberOfNodes);
+	mScaleZ.resize(numberOfNodes);
+	mWorldPosX.resize(numberOfNodes);
+	mWorldPosY.resize(numberOfNodes);
+	mWorldPosZ.resize(numberOfNodes);
+	mWorldMatrices.resize(numberOfNodes);
+	mDirtyFlags.assign(numberOfNodes, 1);
+	mHasChildren.assign(numberOfNodes, 0);
+	mExternalParentNodes.clear();
+	mDirtyList.clear();
+
+	for (unsigned int i = 0; i < numberOfNodes; i++)
+	{
+		mpNodes[i]->mTransformIndex = i;
+	}
+
+	for (unsigned int i = 0; i < numberOfNodes; i++)
+	{
+		CModelControl* parent = mpNodes[i]->mpParent;
+
+		if (parent == nullptr)
+		{
+			continue;
+		}
+
+		if (parent->mpTransformSystem == this)
+		{
+			mParents[i] = parent->mTransformIndex;
+			mHasChildren[parent->mTransformIndex] = 1;
+		}
+		else
+		{
+			mExternalParentNodes.push_back(i);
+		}
+	}
+
+	mHierarchyDirty = false;
+}
+
+/* Copy the local transform out of the owning model into our arrays. */
+void CTransformSystem::GatherLocalTransform(unsigned int index)
+{
+	CModelControl* node = mpNodes[index];
+
+	// Slot was emptied since it was flagged.
+	if (node == nullptr)
+	{
+		return;
+	}
+
+	mPosX[index] = node->mPosition.x;
+	mPosY[index] = node->mPosition.y;
+	mPosZ[index] = node->mPosition.z;
+
+	// Convert to radians now rather than once per lane later.
+	mRotX[index] = (node->mRotation.x * PrioEngine::kPi) / 180.0f;
+	mRotY[index] = (node->mRotation.y * PrioEngine::kPi) / 180.0f;
+	mRotZ[index] = (node->mRotation.z * PrioEngine::kPi) / 180.0f;
+
+	mScaleX[index] = node->mScale.x;
+	mScaleY[index] = node->mScale.y;
+	mScaleZ[index] = node->mScale.z;
+}
+
+/* Build scale * rotX * rotY * rotZ for up to four nodes at once.
+* The rows are computed with one lane per node and then transposed out into each world matrix. */
+void CTransformSystem::ComputeLocalMatrices(const unsigned int * indices, unsigned int count)
+{
+	float sinX[kBatchSize], cosX[kBatchSize];
+	float sinY[kBatchSize], cosY[kBatchSize];
+	float sinZ[kBatchSize], cosZ[kBatchSize];
+	float scaleX[kBatchSize], scaleY[kBatchSize], scaleZ[kBatchSize];
+
+	for (unsigned int lane = 0; lane < kBatchSize; lane++)
+	{
+		// Pad a partial batch by repeating the last node, the result for those lanes is thrown away.
+		unsigned int index = indices[std::min(lane, count - 1)];
+
+		sinX[lane] = sinf(mRotX[index]);
+		cosX[lane] = cosf(mRotX[index]);
+		sinY[lane] = sinf(mRotY[index]);
+		cosY[lane] = cosf(mRotY[index]);
+		sinZ[lane] = sinf(mRotZ[index]);
+		cosZ[lane] = cosf(mRotZ[index]);
+		scaleX[lane] = mScaleX[index];
+		scaleY[lane] = mScaleY[index];
+		scaleZ[lane] = mScaleZ[index];
+	}
+
+	const __m128 sa = _mm_loadu_ps(sinX);
+	const __m128 ca = _mm_loadu_ps(cosX);
+	const __m128 sb = _mm_loadu_ps(sinY);
+	const __m128 cb = _mm_loadu_ps(cosY);
+	const __m128 sg = _mm_loadu_ps(sinZ);
+	const __m128 cg = _mm_loadu_ps(cosZ);
+	const __m128 sx = _mm_loadu_ps(scaleX);
+	const __m128 sy = _mm_loadu_ps(scaleY);
+	const __m128 sz = _mm_loadu_ps(scaleZ);
+	const __m128 zero = _mm_setzero_ps();
+
+	const __m128 sasb = _mm_mul_ps(sa, sb);
+	const __m128 casb = _mm_mul_ps(ca, sb);
+
+	// Row 0: sx * [cb*cg, cb*sg, -sb, 0]
+	__m128 m11 = _mm_mul_ps(sx, _mm_mul_ps(cb, cg));
+	__m128 m12 = _mm_mul_ps(sx, _mm_mul_ps(cb, sg));
+	__m128 m13 = _mm_mul_ps(sx, _mm_sub_ps(zero, sb));
+	__m128 m14 = zero;
+
+	// Row 1: sy * [sa*sb*cg - ca*sg, sa*sb*sg + ca*cg, sa*cb, 0]
+	__m128 m21 = _mm_mul_ps(sy, _mm_sub_ps(_mm_mul_ps(sasb, cg), _mm_mul_ps(ca, sg)));
+	__m128 m22 = _mm_mul_ps(sy, _mm_add_ps(_mm_mul_ps(sasb, sg), _mm_mul_ps(ca, cg)));
+	__m128 m23 = _mm_mul_ps(sy, _mm_mul_ps(sa, cb));
+	__m128 m24 = zero;
+
+	// Row 2: sz * [ca*sb*cg + sa*sg, ca*sb*sg - sa*cg, ca*cb, 0]
+	__m128 m31 = _mm_mul_ps(sz, _mm_add_ps(_mm_mul_ps(casb, cg), _mm_mul_ps(sa, sg)));
+	__m128 m32 = _mm_mul_ps(sz, _mm_sub_ps(_mm_mul_ps(casb, sg), _mm_mul_ps(sa, cg)));
+	__m128 m33 = _mm_mul_ps(sz, _mm_mul_ps(ca, cb));
+	__m128 m34 = zero;
+
+	// Turn the lanes back into one row per node.
+	_MM_TRANSPOSE4_PS(m11, m12, m13, m14);
+	_MM_TRANSPOSE4_PS(m21, m22, m23, m24);
+	_MM_TRANSPOSE4_PS(m31, m32, m33, m34);
+
+	const __m128 row0[kBatchSize] = { m11, m12, m13, m14 };
+	const __m128 row1[kBatchSize] = { m21, m22, m23, m24 };
+	const __m128 row2[kBatchSize] = { m31, m32, m33, m34 };
+
+	for (unsigned int lane = 0; lane < count; lane++)
+	{
+		D3DXMATRIX& world = mWorldMatrices[indices[lane]];
+
+		_mm_storeu_ps(&world._11, row0[lane]);
+		_mm_storeu_ps(&world._21, row1[lane]);
+		_mm_storeu_ps(&world._31, row2[lane]);
+	}
+}
+
+/* Models only inherit the position of their parent, so the world translation is the local position plus the parents world position. */
+void CTransformSystem::ComputeWorldPosition(unsigned int index)
+{
+	float x = mPosX[index];
+	float y = mPosY[index];
+	float z = mPosZ[index];
+
+	if (mParents[index] != kInvalidIndex)
+	{
+		unsigned int parent = mParents[index];
+		x += mWorldPosX[parent];
+		y += mWorldPosY[parent];
+		z += mWorldPosZ[parent];
+	}
+	else if (mpNodes[index] != nullptr && mpNodes[index]->mpParent != nullptr)
+	{
+		// Parent isn't tracked by us, ask it directly.
+		D3DXVECTOR3 parentPos = mpNodes[index]->mpParent->GetPos();
+		x += parentPos.x;
+		y += parentPos.y;
+		z += parentPos.z;
+	}
+
+	mWorldPosX[index] = x;
+	mWorldPosY[index] = y;
+	mWorldPosZ[index] = z;
+
+	D3DXMATRIX& world = mWorldMatrices[index];
+	world._41 = x;
+	world._42 = y;
+	world._43 = z;
+	world._44 = 1.0f;
+}
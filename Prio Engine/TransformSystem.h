@@ -0,0 +1,89 @@
+#ifndef TRANSFORMSYSTEM_H
+#define TRANSFORMSYSTEM_H
+
+#include <D3DX10math.h>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include "PrioEngineVars.h"
+
+class CModelControl;
+
+/* Keeps the transforms of every registered model in flat structure of arrays storage.
+* Nodes are kept sorted so that a parent always comes before its children, and only nodes which
+* have been flagged as dirty since the last update have their world matrices rebuilt. */
+class CTransformSystem
+{
+private:
+	CLogger* logger;
+public:
+	static const unsigned int kInvalidIndex = 0xFFFFFFFF;
+	// How many nodes are processed by a single SIMD batch.
+	static const unsigned int kBatchSize = 4;
+public:
+	CTransformSystem();
+	~CTransformSystem();
+public:
+	// Start tracking the transform of a model, from now on the world matrix will be supplied by this system.
+	void Register(CModelControl* node);
+	// Stop tracking the transform of a model, should be called before the model is deallocated.
+	void Unregister(CModelControl* node);
+	/* Flag a node as changed so that it's world matrix is rebuilt on the next update. Takes no lock, so models can be moved
+	* from any thread, even while another is registering models or running the update. */
+	void MarkDirty(CModelControl* node);
+	// Flag that parents have been attached or detached so nodes need to be resorted.
+	void MarkHierarchyDirty();
+	// Rebuild the world matrices of any nodes which have changed. Should be called once per frame.
+	void Update();
+public:
+	const D3DXMATRIX& GetWorldMatrix(unsigned int index) { return mWorldMatrices[index]; };
+	D3DXVECTOR3 GetWorldPosition(unsigned int index) { return D3DXVECTOR3(mWorldPosX[index], mWorldPosY[index], mWorldPosZ[index]); };
+	unsigned int GetNumberOfNodes() { return static_cast<unsigned int>(mpNodes.size()); };
+	unsigned int GetNumberOfUpdatedNodes() { return mNumberOfUpdatedNodes; };
+private:
+	void RebuildHierarchy();
+	void GatherLocalTransform(unsigned int index);
+	void ComputeLocalMatrices(const unsigned int* indices, unsigned int count);
+	void ComputeWorldPosition(unsigned int index);
+private:
+	// The model which owns each node.
+	std::vector<CModelControl*> mpNodes;
+	// Index of the parent of each node, parents always have a lower index than their children.
+	std::vector<unsigned int> mParents;
+
+	// Local transform, copied from the owning model when it has been flagged as dirty.
+	std::vector<float> mPosX;
+	std::vector<float> mPosY;
+	std::vector<float> mPosZ;
+	std::vector<float> mRotX;
+	std::vector<float> mRotY;
+	std::vector<float> mRotZ;
+	std::vector<float> mScaleX;
+	std::vector<float> mScaleY;
+	std::vector<float> mScaleZ;
+
+	// World transform output.
+	std::vector<float> mWorldPosX;
+	std::vector<float> mWorldPosY;
+	std::vector<float> mWorldPosZ;
+	std::vector<D3DXMATRIX> mWorldMatrices;
+
+	std::vector<unsigned char> mDirtyFlags;
+	std::vector<unsigned char> mHasChildren;
+
+	// Nodes which have been flagged dirty since the last update.
+	std::vector<unsigned int> mDirtyList;
+	// Nodes which will have their matrices rebuilt this update.
+	std::vector<unsigned int> mUpdateList;
+	// Nodes whose parent is not tracked by this system, these are refreshed every update.
+	std::vector<unsigned int> mExternalParentNodes;
+
+	// How many models have set their dirty flag since the last update looked, so a frame where nothing moved skips the search.
+	std::atomic<unsigned int> mNumberOfMarkedNodes;
+
+	bool mHierarchyDirty;
+	unsigned int mNumberOfUpdatedNodes;
+	std::mutex mMutex;
+};
+
+#endif
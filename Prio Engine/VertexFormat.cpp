@@ -0,0 +1,152 @@
+#include "VertexFormat.h"
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+
+namespace PrioEngine
+{
+	namespace Quantisation
+	{
+		unsigned short FloatToHalf(float value)
+		{
+			unsigned int bits;
+			memcpy(&bits, &value, sizeof(bits));
+
+			const unsigned short sign = static_cast<unsigned short>((bits >> 16) & 0x8000);
+			const unsigned int floatExponent = (bits >> 23) & 0xFF;
+			unsigned int mantissa = bits & 0x7FFFFF;
+
+			// Infinity and NaN stay as they are.
+			if (floatExponent == 0xFF)
+			{
+				return sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0);
+			}
+
+			const int exponent = static_cast<int>(floatExponent) - 127 + 15;
+
+			// Too large to represent, clamp to infinity.
+			if (exponent >= 31)
+			{
+				return sign | 0x7C00;
+			}
+
+			// Too small for a normal half, store as a denormal or flush to zero.
+			if (exponent <= 0)
+			{
+				if (exponent < -10)
+				{
+					return sign;
+				}
+
+				mantissa |= 0x800000;
+				const unsigned int shift = static_cast<unsigned int>(14 - exponent);
+				unsigned short half = static_cast<unsigned short>(mantissa >> shift);
+				if ((mantissa >> (shift - 1)) & 1)
+				{
+					half++;
+				}
+				return sign | half;
+			}
+
+			unsigned short half = static_cast<unsigned short>(sign | (exponent << 10) | (mantissa >> 13));
+			// Round to nearest, a carry out of the mantissa correctly bumps the exponent.
+			if (mantissa & 0x1000)
+			{
+				half++;
+			}
+			return half;
+		}
+
+		short FloatToSnorm16(float value)
+		{
+			if (value > 1.0f)
+			{
+				value = 1.0f;
+			}
+			else if (value < -1.0f)
+			{
+				value = -1.0f;
+			}
+
+			// Casting truncates towards zero, so offsetting by half first rounds to nearest.
+			return static_cast<short>(value >= 0.0f ? value * 32767.0f + 0.5f : value * 32767.0f - 0.5f);
+		}
+
+		void EncodeOctahedralNormal(const float normal[3], short encoded[2])
+		{
+			const float length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+			if (length <= FLT_EPSILON)
+			{
+				// Degenerate normal, point it straight along z.
+				encoded[0] = 0;
+				encoded[1] = 0;
+				return;
+			}
+
+			float x = normal[0] / length;
+			float y = normal[1] / length;
+
+			// The lower half of the octahedron is folded out over the corners of the upper half.
+			if (normal[2] < 0.0f)
+			{
+				const float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+				const float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+				x = foldedX;
+				y = foldedY;
+			}
+
+			encoded[0] = FloatToSnorm16(x);
+			encoded[1] = FloatToSnorm16(y);
+		}
+
+		void CalculatePositionQuantisation(const float* positions, unsigned int stride, unsigned int count, D3DXVECTOR3& centre, float& scale, D3DXMATRIX& dequantiseMatrix)
+		{
+			D3DXVECTOR3 minBounds = { FLT_MAX, FLT_MAX, FLT_MAX };
+			D3DXVECTOR3 maxBounds = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+			const unsigned char* data = reinterpret_cast<const unsigned char*>(positions);
+			for (unsigned int vertex = 0; vertex < count; vertex++)
+			{
+				const float* position = reinterpret_cast<const float*>(data + vertex * stride);
+				minBounds.x = position[0] < minBounds.x ? position[0] : minBounds.x;
+				minBounds.y = position[1] < minBounds.y ? position[1] : minBounds.y;
+				minBounds.z = position[2] < minBounds.z ? position[2] : minBounds.z;
+				maxBounds.x = position[0] > maxBounds.x ? position[0] : maxBounds.x;
+				maxBounds.y = position[1] > maxBounds.y ? position[1] : maxBounds.y;
+				maxBounds.z = position[2] > maxBounds.z ? position[2] : maxBounds.z;
+			}
+
+			if (count == 0)
+			{
+				minBounds = { 0.0f, 0.0f, 0.0f };
+				maxBounds = { 0.0f, 0.0f, 0.0f };
+			}
+
+			centre = (minBounds + maxBounds) * 0.5f;
+
+			scale = (maxBounds.x - minBounds.x) * 0.5f;
+			scale = (maxBounds.y - minBounds.y) * 0.5f > scale ? (maxBounds.y - minBounds.y) * 0.5f : scale;
+			scale = (maxBounds.z - minBounds.z) * 0.5f > scale ? (maxBounds.z - minBounds.z) * 0.5f : scale;
+			if (scale <= FLT_EPSILON)
+			{
+				scale = 1.0f;
+			}
+
+			// Row vectors, so the scale happens first then the translation.
+			D3DXMATRIX scaleMatrix;
+			D3DXMATRIX translationMatrix;
+			D3DXMatrixScaling(&scaleMatrix, scale, scale, scale);
+			D3DXMatrixTranslation(&translationMatrix, centre.x, centre.y, centre.z);
+			dequantiseMatrix = scaleMatrix * translationMatrix;
+		}
+
+		void QuantisePosition(const float position[3], const D3DXVECTOR3& centre, float scale, short quantised[4])
+		{
+			quantised[0] = FloatToSnorm16((position[0] - centre.x) / scale);
+			quantised[1] = FloatToSnorm16((position[1] - centre.y) / scale);
+			quantised[2] = FloatToSnorm16((position[2] - centre.z) / scale);
+			// Decodes to 1, the shaders expect a w of 1 for positions.
+			quantised[3] = 32767;
+		}
+	}
+}
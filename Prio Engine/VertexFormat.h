@@ -0,0 +1,68 @@
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+
+#include <d3d11.h>
+#include <d3dx10math.h>
+#include "PrioEngineVars.h"
+
+// How the vertices in a buffer are stored, shaders which draw meshes pick their input layout to match.
+enum VertexFormat
+{
+	// Full precision float3 position, float2 uv and float3 normal.
+	FloatVertexFormat = 0,
+	// Packed down to 16 bytes, see QuantisedVertexType.
+	QuantisedVertexFormat
+};
+
+/* A vertex squeezed down to half the size of the float version.
+* The position is stored relative to the centre of the mesh bounds as snorm16, scaled by the largest half extent,
+* so it can be decoded by the world matrix. The uv is stored as half floats, and the normal is octahedral encoded as snorm16. */
+struct QuantisedVertexType
+{
+	short position[4];
+	unsigned short uv[2];
+	short normal[2];
+};
+
+// Input layout matching QuantisedVertexType, the shaders decode the octahedral normal themselves.
+const D3D11_INPUT_ELEMENT_DESC kQuantisedVertexLayout[] =
+{
+	{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+};
+const unsigned int kNumberOfQuantisedVertexElements = sizeof(kQuantisedVertexLayout) / sizeof(kQuantisedVertexLayout[0]);
+
+// Largest vertex count which can still be drawn with 16 bit indices.
+const unsigned int kMaxVerticesFor16BitIndices = 0xFFFF;
+
+/* Describes how the vertex and index buffers of a submesh are laid out, and how to get the original positions back. */
+struct VertexLayout
+{
+	VertexFormat vertexFormat;
+	unsigned int vertexStride;
+	DXGI_FORMAT indexFormat;
+	unsigned int indexStride;
+	// Scale and translation from the quantised range back into model space, applied before the world matrix.
+	D3DXMATRIX dequantiseMatrix;
+};
+
+namespace PrioEngine
+{
+	namespace Quantisation
+	{
+		// Convert to an IEEE half float, rounding to nearest.
+		unsigned short FloatToHalf(float value);
+		// Convert a value in the range -1 to 1 to snorm16.
+		short FloatToSnorm16(float value);
+		// Fold a unit normal onto an octahedron, returned as two snorm16 values.
+		void EncodeOctahedralNormal(const float normal[3], short encoded[2]);
+
+		/* Works out the centre and scale used to quantise a set of positions, and the matrix which undoes it.
+		* A single scale is used for all three axes, so normals transformed by the world matrix only need renormalising. */
+		void CalculatePositionQuantisation(const float* positions, unsigned int stride, unsigned int count, D3DXVECTOR3& centre, float& scale, D3DXMATRIX& dequantiseMatrix);
+		void QuantisePosition(const float position[3], const D3DXVECTOR3& centre, float scale, short quantised[4]);
+	}
+}
+
+#endif
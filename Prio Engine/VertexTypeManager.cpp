@@ -1,4 +1,5 @@
 #include "VertexTypeManager.h"
+#include "StateCache.h"
 
 
 CVertexManager::CVertexManager(PrioEngine::ShaderType vertexType)
@@ -572,11 +573,11 @@ void CVertexManager::RenderBuffers(ID3D11DeviceContext * deviceContext, ID3D11Bu
 	offset = 0;
 
 	// Set the vertex buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
+	CStateCache::Get(deviceContext)->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
 
 	// Set the index buffer to active in the input assembler so it can be rendered.
-	deviceContext->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	CStateCache::Get(deviceContext)->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
 	// Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
\ No newline at end of file
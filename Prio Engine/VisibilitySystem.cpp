@@ -0,0 +1,356 @@
+#include "VisibilitySystem.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+CVisibilitySystem::CVisibilitySystem(CThreadPool* threadPool)
+{
+	mpThreadPool = threadPool;
+	mNumberOfTestedInstances = 0;
+
+	for (unsigned int view = 0; view < kMaxViews; view++)
+	{
+		mViews[view].enabled = false;
+		mViews[view].frustum = nullptr;
+		mViews[view].cameraPos = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+		mViews[view].projectionScale = 1.0f;
+		mViews[view].occlusionCuller = nullptr;
+		mNumberOfVisibleInstances[view] = 0;
+		mNumberOfOccludedInstances[view] = 0;
+	}
+}
+
+
+CVisibilitySystem::~CVisibilitySystem()
+{
+}
+
+void CVisibilitySystem::SetView(unsigned int view, CFrustum* frustum, D3DXVECTOR3 cameraPos, float projectionScale, COcclusionCuller* occlusionCuller)
+{
+	if (view >= kMaxViews)
+	{
+		logger->GetInstance().WriteLine("Attempted to set up a view outside the range supported by the visibility system.");
+		return;
+	}
+
+	mViews[view].enabled = true;
+	mViews[view].frustum = frustum;
+	mViews[view].cameraPos = cameraPos;
+	mViews[view].projectionScale = projectionScale;
+	mViews[view].occlusionCuller = occlusionCuller;
+}
+
+void CVisibilitySystem::DisableView(unsigned int view)
+{
+	if (view >= kMaxViews)
+	{
+		return;
+	}
+
+	mViews[view].enabled = false;
+}
+
+/* Build the jobs for every mesh, test them all in parallel then copy the results back onto the meshes.
+* Jobs are merged back in the order they were created so each list comes out in ascending index order. */
+void CVisibilitySystem::Cull(std::list<CMesh*>& meshes)
+{
+	unsigned int numberOfJobs = 0;
+	unsigned int numberOfEnabledViews = 0;
+	mNumberOfTestedInstances = 0;
+
+	for (unsigned int view = 0; view < kMaxViews; view++)
+	{
+		mNumberOfVisibleInstances[view] = 0;
+		mNumberOfOccludedInstances[view] = 0;
+
+		for (auto mesh : meshes)
+		{
+			for (unsigned int lod = 0; lod < CCookedMesh::kMaxLods; lod++)
+			{
+				mesh->GetVisibleModels(view, lod).clear();
+			}
+			mesh->GetVisibleChunks(view).clear();
+		}
+
+		if (IsViewEnabled(view))
+		{
+			numberOfEnabledViews++;
+		}
+	}
+
+	if (numberOfEnabledViews == 0)
+	{
+		return;
+	}
+
+	for (auto mesh : meshes)
+	{
+		ClassifyChunks(mesh);
+
+		unsigned int numberOfModels = mesh->GetNumberOfModels();
+
+		// Sized here rather than in the jobs, as each job only writes to the entries of its own instances.
+		for (unsigned int view = 0; view < kMaxViews; view++)
+		{
+			if (IsViewEnabled(view))
+			{
+				mesh->GetModelLods(view).resize(numberOfModels, 0);
+			}
+		}
+
+		for (unsigned int begin = 0; begin < numberOfModels; begin += kInstancesPerJob)
+		{
+			if (numberOfJobs == mJobs.size())
+			{
+				mJobs.push_back(CullJob());
+			}
+
+			CullJob& job = mJobs[numberOfJobs];
+			job.mesh = mesh;
+			job.begin = begin;
+			job.end = begin + kInstancesPerJob < numberOfModels ? begin + kInstancesPerJob : numberOfModels;
+			for (unsigned int view = 0; view < kMaxViews; view++)
+			{
+				for (unsigned int lod = 0; lod < CCookedMesh::kMaxLods; lod++)
+				{
+					job.visible[view][lod].clear();
+				}
+				job.numberOfOccluded[view] = 0;
+			}
+
+			mNumberOfTestedInstances += (job.end - job.begin) * numberOfEnabledViews;
+			numberOfJobs++;
+		}
+	}
+
+	mpThreadPool->ParallelFor(numberOfJobs, 1, [this](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			ProcessJob(mJobs[i]);
+		}
+	});
+
+	for (unsigned int i = 0; i < numberOfJobs; i++)
+	{
+		CullJob& job = mJobs[i];
+		for (unsigned int view = 0; view < kMaxViews; view++)
+		{
+			if (!IsViewEnabled(view))
+			{
+				continue;
+			}
+
+			for (unsigned int lod = 0; lod < CCookedMesh::kMaxLods; lod++)
+			{
+				std::vector<unsigned int>& visibleModels = job.mesh->GetVisibleModels(view, lod);
+				visibleModels.insert(visibleModels.end(), job.visible[view][lod].begin(), job.visible[view][lod].end());
+				mNumberOfVisibleInstances[view] += static_cast<unsigned int>(job.visible[view][lod].size());
+			}
+			mNumberOfOccludedInstances[view] += job.numberOfOccluded[view];
+		}
+	}
+}
+
+/* Test a range of instances against the distance cut off, frustum and occluders of each view, and pick the level of detail
+* of those which pass. Only reads shared state, other than the levels of detail of its own instances, so is safe to run on any thread.
+* The bounds are gathered into flat arrays once, then each frustum tests them in batches. */
+void CVisibilitySystem::ProcessJob(CullJob& job)
+{
+	const float levelOfDetail = job.mesh->GetLevelOfDetail();
+	const float radius = job.mesh->GetRadius();
+	const unsigned int count = job.end - job.begin;
+	const bool hasLods = job.mesh->GetNumberOfLods() > 1;
+
+	float posX[kInstancesPerJob];
+	float posY[kInstancesPerJob];
+	float posZ[kInstancesPerJob];
+	float radii[kInstancesPerJob];
+	unsigned int visibleMasks[kInstancesPerJob / 32];
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		CModel* model = job.mesh->GetModel(job.begin + i);
+		D3DXVECTOR3 position = model->GetWorldPosition();
+		posX[i] = position.x;
+		posY[i] = position.y;
+		posZ[i] = position.z;
+		radii[i] = model->GetScaleRadius(radius);
+	}
+
+	for (unsigned int viewIndex = 0; viewIndex < kMaxViews; viewIndex++)
+	{
+		if (!IsViewEnabled(viewIndex))
+		{
+			continue;
+		}
+
+		const ViewInfo& view = mViews[viewIndex];
+		const std::vector<unsigned char>& chunkStates = job.mesh->GetChunkStates(viewIndex);
+		std::vector<unsigned char>& modelLods = job.mesh->GetModelLods(viewIndex);
+
+		view.frustum->CullSpheres(posX, posY, posZ, radii, count, visibleMasks);
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (!(visibleMasks[i / 32] & (1u << (i % 32))))
+			{
+				continue;
+			}
+
+			// Instances in a chunk which has been culled or is being drawn as a batch are already dealt with.
+			unsigned int chunk = job.mesh->GetModelChunk(job.begin + i);
+			if (chunk != CMesh::kNoChunk && chunkStates[chunk] != CMesh::ChunkDrawInstances)
+			{
+				continue;
+			}
+
+			unsigned int lod = 0;
+			if (hasLods)
+			{
+				// Meshes with levels of detail drop down to their coarsest level in the distance, rather than disappearing at a fixed range.
+				const float x = view.cameraPos.x - posX[i];
+				const float y = view.cameraPos.y - posY[i];
+				const float z = view.cameraPos.z - posZ[i];
+				const float distance = sqrtf(x * x + y * y + z * z);
+				const float screenSize = distance > radii[i] ? radii[i] * view.projectionScale / distance : FLT_MAX;
+
+				if (screenSize < kMinimumScreenSize)
+				{
+					continue;
+				}
+
+				lod = job.mesh->SelectLod(screenSize, modelLods[job.begin + i]);
+			}
+			else
+			{
+				float distance = std::abs(view.cameraPos.x - posX[i]) +
+					std::abs(view.cameraPos.y - posY[i]) +
+					std::abs(view.cameraPos.z - posZ[i]);
+
+				if (distance >= levelOfDetail)
+				{
+					continue;
+				}
+			}
+
+			// Occlusion is the most expensive test, so only done for instances which passed everything else.
+			if (view.occlusionCuller != nullptr && !view.occlusionCuller->TestSphere(D3DXVECTOR3(posX[i], posY[i], posZ[i]), radii[i]))
+			{
+				job.numberOfOccluded[viewIndex]++;
+				continue;
+			}
+
+			modelLods[job.begin + i] = static_cast<unsigned char>(lod);
+			job.visible[viewIndex][lod].push_back(job.begin + i);
+		}
+	}
+}
+
+/* Chunks are culled as a unit against the frustum. Those nearby have their instances tested as normal, while those far
+* enough away are drawn as one batch and so are also tested against the occluders here. */
+void CVisibilitySystem::ClassifyChunks(CMesh* mesh)
+{
+	const unsigned int numberOfChunks = mesh->GetNumberOfStaticChunks();
+
+	for (unsigned int view = 0; view < kMaxViews; view++)
+	{
+		if (IsViewEnabled(view))
+		{
+			mesh->GetChunkStates(view).assign(numberOfChunks, CMesh::ChunkCulled);
+		}
+	}
+
+	if (numberOfChunks == 0)
+	{
+		return;
+	}
+
+	mChunkCentreX.resize(numberOfChunks);
+	mChunkCentreY.resize(numberOfChunks);
+	mChunkCentreZ.resize(numberOfChunks);
+	mChunkExtentX.resize(numberOfChunks);
+	mChunkExtentY.resize(numberOfChunks);
+	mChunkExtentZ.resize(numberOfChunks);
+	mChunkVisibleMasks.resize((numberOfChunks + 31) / 32);
+
+	for (unsigned int chunk = 0; chunk < numberOfChunks; chunk++)
+	{
+		const D3DXVECTOR3& minBounds = mesh->GetStaticChunkMinBounds(chunk);
+		const D3DXVECTOR3& maxBounds = mesh->GetStaticChunkMaxBounds(chunk);
+		mChunkCentreX[chunk] = (minBounds.x + maxBounds.x) * 0.5f;
+		mChunkCentreY[chunk] = (minBounds.y + maxBounds.y) * 0.5f;
+		mChunkCentreZ[chunk] = (minBounds.z + maxBounds.z) * 0.5f;
+		mChunkExtentX[chunk] = (maxBounds.x - minBounds.x) * 0.5f;
+		mChunkExtentY[chunk] = (maxBounds.y - minBounds.y) * 0.5f;
+		mChunkExtentZ[chunk] = (maxBounds.z - minBounds.z) * 0.5f;
+	}
+
+	const float levelOfDetail = mesh->GetLevelOfDetail();
+	const float batchDistance = mesh->GetStaticBatchDistance();
+	const bool hasLods = mesh->GetNumberOfLods() > 1;
+
+	for (unsigned int view = 0; view < kMaxViews; view++)
+	{
+		if (!IsViewEnabled(view))
+		{
+			continue;
+		}
+
+		std::vector<unsigned char>& states = mesh->GetChunkStates(view);
+		std::vector<unsigned int>& visibleChunks = mesh->GetVisibleChunks(view);
+		const ViewInfo& viewInfo = mViews[view];
+
+		viewInfo.frustum->CullAABBs(mChunkCentreX.data(), mChunkCentreY.data(), mChunkCentreZ.data(),
+			mChunkExtentX.data(), mChunkExtentY.data(), mChunkExtentZ.data(), numberOfChunks, mChunkVisibleMasks.data());
+
+		for (unsigned int chunk = 0; chunk < numberOfChunks; chunk++)
+		{
+			if (!(mChunkVisibleMasks[chunk / 32] & (1u << (chunk % 32))))
+			{
+				continue;
+			}
+
+			// Distance to the closest point of the chunk, measured the same way as for instances.
+			float distance = std::max(0.0f, std::abs(viewInfo.cameraPos.x - mChunkCentreX[chunk]) - mChunkExtentX[chunk]) +
+				std::max(0.0f, std::abs(viewInfo.cameraPos.y - mChunkCentreY[chunk]) - mChunkExtentY[chunk]) +
+				std::max(0.0f, std::abs(viewInfo.cameraPos.z - mChunkCentreZ[chunk]) - mChunkExtentZ[chunk]);
+
+			if (hasLods)
+			{
+				// Same screen size cut off as the instances, using the radius of the whole chunk.
+				const float chunkRadius = sqrtf(mChunkExtentX[chunk] * mChunkExtentX[chunk] + mChunkExtentY[chunk] * mChunkExtentY[chunk] +
+					mChunkExtentZ[chunk] * mChunkExtentZ[chunk]);
+				const float x = viewInfo.cameraPos.x - mChunkCentreX[chunk];
+				const float y = viewInfo.cameraPos.y - mChunkCentreY[chunk];
+				const float z = viewInfo.cameraPos.z - mChunkCentreZ[chunk];
+				const float centreDistance = sqrtf(x * x + y * y + z * z);
+
+				if (centreDistance > chunkRadius && chunkRadius * viewInfo.projectionScale / centreDistance < kMinimumScreenSize)
+				{
+					continue;
+				}
+			}
+			else if (distance >= levelOfDetail)
+			{
+				continue;
+			}
+
+			if (distance < batchDistance)
+			{
+				states[chunk] = CMesh::ChunkDrawInstances;
+				continue;
+			}
+
+			if (viewInfo.occlusionCuller != nullptr &&
+				!viewInfo.occlusionCuller->TestAABB(mesh->GetStaticChunkMinBounds(chunk), mesh->GetStaticChunkMaxBounds(chunk)))
+			{
+				continue;
+			}
+
+			states[chunk] = CMesh::ChunkDrawBatch;
+			visibleChunks.push_back(chunk);
+		}
+	}
+}
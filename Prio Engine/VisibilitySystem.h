@@ -0,0 +1,94 @@
+#ifndef VISIBILITYSYSTEM_H
+#define VISIBILITYSYSTEM_H
+
+#include <D3DX10math.h>
+#include <list>
+#include <vector>
+#include "PrioEngineVars.h"
+#include "Frustum.h"
+#include "ThreadPool.h"
+#include "OcclusionCuller.h"
+#include "CookedMesh.h"
+
+class CMesh;
+
+/* Culls every instance of every mesh against each view once per frame, spread across the thread pool. The bounds of
+* each range of instances are gathered once and tested against every enabled view in turn, so adding a view costs
+* the plane tests rather than another pass over the scene.
+* The results are stored on each mesh as a compact list of visible model indices which the render passes walk. */
+class CVisibilitySystem
+{
+private:
+	CLogger* logger;
+public:
+	enum ViewType
+	{
+		MainView = 0,
+		// Seen from the reflected camera, so can't share occlusion results with the main view.
+		ReflectionView,
+		// Seen from the main camera, but only what's below the water.
+		RefractionView
+	};
+	static const unsigned int kMaxViews = 4;
+	// How many instances a single job will test.
+	static const unsigned int kInstancesPerJob = 256;
+public:
+	CVisibilitySystem(CThreadPool* threadPool);
+	~CVisibilitySystem();
+public:
+	// Set up the frustum and camera position a view will be culled with this frame. The projection scale is
+	// 1 / tan(fov / 2), used to work out how large instances appear on screen when picking their level of detail.
+	// If an occlusion culler is given, it must already have been rasterised from the same camera.
+	void SetView(unsigned int view, CFrustum* frustum, D3DXVECTOR3 cameraPos, float projectionScale, COcclusionCuller* occlusionCuller = nullptr);
+	// Stop a view from being culled, any meshes will report no visible models for it.
+	void DisableView(unsigned int view);
+	// Cull every enabled view, should be called once per frame before any of the meshes are rendered.
+	void Cull(std::list<CMesh*>& meshes);
+public:
+	unsigned int GetNumberOfTestedInstances() { return mNumberOfTestedInstances; };
+	unsigned int GetNumberOfVisibleInstances(unsigned int view) { return mNumberOfVisibleInstances[view]; };
+	unsigned int GetNumberOfOccludedInstances(unsigned int view) { return mNumberOfOccludedInstances[view]; };
+private:
+	struct ViewInfo
+	{
+		bool enabled;
+		CFrustum* frustum;
+		D3DXVECTOR3 cameraPos;
+		float projectionScale;
+		COcclusionCuller* occlusionCuller;
+	};
+
+	// A range of instances from one mesh, to be tested against every enabled view.
+	struct CullJob
+	{
+		CMesh* mesh;
+		unsigned int begin;
+		unsigned int end;
+		std::vector<unsigned int> visible[kMaxViews][CCookedMesh::kMaxLods];
+		unsigned int numberOfOccluded[kMaxViews];
+	};
+
+	bool IsViewEnabled(unsigned int view) { return mViews[view].enabled && mViews[view].frustum != nullptr; };
+	void ProcessJob(CullJob& job);
+	// Decide which static chunks of a mesh are culled, drawn as a batch, or have their instances tested individually, for every enabled view.
+	void ClassifyChunks(CMesh* mesh);
+private:
+	CThreadPool* mpThreadPool;
+	ViewInfo mViews[kMaxViews];
+	// Kept between frames so the job lists don't need to be reallocated each time.
+	std::vector<CullJob> mJobs;
+	unsigned int mNumberOfTestedInstances;
+	unsigned int mNumberOfVisibleInstances[kMaxViews];
+	unsigned int mNumberOfOccludedInstances[kMaxViews];
+
+	// Bounds of the static chunks of the mesh currently being classified.
+	std::vector<float> mChunkCentreX;
+	std::vector<float> mChunkCentreY;
+	std::vector<float> mChunkCentreZ;
+	std::vector<float> mChunkExtentX;
+	std::vector<float> mChunkExtentY;
+	std::vector<float> mChunkExtentZ;
+	std::vector<unsigned int> mChunkVisibleMasks;
+};
+
+#endif
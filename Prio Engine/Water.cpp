@@ -1,4 +1,5 @@
 #include "Water.h"
+#include "StateCache.h"
 
 CWater::CWater()
 {
@@ -16,6 +17,8 @@ CWater::CWater()
 	mRefractionStrength = 0.95f;
 	mReflectionStrength = 0.9f;
 	mWaterDepth = 6.0f;
+	mBoundsCentre = { 0.0f, 0.0f, 0.0f };
+	mBoundsRadius = 0.0f;
 }
 
 
@@ -23,7 +26,7 @@ CWater::~CWater()
 {
 }
 
-bool CWater::Initialise(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint, unsigned int subDivisionX, unsigned int subDivisionZ, std::string normalMap, int screenWidth, int screenHeight)
+bool CWater::Initialise(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint, unsigned int subDivisionX, unsigned int subDivisionZ, std::string normalMap)
 {
 	// Release the existing data.
 	Shutdown();
@@ -41,38 +44,10 @@ bool CWater::Initialise(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3
 		return false;
 	}
 
-	///////////////////////////
-	// Refraction render target
-	//////////////////////////
-
-	mpRefractionRenderTexture = new CRenderTexture();
-	if (!mpRefractionRenderTexture->Initialise(device, screenWidth, screenHeight, DXGI_FORMAT_R8G8B8A8_UNORM))
-	{
-		logger->GetInstance().WriteLine("Failed to initialise the refraction render texture.");
-		return false;
-	}
-
-	///////////////////////////
-	// Reflection render target
-	///////////////////////////
-
-	mpReflectionRenderTexture = new CRenderTexture();
-	if (!mpReflectionRenderTexture->Initialise(device, screenWidth, screenHeight, DXGI_FORMAT_R8G8B8A8_UNORM))
-	{
-		logger->GetInstance().WriteLine("Failed to initialise the reflection render texture.");
-		return false;
-	}
-
-	///////////////////////////
-	// Height map render target
-	///////////////////////////
-
-	mpHeightRenderTexture = new CRenderTexture();
-	if (!mpHeightRenderTexture->Initialise(device, screenWidth, screenHeight, DXGI_FORMAT_R32_FLOAT))
-	{
-		logger->GetInstance().WriteLine("Failed to initialise the height render texture.");
-		return false;
-	}
+	// A sphere around the plane, grown by the wave height so the surface is still drawn when only the crests are on screen.
+	mBoundsCentre = (minPoint + maxPoint) * 0.5f;
+	D3DXVECTOR3 halfExtents = (maxPoint - minPoint) * 0.5f;
+	mBoundsRadius = D3DXVec3Length(&halfExtents) + mWaveHeight;
 
 	logger->GetInstance().WriteLine("Successfully loaded the texture for the water model.");
 
@@ -81,27 +56,6 @@ bool CWater::Initialise(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3
 
 void CWater::Shutdown()
 {
-	if (mpHeightRenderTexture)
-	{
-		mpHeightRenderTexture->Shutdown();
-		delete mpHeightRenderTexture;
-		mpHeightRenderTexture = nullptr;
-	}
-
-	if (mpRefractionRenderTexture)
-	{
-		mpRefractionRenderTexture->Shutdown();
-		delete mpRefractionRenderTexture;
-		mpRefractionRenderTexture = nullptr;
-	}
-
-	if (mpReflectionRenderTexture)
-	{
-		mpReflectionRenderTexture->Shutdown();
-		delete mpReflectionRenderTexture;
-		mpReflectionRenderTexture = nullptr;
-	}
-
 	if (mpNormalMap)
 	{
 		mpNormalMap->Shutdown();
@@ -232,34 +186,14 @@ CTexture * CWater::GetNormalMap()
 	return mpNormalMap;
 }
 
-CRenderTexture * CWater::GetRefractionTexture()
-{
-	return mpRefractionRenderTexture;
-}
-
-CRenderTexture * CWater::GetReflectionTexture()
-{
-	return mpReflectionRenderTexture;
-}
-
-CRenderTexture * CWater::GetHeightTexture()
-{
-	return mpHeightRenderTexture;
-}
-
-void CWater::SetRefractionRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView)
-{
-	mpRefractionRenderTexture->SetRenderTarget(deviceContext, depthStencilView);
-}
-
-void CWater::SetReflectionRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView)
+D3DXVECTOR3 CWater::GetBoundsCentre()
 {
-	mpReflectionRenderTexture->SetRenderTarget(deviceContext, depthStencilView);
+	return mPosition + mBoundsCentre;
 }
 
-void CWater::SetHeightMapRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView)
+float CWater::GetBoundsRadius()
 {
-	mpHeightRenderTexture->SetRenderTarget(deviceContext, depthStencilView);
+	return mBoundsRadius;
 }
 
 void CWater::RenderBuffers(ID3D11DeviceContext* deviceContext)
@@ -272,13 +206,13 @@ void CWater::RenderBuffers(ID3D11DeviceContext* deviceContext)
 	offset = 0;
 
 	// Set the vertex buffer to active in the input assembler.
-	deviceContext->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
+	CStateCache::Get(deviceContext)->IASetVertexBuffers(0, 1, &mpVertexBuffer, &stride, &offset);
 
 	// Set the index buffer to active in the input assembler.
-	deviceContext->IASetIndexBuffer(mpIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	CStateCache::Get(deviceContext)->IASetIndexBuffer(mpIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
 
 	// Tell directx we've passed it a triangle list in the form of indices.
-	deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CStateCache::Get(deviceContext)->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
 D3DXVECTOR2 CWater::GetMovement()
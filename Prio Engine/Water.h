@@ -2,7 +2,6 @@
 #define WATER_H
 
 #include "Texture.h"
-#include "RenderTexture.h"
 #include "PrioEngineVars.h"
 #include "ModelControl.h"
 #include <memory>
@@ -21,7 +20,7 @@ private:
 public:
 	CWater();
 	~CWater();
-	bool Initialise(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint, unsigned int subDivisionX, unsigned int subDivisionZ, std::string normalMap, int screenWidth, int screenHeight);
+	bool Initialise(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint, unsigned int subDivisionX, unsigned int subDivisionZ, std::string normalMap);
 	void Shutdown();
 	void Render(ID3D11DeviceContext* deviceContext);
 	void Update(float frameTime);
@@ -35,19 +34,14 @@ private:
 public:
 	unsigned int GetNumberOfIndices();
 	CTexture* GetNormalMap();
-	CRenderTexture* GetRefractionTexture();
-	CRenderTexture* GetReflectionTexture();
-	CRenderTexture* GetHeightTexture();
-public:
-	void SetRefractionRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView);
-	void SetReflectionRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView);
-	void SetHeightMapRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView);
+	// A world space sphere around the surface, for checking whether the water is on screen at all.
+	D3DXVECTOR3 GetBoundsCentre();
+	float GetBoundsRadius();
 private:
 	bool InitialiseBuffers(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint, unsigned int subDivisionX, unsigned int subDivisionZ, bool uvs = true, bool normals = true);
 private:
-	CRenderTexture* mpRefractionRenderTexture;
-	CRenderTexture* mpReflectionRenderTexture;
-	CRenderTexture* mpHeightRenderTexture;
+	D3DXVECTOR3 mBoundsCentre;
+	float mBoundsRadius;
 
 	D3DXVECTOR2 mMovement;
 	float mWaveHeight;
@@ -1,4 +1,5 @@
 #include "WaterShader.h"
+#include "StateCache.h"
 
 CWaterShader::CWaterShader()
 {
@@ -10,7 +11,9 @@ CWaterShader::CWaterShader()
 	mpWaterBuffer = nullptr;
 	mpCameraBuffer = nullptr;
 	mpViewportBuffer = nullptr;
-	mpLightBuffer = nullptr;
+	mpReprojectionBuffer = nullptr;
+	D3DXMatrixIdentity(&mRefractionViewProj);
+	D3DXMatrixIdentity(&mReflectionViewProj);
 }
 
 CWaterShader::~CWaterShader()
@@ -88,7 +91,7 @@ bool CWaterShader::InitialiseShader(ID3D11Device* device, HWND hwnd, std::string
 	D3D11_BUFFER_DESC waterBufferDesc;
 	D3D11_BUFFER_DESC cameraBufferDesc;
 	D3D11_BUFFER_DESC viewportBufferDesc;
-	D3D11_BUFFER_DESC lightBufferDesc;
+	D3D11_BUFFER_DESC reprojectionBufferDesc;
 	D3D11_SAMPLER_DESC samplerDesc;
 
 	// Initialise pointers in this function to null.
@@ -101,7 +104,7 @@ bool CWaterShader::InitialiseShader(ID3D11Device* device, HWND hwnd, std::string
 	////////////////////////////////
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(surfaceVSFilename.c_str(), NULL, NULL, "WaterSurfaceVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(surfaceVSFilename, "WaterSurfaceVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -118,7 +121,7 @@ bool CWaterShader::InitialiseShader(ID3D11Device* device, HWND hwnd, std::string
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(surfacePsFilename.c_str(), NULL, NULL, "WaterSurfacePS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(surfacePsFilename, "WaterSurfacePS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -158,7 +161,7 @@ bool CWaterShader::InitialiseShader(ID3D11Device* device, HWND hwnd, std::string
 	pixelShaderBuffer = nullptr;
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(heightPsFilename.c_str(), NULL, NULL, "WaterHeightPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(heightPsFilename, "WaterHeightPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -348,22 +351,20 @@ bool CWaterShader::InitialiseShader(ID3D11Device* device, HWND hwnd, std::string
 	}
 
 	////////////////////////////
-	// Light buffer
+	// Reprojection buffer
 	////////////////////////////
 
-	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
+	reprojectionBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	reprojectionBufferDesc.ByteWidth = sizeof(ReprojectionBufferType);
+	reprojectionBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	reprojectionBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	reprojectionBufferDesc.MiscFlags = 0;
+	reprojectionBufferDesc.StructureByteStride = 0;
 
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&lightBufferDesc, NULL, &mpLightBuffer);
+	result = device->CreateBuffer(&reprojectionBufferDesc, NULL, &mpReprojectionBuffer);
 	if (FAILED(result))
 	{
-		logger->GetInstance().WriteLine("Failed to create the light buffer in WaterShader.cpp.");
+		logger->GetInstance().WriteLine("Failed to create the reprojection buffer in WaterShader.cpp.");
 		return false;
 	}
 
@@ -402,10 +403,10 @@ void CWaterShader::ShutdownShader()
 		mpViewportBuffer = nullptr;
 	}
 
-	if (mpLightBuffer)
+	if (mpReprojectionBuffer)
 	{
-		mpLightBuffer->Release();
-		mpLightBuffer = nullptr;
+		mpReprojectionBuffer->Release();
+		mpReprojectionBuffer = nullptr;
 	}
 
 	if (mpLayout)
@@ -520,8 +521,8 @@ bool CWaterShader::SetSurfaceShaderParameters(ID3D11DeviceContext* deviceContext
 	bufferNumber = 1;
 
 	// Now set the constant buffer in the vertex and pixel shader with the updated values.
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &mpWaterBuffer);
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpWaterBuffer);
+	CStateCache::Get(deviceContext)->VSSetConstantBuffers(bufferNumber, 1, &mpWaterBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpWaterBuffer);
 
 	///////////////////////////
 	// Camera buffer
@@ -548,7 +549,7 @@ bool CWaterShader::SetSurfaceShaderParameters(ID3D11DeviceContext* deviceContext
 	bufferNumber = 2;
 
 	// Now set the constant buffer in the vertex and pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpCameraBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpCameraBuffer);
 
 	///////////////////////////
 	// Viewport buffer
@@ -574,47 +575,35 @@ bool CWaterShader::SetSurfaceShaderParameters(ID3D11DeviceContext* deviceContext
 	bufferNumber = 3;
 
 	// Now set the constant buffer in the vertex and pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpViewportBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpViewportBuffer);
 
 	///////////////////////////
-	// Light buffer
+	// Reprojection buffer
 	///////////////////////////
 
-	// Lock the constant buffer so it can be written to.
-	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	result = deviceContext->Map(mpReprojectionBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
 	if (FAILED(result))
 	{
 		return false;
 	}
 
-	// Get a pointer to the data in the constant buffer.
-	LightBufferType * lightBufferPtr = (LightBufferType*)mappedResource.pData;
+	ReprojectionBufferType * reprojectionBufferPtr = (ReprojectionBufferType*)mappedResource.pData;
+	reprojectionBufferPtr->RefractionViewProj = mRefractionViewProj;
+	reprojectionBufferPtr->ReflectionViewProj = mReflectionViewProj;
 
-	// Copy the matrices into the constant buffer.
-	lightBufferPtr->AmbientColour = mAmbientColour;
-	lightBufferPtr->DiffuseColour = mDiffuseColour;
-	lightBufferPtr->LightDirection = mLightDirection;
-	lightBufferPtr->mSpecularColour = mSpecularColour;
-	lightBufferPtr->mSpecularPower = mSpecularPower;
-	lightBufferPtr->mLightPosition = mLightPosition;
-	lightBufferPtr->lightBufferPadding = 0.0f;
+	deviceContext->Unmap(mpReprojectionBuffer, 0);
 
-	// Unlock the constant buffer.
-	deviceContext->Unmap(mpLightBuffer, 0);
-
-	// Set the position of the constant buffer in the vertex shader.
 	bufferNumber = 4;
 
-	// Now set the constant buffer in the vertex and pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
+	CStateCache::Get(deviceContext)->PSSetConstantBuffers(bufferNumber, 1, &mpReprojectionBuffer);
 
 	///////////////////////////
 	// Shader resources
 	///////////////////////////
-	deviceContext->VSSetShaderResources(0, 1, &mpNormalMap);
-	deviceContext->PSSetShaderResources(0, 1, &mpNormalMap);
-	deviceContext->PSSetShaderResources(1, 1, &mpRefractionMap);
-	deviceContext->PSSetShaderResources(2, 1, &mpReflectionMap);
+	CStateCache::Get(deviceContext)->VSSetShaderResources(0, 1, &mpNormalMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &mpNormalMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(1, 1, &mpRefractionMap);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(2, 1, &mpReflectionMap);
 
 	return true;
 }
@@ -674,12 +663,12 @@ bool CWaterShader::SetHeightShaderParameters(ID3D11DeviceContext* deviceContext)
 	bufferNumber = 1;
 
 	// Now set the constant buffer in the vertex and pixel shader with the updated values.
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &mpWaterBuffer);
+	CStateCache::Get(deviceContext)->VSSetConstantBuffers(bufferNumber, 1, &mpWaterBuffer);
 
 	///////////////////////////
 	// Shader resources
 	///////////////////////////
-	deviceContext->VSSetShaderResources(0, 1, &mpNormalMap);
+	CStateCache::Get(deviceContext)->VSSetShaderResources(0, 1, &mpNormalMap);
 
 	return true;
 }
@@ -687,16 +676,16 @@ bool CWaterShader::SetHeightShaderParameters(ID3D11DeviceContext* deviceContext)
 void CWaterShader::RenderSurfaceShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {	
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpSurfaceVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpSurfacePixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpSurfaceVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpSurfacePixelShader, NULL, 0);
 
 	// Set the sampler states
-	deviceContext->VSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetSamplers(0, 1, &mpTrilinearWrap);
-	deviceContext->PSSetSamplers(1, 1, &mpBilinearMirror);
+	CStateCache::Get(deviceContext)->VSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->PSSetSamplers(1, 1, &mpBilinearMirror);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
@@ -704,10 +693,10 @@ void CWaterShader::RenderSurfaceShader(ID3D11DeviceContext * deviceContext, int
 
 	// Unbind the shader resources we used.
 	ID3D11ShaderResourceView* nullResource = nullptr;
-	deviceContext->VSSetShaderResources(0, 1, &nullResource);
-	deviceContext->PSSetShaderResources(0, 1, &nullResource);
-	deviceContext->PSSetShaderResources(1, 1, &nullResource);
-	deviceContext->PSSetShaderResources(2, 1, &nullResource);
+	CStateCache::Get(deviceContext)->VSSetShaderResources(0, 1, &nullResource);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(0, 1, &nullResource);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(1, 1, &nullResource);
+	CStateCache::Get(deviceContext)->PSSetShaderResources(2, 1, &nullResource);
 
 	return;
 }
@@ -715,21 +704,21 @@ void CWaterShader::RenderSurfaceShader(ID3D11DeviceContext * deviceContext, int
 void CWaterShader::RenderHeightShader(ID3D11DeviceContext * deviceContext, int indexCount)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
+	CStateCache::Get(deviceContext)->IASetInputLayout(mpLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpSurfaceVertexShader, NULL, 0);
-	deviceContext->PSSetShader(mpHeightPixelShader, NULL, 0);
+	CStateCache::Get(deviceContext)->VSSetShader(mpSurfaceVertexShader, NULL, 0);
+	CStateCache::Get(deviceContext)->PSSetShader(mpHeightPixelShader, NULL, 0);
 
 	// Set the sampler state in the vertex shader.
-	deviceContext->VSSetSamplers(0, 1, &mpTrilinearWrap);
+	CStateCache::Get(deviceContext)->VSSetSamplers(0, 1, &mpTrilinearWrap);
 
 	// Render the triangle.
 	deviceContext->DrawIndexed(indexCount, 0, 0);
 
 	// Unbind the shader resources we used.
 	ID3D11ShaderResourceView* nullResource = nullptr;
-	deviceContext->VSSetShaderResources(0, 1, &nullResource);
+	CStateCache::Get(deviceContext)->VSSetShaderResources(0, 1, &nullResource);
 
 	return;
 }
@@ -785,14 +774,10 @@ void CWaterShader::SetViewportSize(int screenWidth, int screenHeight)
 	mViewportSize = D3DXVECTOR2(static_cast<float>(screenWidth), static_cast<float>(screenHeight));
 }
 
-void CWaterShader::SetLightProperties(CLight * light)
+void CWaterShader::SetReprojection(D3DXMATRIX refractionViewProj, D3DXMATRIX reflectionViewProj)
 {
-	mAmbientColour = light->GetAmbientColour();
-	mDiffuseColour = light->GetDiffuseColour();
-	mLightDirection = light->GetDirection();
-	mSpecularPower = light->GetSpecularPower();
-	mSpecularColour = light->GetSpecularColour();
-	mLightPosition = light->GetPos();
+	D3DXMatrixTranspose(&mRefractionViewProj, &refractionViewProj);
+	D3DXMatrixTranspose(&mReflectionViewProj, &reflectionViewProj);
 }
 
 void CWaterShader::SetNormalMap(CTexture * normalMap)
@@ -2,7 +2,6 @@
 #define WATERSHADER_H
 
 #include "Shader.h"
-#include "Light.h"
 
 class CWaterShader :
 	public CShader
@@ -39,16 +38,11 @@ private:
 		D3DXVECTOR2 viewportPadding2;
 	};
 
-	// Surface pixel shader reg 4
-	struct LightBufferType
+	// Surface pixel shader reg 4.
+	struct ReprojectionBufferType
 	{
-		D3DXVECTOR4	AmbientColour;
-		D3DXVECTOR4	DiffuseColour;
-		D3DXVECTOR3	LightDirection;
-		D3DXVECTOR4 mSpecularColour;
-		D3DXVECTOR3 mLightPosition;
-		float mSpecularPower;
-		float lightBufferPadding;
+		D3DXMATRIX RefractionViewProj;
+		D3DXMATRIX ReflectionViewProj;
 	};
 public:
 	CWaterShader();
@@ -71,13 +65,8 @@ private:
 	D3DXMATRIX mCameraMatrix; 
 	D3DXVECTOR3 mCameraPosition; 
 	D3DXVECTOR2 mViewportSize; 
-
-	D3DXVECTOR4 mAmbientColour;
-	D3DXVECTOR4 mDiffuseColour; 
-	D3DXVECTOR3 mLightDirection; 
-	float mSpecularPower;
-	D3DXVECTOR4 mSpecularColour;
-	D3DXVECTOR3 mLightPosition;
+	D3DXMATRIX mRefractionViewProj;
+	D3DXMATRIX mReflectionViewProj;
 
 	ID3D11ShaderResourceView* mpNormalMap; 
 	ID3D11ShaderResourceView* mpRefractionMap; 
@@ -93,7 +82,8 @@ public:
 	void SetCameraMatrix(D3DXMATRIX cameraWorld);
 	void SetCameraPosition(D3DXVECTOR3 position);
 	void SetViewportSize(int screenWidth, int screenHeight);
-	void SetLightProperties(CLight* light);
+	// The camera the refraction and reflection maps were drawn from, which may be a few frames behind the current one.
+	void SetReprojection(D3DXMATRIX refractionViewProj, D3DXMATRIX reflectionViewProj);
 	void SetNormalMap(CTexture* normalMap);
 	void SetRefractionMap(ID3D11ShaderResourceView* refractionMap);
 	void SetReflectionMap(ID3D11ShaderResourceView* reflectionMap);
@@ -119,7 +109,7 @@ private:
 	ID3D11Buffer* mpWaterBuffer;
 	ID3D11Buffer* mpCameraBuffer;
 	ID3D11Buffer* mpViewportBuffer;
-	ID3D11Buffer* mpLightBuffer;
+	ID3D11Buffer* mpReprojectionBuffer;
 
 };
 
@@ -0,0 +1,104 @@
+#include "Test.h"
+#include "StubDevice.h"
+#include "AssetLoader.h"
+#include "Texture.h"
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+	const std::string kTextures = std::string(PRIO_ENGINE_DIRECTORY) + "/Resources/Textures/";
+	const unsigned int kIterations = 5;
+
+	// The material textures of a scene at startup, all ones the engine decodes itself.
+	const char* const kMaterialTextures[] =
+	{
+		"WaterNormalHeight.png",
+		"Branches0030_1_M.png",
+		"Foliage/Grass.png",
+		"Foliage/GrassAlpha.png",
+		"Foliage/Reeds.png",
+		"Foliage/ReedsAlpha.png",
+		"Ice.dds",
+		"Rock.dds",
+		"Dirt.dds",
+		"Sand.dds",
+		"Stone.dds"
+	};
+
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef std::chrono::duration<double, std::milli> Milliseconds;
+}
+
+/* Every texture read, decoded and created before the first frame, which is what loading the meshes' materials used to do. */
+TEST(BenchmarkSynchronousStartup)
+{
+	CStubDevice device;
+
+	bool loaded = true;
+	PrioTest::Benchmark("Synchronous startup, main thread", kIterations, [&]()
+	{
+		for (auto texture : kMaterialTextures)
+		{
+			ID3D11ShaderResourceView* view = nullptr;
+			loaded &= CTexture::CreateFromFile(&device, kTextures + texture, &view);
+			if (view != nullptr)
+			{
+				view->Release();
+			}
+		}
+	});
+	CHECK(loaded);
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+/* The textures are queued and the frame loop carries on with placeholders, so only the time spent queueing and in Update
+* holds up the main thread. The wall time until the last one is ready is reported alongside it. */
+TEST(BenchmarkQueuedStartup)
+{
+	CStubDevice device;
+
+	Milliseconds mainThread(0);
+	Milliseconds wallTime(0);
+	unsigned int numberOfFrames = 0;
+	bool loaded = true;
+	for (unsigned int iteration = 0; iteration < kIterations; iteration++)
+	{
+		CAssetLoader assetLoader(&device);
+		const auto start = Clock::now();
+
+		std::vector<CAssetLoader::AssetHandle> requests;
+		for (auto texture : kMaterialTextures)
+		{
+			requests.push_back(assetLoader.LoadTexture(kTextures + texture));
+		}
+		mainThread += Clock::now() - start;
+
+		// One Update a frame, as the engine does, until everything has been created.
+		while (assetLoader.GetNumberOfPendingRequests() > 0)
+		{
+			const auto frameStart = Clock::now();
+			assetLoader.Update();
+			mainThread += Clock::now() - frameStart;
+			numberOfFrames++;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		wallTime += Clock::now() - start;
+
+		for (auto& request : requests)
+		{
+			loaded &= request->state == CAssetLoader::AssetReady;
+			if (request->texture != nullptr)
+			{
+				request->texture->Release();
+				request->texture = nullptr;
+			}
+		}
+	}
+	CHECK(loaded);
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+
+	std::cout << "Queued startup, main thread: " << mainThread.count() / kIterations << "ms" << std::endl;
+	std::cout << "Queued startup, until all ready: " << wallTime.count() / kIterations << "ms over "
+		<< numberOfFrames / kIterations << " frames" << std::endl;
+}
@@ -0,0 +1,241 @@
+#include "Test.h"
+#include "StubDevice.h"
+#include "AssetLoader.h"
+#include <chrono>
+
+namespace
+{
+	const std::string kTextures = std::string(PRIO_ENGINE_DIRECTORY) + "/Resources/Textures/";
+
+	// Textures the engine decodes itself, so nothing is left to D3DX.
+	const char* const kMaterialTextures[] =
+	{
+		"WaterNormalHeight.png",
+		"Foliage/Grass.png",
+		"Foliage/GrassAlpha.png",
+		"Foliage/Reeds.png",
+		"Ice.dds",
+		"Rock.dds"
+	};
+
+	// Waits for the workers without calling Update, so nothing can be created on the device in the meantime.
+	bool WaitForWorkers(const CAssetLoader::AssetHandle& request)
+	{
+		const auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (request->state == CAssetLoader::AssetQueued || request->state == CAssetLoader::AssetLoading)
+		{
+			if (std::chrono::steady_clock::now() > giveUp)
+			{
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+
+	void ReleaseTexture(CAssetLoader::AssetHandle& request)
+	{
+		if (request->texture != nullptr)
+		{
+			if (request->resourceCache != nullptr)
+			{
+				request->resourceCache->ReleaseTexture(request->texture);
+			}
+			else
+			{
+				request->texture->Release();
+			}
+			request->texture = nullptr;
+		}
+	}
+}
+
+TEST(PlaceholderIsReadyStraightAway)
+{
+	CStubDevice device;
+	{
+		CAssetLoader assetLoader(&device);
+		CHECK(assetLoader.GetPlaceholderTexture() != nullptr);
+		CHECK(device.GetNumberOfTextures() == 1);
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+/* The read and decode happen on a worker, the device is only touched by Update on the thread which calls it, which is
+* the frame boundary in the engine. */
+TEST(TexturesAreOnlyCreatedInUpdate)
+{
+	CStubDevice device;
+	{
+		CAssetLoader assetLoader(&device);
+		const unsigned int texturesBefore = device.GetNumberOfTextures();
+
+		bool callbackFired = false;
+		bool callbackSucceeded = false;
+		std::thread::id callbackThread;
+		CAssetLoader::AssetHandle request = assetLoader.LoadTexture(kTextures + "WaterNormalHeight.png", [&](bool success)
+		{
+			callbackFired = true;
+			callbackSucceeded = success;
+			callbackThread = std::this_thread::get_id();
+		});
+
+		CHECK(request != nullptr);
+		CHECK(WaitForWorkers(request));
+
+		// Decoded, but nothing has been created yet.
+		CHECK(request->state == CAssetLoader::AssetLoaded);
+		CHECK(request->image.IsDecoded());
+		CHECK(request->texture == nullptr);
+		CHECK(device.GetNumberOfTextures() == texturesBefore);
+		CHECK(!callbackFired);
+
+		assetLoader.Update();
+
+		CHECK(request->state == CAssetLoader::AssetReady);
+		CHECK(request->texture != nullptr);
+		CHECK(device.GetNumberOfTextures() == texturesBefore + 1);
+		CHECK(callbackFired && callbackSucceeded);
+		CHECK(callbackThread == std::this_thread::get_id());
+		CHECK(device.AllCreatedOn(std::this_thread::get_id()));
+		// The decoded pixels are let go once they've been uploaded.
+		CHECK(!request->image.IsDecoded());
+
+		ReleaseTexture(request);
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+TEST(CreationsAreSpreadOverUpdates)
+{
+	CStubDevice device;
+	{
+		CAssetLoader assetLoader(&device);
+		const unsigned int texturesBefore = device.GetNumberOfTextures();
+
+		std::vector<CAssetLoader::AssetHandle> requests;
+		for (auto texture : kMaterialTextures)
+		{
+			requests.push_back(assetLoader.LoadTexture(kTextures + texture));
+		}
+		for (auto& request : requests)
+		{
+			CHECK(WaitForWorkers(request));
+		}
+
+		assetLoader.Update(2);
+		CHECK(device.GetNumberOfTextures() == texturesBefore + 2);
+		assetLoader.Update(2);
+		CHECK(device.GetNumberOfTextures() == texturesBefore + 4);
+
+		assetLoader.Flush();
+		CHECK(device.GetNumberOfTextures() == texturesBefore + static_cast<unsigned int>(requests.size()));
+
+		for (auto& request : requests)
+		{
+			CHECK(request->state == CAssetLoader::AssetReady);
+			ReleaseTexture(request);
+		}
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+TEST(CancelledTexturesAreNotCreated)
+{
+	CStubDevice device;
+	{
+		CAssetLoader assetLoader(&device);
+		const unsigned int texturesBefore = device.GetNumberOfTextures();
+
+		bool callbackFired = false;
+		CAssetLoader::AssetHandle request = assetLoader.LoadTexture(kTextures + "Ice.dds", [&](bool) { callbackFired = true; });
+		CAssetLoader::AssetHandle kept = request;
+		CAssetLoader::Cancel(request);
+
+		CHECK(request == nullptr);
+		assetLoader.Flush();
+
+		CHECK(!callbackFired);
+		CHECK(device.GetNumberOfTextures() == texturesBefore);
+		CHECK(kept->texture == nullptr);
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+TEST(MissingTexturesFail)
+{
+	CStubDevice device;
+	CAssetLoader assetLoader(&device);
+
+	bool callbackFired = false;
+	bool callbackSucceeded = true;
+	CAssetLoader::AssetHandle request = assetLoader.LoadTexture(kTextures + "NotThere.png", [&](bool success)
+	{
+		callbackFired = true;
+		callbackSucceeded = success;
+	});
+	assetLoader.Flush();
+
+	CHECK(request->state == CAssetLoader::AssetFailed);
+	CHECK(callbackFired && !callbackSucceeded);
+}
+
+/* A mesh queues its material textures from inside Update, when its own buffers are created. Those requests have to be
+* picked up without disturbing the requests Update is working through. */
+TEST(CallbacksCanQueueMoreTextures)
+{
+	CStubDevice device;
+	{
+		CResourceCache resourceCache;
+		CAssetLoader assetLoader(&device, &resourceCache);
+
+		// Already in the cache by the time the callback asks for it again, so that request is ready straight away.
+		CAssetLoader::AssetHandle first = assetLoader.LoadTexture(kTextures + "Rock.dds");
+		assetLoader.Flush();
+
+		std::vector<CAssetLoader::AssetHandle> queued;
+		unsigned int numberOfLoaded = 0;
+		CAssetLoader::AssetHandle trigger = assetLoader.LoadTexture(kTextures + "Ice.dds", [&](bool)
+		{
+			for (auto texture : kMaterialTextures)
+			{
+				queued.push_back(assetLoader.LoadTexture(kTextures + texture, [&](bool success) { numberOfLoaded += success ? 1 : 0; }));
+			}
+		});
+		assetLoader.Flush();
+
+		CHECK(queued.size() == sizeof(kMaterialTextures) / sizeof(kMaterialTextures[0]));
+		CHECK(numberOfLoaded == queued.size());
+		for (auto& request : queued)
+		{
+			CHECK(request->state == CAssetLoader::AssetReady && request->texture != nullptr);
+			ReleaseTexture(request);
+		}
+
+		// Rock and Ice were asked for twice, but only created once.
+		CHECK(resourceCache.GetStatistics().numberOfTextures == queued.size());
+
+		ReleaseTexture(first);
+		ReleaseTexture(trigger);
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+TEST(MeshCreationIsAtTheFrameBoundary)
+{
+	CStubDevice device;
+	CAssetLoader assetLoader(&device);
+
+	// Assimp isn't in the tests, so this can only fail, but the create function must still never be called for it.
+	bool created = false;
+	bool callbackFired = false;
+	CAssetLoader::AssetHandle request = assetLoader.LoadMesh(std::string(PRIO_ENGINE_DIRECTORY) + "/Resources/Models/NotThere.fbx",
+		[&](CCookedMesh&) { created = true; return true; }, [&](bool) { callbackFired = true; });
+	CHECK(WaitForWorkers(request));
+	CHECK(!callbackFired);
+
+	assetLoader.Update();
+	CHECK(request->state == CAssetLoader::AssetFailed);
+	CHECK(!created);
+	CHECK(callbackFired);
+}
@@ -0,0 +1,51 @@
+#include "Test.h"
+#include "MeshScene.h"
+#include "CookedMesh.h"
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+	// Around the size of the larger models in the scene, at a little over 30,000 triangles.
+	const unsigned int kGridSize = 128;
+	const char* kSourceFile = "Grid.x";
+	const unsigned int kColdIterations = 3;
+	const unsigned int kWarmIterations = 100;
+}
+
+/* Loads with no cooked copy on disk, so every load imports, optimises and simplifies the model and writes it out, as the
+* first run after a model changes does. The stub importer hands over the scene straight away, so the time assimp would take
+* to parse the file is left out. Then loads from the up to date cooked copy, which only hashes the source and maps the file,
+* and remaps it without checking the source, as baking the static batches does. */
+TEST(BenchmarkColdAndWarmLoads)
+{
+	{
+		std::ofstream file(kSourceFile, std::ios::binary | std::ios::trunc);
+		file << "Grid";
+	}
+	CMeshScene scene(kGridSize);
+	CCookedMesh cookedMesh;
+
+	bool cold = true;
+	PrioTest::Benchmark("Cold load, importing and cooking", kColdIterations, [&]()
+	{
+		std::remove(CCookedMesh::GetCookedFilename(kSourceFile).c_str());
+		cold &= cookedMesh.Load(kSourceFile, kMeshImportFlags) && !cookedMesh.WasLoadedFromCache();
+	});
+	CHECK(cold);
+	CHECK(cookedMesh.GetNumberOfIndices() > kGridSize * kGridSize * 6);
+
+	bool warm = true;
+	PrioTest::Benchmark("Warm load, from the cooked copy", kWarmIterations, [&]()
+	{
+		warm &= cookedMesh.Load(kSourceFile, kMeshImportFlags) && cookedMesh.WasLoadedFromCache();
+	});
+	CHECK(warm);
+
+	bool remapped = true;
+	PrioTest::Benchmark("Remap, without checking the source", kWarmIterations, [&]()
+	{
+		remapped &= cookedMesh.Remap(kSourceFile, kMeshImportFlags);
+	});
+	CHECK(remapped);
+}
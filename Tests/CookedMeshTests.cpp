@@ -0,0 +1,197 @@
+#include "Test.h"
+#include "MeshScene.h"
+#include "CookedMesh.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+	const unsigned int kGridSize = 16;
+
+	// The stub importer never reads the source, it only has to exist so it can be hashed.
+	void WriteSource(const std::string& filename, const std::string& contents)
+	{
+		std::remove(CCookedMesh::GetCookedFilename(filename).c_str());
+		std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+		file << contents;
+	}
+
+	// Every attribute of every vertex, sorted, so the two sides can be compared whatever order the cooker left them in.
+	std::vector<std::array<float, 8>> GetVertices(const aiMesh& subMesh)
+	{
+		std::vector<std::array<float, 8>> vertices;
+		for (unsigned int vertex = 0; vertex < subMesh.mNumVertices; vertex++)
+		{
+			const aiVector3D& position = subMesh.mVertices[vertex];
+			const aiVector3D& uv = subMesh.mTextureCoords[0][vertex];
+			const aiVector3D& normal = subMesh.mNormals[vertex];
+			vertices.push_back({ position.x, position.y, position.z, uv.x, uv.y, normal.x, normal.y, normal.z });
+		}
+		std::sort(vertices.begin(), vertices.end());
+		return vertices;
+	}
+
+	std::vector<std::array<float, 8>> GetVertices(const CCookedMesh::Vertex* first, unsigned int numberOfVertices)
+	{
+		std::vector<std::array<float, 8>> vertices;
+		for (const CCookedMesh::Vertex* vertex = first; vertex < first + numberOfVertices; vertex++)
+		{
+			vertices.push_back({ vertex->position[0], vertex->position[1], vertex->position[2], vertex->uv[0], vertex->uv[1],
+				vertex->normal[0], vertex->normal[1], vertex->normal[2] });
+		}
+		std::sort(vertices.begin(), vertices.end());
+		return vertices;
+	}
+
+	/* Each triangle as the positions of its corners, rotated to start from the lowest so the winding is kept but where it
+	* starts isn't, then sorted. */
+	std::vector<std::array<float, 9>> SortTriangles(std::vector<std::array<std::array<float, 3>, 3>>& corners)
+	{
+		std::vector<std::array<float, 9>> triangles;
+		for (auto& triangle : corners)
+		{
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+			triangles.push_back({ triangle[0][0], triangle[0][1], triangle[0][2], triangle[1][0], triangle[1][1], triangle[1][2],
+				triangle[2][0], triangle[2][1], triangle[2][2] });
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	std::vector<std::array<float, 9>> GetTriangles(const aiMesh& subMesh)
+	{
+		std::vector<std::array<std::array<float, 3>, 3>> corners;
+		for (unsigned int face = 0; face < subMesh.mNumFaces; face++)
+		{
+			std::array<std::array<float, 3>, 3> triangle;
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				const aiVector3D& position = subMesh.mVertices[subMesh.mFaces[face].mIndices[corner]];
+				triangle[corner] = { position.x, position.y, position.z };
+			}
+			corners.push_back(triangle);
+		}
+		return SortTriangles(corners);
+	}
+
+	std::vector<std::array<float, 9>> GetTriangles(const CCookedMesh::Vertex* vertices, const unsigned int* indices, unsigned int numberOfIndices)
+	{
+		std::vector<std::array<std::array<float, 3>, 3>> corners;
+		for (unsigned int index = 0; index < numberOfIndices; index += 3)
+		{
+			std::array<std::array<float, 3>, 3> triangle;
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				const CCookedMesh::Vertex& vertex = vertices[indices[index + corner]];
+				triangle[corner] = { vertex.position[0], vertex.position[1], vertex.position[2] };
+			}
+			corners.push_back(triangle);
+		}
+		return SortTriangles(corners);
+	}
+}
+
+TEST(CookedMeshMatchesTheImportedScene)
+{
+	WriteSource("Grid.x", "Grid");
+	CMeshScene scene(kGridSize);
+	CHECK(CCookedMesh::Cook("Grid.x", kMeshImportFlags));
+
+	CCookedMesh cookedMesh;
+	CHECK(cookedMesh.Load("Grid.x", kMeshImportFlags));
+	CHECK(cookedMesh.WasLoadedFromCache());
+	CHECK(cookedMesh.GetNumberOfSubMeshes() == CMeshScene::kNumberOfSubMeshes);
+	CHECK(cookedMesh.GetNumberOfMaterials() == CMeshScene::kNumberOfSubMeshes);
+	CHECK(cookedMesh.GetNumberOfLods() == CCookedMesh::kDefaultLodSettings.numberOfLods);
+	CHECK(cookedMesh.GetLodError(0) == 0.0f);
+	if (cookedMesh.GetNumberOfSubMeshes() != CMeshScene::kNumberOfSubMeshes)
+	{
+		return;
+	}
+
+	unsigned int nextVertex = 0;
+	unsigned int nextIndex = 0;
+	for (unsigned int subMesh = 0; subMesh < cookedMesh.GetNumberOfSubMeshes(); subMesh++)
+	{
+		const aiMesh& imported = scene.GetSubMesh(subMesh);
+		const CCookedMesh::SubMeshRecord& record = cookedMesh.GetSubMesh(subMesh);
+		const CCookedMesh::Vertex* vertices = cookedMesh.GetVertices() + record.firstVertex;
+		const unsigned int* indices = cookedMesh.GetIndices();
+
+		// Nothing in the scene is shared, so every vertex is kept as it was, only the order may change.
+		CHECK(record.materialIndex == imported.mMaterialIndex);
+		CHECK(record.firstVertex == nextVertex);
+		CHECK(record.numberOfVertices == imported.mNumVertices);
+		CHECK(GetVertices(vertices, record.numberOfVertices) == GetVertices(imported));
+
+		CHECK(record.firstIndex == nextIndex);
+		CHECK(record.numberOfIndices == imported.mNumFaces * 3);
+		CHECK(GetTriangles(vertices, indices + record.firstIndex, record.numberOfIndices) == GetTriangles(imported));
+
+		// Each level follows on from the one before with fewer triangles, all drawn from the submesh's own vertices.
+		for (unsigned int lod = 0; lod < cookedMesh.GetNumberOfLods(); lod++)
+		{
+			const unsigned int first = record.lodFirstIndex[lod];
+			const unsigned int count = record.lodNumberOfIndices[lod];
+			CHECK(first == nextIndex);
+			CHECK(count % 3 == 0);
+			CHECK(lod == 0 || count <= record.lodNumberOfIndices[lod - 1]);
+			CHECK(lod == 0 || cookedMesh.GetLodError(lod) >= cookedMesh.GetLodError(lod - 1));
+			CHECK(std::all_of(indices + first, indices + first + count, [&record](unsigned int index) { return index < record.numberOfVertices; }));
+			nextIndex = first + count;
+		}
+		nextVertex += record.numberOfVertices;
+	}
+	CHECK(nextVertex == cookedMesh.GetNumberOfVertices());
+	CHECK(nextIndex == cookedMesh.GetNumberOfIndices());
+
+	/* The grid is flat, so every level down has fewer triangles, and all the way to the triangles asked for until the
+	* vertices round its edge, which are never removed, are most of what's left. */
+	const CCookedMesh::SubMeshRecord& grid = cookedMesh.GetSubMesh(0);
+	for (unsigned int lod = 1; lod < cookedMesh.GetNumberOfLods(); lod++)
+	{
+		const float ratio = CCookedMesh::kDefaultLodSettings.ratios[lod];
+		const unsigned int target = static_cast<unsigned int>(grid.numberOfIndices * ratio) / 3 * 3;
+		CHECK(grid.lodNumberOfIndices[lod] > 0);
+		CHECK(grid.lodNumberOfIndices[lod] < grid.lodNumberOfIndices[lod - 1]);
+		CHECK(ratio < 0.25f || grid.lodNumberOfIndices[lod] <= target);
+	}
+}
+
+TEST(EditingTheSourceCooksItAgain)
+{
+	WriteSource("Quad.x", "Quad");
+	CMeshScene scene(2);
+	CCookedMesh cookedMesh;
+
+	CHECK(cookedMesh.Load("Quad.x", kMeshImportFlags));
+	CHECK(!cookedMesh.WasLoadedFromCache());
+	CHECK(cookedMesh.Load("Quad.x", kMeshImportFlags));
+	CHECK(cookedMesh.WasLoadedFromCache());
+
+	// Different import flags or level of detail settings make the cooked copy out of date, as does changing the source.
+	CHECK(cookedMesh.Load("Quad.x", kMeshImportFlags | aiProcess_FlipUVs));
+	CHECK(!cookedMesh.WasLoadedFromCache());
+	CHECK(cookedMesh.Load("Quad.x", kMeshImportFlags));
+	CHECK(!cookedMesh.WasLoadedFromCache());
+	const CCookedMesh::LodSettings lodSettings = { 2, { 1.0f, 0.5f } };
+	CHECK(cookedMesh.Load("Quad.x", kMeshImportFlags, lodSettings));
+	CHECK(!cookedMesh.WasLoadedFromCache());
+	CHECK(cookedMesh.GetNumberOfLods() == 2);
+
+	{
+		std::ofstream file("Quad.x", std::ios::binary | std::ios::app);
+		file << " edited";
+	}
+	CHECK(cookedMesh.Load("Quad.x", kMeshImportFlags, lodSettings));
+	CHECK(!cookedMesh.WasLoadedFromCache());
+	CHECK(cookedMesh.Load("Quad.x", kMeshImportFlags, lodSettings));
+	CHECK(cookedMesh.WasLoadedFromCache());
+
+	// Without the source, whatever was cooked is used as it is.
+	std::remove("Quad.x");
+	CHECK(cookedMesh.Load("Quad.x", kMeshImportFlags));
+	CHECK(cookedMesh.WasLoadedFromCache());
+	CHECK(cookedMesh.GetNumberOfLods() == 2);
+}
@@ -0,0 +1,164 @@
+#include "Test.h"
+#include "DrawList.h"
+#include "PassRecorder.h"
+#include "SharedConstants.h"
+#include "NullRenderDevice.h"
+#include "DrawListScene.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	const unsigned int kIterations = 50;
+	const unsigned int kNumberOfPackets = 20000;
+	const unsigned int kNumberOfPipelines = 4;
+	const unsigned int kNumberOfMaterials = 16;
+	const float kScreenWidth = 1280.0f;
+	const float kScreenHeight = 720.0f;
+
+	/* Packets added in no particular order, as they would be walking the scene, a quarter of them transparent.
+	* @Returns The keys of the packets, in the order they were added. */
+	std::vector<unsigned long long> FillDrawList(CDrawListScene& scene, CDrawList& drawList)
+	{
+		std::vector<unsigned long long> keys;
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> depth(1.0f, 1000.0f);
+		for (unsigned int i = 0; i < kNumberOfPackets; i++)
+		{
+			const unsigned int pipeline = random() % kNumberOfPipelines;
+			const unsigned int material = random() % kNumberOfMaterials;
+			const CDrawList::Pass pass = (i % 4 == 0) ? CDrawList::TransparentPass : CDrawList::OpaquePass;
+			keys.push_back(CDrawList::MakeSortKey(pass, pipeline + 1, material + 1, depth(random)));
+			scene.Add(drawList, keys.back(), pipeline, material);
+		}
+		return keys;
+	}
+
+	void PrintStatistics(const std::string& name, const CDrawList::Statistics& statistics)
+	{
+		std::cout << name << ": " << statistics.pipelineChanges << " pipeline binds, " << statistics.materialChanges << " material binds, " <<
+			statistics.bufferChanges << " buffer binds, " << statistics.skippedBinds << " skipped" << std::endl;
+	}
+}
+
+/* The radix sort against std::stable_sort on the same keys, which is what it replaces. */
+TEST(BenchmarkSort)
+{
+	CNullRenderDevice renderDevice;
+	CDrawListScene scene(&renderDevice, kNumberOfPipelines, kNumberOfMaterials);
+	CDrawList drawList;
+	const std::vector<unsigned long long> keys = FillDrawList(scene, drawList);
+
+	PrioTest::Benchmark("Radix sort " + std::to_string(kNumberOfPackets) + " packets", kIterations, [&]()
+	{
+		drawList.Sort();
+	});
+
+	std::vector<std::pair<unsigned long long, unsigned int>> entries(kNumberOfPackets);
+	for (unsigned int i = 0; i < kNumberOfPackets; i++)
+	{
+		entries[i] = std::make_pair(keys[i], i);
+	}
+	std::vector<std::pair<unsigned long long, unsigned int>> sorted;
+	PrioTest::Benchmark("std::stable_sort " + std::to_string(kNumberOfPackets) + " packets", kIterations, [&]()
+	{
+		sorted = entries;
+		std::stable_sort(sorted.begin(), sorted.end(), [](const std::pair<unsigned long long, unsigned int>& a, const std::pair<unsigned long long, unsigned int>& b)
+		{
+			return a.first < b.first;
+		});
+	});
+	CHECK(sorted.size() == kNumberOfPackets);
+}
+
+/* The null device makes binds free, so this is only the CPU side of submission, with the binds it saved counted. */
+TEST(BenchmarkSubmit)
+{
+	CNullRenderDevice renderDevice;
+	{
+		CDrawListScene scene(&renderDevice, kNumberOfPipelines, kNumberOfMaterials);
+		CDrawList drawList;
+		FillDrawList(scene, drawList);
+
+		PrioTest::Benchmark("Submit unsorted", kIterations, [&]()
+		{
+			drawList.Submit(&renderDevice);
+		});
+		const CDrawList::Statistics unsorted = drawList.GetStatistics();
+		PrintStatistics("Unsorted", unsorted);
+
+		PrioTest::Benchmark("Sort and submit", kIterations, [&]()
+		{
+			drawList.Sort();
+			drawList.Submit(&renderDevice);
+		});
+		PrintStatistics("Sorted", drawList.GetStatistics());
+
+		CHECK(drawList.GetStatistics().packets == kNumberOfPackets);
+		// Transparent packets go back to front whatever their state, so only the opaque ones are grouped.
+		CHECK(drawList.GetStatistics().pipelineChanges < unsorted.pipelineChanges / 2);
+		CHECK(drawList.GetStatistics().materialChanges < unsorted.materialChanges / 2);
+	}
+	CHECK(renderDevice.GetNumberOfErrors() == 0);
+}
+
+/* The list as it's submitted each frame, once the shared frame and pass constants are set: cleared, filled, sorted and
+* recorded across the workers. Only the draw list side of a frame, everything else CGraphics draws is left out. */
+TEST(BenchmarkRecordedSubmit)
+{
+	CNullRenderDevice renderDevice;
+	{
+		CThreadPool threadPool;
+		CPassRecorder passRecorder(&renderDevice, &threadPool);
+		CSharedConstants sharedConstants(&renderDevice);
+		CHECK(sharedConstants.Initialise());
+		CDrawListScene scene(&renderDevice, kNumberOfPipelines, kNumberOfMaterials);
+		CDrawList drawList;
+		const unsigned int maxRuns = threadPool.GetNumberOfThreads() + 1;
+
+		const D3DXVECTOR3 position(0.0f, 50.0f, -200.0f);
+		const D3DXVECTOR3 lookAt(0.0f, 0.0f, 0.0f);
+		const D3DXVECTOR3 up(0.0f, 1.0f, 0.0f);
+		const D3DXVECTOR4 noClipPlane(0.0f, 0.0f, 0.0f, 0.0f);
+		D3DXMATRIX view;
+		D3DXMATRIX proj;
+		D3DXMatrixLookAtLH(&view, &position, &lookAt, &up);
+		D3DXMatrixPerspectiveFovLH(&proj, 0.785f, kScreenWidth / kScreenHeight, 0.1f, 1000.0f);
+
+		CSharedConstants::FrameConstants frameConstants = {};
+		frameConstants.ambientColour = D3DXVECTOR4(0.2f, 0.2f, 0.2f, 1.0f);
+		frameConstants.diffuseColour = D3DXVECTOR4(1.0f, 1.0f, 1.0f, 1.0f);
+		frameConstants.specularColour = D3DXVECTOR4(1.0f, 1.0f, 1.0f, 1.0f);
+		frameConstants.lightDirection = D3DXVECTOR3(0.0f, -1.0f, 0.0f);
+		frameConstants.lightPosition = D3DXVECTOR3(0.0f, 100.0f, 0.0f);
+		frameConstants.eyePosition = position;
+		frameConstants.windDirection = D3DXVECTOR3(1.0f, 0.0f, 0.0f);
+
+		bool result = true;
+		PrioTest::Benchmark("Fill, sort and record " + std::to_string(kNumberOfPackets) + " packets", kIterations, [&]()
+		{
+			renderDevice.BeginFrame();
+			result = sharedConstants.SetFrameConstants(frameConstants) && result;
+			result = sharedConstants.SetPassConstants(view, proj, noClipPlane, kScreenWidth, kScreenHeight) && result;
+
+			drawList.Clear();
+			FillDrawList(scene, drawList);
+			drawList.Sort();
+			result = drawList.Submit(&renderDevice, &passRecorder, maxRuns) && result;
+			result = passRecorder.Execute() && result;
+		});
+		CHECK(result);
+
+		const CRenderDevice::Statistics& statistics = renderDevice.GetStatistics();
+		std::cout << "  " << statistics.draws << " draws, " << statistics.pipelineChanges << " pipeline binds, " <<
+			statistics.bufferBindings << " buffer binds, " << statistics.maps << " maps, " << statistics.uploadBytes << " bytes uploaded" << std::endl;
+
+		// The frame and pass constants, then the object data of every packet.
+		CHECK(statistics.draws == kNumberOfPackets);
+		CHECK(statistics.uploadBytes == sizeof(CSharedConstants::FrameConstants) + sizeof(CSharedConstants::PassConstants) +
+			kNumberOfPackets * CDrawListScene::kObjectDataSize);
+
+		sharedConstants.Shutdown();
+	}
+	CHECK(renderDevice.GetNumberOfErrors() == 0);
+}
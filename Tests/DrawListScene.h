@@ -0,0 +1,79 @@
+#ifndef DRAWLISTSCENE_H
+#define DRAWLISTSCENE_H
+
+#include "DrawList.h"
+#include <vector>
+
+/* The buffers and states a list of packets draws with, made on the device given and destroyed along with it. Shared by
+* the draw list tests and benchmark. */
+class CDrawListScene
+{
+public:
+	static const unsigned int kObjectDataSize = 64;
+public:
+	CDrawListScene(CRenderDevice* renderDevice, unsigned int numberOfPipelines, unsigned int numberOfMaterials) : mpRenderDevice(renderDevice)
+	{
+		const unsigned char shader[4] = { 0 };
+		CRenderDevice::PipelineStateDesc pipelineDesc = {};
+		pipelineDesc.vertexShader = shader;
+		pipelineDesc.vertexShaderSize = sizeof(shader);
+		pipelineDesc.topology = CRenderDevice::TriangleList;
+		for (unsigned int pipeline = 0; pipeline < numberOfPipelines; pipeline++)
+		{
+			mPipelineStates.push_back(renderDevice->CreatePipelineState(pipelineDesc));
+		}
+
+		mMaterials.resize(numberOfMaterials);
+		for (unsigned int material = 0; material < numberOfMaterials; material++)
+		{
+			mMaterials[material].id = CDrawList::AllocateStateId();
+			mMaterials[material].numberOfTextures = 0;
+			mMaterials[material].constantBuffer = nullptr;
+		}
+
+		const unsigned int indices[3] = { 0, 1, 2 };
+		const float vertices[24] = { 0.0f };
+		mpVertexBuffer = renderDevice->CreateBuffer({ CRenderDevice::VertexBuffer, CRenderDevice::ImmutableUsage, sizeof(vertices) }, vertices);
+		mpIndexBuffer = renderDevice->CreateBuffer({ CRenderDevice::IndexBuffer, CRenderDevice::ImmutableUsage, sizeof(indices) }, indices);
+		mpObjectBuffer = renderDevice->CreateBuffer({ CRenderDevice::ConstantBuffer, CRenderDevice::DynamicUsage, kObjectDataSize }, nullptr);
+	}
+
+	~CDrawListScene()
+	{
+		for (auto pipelineState : mPipelineStates)
+		{
+			mpRenderDevice->DestroyPipelineState(pipelineState);
+		}
+		mpRenderDevice->DestroyBuffer(mpVertexBuffer);
+		mpRenderDevice->DestroyBuffer(mpIndexBuffer);
+		mpRenderDevice->DestroyBuffer(mpObjectBuffer);
+	}
+
+	// The packet's first index is its position in the list, so it can be picked out of what was drawn.
+	void Add(CDrawList& drawList, unsigned long long sortKey, unsigned int pipeline, unsigned int material)
+	{
+		CDrawList::DrawPacket packet = {};
+		packet.sortKey = sortKey;
+		packet.pipelineState = mPipelineStates[pipeline];
+		packet.material = &mMaterials[material];
+		packet.vertexBuffer = mpVertexBuffer;
+		packet.vertexStride = 32;
+		packet.indexBuffer = mpIndexBuffer;
+		packet.indexFormat = CRenderDevice::Index32;
+		packet.firstIndex = drawList.GetNumberOfPackets();
+		packet.indexCount = 3;
+		packet.objectBuffer = mpObjectBuffer;
+
+		const unsigned char objectData[kObjectDataSize] = { 0 };
+		drawList.Add(packet, objectData, sizeof(objectData));
+	}
+private:
+	CRenderDevice* mpRenderDevice;
+	std::vector<CRenderDevice::PipelineState*> mPipelineStates;
+	std::vector<CDrawList::Material> mMaterials;
+	CRenderDevice::Buffer* mpVertexBuffer;
+	CRenderDevice::Buffer* mpIndexBuffer;
+	CRenderDevice::Buffer* mpObjectBuffer;
+};
+
+#endif
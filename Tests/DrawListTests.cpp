@@ -0,0 +1,295 @@
+#include "Test.h"
+#include "DrawList.h"
+#include "PassRecorder.h"
+#include "NullRenderDevice.h"
+#include "DrawListScene.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	// Notes the first index of each draw, every packet is given its own so the order they were drawn in can be read back.
+	class CRecordingDevice : public CNullRenderDevice
+	{
+	public:
+		void DrawIndexed(unsigned int indexCount, unsigned int firstIndex, int baseVertex)
+		{
+			mDrawn.push_back(firstIndex);
+			CNullRenderDevice::DrawIndexed(indexCount, firstIndex, baseVertex);
+		}
+
+		std::vector<unsigned int>& GetDrawn() { return mDrawn; }
+	private:
+		std::vector<unsigned int> mDrawn;
+	};
+
+	// The order std::stable_sort puts the keys in, as the positions they were added at.
+	std::vector<unsigned int> StableSortOrder(const std::vector<unsigned long long>& keys)
+	{
+		std::vector<unsigned int> order(keys.size());
+		for (unsigned int i = 0; i < order.size(); i++)
+		{
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&keys](unsigned int a, unsigned int b) { return keys[a] < keys[b]; });
+		return order;
+	}
+
+	// Sorts and submits the keys, checking they come out in exactly the order std::stable_sort gives.
+	void CheckSortMatches(const std::vector<unsigned long long>& keys)
+	{
+		CRecordingDevice renderDevice;
+		{
+			CDrawListScene scene(&renderDevice, 4, 8);
+			CDrawList drawList;
+			for (unsigned int i = 0; i < keys.size(); i++)
+			{
+				scene.Add(drawList, keys[i], i % 4, i % 8);
+			}
+
+			drawList.Sort();
+			drawList.Submit(&renderDevice);
+
+			CHECK(renderDevice.GetDrawn() == StableSortOrder(keys));
+			CHECK(drawList.GetStatistics().packets == keys.size());
+		}
+		CHECK(renderDevice.GetNumberOfErrors() == 0);
+	}
+
+	float RandomDepth(std::mt19937& random)
+	{
+		return std::uniform_real_distribution<float>(0.0f, 1000.0f)(random);
+	}
+}
+
+/* Few pipelines and materials, so most keys share their top bytes and plenty share everything, which is where a sort
+* that isn't stable would give itself away. */
+TEST(OpaqueOrderMatchesStableSort)
+{
+	std::mt19937 random(42);
+	for (unsigned int numberOfPackets : { 1u, 2u, 17u, 1000u, 20000u })
+	{
+		std::vector<unsigned long long> keys;
+		for (unsigned int i = 0; i < numberOfPackets; i++)
+		{
+			// Depths rounded to whole units, so draws with the same state often tie.
+			const float depth = static_cast<float>(static_cast<int>(RandomDepth(random)) % 50);
+			keys.push_back(CDrawList::MakeSortKey(CDrawList::OpaquePass, random() % 3, random() % 16, depth));
+		}
+		CheckSortMatches(keys);
+	}
+}
+
+TEST(TransparentOrderMatchesStableSort)
+{
+	std::mt19937 random(7);
+	for (unsigned int numberOfPackets : { 1u, 2u, 17u, 1000u, 20000u })
+	{
+		std::vector<unsigned long long> keys;
+		for (unsigned int i = 0; i < numberOfPackets; i++)
+		{
+			const float depth = (i % 5 == 0) ? 10.0f : RandomDepth(random);
+			keys.push_back(CDrawList::MakeSortKey(CDrawList::TransparentPass, random() % 3, random() % 16, depth));
+		}
+		CheckSortMatches(keys);
+	}
+}
+
+TEST(MixedPassesMatchStableSort)
+{
+	std::mt19937 random(1234);
+	std::vector<unsigned long long> keys;
+	for (unsigned int i = 0; i < 5000; i++)
+	{
+		const CDrawList::Pass pass = (random() % 4 == 0) ? CDrawList::TransparentPass : CDrawList::OpaquePass;
+		keys.push_back(CDrawList::MakeSortKey(pass, random() % 4096, random() % 65536, RandomDepth(random)));
+	}
+	CheckSortMatches(keys);
+
+	// Every byte different somewhere, so no pass of the sort is skipped.
+	std::mt19937_64 random64(99);
+	keys.clear();
+	for (unsigned int i = 0; i < 5000; i++)
+	{
+		keys.push_back(random64());
+	}
+	CheckSortMatches(keys);
+
+	// And every byte the same, so every pass is.
+	CheckSortMatches(std::vector<unsigned long long>(100, 0x123456789abcdef0ull));
+}
+
+TEST(OpaqueIsGroupedByStateThenFrontToBack)
+{
+	CRecordingDevice renderDevice;
+	{
+		CDrawListScene scene(&renderDevice, 2, 2);
+		CDrawList drawList;
+		const float depths[] = { 30.0f, 10.0f, 20.0f, 0.0f, -5.0f };
+
+		std::vector<unsigned long long> keys;
+		for (unsigned int pipeline = 0; pipeline < 2; pipeline++)
+		{
+			for (unsigned int material = 0; material < 2; material++)
+			{
+				for (float depth : depths)
+				{
+					keys.push_back(CDrawList::MakeSortKey(CDrawList::OpaquePass, 2 - pipeline, 2 - material, depth));
+					scene.Add(drawList, keys.back(), pipeline, material);
+				}
+			}
+		}
+
+		drawList.Sort();
+		drawList.Submit(&renderDevice);
+
+		// One bind each, however they were added.
+		CHECK(drawList.GetStatistics().pipelineChanges == 2);
+		CHECK(drawList.GetStatistics().materialChanges == 4);
+
+		const std::vector<unsigned int>& drawn = renderDevice.GetDrawn();
+		for (unsigned int i = 1; i < drawn.size(); i++)
+		{
+			CHECK(keys[drawn[i - 1]] <= keys[drawn[i]]);
+		}
+		// The last pipeline and material added have the lowest ids, and the nearest of them is first. Negative depths count as zero.
+		CHECK(drawn[0] == 18 && drawn[1] == 19 && drawn[2] == 16);
+	}
+	CHECK(renderDevice.GetNumberOfErrors() == 0);
+}
+
+TEST(TransparentIsBackToFrontAfterOpaque)
+{
+	CRecordingDevice renderDevice;
+	{
+		CDrawListScene scene(&renderDevice, 1, 1);
+		CDrawList drawList;
+		scene.Add(drawList, CDrawList::MakeSortKey(CDrawList::TransparentPass, 1, 1, 5.0f), 0, 0);
+		scene.Add(drawList, CDrawList::MakeSortKey(CDrawList::OpaquePass, 1, 1, 100.0f), 0, 0);
+		scene.Add(drawList, CDrawList::MakeSortKey(CDrawList::TransparentPass, 1, 1, 50.0f), 0, 0);
+		scene.Add(drawList, CDrawList::MakeSortKey(CDrawList::TransparentPass, 1, 1, 20.0f), 0, 0);
+
+		drawList.Sort();
+		drawList.Submit(&renderDevice);
+		CHECK(renderDevice.GetDrawn() == std::vector<unsigned int>({ 1, 2, 3, 0 }));
+	}
+}
+
+/* Sorting again after a clear reuses the scratch space, which mustn't carry anything over from the last frame. */
+TEST(ListsCanBeReused)
+{
+	CRecordingDevice renderDevice;
+	{
+		CDrawListScene scene(&renderDevice, 1, 1);
+		CDrawList drawList;
+		std::mt19937_64 random(5);
+
+		for (unsigned int frame = 0; frame < 3; frame++)
+		{
+			drawList.Clear();
+			renderDevice.GetDrawn().clear();
+
+			std::vector<unsigned long long> keys;
+			for (unsigned int i = 0; i < 500 - frame * 200; i++)
+			{
+				keys.push_back(random());
+				scene.Add(drawList, keys.back(), 0, 0);
+			}
+
+			drawList.Sort();
+			drawList.Submit(&renderDevice);
+			CHECK(renderDevice.GetDrawn() == StableSortOrder(keys));
+		}
+
+		// An empty list sorts and submits nothing.
+		drawList.Clear();
+		renderDevice.GetDrawn().clear();
+		drawList.Sort();
+		drawList.Submit(&renderDevice);
+		CHECK(renderDevice.GetDrawn().empty());
+	}
+	CHECK(renderDevice.GetNumberOfErrors() == 0);
+}
+
+/* Runs of the sorted list submitted separately between them draw the same as submitting it whole. */
+TEST(RunsCoverTheSortedList)
+{
+	std::mt19937_64 random(11);
+	std::vector<unsigned long long> keys;
+	for (unsigned int i = 0; i < 1000; i++)
+	{
+		keys.push_back(random());
+	}
+
+	CRecordingDevice renderDevice;
+	{
+		CDrawListScene scene(&renderDevice, 1, 1);
+		CDrawList drawList;
+		for (auto key : keys)
+		{
+			scene.Add(drawList, key, 0, 0);
+		}
+		drawList.Sort();
+
+		unsigned int packets = 0;
+		for (unsigned int first = 0; first < keys.size(); first += 256)
+		{
+			CDrawList::Statistics statistics;
+			const unsigned int count = std::min(256u, static_cast<unsigned int>(keys.size()) - first);
+			drawList.Submit(&renderDevice, first, count, statistics);
+			packets += statistics.packets;
+		}
+		CHECK(packets == keys.size());
+		CHECK(renderDevice.GetDrawn() == StableSortOrder(keys));
+	}
+	CHECK(renderDevice.GetNumberOfErrors() == 0);
+}
+
+/* Recorded across the workers, the runs are still executed in order, and the statistics are those of every run. */
+TEST(RecordedRunsDrawTheWholeList)
+{
+	std::mt19937_64 random(13);
+	std::vector<unsigned long long> keys;
+	for (unsigned int i = 0; i < 1000; i++)
+	{
+		keys.push_back(random());
+	}
+
+	CRecordingDevice renderDevice;
+	{
+		CThreadPool threadPool(3);
+		CPassRecorder passRecorder(&renderDevice, &threadPool);
+		CDrawListScene scene(&renderDevice, 1, 1);
+		CDrawList drawList;
+		for (auto key : keys)
+		{
+			scene.Add(drawList, key, 0, 0);
+		}
+		drawList.Sort();
+
+		CHECK(drawList.Submit(&renderDevice, &passRecorder, 4));
+		CHECK(passRecorder.GetStatistics().passes == 4);
+		CHECK(renderDevice.GetDrawn() == StableSortOrder(keys));
+		CHECK(drawList.GetStatistics().packets == keys.size());
+		// One pipeline and one material, bound once at the start of each run.
+		CHECK(drawList.GetStatistics().pipelineChanges == 4);
+		CHECK(drawList.GetStatistics().materialChanges == 4);
+
+		// Too short to give each run its share, so it's submitted directly.
+		drawList.Clear();
+		renderDevice.GetDrawn().clear();
+		keys.resize(CDrawList::kMinPacketsPerRecordedRun * 2 - 1);
+		for (auto key : keys)
+		{
+			scene.Add(drawList, key, 0, 0);
+		}
+		drawList.Sort();
+
+		CHECK(drawList.Submit(&renderDevice, &passRecorder, 4));
+		CHECK(renderDevice.GetDrawn() == StableSortOrder(keys));
+		CHECK(drawList.GetStatistics().packets == keys.size());
+		// A single bind shows it went as one.
+		CHECK(drawList.GetStatistics().pipelineChanges == 1);
+	}
+	CHECK(renderDevice.GetNumberOfErrors() == 0);
+}
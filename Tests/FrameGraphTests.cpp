@@ -0,0 +1,239 @@
+#include "Test.h"
+#include "FrameGraph.h"
+#include "StubDevice.h"
+
+namespace
+{
+	const CFrameGraph::TargetDesc kTargetDesc = { 256, 128, DXGI_FORMAT_R8G8B8A8_UNORM, false };
+	const CFrameGraph::TargetDesc kHalfTargetDesc = { 128, 64, DXGI_FORMAT_R8G8B8A8_UNORM, false };
+
+	// A pass which notes that it ran, and which texture it was given for a target, then carries on.
+	CFrameGraph::ExecuteFunction RecordPass(CFrameGraph& frameGraph, const std::string& name, std::vector<std::string>& run,
+		CFrameGraph::ResourceId target = CFrameGraph::kNone, CRenderTexture** texture = nullptr)
+	{
+		return [&frameGraph, name, &run, target, texture]()
+		{
+			run.push_back(name);
+			if (texture != nullptr)
+			{
+				*texture = frameGraph.GetTarget(target);
+			}
+			return true;
+		};
+	}
+}
+
+TEST(PassesNothingReadsArePruned)
+{
+	CStubDevice device;
+	{
+		CFrameGraph frameGraph(&device);
+		std::vector<std::string> run;
+		frameGraph.Reset();
+
+		// A chain ending in a target nobody reads, every pass of it goes.
+		CFrameGraph::ResourceId shadow = frameGraph.CreateTarget("Shadow", kTargetDesc);
+		CFrameGraph::ResourceId blurred = frameGraph.CreateTarget("Blurred", kTargetDesc);
+		CFrameGraph::ResourceId unused = frameGraph.CreateTarget("Unused", kTargetDesc);
+		CFrameGraph::PassId shadowPass = frameGraph.AddPass("Shadow", RecordPass(frameGraph, "Shadow", run));
+		frameGraph.Write(shadowPass, shadow);
+		CFrameGraph::PassId blurPass = frameGraph.AddPass("Blur", RecordPass(frameGraph, "Blur", run));
+		frameGraph.Read(blurPass, shadow);
+		frameGraph.Write(blurPass, blurred);
+		CFrameGraph::PassId unusedPass = frameGraph.AddPass("Unused", RecordPass(frameGraph, "Unused", run));
+		frameGraph.Read(unusedPass, blurred);
+		frameGraph.Write(unusedPass, unused);
+
+		// A chain ending in the back buffer, which is kept.
+		CFrameGraph::ResourceId scene = frameGraph.CreateTarget("Scene", kTargetDesc);
+		CFrameGraph::PassId scenePass = frameGraph.AddPass("Scene", RecordPass(frameGraph, "Scene", run));
+		frameGraph.Write(scenePass, scene);
+		CFrameGraph::PassId presentPass = frameGraph.AddPass("Present", RecordPass(frameGraph, "Present", run));
+		frameGraph.Read(presentPass, scene);
+		frameGraph.SetSideEffect(presentPass);
+
+		frameGraph.Compile();
+
+		CHECK(!frameGraph.IsPassActive(shadowPass));
+		CHECK(!frameGraph.IsPassActive(blurPass));
+		CHECK(!frameGraph.IsPassActive(unusedPass));
+		CHECK(frameGraph.IsPassActive(scenePass));
+		CHECK(frameGraph.IsPassActive(presentPass));
+		CHECK(!frameGraph.IsResourceUsed(shadow));
+		CHECK(!frameGraph.IsResourceUsed(unused));
+		CHECK(frameGraph.IsResourceUsed(scene));
+		CHECK(frameGraph.GetStatistics().passes == 2);
+		CHECK(frameGraph.GetStatistics().prunedPasses == 3);
+		CHECK(frameGraph.GetStatistics().targets == 1);
+
+		CHECK(frameGraph.Execute());
+		CHECK((run == std::vector<std::string>{ "Scene", "Present" }));
+		// Targets for pruned passes are never even created.
+		CHECK(frameGraph.GetStatistics().createdTargets == 1);
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+TEST(TargetsWithDisjointLifetimesShareATexture)
+{
+	CStubDevice device;
+	{
+		CFrameGraph frameGraph(&device);
+		std::vector<std::string> run;
+		CRenderTexture* first = nullptr;
+		CRenderTexture* second = nullptr;
+		CRenderTexture* overlapping = nullptr;
+		CRenderTexture* otherSize = nullptr;
+
+		for (unsigned int frame = 0; frame < 2; frame++)
+		{
+			frameGraph.Reset();
+
+			CFrameGraph::ResourceId reflection = frameGraph.CreateTarget("Reflection", kTargetDesc);
+			CFrameGraph::ResourceId refraction = frameGraph.CreateTarget("Refraction", kTargetDesc);
+			CFrameGraph::ResourceId bloom = frameGraph.CreateTarget("Bloom", kTargetDesc);
+			CFrameGraph::ResourceId halfBloom = frameGraph.CreateTarget("HalfBloom", kHalfTargetDesc);
+
+			// The reflection is finished with before the refraction starts, so the two can be the same texture.
+			CFrameGraph::PassId reflectionPass = frameGraph.AddPass("Reflection", RecordPass(frameGraph, "Reflection", run, reflection, &first));
+			frameGraph.Write(reflectionPass, reflection);
+			CFrameGraph::PassId reflectionUse = frameGraph.AddPass("UseReflection", RecordPass(frameGraph, "UseReflection", run));
+			frameGraph.Read(reflectionUse, reflection);
+			frameGraph.SetSideEffect(reflectionUse);
+
+			// The bloom target is alive at the same time as the refraction, so has to be a different one.
+			CFrameGraph::PassId refractionPass = frameGraph.AddPass("Refraction", RecordPass(frameGraph, "Refraction", run, refraction, &second));
+			frameGraph.Write(refractionPass, refraction);
+			CFrameGraph::PassId bloomPass = frameGraph.AddPass("Bloom", RecordPass(frameGraph, "Bloom", run, bloom, &overlapping));
+			frameGraph.Read(bloomPass, refraction);
+			frameGraph.Write(bloomPass, bloom);
+			CFrameGraph::PassId halfBloomPass = frameGraph.AddPass("HalfBloom", RecordPass(frameGraph, "HalfBloom", run, halfBloom, &otherSize));
+			frameGraph.Read(halfBloomPass, bloom);
+			frameGraph.Write(halfBloomPass, halfBloom);
+			CFrameGraph::PassId presentPass = frameGraph.AddPass("Present", RecordPass(frameGraph, "Present", run));
+			frameGraph.Read(presentPass, halfBloom);
+			frameGraph.SetSideEffect(presentPass);
+
+			frameGraph.Compile();
+			CHECK(frameGraph.Execute());
+
+			CHECK(first != nullptr);
+			CHECK(first == second);
+			CHECK(overlapping != nullptr && overlapping != second);
+			// The first target is free again by the time the half size one starts, but isn't the right size to be used.
+			CHECK(otherSize != nullptr && otherSize != first && otherSize != overlapping);
+			CHECK(frameGraph.GetStatistics().targets == 4);
+			CHECK(frameGraph.GetStatistics().pooledTargets == 3);
+
+			// The pool is kept, so the second frame creates nothing.
+			CHECK(frameGraph.GetStatistics().createdTargets == (frame == 0 ? 3u : 0u));
+		}
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+TEST(DeferredPassesHoldTheirTargetsUntilFlushed)
+{
+	CStubDevice device;
+	{
+		CFrameGraph frameGraph(&device);
+		std::vector<std::string> run;
+		CRenderTexture* queued = nullptr;
+		CRenderTexture* whileQueued = nullptr;
+		CRenderTexture* afterFlush = nullptr;
+		frameGraph.Reset();
+
+		// Both passes only queue their drawing, so the target is finished with before anything has been drawn into it.
+		CFrameGraph::ResourceId height = frameGraph.CreateTarget("Height", kTargetDesc);
+		CFrameGraph::PassId heightPass = frameGraph.AddPass("Height", RecordPass(frameGraph, "Height", run, height, &queued));
+		frameGraph.Write(heightPass, height);
+		frameGraph.SetDeferred(heightPass);
+		CFrameGraph::PassId refractionPass = frameGraph.AddPass("Refraction", RecordPass(frameGraph, "Refraction", run));
+		frameGraph.Read(refractionPass, height);
+		frameGraph.SetSideEffect(refractionPass);
+		frameGraph.SetDeferred(refractionPass);
+
+		CFrameGraph::ResourceId scratch = frameGraph.CreateTarget("Scratch", kTargetDesc);
+		CFrameGraph::PassId scratchPass = frameGraph.AddPass("Scratch", RecordPass(frameGraph, "Scratch", run, scratch, &whileQueued));
+		frameGraph.Write(scratchPass, scratch);
+		frameGraph.SetSideEffect(scratchPass);
+
+		CFrameGraph::PassId recordPass = frameGraph.AddPass("Record", [&frameGraph, &run]()
+		{
+			run.push_back("Record");
+			frameGraph.FlushDeferredReleases();
+			return true;
+		});
+		frameGraph.SetSideEffect(recordPass);
+
+		CFrameGraph::ResourceId later = frameGraph.CreateTarget("Later", kTargetDesc);
+		CFrameGraph::PassId laterPass = frameGraph.AddPass("Later", RecordPass(frameGraph, "Later", run, later, &afterFlush));
+		frameGraph.Write(laterPass, later);
+		frameGraph.SetSideEffect(laterPass);
+
+		frameGraph.Compile();
+		CHECK(frameGraph.Execute());
+		CHECK((run == std::vector<std::string>{ "Height", "Refraction", "Scratch", "Record", "Later" }));
+
+		// Nothing may be handed the height target while its queued work is still waiting to be recorded.
+		CHECK(queued != nullptr);
+		CHECK(whileQueued != nullptr && whileQueued != queued);
+		// Once recorded it goes back to the pool like any other.
+		CHECK(afterFlush == queued);
+		CHECK(frameGraph.GetStatistics().createdTargets == 2);
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+TEST(HistoryIsOnlyValidAfterAWrite)
+{
+	CStubDevice device;
+	{
+		CFrameGraph frameGraph(&device);
+		std::vector<std::string> run;
+
+		// Read but not written, as on the frames where the pass which fills it is skipped.
+		frameGraph.Reset();
+		CFrameGraph::ResourceId history = frameGraph.CreateHistoryTarget("Reflection", kTargetDesc);
+		CFrameGraph::PassId readPass = frameGraph.AddPass("Read", RecordPass(frameGraph, "Read", run));
+		frameGraph.Read(readPass, history);
+		frameGraph.SetSideEffect(readPass);
+		frameGraph.Compile();
+		CHECK(!frameGraph.IsHistoryValid(history));
+		CHECK(frameGraph.Execute());
+		CHECK(!frameGraph.IsHistoryValid(history));
+
+		// Written by a pass which is pruned, which doesn't count.
+		frameGraph.Reset();
+		history = frameGraph.CreateHistoryTarget("Reflection", kTargetDesc);
+		CFrameGraph::PassId prunedPass = frameGraph.AddPass("Pruned", RecordPass(frameGraph, "Pruned", run));
+		frameGraph.Write(prunedPass, history);
+		frameGraph.Compile();
+		CHECK(frameGraph.Execute());
+		CHECK(!frameGraph.IsHistoryValid(history));
+
+		// Only valid once the write has actually run, not as soon as it's declared.
+		frameGraph.Reset();
+		history = frameGraph.CreateHistoryTarget("Reflection", kTargetDesc);
+		CFrameGraph::PassId writePass = frameGraph.AddPass("Write", RecordPass(frameGraph, "Write", run));
+		frameGraph.Write(writePass, history);
+		frameGraph.SetSideEffect(writePass);
+		frameGraph.Compile();
+		CHECK(!frameGraph.IsHistoryValid(history));
+		CHECK(frameGraph.Execute());
+		CHECK(frameGraph.IsHistoryValid(history));
+
+		// Still there on the next frame, without being written again.
+		frameGraph.Reset();
+		history = frameGraph.CreateHistoryTarget("Reflection", kTargetDesc);
+		CHECK(frameGraph.IsHistoryValid(history));
+
+		// Changing the size throws away what was there.
+		frameGraph.Reset();
+		history = frameGraph.CreateHistoryTarget("Reflection", kHalfTargetDesc);
+		CHECK(!frameGraph.IsHistoryValid(history));
+
+		CHECK((run == std::vector<std::string>{ "Read", "Write" }));
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
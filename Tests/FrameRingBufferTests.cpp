@@ -0,0 +1,206 @@
+#include "Test.h"
+#include "FrameRingBuffer.h"
+#include "NullRenderDevice.h"
+#include <random>
+
+namespace
+{
+	/* A GPU which runs a number of frames behind the CPU, so fences complete late. While the ring is waiting on a fence
+	* it polls it over and over, which stands in for the GPU catching up, so after enough polls the oldest one completes. */
+	class CLateFenceDevice : public CNullRenderDevice
+	{
+	public:
+		CLateFenceDevice(unsigned int framesBehind) : mFramesBehind(framesBehind), mLastFence(0), mCompletedFence(0), mNumberOfPolls(0)
+		{
+		}
+
+		unsigned long long InsertFence() override
+		{
+			mLastFence++;
+			mNumberOfPolls = 0;
+			if (mLastFence > mFramesBehind && mLastFence - mFramesBehind > mCompletedFence)
+			{
+				mCompletedFence = mLastFence - mFramesBehind;
+			}
+			return mLastFence;
+		}
+
+		bool IsFenceComplete(unsigned long long fence) override
+		{
+			if (fence > mCompletedFence && ++mNumberOfPolls >= kPollsToComplete)
+			{
+				mCompletedFence++;
+				mNumberOfPolls = 0;
+			}
+			return fence <= mCompletedFence;
+		}
+
+		unsigned long long GetLastFence() { return mLastFence; }
+		unsigned long long GetCompletedFence() { return mCompletedFence; }
+	private:
+		// Far more than the one poll a write makes without waiting, so only a stall ever moves the GPU on.
+		static const unsigned int kPollsToComplete = 1000;
+
+		unsigned long long mFramesBehind;
+		unsigned long long mLastFence;
+		unsigned long long mCompletedFence;
+		unsigned int mNumberOfPolls;
+	};
+
+	struct Range
+	{
+		unsigned int start;
+		unsigned int end;
+	};
+
+	bool Overlaps(const Range& first, const Range& second)
+	{
+		return first.start < second.end && second.start < first.end;
+	}
+
+	// Everything written during a frame, along with the fence which ended it.
+	struct WrittenFrame
+	{
+		unsigned long long fence;
+		std::vector<Range> ranges;
+	};
+
+	const unsigned int kRingSize = 4096;
+}
+
+TEST(WritesNeverOverlapAFrameInFlight)
+{
+	// Far enough behind that the frames in flight hold more than the ring, so writes have to wait on the GPU at times.
+	CLateFenceDevice device(8);
+	CFrameRingBuffer ring(&device, CRenderDevice::VertexBuffer, kRingSize);
+	CHECK(ring.Initialise());
+
+	std::mt19937 random(7);
+	std::vector<WrittenFrame> frames;
+	// Small enough that a whole frame, padding and wrapping included, always fits in the ring.
+	std::vector<unsigned char> data(kRingSize / 8);
+	unsigned int numberOfWraps = 0;
+	unsigned int numberOfStalls = 0;
+	bool allWritten = true;
+	bool allAligned = true;
+	bool anyOverlap = false;
+
+	for (unsigned int frame = 0; frame < 200; frame++)
+	{
+		WrittenFrame written;
+		const unsigned int numberOfWrites = 1 + random() % 4;
+
+		for (unsigned int write = 0; write < numberOfWrites; write++)
+		{
+			const unsigned int size = 1 + random() % static_cast<unsigned int>(data.size());
+			const unsigned int alignment = write % 2 == 0 ? 16 : 4;
+
+			unsigned int offset = 0;
+			if (!ring.Write(data.data(), size, alignment, offset))
+			{
+				allWritten = false;
+				continue;
+			}
+
+			const Range range = { offset, offset + size };
+			allAligned = allAligned && offset % alignment == 0 && range.end <= kRingSize;
+
+			// Anything the GPU may still be reading must be left alone, which is every earlier write this frame too.
+			for (auto& earlier : written.ranges)
+			{
+				anyOverlap = anyOverlap || Overlaps(range, earlier);
+			}
+			for (auto& inFlight : frames)
+			{
+				if (inFlight.fence <= device.GetCompletedFence())
+				{
+					continue;
+				}
+				for (auto& earlier : inFlight.ranges)
+				{
+					anyOverlap = anyOverlap || Overlaps(range, earlier);
+				}
+			}
+
+			written.ranges.push_back(range);
+		}
+
+		ring.EndFrame();
+		written.fence = device.GetLastFence();
+		frames.push_back(written);
+
+		numberOfWraps += ring.GetLastFrameStatistics().wraps;
+		numberOfStalls += ring.GetLastFrameStatistics().stalls;
+	}
+
+	CHECK(allWritten);
+	CHECK(allAligned);
+	CHECK(!anyOverlap);
+	// Over that many frames the ring has to have gone round, and caught up with the GPU, more than once.
+	CHECK(numberOfWraps > 1);
+	CHECK(numberOfStalls > 1);
+}
+
+TEST(WrapsAndStallsAreCounted)
+{
+	// Too far behind to ever catch up on its own, so the second frame has to wait on the first.
+	CLateFenceDevice device(100);
+	CFrameRingBuffer ring(&device, CRenderDevice::VertexBuffer, 1024);
+	CHECK(ring.Initialise());
+
+	std::vector<unsigned char> data(600);
+	unsigned int offset = 0;
+
+	CHECK(ring.Write(data.data(), 600, 4, offset));
+	CHECK(offset == 0);
+	ring.EndFrame();
+	CHECK(ring.GetLastFrameStatistics().allocations == 1);
+	CHECK(ring.GetLastFrameStatistics().wraps == 0);
+	CHECK(ring.GetLastFrameStatistics().stalls == 0);
+	CHECK(device.GetCompletedFence() == 0);
+
+	// Doesn't fit after the first write, so goes back to the start, where the first frame is still being read.
+	CHECK(ring.Write(data.data(), 600, 4, offset));
+	CHECK(offset == 0);
+	CHECK(device.GetCompletedFence() == 1);
+	ring.EndFrame();
+	CHECK(ring.GetLastFrameStatistics().wraps == 1);
+	CHECK(ring.GetLastFrameStatistics().stalls == 1);
+	// The space skipped at the end to wrap counts against the frame which skipped it.
+	CHECK(ring.GetLastFrameStatistics().peakBytesInUse == 1024);
+
+	// Fits straight after, but the skipped space still belongs to the second frame, so this waits again without wrapping.
+	CHECK(ring.Write(data.data(), 100, 4, offset));
+	CHECK(offset == 600);
+	ring.EndFrame();
+	CHECK(ring.GetLastFrameStatistics().wraps == 0);
+	CHECK(ring.GetLastFrameStatistics().stalls == 1);
+	CHECK(ring.GetLastFrameStatistics().failedAllocations == 0);
+}
+
+TEST(WritesLargerThanTheRingAreRejected)
+{
+	CLateFenceDevice device(2);
+	CFrameRingBuffer ring(&device, CRenderDevice::VertexBuffer, kRingSize);
+	CHECK(ring.Initialise());
+
+	std::vector<unsigned char> data(kRingSize + 1);
+	unsigned int offset = 12345;
+
+	CHECK(!ring.Write(data.data(), kRingSize + 1, 4, offset));
+	CHECK(offset == 12345);
+	CHECK(!ring.Write(data.data(), 0, 4, offset));
+
+	// Nothing was taken by the failed writes, so the whole ring is still there.
+	CHECK(ring.Write(data.data(), kRingSize, 4, offset));
+	CHECK(offset == 0);
+
+	// One frame can't use more than the whole ring, there's nothing earlier to wait on.
+	CHECK(!ring.Write(data.data(), 16, 4, offset));
+
+	ring.EndFrame();
+	CHECK(ring.GetLastFrameStatistics().allocations == 1);
+	CHECK(ring.GetLastFrameStatistics().failedAllocations == 3);
+	CHECK(ring.GetLastFrameStatistics().stalls == 0);
+	CHECK(device.GetNumberOfErrors() == 0);
+}
@@ -0,0 +1,110 @@
+#include "Test.h"
+#include "Frustum.h"
+#include <random>
+
+namespace
+{
+	const unsigned int kNumberOfObjects = 16384;
+	const unsigned int kIterations = 200;
+
+	void ConstructBenchmarkFrustum(CFrustum& frustum)
+	{
+		D3DXMATRIX projMatrix;
+		D3DXMatrixPerspectiveFovLH(&projMatrix, static_cast<float>(D3DX_PI) / 4.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+
+		D3DXMATRIX viewMatrix;
+		D3DXMatrixRotationY(&viewMatrix, 0.5f);
+
+		frustum.ConstructFrustum(1000.0f, projMatrix, viewMatrix);
+	}
+
+	// Scattered over a terrain sized area around the camera, roughly how the scenery is laid out.
+	std::vector<float> RandomValues(unsigned int count, float minimum, float maximum, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> distribution(minimum, maximum);
+
+		std::vector<float> values(count);
+		for (auto& value : values)
+		{
+			value = distribution(random);
+		}
+		return values;
+	}
+}
+
+TEST(BenchmarkSpheres)
+{
+	CFrustum frustum;
+	ConstructBenchmarkFrustum(frustum);
+
+	const std::vector<float> x = RandomValues(kNumberOfObjects, -1000.0f, 1000.0f, 1);
+	const std::vector<float> y = RandomValues(kNumberOfObjects, -50.0f, 50.0f, 2);
+	const std::vector<float> z = RandomValues(kNumberOfObjects, -1000.0f, 1000.0f, 3);
+	const std::vector<float> radius = RandomValues(kNumberOfObjects, 1.0f, 10.0f, 4);
+
+	unsigned int scalarVisible = 0;
+	PrioTest::Benchmark("CheckSphere x " + std::to_string(kNumberOfObjects), kIterations, [&]()
+	{
+		scalarVisible = 0;
+		for (unsigned int i = 0; i < kNumberOfObjects; i++)
+		{
+			scalarVisible += frustum.CheckSphere(D3DXVECTOR3(x[i], y[i], z[i]), radius[i]) ? 1 : 0;
+		}
+	});
+
+	std::vector<unsigned int> visibleMasks(kNumberOfObjects / 32);
+	PrioTest::Benchmark("CullSpheres x " + std::to_string(kNumberOfObjects), kIterations, [&]()
+	{
+		frustum.CullSpheres(x.data(), y.data(), z.data(), radius.data(), kNumberOfObjects, visibleMasks.data());
+	});
+
+	std::vector<unsigned char> planeMasks(kNumberOfObjects);
+	PrioTest::Benchmark("CullSpheres with plane masks x " + std::to_string(kNumberOfObjects), kIterations, [&]()
+	{
+		frustum.CullSpheres(x.data(), y.data(), z.data(), radius.data(), kNumberOfObjects, visibleMasks.data(), CFrustum::kAllPlanes, planeMasks.data());
+	});
+
+	unsigned int batchVisible = 0;
+	for (auto mask : visibleMasks)
+	{
+		batchVisible += __builtin_popcount(mask);
+	}
+	CHECK(batchVisible == scalarVisible);
+}
+
+TEST(BenchmarkAABBs)
+{
+	CFrustum frustum;
+	ConstructBenchmarkFrustum(frustum);
+
+	const std::vector<float> x = RandomValues(kNumberOfObjects, -1000.0f, 1000.0f, 5);
+	const std::vector<float> y = RandomValues(kNumberOfObjects, -50.0f, 50.0f, 6);
+	const std::vector<float> z = RandomValues(kNumberOfObjects, -1000.0f, 1000.0f, 7);
+	const std::vector<float> extentX = RandomValues(kNumberOfObjects, 1.0f, 10.0f, 8);
+	const std::vector<float> extentY = RandomValues(kNumberOfObjects, 1.0f, 10.0f, 9);
+	const std::vector<float> extentZ = RandomValues(kNumberOfObjects, 1.0f, 10.0f, 10);
+
+	unsigned int scalarVisible = 0;
+	PrioTest::Benchmark("CheckRectangle x " + std::to_string(kNumberOfObjects), kIterations, [&]()
+	{
+		scalarVisible = 0;
+		for (unsigned int i = 0; i < kNumberOfObjects; i++)
+		{
+			scalarVisible += frustum.CheckRectangle(D3DXVECTOR3(x[i], y[i], z[i]), D3DXVECTOR3(extentX[i], extentY[i], extentZ[i])) ? 1 : 0;
+		}
+	});
+
+	std::vector<unsigned int> visibleMasks(kNumberOfObjects / 32);
+	PrioTest::Benchmark("CullAABBs x " + std::to_string(kNumberOfObjects), kIterations, [&]()
+	{
+		frustum.CullAABBs(x.data(), y.data(), z.data(), extentX.data(), extentY.data(), extentZ.data(), kNumberOfObjects, visibleMasks.data());
+	});
+
+	unsigned int batchVisible = 0;
+	for (auto mask : visibleMasks)
+	{
+		batchVisible += __builtin_popcount(mask);
+	}
+	CHECK(batchVisible == scalarVisible);
+}
@@ -0,0 +1,535 @@
+#include "Test.h"
+#include "Frustum.h"
+#include <cmath>
+#include <random>
+
+namespace
+{
+	const float kNearClip = 0.1f;
+	const float kFarClip = 1000.0f;
+
+	// Objects nearer than this to the edge of a plane are left unjudged by the reference, either answer could be right.
+	// The far plane comes from the difference of two nearly equal columns, which in floats costs the frustum about a
+	// thousandth of the far clip in where the plane ends up.
+	const double kReferenceTolerance = kFarClip * 0.001;
+
+	// A camera at the origin looking down the positive z axis, the same as the engine's default projection.
+	void GetTestMatrices(float yaw, D3DXMATRIX& viewMatrix, D3DXMATRIX& projMatrix)
+	{
+		D3DXMatrixPerspectiveFovLH(&projMatrix, static_cast<float>(D3DX_PI) / 4.0f, 16.0f / 9.0f, kNearClip, kFarClip);
+		D3DXMatrixRotationY(&viewMatrix, yaw);
+	}
+
+	void ConstructTestFrustum(CFrustum& frustum, float yaw = 0.0f)
+	{
+		D3DXMATRIX viewMatrix;
+		D3DXMATRIX projMatrix;
+		GetTestMatrices(yaw, viewMatrix, projMatrix);
+		frustum.ConstructFrustum(kFarClip, projMatrix, viewMatrix);
+	}
+
+	/* The planes taken straight from the rows of the view projection matrix in double precision, as the frustum did
+	* before it was rewritten, and objects judged one plane at a time by their distance to it. Shares nothing with
+	* CFrustum but the matrices, so the scalar and batched tests can both be checked against it. */
+	class CReferenceFrustum
+	{
+	public:
+		enum Result
+		{
+			Culled,
+			Visible,
+			TooCloseToCall
+		};
+	public:
+		CReferenceFrustum(float yaw)
+		{
+			D3DXMATRIX viewMatrix;
+			D3DXMATRIX projMatrix;
+			GetTestMatrices(yaw, viewMatrix, projMatrix);
+
+			double viewProj[4][4];
+			for (int row = 0; row < 4; row++)
+			{
+				for (int column = 0; column < 4; column++)
+				{
+					viewProj[row][column] = 0.0;
+					for (int i = 0; i < 4; i++)
+					{
+						viewProj[row][column] += static_cast<double>(viewMatrix.m[row][i]) * projMatrix.m[i][column];
+					}
+				}
+			}
+
+			// Near, far, left, right, top and bottom, the same order as the frustum's plane masks.
+			const int columns[6] = { 2, 2, 0, 0, 1, 1 };
+			const double signs[6] = { 1.0, -1.0, 1.0, -1.0, 1.0, -1.0 };
+			for (int plane = 0; plane < 6; plane++)
+			{
+				double coefficients[4];
+				for (int row = 0; row < 4; row++)
+				{
+					coefficients[row] = viewProj[row][3] + signs[plane] * viewProj[row][columns[plane]];
+				}
+				SetPlane(plane, coefficients);
+			}
+
+			mNumberOfPlanes = 6;
+		}
+
+		void SetClipPlane(const D3DXPLANE& plane)
+		{
+			const double coefficients[4] = { plane.a, plane.b, plane.c, plane.d };
+			SetPlane(6, coefficients);
+			mNumberOfPlanes = 7;
+		}
+
+		// The planes in the mask which the sphere crosses are given back in intersectedPlanes when it's visible.
+		Result CheckSphere(float x, float y, float z, float radius, unsigned int planeMask, unsigned int& intersectedPlanes) const
+		{
+			return Check(x, y, z, 0.0f, 0.0f, 0.0f, radius, planeMask, intersectedPlanes);
+		}
+
+		Result CheckBox(float x, float y, float z, float extentX, float extentY, float extentZ, unsigned int planeMask, unsigned int& intersectedPlanes) const
+		{
+			return Check(x, y, z, extentX, extentY, extentZ, 0.0f, planeMask, intersectedPlanes);
+		}
+	private:
+		void SetPlane(int plane, const double coefficients[4])
+		{
+			const double length = std::sqrt(coefficients[0] * coefficients[0] + coefficients[1] * coefficients[1] + coefficients[2] * coefficients[2]);
+			for (int i = 0; i < 4; i++)
+			{
+				mPlanes[plane][i] = coefficients[i] / length;
+			}
+		}
+
+		// A sphere is a box with no extents and a radius, a box a sphere with no radius.
+		Result Check(float x, float y, float z, float extentX, float extentY, float extentZ, float radius, unsigned int planeMask, unsigned int& intersectedPlanes) const
+		{
+			bool tooCloseToCall = false;
+			intersectedPlanes = 0;
+			for (int plane = 0; plane < mNumberOfPlanes; plane++)
+			{
+				if (!(planeMask & (1 << plane)))
+				{
+					continue;
+				}
+
+				const double distance = mPlanes[plane][0] * x + mPlanes[plane][1] * y + mPlanes[plane][2] * z + mPlanes[plane][3];
+				const double reach = radius + std::abs(mPlanes[plane][0]) * extentX + std::abs(mPlanes[plane][1]) * extentY + std::abs(mPlanes[plane][2]) * extentZ;
+
+				if (distance < -reach - kReferenceTolerance)
+				{
+					return Culled;
+				}
+				if (std::abs(distance + reach) <= kReferenceTolerance || std::abs(distance - reach) <= kReferenceTolerance)
+				{
+					tooCloseToCall = true;
+				}
+				if (distance < reach)
+				{
+					intersectedPlanes |= 1 << plane;
+				}
+			}
+			return tooCloseToCall ? TooCloseToCall : Visible;
+		}
+	private:
+		double mPlanes[7][4];
+		int mNumberOfPlanes;
+	};
+
+	struct Spheres
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> radius;
+	};
+
+	struct Boxes
+	{
+		std::vector<float> centreX;
+		std::vector<float> centreY;
+		std::vector<float> centreZ;
+		std::vector<float> extentX;
+		std::vector<float> extentY;
+		std::vector<float> extentZ;
+	};
+
+	// Spread around the camera in every direction, so plenty fall either side of and across each plane.
+	Spheres RandomSpheres(unsigned int count, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-1200.0f, 1200.0f);
+		std::uniform_real_distribution<float> size(0.0f, 200.0f);
+
+		Spheres spheres;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			spheres.x.push_back(position(random));
+			spheres.y.push_back(position(random));
+			spheres.z.push_back(position(random));
+			spheres.radius.push_back(size(random));
+		}
+		return spheres;
+	}
+
+	Boxes RandomBoxes(unsigned int count, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-1200.0f, 1200.0f);
+		std::uniform_real_distribution<float> size(0.0f, 150.0f);
+
+		Boxes boxes;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			boxes.centreX.push_back(position(random));
+			boxes.centreY.push_back(position(random));
+			boxes.centreZ.push_back(position(random));
+			boxes.extentX.push_back(size(random));
+			boxes.extentY.push_back(size(random));
+			boxes.extentZ.push_back(size(random));
+		}
+		return boxes;
+	}
+
+	bool IsVisible(const std::vector<unsigned int>& visibleMasks, unsigned int index)
+	{
+		return (visibleMasks[index / 32] & (1u << (index % 32))) != 0;
+	}
+
+	/* Compares every sphere from the batch against CheckSphere, both whether it's visible and which planes it crosses,
+	* and CheckSphere against the reference wherever the reference can tell.
+	* @Returns unsigned int How many spheres were visible. */
+	unsigned int CheckSpheresMatch(CFrustum& frustum, const CReferenceFrustum& reference, const Spheres& spheres, unsigned int planeMask)
+	{
+		const unsigned int count = static_cast<unsigned int>(spheres.x.size());
+		std::vector<unsigned int> visibleMasks((count + 31) / 32, 0xffffffff);
+		std::vector<unsigned int> visibleMasksWithPlanes((count + 31) / 32, 0xffffffff);
+		std::vector<unsigned char> planeMasks(count, 0xff);
+
+		frustum.CullSpheres(spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.radius.data(), count, visibleMasks.data(), planeMask);
+		frustum.CullSpheres(spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.radius.data(), count, visibleMasksWithPlanes.data(), planeMask, planeMasks.data());
+
+		unsigned int numberVisible = 0;
+		unsigned int numberJudged = 0;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			unsigned int scalarMask = planeMask;
+			const bool visible = frustum.CheckSphere(D3DXVECTOR3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i], scalarMask);
+
+			unsigned int referenceMask = 0;
+			const CReferenceFrustum::Result expected = reference.CheckSphere(spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i], planeMask, referenceMask);
+			if (expected != CReferenceFrustum::TooCloseToCall)
+			{
+				numberJudged++;
+				CHECK(visible == (expected == CReferenceFrustum::Visible));
+				CHECK(!visible || scalarMask == referenceMask);
+			}
+
+			CHECK(IsVisible(visibleMasks, i) == visible);
+			CHECK(IsVisible(visibleMasksWithPlanes, i) == visible);
+			if (visible)
+			{
+				CHECK(planeMasks[i] == scalarMask);
+				numberVisible++;
+			}
+		}
+
+		// Bits past the end of the batch are left clear.
+		if (count % 32 != 0)
+		{
+			CHECK((visibleMasks.back() >> (count % 32)) == 0);
+		}
+
+		// Only a few should sit close enough to a plane for the reference to leave them.
+		CHECK(numberJudged * 10 >= count * 9);
+
+		return numberVisible;
+	}
+
+	unsigned int CheckBoxesMatch(CFrustum& frustum, const CReferenceFrustum& reference, const Boxes& boxes, unsigned int planeMask)
+	{
+		const unsigned int count = static_cast<unsigned int>(boxes.centreX.size());
+		std::vector<unsigned int> visibleMasks((count + 31) / 32, 0xffffffff);
+		std::vector<unsigned int> visibleMasksWithPlanes((count + 31) / 32, 0xffffffff);
+		std::vector<unsigned char> planeMasks(count, 0xff);
+
+		frustum.CullAABBs(boxes.centreX.data(), boxes.centreY.data(), boxes.centreZ.data(), boxes.extentX.data(), boxes.extentY.data(),
+			boxes.extentZ.data(), count, visibleMasks.data(), planeMask);
+		frustum.CullAABBs(boxes.centreX.data(), boxes.centreY.data(), boxes.centreZ.data(), boxes.extentX.data(), boxes.extentY.data(),
+			boxes.extentZ.data(), count, visibleMasksWithPlanes.data(), planeMask, planeMasks.data());
+
+		unsigned int numberVisible = 0;
+		unsigned int numberJudged = 0;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			unsigned int scalarMask = planeMask;
+			const bool visible = frustum.CheckRectangle(D3DXVECTOR3(boxes.centreX[i], boxes.centreY[i], boxes.centreZ[i]),
+				D3DXVECTOR3(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]), scalarMask);
+
+			unsigned int referenceMask = 0;
+			const CReferenceFrustum::Result expected = reference.CheckBox(boxes.centreX[i], boxes.centreY[i], boxes.centreZ[i],
+				boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i], planeMask, referenceMask);
+			if (expected != CReferenceFrustum::TooCloseToCall)
+			{
+				numberJudged++;
+				CHECK(visible == (expected == CReferenceFrustum::Visible));
+				CHECK(!visible || scalarMask == referenceMask);
+			}
+
+			CHECK(IsVisible(visibleMasks, i) == visible);
+			CHECK(IsVisible(visibleMasksWithPlanes, i) == visible);
+			if (visible)
+			{
+				CHECK(planeMasks[i] == scalarMask);
+				numberVisible++;
+			}
+		}
+
+		if (count % 32 != 0)
+		{
+			CHECK((visibleMasks.back() >> (count % 32)) == 0);
+		}
+
+		// Only a few should sit close enough to a plane for the reference to leave them.
+		CHECK(numberJudged * 10 >= count * 9);
+
+		return numberVisible;
+	}
+}
+
+TEST(SphereInFrontIsVisible)
+{
+	CFrustum frustum;
+	ConstructTestFrustum(frustum);
+
+	CHECK(frustum.CheckSphere(D3DXVECTOR3(0.0f, 0.0f, 50.0f), 1.0f));
+	CHECK(frustum.CheckPoint(0.0f, 0.0f, 50.0f));
+	CHECK(frustum.CheckRectangle(D3DXVECTOR3(0.0f, 0.0f, 50.0f), D3DXVECTOR3(1.0f, 1.0f, 1.0f)));
+}
+
+TEST(SphereBehindIsCulled)
+{
+	CFrustum frustum;
+	ConstructTestFrustum(frustum);
+
+	CHECK(!frustum.CheckSphere(D3DXVECTOR3(0.0f, 0.0f, -50.0f), 1.0f));
+	CHECK(!frustum.CheckPoint(0.0f, 0.0f, -50.0f));
+	CHECK(!frustum.CheckRectangle(D3DXVECTOR3(0.0f, 0.0f, -50.0f), D3DXVECTOR3(1.0f, 1.0f, 1.0f)));
+	CHECK(!frustum.CheckSphere(D3DXVECTOR3(0.0f, 0.0f, kFarClip + 50.0f), 1.0f));
+}
+
+TEST(SphereAcrossPlaneReportsIt)
+{
+	CFrustum frustum;
+	ConstructTestFrustum(frustum);
+
+	// Crosses the far plane, but nowhere near any other.
+	unsigned int planeMask = CFrustum::kAllPlanes;
+	CHECK(frustum.CheckSphere(D3DXVECTOR3(0.0f, 0.0f, kFarClip - 0.5f), 1.0f, planeMask));
+	CHECK(planeMask == 2u);
+
+	// Entirely inside, so the children of this node wouldn't have any planes left to test.
+	planeMask = CFrustum::kAllPlanes;
+	CHECK(frustum.CheckSphere(D3DXVECTOR3(0.0f, 0.0f, 100.0f), 1.0f, planeMask));
+	CHECK(planeMask == 0u);
+}
+
+TEST(ClipPlaneCullsOneSide)
+{
+	CFrustum frustum;
+	ConstructTestFrustum(frustum);
+
+	// Only keep what's above y = 5, as the reflection does with the water.
+	frustum.SetClipPlane(D3DXPLANE(0.0f, 1.0f, 0.0f, -5.0f));
+	CHECK(frustum.CheckSphere(D3DXVECTOR3(0.0f, 10.0f, 100.0f), 1.0f));
+	CHECK(!frustum.CheckSphere(D3DXVECTOR3(0.0f, 0.0f, 100.0f), 1.0f));
+	CHECK(!frustum.CheckRectangle(D3DXVECTOR3(0.0f, 0.0f, 100.0f), D3DXVECTOR3(1.0f, 1.0f, 1.0f)));
+
+	// Rebuilding the frustum keeps the clip plane, it's only removed when it's cleared.
+	ConstructTestFrustum(frustum);
+	CHECK(!frustum.CheckSphere(D3DXVECTOR3(0.0f, 0.0f, 100.0f), 1.0f));
+
+	frustum.ClearClipPlane();
+	CHECK(frustum.CheckSphere(D3DXVECTOR3(0.0f, 0.0f, 100.0f), 1.0f));
+}
+
+TEST(CullSpheresMatchesCheckSphere)
+{
+	CFrustum frustum;
+	ConstructTestFrustum(frustum, 0.7f);
+	const CReferenceFrustum reference(0.7f);
+
+	// Counts which leave partial groups of four and partial words of the mask.
+	const unsigned int counts[] = { 1, 3, 4, 31, 32, 33, 1021 };
+	unsigned int seed = 1;
+	for (auto count : counts)
+	{
+		const Spheres spheres = RandomSpheres(count, seed++);
+		CheckSpheresMatch(frustum, reference, spheres, CFrustum::kAllPlanes);
+	}
+
+	const unsigned int numberVisible = CheckSpheresMatch(frustum, reference, RandomSpheres(4096, 100), CFrustum::kAllPlanes);
+	// Make sure the random spheres actually tested both outcomes.
+	CHECK(numberVisible > 0 && numberVisible < 4096);
+}
+
+TEST(CullAABBsMatchesCheckRectangle)
+{
+	CFrustum frustum;
+	ConstructTestFrustum(frustum, -1.3f);
+	const CReferenceFrustum reference(-1.3f);
+
+	const unsigned int counts[] = { 1, 3, 4, 31, 32, 33, 1021 };
+	unsigned int seed = 200;
+	for (auto count : counts)
+	{
+		const Boxes boxes = RandomBoxes(count, seed++);
+		CheckBoxesMatch(frustum, reference, boxes, CFrustum::kAllPlanes);
+	}
+
+	const unsigned int numberVisible = CheckBoxesMatch(frustum, reference, RandomBoxes(4096, 300), CFrustum::kAllPlanes);
+	CHECK(numberVisible > 0 && numberVisible < 4096);
+}
+
+TEST(InheritedPlaneMasksMatchScalar)
+{
+	CFrustum frustum;
+	ConstructTestFrustum(frustum, 2.1f);
+	frustum.SetClipPlane(D3DXPLANE(0.0f, 1.0f, 0.0f, 20.0f));
+	CReferenceFrustum reference(2.1f);
+	reference.SetClipPlane(D3DXPLANE(0.0f, 1.0f, 0.0f, 20.0f));
+
+	const Spheres spheres = RandomSpheres(1000, 400);
+	const Boxes boxes = RandomBoxes(1000, 401);
+
+	// Every subset of the seven planes, as a parent node could pass down.
+	for (unsigned int planeMask = 0; planeMask <= CFrustum::kAllPlanes; planeMask++)
+	{
+		CheckSpheresMatch(frustum, reference, spheres, planeMask);
+		CheckBoxesMatch(frustum, reference, boxes, planeMask);
+	}
+
+	// With no planes left to test everything is visible.
+	CHECK(CheckSpheresMatch(frustum, reference, spheres, 0) == 1000);
+}
+
+TEST(ChildrenOfVisibleParentAgree)
+{
+	CFrustum frustum;
+	ConstructTestFrustum(frustum, 0.3f);
+
+	// A parent sphere, and children inside it tested only against the planes the parent crosses.
+	std::mt19937 random(500);
+	std::uniform_real_distribution<float> offset(-40.0f, 40.0f);
+	std::uniform_real_distribution<float> size(0.0f, 10.0f);
+
+	for (unsigned int parent = 0; parent < 200; parent++)
+	{
+		const D3DXVECTOR3 parentCentre(offset(random) * 10.0f, offset(random) * 2.0f, offset(random) * 10.0f + 300.0f);
+		const float parentRadius = 60.0f;
+
+		unsigned int parentMask = CFrustum::kAllPlanes;
+		if (!frustum.CheckSphere(parentCentre, parentRadius, parentMask))
+		{
+			continue;
+		}
+
+		for (unsigned int child = 0; child < 16; child++)
+		{
+			const D3DXVECTOR3 childCentre(parentCentre.x + offset(random) * 0.5f, parentCentre.y + offset(random) * 0.5f, parentCentre.z + offset(random) * 0.5f);
+			const float childRadius = size(random);
+
+			unsigned int inheritedMask = parentMask;
+			const bool inherited = frustum.CheckSphere(childCentre, childRadius, inheritedMask);
+			const bool full = frustum.CheckSphere(childCentre, childRadius);
+
+			CHECK(inherited == full);
+		}
+	}
+}
+
+TEST(WaterClipPlaneOnlyCullsTheReflection)
+{
+	const float waterHeight = 5.0f;
+	const D3DXVECTOR3 cameraPos(0.0f, 25.0f, 0.0f);
+	const D3DXVECTOR3 lookAt(0.0f, 15.0f, 100.0f);
+	const D3DXVECTOR3 up(0.0f, 1.0f, 0.0f);
+	D3DXMATRIX projMatrix;
+	D3DXMatrixPerspectiveFovLH(&projMatrix, static_cast<float>(D3DX_PI) / 4.0f, 16.0f / 9.0f, kNearClip, kFarClip);
+
+	// The main camera looking down at the water, and the reflection camera mirrored below it looking up, as the camera
+	// sets them up. The reflection's frustum is clipped to what's above the water, the main view's isn't.
+	D3DXMATRIX mainView;
+	D3DXMatrixLookAtLH(&mainView, &cameraPos, &lookAt, &up);
+	CFrustum mainFrustum;
+	mainFrustum.ConstructFrustum(kFarClip, projMatrix, mainView);
+
+	const D3DXVECTOR3 reflectionPos(cameraPos.x, waterHeight * 2.0f - cameraPos.y, cameraPos.z);
+	const D3DXVECTOR3 reflectionLookAt(lookAt.x, waterHeight * 2.0f - lookAt.y, lookAt.z);
+	D3DXMATRIX reflectionView;
+	D3DXMatrixLookAtLH(&reflectionView, &reflectionPos, &reflectionLookAt, &up);
+	CFrustum reflectionFrustum;
+	reflectionFrustum.ConstructFrustum(kFarClip, projMatrix, reflectionView);
+	CFrustum unclippedReflectionFrustum = reflectionFrustum;
+	reflectionFrustum.SetClipPlane(D3DXPLANE(0.0f, 1.0f, 0.0f, -waterHeight));
+
+	// A row of objects entirely below the water, and a row above it, both in front of either camera.
+	const unsigned int kNumberOfObjects = 40;
+	Spheres spheres;
+	Boxes boxes;
+	for (unsigned int i = 0; i < kNumberOfObjects * 2; i++)
+	{
+		const bool below = i < kNumberOfObjects;
+		const float x = (static_cast<float>(i % kNumberOfObjects) - kNumberOfObjects / 2.0f) * 1.5f;
+		const float y = below ? waterHeight - 6.0f : waterHeight + 6.0f;
+		const float z = 100.0f + static_cast<float>(i % kNumberOfObjects) * 5.0f;
+		spheres.x.push_back(x);
+		spheres.y.push_back(y);
+		spheres.z.push_back(z);
+		spheres.radius.push_back(5.0f);
+		boxes.centreX.push_back(x);
+		boxes.centreY.push_back(y);
+		boxes.centreZ.push_back(z);
+		boxes.extentX.push_back(3.0f);
+		boxes.extentY.push_back(5.0f);
+		boxes.extentZ.push_back(3.0f);
+	}
+
+	// The batched tests the visibility system culls each view with, and the scalar ones.
+	const unsigned int count = kNumberOfObjects * 2;
+	auto cull = [&](CFrustum& frustum, std::vector<unsigned int>& sphereMasks, std::vector<unsigned int>& boxMasks)
+	{
+		sphereMasks.assign((count + 31) / 32, 0);
+		boxMasks.assign((count + 31) / 32, 0);
+		frustum.CullSpheres(spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.radius.data(), count, sphereMasks.data());
+		frustum.CullAABBs(boxes.centreX.data(), boxes.centreY.data(), boxes.centreZ.data(), boxes.extentX.data(), boxes.extentY.data(),
+			boxes.extentZ.data(), count, boxMasks.data());
+	};
+
+	std::vector<unsigned int> mainSpheres, mainBoxes, reflectionSpheres, reflectionBoxes, unclippedSpheres, unclippedBoxes;
+	cull(mainFrustum, mainSpheres, mainBoxes);
+	cull(reflectionFrustum, reflectionSpheres, reflectionBoxes);
+	cull(unclippedReflectionFrustum, unclippedSpheres, unclippedBoxes);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const bool below = i < kNumberOfObjects;
+		const D3DXVECTOR3 centre(spheres.x[i], spheres.y[i], spheres.z[i]);
+		const D3DXVECTOR3 extents(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+
+		CHECK(IsVisible(mainSpheres, i));
+		CHECK(IsVisible(mainBoxes, i));
+		CHECK(mainFrustum.CheckSphere(centre, spheres.radius[i]));
+		CHECK(mainFrustum.CheckRectangle(centre, extents));
+
+		// Everything is in front of the reflection camera, so it's only the clip plane which rejects what's below the water.
+		CHECK(IsVisible(unclippedSpheres, i));
+		CHECK(IsVisible(unclippedBoxes, i));
+		CHECK(IsVisible(reflectionSpheres, i) == !below);
+		CHECK(IsVisible(reflectionBoxes, i) == !below);
+		CHECK(reflectionFrustum.CheckSphere(centre, spheres.radius[i]) == !below);
+		CHECK(reflectionFrustum.CheckRectangle(centre, extents) == !below);
+	}
+}
@@ -0,0 +1,42 @@
+#include "Test.h"
+#include "Image.h"
+
+namespace
+{
+	const std::string kResources = std::string(PRIO_ENGINE_DIRECTORY) + "/Resources/";
+	const unsigned int kIterations = 20;
+
+	// Opened once, so only the decode is timed and not the read from disk.
+	void BenchmarkDecode(const std::string& filename, bool generateMips)
+	{
+		CImage image;
+		CHECK(image.Open(kResources + filename));
+
+		bool decoded = true;
+		PrioTest::Benchmark("Decode " + filename + (generateMips ? " with mips" : ""), kIterations, [&]()
+		{
+			decoded &= image.Decode(generateMips);
+		});
+		CHECK(decoded);
+	}
+}
+
+TEST(BenchmarkPNG)
+{
+	BenchmarkDecode("Textures/Branches0030_1_M.png", false);
+	BenchmarkDecode("Textures/Branches0030_1_M.png", true);
+	BenchmarkDecode("Textures/Foliage/Grass.png", true);
+	BenchmarkDecode("Textures/Foliage/ReedsAlpha.png", true);
+}
+
+TEST(BenchmarkTGA)
+{
+	BenchmarkDecode("Fonts/font01.tga", true);
+}
+
+TEST(BenchmarkDDS)
+{
+	// Used straight from the file, so this is only the cost of reading the header and generating mips.
+	BenchmarkDecode("Textures/Stone.dds", false);
+	BenchmarkDecode("Textures/Stone.dds", true);
+}
@@ -0,0 +1,245 @@
+#include "Test.h"
+#include "Image.h"
+#include "PrioEngineVars.h"
+#include <fstream>
+#include <random>
+#include <cstring>
+
+namespace
+{
+	const std::string kResources = std::string(PRIO_ENGINE_DIRECTORY) + "/Resources/";
+
+	struct KnownImage
+	{
+		const char* filename;
+		unsigned int width;
+		unsigned int height;
+		// FNV-1a of the decoded RGBA texels of the top level, worked out by a separate decoder.
+		unsigned long long hash;
+	};
+
+	// One of each kind of PNG the repo holds, and the one TGA.
+	const KnownImage kKnownImages[] =
+	{
+		{ "Textures/WaterNormalHeight.png", 512, 512, 0x9a3ef4f460caaa54ULL },
+		{ "Textures/Foliage/Grass.png", 412, 285, 0x7f3994ef6729c063ULL },
+		{ "Textures/Foliage/ReedsAlpha.png", 872, 440, 0x22c3a284af14bceeULL },
+		{ "Textures/Foliage/GrassAlpha.png", 412, 285, 0x0a18ee3e441f3a20ULL },
+		{ "Fonts/font01.tga", 1024, 32, 0x460210e40bc7a1b0ULL }
+	};
+
+	std::vector<unsigned char> ReadFile(const std::string& filename)
+	{
+		std::ifstream file(filename.c_str(), std::ios::binary);
+		return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	void WriteFile(const std::string& filename, const std::vector<unsigned char>& contents)
+	{
+		std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+	}
+
+	// Written to the working directory then decoded, so it goes through the same path as a real file.
+	bool DecodeBytes(const std::string& filename, const std::vector<unsigned char>& contents)
+	{
+		WriteFile(filename, contents);
+
+		CImage image;
+		if (!image.Open(filename))
+		{
+			return false;
+		}
+		const bool decoded = image.Decode();
+
+		// Whatever went wrong, a failed decode mustn't leave anything half set up.
+		CHECK(decoded || (!image.IsDecoded() && image.GetNumberOfMipLevels() == 0));
+		return decoded;
+	}
+
+	void CheckMipChain(CImage& image)
+	{
+		CHECK(image.GetNumberOfMipLevels() == CImage::CalculateNumberOfMipLevels(image.GetWidth(), image.GetHeight()));
+
+		for (unsigned int level = 1; level < image.GetNumberOfMipLevels(); level++)
+		{
+			const CImage::MipLevel& mip = image.GetMipLevel(level);
+			CHECK(mip.width == std::max(1u, image.GetWidth() >> level));
+			CHECK(mip.height == std::max(1u, image.GetHeight() >> level));
+			CHECK(mip.data != nullptr);
+		}
+	}
+}
+
+TEST(KnownImagesDecode)
+{
+	for (auto& known : kKnownImages)
+	{
+		CImage image;
+		CHECK(image.Open(kResources + known.filename));
+		CHECK(image.Decode());
+
+		CHECK(image.GetFormat() == CImage::RGBA8Format);
+		CHECK(image.GetWidth() == known.width);
+		CHECK(image.GetHeight() == known.height);
+
+		const CImage::MipLevel& top = image.GetMipLevel(0);
+		CHECK(top.rowPitch == known.width * 4);
+		CHECK(top.size == known.width * known.height * 4);
+		CHECK(PrioEngine::Hash::FNV1a(top.data, top.size) == known.hash);
+
+		CheckMipChain(image);
+	}
+}
+
+TEST(MipsAreOnlyGeneratedWhenAsked)
+{
+	CImage image;
+	CHECK(image.Open(kResources + "Textures/WaterNormalHeight.png"));
+	CHECK(image.Decode(false));
+	CHECK(image.GetNumberOfMipLevels() == 1);
+}
+
+TEST(GeneratedMipsAverageTheLevelAbove)
+{
+	CImage image;
+	CHECK(image.Open(kResources + "Textures/WaterNormalHeight.png"));
+	CHECK(image.Decode());
+
+	const CImage::MipLevel& top = image.GetMipLevel(0);
+	const CImage::MipLevel& next = image.GetMipLevel(1);
+
+	// A 2x2 box filter, rounded either way.
+	for (unsigned int channel = 0; channel < 4; channel++)
+	{
+		const unsigned int sum = top.data[channel] + top.data[4 + channel] + top.data[top.rowPitch + channel] + top.data[top.rowPitch + 4 + channel];
+		CHECK(next.data[channel] >= sum / 4 && next.data[channel] <= (sum + 3) / 4);
+	}
+}
+
+TEST(DDSIsUsedStraightFromTheFile)
+{
+	struct KnownDDS
+	{
+		const char* filename;
+		unsigned int width;
+		unsigned int height;
+		CImage::PixelFormat format;
+	};
+
+	// None of these have a mip chain of their own.
+	const KnownDDS kKnownDDS[] =
+	{
+		{ "Textures/Ice.dds", 320, 320, CImage::BGRA8Format },
+		{ "Textures/Dirt.dds", 600, 450, CImage::BGRX8Format },
+		{ "Textures/Sand.dds", 500, 300, CImage::BGRX8Format }
+	};
+
+	for (auto& known : kKnownDDS)
+	{
+		CImage image;
+		CHECK(image.Open(kResources + known.filename));
+		CHECK(image.Decode());
+
+		CHECK(image.GetFormat() == known.format);
+		CHECK(image.GetWidth() == known.width);
+		CHECK(image.GetHeight() == known.height);
+
+		// Nothing is copied, the top level is a view of the file straight after the header.
+		const CImage::MipLevel& top = image.GetMipLevel(0);
+		CHECK(top.data == image.GetFileData() + 128);
+		CHECK(top.size == known.width * known.height * 4);
+		CHECK(top.data + top.size == image.GetFileData() + image.GetFileSize());
+
+		CheckMipChain(image);
+	}
+}
+
+/* Stored as RGBX, which has no DXGI format of its own, so it's copied with the unused alpha filled in. */
+TEST(DDSWithoutAlphaIsMadeOpaque)
+{
+	CImage image;
+	CHECK(image.Open(kResources + "Fonts/font.dds"));
+	CHECK(image.Decode());
+
+	CHECK(image.GetFormat() == CImage::RGBA8Format);
+	CHECK(image.GetWidth() == 1024 && image.GetHeight() == 16);
+
+	const CImage::MipLevel& top = image.GetMipLevel(0);
+	const unsigned char* stored = image.GetFileData() + 128;
+	CHECK(top.data != stored);
+
+	bool matches = true;
+	for (unsigned int texel = 0; texel < image.GetWidth() * image.GetHeight(); texel++)
+	{
+		matches &= memcmp(top.data + texel * 4, stored + texel * 4, 3) == 0 && top.data[texel * 4 + 3] == 0xFF;
+	}
+	CHECK(matches);
+}
+
+TEST(DDSMipChainIsUsedAsItIs)
+{
+	CImage image;
+	CHECK(image.Open(kResources + "Textures/raindrop.dds"));
+	CHECK(image.Decode());
+
+	CHECK(image.GetFormat() == CImage::BC2Format);
+	CHECK(image.GetWidth() == 16 && image.GetHeight() == 16);
+	CHECK(image.GetNumberOfMipLevels() == 5);
+
+	// Every level follows on from the one before, blocks are never smaller than 4x4 texels.
+	const unsigned char* expected = image.GetFileData() + 128;
+	for (unsigned int level = 0; level < image.GetNumberOfMipLevels(); level++)
+	{
+		const CImage::MipLevel& mip = image.GetMipLevel(level);
+		const unsigned int blocks = std::max(1u, (16u >> level) / 4);
+		CHECK(mip.data == expected);
+		CHECK(mip.size == blocks * blocks * 16);
+		CHECK(mip.rowPitch == blocks * 16);
+		expected += mip.size;
+	}
+	CHECK(expected == image.GetFileData() + image.GetFileSize());
+}
+
+TEST(CorruptImagesAreRefused)
+{
+	const std::vector<unsigned char> png = ReadFile(kResources + "Textures/WaterNormalHeight.png");
+	const std::vector<unsigned char> tga = ReadFile(kResources + "Fonts/font01.tga");
+	const std::vector<unsigned char> dds = ReadFile(kResources + "Textures/Ice.dds");
+	CHECK(!png.empty() && !tga.empty() && !dds.empty());
+
+	// Cut off part way through the data, or part way through the header.
+	for (auto length : { png.size() / 2, static_cast<size_t>(40), static_cast<size_t>(9) })
+	{
+		CHECK(!DecodeBytes("Truncated.png", std::vector<unsigned char>(png.begin(), png.begin() + length)));
+	}
+	CHECK(!DecodeBytes("Truncated.tga", std::vector<unsigned char>(tga.begin(), tga.begin() + tga.size() / 2)));
+	CHECK(!DecodeBytes("Truncated.tga", std::vector<unsigned char>(tga.begin(), tga.begin() + 10)));
+	CHECK(!DecodeBytes("Truncated.dds", std::vector<unsigned char>(dds.begin(), dds.begin() + dds.size() / 2)));
+	CHECK(!DecodeBytes("Truncated.dds", std::vector<unsigned char>(dds.begin(), dds.begin() + 64)));
+
+	// The compressed data scrambled after the zlib header.
+	std::vector<unsigned char> scrambled = png;
+	std::mt19937 random(1);
+	for (size_t i = 200; i < scrambled.size() - 100; i++)
+	{
+		scrambled[i] = static_cast<unsigned char>(random());
+	}
+	CHECK(!DecodeBytes("Scrambled.png", scrambled));
+
+	// Claiming to be far larger than the file.
+	std::vector<unsigned char> huge = dds;
+	const unsigned int hugeSize = 0x10000;
+	memcpy(huge.data() + 12, &hugeSize, sizeof(hugeSize));
+	memcpy(huge.data() + 16, &hugeSize, sizeof(hugeSize));
+	CHECK(!DecodeBytes("Huge.dds", huge));
+
+	// Not an image at all.
+	std::vector<unsigned char> noise(4096);
+	for (auto& byte : noise)
+	{
+		byte = static_cast<unsigned char>(random());
+	}
+	CHECK(!DecodeBytes("Noise.tga", noise));
+	CHECK(!DecodeBytes("Noise.png", noise));
+}
@@ -0,0 +1,151 @@
+#include "Test.h"
+#include "MeshOptimiser.h"
+#include <algorithm>
+#include <array>
+#include <random>
+
+namespace
+{
+	// Wider than the simulated cache, so even drawn row by row most vertices have left it by the time the next row needs them.
+	const unsigned int kGridSize = 64;
+
+	// A square grid of quads in the xz plane, two triangles a quad, drawn a row at a time.
+	void CreateGrid(std::vector<CCookedMesh::Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		for (unsigned int z = 0; z <= kGridSize; z++)
+		{
+			for (unsigned int x = 0; x <= kGridSize; x++)
+			{
+				CCookedMesh::Vertex vertex = {};
+				vertex.position[0] = static_cast<float>(x);
+				vertex.position[2] = static_cast<float>(z);
+				vertex.uv[0] = static_cast<float>(x) / kGridSize;
+				vertex.uv[1] = static_cast<float>(z) / kGridSize;
+				vertex.normal[1] = 1.0f;
+				vertices.push_back(vertex);
+			}
+		}
+
+		const unsigned int rowLength = kGridSize + 1;
+		for (unsigned int z = 0; z < kGridSize; z++)
+		{
+			for (unsigned int x = 0; x < kGridSize; x++)
+			{
+				const unsigned int corner = z * rowLength + x;
+				indices.insert(indices.end(), { corner, corner + rowLength, corner + 1 });
+				indices.insert(indices.end(), { corner + 1, corner + rowLength, corner + rowLength + 1 });
+			}
+		}
+	}
+
+	// The same triangles in a random order, as an exporter which knows nothing of the cache might leave them.
+	void ShuffleTriangles(std::vector<unsigned int>& indices)
+	{
+		std::vector<std::array<unsigned int, 3>> triangles;
+		for (size_t index = 0; index < indices.size(); index += 3)
+		{
+			triangles.push_back({ indices[index], indices[index + 1], indices[index + 2] });
+		}
+
+		std::mt19937 random(11);
+		std::shuffle(triangles.begin(), triangles.end(), random);
+
+		indices.clear();
+		for (auto& triangle : triangles)
+		{
+			indices.insert(indices.end(), triangle.begin(), triangle.end());
+		}
+	}
+
+	/* Each triangle as the positions of its corners, rotated to start from the lowest so the winding is kept but where
+	* it starts isn't, then sorted, so two meshes can be compared however their triangles and vertices are ordered. */
+	std::vector<std::array<float, 9>> GetTriangles(const std::vector<CCookedMesh::Vertex>& vertices, const std::vector<unsigned int>& indices)
+	{
+		std::vector<std::array<float, 9>> triangles;
+		for (size_t index = 0; index < indices.size(); index += 3)
+		{
+			std::array<std::array<float, 3>, 3> corners;
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				const CCookedMesh::Vertex& vertex = vertices[indices[index + corner]];
+				corners[corner] = { vertex.position[0], vertex.position[1], vertex.position[2] };
+			}
+			std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+
+			std::array<float, 9> triangle;
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				std::copy(corners[corner].begin(), corners[corner].end(), triangle.begin() + corner * 3);
+			}
+			triangles.push_back(triangle);
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+}
+
+TEST(VertexCacheOrderLowersACMR)
+{
+	std::vector<CCookedMesh::Vertex> vertices;
+	std::vector<unsigned int> indices;
+	CreateGrid(vertices, indices);
+	const unsigned int numberOfVertices = static_cast<unsigned int>(vertices.size());
+
+	for (bool shuffled : { false, true })
+	{
+		std::vector<unsigned int> optimised = indices;
+		if (shuffled)
+		{
+			ShuffleTriangles(optimised);
+		}
+		const std::vector<std::array<float, 9>> before = GetTriangles(vertices, optimised);
+		const float acmrBefore = CMeshOptimiser::CalculateACMR(optimised, numberOfVertices);
+
+		CMeshOptimiser::OptimiseVertexCache(optimised, numberOfVertices);
+		const float acmrAfter = CMeshOptimiser::CalculateACMR(optimised, numberOfVertices);
+		std::cout << (shuffled ? "Shuffled" : "Row by row") << " grid ACMR: " << acmrBefore << " before, " << acmrAfter << " after" << std::endl;
+
+		CHECK(acmrAfter < acmrBefore);
+		// Every vertex of a grid is shared by up to six triangles, so a good order gets well under one vertex a triangle.
+		CHECK(acmrAfter < 0.8f);
+		CHECK(optimised.size() == indices.size());
+		CHECK(GetTriangles(vertices, optimised) == before);
+	}
+}
+
+TEST(OptimiseKeepsTheSameTriangles)
+{
+	std::vector<CCookedMesh::Vertex> vertices;
+	std::vector<unsigned int> indices;
+	CreateGrid(vertices, indices);
+	ShuffleTriangles(indices);
+
+	// Every quad given its own copies of its corners, so there are duplicates to weld.
+	std::vector<CCookedMesh::Vertex> unwelded;
+	std::vector<unsigned int> unweldedIndices;
+	for (auto index : indices)
+	{
+		unweldedIndices.push_back(static_cast<unsigned int>(unwelded.size()));
+		unwelded.push_back(vertices[index]);
+	}
+	const std::vector<std::array<float, 9>> before = GetTriangles(unwelded, unweldedIndices);
+
+	const CMeshOptimiser::Statistics statistics = CMeshOptimiser::Optimise(unwelded, unweldedIndices);
+
+	CHECK(statistics.numberOfVerticesBefore == indices.size());
+	CHECK(statistics.numberOfVerticesAfter == vertices.size());
+	CHECK(unwelded.size() == vertices.size());
+	CHECK(statistics.acmrAfter < statistics.acmrBefore);
+	CHECK(GetTriangles(unwelded, unweldedIndices) == before);
+
+	// Laid out in the order they're first used, so the first triangle's corners come first.
+	bool inFetchOrder = true;
+	unsigned int nextVertex = 0;
+	for (auto index : unweldedIndices)
+	{
+		inFetchOrder = inFetchOrder && index <= nextVertex;
+		nextVertex = std::max(nextVertex, index + 1);
+	}
+	CHECK(inFetchOrder);
+}
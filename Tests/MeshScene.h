@@ -0,0 +1,108 @@
+#ifndef MESHSCENE_H
+#define MESHSCENE_H
+
+#include <Importer.hpp>
+#include <scene.h>
+#include <array>
+#include <vector>
+
+/* A scene for the stub importer to hand back in place of reading a model, so meshes can be cooked in the tests. It has a
+* square grid of quads in the xz plane using the first material and a single quad above it using the second. Shared by
+* the cooked mesh tests and benchmark, and the visibility system tests. */
+class CMeshScene
+{
+public:
+	static const unsigned int kNumberOfSubMeshes = 2;
+public:
+	CMeshScene(unsigned int gridSize)
+	{
+		const unsigned int rowLength = gridSize + 1;
+		for (unsigned int z = 0; z <= gridSize; z++)
+		{
+			for (unsigned int x = 0; x <= gridSize; x++)
+			{
+				AddVertex(mGrid, static_cast<float>(x), 0.0f, static_cast<float>(z), static_cast<float>(x) / gridSize, static_cast<float>(z) / gridSize);
+			}
+		}
+		for (unsigned int z = 0; z < gridSize; z++)
+		{
+			for (unsigned int x = 0; x < gridSize; x++)
+			{
+				const unsigned int corner = z * rowLength + x;
+				mGrid.indices.push_back({ corner, corner + rowLength, corner + 1 });
+				mGrid.indices.push_back({ corner + 1, corner + rowLength, corner + rowLength + 1 });
+			}
+		}
+
+		AddVertex(mQuad, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f);
+		AddVertex(mQuad, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f);
+		AddVertex(mQuad, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f);
+		AddVertex(mQuad, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+		mQuad.indices.push_back({ 0, 1, 2 });
+		mQuad.indices.push_back({ 2, 1, 3 });
+
+		Finish(mGrid, 0);
+		Finish(mQuad, 1);
+		mpMeshes[0] = &mGrid.mesh;
+		mpMeshes[1] = &mQuad.mesh;
+		mpMaterials[0] = &mMaterials[0];
+		mpMaterials[1] = &mMaterials[1];
+
+		mScene.mNumMeshes = kNumberOfSubMeshes;
+		mScene.mNumMaterials = kNumberOfSubMeshes;
+		mScene.mMeshes = mpMeshes;
+		mScene.mMaterials = mpMaterials;
+		Assimp::Importer::SetScene(&mScene);
+	}
+
+	~CMeshScene()
+	{
+		Assimp::Importer::SetScene(nullptr);
+	}
+
+	const aiMesh& GetSubMesh(unsigned int index) { return *mpMeshes[index]; };
+private:
+	struct SubMesh
+	{
+		std::vector<aiVector3D> positions;
+		std::vector<aiVector3D> uvs;
+		std::vector<aiVector3D> normals;
+		std::vector<std::array<unsigned int, 3>> indices;
+		std::vector<aiFace> faces;
+		aiMesh mesh;
+	};
+
+	void AddVertex(SubMesh& subMesh, float x, float y, float z, float u, float v)
+	{
+		subMesh.positions.push_back({ x, y, z });
+		subMesh.uvs.push_back({ u, v, 0.0f });
+		subMesh.normals.push_back({ 0.0f, 1.0f, 0.0f });
+	}
+
+	// Only once every vector is full, as the mesh points into them.
+	void Finish(SubMesh& subMesh, unsigned int materialIndex)
+	{
+		for (auto& triangle : subMesh.indices)
+		{
+			subMesh.faces.push_back({ 3, triangle.data() });
+		}
+
+		subMesh.mesh = {};
+		subMesh.mesh.mNumVertices = static_cast<unsigned int>(subMesh.positions.size());
+		subMesh.mesh.mNumFaces = static_cast<unsigned int>(subMesh.faces.size());
+		subMesh.mesh.mMaterialIndex = materialIndex;
+		subMesh.mesh.mVertices = subMesh.positions.data();
+		subMesh.mesh.mNormals = subMesh.normals.data();
+		subMesh.mesh.mTextureCoords[0] = subMesh.uvs.data();
+		subMesh.mesh.mFaces = subMesh.faces.data();
+	}
+
+	SubMesh mGrid;
+	SubMesh mQuad;
+	aiMesh* mpMeshes[kNumberOfSubMeshes];
+	aiMaterial mMaterials[kNumberOfSubMeshes];
+	aiMaterial* mpMaterials[kNumberOfSubMeshes];
+	aiScene mScene;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "Test.h"
+#include "MeshSimplifier.h"
+#include <cmath>
+#include <functional>
+
+namespace
+{
+	const unsigned int kGridSize = 24;
+
+	// A square grid of quads in the xz plane, with the height of each point given by the function.
+	void CreateGrid(const std::function<float(unsigned int x, unsigned int z)>& height, std::vector<CCookedMesh::Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		vertices.clear();
+		indices.clear();
+
+		for (unsigned int z = 0; z <= kGridSize; z++)
+		{
+			for (unsigned int x = 0; x <= kGridSize; x++)
+			{
+				CCookedMesh::Vertex vertex = {};
+				vertex.position[0] = static_cast<float>(x);
+				vertex.position[1] = height(x, z);
+				vertex.position[2] = static_cast<float>(z);
+				vertex.uv[0] = static_cast<float>(x) / kGridSize;
+				vertex.uv[1] = static_cast<float>(z) / kGridSize;
+				vertex.normal[1] = 1.0f;
+				vertices.push_back(vertex);
+			}
+		}
+
+		const unsigned int rowLength = kGridSize + 1;
+		for (unsigned int z = 0; z < kGridSize; z++)
+		{
+			for (unsigned int x = 0; x < kGridSize; x++)
+			{
+				const unsigned int corner = z * rowLength + x;
+				indices.insert(indices.end(), { corner, corner + rowLength, corner + 1 });
+				indices.insert(indices.end(), { corner + 1, corner + rowLength, corner + rowLength + 1 });
+			}
+		}
+	}
+}
+
+TEST(FlatGridHasNoError)
+{
+	std::vector<CCookedMesh::Vertex> vertices;
+	std::vector<unsigned int> indices;
+	CreateGrid([](unsigned int, unsigned int) { return 2.0f; }, vertices, indices);
+
+	std::vector<unsigned int> result;
+	const float error = CMeshSimplifier::Simplify(vertices, indices, static_cast<unsigned int>(indices.size() / 4) / 3 * 3, CMeshSimplifier::kDefaultSettings, result);
+
+	CHECK(result.size() < indices.size() / 2);
+	CHECK(result.size() % 3 == 0);
+	CHECK(error < 0.0001f);
+}
+
+TEST(NothingToDoHasNoError)
+{
+	std::vector<CCookedMesh::Vertex> vertices;
+	std::vector<unsigned int> indices;
+	CreateGrid([](unsigned int x, unsigned int z) { return static_cast<float>((x * 7 + z * 3) % 5); }, vertices, indices);
+
+	std::vector<unsigned int> result;
+	const float error = CMeshSimplifier::Simplify(vertices, indices, static_cast<unsigned int>(indices.size()), CMeshSimplifier::kDefaultSettings, result);
+
+	CHECK(result == indices);
+	CHECK(error == 0.0f);
+}
+
+/* A single spike in an otherwise flat grid. Collapsing it flattens the surface there, so the reported error is the
+* distance the tip moved off the planes of the triangles around it, which can't be more than its height. */
+TEST(SpikeErrorIsADistance)
+{
+	const float spikeHeight = 3.0f;
+	const unsigned int spike = kGridSize / 2;
+
+	std::vector<CCookedMesh::Vertex> vertices;
+	std::vector<unsigned int> indices;
+	CreateGrid([&](unsigned int x, unsigned int z) { return x == spike && z == spike ? spikeHeight : 0.0f; }, vertices, indices);
+
+	std::vector<unsigned int> result;
+	const float error = CMeshSimplifier::Simplify(vertices, indices, static_cast<unsigned int>(indices.size() / 8) / 3 * 3, CMeshSimplifier::kDefaultSettings, result);
+
+	// The tip of the spike is gone.
+	const unsigned int spikeVertex = spike * (kGridSize + 1) + spike;
+	bool spikeRemains = false;
+	for (auto index : result)
+	{
+		spikeRemains |= index == spikeVertex;
+	}
+	CHECK(!spikeRemains);
+
+	CHECK(error > 0.0f);
+	CHECK(error <= spikeHeight);
+}
+
+/* A smooth surface simplified twice, the coarser level must report at least as much error as the finer one, as that's
+* what the switching distances between levels of detail are worked out from. */
+TEST(CoarserLevelsHaveMoreError)
+{
+	std::vector<CCookedMesh::Vertex> vertices;
+	std::vector<unsigned int> indices;
+	CreateGrid([](unsigned int x, unsigned int z) { return std::sin(x * 0.5f) * std::cos(z * 0.4f) * 2.0f; }, vertices, indices);
+
+	std::vector<unsigned int> result;
+	const float error = CMeshSimplifier::Simplify(vertices, indices, static_cast<unsigned int>(indices.size() / 5) / 3 * 3, CMeshSimplifier::kDefaultSettings, result);
+
+	CHECK(result.size() < indices.size() / 2);
+	CHECK(error > 0.0f);
+	// Never further than the whole height of the surface.
+	CHECK(error <= 4.0f);
+
+	std::vector<unsigned int> coarser;
+	const float coarserError = CMeshSimplifier::Simplify(vertices, indices, static_cast<unsigned int>(indices.size() / 20) / 3 * 3, CMeshSimplifier::kDefaultSettings, coarser);
+	CHECK(coarser.size() < result.size());
+	CHECK(coarserError >= error);
+}
@@ -0,0 +1,199 @@
+#include "Test.h"
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const int kHeightMapSize = 64;
+	const float kRidgeHeight = 15.0f;
+	// Rows of the height map the ridge runs along, right across the terrain.
+	const int kRidgeStart = 38;
+	const int kRidgeEnd = 46;
+
+	// Flat ground with a tall ridge across the middle, so everything low down on the far side is hidden.
+	class CRidgeHeightMap
+	{
+	public:
+		// The ridge can stop short of the right hand side, leaving a gap to see past its end through.
+		CRidgeHeightMap(int ridgeWidth = kHeightMapSize)
+		{
+			mRows.resize(kHeightMapSize, std::vector<double>(kHeightMapSize, 0.0));
+			for (int z = 0; z < kHeightMapSize; z++)
+			{
+				if (z >= kRidgeStart && z <= kRidgeEnd)
+				{
+					std::fill(mRows[z].begin(), mRows[z].begin() + ridgeWidth, kRidgeHeight);
+				}
+				mRowPointers.push_back(mRows[z].data());
+			}
+		}
+		double** Get() { return mRowPointers.data(); }
+	private:
+		std::vector<std::vector<double>> mRows;
+		std::vector<double*> mRowPointers;
+	};
+
+	// Stood on the ground in front of the ridge, looking straight at it.
+	D3DXMATRIX CreateViewProj()
+	{
+		const D3DXVECTOR3 eye(32.0f, 5.0f, 0.0f);
+		const D3DXVECTOR3 at(32.0f, 5.0f, 1.0f);
+		const D3DXVECTOR3 up(0.0f, 1.0f, 0.0f);
+
+		D3DXMATRIX view;
+		D3DXMatrixLookAtLH(&view, &eye, &at, &up);
+
+		D3DXMATRIX proj;
+		D3DXMatrixPerspectiveFovLH(&proj, static_cast<float>(D3DX_PI) / 4.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+
+		D3DXMATRIX viewProj;
+		D3DXMatrixMultiply(&viewProj, &view, &proj);
+		return viewProj;
+	}
+
+	// Where a point lands in the depth buffer, worked out the same way as the culler does.
+	void ProjectToDepthBuffer(const D3DXVECTOR3& point, float& screenX, float& screenY)
+	{
+		D3DXVECTOR4 clip;
+		D3DXMATRIX viewProj = CreateViewProj();
+		D3DXVec3Transform(&clip, &point, &viewProj);
+		screenX = (clip.x / clip.w * 0.5f + 0.5f) * COcclusionCuller::kDepthBufferWidth;
+		screenY = (0.5f - clip.y / clip.w * 0.5f) * COcclusionCuller::kDepthBufferHeight;
+	}
+
+	// The x a point at the given height and distance needs to land on the given column, the projection above run backwards.
+	// Nothing in w depends on x when looking straight down the z axis, so the column is linear in x.
+	float GetWorldX(float screenX, float y, float z)
+	{
+		const D3DXMATRIX m = CreateViewProj();
+		const float clipW = y * m._24 + z * m._34 + m._44;
+		const float clipX = (screenX / COcclusionCuller::kDepthBufferWidth - 0.5f) * 2.0f * clipW;
+		return (clipX - y * m._21 - z * m._31 - m._41) / m._11;
+	}
+
+	void RasteriseRidge(COcclusionCuller& culler, CRidgeHeightMap& heightMap)
+	{
+		culler.BuildOccluder(heightMap.Get(), kHeightMapSize, kHeightMapSize);
+
+		D3DXMATRIX world;
+		D3DXMatrixIdentity(&world);
+		culler.Rasterise(world, CreateViewProj());
+	}
+}
+
+TEST(NothingIsCulledWithoutAnOccluder)
+{
+	CThreadPool threadPool(2);
+	COcclusionCuller culler(&threadPool);
+
+	D3DXMATRIX world;
+	D3DXMatrixIdentity(&world);
+	culler.Rasterise(world, CreateViewProj());
+
+	CHECK(!culler.HasOccluder());
+	CHECK(culler.TestAABB(D3DXVECTOR3(30.0f, 0.0f, 80.0f), D3DXVECTOR3(34.0f, 4.0f, 84.0f)));
+}
+
+TEST(RidgeIsRasterised)
+{
+	CThreadPool threadPool(2);
+	COcclusionCuller culler(&threadPool);
+	CRidgeHeightMap heightMap;
+	RasteriseRidge(culler, heightMap);
+
+	CHECK(culler.HasOccluder());
+
+	// The centre of the screen looks straight into the ridge, the top row looks over it into the sky.
+	const float* depthBuffer = culler.GetDepthBuffer();
+	const float centre = depthBuffer[(COcclusionCuller::kDepthBufferHeight / 2) * COcclusionCuller::kDepthBufferWidth + COcclusionCuller::kDepthBufferWidth / 2];
+	const float top = depthBuffer[COcclusionCuller::kDepthBufferWidth / 2];
+	CHECK(centre > 0.0f && centre < 1.0f);
+	CHECK(top == 1.0f);
+}
+
+TEST(BoxesBehindRidgeAreCulled)
+{
+	CThreadPool threadPool(2);
+	COcclusionCuller culler(&threadPool);
+	CRidgeHeightMap heightMap;
+	RasteriseRidge(culler, heightMap);
+
+	// Down on the ground on the far side of the ridge, straight ahead and off to either side.
+	CHECK(!culler.TestAABB(D3DXVECTOR3(30.0f, 0.0f, 55.0f), D3DXVECTOR3(34.0f, 4.0f, 59.0f)));
+	CHECK(!culler.TestAABB(D3DXVECTOR3(20.0f, 0.0f, 60.0f), D3DXVECTOR3(22.0f, 6.0f, 62.0f)));
+	CHECK(!culler.TestAABB(D3DXVECTOR3(42.0f, 0.0f, 60.0f), D3DXVECTOR3(44.0f, 6.0f, 62.0f)));
+	CHECK(!culler.TestSphere(D3DXVECTOR3(32.0f, 3.0f, 58.0f), 2.0f));
+}
+
+TEST(BoxesInFrontOfRidgeAreVisible)
+{
+	CThreadPool threadPool(2);
+	COcclusionCuller culler(&threadPool);
+	CRidgeHeightMap heightMap;
+	RasteriseRidge(culler, heightMap);
+
+	CHECK(culler.TestAABB(D3DXVECTOR3(30.0f, 0.0f, 20.0f), D3DXVECTOR3(34.0f, 4.0f, 24.0f)));
+	CHECK(culler.TestSphere(D3DXVECTOR3(32.0f, 3.0f, 30.0f), 2.0f));
+}
+
+TEST(BoxesPokingAboveRidgeAreVisible)
+{
+	CThreadPool threadPool(2);
+	COcclusionCuller culler(&threadPool);
+	CRidgeHeightMap heightMap;
+	RasteriseRidge(culler, heightMap);
+
+	// Behind the ridge, but tall enough for the top to be seen over it.
+	CHECK(culler.TestAABB(D3DXVECTOR3(30.0f, 0.0f, 55.0f), D3DXVECTOR3(34.0f, kRidgeHeight + 30.0f, 59.0f)));
+}
+
+TEST(BoxesBehindCameraAreNotCulled)
+{
+	CThreadPool threadPool(2);
+	COcclusionCuller culler(&threadPool);
+	CRidgeHeightMap heightMap;
+	RasteriseRidge(culler, heightMap);
+
+	// Left to the frustum, the occlusion test only ever says no when it's sure.
+	CHECK(culler.TestAABB(D3DXVECTOR3(30.0f, 0.0f, -20.0f), D3DXVECTOR3(34.0f, 4.0f, -16.0f)));
+	CHECK(culler.TestAABB(D3DXVECTOR3(30.0f, 0.0f, -2.0f), D3DXVECTOR3(34.0f, 4.0f, 59.0f)));
+}
+
+/* A box behind the ridge whose right hand edge ends partway into the last column the ridge covers. That column's own
+* depth can't say whether the ridge covers the part of it the box reaches into, so the box has to take in the column past
+* it, which looks past the end of the ridge, and be kept. Pulled back a pixel it only reaches the covered columns. */
+TEST(BoxesReachingPartwayIntoAPixelTakeInTheNext)
+{
+	CThreadPool threadPool(2);
+	COcclusionCuller culler(&threadPool);
+	CRidgeHeightMap heightMap(40);
+	RasteriseRidge(culler, heightMap);
+
+	// Thin enough to span just the two rows either side of where its top and bottom land.
+	const float height = 6.5f;
+	const float distance = 58.0f;
+	float screenX;
+	float screenY;
+	ProjectToDepthBuffer(D3DXVECTOR3(30.0f, height, distance), screenX, screenY);
+	CHECK(screenY != std::floor(screenY));
+
+	// The last column the ridge covers in both rows, working out from where the box starts.
+	const float* depthBuffer = culler.GetDepthBuffer();
+	unsigned int lastCovered = COcclusionCuller::kDepthBufferWidth;
+	for (unsigned int row = static_cast<unsigned int>(screenY); row <= static_cast<unsigned int>(screenY) + 1; row++)
+	{
+		unsigned int column = static_cast<unsigned int>(screenX);
+		while (column + 1 < COcclusionCuller::kDepthBufferWidth && depthBuffer[row * COcclusionCuller::kDepthBufferWidth + column + 1] < 1.0f)
+		{
+			column++;
+		}
+		lastCovered = std::min(lastCovered, column);
+	}
+	CHECK(lastCovered + 1 < COcclusionCuller::kDepthBufferWidth);
+
+	const float reachingIn = GetWorldX(lastCovered + 0.5f, height, distance);
+	CHECK(culler.TestAABB(D3DXVECTOR3(30.0f, height, distance), D3DXVECTOR3(reachingIn, height, distance)));
+	const float pulledBack = GetWorldX(lastCovered - 0.5f, height, distance);
+	CHECK(!culler.TestAABB(D3DXVECTOR3(30.0f, height, distance), D3DXVECTOR3(pulledBack, height, distance)));
+}
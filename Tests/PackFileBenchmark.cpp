@@ -0,0 +1,89 @@
+#include "Test.h"
+#include "PackFile.h"
+#include "FileSystem.h"
+#include "DiskFile.h"
+#include "Hash.h"
+
+namespace
+{
+	const std::string kResources = std::string(PRIO_ENGINE_DIRECTORY) + "/Resources/";
+	const unsigned int kIterations = 20;
+
+	const size_t kPageSize = 4096;
+
+	// Every resource the engine ships, fonts and patch maps of a few kilobytes through to textures of several megabytes.
+	const char* const kDirectories[] = { "Fonts", "Models", "Normal Maps", "Patch Maps", "Sounds", "Textures" };
+
+	/* Opens every file through the file system and reads a byte from each page of it, so every page has to be brought in
+	* without the time going on hashing the whole contents. */
+	bool ReadAll(const std::vector<std::string>& files, bool packed, unsigned long long& checksum)
+	{
+		bool allRead = true;
+		checksum = PrioEngine::Hash::kFNVOffsetBasis;
+		for (auto& filename : files)
+		{
+			CVirtualFile file;
+			allRead &= CFileSystem::GetInstance().Open(filename, file) && file.IsPacked() == packed;
+			for (size_t offset = 0; offset < file.GetSize(); offset += kPageSize)
+			{
+				checksum = PrioEngine::Hash::FNV1a(file.GetData() + offset, 1, checksum);
+			}
+		}
+		return allRead;
+	}
+}
+
+/* Every file under the resource directories read loose from disk, each one opened on its own, then the same files read out
+* of a pack of them, where the pack is mounted once and each file found with a search over its mapped index. Both run with
+* the files already in the page cache after the first pass, so this measures the cost of opening many files rather than the
+* disk. Compressed entries are decompressed as they're opened, which is counted against the pack. */
+TEST(BenchmarkPackedAgainstLooseReads)
+{
+	std::vector<std::string> directories;
+	std::vector<std::string> files;
+	for (auto directory : kDirectories)
+	{
+		directories.push_back(kResources + directory);
+		PrioEngine::DiskFile::FindFiles(directories.back(), files);
+	}
+	CHECK(CPackFile::Build("Resources.pak", directories));
+
+	// Compressed entries have to be decompressed in full as they're opened, where anything else is only mapped.
+	CPackFile pack;
+	CHECK(pack.Open("Resources.pak"));
+	unsigned int numberOfCompressed = 0;
+	unsigned long long compressedBytes = 0;
+	for (auto& filename : files)
+	{
+		const CPackFile::Entry* entry = pack.Find(filename);
+		if (entry != nullptr && (entry->flags & CPackFile::CompressedEntry) != 0)
+		{
+			numberOfCompressed++;
+			compressedBytes += entry->size;
+		}
+	}
+	pack.Close();
+	std::cout << numberOfCompressed << " of " << files.size() << " entries compressed, " << compressedBytes / 1024 << "KB once decompressed" << std::endl;
+
+	CFileSystem::GetInstance().UnmountAll();
+	unsigned long long looseChecksum = 0;
+	bool looseRead = true;
+	PrioTest::Benchmark("Loose reads of " + std::to_string(files.size()) + " files", kIterations, [&]()
+	{
+		looseRead &= ReadAll(files, false, looseChecksum);
+	});
+	CHECK(looseRead);
+
+	unsigned long long packedChecksum = 0;
+	bool packedRead = true;
+	PrioTest::Benchmark("Mounting the pack and reading the same files", kIterations, [&]()
+	{
+		CFileSystem::GetInstance().UnmountAll();
+		packedRead &= CFileSystem::GetInstance().Mount("Resources.pak");
+		packedRead &= ReadAll(files, true, packedChecksum);
+	});
+	CHECK(packedRead);
+	CHECK(packedChecksum == looseChecksum);
+
+	CFileSystem::GetInstance().UnmountAll();
+}
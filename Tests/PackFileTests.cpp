@@ -0,0 +1,321 @@
+#include "Test.h"
+#include "PackFile.h"
+#include "FileSystem.h"
+#include "Lz4.h"
+#include "DiskFile.h"
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	std::vector<unsigned char> RandomBytes(size_t size, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::vector<unsigned char> bytes(size);
+		for (auto& byte : bytes)
+		{
+			byte = static_cast<unsigned char>(random());
+		}
+		return bytes;
+	}
+
+	// Text with plenty of repeats, which LZ4 shrinks well.
+	std::vector<unsigned char> RepetitiveBytes(size_t size)
+	{
+		const std::string line = "v 1.000000 2.000000 3.000000\nvt 0.500000 0.250000\n";
+		std::vector<unsigned char> bytes(size);
+		for (size_t i = 0; i < size; i++)
+		{
+			bytes[i] = static_cast<unsigned char>(line[i % line.size()]);
+		}
+		return bytes;
+	}
+
+	bool RoundTrips(const std::vector<unsigned char>& source)
+	{
+		std::vector<unsigned char> compressed;
+		PrioEngine::Lz4::Compress(source.data(), source.size(), compressed);
+
+		std::vector<unsigned char> decompressed(source.size());
+		return PrioEngine::Lz4::Decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size()) && decompressed == source;
+	}
+
+	void WriteFile(const std::string& filename, const std::vector<unsigned char>& contents)
+	{
+		const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+		if (!directory.empty())
+		{
+			std::filesystem::create_directories(directory);
+		}
+		std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+	}
+
+	std::vector<unsigned char> ReadFile(const std::string& filename)
+	{
+		std::ifstream file(filename.c_str(), std::ios::binary);
+		return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	// A directory of resources to pack, one file compresses well, one doesn't and one is in a sub directory.
+	struct SourceDirectory
+	{
+		SourceDirectory()
+		{
+			std::filesystem::remove_all("PackSource");
+			compressible = RepetitiveBytes(100000);
+			incompressible = RandomBytes(5000, 1);
+			nested = RepetitiveBytes(777);
+
+			WriteFile("PackSource/Model.obj", compressible);
+			WriteFile("PackSource/Noise.raw", incompressible);
+			WriteFile("PackSource/Textures/Detail.txt", nested);
+			// Left behind by a write which never finished, it mustn't end up in the pack.
+			WriteFile("PackSource/Half.pmesh.1234.tmp", nested);
+		}
+
+		std::vector<unsigned char> compressible;
+		std::vector<unsigned char> incompressible;
+		std::vector<unsigned char> nested;
+	};
+
+	std::vector<unsigned char> ReadEntry(CPackFile& pack, const CPackFile::Entry& entry)
+	{
+		std::vector<unsigned char> contents(static_cast<size_t>(entry.size));
+		if (entry.flags & CPackFile::CompressedEntry)
+		{
+			if (!PrioEngine::Lz4::Decompress(pack.GetEntryData(entry), static_cast<size_t>(entry.storedSize), contents.data(), contents.size()))
+			{
+				contents.clear();
+			}
+		}
+		else
+		{
+			memcpy(contents.data(), pack.GetEntryData(entry), contents.size());
+		}
+		return contents;
+	}
+
+	// Offset of the index in a pack, read from its header.
+	unsigned long long GetIndexOffset(const std::vector<unsigned char>& pack)
+	{
+		unsigned long long indexOffset;
+		memcpy(&indexOffset, pack.data() + 16, sizeof(indexOffset));
+		return indexOffset;
+	}
+}
+
+TEST(Lz4RoundTrips)
+{
+	CHECK(RoundTrips(RepetitiveBytes(100000)));
+	CHECK(RoundTrips(RandomBytes(100000, 2)));
+	CHECK(RoundTrips(std::vector<unsigned char>(65536 * 3, 0)));
+
+	// Sizes around the literals the format keeps at the end of a block.
+	for (size_t size = 0; size < 40; size++)
+	{
+		CHECK(RoundTrips(RepetitiveBytes(size)));
+		CHECK(RoundTrips(RandomBytes(size, static_cast<unsigned int>(size))));
+	}
+}
+
+TEST(Lz4CompressesRepeats)
+{
+	const std::vector<unsigned char> source = RepetitiveBytes(100000);
+	std::vector<unsigned char> compressed;
+	PrioEngine::Lz4::Compress(source.data(), source.size(), compressed);
+
+	CHECK(compressed.size() < source.size() / 10);
+}
+
+TEST(Lz4RejectsCorruptBlocks)
+{
+	const std::vector<unsigned char> source = RepetitiveBytes(10000);
+	std::vector<unsigned char> compressed;
+	PrioEngine::Lz4::Compress(source.data(), source.size(), compressed);
+
+	std::vector<unsigned char> decompressed(source.size());
+
+	// Told to expect the wrong size.
+	CHECK(!PrioEngine::Lz4::Decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size() - 1));
+	std::vector<unsigned char> larger(source.size() + 1);
+	CHECK(!PrioEngine::Lz4::Decompress(compressed.data(), compressed.size(), larger.data(), larger.size()));
+
+	// Cut short.
+	CHECK(!PrioEngine::Lz4::Decompress(compressed.data(), compressed.size() / 2, decompressed.data(), decompressed.size()));
+
+	// Every match offset pointing back before the start of the output.
+	std::vector<unsigned char> badOffset = { 0x14, 'a', 0xFF, 0xFF, 0x00 };
+	std::vector<unsigned char> output(64);
+	CHECK(!PrioEngine::Lz4::Decompress(badOffset.data(), badOffset.size(), output.data(), 1 + 4 + 4));
+
+	// Random garbage must never read or write out of bounds, whatever it decides.
+	for (unsigned int seed = 0; seed < 200; seed++)
+	{
+		const std::vector<unsigned char> garbage = RandomBytes(64, seed);
+		PrioEngine::Lz4::Decompress(garbage.data(), garbage.size(), output.data(), output.size());
+	}
+}
+
+TEST(PackRoundTrips)
+{
+	SourceDirectory source;
+	CHECK(CPackFile::Build("RoundTrip.pak", { "PackSource" }));
+
+	CPackFile pack;
+	CHECK(pack.Open("RoundTrip.pak"));
+	CHECK(pack.GetNumberOfEntries() == 3);
+
+	const CPackFile::Entry* model = pack.Find("PackSource/Model.obj");
+	const CPackFile::Entry* noise = pack.Find("PackSource/Noise.raw");
+	// Found however the path is written.
+	const CPackFile::Entry* nested = pack.Find(".\\PACKSOURCE\\textures\\detail.TXT");
+
+	CHECK(model != nullptr && noise != nullptr && nested != nullptr);
+	if (model == nullptr || noise == nullptr || nested == nullptr)
+	{
+		return;
+	}
+
+	// Only the file which shrinks is stored compressed.
+	CHECK((model->flags & CPackFile::CompressedEntry) != 0);
+	CHECK((noise->flags & CPackFile::CompressedEntry) == 0);
+
+	CHECK(ReadEntry(pack, *model) == source.compressible);
+	CHECK(ReadEntry(pack, *noise) == source.incompressible);
+	CHECK(ReadEntry(pack, *nested) == source.nested);
+
+	for (auto entry : { model, noise, nested })
+	{
+		CHECK(entry->offset % CPackFile::kEntryAlignment == 0);
+	}
+
+	CHECK(pack.Find("PackSource/Half.pmesh.1234.tmp") == nullptr);
+	CHECK(pack.Find("PackSource/Missing.obj") == nullptr);
+}
+
+TEST(PackIsReadThroughTheFileSystem)
+{
+	SourceDirectory source;
+	CHECK(CPackFile::Build("FileSystem.pak", { "PackSource" }));
+
+	// Moved out of the way, so anything found must have come from the pack.
+	std::filesystem::remove_all("PackSource");
+
+	CHECK(CFileSystem::GetInstance().Mount("FileSystem.pak"));
+
+	CVirtualFile model;
+	CHECK(CFileSystem::GetInstance().Open("PackSource/Model.obj", model));
+	CHECK(model.IsPacked());
+	CHECK(std::vector<unsigned char>(model.GetData(), model.GetData() + model.GetSize()) == source.compressible);
+
+	CVirtualFile noise;
+	CHECK(CFileSystem::GetInstance().Open("PackSource/Noise.raw", noise));
+	CHECK(std::vector<unsigned char>(noise.GetData(), noise.GetData() + noise.GetSize()) == source.incompressible);
+
+	CVirtualFile missing;
+	CHECK(!CFileSystem::GetInstance().Open("PackSource/Missing.obj", missing));
+
+	CFileSystem::GetInstance().UnmountAll();
+}
+
+TEST(TruncatedPackIsRefused)
+{
+	SourceDirectory source;
+	CHECK(CPackFile::Build("Truncated.pak", { "PackSource" }));
+
+	std::vector<unsigned char> contents = ReadFile("Truncated.pak");
+	contents.resize(contents.size() - sizeof(CPackFile::Entry));
+	WriteFile("Truncated.pak", contents);
+
+	CPackFile pack;
+	CHECK(!pack.Open("Truncated.pak"));
+
+	WriteFile("Tiny.pak", std::vector<unsigned char>(8, 'P'));
+	CHECK(!pack.Open("Tiny.pak"));
+}
+
+TEST(CorruptEntriesAreNotFollowed)
+{
+	SourceDirectory source;
+	CHECK(CPackFile::Build("Corrupt.pak", { "PackSource" }));
+
+	const std::vector<unsigned char> original = ReadFile("Corrupt.pak");
+	const unsigned long long indexOffset = GetIndexOffset(original);
+
+	// Point the path of every entry past the end of the paths, then the data of every entry past the end of the file.
+	std::vector<unsigned char> badPaths = original;
+	std::vector<unsigned char> badData = original;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		CPackFile::Entry entry;
+		const size_t entryOffset = static_cast<size_t>(indexOffset) + i * sizeof(CPackFile::Entry);
+
+		memcpy(&entry, original.data() + entryOffset, sizeof(entry));
+		entry.pathOffset = 0xFFFFFF00;
+		memcpy(badPaths.data() + entryOffset, &entry, sizeof(entry));
+
+		memcpy(&entry, original.data() + entryOffset, sizeof(entry));
+		entry.offset = 0xFFFFFFFFFFFFFF00ull;
+		memcpy(badData.data() + entryOffset, &entry, sizeof(entry));
+	}
+	WriteFile("BadPaths.pak", badPaths);
+	WriteFile("BadData.pak", badData);
+
+	CPackFile pack;
+	CHECK(pack.Open("BadPaths.pak"));
+	CHECK(pack.Find("PackSource/Model.obj") == nullptr);
+	CHECK(pack.Find("PackSource/Noise.raw") == nullptr);
+
+	CHECK(pack.Open("BadData.pak"));
+	CHECK(pack.Find("PackSource/Model.obj") == nullptr);
+	CHECK(pack.Find("PackSource/Noise.raw") == nullptr);
+}
+
+TEST(FindFilesWalksSubDirectories)
+{
+	SourceDirectory source;
+
+	std::vector<std::string> files;
+	CHECK(PrioEngine::DiskFile::FindFiles("PackSource", files));
+	CHECK(files.size() == 4);
+	CHECK(std::find(files.begin(), files.end(), "PackSource/Textures/Detail.txt") != files.end());
+
+	CHECK(!PrioEngine::DiskFile::FindFiles("NotThere", files));
+}
+
+TEST(WriteReplacesFilesWhole)
+{
+	const std::vector<unsigned char> first = RandomBytes(1000, 3);
+	const std::vector<unsigned char> second = RandomBytes(10, 4);
+
+	auto write = [](const std::vector<unsigned char>& contents)
+	{
+		return PrioEngine::DiskFile::Write("Replaced.bin", [&contents](std::ofstream& file)
+		{
+			file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+		});
+	};
+
+	CHECK(write(first));
+	CHECK(ReadFile("Replaced.bin") == first);
+	CHECK(write(second));
+	CHECK(ReadFile("Replaced.bin") == second);
+
+	// A write which fails leaves the old file alone, and nothing behind.
+	CHECK(!PrioEngine::DiskFile::Write("Replaced.bin", [](std::ofstream& file)
+	{
+		file.setstate(std::ios::badbit);
+	}));
+	CHECK(ReadFile("Replaced.bin") == second);
+
+	std::vector<std::string> files;
+	PrioEngine::DiskFile::FindFiles(".", files);
+	for (auto& file : files)
+	{
+		CHECK(file.find("Replaced.bin.") == std::string::npos);
+	}
+}
@@ -0,0 +1,117 @@
+#include "Test.h"
+#include "DrawList.h"
+#include "PassRecorder.h"
+#include "NullRenderDevice.h"
+#include "DrawListScene.h"
+#include <random>
+
+namespace
+{
+	const unsigned int kIterations = 200;
+	const unsigned int kNumberOfPipelines = 4;
+	const unsigned int kNumberOfMaterials = 16;
+
+	void FillDrawList(CDrawListScene& scene, CDrawList& drawList, unsigned int numberOfPackets)
+	{
+		std::mt19937 random(3);
+		std::uniform_real_distribution<float> depth(1.0f, 1000.0f);
+		drawList.Clear();
+		for (unsigned int i = 0; i < numberOfPackets; i++)
+		{
+			const unsigned int pipeline = random() % kNumberOfPipelines;
+			const unsigned int material = random() % kNumberOfMaterials;
+			scene.Add(drawList, CDrawList::MakeSortKey(CDrawList::OpaquePass, pipeline + 1, material + 1, depth(random)), pipeline, material);
+		}
+		drawList.Sort();
+	}
+
+	// Records the list in as many runs as asked, whatever their size, so the cost of a run can be seen below the minimum.
+	void RecordRuns(CDrawList& drawList, CPassRecorder& passRecorder, unsigned int numberOfRuns)
+	{
+		const unsigned int numberOfPackets = drawList.GetNumberOfPackets();
+		for (unsigned int run = 0; run < numberOfRuns; run++)
+		{
+			const unsigned int firstPacket = numberOfPackets * run / numberOfRuns;
+			const unsigned int runPackets = numberOfPackets * (run + 1) / numberOfRuns - firstPacket;
+			passRecorder.AddPass([&drawList, firstPacket, runPackets](CRenderDevice* renderDevice)
+			{
+				CDrawList::Statistics statistics;
+				drawList.Submit(renderDevice, firstPacket, runPackets, statistics);
+				return true;
+			});
+		}
+		passRecorder.Execute();
+	}
+}
+
+/* What recording a list across the workers costs against submitting it directly, as the list grows. The null device
+* replays a list through the immediate device when it's executed, which a driver doesn't, so only the time spent
+* recording is compared with the direct submit. It's that time the main thread waits on before it can carry on. */
+TEST(BenchmarkRecordedRuns)
+{
+	CNullRenderDevice renderDevice;
+	{
+		CThreadPool threadPool;
+		CPassRecorder passRecorder(&renderDevice, &threadPool);
+		CDrawListScene scene(&renderDevice, kNumberOfPipelines, kNumberOfMaterials);
+		CDrawList drawList;
+		const unsigned int numberOfRuns = threadPool.GetNumberOfThreads() + 1;
+
+		std::cout << numberOfRuns << " runs, one for each worker and the main thread" << std::endl;
+		for (unsigned int numberOfPackets : { 32u, 64u, 128u, 256u, 512u, 1024u, 4096u, 20000u })
+		{
+			FillDrawList(scene, drawList, numberOfPackets);
+			const std::string packets = std::to_string(numberOfPackets) + " packets";
+
+			PrioTest::Benchmark("Direct " + packets, kIterations, [&]()
+			{
+				drawList.Submit(&renderDevice);
+			});
+
+			float recordTime = 0.0f;
+			PrioTest::Benchmark("Recorded " + packets + " including replay", kIterations, [&]()
+			{
+				RecordRuns(drawList, passRecorder, numberOfRuns);
+				recordTime += passRecorder.GetStatistics().recordTime;
+			});
+			std::cout << "Recorded " << packets << " recording only: " << recordTime / kIterations << "ms, " <<
+				numberOfPackets / numberOfRuns << " packets a run" << std::endl;
+		}
+	}
+	CHECK(renderDevice.GetNumberOfErrors() == 0);
+}
+
+/* The split the renderer uses, which leaves short lists alone and totals the runs of long ones. */
+TEST(BenchmarkSubmitAcrossWorkers)
+{
+	CNullRenderDevice renderDevice;
+	{
+		CThreadPool threadPool;
+		CPassRecorder passRecorder(&renderDevice, &threadPool);
+		CDrawListScene scene(&renderDevice, kNumberOfPipelines, kNumberOfMaterials);
+		CDrawList drawList;
+		const unsigned int maxRuns = threadPool.GetNumberOfThreads() + 1;
+
+		for (unsigned int numberOfPackets : { CDrawList::kMinPacketsPerRecordedRun, 4096u, 20000u })
+		{
+			FillDrawList(scene, drawList, numberOfPackets);
+
+			drawList.Submit(&renderDevice);
+			const CDrawList::Statistics direct = drawList.GetStatistics();
+
+			renderDevice.BeginFrame();
+			PrioTest::Benchmark("Submit " + std::to_string(numberOfPackets) + " packets across the workers", kIterations, [&]()
+			{
+				CHECK(drawList.Submit(&renderDevice, &passRecorder, maxRuns));
+			});
+
+			// Every run starts with nothing bound, so it can only bind as much or more than a single submit.
+			const CDrawList::Statistics& recorded = drawList.GetStatistics();
+			CHECK(recorded.packets == numberOfPackets);
+			CHECK(recorded.pipelineChanges >= direct.pipelineChanges);
+			CHECK(recorded.materialChanges >= direct.materialChanges);
+			CHECK(renderDevice.GetStatistics().draws == numberOfPackets * kIterations);
+		}
+	}
+	CHECK(renderDevice.GetNumberOfErrors() == 0);
+}
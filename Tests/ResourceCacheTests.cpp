@@ -0,0 +1,143 @@
+#include "Test.h"
+#include "StubDevice.h"
+#include "ResourceCache.h"
+#include <filesystem>
+
+namespace
+{
+	const std::string kTexture = std::string(PRIO_ENGINE_DIRECTORY) + "/Resources/Textures/Foliage/Grass.png";
+	const unsigned int kTextureSize = 64;
+	// What the cache counts one of the textures below as taking up.
+	const size_t kTextureBytes = kTextureSize * kTextureSize * 4;
+
+	// A texture with one level and nothing in it, with the only reference to it handed back.
+	ID3D11ShaderResourceView* CreateTexture(CStubDevice& device)
+	{
+		std::vector<unsigned char> texels(kTextureBytes);
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = kTextureSize;
+		desc.Height = kTextureSize;
+		desc.MipLevels = 1;
+		desc.ArraySize = 1;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		D3D11_SUBRESOURCE_DATA data = { texels.data(), kTextureSize * 4, 0 };
+
+		ID3D11Texture2D* texture = nullptr;
+		ID3D11ShaderResourceView* view = nullptr;
+		device.CreateTexture2D(&desc, &data, &texture);
+		device.CreateShaderResourceView(texture, nullptr, &view);
+		texture->Release();
+
+		return view;
+	}
+
+	// Whether a texture is still cached under a name, without keeping hold of it.
+	bool IsCached(CResourceCache& resourceCache, const std::string& filename)
+	{
+		ID3D11ShaderResourceView* texture = resourceCache.AcquireTexture(filename);
+		resourceCache.ReleaseTexture(texture);
+		return texture != nullptr;
+	}
+}
+
+TEST(SameContentsUnderTwoNamesShareAnEntry)
+{
+	std::filesystem::create_directories("Textures");
+	std::filesystem::copy_file(kTexture, "Textures/First.png", std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::copy_file(kTexture, "Textures/Second.png", std::filesystem::copy_options::overwrite_existing);
+
+	CStubDevice device;
+	{
+		CResourceCache resourceCache;
+		ID3D11ShaderResourceView* first = resourceCache.LoadTexture(&device, "Textures/First.png");
+		ID3D11ShaderResourceView* second = resourceCache.LoadTexture(&device, "Textures/Second.png");
+
+		CHECK(first != nullptr);
+		CHECK(first == second);
+		CHECK(device.GetNumberOfTextures() == 1);
+		CHECK(resourceCache.GetStatistics().numberOfTextures == 1);
+		CHECK(resourceCache.GetStatistics().misses == 1);
+		CHECK(resourceCache.GetStatistics().contentHits == 1);
+
+		// The second name is remembered, so it's found without reading the file again, whichever slashes and case it's given in.
+		ID3D11ShaderResourceView* byName = resourceCache.LoadTexture(&device, "textures\\SECOND.png");
+		CHECK(byName == first);
+		CHECK(resourceCache.GetStatistics().hits == 1);
+
+		resourceCache.ReleaseTexture(first);
+		resourceCache.ReleaseTexture(second);
+		resourceCache.ReleaseTexture(byName);
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+TEST(UnreferencedEntriesAreEvictedOldestFirst)
+{
+	CStubDevice device;
+	{
+		CResourceCache resourceCache(3 * kTextureBytes);
+		ID3D11ShaderResourceView* first = resourceCache.AddTexture("First", 1, CreateTexture(device));
+		ID3D11ShaderResourceView* second = resourceCache.AddTexture("Second", 2, CreateTexture(device));
+		ID3D11ShaderResourceView* third = resourceCache.AddTexture("Third", 3, CreateTexture(device));
+		resourceCache.ReleaseTexture(first);
+		resourceCache.ReleaseTexture(second);
+		resourceCache.ReleaseTexture(third);
+		CHECK(resourceCache.GetStatistics().residentBytes == 3 * kTextureBytes);
+		CHECK(resourceCache.GetStatistics().evictions == 0);
+
+		// Using the first again makes the second the oldest.
+		CHECK(IsCached(resourceCache, "First"));
+
+		ID3D11ShaderResourceView* fourth = resourceCache.AddTexture("Fourth", 4, CreateTexture(device));
+		CHECK(resourceCache.GetStatistics().evictions == 1);
+		CHECK(resourceCache.GetStatistics().residentBytes == 3 * kTextureBytes);
+		CHECK(!IsCached(resourceCache, "Second"));
+
+		ID3D11ShaderResourceView* fifth = resourceCache.AddTexture("Fifth", 5, CreateTexture(device));
+		CHECK(resourceCache.GetStatistics().evictions == 2);
+		CHECK(!IsCached(resourceCache, "Third"));
+		CHECK(IsCached(resourceCache, "First"));
+
+		// Its contents are forgotten along with its name, so the same data has to be created again.
+		CHECK(resourceCache.AcquireTexture("Other", 2) == nullptr);
+
+		resourceCache.ReleaseTexture(fourth);
+		resourceCache.ReleaseTexture(fifth);
+		CHECK(device.GetNumberOfLiveObjects() == 6);
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
+
+TEST(ReferencedEntriesAreNeverEvicted)
+{
+	CStubDevice device;
+	{
+		CResourceCache resourceCache(kTextureBytes);
+		ID3D11ShaderResourceView* first = resourceCache.AddTexture("First", 1, CreateTexture(device));
+		ID3D11ShaderResourceView* second = resourceCache.AddTexture("Second", 2, CreateTexture(device));
+
+		// Both are held, so the budget is simply exceeded.
+		CHECK(resourceCache.GetStatistics().evictions == 0);
+		CHECK(resourceCache.GetStatistics().residentBytes == 2 * kTextureBytes);
+
+		resourceCache.SetMemoryBudget(0);
+		CHECK(resourceCache.GetStatistics().evictions == 0);
+		CHECK(resourceCache.GetStatistics().numberOfTextures == 2);
+
+		// Goes the moment nothing holds it, as the cache is over budget.
+		resourceCache.ReleaseTexture(first);
+		CHECK(resourceCache.GetStatistics().evictions == 1);
+		CHECK(resourceCache.GetStatistics().numberOfTextures == 1);
+
+		ID3D11ShaderResourceView* again = resourceCache.AcquireTexture("Second");
+		CHECK(again == second);
+		resourceCache.ReleaseTexture(second);
+		CHECK(resourceCache.GetStatistics().evictions == 1);
+
+		resourceCache.ReleaseTexture(again);
+		CHECK(resourceCache.GetStatistics().evictions == 2);
+		CHECK(resourceCache.GetStatistics().residentBytes == 0);
+	}
+	CHECK(device.GetNumberOfLiveObjects() == 0);
+}
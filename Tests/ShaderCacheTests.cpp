@@ -0,0 +1,361 @@
+#include "Test.h"
+#include "ShaderCache.h"
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+
+namespace
+{
+	/* Stands in for D3DX, the "bytecode" is the source and defines it was given so a stale cache entry shows up. Source
+	* with "error" in it fails to compile. */
+	class CFakeCompiler
+	{
+	public:
+		CFakeCompiler() : mNumberOfCompiles(0)
+		{
+		}
+
+		CShaderCache::CompileFunction GetFunction()
+		{
+			return [this](const CShaderCache::ShaderDesc& desc, const std::string& source, std::vector<unsigned char>& bytecode, std::string& errors)
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mNumberOfCompiles++;
+				mCompiled.push_back(desc);
+
+				if (source.find("error") != std::string::npos)
+				{
+					errors = desc.filename + "(1,1): error X3000: syntax error";
+					return false;
+				}
+
+				const std::string output = Compiled(desc, source);
+				bytecode.assign(output.begin(), output.end());
+				return true;
+			};
+		}
+
+		static std::string Compiled(const CShaderCache::ShaderDesc& desc, const std::string& source)
+		{
+			std::string output = desc.entryPoint + "|" + desc.profile + "|" + source;
+			for (auto& define : desc.defines)
+			{
+				output += "|" + define.name + "=" + define.value;
+			}
+			return output;
+		}
+
+		unsigned int GetNumberOfCompiles() { return mNumberOfCompiles; }
+		const std::vector<CShaderCache::ShaderDesc>& GetCompiled() { return mCompiled; }
+	private:
+		unsigned int mNumberOfCompiles;
+		std::vector<CShaderCache::ShaderDesc> mCompiled;
+		std::mutex mMutex;
+	};
+
+	const std::string kShader = "Shaders/Water.hlsl";
+	const std::string kShaderSource = "#include \"Common.hlsl\"\nfloat4 WaterPS() : SV_TARGET { return Shade(); }\n";
+
+	void WriteText(const std::string& filename, const std::string& text)
+	{
+		std::filesystem::create_directories(std::filesystem::path(filename).parent_path());
+		std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+		file << text;
+	}
+
+	std::vector<unsigned char> ReadFile(const std::string& filename)
+	{
+		std::ifstream file(filename.c_str(), std::ios::binary);
+		return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	void WriteFile(const std::string& filename, const std::vector<unsigned char>& contents)
+	{
+		std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+	}
+
+	// A fresh set of shaders and an empty cache, so each test starts from nothing whatever ran before it.
+	std::string SetUp(const std::string& cacheDirectory)
+	{
+		std::filesystem::remove_all("Shaders");
+		std::filesystem::remove_all(cacheDirectory);
+		WriteText(kShader, kShaderSource);
+		WriteText("Shaders/Common.hlsl", "#include \"Lighting.hlsl\"\nfloat4 Shade() { return Light(); }\n");
+		// Includes Common again, which mustn't send the hash round in circles.
+		WriteText("Shaders/Lighting.hlsl", "#include \"Common.hlsl\"\nfloat4 Light() { return 1.0f; }\n");
+		return cacheDirectory;
+	}
+
+	CShaderCache::ShaderDesc WaterDesc()
+	{
+		CShaderCache::ShaderDesc desc;
+		desc.filename = kShader;
+		desc.entryPoint = "WaterPS";
+		desc.profile = "ps_5_0";
+		desc.flags = 0x800;
+		return desc;
+	}
+
+	bool Compile(CShaderCache& shaderCache, const CShaderCache::ShaderDesc& desc, CFakeCompiler& compiler, std::vector<unsigned char>& bytecode)
+	{
+		std::string errors;
+		const bool compiled = shaderCache.Compile(desc, compiler.GetFunction(), bytecode, errors);
+		CHECK(errors.empty() == compiled);
+		return compiled;
+	}
+}
+
+TEST(MissesAreCompiledAndStored)
+{
+	CShaderCache shaderCache(SetUp("MissCache"));
+	CFakeCompiler compiler;
+	const CShaderCache::ShaderDesc desc = WaterDesc();
+
+	std::vector<unsigned char> bytecode;
+	CHECK(Compile(shaderCache, desc, compiler, bytecode));
+	CHECK(compiler.GetNumberOfCompiles() == 1);
+	CHECK(std::string(bytecode.begin(), bytecode.end()) == CFakeCompiler::Compiled(desc, kShaderSource));
+
+	const unsigned long long key = shaderCache.CalculateKey(desc, kShaderSource);
+	CHECK(std::filesystem::exists(shaderCache.GetCachedFilename(key)));
+
+	const CShaderCache::Statistics statistics = shaderCache.GetStatistics();
+	CHECK(statistics.misses == 1 && statistics.hits == 0 && statistics.failures == 0);
+}
+
+TEST(HitsAreNotCompiledAgain)
+{
+	const std::string cacheDirectory = SetUp("HitCache");
+	CFakeCompiler compiler;
+	const CShaderCache::ShaderDesc desc = WaterDesc();
+
+	std::vector<unsigned char> compiled;
+	{
+		CShaderCache shaderCache(cacheDirectory);
+		CHECK(Compile(shaderCache, desc, compiler, compiled));
+	}
+
+	// A new cache on the same directory is a later run of the engine.
+	CShaderCache shaderCache(cacheDirectory);
+	for (unsigned int run = 0; run < 3; run++)
+	{
+		std::vector<unsigned char> bytecode;
+		CHECK(Compile(shaderCache, desc, compiler, bytecode));
+		CHECK(bytecode == compiled);
+	}
+	CHECK(compiler.GetNumberOfCompiles() == 1);
+
+	const CShaderCache::Statistics statistics = shaderCache.GetStatistics();
+	CHECK(statistics.hits == 3 && statistics.misses == 0);
+}
+
+TEST(KeyCoversEverythingCompiled)
+{
+	CShaderCache shaderCache(SetUp("KeyCache"));
+	const CShaderCache::ShaderDesc desc = WaterDesc();
+	const unsigned long long key = shaderCache.CalculateKey(desc, kShaderSource);
+	CHECK(shaderCache.CalculateKey(desc, kShaderSource) == key);
+
+	CShaderCache::ShaderDesc changed = desc;
+	changed.entryPoint = "WaterRefractionPS";
+	CHECK(shaderCache.CalculateKey(changed, kShaderSource) != key);
+
+	changed = desc;
+	changed.profile = "ps_4_0";
+	CHECK(shaderCache.CalculateKey(changed, kShaderSource) != key);
+
+	changed = desc;
+	changed.flags |= 1;
+	CHECK(shaderCache.CalculateKey(changed, kShaderSource) != key);
+
+	changed = desc;
+	changed.defines.push_back({ "REFLECTION", "1" });
+	const unsigned long long definedKey = shaderCache.CalculateKey(changed, kShaderSource);
+	CHECK(definedKey != key);
+	changed.defines[0].value = "0";
+	CHECK(shaderCache.CalculateKey(changed, kShaderSource) != definedKey);
+
+	// The boundary between strings is hashed too, so moving a character from one to the next isn't the same shader.
+	changed = desc;
+	changed.entryPoint = "WaterP";
+	changed.profile = "Sps_5_0";
+	CHECK(shaderCache.CalculateKey(changed, kShaderSource) != key);
+
+	CHECK(shaderCache.CalculateKey(desc, kShaderSource + "\n") != key);
+}
+
+TEST(EditingAnIncludeCompilesAgain)
+{
+	CShaderCache shaderCache(SetUp("IncludeCache"));
+	CFakeCompiler compiler;
+	const CShaderCache::ShaderDesc desc = WaterDesc();
+
+	std::vector<unsigned char> bytecode;
+	CHECK(Compile(shaderCache, desc, compiler, bytecode));
+	const unsigned long long key = shaderCache.CalculateKey(desc, kShaderSource);
+
+	// Lighting is only reached through Common, so this is two includes deep.
+	WriteText("Shaders/Lighting.hlsl", "#include \"Common.hlsl\"\nfloat4 Light() { return 0.5f; }\n");
+	const unsigned long long editedKey = shaderCache.CalculateKey(desc, kShaderSource);
+	CHECK(editedKey != key);
+
+	CHECK(Compile(shaderCache, desc, compiler, bytecode));
+	CHECK(compiler.GetNumberOfCompiles() == 2);
+	CHECK(std::filesystem::exists(shaderCache.GetCachedFilename(editedKey)));
+
+	// Putting it back finds the first copy still in the cache.
+	WriteText("Shaders/Lighting.hlsl", "#include \"Common.hlsl\"\nfloat4 Light() { return 1.0f; }\n");
+	CHECK(shaderCache.CalculateKey(desc, kShaderSource) == key);
+	CHECK(Compile(shaderCache, desc, compiler, bytecode));
+	CHECK(compiler.GetNumberOfCompiles() == 2);
+
+	// An include which isn't there still goes into the key by name.
+	std::filesystem::remove("Shaders/Lighting.hlsl");
+	CHECK(shaderCache.CalculateKey(desc, kShaderSource) != key);
+}
+
+TEST(BadCachedFilesAreCompiledAgain)
+{
+	CShaderCache shaderCache(SetUp("BadCache"));
+	CFakeCompiler compiler;
+	const CShaderCache::ShaderDesc desc = WaterDesc();
+
+	std::vector<unsigned char> bytecode;
+	CHECK(Compile(shaderCache, desc, compiler, bytecode));
+	const std::string cachedFile = shaderCache.GetCachedFilename(shaderCache.CalculateKey(desc, kShaderSource));
+	const std::vector<unsigned char> good = ReadFile(cachedFile);
+	CHECK(good.size() > 24);
+
+	std::vector<unsigned char> wrongVersion = good;
+	const unsigned int otherVersion = CShaderCache::kVersion + 1;
+	std::memcpy(wrongVersion.data() + 4, &otherVersion, sizeof(otherVersion));
+
+	std::vector<unsigned char> wrongMagic = good;
+	wrongMagic[0] ^= 0xFF;
+
+	const std::vector<std::vector<unsigned char>> badFiles =
+	{
+		std::vector<unsigned char>(good.begin(), good.end() - 1),
+		std::vector<unsigned char>(good.begin(), good.begin() + 10),
+		std::vector<unsigned char>(),
+		wrongVersion,
+		wrongMagic
+	};
+
+	unsigned int expectedCompiles = 1;
+	for (auto& badFile : badFiles)
+	{
+		WriteFile(cachedFile, badFile);
+		CHECK(Compile(shaderCache, desc, compiler, bytecode));
+		CHECK(compiler.GetNumberOfCompiles() == ++expectedCompiles);
+		CHECK(std::string(bytecode.begin(), bytecode.end()) == CFakeCompiler::Compiled(desc, kShaderSource));
+
+		// Stored again over the bad one.
+		CHECK(ReadFile(cachedFile) == good);
+	}
+}
+
+TEST(FailuresAreNotStored)
+{
+	CShaderCache shaderCache(SetUp("FailureCache"));
+	CFakeCompiler compiler;
+
+	WriteText("Shaders/Broken.hlsl", "float4 BrokenPS() : SV_TARGET { error }\n");
+	CShaderCache::ShaderDesc desc = WaterDesc();
+	desc.filename = "Shaders/Broken.hlsl";
+
+	std::vector<unsigned char> bytecode;
+	std::string errors;
+	CHECK(!shaderCache.Compile(desc, compiler.GetFunction(), bytecode, errors));
+	CHECK(errors.find("X3000") != std::string::npos);
+	CHECK(!std::filesystem::exists("FailureCache") || std::filesystem::is_empty("FailureCache"));
+
+	// Tried again each time, it may have been fixed since.
+	CHECK(!shaderCache.Compile(desc, compiler.GetFunction(), bytecode, errors));
+	CHECK(compiler.GetNumberOfCompiles() == 2);
+
+	// Source which can't be read never gets as far as the compiler, and has no errors to give.
+	desc.filename = "Shaders/NotThere.hlsl";
+	CHECK(!shaderCache.Compile(desc, compiler.GetFunction(), bytecode, errors));
+	CHECK(errors.empty());
+	CHECK(compiler.GetNumberOfCompiles() == 2);
+	CHECK(shaderCache.GetStatistics().failures == 3);
+}
+
+TEST(ManifestRoundTrips)
+{
+	const std::string cacheDirectory = SetUp("Manifest Cache");
+	WriteText("Shaders/With Space/Sky.hlsl", "float4 SkyPS() : SV_TARGET { return 0.0f; }\n");
+
+	std::vector<CShaderCache::ShaderDesc> shaders(3, WaterDesc());
+	shaders[1].defines.push_back({ "REFLECTION", "1" });
+	shaders[1].defines.push_back({ "QUALITY", "HIGH" });
+	shaders[2].filename = "Shaders/With Space/Sky.hlsl";
+	shaders[2].entryPoint = "SkyPS";
+	shaders[2].profile = "ps_4_0";
+	shaders[2].flags = 0x1234abcd;
+
+	CFakeCompiler compiler;
+	{
+		CShaderCache shaderCache(cacheDirectory);
+		for (auto& shader : shaders)
+		{
+			std::vector<unsigned char> bytecode;
+			CHECK(Compile(shaderCache, shader, compiler, bytecode));
+		}
+		CHECK(shaderCache.SaveManifest());
+	}
+
+	// Everything in the manifest is already cached, so there's nothing to do.
+	{
+		CFakeCompiler precompiler;
+		CShaderCache shaderCache(cacheDirectory);
+		CHECK(shaderCache.Precompile(precompiler.GetFunction()) == 0);
+		CHECK(precompiler.GetNumberOfCompiles() == 0);
+		CHECK(shaderCache.GetStatistics().hits == shaders.size());
+	}
+
+	// With the compiled shaders gone, each one comes back out of the manifest as it went in.
+	for (auto& entry : std::filesystem::directory_iterator(cacheDirectory))
+	{
+		if (entry.path().extension() == ".cso")
+		{
+			std::filesystem::remove(entry.path());
+		}
+	}
+
+	CFakeCompiler precompiler;
+	CShaderCache shaderCache(cacheDirectory);
+	CHECK(shaderCache.Precompile(precompiler.GetFunction()) == shaders.size());
+
+	const std::vector<CShaderCache::ShaderDesc>& precompiled = precompiler.GetCompiled();
+	CHECK(precompiled.size() == shaders.size());
+	for (auto& shader : shaders)
+	{
+		bool found = false;
+		for (auto& read : precompiled)
+		{
+			bool definesMatch = read.defines.size() == shader.defines.size();
+			for (size_t i = 0; definesMatch && i < shader.defines.size(); i++)
+			{
+				definesMatch = read.defines[i].name == shader.defines[i].name && read.defines[i].value == shader.defines[i].value;
+			}
+			found |= definesMatch && read.filename == shader.filename && read.entryPoint == shader.entryPoint &&
+				read.profile == shader.profile && read.flags == shader.flags;
+		}
+		CHECK(found);
+	}
+}
+
+TEST(ManifestFromAnotherVersionIsIgnored)
+{
+	const std::string cacheDirectory = SetUp("OldManifestCache");
+	WriteText(cacheDirectory + "/Manifest.txt", "PrioShaderManifest " + std::to_string(CShaderCache::kVersion + 1) +
+		"\n00000800 WaterPS ps_5_0 0 " + kShader + "\n");
+
+	CFakeCompiler compiler;
+	CShaderCache shaderCache(cacheDirectory);
+	CHECK(shaderCache.Precompile(compiler.GetFunction()) == 0);
+	CHECK(compiler.GetNumberOfCompiles() == 0);
+}
@@ -0,0 +1,181 @@
+#ifndef STUBDEVICE_H
+#define STUBDEVICE_H
+
+#include <d3d11.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* A device which creates textures and views that hold nothing, but are reference counted like the real thing. Every
+* creation is counted and the thread it was made on is kept, so tests can see when and where the device was used.
+* Render targets and their views can be made too, so a frame graph can pool them. Anything else the engine asks of it fails. */
+class CStubDevice : public ID3D11Device
+{
+public:
+	// Final, as both delete themselves through interfaces which, like COM's, have no virtual destructor.
+	class CStubTexture final : public ID3D11Texture2D
+	{
+	public:
+		CStubTexture(CStubDevice* device, const D3D11_TEXTURE2D_DESC& desc) : mpDevice(device), mDesc(desc), mReferenceCount(1)
+		{
+			mpDevice->mNumberOfLiveObjects++;
+		}
+		ULONG AddRef() override { return ++mReferenceCount; }
+		ULONG Release() override
+		{
+			const ULONG referenceCount = --mReferenceCount;
+			if (referenceCount == 0)
+			{
+				mpDevice->mNumberOfLiveObjects--;
+				delete this;
+			}
+			return referenceCount;
+		}
+		// The only interface asked of a texture is ID3D11Texture2D, which is this.
+		HRESULT QueryInterface(const GUID&, void** object) override
+		{
+			AddRef();
+			*object = static_cast<ID3D11Texture2D*>(this);
+			return S_OK;
+		}
+		void GetDesc(D3D11_TEXTURE2D_DESC* desc) override { *desc = mDesc; }
+	private:
+		CStubDevice* mpDevice;
+		D3D11_TEXTURE2D_DESC mDesc;
+		std::atomic<ULONG> mReferenceCount;
+	};
+
+	template <typename Interface>
+	class CStubView final : public Interface
+	{
+	public:
+		CStubView(CStubDevice* device, ID3D11Resource* resource) : mpDevice(device), mpResource(resource), mReferenceCount(1)
+		{
+			mpResource->AddRef();
+			mpDevice->mNumberOfLiveObjects++;
+		}
+		ULONG AddRef() override { return ++mReferenceCount; }
+		ULONG Release() override
+		{
+			const ULONG referenceCount = --mReferenceCount;
+			if (referenceCount == 0)
+			{
+				mpResource->Release();
+				mpDevice->mNumberOfLiveObjects--;
+				delete this;
+			}
+			return referenceCount;
+		}
+		HRESULT QueryInterface(const GUID&, void**) override { return E_NOINTERFACE; }
+		void GetResource(ID3D11Resource** resource) override
+		{
+			mpResource->AddRef();
+			*resource = mpResource;
+		}
+	private:
+		CStubDevice* mpDevice;
+		ID3D11Resource* mpResource;
+		std::atomic<ULONG> mReferenceCount;
+	};
+public:
+	CStubDevice() : mNumberOfTextures(0), mNumberOfViews(0), mNumberOfLiveObjects(0), mChecksum(0)
+	{
+	}
+
+	HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture) override
+	{
+		// Only something the GPU draws into can start out empty.
+		const bool isTarget = (desc->BindFlags & (D3D11_BIND_RENDER_TARGET | D3D11_BIND_DEPTH_STENCIL)) != 0;
+		if (desc->Width == 0 || desc->Height == 0 || desc->MipLevels == 0 || (initialData == nullptr && !isTarget))
+		{
+			return E_FAIL;
+		}
+
+		// Touch the first row of every level, as a real device would copy them, so data which isn't there shows up under a sanitiser.
+		unsigned int checksum = 0;
+		for (unsigned int level = 0; initialData != nullptr && level < desc->MipLevels; level++)
+		{
+			const unsigned char* data = static_cast<const unsigned char*>(initialData[level].pSysMem);
+			checksum += data[0] + data[initialData[level].SysMemPitch - 1];
+		}
+		mChecksum += checksum;
+
+		RecordCreation();
+		mNumberOfTextures++;
+		*texture = new CStubTexture(this, *desc);
+		return S_OK;
+	}
+
+	HRESULT CreateShaderResourceView(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC*, ID3D11ShaderResourceView** view) override
+	{
+		RecordCreation();
+		mNumberOfViews++;
+		*view = new CStubView<ID3D11ShaderResourceView>(this, resource);
+		return S_OK;
+	}
+
+	HRESULT CreateRenderTargetView(ID3D11Resource* resource, const void*, ID3D11RenderTargetView** view) override
+	{
+		RecordCreation();
+		mNumberOfViews++;
+		*view = new CStubView<ID3D11RenderTargetView>(this, resource);
+		return S_OK;
+	}
+
+	HRESULT CreateDepthStencilView(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC*, ID3D11DepthStencilView** view) override
+	{
+		RecordCreation();
+		mNumberOfViews++;
+		*view = new CStubView<ID3D11DepthStencilView>(this, resource);
+		return S_OK;
+	}
+
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Buffer**) override { return E_FAIL; }
+	HRESULT CreateVertexShader(const void*, size_t, ID3D11ClassLinkage*, ID3D11VertexShader**) override { return E_FAIL; }
+	HRESULT CreatePixelShader(const void*, size_t, ID3D11ClassLinkage*, ID3D11PixelShader**) override { return E_FAIL; }
+	HRESULT CreateGeometryShader(const void*, size_t, ID3D11ClassLinkage*, ID3D11GeometryShader**) override { return E_FAIL; }
+	HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC*, UINT, const void*, size_t, ID3D11InputLayout**) override { return E_FAIL; }
+	HRESULT CreateDeferredContext(UINT, ID3D11DeviceContext**) override { return E_FAIL; }
+	HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC*, ID3D11SamplerState**) override { return E_FAIL; }
+	HRESULT CreateQuery(const D3D11_QUERY_DESC*, ID3D11Query**) override { return E_FAIL; }
+
+	// The device itself lives on the stack of the test.
+	ULONG AddRef() override { return 1; }
+	ULONG Release() override { return 1; }
+	HRESULT QueryInterface(const GUID&, void**) override { return E_NOINTERFACE; }
+
+	unsigned int GetNumberOfTextures() { return mNumberOfTextures; }
+	unsigned int GetNumberOfViews() { return mNumberOfViews; }
+	// Textures and views which haven't been released yet.
+	int GetNumberOfLiveObjects() { return mNumberOfLiveObjects; }
+
+	// Whether everything created so far was created on the given thread.
+	bool AllCreatedOn(std::thread::id thread)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto& creationThread : mCreationThreads)
+		{
+			if (creationThread != thread)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+private:
+	void RecordCreation()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mCreationThreads.push_back(std::this_thread::get_id());
+	}
+private:
+	std::atomic<unsigned int> mNumberOfTextures;
+	std::atomic<unsigned int> mNumberOfViews;
+	std::atomic<int> mNumberOfLiveObjects;
+	std::atomic<unsigned int> mChecksum;
+	std::mutex mMutex;
+	std::vector<std::thread::id> mCreationThreads;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include <Importer.hpp>
+#include <scene.h>
+
+// Nothing can be imported in the tests, every model fails to load as if the file were missing, unless a test has set a
+// scene for every import to return instead. Cooked meshes which are already on disk can still be read, that doesn't go
+// through assimp.
+
+namespace
+{
+	const aiScene* gScene = nullptr;
+}
+
+const aiScene* Assimp::Importer::ReadFile(const std::string&, unsigned int)
+{
+	return gScene;
+}
+
+void Assimp::Importer::SetScene(const aiScene* scene)
+{
+	gScene = scene;
+}
+
+const char* Assimp::Importer::GetErrorString() const
+{
+	return "Assimp isn't available in the tests.";
+}
+
+const char* aiString::C_Str() const
+{
+	return data;
+}
+
+int aiMaterial::GetTexture(aiTextureType, unsigned int, aiString*) const
+{
+	return -1;
+}
+
+bool aiMesh::HasPositions() const
+{
+	return mVertices != nullptr;
+}
+
+bool aiMesh::HasNormals() const
+{
+	return mNormals != nullptr;
+}
+
+bool aiMesh::HasTangentsAndBitangents() const
+{
+	return false;
+}
+
+bool aiMesh::HasTextureCoords(unsigned int index) const
+{
+	return index < AI_MAX_NUMBER_OF_TEXTURECOORDS && mTextureCoords[index] != nullptr;
+}
+
+bool aiMesh::HasVertexColors(unsigned int) const
+{
+	return false;
+}
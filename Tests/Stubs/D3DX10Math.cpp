@@ -0,0 +1,293 @@
+#include <D3DX10math.h>
+
+// Row vectors multiplied on the left, the same convention as D3DX.
+
+D3DXMATRIX D3DXMATRIX::operator*(const D3DXMATRIX& other) const
+{
+	D3DXMATRIX result;
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			float sum = 0.0f;
+			for (int i = 0; i < 4; i++)
+			{
+				sum += m[row][i] * other.m[i][column];
+			}
+			result.m[row][column] = sum;
+		}
+	}
+	return result;
+}
+
+D3DXMATRIX& D3DXMATRIX::operator*=(const D3DXMATRIX& other)
+{
+	*this = *this * other;
+	return *this;
+}
+
+D3DXMATRIX* D3DXMatrixIdentity(D3DXMATRIX* out)
+{
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			out->m[row][column] = row == column ? 1.0f : 0.0f;
+		}
+	}
+	return out;
+}
+
+D3DXMATRIX* D3DXMatrixMultiply(D3DXMATRIX* out, const D3DXMATRIX* a, const D3DXMATRIX* b)
+{
+	*out = *a * *b;
+	return out;
+}
+
+D3DXMATRIX* D3DXMatrixTranspose(D3DXMATRIX* out, const D3DXMATRIX* in)
+{
+	D3DXMATRIX result;
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			result.m[row][column] = in->m[column][row];
+		}
+	}
+	*out = result;
+	return out;
+}
+
+D3DXMATRIX* D3DXMatrixRotationX(D3DXMATRIX* out, float angle)
+{
+	D3DXMatrixIdentity(out);
+	out->_22 = std::cos(angle);
+	out->_23 = std::sin(angle);
+	out->_32 = -std::sin(angle);
+	out->_33 = std::cos(angle);
+	return out;
+}
+
+D3DXMATRIX* D3DXMatrixRotationY(D3DXMATRIX* out, float angle)
+{
+	D3DXMatrixIdentity(out);
+	out->_11 = std::cos(angle);
+	out->_13 = -std::sin(angle);
+	out->_31 = std::sin(angle);
+	out->_33 = std::cos(angle);
+	return out;
+}
+
+D3DXMATRIX* D3DXMatrixRotationZ(D3DXMATRIX* out, float angle)
+{
+	D3DXMatrixIdentity(out);
+	out->_11 = std::cos(angle);
+	out->_12 = std::sin(angle);
+	out->_21 = -std::sin(angle);
+	out->_22 = std::cos(angle);
+	return out;
+}
+
+D3DXMATRIX* D3DXMatrixScaling(D3DXMATRIX* out, float x, float y, float z)
+{
+	D3DXMatrixIdentity(out);
+	out->_11 = x;
+	out->_22 = y;
+	out->_33 = z;
+	return out;
+}
+
+D3DXMATRIX* D3DXMatrixTranslation(D3DXMATRIX* out, float x, float y, float z)
+{
+	D3DXMatrixIdentity(out);
+	out->_41 = x;
+	out->_42 = y;
+	out->_43 = z;
+	return out;
+}
+
+/* Gauss-Jordan elimination with partial pivoting. */
+D3DXMATRIX* D3DXMatrixInverse(D3DXMATRIX* out, float* determinant, const D3DXMATRIX* in)
+{
+	double work[4][8];
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			work[row][column] = in->m[row][column];
+			work[row][column + 4] = row == column ? 1.0 : 0.0;
+		}
+	}
+
+	double product = 1.0;
+	for (int column = 0; column < 4; column++)
+	{
+		int pivot = column;
+		for (int row = column + 1; row < 4; row++)
+		{
+			if (std::fabs(work[row][column]) > std::fabs(work[pivot][column]))
+			{
+				pivot = row;
+			}
+		}
+
+		if (work[pivot][column] == 0.0)
+		{
+			if (determinant != nullptr)
+			{
+				*determinant = 0.0f;
+			}
+			return nullptr;
+		}
+
+		if (pivot != column)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				const double swap = work[column][i];
+				work[column][i] = work[pivot][i];
+				work[pivot][i] = swap;
+			}
+			product = -product;
+		}
+
+		const double scale = work[column][column];
+		product *= scale;
+		for (int i = 0; i < 8; i++)
+		{
+			work[column][i] /= scale;
+		}
+
+		for (int row = 0; row < 4; row++)
+		{
+			if (row != column)
+			{
+				const double factor = work[row][column];
+				for (int i = 0; i < 8; i++)
+				{
+					work[row][i] -= factor * work[column][i];
+				}
+			}
+		}
+	}
+
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			out->m[row][column] = static_cast<float>(work[row][column + 4]);
+		}
+	}
+
+	if (determinant != nullptr)
+	{
+		*determinant = static_cast<float>(product);
+	}
+	return out;
+}
+
+D3DXMATRIX* D3DXMatrixLookAtLH(D3DXMATRIX* out, const D3DXVECTOR3* eye, const D3DXVECTOR3* at, const D3DXVECTOR3* up)
+{
+	D3DXVECTOR3 zAxis = *at - *eye;
+	D3DXVec3Normalize(&zAxis, &zAxis);
+
+	D3DXVECTOR3 xAxis(up->y * zAxis.z - up->z * zAxis.y, up->z * zAxis.x - up->x * zAxis.z, up->x * zAxis.y - up->y * zAxis.x);
+	D3DXVec3Normalize(&xAxis, &xAxis);
+
+	const D3DXVECTOR3 yAxis(zAxis.y * xAxis.z - zAxis.z * xAxis.y, zAxis.z * xAxis.x - zAxis.x * xAxis.z, zAxis.x * xAxis.y - zAxis.y * xAxis.x);
+
+	D3DXMatrixIdentity(out);
+	out->_11 = xAxis.x;
+	out->_21 = xAxis.y;
+	out->_31 = xAxis.z;
+	out->_12 = yAxis.x;
+	out->_22 = yAxis.y;
+	out->_32 = yAxis.z;
+	out->_13 = zAxis.x;
+	out->_23 = zAxis.y;
+	out->_33 = zAxis.z;
+	out->_41 = -(xAxis.x * eye->x + xAxis.y * eye->y + xAxis.z * eye->z);
+	out->_42 = -(yAxis.x * eye->x + yAxis.y * eye->y + yAxis.z * eye->z);
+	out->_43 = -(zAxis.x * eye->x + zAxis.y * eye->y + zAxis.z * eye->z);
+	return out;
+}
+
+D3DXMATRIX* D3DXMatrixPerspectiveFovLH(D3DXMATRIX* out, float fieldOfView, float aspect, float nearClip, float farClip)
+{
+	const float yScale = 1.0f / std::tan(fieldOfView * 0.5f);
+
+	for (int row = 0; row < 4; row++)
+	{
+		for (int column = 0; column < 4; column++)
+		{
+			out->m[row][column] = 0.0f;
+		}
+	}
+	out->_11 = yScale / aspect;
+	out->_22 = yScale;
+	out->_33 = farClip / (farClip - nearClip);
+	out->_34 = 1.0f;
+	out->_43 = -nearClip * farClip / (farClip - nearClip);
+	return out;
+}
+
+D3DXMATRIX* D3DXMatrixOrthoLH(D3DXMATRIX* out, float width, float height, float nearClip, float farClip)
+{
+	D3DXMatrixIdentity(out);
+	out->_11 = 2.0f / width;
+	out->_22 = 2.0f / height;
+	out->_33 = 1.0f / (farClip - nearClip);
+	out->_43 = -nearClip / (farClip - nearClip);
+	return out;
+}
+
+D3DXPLANE* D3DXPlaneNormalize(D3DXPLANE* out, const D3DXPLANE* in)
+{
+	const float length = std::sqrt(in->a * in->a + in->b * in->b + in->c * in->c);
+	const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+	*out = D3DXPLANE(in->a * scale, in->b * scale, in->c * scale, in->d * scale);
+	return out;
+}
+
+float D3DXPlaneDotCoord(const D3DXPLANE* plane, const D3DXVECTOR3* point)
+{
+	return plane->a * point->x + plane->b * point->y + plane->c * point->z + plane->d;
+}
+
+D3DXVECTOR4* D3DXVec3Transform(D3DXVECTOR4* out, const D3DXVECTOR3* in, const D3DXMATRIX* matrix)
+{
+	const D3DXMATRIX& m = *matrix;
+	*out = D3DXVECTOR4(in->x * m._11 + in->y * m._21 + in->z * m._31 + m._41, in->x * m._12 + in->y * m._22 + in->z * m._32 + m._42,
+		in->x * m._13 + in->y * m._23 + in->z * m._33 + m._43, in->x * m._14 + in->y * m._24 + in->z * m._34 + m._44);
+	return out;
+}
+
+D3DXVECTOR3* D3DXVec3TransformCoord(D3DXVECTOR3* out, const D3DXVECTOR3* in, const D3DXMATRIX* matrix)
+{
+	D3DXVECTOR4 transformed;
+	D3DXVec3Transform(&transformed, in, matrix);
+	const float invW = transformed.w != 0.0f ? 1.0f / transformed.w : 0.0f;
+	*out = D3DXVECTOR3(transformed.x * invW, transformed.y * invW, transformed.z * invW);
+	return out;
+}
+
+D3DXVECTOR3* D3DXVec3TransformNormal(D3DXVECTOR3* out, const D3DXVECTOR3* in, const D3DXMATRIX* matrix)
+{
+	const D3DXMATRIX& m = *matrix;
+	*out = D3DXVECTOR3(in->x * m._11 + in->y * m._21 + in->z * m._31, in->x * m._12 + in->y * m._22 + in->z * m._32,
+		in->x * m._13 + in->y * m._23 + in->z * m._33);
+	return out;
+}
+
+float D3DXVec3Length(const D3DXVECTOR3* in)
+{
+	return std::sqrt(in->x * in->x + in->y * in->y + in->z * in->z);
+}
+
+D3DXVECTOR3* D3DXVec3Normalize(D3DXVECTOR3* out, const D3DXVECTOR3* in)
+{
+	const float length = D3DXVec3Length(in);
+	const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+	*out = D3DXVECTOR3(in->x * scale, in->y * scale, in->z * scale);
+	return out;
+}
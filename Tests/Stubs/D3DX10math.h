@@ -0,0 +1,25 @@
+#pragma once
+// Stand in for the D3DX maths header, the functions the tests need are defined in D3DX10Math.cpp.
+#include <windows.h>
+#include <cmath>
+#define D3DX_PI 3.14159265358979323846
+struct D3DXVECTOR2 { float x, y; D3DXVECTOR2() {} D3DXVECTOR2(float a, float b) : x(a), y(b) {} };
+struct D3DXVECTOR3 { float x, y, z; D3DXVECTOR3() {} D3DXVECTOR3(float a, float b, float c) : x(a), y(b), z(c) {}
+ D3DXVECTOR3 operator+(const D3DXVECTOR3& o) const { return D3DXVECTOR3(x+o.x,y+o.y,z+o.z); } D3DXVECTOR3 operator-(const D3DXVECTOR3& o) const { return D3DXVECTOR3(x-o.x,y-o.y,z-o.z); }
+ D3DXVECTOR3 operator*(float s) const { return D3DXVECTOR3(x*s,y*s,z*s); } D3DXVECTOR3& operator+=(const D3DXVECTOR3& o){x+=o.x;y+=o.y;z+=o.z;return *this;} };
+struct D3DXVECTOR4 { float x, y, z, w; D3DXVECTOR4() {} D3DXVECTOR4(float a, float b, float c, float d) : x(a), y(b), z(c), w(d) {} D3DXVECTOR4& operator*=(float s){x*=s;y*=s;z*=s;w*=s;return *this;} };
+struct D3DMATRIX { union { struct { float _11,_12,_13,_14,_21,_22,_23,_24,_31,_32,_33,_34,_41,_42,_43,_44; }; float m[4][4]; }; };
+struct D3DXMATRIX : D3DMATRIX { D3DXMATRIX() {} D3DXMATRIX operator*(const D3DXMATRIX&) const; D3DXMATRIX& operator*=(const D3DXMATRIX&); D3DXMATRIX(const D3DMATRIX& o) : D3DMATRIX(o) {} operator float*() { return &_11; } };
+struct D3DXPLANE { float a, b, c, d; D3DXPLANE() {} D3DXPLANE(float a_, float b_, float c_, float d_) : a(a_), b(b_), c(c_), d(d_) {} };
+D3DXMATRIX* D3DXMatrixRotationX(D3DXMATRIX*, float); D3DXMATRIX* D3DXMatrixRotationY(D3DXMATRIX*, float); D3DXMATRIX* D3DXMatrixRotationZ(D3DXMATRIX*, float);
+D3DXMATRIX* D3DXMatrixScaling(D3DXMATRIX*, float, float, float); D3DXMATRIX* D3DXMatrixTranslation(D3DXMATRIX*, float, float, float);
+D3DXMATRIX* D3DXMatrixMultiply(D3DXMATRIX*, const D3DXMATRIX*, const D3DXMATRIX*); D3DXMATRIX* D3DXMatrixTranspose(D3DXMATRIX*, const D3DXMATRIX*);
+D3DXMATRIX* D3DXMatrixIdentity(D3DXMATRIX*); D3DXMATRIX* D3DXMatrixInverse(D3DXMATRIX*, float*, const D3DXMATRIX*);
+D3DXMATRIX* D3DXMatrixLookAtLH(D3DXMATRIX*, const D3DXVECTOR3*, const D3DXVECTOR3*, const D3DXVECTOR3*);
+D3DXMATRIX* D3DXMatrixPerspectiveFovLH(D3DXMATRIX*, float, float, float, float); D3DXMATRIX* D3DXMatrixOrthoLH(D3DXMATRIX*, float, float, float, float);
+D3DXPLANE* D3DXPlaneNormalize(D3DXPLANE*, const D3DXPLANE*); float D3DXPlaneDotCoord(const D3DXPLANE*, const D3DXVECTOR3*);
+D3DXVECTOR3* D3DXVec3TransformCoord(D3DXVECTOR3*, const D3DXVECTOR3*, const D3DXMATRIX*);
+D3DXVECTOR3* D3DXVec3Normalize(D3DXVECTOR3*, const D3DXVECTOR3*);
+float D3DXVec3Length(const D3DXVECTOR3*);
+D3DXVECTOR4* D3DXVec3Transform(D3DXVECTOR4*, const D3DXVECTOR3*, const D3DXMATRIX*);
+D3DXVECTOR3* D3DXVec3TransformNormal(D3DXVECTOR3*, const D3DXVECTOR3*, const D3DXMATRIX*);
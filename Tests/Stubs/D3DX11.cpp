@@ -0,0 +1,27 @@
+#include <D3DX11tex.h>
+#include <D3DX11async.h>
+
+// D3DX isn't available in the tests, so anything the engine can't decode itself fails to load as if it were corrupt.
+
+HRESULT D3DX11CreateShaderResourceViewFromFile(ID3D11Device*, const char*, void*, void*, ID3D11ShaderResourceView** texture, HRESULT*)
+{
+	*texture = nullptr;
+	return E_FAIL;
+}
+
+HRESULT D3DX11CreateShaderResourceViewFromMemory(ID3D11Device*, const void*, size_t, void*, void*, ID3D11ShaderResourceView** texture, HRESULT*)
+{
+	*texture = nullptr;
+	return E_FAIL;
+}
+
+// Nothing in the tests draws, so shaders only need to fail to compile as they would with a broken source.
+HRESULT D3DX11CompileFromMemory(const char*, size_t, const char*, const D3D10_SHADER_MACRO*, void*, const char*, const char*, UINT, UINT, void*, ID3D10Blob** shader, ID3D10Blob** errors, HRESULT*)
+{
+	*shader = nullptr;
+	if (errors != nullptr)
+	{
+		*errors = nullptr;
+	}
+	return E_FAIL;
+}
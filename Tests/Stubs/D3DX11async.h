@@ -0,0 +1,7 @@
+#pragma once
+// Stand in for the D3DX shader compiler header, the compiler is defined in D3DX11.cpp and always fails.
+#include <d3d11.h>
+#define D3D10_SHADER_ENABLE_STRICTNESS 0x800
+HRESULT D3DX11CompileFromFile(const char*, const D3D10_SHADER_MACRO*, void*, const char*, const char*, UINT, UINT, void*, ID3D10Blob**, ID3D10Blob**, HRESULT*);
+HRESULT D3DX11CompileFromMemory(const char*, size_t, const char*, const D3D10_SHADER_MACRO*, void*, const char*, const char*, UINT, UINT, void*, ID3D10Blob**, ID3D10Blob**, HRESULT*);
+HRESULT D3D10CreateBlob(size_t, ID3D10Blob**);
@@ -0,0 +1,5 @@
+#pragma once
+// Stand in for the D3DX texture header, defined in D3DX11.cpp to fail every load.
+#include <d3d11.h>
+HRESULT D3DX11CreateShaderResourceViewFromFile(ID3D11Device*, const char*, void*, void*, ID3D11ShaderResourceView**, HRESULT*);
+HRESULT D3DX11CreateShaderResourceViewFromMemory(ID3D11Device*, const void*, size_t, void*, void*, ID3D11ShaderResourceView**, HRESULT*);
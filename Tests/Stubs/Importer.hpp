@@ -0,0 +1,7 @@
+#pragma once
+// Stand in for the assimp importer, defined in Assimp.cpp to fail every import unless a test has handed it a scene.
+#include <string>
+#include "scene.h"
+namespace Assimp { class Importer { public: const aiScene* ReadFile(const std::string&, unsigned int); const char* GetErrorString() const;
+ // Not part of assimp, every file read returns this scene until it is set back to null.
+ static void SetScene(const aiScene* scene); }; }
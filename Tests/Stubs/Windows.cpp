@@ -0,0 +1,24 @@
+#include <windows.h>
+
+// Only what's linked into the tests without being called, or which has an obvious portable meaning.
+
+int MultiByteToWideChar(UINT, DWORD, const char* source, int sourceLength, wchar_t* destination, int destinationLength)
+{
+	if (sourceLength < 0)
+	{
+		sourceLength = static_cast<int>(strlen(source)) + 1;
+	}
+
+	// Asked how much room is needed.
+	if (destinationLength == 0)
+	{
+		return sourceLength;
+	}
+
+	const int length = sourceLength < destinationLength ? sourceLength : destinationLength;
+	for (int i = 0; i < length; i++)
+	{
+		destination[i] = static_cast<wchar_t>(static_cast<unsigned char>(source[i]));
+	}
+	return length;
+}
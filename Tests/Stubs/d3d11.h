@@ -0,0 +1,109 @@
+#pragma once
+// Stand in for the Direct3D 11 header. The interfaces are abstract, so tests can implement the parts they need.
+#include <dxgi.h>
+#include <d3dcommon.h>
+enum D3D11_USAGE { D3D11_USAGE_DEFAULT, D3D11_USAGE_IMMUTABLE, D3D11_USAGE_DYNAMIC, D3D11_USAGE_STAGING };
+enum { D3D11_BIND_VERTEX_BUFFER=1, D3D11_BIND_INDEX_BUFFER=2, D3D11_BIND_CONSTANT_BUFFER=4, D3D11_BIND_SHADER_RESOURCE=8, D3D11_BIND_RENDER_TARGET=0x20, D3D11_BIND_DEPTH_STENCIL=0x40 };
+enum { D3D11_CPU_ACCESS_WRITE=0x10000 };
+enum D3D11_MAP { D3D11_MAP_READ=1, D3D11_MAP_WRITE=2, D3D11_MAP_WRITE_DISCARD=4, D3D11_MAP_WRITE_NO_OVERWRITE=5 };
+enum D3D11_PRIMITIVE_TOPOLOGY { D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED, D3D11_PRIMITIVE_TOPOLOGY_POINTLIST, D3D11_PRIMITIVE_TOPOLOGY_LINELIST, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST=4 };
+enum D3D11_INPUT_CLASSIFICATION { D3D11_INPUT_PER_VERTEX_DATA, D3D11_INPUT_PER_INSTANCE_DATA };
+#define D3D11_APPEND_ALIGNED_ELEMENT 0xffffffff
+#define D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT 14
+#define D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT 128
+#define D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT 16
+#define D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+#define D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE 16
+#define D3D11_CLEAR_DEPTH 1
+enum D3D11_RESOURCE_DIMENSION { D3D11_RESOURCE_DIMENSION_TEXTURE2D=3 };
+enum D3D11_SRV_DIMENSION { D3D11_SRV_DIMENSION_TEXTURE2D=4 };
+struct D3D11_BUFFER_DESC { UINT ByteWidth; D3D11_USAGE Usage; UINT BindFlags; UINT CPUAccessFlags; UINT MiscFlags; UINT StructureByteStride; };
+struct D3D11_SUBRESOURCE_DATA { const void* pSysMem; UINT SysMemPitch; UINT SysMemSlicePitch; };
+struct D3D11_MAPPED_SUBRESOURCE { void* pData; UINT RowPitch; UINT DepthPitch; };
+struct D3D11_INPUT_ELEMENT_DESC { const char* SemanticName; UINT SemanticIndex; DXGI_FORMAT Format; UINT InputSlot; UINT AlignedByteOffset; D3D11_INPUT_CLASSIFICATION InputSlotClass; UINT InstanceDataStepRate; };
+struct D3D11_TEXTURE2D_DESC { UINT Width, Height, MipLevels, ArraySize; DXGI_FORMAT Format; DXGI_SAMPLE_DESC SampleDesc; D3D11_USAGE Usage; UINT BindFlags, CPUAccessFlags, MiscFlags; };
+struct D3D11_TEX2D_SRV { UINT MostDetailedMip; UINT MipLevels; };
+struct D3D11_SHADER_RESOURCE_VIEW_DESC { DXGI_FORMAT Format; D3D11_SRV_DIMENSION ViewDimension; union { D3D11_TEX2D_SRV Texture2D; }; };
+struct D3D11_VIEWPORT { float TopLeftX, TopLeftY, Width, Height, MinDepth, MaxDepth; };
+struct D3D11_RASTERIZER_DESC {}; struct D3D11_DEPTH_STENCIL_DESC {}; struct D3D11_DEPTH_STENCIL_VIEW_DESC {}; enum D3D11_FILTER { D3D11_FILTER_MIN_MAG_MIP_LINEAR, D3D11_FILTER_MIN_MAG_MIP_POINT };
+enum D3D11_TEXTURE_ADDRESS_MODE { D3D11_TEXTURE_ADDRESS_WRAP=1, D3D11_TEXTURE_ADDRESS_MIRROR=2, D3D11_TEXTURE_ADDRESS_CLAMP=3 };
+enum D3D11_COMPARISON_FUNC { D3D11_COMPARISON_NEVER=1, D3D11_COMPARISON_ALWAYS=8 };
+struct D3D11_SAMPLER_DESC { int Filter; int AddressU, AddressV, AddressW; float MipLODBias; UINT MaxAnisotropy; int ComparisonFunc; float BorderColor[4]; float MinLOD, MaxLOD; };
+#define D3D11_FLOAT32_MAX 3.402823466e+38f
+struct D3D11_QUERY_DESC { UINT Query; UINT MiscFlags; };
+enum { D3D11_QUERY_EVENT = 0 };
+struct ID3D11DeviceChild : IUnknown {};
+struct ID3D11Resource : ID3D11DeviceChild {};
+struct ID3D11Buffer : ID3D11Resource { virtual void GetDesc(D3D11_BUFFER_DESC*) = 0; };
+struct ID3D11Texture2D : ID3D11Resource { virtual void GetDesc(D3D11_TEXTURE2D_DESC*) = 0; };
+struct ID3D11View : ID3D11DeviceChild { virtual void GetResource(ID3D11Resource**) = 0; };
+struct ID3D11ShaderResourceView : ID3D11View {};
+struct ID3D11RenderTargetView : ID3D11View {};
+struct ID3D11DepthStencilView : ID3D11View {};
+struct ID3D11VertexShader : ID3D11DeviceChild {}; struct ID3D11PixelShader : ID3D11DeviceChild {}; struct ID3D11GeometryShader : ID3D11DeviceChild {};
+struct ID3D11InputLayout : ID3D11DeviceChild {}; struct ID3D11SamplerState : ID3D11DeviceChild {};
+struct ID3D11BlendState : ID3D11DeviceChild {}; struct ID3D11RasterizerState : ID3D11DeviceChild {}; struct ID3D11DepthStencilState : ID3D11DeviceChild {};
+struct ID3D11Asynchronous : ID3D11DeviceChild {}; struct ID3D11Query : ID3D11Asynchronous {};
+struct ID3D11CommandList : ID3D11DeviceChild {};
+struct ID3D11ClassLinkage; struct ID3D11ClassInstance;
+struct ID3D11DeviceContext : ID3D11DeviceChild {
+ virtual HRESULT Map(ID3D11Resource*, UINT, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE*) = 0;
+ virtual void Unmap(ID3D11Resource*, UINT) = 0;
+ virtual void VSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) = 0;
+ virtual void PSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) = 0;
+ virtual void GSSetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) = 0;
+ virtual void IASetVertexBuffers(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) = 0;
+ virtual void IASetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT, UINT) = 0;
+ virtual void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY) = 0;
+ virtual void IASetInputLayout(ID3D11InputLayout*) = 0;
+ virtual void VSSetShader(ID3D11VertexShader*, ID3D11ClassInstance* const*, UINT) = 0;
+ virtual void PSSetShader(ID3D11PixelShader*, ID3D11ClassInstance* const*, UINT) = 0;
+ virtual void GSSetShader(ID3D11GeometryShader*, ID3D11ClassInstance* const*, UINT) = 0;
+ virtual void PSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) = 0;
+ virtual void VSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) = 0;
+ virtual void GSSetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) = 0;
+ virtual void PSSetSamplers(UINT, UINT, ID3D11SamplerState* const*) = 0;
+ virtual void VSSetSamplers(UINT, UINT, ID3D11SamplerState* const*) = 0;
+ virtual void GSSetSamplers(UINT, UINT, ID3D11SamplerState* const*) = 0;
+ virtual void SOSetTargets(UINT, ID3D11Buffer* const*, const UINT*) = 0;
+ virtual void DrawAuto() = 0;
+ virtual void OMSetBlendState(ID3D11BlendState*, const float[4], UINT) = 0;
+ virtual void OMSetDepthStencilState(ID3D11DepthStencilState*, UINT) = 0;
+ virtual void OMSetRenderTargets(UINT, ID3D11RenderTargetView* const*, ID3D11DepthStencilView*) = 0;
+ virtual void RSSetState(ID3D11RasterizerState*) = 0;
+ virtual void RSSetViewports(UINT, const D3D11_VIEWPORT*) = 0;
+ virtual void DrawIndexed(UINT, UINT, int) = 0;
+ virtual void Draw(UINT, UINT) = 0;
+ virtual void DrawIndexedInstanced(UINT, UINT, UINT, int, UINT) = 0;
+ virtual void DrawInstanced(UINT, UINT, UINT, UINT) = 0;
+ virtual void ClearDepthStencilView(ID3D11DepthStencilView*, UINT, float, BYTE) = 0;
+ virtual void ClearRenderTargetView(ID3D11RenderTargetView*, const float[4]) = 0;
+ virtual void UpdateSubresource(ID3D11Resource*, UINT, const void*, const void*, UINT, UINT) = 0;
+ virtual void ExecuteCommandList(ID3D11CommandList*, BOOL) = 0;
+ virtual HRESULT FinishCommandList(BOOL, ID3D11CommandList**) = 0;
+ virtual void End(ID3D11Asynchronous*) = 0;
+ virtual HRESULT GetData(ID3D11Asynchronous*, void*, UINT, UINT) = 0;
+ virtual void ClearState() = 0;
+ virtual void OMGetRenderTargets(UINT, ID3D11RenderTargetView**, ID3D11DepthStencilView**) = 0;
+ virtual void RSGetViewports(UINT*, D3D11_VIEWPORT*) = 0;
+ virtual void RSGetState(ID3D11RasterizerState**) = 0;
+ virtual void OMGetBlendState(ID3D11BlendState**, FLOAT[4], UINT*) = 0;
+ virtual void OMGetDepthStencilState(ID3D11DepthStencilState**, UINT*) = 0;
+ virtual void VSGetConstantBuffers(UINT, UINT, ID3D11Buffer**) = 0;
+ virtual void GSGetConstantBuffers(UINT, UINT, ID3D11Buffer**) = 0;
+ virtual void PSGetConstantBuffers(UINT, UINT, ID3D11Buffer**) = 0;
+};
+struct ID3D11Device : IUnknown {
+ virtual HRESULT CreateBuffer(const D3D11_BUFFER_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Buffer**) = 0;
+ virtual HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Texture2D**) = 0;
+ virtual HRESULT CreateShaderResourceView(ID3D11Resource*, const D3D11_SHADER_RESOURCE_VIEW_DESC*, ID3D11ShaderResourceView**) = 0;
+ virtual HRESULT CreateVertexShader(const void*, size_t, ID3D11ClassLinkage*, ID3D11VertexShader**) = 0;
+ virtual HRESULT CreatePixelShader(const void*, size_t, ID3D11ClassLinkage*, ID3D11PixelShader**) = 0;
+ virtual HRESULT CreateGeometryShader(const void*, size_t, ID3D11ClassLinkage*, ID3D11GeometryShader**) = 0;
+ virtual HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC*, UINT, const void*, size_t, ID3D11InputLayout**) = 0;
+ virtual HRESULT CreateDeferredContext(UINT, ID3D11DeviceContext**) = 0;
+ virtual HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC*, ID3D11SamplerState**) = 0;
+ virtual HRESULT CreateRenderTargetView(ID3D11Resource*, const void*, ID3D11RenderTargetView**) = 0;
+ virtual HRESULT CreateDepthStencilView(ID3D11Resource*, const D3D11_DEPTH_STENCIL_VIEW_DESC*, ID3D11DepthStencilView**) = 0;
+ virtual HRESULT CreateQuery(const D3D11_QUERY_DESC*, ID3D11Query**) = 0;
+};
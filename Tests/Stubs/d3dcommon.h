@@ -0,0 +1,14 @@
+#pragma once
+// Stand in for the Direct3D common header, types only.
+#include <windows.h>
+enum D3D_FEATURE_LEVEL { D3D_FEATURE_LEVEL_11_0 };
+struct ID3D10Blob : IUnknown { virtual LPVOID GetBufferPointer() = 0; virtual SIZE_T GetBufferSize() = 0; };
+typedef ID3D10Blob ID3DBlob;
+struct D3D10_SHADER_MACRO { const char* Name; const char* Definition; };
+typedef D3D10_SHADER_MACRO D3D_SHADER_MACRO;
+typedef const void* LPCVOID;
+#define STDMETHOD(m) virtual HRESULT m
+#define PURE = 0
+enum D3D10_INCLUDE_TYPE { D3D10_INCLUDE_LOCAL, D3D10_INCLUDE_SYSTEM };
+struct ID3D10Include { virtual HRESULT Open(D3D10_INCLUDE_TYPE, LPCSTR, LPCVOID, LPCVOID*, UINT*) = 0; virtual HRESULT Close(LPCVOID) = 0; };
+#define __stdcall
@@ -0,0 +1,3 @@
+#pragma once
+// The engine includes the maths header under both spellings, which matters on a case sensitive file system.
+#include "D3DX10math.h"
@@ -0,0 +1,3 @@
+#pragma once
+// Stand in for the assimp post processing flags.
+enum aiPostProcessSteps { aiProcess_ConvertToLeftHanded=1, aiProcess_Triangulate=2, aiProcess_SortByPType=4, aiProcess_JoinIdenticalVertices=8, aiProcess_ImproveCacheLocality=16, aiProcess_FlipUVs=32, aiProcess_GenNormals = 64 };
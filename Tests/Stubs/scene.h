@@ -0,0 +1,10 @@
+#pragma once
+// Stand in for the assimp scene types.
+#include "types.h"
+#define AI_SUCCESS 0
+#define AI_MAX_NUMBER_OF_TEXTURECOORDS 8
+enum aiTextureType { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_OPACITY };
+struct aiMaterial { int GetTexture(aiTextureType, unsigned int, aiString*) const; };
+struct aiMesh { unsigned int mNumVertices, mNumFaces, mMaterialIndex; aiVector3D* mVertices; aiVector3D* mNormals; aiVector3D* mTextureCoords[8]; aiFace* mFaces;
+ bool HasPositions() const; bool HasNormals() const; bool HasTangentsAndBitangents() const; bool HasTextureCoords(unsigned) const; bool HasVertexColors(unsigned) const; };
+struct aiScene { unsigned int mNumMeshes, mNumMaterials; aiMesh** mMeshes; aiMaterial** mMaterials; };
@@ -0,0 +1,5 @@
+#pragma once
+// Stand in for the assimp basic types.
+struct aiVector3D { float x, y, z; }; struct aiColor4D { float r,g,b,a; };
+struct aiString { unsigned int length; char data[1024]; const char* C_Str() const; };
+struct aiFace { unsigned int mNumIndices; unsigned int* mIndices; };
@@ -0,0 +1,75 @@
+#pragma once
+// Just enough of the Windows headers for the engine to compile on Linux, for the tests. Hardly anything declared
+// here is defined, see Windows.cpp, any test which ends up calling the rest fails to link rather than running against a fake.
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+typedef long long __int64;
+typedef long HRESULT; typedef unsigned int UINT; typedef unsigned long DWORD; typedef int BOOL; typedef void* HWND; typedef void* HINSTANCE; typedef void* HANDLE; typedef float FLOAT;
+#define TRUE 1
+#define FALSE 0
+typedef uintptr_t WPARAM; typedef intptr_t LPARAM; typedef intptr_t LRESULT; typedef unsigned char BYTE; typedef long LONG; typedef char* LPSTR; typedef const char* LPCSTR; typedef uint64_t UINT64; typedef int64_t LONGLONG; typedef unsigned long ULONG;
+typedef union { struct { DWORD LowPart; LONG HighPart; }; LONGLONG QuadPart; } LARGE_INTEGER;
+#define CALLBACK
+#define WINAPI
+#define FAILED(x) ((x)<0)
+#define SUCCEEDED(x) ((x)>=0)
+#define S_OK 0
+#define E_FAIL ((HRESULT)(int)0x80004005)
+#define MB_OK 0
+#define CP_ACP 0
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define GENERIC_READ 0x80000000
+#define FILE_SHARE_READ 1
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define PAGE_READONLY 2
+#define FILE_MAP_READ 4
+#define VK_LBUTTON 1
+#define VK_RBUTTON 2
+#define VK_MBUTTON 4
+#define VK_XBUTTON1 5
+#define VK_XBUTTON2 6
+#define VK_ESCAPE 0x1b
+#define VK_F1 0x70
+#define VK_F2 0x71
+#define VK_F3 0x72
+#define VK_F4 0x73
+#define VK_F5 0x74
+#define VK_F6 0x75
+#define VK_F7 0x76
+#define VK_F8 0x77
+#define VK_F9 0x78
+#define VK_F10 0x79
+#define VK_F11 0x7a
+#define VK_F12 0x7b
+#define VK_SUBTRACT 0x6d
+#define VK_ADD 0x6b
+#define VK_BACK 8
+#define VK_UP 0x26
+#define VK_DOWN 0x28
+#define VK_LEFT 0x25
+#define VK_RIGHT 0x27
+int MessageBox(HWND, const char*, const char*, UINT);
+int MultiByteToWideChar(UINT, DWORD, const char*, int, wchar_t*, int);
+BOOL QueryPerformanceCounter(LARGE_INTEGER*); BOOL QueryPerformanceFrequency(LARGE_INTEGER*);
+HANDLE CreateFileA(const char*, DWORD, DWORD, void*, DWORD, DWORD, HANDLE);
+#define CreateFile CreateFileA
+HANDLE CreateFileMappingA(HANDLE, void*, DWORD, DWORD, DWORD, const char*);
+#define CreateFileMapping CreateFileMappingA
+void* MapViewOfFile(HANDLE, DWORD, DWORD, DWORD, size_t);
+BOOL UnmapViewOfFile(const void*); BOOL CloseHandle(HANDLE); BOOL GetFileSizeEx(HANDLE, LARGE_INTEGER*);
+struct GUID { unsigned long a; unsigned short b, c; unsigned char d[8]; };
+#define __uuidof(x) GUID()
+typedef const GUID& REFIID; typedef void* LPVOID; typedef size_t SIZE_T; const HRESULT E_NOINTERFACE = (HRESULT)(int)0x80004002;
+struct IUnknown { virtual ULONG Release() = 0; virtual ULONG AddRef() = 0; virtual HRESULT QueryInterface(const GUID&, void**) = 0; };
+
+#define FILE_ATTRIBUTE_DIRECTORY 0x10
+#define MOVEFILE_REPLACE_EXISTING 0x1
+struct WIN32_FIND_DATAA { DWORD dwFileAttributes; char cFileName[260]; };
+HANDLE FindFirstFileA(const char*, WIN32_FIND_DATAA*);
+BOOL FindNextFileA(HANDLE, WIN32_FIND_DATAA*);
+BOOL FindClose(HANDLE);
+BOOL DeleteFileA(const char*);
+BOOL MoveFileExA(const char*, const char*, DWORD);
+#define FILE_FLAG_SEQUENTIAL_SCAN 0x08000000
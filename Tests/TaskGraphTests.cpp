@@ -0,0 +1,138 @@
+#include "Test.h"
+#include "TaskGraph.h"
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+	const unsigned int kNumberOfThreads = 4;
+
+	// Notes the order tasks run in, and which thread each ran on, from whichever threads they happen to run on.
+	class CTaskLog
+	{
+	public:
+		std::function<bool()> Record(const std::string& name, bool successful = true)
+		{
+			return [this, name, successful]()
+			{
+				// Long enough that anything wrongly started alongside would still be running.
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				std::lock_guard<std::mutex> lock(mMutex);
+				mRun.push_back(name);
+				mThreads.push_back(std::this_thread::get_id());
+				return successful;
+			};
+		}
+
+		unsigned int GetNumberOfRuns(const std::string& name)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return static_cast<unsigned int>(std::count(mRun.begin(), mRun.end(), name));
+		}
+
+		// Where a task first ran, or past the end if it never did.
+		size_t GetPosition(const std::string& name)
+		{
+			return std::find(mRun.begin(), mRun.end(), name) - mRun.begin();
+		}
+
+		std::thread::id GetThread(const std::string& name)
+		{
+			return mThreads[GetPosition(name)];
+		}
+
+		size_t GetNumberOfRuns() { return mRun.size(); };
+		void Clear() { mRun.clear(); mThreads.clear(); };
+	private:
+		std::mutex mMutex;
+		std::vector<std::string> mRun;
+		std::vector<std::thread::id> mThreads;
+	};
+}
+
+TEST(DiamondRunsEachTaskOnceAfterItsDependencies)
+{
+	CThreadPool threadPool(kNumberOfThreads);
+	CTaskLog log;
+
+	// The shader and texture loads only need the file list, and the pipeline needs both, so has to wait on the slower one.
+	CTaskGraph taskGraph("Diamond");
+	const CTaskGraph::TaskId files = taskGraph.AddTask("Files", log.Record("Files"));
+	const CTaskGraph::TaskId shaders = taskGraph.AddTask("Shaders", log.Record("Shaders"));
+	const CTaskGraph::TaskId textures = taskGraph.AddTask("Textures", log.Record("Textures"));
+	const CTaskGraph::TaskId pipeline = taskGraph.AddTask("Pipeline", log.Record("Pipeline"), CTaskGraph::MainThread);
+	taskGraph.AddDependency(shaders, files);
+	taskGraph.AddDependency(textures, files);
+	taskGraph.AddDependency(pipeline, shaders);
+	taskGraph.AddDependency(pipeline, textures);
+
+	// Again on just the calling thread, and a second time to show the graph can be run more than once.
+	for (CThreadPool* pool : { &threadPool, static_cast<CThreadPool*>(nullptr), &threadPool })
+	{
+		log.Clear();
+		CHECK(taskGraph.Run(pool));
+
+		CHECK(log.GetNumberOfRuns() == 4);
+		for (auto name : { "Files", "Shaders", "Textures", "Pipeline" })
+		{
+			CHECK(log.GetNumberOfRuns(name) == 1);
+		}
+		CHECK(log.GetPosition("Files") < log.GetPosition("Shaders"));
+		CHECK(log.GetPosition("Files") < log.GetPosition("Textures"));
+		CHECK(log.GetPosition("Shaders") < log.GetPosition("Pipeline"));
+		CHECK(log.GetPosition("Textures") < log.GetPosition("Pipeline"));
+		CHECK(log.GetThread("Pipeline") == std::this_thread::get_id());
+	}
+}
+
+TEST(CycleMakesRunReturnFalse)
+{
+	CThreadPool threadPool(kNumberOfThreads);
+	CTaskLog log;
+
+	CTaskGraph taskGraph("Cycle");
+	const CTaskGraph::TaskId first = taskGraph.AddTask("First", log.Record("First"));
+	const CTaskGraph::TaskId second = taskGraph.AddTask("Second", log.Record("Second"));
+	taskGraph.AddTask("Unrelated", log.Record("Unrelated"));
+	taskGraph.AddDependency(first, second);
+	taskGraph.AddDependency(second, first);
+
+	// Run returns rather than waiting forever on the two, and everything outside the cycle still runs.
+	CHECK(!taskGraph.Run(&threadPool));
+	CHECK(log.GetNumberOfRuns("First") == 0);
+	CHECK(log.GetNumberOfRuns("Second") == 0);
+	CHECK(log.GetNumberOfRuns("Unrelated") == 1);
+}
+
+TEST(FailingTaskStopsItsDependents)
+{
+	CThreadPool threadPool(kNumberOfThreads);
+	CTaskLog log;
+
+	CTaskGraph taskGraph("Failing");
+	const CTaskGraph::TaskId load = taskGraph.AddTask("Load", log.Record("Load", false));
+	const CTaskGraph::TaskId create = taskGraph.AddTask("Create", log.Record("Create"));
+	const CTaskGraph::TaskId upload = taskGraph.AddTask("Upload", log.Record("Upload"), CTaskGraph::MainThread);
+	taskGraph.AddDependency(create, load);
+	taskGraph.AddDependency(upload, create);
+
+	// Still running when the load fails, so what depends on it is only ready to start after the failure.
+	const CTaskGraph::TaskId slow = taskGraph.AddTask("Slow", [&log]()
+	{
+		while (log.GetNumberOfRuns("Load") == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		return true;
+	});
+	const CTaskGraph::TaskId later = taskGraph.AddTask("Later", log.Record("Later"));
+	taskGraph.AddDependency(later, slow);
+
+	CHECK(!taskGraph.Run(&threadPool));
+	CHECK(log.GetNumberOfRuns("Load") == 1);
+	CHECK(log.GetNumberOfRuns("Create") == 0);
+	CHECK(log.GetNumberOfRuns("Upload") == 0);
+	// Nothing more is started once a task has failed, even where it doesn't depend on the one which did.
+	CHECK(log.GetNumberOfRuns("Later") == 0);
+}
@@ -0,0 +1,39 @@
+#include "Test.h"
+
+namespace
+{
+	unsigned int gFailures = 0;
+}
+
+std::vector<PrioTest::TestCase>& PrioTest::GetTests()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+void PrioTest::ReportFailure(const char* expression, const char* file, int line)
+{
+	std::cout << file << "(" << line << "): CHECK(" << expression << ") failed." << std::endl;
+	gFailures++;
+}
+
+int main()
+{
+	unsigned int failedTests = 0;
+
+	for (auto& test : PrioTest::GetTests())
+	{
+		const unsigned int failuresBefore = gFailures;
+		test.function();
+
+		const bool passed = gFailures == failuresBefore;
+		if (!passed)
+		{
+			failedTests++;
+		}
+		std::cout << (passed ? "[ PASSED ] " : "[ FAILED ] ") << test.name << std::endl;
+	}
+
+	std::cout << PrioTest::GetTests().size() - failedTests << " of " << PrioTest::GetTests().size() << " tests passed." << std::endl;
+	return failedTests == 0 ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+/* A very small test runner, each test executable is built from one file of tests plus Test.cpp which runs them all.
+* A failed CHECK is reported and the test carries on, so one run shows every check which fails. The executable
+* returns non zero if any did, which is what ctest goes by. */
+namespace PrioTest
+{
+	typedef void(*TestFunction)();
+
+	struct TestCase
+	{
+		const char* name;
+		TestFunction function;
+	};
+
+	std::vector<TestCase>& GetTests();
+	void ReportFailure(const char* expression, const char* file, int line);
+
+	struct Registrar
+	{
+		Registrar(const char* name, TestFunction function)
+		{
+			GetTests().push_back({ name, function });
+		}
+	};
+
+	/* Runs the function the number of times given and prints the time each one took on average.
+	* @Returns double The average time in milliseconds. */
+	template <typename Function>
+	double Benchmark(const std::string& name, unsigned int iterations, Function function)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			function();
+		}
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+		const double average = elapsed.count() / iterations;
+		std::cout << name << ": " << average << "ms" << std::endl;
+		return average;
+	}
+}
+
+#define TEST(name) \
+	static void name(); \
+	static PrioTest::Registrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(expression) \
+	do \
+	{ \
+		if (!(expression)) \
+		{ \
+			PrioTest::ReportFailure(#expression, __FILE__, __LINE__); \
+		} \
+	} while (false)
+
+#endif
@@ -0,0 +1,244 @@
+#include "Test.h"
+#include "TextureCooker.h"
+#include <fstream>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+
+namespace
+{
+	// Not a multiple of the block size, so the blocks hanging over the edge of every level get cooked too.
+	const unsigned int kWidth = 36;
+	const unsigned int kHeight = 20;
+
+	// The most the smaller mip levels may be out by, in any texel and on average.
+	const int kMipLargestError = 20;
+	const double kMipAverageError = 14.0;
+
+	typedef std::function<void(unsigned int x, unsigned int y, unsigned char* rgba)> TexelFunction;
+
+	// An uncompressed 32 bit TGA, stored top down.
+	void WriteTGA(const std::string& filename, const TexelFunction& texel)
+	{
+		std::vector<unsigned char> contents(18, 0);
+		contents[2] = 2;
+		contents[12] = kWidth & 0xFF;
+		contents[13] = kWidth >> 8;
+		contents[14] = kHeight & 0xFF;
+		contents[15] = kHeight >> 8;
+		contents[16] = 32;
+		contents[17] = 0x28;
+
+		for (unsigned int y = 0; y < kHeight; y++)
+		{
+			for (unsigned int x = 0; x < kWidth; x++)
+			{
+				unsigned char rgba[4];
+				texel(x, y, rgba);
+				contents.insert(contents.end(), { rgba[2], rgba[1], rgba[0], rgba[3] });
+			}
+		}
+
+		std::remove(CTextureCooker::GetCookedFilename(filename).c_str());
+		std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+	}
+
+	void ExpandColour(unsigned int colour, int rgb[3])
+	{
+		const unsigned int red = (colour >> 11) & 0x1F;
+		const unsigned int green = (colour >> 5) & 0x3F;
+		const unsigned int blue = colour & 0x1F;
+		rgb[0] = (red << 3) | (red >> 2);
+		rgb[1] = (green << 2) | (green >> 4);
+		rgb[2] = (blue << 3) | (blue >> 2);
+	}
+
+	/* Decodes the colour half of a BC1 or BC3 block the way the GPU does, written from the format's description rather
+	* than from the cooker, so the two can't share a mistake. BC3 always uses four colours, whichever endpoint is larger. */
+	void DecodeColourBlock(const unsigned char* block, bool alwaysFourColours, unsigned char texels[16][4])
+	{
+		const unsigned int colour0 = block[0] | (block[1] << 8);
+		const unsigned int colour1 = block[2] | (block[3] << 8);
+		int palette[4][4];
+		ExpandColour(colour0, palette[0]);
+		ExpandColour(colour1, palette[1]);
+		const bool fourColours = alwaysFourColours || colour0 > colour1;
+		for (unsigned int channel = 0; channel < 3; channel++)
+		{
+			if (fourColours)
+			{
+				palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+				palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+			}
+			else
+			{
+				palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+				palette[3][channel] = 0;
+			}
+		}
+		palette[0][3] = palette[1][3] = palette[2][3] = 255;
+		palette[3][3] = fourColours ? 255 : 0;
+
+		const unsigned int indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<unsigned int>(block[7]) << 24);
+		for (unsigned int texel = 0; texel < 16; texel++)
+		{
+			const int* colour = palette[(indices >> (texel * 2)) & 3];
+			for (unsigned int channel = 0; channel < 4; channel++)
+			{
+				texels[texel][channel] = static_cast<unsigned char>(colour[channel]);
+			}
+		}
+	}
+
+	void DecodeAlphaBlock(const unsigned char* block, unsigned char texels[16][4])
+	{
+		int palette[8];
+		palette[0] = block[0];
+		palette[1] = block[1];
+		if (palette[0] > palette[1])
+		{
+			for (int step = 1; step < 7; step++)
+			{
+				palette[step + 1] = ((7 - step) * palette[0] + step * palette[1]) / 7;
+			}
+		}
+		else
+		{
+			for (int step = 1; step < 5; step++)
+			{
+				palette[step + 1] = ((5 - step) * palette[0] + step * palette[1]) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		unsigned long long indices = 0;
+		for (unsigned int byte = 0; byte < 6; byte++)
+		{
+			indices |= static_cast<unsigned long long>(block[2 + byte]) << (byte * 8);
+		}
+		for (unsigned int texel = 0; texel < 16; texel++)
+		{
+			texels[texel][3] = static_cast<unsigned char>(palette[(indices >> (texel * 3)) & 7]);
+		}
+	}
+
+	struct Errors
+	{
+		int largest[4];
+		double average[4];
+	};
+
+	// Decodes every block of a cooked level and compares it with the same level decoded from the source.
+	Errors CompareLevel(const CImage::MipLevel& cooked, const CImage::MipLevel& source, bool hasAlpha)
+	{
+		Errors errors = {};
+		const unsigned int bytesPerBlock = hasAlpha ? 16 : 8;
+
+		for (unsigned int y = 0; y < source.height; y++)
+		{
+			for (unsigned int x = 0; x < source.width; x++)
+			{
+				const unsigned char* block = cooked.data + (y / 4) * cooked.rowPitch + (x / 4) * bytesPerBlock;
+				unsigned char texels[16][4];
+				DecodeColourBlock(hasAlpha ? block + 8 : block, hasAlpha, texels);
+				if (hasAlpha)
+				{
+					DecodeAlphaBlock(block, texels);
+				}
+
+				const unsigned char* decoded = texels[(y % 4) * 4 + x % 4];
+				const unsigned char* expected = source.data + y * source.rowPitch + x * 4;
+				for (unsigned int channel = 0; channel < 4; channel++)
+				{
+					const int error = std::abs(decoded[channel] - expected[channel]);
+					errors.largest[channel] = std::max(errors.largest[channel], error);
+					errors.average[channel] += error;
+				}
+			}
+		}
+
+		for (unsigned int channel = 0; channel < 4; channel++)
+		{
+			errors.average[channel] /= source.width * source.height;
+		}
+		return errors;
+	}
+
+	void CheckRoundTrip(const std::string& filename, CImage::PixelFormat expectedFormat, int largestError, double averageError)
+	{
+		CTextureCooker cooker("Manifest.txt", 1);
+		CHECK(cooker.Cook(filename));
+		CHECK(cooker.GetNumberOfCooked() == 1);
+
+		CImage source;
+		CHECK(source.Open(filename));
+		CHECK(source.Decode());
+
+		CImage cooked;
+		CHECK(CTextureCooker::OpenImage(cooked, filename));
+		CHECK(cooked.GetFilename() == CTextureCooker::GetCookedFilename(filename));
+		CHECK(cooked.Decode());
+		CHECK(cooked.GetFormat() == expectedFormat);
+		CHECK(cooked.GetWidth() == kWidth);
+		CHECK(cooked.GetHeight() == kHeight);
+		CHECK(cooked.GetNumberOfMipLevels() == CImage::CalculateNumberOfMipLevels(kWidth, kHeight));
+		CHECK(cooked.GetNumberOfMipLevels() == source.GetNumberOfMipLevels());
+
+		const bool hasAlpha = expectedFormat == CImage::BC3Format;
+		for (unsigned int level = 0; level < cooked.GetNumberOfMipLevels() && level < source.GetNumberOfMipLevels(); level++)
+		{
+			const CImage::MipLevel& cookedLevel = cooked.GetMipLevel(level);
+			const CImage::MipLevel& sourceLevel = source.GetMipLevel(level);
+			CHECK(cookedLevel.width == sourceLevel.width);
+			CHECK(cookedLevel.height == sourceLevel.height);
+			if (cookedLevel.width != sourceLevel.width || cookedLevel.height != sourceLevel.height)
+			{
+				continue;
+			}
+
+			// Each level down halves the texels the gradient is spread over, so a block spans more of it and loses more.
+			const Errors errors = CompareLevel(cookedLevel, sourceLevel, hasAlpha);
+			for (unsigned int channel = 0; channel < 4; channel++)
+			{
+				CHECK(errors.largest[channel] <= (level == 0 ? largestError : kMipLargestError));
+				CHECK(errors.average[channel] <= (level == 0 ? averageError : kMipAverageError));
+			}
+			if (level == 0)
+			{
+				std::cout << filename << " largest error " << errors.largest[0] << ", " << errors.largest[1] << ", " << errors.largest[2] <<
+					", " << errors.largest[3] << ", average " << errors.average[0] << ", " << errors.average[1] << ", " << errors.average[2] <<
+					", " << errors.average[3] << std::endl;
+			}
+		}
+	}
+
+	/* Smooth along one direction, as most of the detail in a real texture is, which a block's line of four colours can
+	* follow. Blue falls as the others rise, so the endpoints can't just be the corners of the box around the block. */
+	void Gradient(unsigned int x, unsigned int y, unsigned char* rgba)
+	{
+		const unsigned int step = x + y;
+		rgba[0] = static_cast<unsigned char>(step * 4);
+		rgba[1] = static_cast<unsigned char>(40 + step * 3);
+		rgba[2] = static_cast<unsigned char>(230 - step * 3);
+		rgba[3] = 255;
+	}
+}
+
+TEST(OpaqueImageRoundTripsThroughBC1)
+{
+	WriteTGA("Opaque.tga", Gradient);
+	CheckRoundTrip("Opaque.tga", CImage::BC1Format, 8, 3.0);
+}
+
+TEST(ImageWithAlphaRoundTripsThroughBC3)
+{
+	WriteTGA("Alpha.tga", [](unsigned int x, unsigned int y, unsigned char* rgba)
+	{
+		Gradient(x, y, rgba);
+		rgba[3] = static_cast<unsigned char>(255 - (x + y) * 4);
+	});
+	CheckRoundTrip("Alpha.tga", CImage::BC3Format, 8, 3.0);
+}
@@ -0,0 +1,193 @@
+#include "Test.h"
+#include "TransformSystem.h"
+#include "ModelControl.h"
+#include <cmath>
+#include <memory>
+#include <thread>
+
+namespace
+{
+	const float kTolerance = 0.0001f;
+	const unsigned int kNumberOfNodes = 16;
+	const unsigned int kNumberOfThreads = 4;
+	const unsigned int kMovesPerThread = 2000;
+
+	// A model with nothing to draw, which can say where the transform system keeps its matrix.
+	class CNode : public CModelControl
+	{
+	public:
+		const D3DXMATRIX& GetWorldMatrix(CTransformSystem& transformSystem) { return transformSystem.GetWorldMatrix(mTransformIndex); };
+	};
+
+	/* What the world matrix should be, built the way CModel::UpdateMatrices builds it with D3DX, scale then the rotations
+	* about x, y and z, then translated to the position, which GetPos already adds to that of every parent up the chain. */
+	D3DXMATRIX GetExpectedWorldMatrix(CNode& node)
+	{
+		D3DXMATRIX scale;
+		D3DXMATRIX rotationX;
+		D3DXMATRIX rotationY;
+		D3DXMATRIX rotationZ;
+		D3DXMATRIX translation;
+		D3DXMatrixScaling(&scale, node.GetScaleX(), node.GetScaleY(), node.GetScaleZ());
+		D3DXMatrixRotationX(&rotationX, (node.GetRotationX() * PrioEngine::kPi) / 180.0f);
+		D3DXMatrixRotationY(&rotationY, (node.GetRotationY() * PrioEngine::kPi) / 180.0f);
+		D3DXMatrixRotationZ(&rotationZ, (node.GetRotationZ() * PrioEngine::kPi) / 180.0f);
+
+		const D3DXVECTOR3 position = node.GetPos();
+		D3DXMatrixTranslation(&translation, position.x, position.y, position.z);
+
+		return scale * rotationX * rotationY * rotationZ * translation;
+	}
+
+	bool MatchesExpected(CTransformSystem& transformSystem, CNode& node)
+	{
+		const D3DXMATRIX expected = GetExpectedWorldMatrix(node);
+		const D3DXMATRIX& world = node.GetWorldMatrix(transformSystem);
+		for (unsigned int element = 0; element < 16; element++)
+		{
+			if (std::fabs((&world._11)[element] - (&expected._11)[element]) > kTolerance)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Every node given its own position, rotation and non uniform scale, so a row or lane swapped by mistake shows up.
+	std::vector<std::unique_ptr<CNode>> CreateNodes(unsigned int numberOfNodes)
+	{
+		std::vector<std::unique_ptr<CNode>> nodes;
+		for (unsigned int i = 0; i < numberOfNodes; i++)
+		{
+			const float value = static_cast<float>(i);
+			nodes.emplace_back(new CNode());
+			nodes.back()->SetPos(value, 2.0f * value - 5.0f, 10.0f - value);
+			nodes.back()->SetRotation(value * 17.0f, value * 29.0f - 90.0f, value * 41.0f);
+			nodes.back()->SetScale(1.0f + value * 0.25f, 0.5f + value * 0.125f, 2.0f);
+		}
+		return nodes;
+	}
+}
+
+TEST(WorldMatricesMatchAfterReparentingAndUnregistering)
+{
+	CTransformSystem transformSystem;
+	std::vector<std::unique_ptr<CNode>> nodes = CreateNodes(kNumberOfNodes);
+
+	// A chain three deep, given its parents both before and after registering, and so registered out of order.
+	nodes[3]->AttatchToParent(nodes[7].get());
+	for (auto& node : nodes)
+	{
+		transformSystem.Register(node.get());
+	}
+	nodes[7]->AttatchToParent(nodes[12].get());
+	nodes[1]->AttatchToParent(nodes[3].get());
+	nodes[2]->AttatchToParent(nodes[3].get());
+
+	// A parent the system doesn't track, whose child is refreshed every update without being told.
+	CNode externalParent;
+	externalParent.SetPos(100.0f, 0.0f, -100.0f);
+	nodes[9]->AttatchToParent(&externalParent);
+
+	auto allMatch = [&]()
+	{
+		bool match = true;
+		for (auto& node : nodes)
+		{
+			match &= node == nullptr || MatchesExpected(transformSystem, *node);
+		}
+		return match;
+	};
+
+	transformSystem.Update();
+	CHECK(transformSystem.GetNumberOfNodes() == kNumberOfNodes);
+	CHECK(allMatch());
+
+	// Nothing moved, so only the node following the untracked parent is rebuilt.
+	externalParent.MoveY(3.0f);
+	transformSystem.Update();
+	CHECK(transformSystem.GetNumberOfUpdatedNodes() == 1);
+	CHECK(allMatch());
+
+	// Moving the root of the chain carries everything below it along, as rotating and scaling a child doesn't.
+	nodes[12]->MoveX(4.0f);
+	nodes[2]->RotateZ(33.0f);
+	nodes[2]->ScaleY(0.5f);
+	transformSystem.Update();
+	CHECK(allMatch());
+
+	// Moved onto a different parent, and cut loose from one.
+	nodes[3]->AttatchToParent(nodes[0].get());
+	nodes[1]->SeperateFromParent();
+	nodes[1]->SetPos(-3.0f, 1.0f, 8.0f);
+	transformSystem.Update();
+	CHECK(allMatch());
+	nodes[0]->MoveZ(-6.0f);
+	transformSystem.Update();
+	CHECK(allMatch());
+
+	// Removing leaves, and nodes which used to be parents, closes the gaps they leave and keeps the rest where they were.
+	nodes[2].reset();
+	nodes[7].reset();
+	nodes[12].reset();
+	nodes[15].reset();
+	nodes[5]->SetRotation(10.0f, 20.0f, 30.0f);
+	transformSystem.Update();
+	CHECK(transformSystem.GetNumberOfNodes() == kNumberOfNodes - 4);
+	CHECK(allMatch());
+	nodes[0]->MoveZ(2.0f);
+	transformSystem.Update();
+	CHECK(allMatch());
+
+	nodes[9]->SeperateFromParent();
+	transformSystem.Update();
+	transformSystem.Update();
+	CHECK(transformSystem.GetNumberOfUpdatedNodes() == 0);
+	CHECK(allMatch());
+}
+
+/* Each thread moves its own nodes while the main thread keeps updating, so nodes are flagged from several threads at once
+* and while the update is collecting them. Once everything has stopped a last update has to have caught every move. */
+TEST(NodesMovedFromManyThreadsAreAllUpdated)
+{
+	CTransformSystem transformSystem;
+	std::vector<std::unique_ptr<CNode>> nodes = CreateNodes(kNumberOfThreads * kNumberOfNodes);
+	for (auto& node : nodes)
+	{
+		transformSystem.Register(node.get());
+	}
+	transformSystem.Update();
+
+	std::atomic<unsigned int> numberOfRunning(kNumberOfThreads);
+	std::vector<std::thread> threads;
+	for (unsigned int thread = 0; thread < kNumberOfThreads; thread++)
+	{
+		threads.emplace_back([&, thread]()
+		{
+			for (unsigned int move = 0; move < kMovesPerThread; move++)
+			{
+				CNode& node = *nodes[thread * kNumberOfNodes + move % kNumberOfNodes];
+				node.MoveX(0.5f);
+				node.RotateY(1.0f);
+			}
+			numberOfRunning--;
+		});
+	}
+
+	while (numberOfRunning > 0)
+	{
+		transformSystem.Update();
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	transformSystem.Update();
+
+	bool allMatch = true;
+	for (auto& node : nodes)
+	{
+		allMatch &= MatchesExpected(transformSystem, *node);
+	}
+	CHECK(allMatch);
+}
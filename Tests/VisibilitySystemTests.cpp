@@ -0,0 +1,160 @@
+#include "Test.h"
+#include "MeshScene.h"
+#include "Mesh.h"
+#include "NullRenderDevice.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+namespace
+{
+	const char* kSourceFile = "Grid.x";
+	const unsigned int kGridSize = 8;
+	const unsigned int kNumberOfThreads = 8;
+	// Enough for several jobs on each mesh, with the last one left part full.
+	const unsigned int kInstancesPerMesh = CVisibilitySystem::kInstancesPerJob * 6 + 100;
+	const unsigned int kNumberOfFrames = 4;
+	const float kWorldSize = 600.0f;
+	const float kChunkSize = 60.0f;
+	const float kFieldOfView = static_cast<float>(D3DX_PI) / 4.0f;
+	const float kFarClip = 400.0f;
+	const float kWaterHeight = -5.0f;
+
+	// Everything the visibility system left on the meshes for one frame, in the order it left it.
+	struct FrameResult
+	{
+		std::vector<std::vector<unsigned int>> visibleModels;
+		std::vector<std::vector<unsigned int>> visibleChunks;
+		unsigned int numberOfTested;
+		unsigned int numberOfVisible[CVisibilitySystem::kMaxViews];
+	};
+
+	void ConstructFrustum(CFrustum& frustum, const D3DXVECTOR3& position, const D3DXVECTOR3& lookAt)
+	{
+		const D3DXVECTOR3 up(0.0f, 1.0f, 0.0f);
+		D3DXMATRIX viewMatrix;
+		D3DXMATRIX projMatrix;
+		D3DXMatrixLookAtLH(&viewMatrix, &position, &lookAt, &up);
+		D3DXMatrixPerspectiveFovLH(&projMatrix, kFieldOfView, 16.0f / 9.0f, 0.1f, kFarClip);
+		frustum.ConstructFrustum(kFarClip, projMatrix, viewMatrix);
+	}
+
+	void CreateInstances(CMesh& mesh, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> horizontal(-kWorldSize * 0.5f, kWorldSize * 0.5f);
+		std::uniform_real_distribution<float> vertical(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> scale(0.5f, 4.0f);
+		for (unsigned int i = 0; i < kInstancesPerMesh; i++)
+		{
+			CModel* model = mesh.CreateModel();
+			model->SetPos(horizontal(random), vertical(random), horizontal(random));
+			model->SetScale(scale(random));
+		}
+	}
+
+	/* Builds the same scene from scratch with a pool of the given size, one mesh batched into static chunks and one drawn
+	* instance by instance, then culls a few frames of a camera moving through it from the main and reflected views. The
+	* levels of detail picked depend on those from the frame before, so the frames have to be culled in order. */
+	std::vector<FrameResult> CullScene(unsigned int numberOfThreads)
+	{
+		CThreadPool threadPool(numberOfThreads);
+		CNullRenderDevice device;
+		CTransformSystem transformSystem;
+		CMesh batched(nullptr, &device, &transformSystem);
+		CMesh instanced(nullptr, &device, &transformSystem);
+		std::list<CMesh*> meshes = { &batched, &instanced };
+
+		std::mt19937 random(7);
+		for (auto mesh : meshes)
+		{
+			CHECK(mesh->LoadMesh(kSourceFile, 2.0f));
+			CreateInstances(*mesh, random);
+		}
+		batched.EnableStaticBatching(kChunkSize);
+		transformSystem.Update();
+		CHECK(batched.UpdateStaticBatches());
+
+		CVisibilitySystem visibilitySystem(&threadPool);
+		const float projectionScale = 1.0f / tanf(kFieldOfView * 0.5f);
+		std::vector<FrameResult> frames;
+		for (unsigned int frame = 0; frame < kNumberOfFrames; frame++)
+		{
+			const D3DXVECTOR3 position(-100.0f + frame * 60.0f, 15.0f, -kWorldSize * 0.5f + frame * 80.0f);
+			const D3DXVECTOR3 lookAt(position.x + 100.0f * sinf(frame * 0.4f), 0.0f, position.z + 100.0f * cosf(frame * 0.4f));
+			const D3DXVECTOR3 reflectedPosition(position.x, 2.0f * kWaterHeight - position.y, position.z);
+			const D3DXVECTOR3 reflectedLookAt(lookAt.x, 2.0f * kWaterHeight - lookAt.y, lookAt.z);
+
+			CFrustum mainFrustum;
+			CFrustum reflectionFrustum;
+			ConstructFrustum(mainFrustum, position, lookAt);
+			ConstructFrustum(reflectionFrustum, reflectedPosition, reflectedLookAt);
+			reflectionFrustum.SetClipPlane(D3DXPLANE(0.0f, 1.0f, 0.0f, -kWaterHeight));
+			visibilitySystem.SetView(CVisibilitySystem::MainView, &mainFrustum, position, projectionScale);
+			visibilitySystem.SetView(CVisibilitySystem::ReflectionView, &reflectionFrustum, reflectedPosition, projectionScale);
+			visibilitySystem.Cull(meshes);
+
+			FrameResult result;
+			result.numberOfTested = visibilitySystem.GetNumberOfTestedInstances();
+			for (unsigned int view = 0; view < CVisibilitySystem::kMaxViews; view++)
+			{
+				result.numberOfVisible[view] = visibilitySystem.GetNumberOfVisibleInstances(view);
+				for (auto mesh : meshes)
+				{
+					for (unsigned int lod = 0; lod < CCookedMesh::kMaxLods; lod++)
+					{
+						result.visibleModels.push_back(mesh->GetVisibleModels(view, lod));
+					}
+					result.visibleChunks.push_back(mesh->GetVisibleChunks(view));
+				}
+			}
+			frames.push_back(result);
+		}
+
+		for (auto mesh : meshes)
+		{
+			mesh->Shutdown();
+		}
+		return frames;
+	}
+}
+
+/* The jobs are the same however many threads there are, and their results are merged back in the order they were made,
+* so a single worker and many have to leave exactly the same lists on the meshes, down to the order within them. */
+TEST(OneWorkerAndManyFindTheSameInstances)
+{
+	{
+		std::ofstream file(kSourceFile, std::ios::binary | std::ios::trunc);
+		file << "Grid";
+	}
+	CMeshScene scene(kGridSize);
+
+	const std::vector<FrameResult> single = CullScene(1);
+	const std::vector<FrameResult> many = CullScene(kNumberOfThreads);
+	CHECK(single.size() == kNumberOfFrames);
+	CHECK(many.size() == kNumberOfFrames);
+	if (single.size() != many.size())
+	{
+		return;
+	}
+
+	for (unsigned int frame = 0; frame < kNumberOfFrames; frame++)
+	{
+		CHECK(single[frame].visibleModels == many[frame].visibleModels);
+		CHECK(single[frame].visibleChunks == many[frame].visibleChunks);
+		CHECK(single[frame].numberOfTested == many[frame].numberOfTested);
+		CHECK(single[frame].numberOfVisible[CVisibilitySystem::MainView] == many[frame].numberOfVisible[CVisibilitySystem::MainView]);
+		CHECK(single[frame].numberOfVisible[CVisibilitySystem::ReflectionView] == many[frame].numberOfVisible[CVisibilitySystem::ReflectionView]);
+	}
+
+	// Only worth comparing if each view kept some of the scene and culled the rest, with some chunks drawn as batches.
+	for (auto& frame : single)
+	{
+		for (auto view : { CVisibilitySystem::MainView, CVisibilitySystem::ReflectionView })
+		{
+			CHECK(frame.numberOfVisible[view] > 0);
+			CHECK(frame.numberOfVisible[view] < frame.numberOfTested / 2);
+		}
+		CHECK(std::any_of(frame.visibleChunks.begin(), frame.visibleChunks.end(), [](const std::vector<unsigned int>& chunks) { return !chunks.empty(); }));
+	}
+}